@@ -39,14 +39,18 @@ mysqlpp::Connection DBRegAgent::ProcessorDBConnection(mysqlpp::use_exceptions);
 string DBRegAgent::joined_query;
 string DBRegAgent::registrations_table = "registrations";
 
-double DBRegAgent::reregister_interval = 0.5;
-double DBRegAgent::minimum_reregister_interval = -1;
+RegRefreshPolicy DBRegAgent::refresh;
 
 bool DBRegAgent::enable_ratelimiting = false;
 unsigned int DBRegAgent::ratelimit_rate = 0;
 unsigned int DBRegAgent::ratelimit_per = 0;
 bool DBRegAgent::ratelimit_slowstart = false;
 
+unsigned int DBRegAgent::sender_threads = 1;
+
+unsigned int DBRegAgent::db_batch_size = 1;
+unsigned int DBRegAgent::db_batch_interval = 100;
+
 bool DBRegAgent::delete_removed_registrations = true;
 bool DBRegAgent::delete_failed_deregistrations = false;
 bool DBRegAgent::save_contacts = true;
@@ -94,9 +98,9 @@ int DBRegAgent::onLoad()
   DBG("requesting registration expires of %u seconds\n", expires);
 
   if (cfg.hasParameter("reregister_interval")) {
-    reregister_interval = -1;
-    reregister_interval = atof(cfg.getParameter("reregister_interval").c_str());
-    if (reregister_interval <= 0 || reregister_interval > 1) {
+    refresh.reregister_interval = -1;
+    refresh.reregister_interval = atof(cfg.getParameter("reregister_interval").c_str());
+    if (refresh.reregister_interval <= 0 || refresh.reregister_interval > 1) {
       ERROR("configuration value 'reregister_interval' could not be read. "
 	    "needs to be 0 .. 1.0 (recommended: 0.5)\n");
       return -1;
@@ -104,21 +108,30 @@ int DBRegAgent::onLoad()
   }
 
   if (cfg.hasParameter("minimum_reregister_interval")) {
-    minimum_reregister_interval = -1;
-    minimum_reregister_interval = atof(cfg.getParameter("minimum_reregister_interval").c_str());
-    if (minimum_reregister_interval <= 0 || minimum_reregister_interval > 1) {
+    refresh.minimum_reregister_interval = -1;
+    refresh.minimum_reregister_interval = atof(cfg.getParameter("minimum_reregister_interval").c_str());
+    if (refresh.minimum_reregister_interval <= 0 || refresh.minimum_reregister_interval > 1) {
       ERROR("configuration value 'minimum_reregister_interval' could not be read. "
 	    "needs to be 0 .. reregister_interval (recommended: 0.4)\n");
       return -1;
     }
 
-    if (minimum_reregister_interval >= reregister_interval) {
+    if (refresh.minimum_reregister_interval >= refresh.reregister_interval) {
       ERROR("configuration value 'minimum_reregister_interval' must be smaller "
 	    "than reregister_interval (recommended: 0.4)\n");
       return -1;
     }
   }
 
+  if (cfg.hasParameter("reregister_jitter")) {
+    refresh.reregister_jitter = atof(cfg.getParameter("reregister_jitter").c_str());
+    if (refresh.reregister_jitter < 0 || refresh.reregister_jitter >= 1) {
+      ERROR("configuration value 'reregister_jitter' could not be read. "
+	    "needs to be 0 .. 1.0 (recommended: 0.1)\n");
+      return -1;
+    }
+  }
+
   enable_ratelimiting = cfg.getParameter("enable_ratelimiting") == "yes";
   if (enable_ratelimiting) {
     if (!cfg.hasParameter("ratelimit_rate") || !cfg.hasParameter("ratelimit_per")) {
@@ -133,8 +146,28 @@ int DBRegAgent::onLoad()
     }
     ratelimit_slowstart = cfg.getParameter("ratelimit_slowstart") == "yes";
 
+    ratelimiter.init(ratelimit_rate, ratelimit_per, ratelimit_slowstart);
+  }
+
+  sender_threads = cfg.getParameterInt("sender_threads", 1);
+  if (!sender_threads) {
+    ERROR("sender_threads must be > 0\n");
+    return -1;
   }
 
+  db_batch_size = cfg.getParameterInt("db_batch_size", 1);
+  if (!db_batch_size) {
+    ERROR("db_batch_size must be > 0\n");
+    return -1;
+  }
+  db_batch_interval = cfg.getParameterInt("db_batch_interval", 100);
+  if (db_batch_size == 1)
+    status_queue.configure(1, 0);
+  else
+    status_queue.configure(db_batch_size, db_batch_interval);
+  DBG("writing DB updates in batches of %u, at least every %u ms\n",
+      db_batch_size, db_batch_interval);
+
   delete_removed_registrations =
     cfg.getParameter("delete_removed_registrations", "yes") == "yes";
 
@@ -225,6 +258,12 @@ int DBRegAgent::onLoad()
   }
   DBG("using registrations table '%s'\n", registrations_table.c_str());
 
+  if (enable_ratelimiting || sender_threads > 1) {
+    DBG("sending REGISTER requests from %u processor threads\n", sender_threads);
+    for (unsigned int i=0; i<sender_threads; i++)
+      registration_processors.push_back(new DBRegAgentProcessorThread(i));
+  }
+
   if (!loadRegistrations()) {
     ERROR("loading registrations from DB\n");
     return -1;
@@ -349,7 +388,10 @@ bool DBRegAgent::loadRegistrations() {
 	    DBG("scheduling imminent re-registration for subscriber %ld\n", subscriber_id);
 	    scheduleRegistration(subscriber_id);
 	  } else {
+	    RegistrationShard& shard = getShard(subscriber_id);
+	    shard.mut.lock();
 	    setRegistrationTimer(subscriber_id, dt_expiry, dt_registration_ts, now_time);
+	    shard.mut.unlock();
 	  }
 	  
 	}; break;
@@ -405,21 +447,24 @@ void DBRegAgent::createRegistration(long subscriber_id,
 			       contact_uri // contact
 			       );
 
-  registrations_mut.lock();
+  RegistrationShard& shard = getShard(subscriber_id);
+  shard.mut.lock();
   try {
-    if (registrations.find(subscriber_id) != registrations.end()) {
-      registrations_mut.unlock();
+    if (shard.registrations.find(subscriber_id) != shard.registrations.end()) {
+      shard.mut.unlock();
       WARN("registration with ID %ld already exists, removing\n", subscriber_id);
       removeRegistration(subscriber_id);
+      shard.mut.lock();
       clearRegistrationTimer(subscriber_id);
-      registrations_mut.lock();
     }
 
     AmSIPRegistration* reg = new AmSIPRegistration(handle, reg_info, "" /*MOD_NAME*/);
     reg->setExpiresInterval(expires);
 
-    registrations[subscriber_id] = reg;
+    shard.registrations[subscriber_id] = reg;
+    ltags_mut.lock();
     registration_ltags[handle] = subscriber_id;
+    ltags_mut.unlock();
 
     if (NULL != uac_auth_i) {
       DBG("enabling UAC Auth for new registration.\n");
@@ -451,7 +496,7 @@ void DBRegAgent::createRegistration(long subscriber_id,
     ERROR("unknown exception occured\n");
   }
 
-  registrations_mut.unlock();
+  shard.mut.unlock();
 
   // register us as SIP event receiver for this ltag
   AmEventDispatcher::instance()->addEventQueue(handle,this);
@@ -466,10 +511,11 @@ void DBRegAgent::updateRegistration(long subscriber_id,
 				    const string& realm,
 				    const string& contact) {
 
-  registrations_mut.lock();
-  map<long, AmSIPRegistration*>::iterator it=registrations.find(subscriber_id);
-  if (it == registrations.end()) {
-    registrations_mut.unlock();
+  RegistrationShard& shard = getShard(subscriber_id);
+  shard.mut.lock();
+  map<long, AmSIPRegistration*>::iterator it=shard.registrations.find(subscriber_id);
+  if (it == shard.registrations.end()) {
+    shard.mut.unlock();
     WARN("updateRegistration - registration %ld %s@%s unknown, creating\n",
 	 subscriber_id, user.c_str(), realm.c_str());
     createRegistration(subscriber_id, user, pass, realm, contact);
@@ -490,7 +536,7 @@ void DBRegAgent::updateRegistration(long subscriber_id,
 						      pass,
 						      outbound_proxy,   // proxy
 						      contact)); // contact
-  registrations_mut.unlock();
+  shard.mut.unlock();
   if (need_reregister) {
     DBG("user/realm for registration %ld changed (%s@%s -> %s@%s). "
 	"Triggering immediate re-registration\n",
@@ -503,16 +549,19 @@ void DBRegAgent::updateRegistration(long subscriber_id,
 void DBRegAgent::removeRegistration(long subscriber_id) {
   bool res = false;
   string handle;
-  registrations_mut.lock();
-  map<long, AmSIPRegistration*>::iterator it = registrations.find(subscriber_id);
-  if (it != registrations.end()) {
+  RegistrationShard& shard = getShard(subscriber_id);
+  shard.mut.lock();
+  map<long, AmSIPRegistration*>::iterator it = shard.registrations.find(subscriber_id);
+  if (it != shard.registrations.end()) {
     handle = it->second->getHandle();
+    ltags_mut.lock();
     registration_ltags.erase(handle);
+    ltags_mut.unlock();
     delete it->second;
-    registrations.erase(it);
+    shard.registrations.erase(it);
     res = true;
   }
-  registrations_mut.unlock();
+  shard.mut.unlock();
 
   if (res) {
     // deregister us as SIP event receiver for this ltag
@@ -526,30 +575,27 @@ void DBRegAgent::removeRegistration(long subscriber_id) {
 
 /** schedule this registration to REGISTER (immediately) */
 void DBRegAgent::scheduleRegistration(long subscriber_id) {
-  if (enable_ratelimiting) {
-    registration_processor.
-      postEvent(new RegistrationActionEvent(RegistrationActionEvent::Register,
-					    subscriber_id));
-  } else {
-    // use our own thread
-    postEvent(new RegistrationActionEvent(RegistrationActionEvent::Register,
-					  subscriber_id));
-  }
+  postRegistrationAction(new RegistrationActionEvent(RegistrationActionEvent::Register,
+						     subscriber_id));
   DBG("added to pending actions: REGISTER of %ld\n", subscriber_id);
 }
 
 /** schedule this registration to de-REGISTER (immediately) */
 void DBRegAgent::scheduleDeregistration(long subscriber_id) {
-  if (enable_ratelimiting) {
-    registration_processor.
-      postEvent(new RegistrationActionEvent(RegistrationActionEvent::Deregister,
-					    subscriber_id));
+  postRegistrationAction(new RegistrationActionEvent(RegistrationActionEvent::Deregister,
+						     subscriber_id));
+  DBG("added to pending actions: DEREGISTER of %ld\n", subscriber_id);
+}
+
+void DBRegAgent::postRegistrationAction(RegistrationActionEvent* ev) {
+  if (!registration_processors.empty()) {
+    // actions of a registration always go to the same sender, in order
+    registration_processors[(unsigned long)ev->subscriber_id %
+			    registration_processors.size()]->postEvent(ev);
   } else {
     // use our own thread
-      postEvent(new RegistrationActionEvent(RegistrationActionEvent::Deregister,
-					    subscriber_id));
+    postEvent(ev);
   }
-  DBG("added to pending actions: DEREGISTER of %ld\n", subscriber_id);
 }
 
 void DBRegAgent::process(AmEvent* ev) {
@@ -584,24 +630,24 @@ void DBRegAgent::process(AmEvent* ev) {
   ERROR("unknown event received!\n");
 }
 
-// uses ProcessorDBConnection
+// called by the sender threads, or the main thread
 void DBRegAgent::onRegistrationActionEvent(RegistrationActionEvent* reg_action_ev) {
   switch (reg_action_ev->action) {
   case RegistrationActionEvent::Register:
     {
       DBG("REGISTER of registration %ld\n", reg_action_ev->subscriber_id);
-      registrations_mut.lock();
+      RegistrationShard& shard = getShard(reg_action_ev->subscriber_id);
+      shard.mut.lock();
       map<long, AmSIPRegistration*>::iterator it=
-	registrations.find(reg_action_ev->subscriber_id);
-      if (it==registrations.end()) {
+	shard.registrations.find(reg_action_ev->subscriber_id);
+      if (it==shard.registrations.end()) {
 	DBG("ignoring scheduled REGISTER of unknown registration %ld\n",
 	    reg_action_ev->subscriber_id);
       } else {
 	if (!it->second->doRegistration()) {
-	  updateDBRegistration(ProcessorDBConnection,
-			       reg_action_ev->subscriber_id,
-			       480, ERR_REASON_UNABLE_TO_SEND_REQUEST,
-			       true, REG_STATUS_FAILED);
+	  queueDBUpdate(reg_action_ev->subscriber_id,
+			480, ERR_REASON_UNABLE_TO_SEND_REQUEST,
+			true, REG_STATUS_FAILED);
 	  if (error_retry_interval) {
 	    // schedule register-refresh after error_retry_interval
 	    setRegistrationTimer(reg_action_ev->subscriber_id, error_retry_interval,
@@ -609,15 +655,16 @@ void DBRegAgent::onRegistrationActionEvent(RegistrationActionEvent* reg_action_e
 	  }
 	}
       }
-      registrations_mut.unlock();
+      shard.mut.unlock();
     } break;
   case RegistrationActionEvent::Deregister:
     {
       DBG("De-REGISTER of registration %ld\n", reg_action_ev->subscriber_id);
-      registrations_mut.lock();
+      RegistrationShard& shard = getShard(reg_action_ev->subscriber_id);
+      shard.mut.lock();
       map<long, AmSIPRegistration*>::iterator it=
-	registrations.find(reg_action_ev->subscriber_id);
-      if (it==registrations.end()) {
+	shard.registrations.find(reg_action_ev->subscriber_id);
+      if (it==shard.registrations.end()) {
 	DBG("ignoring scheduled De-REGISTER of unknown registration %ld\n",
 	    reg_action_ev->subscriber_id);
       } else {
@@ -625,15 +672,14 @@ void DBRegAgent::onRegistrationActionEvent(RegistrationActionEvent* reg_action_e
 	  if (delete_removed_registrations && delete_failed_deregistrations) {
 	    DBG("sending de-Register failed - deleting registration %ld "
 		"(delete_failed_deregistrations=yes)\n", reg_action_ev->subscriber_id);
-	    deleteDBRegistration(reg_action_ev->subscriber_id, ProcessorDBConnection);
+	    queueDBDelete(reg_action_ev->subscriber_id);
 	  } else {
 	    DBG("failed sending de-register, updating DB with REG_STATUS_TO_BE_REMOVED "
 		ERR_REASON_UNABLE_TO_SEND_REQUEST "for subscriber %ld\n",
 		reg_action_ev->subscriber_id);
-	    updateDBRegistration(ProcessorDBConnection,
-				 reg_action_ev->subscriber_id,
-				 480, ERR_REASON_UNABLE_TO_SEND_REQUEST,
-				 true, REG_STATUS_TO_BE_REMOVED);
+	    queueDBUpdate(reg_action_ev->subscriber_id,
+			  480, ERR_REASON_UNABLE_TO_SEND_REQUEST,
+			  true, REG_STATUS_TO_BE_REMOVED);
 	    // don't re-try de-registrations if sending failed
 	  // if (error_retry_interval) {
 	  //   // schedule register-refresh after error_retry_interval
@@ -643,7 +689,7 @@ void DBRegAgent::onRegistrationActionEvent(RegistrationActionEvent* reg_action_e
 	  }
 	}
       }
-      registrations_mut.unlock();
+      shard.mut.unlock();
     } break;
   }
 }
@@ -748,7 +794,150 @@ void DBRegAgent::updateDBRegistration(mysqlpp::Connection& db_connection,
 
 }
 
+void DBRegAgent::queueDBUpdate(long subscriber_id, int last_code,
+			       const string& last_reason,
+			       bool update_status, int status,
+			       bool update_ts, unsigned int expiry,
+			       bool update_contacts, const string& contacts) {
+  RegStatusUpdate u(subscriber_id);
+  u.update = true;
+  u.last_code = last_code;
+  u.last_reason = last_reason;
+  u.update_status = update_status;
+  u.status = status;
+  u.update_ts = update_ts;
+  u.ts = time(NULL);
+  u.expiry = expiry;
+  u.update_contacts = update_contacts;
+  u.contacts = contacts;
+  status_queue.push(u);
+}
+
+void DBRegAgent::queueDBDelete(long subscriber_id) {
+  RegStatusUpdate u(subscriber_id);
+  u.remove = true;
+  status_queue.push(u);
+}
+
 // uses MainDBConnection
+void DBRegAgent::flushDBUpdates(bool all) {
+  if (!all && !status_queue.due())
+    return;
+
+  vector<RegStatusUpdate> batch;
+  if (!status_queue.take(batch))
+    return;
+
+  if (db_batch_size > 1) {
+    writeDBBatch(batch);
+    return;
+  }
+
+  for (vector<RegStatusUpdate>::iterator it=batch.begin(); it != batch.end(); it++) {
+    if (it->remove) {
+      DBG("delete DB registration of subscriber %ld\n", it->subscriber_id);
+      deleteDBRegistration(it->subscriber_id, MainDBConnection);
+    }
+    if (it->update) {
+      updateDBRegistration(MainDBConnection, it->subscriber_id,
+			   it->last_code, it->last_reason,
+			   it->update_status, it->status,
+			   it->update_ts, it->expiry,
+			   it->update_contacts, it->contacts);
+    }
+  }
+}
+
+#define DB_BATCH_STATUS   1
+#define DB_BATCH_TS       2
+#define DB_BATCH_CONTACTS 4
+
+void DBRegAgent::writeDBBatch(const vector<RegStatusUpdate>& batch) {
+  DBG("writing %zd registration changes to DB\n", batch.size());
+
+  try {
+    vector<long> removed;
+    for (vector<RegStatusUpdate>::const_iterator it=batch.begin(); it != batch.end(); it++) {
+      if (it->remove)
+	removed.push_back(it->subscriber_id);
+    }
+
+    for (size_t i=0; i<removed.size(); i+=db_batch_size) {
+      mysqlpp::Query query = MainDBConnection.query();
+      query << "delete from "+registrations_table+" where " COLNAME_SUBSCRIBER_ID " in (";
+      for (size_t j=i; j<removed.size() && j<i+db_batch_size; j++) {
+	if (j>i)
+	  query << ",";
+	query << long2str(removed[j]);
+      }
+      query << ");";
+
+      mysqlpp::SimpleResult res = query.execute();
+      if (!res) {
+	WARN("deleting registrations in DB failed: '%s'\n", res.info());
+      }
+    }
+
+    // one statement per set of updated columns, joining the new values;
+    // like updateDBRegistration, only existing entries are updated, and
+    // updates of entries removed in this batch are dropped
+    for (unsigned int cols=0; cols<8; cols++) {
+      vector<const RegStatusUpdate*> rows;
+      for (vector<RegStatusUpdate>::const_iterator it=batch.begin(); it != batch.end(); it++) {
+	if (it->update && !it->remove &&
+	    ((it->update_status ? DB_BATCH_STATUS : 0) |
+	     (it->update_ts ? DB_BATCH_TS : 0) |
+	     (it->update_contacts ? DB_BATCH_CONTACTS : 0)) == cols)
+	  rows.push_back(&(*it));
+      }
+
+      for (size_t i=0; i<rows.size(); i+=db_batch_size) {
+	mysqlpp::Query query = DBRegAgent::MainDBConnection.query();
+	query << "update "+registrations_table+" r join (";
+
+	for (size_t j=i; j<rows.size() && j<i+db_batch_size; j++) {
+	  const RegStatusUpdate& u = *rows[j];
+	  bool first = j==i;
+	  query << (first ? "select " : " union all select ")
+		<< long2str(u.subscriber_id) << (first ? " id," : ",")
+		<< int2str(u.last_code) << (first ? " last_code," : ",")
+		<< mysqlpp::quote << u.last_reason << (first ? " last_reason" : "");
+	  if (cols & DB_BATCH_STATUS)
+	    query << "," << int2str(u.status) << (first ? " status" : "");
+	  if (cols & DB_BATCH_TS)
+	    query << ",FROM_UNIXTIME(" << long2str(u.ts) << ")" << (first ? " ts" : "")
+		  << ",FROM_UNIXTIME(" << long2str(u.ts + u.expiry) << ")"
+		  << (first ? " expiry" : "");
+	  if (cols & DB_BATCH_CONTACTS)
+	    query << "," << mysqlpp::quote << u.contacts << (first ? " contacts" : "");
+	}
+
+	query << ") v on r." COLNAME_SUBSCRIBER_ID "=v.id set "
+	  "r." COLNAME_LAST_CODE "=v.last_code, "
+	  "r." COLNAME_LAST_REASON "=v.last_reason";
+	if (cols & DB_BATCH_STATUS)
+	  query << ", r." COLNAME_STATUS "=v.status";
+	if (cols & DB_BATCH_TS)
+	  query << ", r." COLNAME_REGISTRATION_TS "=v.ts, r." COLNAME_EXPIRY "=v.expiry";
+	if (cols & DB_BATCH_CONTACTS)
+	  query << ", r.contacts=v.contacts";
+	query << ";";
+
+	mysqlpp::SimpleResult res = query.execute();
+	if (!res) {
+	  WARN("updating registrations in DB failed: '%s'\n", res.info());
+	}
+      }
+    }
+
+  }  catch (const mysqlpp::Exception& er) {
+    // Catch-all for any MySQL++ exceptions
+    ERROR("MySQL++ error: %s\n", er.what());
+    return;
+  }
+}
+
+// called by the main thread
 void DBRegAgent::onSipReplyEvent(AmSipReplyEvent* ev) {
   if (!ev) return;
 
@@ -759,7 +948,6 @@ void DBRegAgent::onSipReplyEvent(AmSipReplyEvent* ev) {
       ev->reply.local_tag.c_str()
 #endif
       );
-  registrations_mut.lock();
 
   string local_tag =
 #ifdef HAS_OFFER_ANSWER
@@ -767,120 +955,121 @@ void DBRegAgent::onSipReplyEvent(AmSipReplyEvent* ev) {
 #else
     ev->reply.local_tag;
 #endif
-    
+
+  ltags_mut.lock();
   map<string, long>::iterator it=registration_ltags.find(local_tag);
-  if (it!=registration_ltags.end()) {
-    long subscriber_id = it->second;
-    map<long, AmSIPRegistration*>::iterator r_it=registrations.find(subscriber_id);
-    if (r_it != registrations.end()) {
-      AmSIPRegistration* registration = r_it->second;
-      if (!registration) {
-	ERROR("Internal error: registration object missing\n");
-	registrations_mut.unlock();
-	return;
-      }
-      unsigned int cseq_before = registration->getDlg()->cseq;
+  if (it==registration_ltags.end()) {
+    ltags_mut.unlock();
+    DBG("ignoring reply for unknown registration\n");
+    return;
+  }
+  long subscriber_id = it->second;
+  ltags_mut.unlock();
+
+  RegistrationShard& shard = getShard(subscriber_id);
+  shard.mut.lock();
+  map<long, AmSIPRegistration*>::iterator r_it=shard.registrations.find(subscriber_id);
+  if (r_it != shard.registrations.end() &&
+      r_it->second && r_it->second->getHandle() == local_tag) {
+    AmSIPRegistration* registration = r_it->second;
+    unsigned int cseq_before = registration->getDlg()->cseq;
 
 #ifdef HAS_OFFER_ANSWER
-      registration->getDlg()->onRxReply(ev->reply);
+    registration->getDlg()->onRxReply(ev->reply);
 #else
-      registration->getDlg()->updateStatus(ev->reply);
+    registration->getDlg()->updateStatus(ev->reply);
 #endif
 
-      //update registrations set 
-      bool update_status = false;
-      int status = 0;
-      bool update_ts = false;
-      unsigned int expiry = 0;
-      bool delete_status = false;
-      bool auth_pending = false;
-
-      if (ev->reply.code >= 300) {
-	// REGISTER or de-REGISTER failed
-	if ((ev->reply.code == 401 || ev->reply.code == 407) &&
-	    // auth response codes
-	    // processing reply triggered sending request: resent by auth
-	    (cseq_before != registration->getDlg()->cseq)) {
-	  DBG("received negative reply, but still in pending state (auth).\n");
-	  auth_pending = true;
-	} else {
-	  if (!registration->getUnregistering()) {
-	    // REGISTER failed - mark in DB
-	    DBG("registration failed - mark in DB\n");
-	    update_status = true;
-	    status = REG_STATUS_FAILED;
-	    if (error_retry_interval) {
-	      // schedule register-refresh after error_retry_interval
-	      setRegistrationTimer(subscriber_id, error_retry_interval,
-				   RegistrationActionEvent::Register);
-	    }
-	  } else {
-	    // de-REGISTER failed
-	    if (delete_removed_registrations && delete_failed_deregistrations) {
-	      DBG("de-Register failed - deleting registration %ld "
-		  "(delete_failed_deregistrations=yes)\n", subscriber_id);
-	      delete_status = true;
-	    } else {
-	      update_status = true;
-	      status = REG_STATUS_TO_BE_REMOVED;
-	    }
-	  }
-	}
-      } else if (ev->reply.code >= 200) {
-	// positive reply
+    //update registrations set 
+    bool update_status = false;
+    int status = 0;
+    bool update_ts = false;
+    unsigned int expiry = 0;
+    bool delete_status = false;
+    bool auth_pending = false;
+
+    if (ev->reply.code >= 300) {
+      // REGISTER or de-REGISTER failed
+      if ((ev->reply.code == 401 || ev->reply.code == 407) &&
+	  // auth response codes
+	  // processing reply triggered sending request: resent by auth
+	  (cseq_before != registration->getDlg()->cseq)) {
+	DBG("received negative reply, but still in pending state (auth).\n");
+	auth_pending = true;
+      } else {
 	if (!registration->getUnregistering()) {
-	  time_t now_time = time(0);
-	  setRegistrationTimer(subscriber_id, registration->getExpiresTS(),
-			       now_time, now_time);
-
+	  // REGISTER failed - mark in DB
+	  DBG("registration failed - mark in DB\n");
 	  update_status = true;
-	  status = REG_STATUS_ACTIVE;
-
-	  update_ts = true;
-	  expiry = registration->getExpiresLeft();
+	  status = REG_STATUS_FAILED;
+	  if (error_retry_interval) {
+	    // schedule register-refresh after error_retry_interval
+	    setRegistrationTimer(subscriber_id, error_retry_interval,
+				 RegistrationActionEvent::Register);
+	  }
 	} else {
-	  if (delete_removed_registrations) {
+	  // de-REGISTER failed
+	  if (delete_removed_registrations && delete_failed_deregistrations) {
+	    DBG("de-Register failed - deleting registration %ld "
+		"(delete_failed_deregistrations=yes)\n", subscriber_id);
 	    delete_status = true;
 	  } else {
 	    update_status = true;
-	    status = REG_STATUS_REMOVED;
+	    status = REG_STATUS_TO_BE_REMOVED;
 	  }
 	}
       }
-
-      // skip provisional replies & auth
-      if (ev->reply.code >= 200 && !auth_pending) {
-	// remove unregistered
-	if (registration->getUnregistering()) {
-	  registrations_mut.unlock();
-	  removeRegistration(subscriber_id);
-	  registrations_mut.lock();
+    } else if (ev->reply.code >= 200) {
+      // positive reply
+      if (!registration->getUnregistering()) {
+	time_t now_time = time(0);
+	setRegistrationTimer(subscriber_id, registration->getExpiresTS(),
+			     now_time, now_time);
+
+	update_status = true;
+	status = REG_STATUS_ACTIVE;
+
+	update_ts = true;
+	expiry = registration->getExpiresLeft();
+      } else {
+	if (delete_removed_registrations) {
+	  delete_status = true;
+	} else {
+	  update_status = true;
+	  status = REG_STATUS_REMOVED;
 	}
       }
+    }
 
-      if (!delete_status) {
-	if (auth_pending && !save_auth_replies) {
-	  DBG("not updating DB with auth reply %u %s\n",
-	      ev->reply.code, ev->reply.reason.c_str());
-	} else {
-	  DBG("update DB with reply %u %s\n", ev->reply.code, ev->reply.reason.c_str());
-	  updateDBRegistration(MainDBConnection,
-			       subscriber_id, ev->reply.code, ev->reply.reason,
-			       update_status, status, update_ts, expiry,
-			       save_contacts, ev->reply.contact);
-	}
-      } else {
-	DBG("delete DB registration of subscriber %ld\n", subscriber_id);
-	deleteDBRegistration(subscriber_id, MainDBConnection);
+    // skip provisional replies & auth
+    if (ev->reply.code >= 200 && !auth_pending) {
+      // remove unregistered
+      if (registration->getUnregistering()) {
+	shard.mut.unlock();
+	removeRegistration(subscriber_id);
+	shard.mut.lock();
       }
+    }
 
+    if (!delete_status) {
+      if (auth_pending && !save_auth_replies) {
+	DBG("not updating DB with auth reply %u %s\n",
+	    ev->reply.code, ev->reply.reason.c_str());
+      } else {
+	DBG("update DB with reply %u %s\n", ev->reply.code, ev->reply.reason.c_str());
+	queueDBUpdate(subscriber_id, ev->reply.code, ev->reply.reason,
+		      update_status, status, update_ts, expiry,
+		      save_contacts, ev->reply.contact);
+      }
     } else {
-      ERROR("internal: inconsistent registration list\n");
+      DBG("delete DB registration of subscriber %ld\n", subscriber_id);
+      queueDBDelete(subscriber_id);
     }
+
   } else {
-    DBG("ignoring reply for unknown registration\n");
+    DBG("ignoring reply for removed registration %ld\n", subscriber_id);
   }
-  registrations_mut.unlock();
+  shard.mut.unlock();
 }
 
 void DBRegAgent::run() {
@@ -891,26 +1080,30 @@ void DBRegAgent::run() {
   
   mysqlpp::Connection::thread_start();
 
-  if (enable_ratelimiting) {
+  for (vector<DBRegAgentProcessorThread*>::iterator it=
+	 registration_processors.begin(); it != registration_processors.end(); it++) {
     DBG("starting processor thread\n");
-    registration_processor.start();
+    (*it)->start();
   }
 
   DBG("running DBRegAgent thread...\n");
   shutdown_finished = false;
   while (running) {
     processEvents();
+    flushDBUpdates(false);
 
     usleep(1000); // 1ms
   }
 
+  flushDBUpdates(true);
+
   DBG("DBRegAgent done, removing all registrations from Event Dispatcher...\n");
-  registrations_mut.lock();
+  ltags_mut.lock();
   for (map<string, long>::iterator it=registration_ltags.begin();
        it != registration_ltags.end(); it++) {
     AmEventDispatcher::instance()->delEventQueue(it->first);
   }
-  registrations_mut.unlock();
+  ltags_mut.unlock();
 
   DBG("removing " MOD_NAME " registrations from Event Dispatcher...\n");
   AmEventDispatcher::instance()->delEventQueue(MOD_NAME);
@@ -931,6 +1124,9 @@ void DBRegAgent::setRegistrationTimer(long subscriber_id, unsigned int timeout,
   DBG("setting Register timer for subscription %ld, timeout %u, reg_action %u\n",
       subscriber_id, timeout, reg_action);
 
+  map<long, RegTimer*>& registration_timers =
+    getShard(subscriber_id).registration_timers;
+
   RegTimer* timer = NULL;
   map<long, RegTimer*>::iterator it=registration_timers.find(subscriber_id);
   if (it==registration_timers.end()) {
@@ -939,6 +1135,7 @@ void DBRegAgent::setRegistrationTimer(long subscriber_id, unsigned int timeout,
     timer->data1 = subscriber_id;
     timer->cb = _timer_cb;
     DBG("created timer object [%p] for subscription %ld\n", timer, subscriber_id);
+    registration_timers.insert(std::make_pair(subscriber_id, timer));
   } else {
     timer = it->second;
     DBG("removing scheduled timer...\n");
@@ -950,9 +1147,6 @@ void DBRegAgent::setRegistrationTimer(long subscriber_id, unsigned int timeout,
 
   DBG("placing timer for %ld in T-%u\n", subscriber_id, timeout);
   registration_scheduler.insert_timer(timer);
-
-  registration_timers.insert(std::make_pair(subscriber_id, timer));
-
 }
 
 void DBRegAgent::setRegistrationTimer(long subscriber_id,
@@ -961,6 +1155,9 @@ void DBRegAgent::setRegistrationTimer(long subscriber_id,
   DBG("setting re-Register timer for subscription %ld, expiry %ld, reg_start_t %ld\n",
       subscriber_id, expiry, reg_start_ts);
 
+  map<long, RegTimer*>& registration_timers =
+    getShard(subscriber_id).registration_timers;
+
   RegTimer* timer = NULL;
   map<long, RegTimer*>::iterator it=registration_timers.find(subscriber_id);
   if (it==registration_timers.end()) {
@@ -978,64 +1175,15 @@ void DBRegAgent::setRegistrationTimer(long subscriber_id,
 
   timer->data2 = RegistrationActionEvent::Register;
 
-  if (minimum_reregister_interval>0.0) {
-    time_t t_expiry_max = reg_start_ts;
-    time_t t_expiry_min = reg_start_ts;
-    if (expiry > reg_start_ts)
-      t_expiry_max+=(expiry - reg_start_ts) * reregister_interval;
-    if (expiry > reg_start_ts)
-      t_expiry_min+=(expiry - reg_start_ts) * minimum_reregister_interval;
-
-    if (t_expiry_max < now_time) {
-      // calculated interval completely in the past - immediate re-registration
-      // by setting the timer to now
-      t_expiry_max = now_time;
-    }
-
-    if (t_expiry_min > t_expiry_max)
-      t_expiry_min = t_expiry_max;
-
-    timer->expires = t_expiry_max;
-
-    if (t_expiry_max == now_time) {
-      // immediate re-registration
-      DBG("calculated re-registration at TS <now> (%ld)"
-	  "(reg_start_ts=%ld, reg_expiry=%ld, reregister_interval=%f, "
-	  "minimum_reregister_interval=%f)\n",
-	  t_expiry_max, reg_start_ts, expiry,
-	  reregister_interval, minimum_reregister_interval);
-      registration_scheduler.insert_timer(timer);
-    } else {
-      DBG("calculated re-registration at TS %ld .. %ld"
-	  "(reg_start_ts=%ld, reg_expiry=%ld, reregister_interval=%f, "
-	  "minimum_reregister_interval=%f)\n",
-	  t_expiry_min, t_expiry_max, reg_start_ts, expiry,
-	  reregister_interval, minimum_reregister_interval);
-  
-      registration_scheduler.insert_timer_leastloaded(timer, t_expiry_min, t_expiry_max);
-    }
-  } else {
-    time_t t_expiry = reg_start_ts;
-    if (expiry > reg_start_ts)
-      t_expiry+=(expiry - reg_start_ts) * reregister_interval;
-
-    if (t_expiry < now_time) {
-      t_expiry = now_time;
-      DBG("re-registering at TS <now> (%ld)\n", now_time);
-    }
-
-    DBG("calculated re-registration at TS %ld "
-	"(reg_start_ts=%ld, reg_expiry=%ld, reregister_interval=%f)\n",
-	t_expiry, reg_start_ts, expiry, reregister_interval);
-
-    timer->expires = t_expiry;    
-    registration_scheduler.insert_timer(timer);
-  }
+  refresh.schedule(registration_scheduler, timer, expiry, reg_start_ts, now_time);
 }
 
 void DBRegAgent::clearRegistrationTimer(long subscriber_id) {
   DBG("removing timer for subscription %ld", subscriber_id);
 
+  map<long, RegTimer*>& registration_timers =
+    getShard(subscriber_id).registration_timers;
+
   map<long, RegTimer*>::iterator it=registration_timers.find(subscriber_id);
   if (it==registration_timers.end()) {
     DBG("timer object for subscription %ld not found\n", subscriber_id);
@@ -1053,6 +1201,9 @@ void DBRegAgent::clearRegistrationTimer(long subscriber_id) {
 void DBRegAgent::removeRegistrationTimer(long subscriber_id) {
   DBG("removing timer object for subscription %ld", subscriber_id);
 
+  map<long, RegTimer*>& registration_timers =
+    getShard(subscriber_id).registration_timers;
+
   map<long, RegTimer*>::iterator it=registration_timers.find(subscriber_id);
   if (it==registration_timers.end()) {
     DBG("timer object for subscription %ld not found\n", subscriber_id);
@@ -1069,9 +1220,19 @@ void DBRegAgent::timer_cb(RegTimer* timer, long subscriber_id, int reg_action) {
   DBG("re-registration timer expired: subscriber %ld, timer=[%p], action %d\n",
       subscriber_id, timer, reg_action);
 
-  registrations_mut.lock();
+  RegistrationShard& shard = getShard(subscriber_id);
+  shard.mut.lock();
+  map<long, RegTimer*>::iterator it=shard.registration_timers.find(subscriber_id);
+  if (it == shard.registration_timers.end() || it->second != timer ||
+      registration_scheduler.is_scheduled(timer)) {
+    // removed or set again meanwhile
+    shard.mut.unlock();
+    DBG("ignoring outdated timer [%p] of subscriber %ld\n", timer, subscriber_id);
+    return;
+  }
   removeRegistrationTimer(subscriber_id);
-  registrations_mut.unlock();
+  shard.mut.unlock();
+
   switch (reg_action) {
   case RegistrationActionEvent::Register:
     scheduleRegistration(subscriber_id); break;
@@ -1121,9 +1282,10 @@ void DBRegAgent::DIremoveRegistration(int subscriber_id, AmArg& ret) {
       subscriber_id);
   scheduleDeregistration(subscriber_id);
 
-  registrations_mut.lock();
+  RegistrationShard& shard = getShard(subscriber_id);
+  shard.mut.lock();
   clearRegistrationTimer(subscriber_id);
-  registrations_mut.unlock();
+  shard.mut.unlock();
 
   ret.push(200);
   ret.push("OK");
@@ -1179,8 +1341,8 @@ void DBRegAgent::invoke(const string& method,
 
 // /////////////// processor thread /////////////////
 
-DBRegAgentProcessorThread::DBRegAgentProcessorThread()
-  : AmEventQueue(this), stopped(false) {
+DBRegAgentProcessorThread::DBRegAgentProcessorThread(unsigned int index)
+  : AmEventQueue(this), stopped(false), index(index) {
 }
 
 DBRegAgentProcessorThread::~DBRegAgentProcessorThread() {
@@ -1190,51 +1352,25 @@ void DBRegAgentProcessorThread::on_stop() {
 }
 
 void DBRegAgentProcessorThread::rateLimitWait() {
-  DBG("applying rate limit %u initial requests per %us\n",
-      DBRegAgent::ratelimit_rate, DBRegAgent::ratelimit_per);
-
-  DBG("allowance before ratelimit: %f\n", allowance);
-
-  struct timeval current;
-  struct timeval time_passed;
-  gettimeofday(&current, 0);
-  timersub(&current, &last_check, &time_passed);
-  memcpy(&last_check, &current, sizeof(struct timeval));
-  double seconds_passed = (double)time_passed.tv_sec +
-    (double)time_passed.tv_usec / 1000000.0;
-  allowance += seconds_passed * 
-    (double) DBRegAgent::ratelimit_rate / (double)DBRegAgent::ratelimit_per;
-
-  if (allowance > (double)DBRegAgent::ratelimit_rate)
-    allowance = (double)DBRegAgent::ratelimit_rate; // enough time passed, but limit to max
-  if (allowance < 1.0) {
-    useconds_t sleep_time = 1000000.0 * (1.0 - allowance) *
-      ((double)DBRegAgent::ratelimit_per/(double)DBRegAgent::ratelimit_rate);
-    DBG("not enough allowance (%f), sleeping %d useconds\n", allowance, sleep_time);
+  if (!DBRegAgent::enable_ratelimiting)
+    return;
+
+  // the bucket is shared by all processor threads
+  useconds_t sleep_time = reg_agent->ratelimiter.acquire();
+  if (sleep_time) {
+    DBG("rate limit %u initial requests per %us: sleeping %u useconds\n",
+	DBRegAgent::ratelimit_rate, DBRegAgent::ratelimit_per,
+	(unsigned int)sleep_time);
     usleep(sleep_time);
-    allowance=0.0;
-    gettimeofday(&last_check, 0);
-  } else {
-    allowance -= 1.0;
   }
-
-  DBG("allowance left: %f\n", allowance);
 }
 
 void DBRegAgentProcessorThread::run() {
-  DBG("DBRegAgentProcessorThread thread started\n");
+  DBG("DBRegAgentProcessorThread thread %u started\n", index);
   
-  // register us as SIP event receiver for MOD_NAME_processor
-  AmEventDispatcher::instance()->addEventQueue(MOD_NAME "_processor",this);
-
-  mysqlpp::Connection::thread_start();
-
-  // initialize ratelimit
-  gettimeofday(&last_check, NULL);
-  if (DBRegAgent::ratelimit_slowstart)
-    allowance = 0.0;
-  else
-    allowance = DBRegAgent::ratelimit_rate;
+  // register us as SIP event receiver for MOD_NAME_processor<index>
+  AmEventDispatcher::instance()->addEventQueue(MOD_NAME "_processor" + int2str(index),
+					       this);
 
   reg_agent = DBRegAgent::instance();
   while (!stopped) {
@@ -1245,9 +1381,7 @@ void DBRegAgentProcessorThread::run() {
     }
   }
 
-  mysqlpp::Connection::thread_end();
-
- DBG("DBRegAgentProcessorThread thread stopped\n"); 
+ DBG("DBRegAgentProcessorThread thread %u stopped\n", index); 
 }
 
 void DBRegAgentProcessorThread::process(AmEvent* ev) {
@@ -34,11 +34,16 @@
 using std::map;
 #include <queue>
 using std::queue;
+#include <vector>
+using std::vector;
 
 #include "AmApi.h"
 #include "AmSipRegistration.h"
 
 #include "RegistrationTimer.h"
+#include "RegRateLimiter.h"
+#include "RegRefresh.h"
+#include "RegStatusQueue.h"
 
 #define REG_STATUS_INACTIVE      0
 #define REG_STATUS_PENDING       1
@@ -70,6 +75,9 @@ using std::queue;
 
 #define ERR_REASON_UNABLE_TO_SEND_REQUEST  "unable to send request"
 
+// registrations are kept in shards by subscriber_id, each with its own lock
+#define DBREG_SHARDS 64
+
 struct RegistrationActionEvent : public AmEvent {
 
   enum RegAction { Register=0, Deregister };
@@ -84,7 +92,7 @@ RegistrationActionEvent(RegAction action, long subscriber_id)
 
 class DBRegAgent;
 
-// separate thread for REGISTER sending, which can block for rate limiting
+// separate threads for REGISTER sending, which can block for rate limiting
 class DBRegAgentProcessorThread
 : public AmEventQueue,
   public AmThread,
@@ -93,17 +101,15 @@ class DBRegAgentProcessorThread
 
   DBRegAgent* reg_agent;
   bool stopped;
+  unsigned int index;
 
   void rateLimitWait();
 
-  double allowance;
-  struct timeval last_check;
-
  protected:
   void process(AmEvent* ev);
 
  public:
-  DBRegAgentProcessorThread();
+  DBRegAgentProcessorThread(unsigned int index);
   ~DBRegAgentProcessorThread();
 
   void run();
@@ -111,6 +117,13 @@ class DBRegAgentProcessorThread
 
 };
 
+/** registrations of one shard, and their refresh timers */
+struct RegistrationShard {
+  map<long, AmSIPRegistration*> registrations;
+  map<long, RegTimer*>          registration_timers;
+  AmMutex mut;
+};
+
 class DBRegAgent
 : public AmDynInvokeFactory,
   public AmDynInvoke,
@@ -122,14 +135,18 @@ class DBRegAgent
   static string joined_query;
   static string registrations_table;
 
-  static double reregister_interval;
-  static double minimum_reregister_interval;
+  static RegRefreshPolicy refresh;
 
   static bool enable_ratelimiting;
   static unsigned int ratelimit_rate;
   static unsigned int ratelimit_per;
   static bool ratelimit_slowstart;
 
+  static unsigned int sender_threads;
+
+  static unsigned int db_batch_size;
+  static unsigned int db_batch_interval;
+
   static bool delete_removed_registrations;
   static bool delete_failed_deregistrations;
   static bool save_contacts;
@@ -144,15 +161,19 @@ class DBRegAgent
 
   static unsigned int error_retry_interval;
 
-  map<long, AmSIPRegistration*> registrations;
+  RegistrationShard reg_shards[DBREG_SHARDS];
+  RegistrationShard& getShard(long subscriber_id) {
+    return reg_shards[(unsigned long)subscriber_id % DBREG_SHARDS];
+  }
+
+  // locked after the shard, if both
   map<string, long>             registration_ltags;
-  map<long, RegTimer*>          registration_timers;
-  AmMutex registrations_mut;
+  AmMutex ltags_mut;
 
   // connection used in main DBRegAgent thread
   static mysqlpp::Connection MainDBConnection;
 
-  // connection used in other thread (processor thread)
+  // connection used for creating entries while loading
   static mysqlpp::Connection ProcessorDBConnection;
 
   int onLoad();
@@ -165,7 +186,11 @@ class DBRegAgent
   void onUnload();
 
   RegistrationTimer registration_scheduler;
-  DBRegAgentProcessorThread registration_processor;
+  vector<DBRegAgentProcessorThread*> registration_processors;
+  RegRateLimiter ratelimiter;
+
+  /** DB changes, written by the main thread */
+  RegStatusQueue status_queue;
 
   bool loadRegistrations();
 
@@ -178,6 +203,20 @@ class DBRegAgent
 			    bool update_ts=false, unsigned int expiry = 0,
 			    bool update_contacts=false, const string& contacts = "");
 
+  /** queue a DB update (see updateDBRegistration) for the main thread */
+  void queueDBUpdate(long subscriber_id, int last_code,
+		     const string& last_reason,
+		     bool update_status = false, int status = 0,
+		     bool update_ts=false, unsigned int expiry = 0,
+		     bool update_contacts=false, const string& contacts = "");
+  /** queue deleting the DB entry for the main thread */
+  void queueDBDelete(long subscriber_id);
+
+  /** write queued DB changes, if due or all */
+  void flushDBUpdates(bool all);
+  /** write changes with one statement per db_batch_size entries */
+  void writeDBBatch(const vector<RegStatusUpdate>& batch);
+
   /** create registration in our list */
   void createRegistration(long subscriber_id,
 			  const string& user,
@@ -200,6 +239,11 @@ class DBRegAgent
   /** schedule this subscriber to de-REGISTER imminently*/
   void scheduleDeregistration(long subscriber_id);
 
+  void postRegistrationAction(RegistrationActionEvent* ev);
+
+  // the timer functions below are called with the shard of the
+  // subscriber locked
+
   /** create a timer for the registration - fixed expiry + action */
   void setRegistrationTimer(long subscriber_id, unsigned int timeout,
 			    RegistrationActionEvent::RegAction reg_action);
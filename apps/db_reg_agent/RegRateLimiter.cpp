@@ -0,0 +1,76 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "RegRateLimiter.h"
+#include "log.h"
+
+RegRateLimiter::RegRateLimiter()
+  : rate(1), per(1), allowance(1)
+{
+  gettimeofday(&last_check, NULL);
+}
+
+void RegRateLimiter::init(unsigned int _rate, unsigned int _per, bool slowstart) {
+  mut.lock();
+  rate = _rate;
+  per = _per;
+  allowance = slowstart ? 0.0 : rate;
+  gettimeofday(&last_check, NULL);
+  mut.unlock();
+}
+
+useconds_t RegRateLimiter::acquire() {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return acquire(now);
+}
+
+useconds_t RegRateLimiter::acquire(const struct timeval& now) {
+  mut.lock();
+
+  if (timercmp(&now, &last_check, >)) {
+    struct timeval time_passed;
+    timersub(&now, &last_check, &time_passed);
+    last_check = now;
+    double seconds_passed = (double)time_passed.tv_sec +
+      (double)time_passed.tv_usec / 1000000.0;
+    allowance += seconds_passed * rate / per;
+    if (allowance > rate)
+      allowance = rate; // enough time passed, but limit to max
+  }
+
+  allowance -= 1.0;
+
+  useconds_t wait_time = 0;
+  if (allowance < 0.0)
+    wait_time = 1000000.0 * -allowance * per / rate;
+
+  mut.unlock();
+
+  if (wait_time) {
+    DBG("ratelimit: waiting %u useconds for next request\n", (unsigned int)wait_time);
+  }
+  return wait_time;
+}
@@ -0,0 +1,64 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _RegRateLimiter_h_
+#define _RegRateLimiter_h_
+
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "AmThread.h"
+
+/**
+  token bucket for initial REGISTER requests: rate requests per per
+  seconds, bursts up to rate.
+
+  Shared by the sender threads. acquire() takes a token right away, and
+  if there is none, books the next one free and returns how long the caller
+  has to wait for it (sleeping is up to the caller, without lock held).
+  So the rate holds for any number of senders, and they are served in
+  order.
+ */
+class RegRateLimiter
+{
+  double rate;
+  double per;
+  // tokens available, < 0: booked ahead
+  double allowance;
+  struct timeval last_check;
+  AmMutex mut;
+
+ public:
+  RegRateLimiter();
+
+  /** @param slowstart start with no tokens instead of a full bucket */
+  void init(unsigned int rate, unsigned int per, bool slowstart);
+
+  /** @return microseconds to wait before sending */
+  useconds_t acquire();
+  useconds_t acquire(const struct timeval& now);
+};
+
+#endif
@@ -0,0 +1,89 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "RegRefresh.h"
+#include "log.h"
+
+bool RegRefreshPolicy::schedule(RegistrationTimer& wheel, RegTimer* timer,
+				time_t expiry, time_t reg_start_ts,
+				time_t now_time) const {
+  if (minimum_reregister_interval>0.0) {
+    time_t t_expiry_max = reg_start_ts;
+    time_t t_expiry_min = reg_start_ts;
+    if (expiry > reg_start_ts)
+      t_expiry_max+=(expiry - reg_start_ts) * reregister_interval;
+    if (expiry > reg_start_ts)
+      t_expiry_min+=(expiry - reg_start_ts) * minimum_reregister_interval;
+
+    if (t_expiry_max < now_time) {
+      // calculated interval completely in the past - immediate re-registration
+      // by setting the timer to now
+      t_expiry_max = now_time;
+    }
+
+    if (t_expiry_min > t_expiry_max)
+      t_expiry_min = t_expiry_max;
+
+    timer->expires = t_expiry_max;
+
+    if (t_expiry_max == now_time) {
+      // immediate re-registration
+      DBG("calculated re-registration at TS <now> (%ld)"
+	  "(reg_start_ts=%ld, reg_expiry=%ld, reregister_interval=%f, "
+	  "minimum_reregister_interval=%f)\n",
+	  t_expiry_max, reg_start_ts, expiry,
+	  reregister_interval, minimum_reregister_interval);
+      return wheel.insert_timer(timer);
+    }
+
+    DBG("calculated re-registration at TS %ld .. %ld"
+	"(reg_start_ts=%ld, reg_expiry=%ld, reregister_interval=%f, "
+	"minimum_reregister_interval=%f)\n",
+	t_expiry_min, t_expiry_max, reg_start_ts, expiry,
+	reregister_interval, minimum_reregister_interval);
+    return wheel.insert_timer_leastloaded(timer, t_expiry_min, t_expiry_max);
+  }
+
+  time_t t_expiry = reg_start_ts;
+  if (expiry > reg_start_ts)
+    t_expiry+=(expiry - reg_start_ts) * reregister_interval;
+
+  // spread out refreshes of registrations done at the same time
+  time_t t_expiry_min = t_expiry - (t_expiry - reg_start_ts) * reregister_jitter;
+
+  if (t_expiry < now_time) {
+    t_expiry = now_time;
+    DBG("re-registering at TS <now> (%ld)\n", now_time);
+  }
+  if (t_expiry_min < now_time)
+    t_expiry_min = now_time;
+
+  DBG("calculated re-registration at TS %ld .. %ld "
+      "(reg_start_ts=%ld, reg_expiry=%ld, reregister_interval=%f, "
+      "reregister_jitter=%f)\n",
+      t_expiry_min, t_expiry, reg_start_ts, expiry,
+      reregister_interval, reregister_jitter);
+  return wheel.insert_timer_jittered(timer, t_expiry_min, t_expiry);
+}
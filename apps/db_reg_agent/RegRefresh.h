@@ -0,0 +1,57 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _RegRefresh_h_
+#define _RegRefresh_h_
+
+#include <time.h>
+
+#include "RegistrationTimer.h"
+
+/**
+  when to refresh a registration: after reregister_interval of the time
+  from registering to expiry. To flatten out refresh spikes, the timer
+  goes
+   - into the least loaded bucket from minimum_reregister_interval on,
+     if that is set (> 0), or else
+   - at a random time within reregister_jitter of that interval before.
+ */
+struct RegRefreshPolicy
+{
+  double reregister_interval;
+  double minimum_reregister_interval;
+  double reregister_jitter;
+
+  RegRefreshPolicy()
+    : reregister_interval(0.5), minimum_reregister_interval(-1),
+      reregister_jitter(0.1) { }
+
+  /** (re)insert timer into wheel for a registration done at
+      reg_start_ts that expires at expiry */
+  bool schedule(RegistrationTimer& wheel, RegTimer* timer,
+		time_t expiry, time_t reg_start_ts, time_t now_time) const;
+};
+
+#endif
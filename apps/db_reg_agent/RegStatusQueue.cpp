@@ -0,0 +1,116 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "RegStatusQueue.h"
+
+void RegStatusUpdate::merge(const RegStatusUpdate& later) {
+  if (later.remove) {
+    // what was before is gone
+    *this = later;
+    return;
+  }
+
+  update = true;
+  last_code = later.last_code;
+  last_reason = later.last_reason;
+  if (later.update_status) {
+    update_status = true;
+    status = later.status;
+  }
+  if (later.update_ts) {
+    update_ts = true;
+    ts = later.ts;
+    expiry = later.expiry;
+  }
+  if (later.update_contacts) {
+    update_contacts = true;
+    contacts = later.contacts;
+  }
+}
+
+RegStatusQueue::RegStatusQueue()
+  : batch_size(1), batch_interval(0)
+{
+  timerclear(&first_push);
+}
+
+void RegStatusQueue::configure(unsigned int _batch_size, unsigned int _batch_interval) {
+  mut.lock();
+  batch_size = _batch_size ? _batch_size : 1;
+  batch_interval = _batch_interval;
+  mut.unlock();
+}
+
+void RegStatusQueue::push(const RegStatusUpdate& update) {
+  mut.lock();
+  std::map<long, size_t>::iterator it = pending.find(update.subscriber_id);
+  if (it != pending.end()) {
+    updates[it->second].merge(update);
+  } else {
+    if (updates.empty())
+      gettimeofday(&first_push, NULL);
+    pending[update.subscriber_id] = updates.size();
+    updates.push_back(update);
+  }
+  mut.unlock();
+}
+
+bool RegStatusQueue::due() {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return due(now);
+}
+
+bool RegStatusQueue::due(const struct timeval& now) {
+  mut.lock();
+  bool res = false;
+  if (!updates.empty()) {
+    if (updates.size() >= batch_size) {
+      res = true;
+    } else {
+      struct timeval age;
+      timersub(&now, &first_push, &age);
+      res = age.tv_sec * 1000 + age.tv_usec / 1000 >= (long)batch_interval;
+    }
+  }
+  mut.unlock();
+  return res;
+}
+
+size_t RegStatusQueue::take(std::vector<RegStatusUpdate>& batch) {
+  mut.lock();
+  batch.swap(updates);
+  updates.clear();
+  pending.clear();
+  mut.unlock();
+  return batch.size();
+}
+
+size_t RegStatusQueue::size() {
+  mut.lock();
+  size_t res = updates.size();
+  mut.unlock();
+  return res;
+}
@@ -0,0 +1,102 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _RegStatusQueue_h_
+#define _RegStatusQueue_h_
+
+#include <sys/time.h>
+#include <time.h>
+
+#include <map>
+#include <string>
+#include <vector>
+using std::string;
+
+#include "AmThread.h"
+
+/** change of a registration's DB entry */
+struct RegStatusUpdate {
+  long subscriber_id;
+
+  // delete the entry (before updating, if update is set as well)
+  bool remove;
+  bool update;
+
+  int last_code;
+  string last_reason;
+  bool update_status;
+  int status;
+  bool update_ts;
+  time_t ts;
+  unsigned int expiry;
+  bool update_contacts;
+  string contacts;
+
+  RegStatusUpdate(long subscriber_id)
+    : subscriber_id(subscriber_id), remove(false), update(false),
+      last_code(0), update_status(false), status(0),
+      update_ts(false), ts(0), expiry(0), update_contacts(false) { }
+
+  /** fold a later change into this one */
+  void merge(const RegStatusUpdate& later);
+};
+
+/**
+  DB changes of the registrations, collected from the SIP reply and
+  sender threads to be written in batches. Changes of the same
+  registration are merged, so with many registrations only the last state
+  of each is written.
+
+  A batch is due if batch_size changes are pending or the oldest one is
+  batch_interval ms old.
+ */
+class RegStatusQueue
+{
+  std::vector<RegStatusUpdate> updates;
+  std::map<long, size_t> pending;
+  struct timeval first_push;
+
+  unsigned int batch_size;
+  unsigned int batch_interval;
+
+  AmMutex mut;
+
+ public:
+  RegStatusQueue();
+
+  void configure(unsigned int batch_size, unsigned int batch_interval);
+
+  void push(const RegStatusUpdate& update);
+
+  bool due();
+  bool due(const struct timeval& now);
+
+  /** take all pending changes, in the order they were first pushed */
+  size_t take(std::vector<RegStatusUpdate>& batch);
+
+  size_t size();
+};
+
+#endif
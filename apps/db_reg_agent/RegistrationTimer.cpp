@@ -27,58 +27,8 @@
 #include <stdlib.h>
 
 RegistrationTimer::RegistrationTimer()
- : current_bucket(0)
+ : wheel(time(NULL), TIMER_BUCKETS, TIMER_BUCKET_LENGTH)
 {
-  struct timeval now;
-  gettimeofday(&now, 0);
-  current_bucket_start = now.tv_sec; 
-}
-
-// unsafe!
-int RegistrationTimer::get_bucket_index(time_t tv) {
-  time_t buckets_start_time = current_bucket_start;
-
-  if (tv < buckets_start_time)
-    return -1;
-
-  // offset
-  int bucket_index =  (tv - buckets_start_time);
-  bucket_index /= TIMER_BUCKET_LENGTH;
-  
-  if (bucket_index > TIMER_BUCKETS) { // too far in the future
-    ERROR("requested timer too far in the future (index %d vs %d TIMER_BUCKETS)\n",
-	  bucket_index, TIMER_BUCKETS);
-    return -2;
-  }
-
-  bucket_index += current_bucket;
-  bucket_index %= TIMER_BUCKETS; // circular array
-
-  return bucket_index;
-}
-
-void RegistrationTimer::place_timer(RegTimer* timer, int bucket_index) {
-  if (bucket_index < 0) {
-    ERROR("trying to place_timer with negative index (%i)\n", bucket_index);
-    return;
-  }
-
-  if (bucket_index > TIMER_BUCKETS) {
-    ERROR("trying to place_timer with too high index (%i vs %i)\n",
-	  bucket_index, TIMER_BUCKETS);
-    return;
-  }
-
-  std::list<RegTimer*>::iterator it = buckets[bucket_index].timers.begin();
-  while (it != buckets[bucket_index].timers.end() &&
-	 (timer->expires > (*it)->expires))
-    it++;
-  
-  buckets[bucket_index].timers.insert(it, timer);
-  size_t b_size = buckets[bucket_index].timers.size();
- 
- DBG("inserted timer [%p] in bucket %i (now sized %zd)\n",
-      timer, bucket_index, b_size);
 }
 
 void RegistrationTimer::fire_timer(RegTimer* timer) {
@@ -92,28 +42,21 @@ bool RegistrationTimer::insert_timer(RegTimer* timer) {
   if (!timer)
     return false;
 
-  buckets_mut.lock();
-  int bucket_index = get_bucket_index(timer->expires);
+  wheel_mut.lock();
+  wheel.cancel(timer);
 
-  if (bucket_index == -1) {
+  if (timer->expires < wheel.getTime()) {
     // already expired, fire timer
-    buckets_mut.unlock();
+    wheel_mut.unlock();
     DBG("inserting already expired timer [%p], firing\n", timer);
     fire_timer(timer);
     return false;
   }
 
-  if (bucket_index == -2) {
-    ERROR("trying to place timer too far in the future\n");
-    buckets_mut.unlock();
-    return false;
-  }
-
-  place_timer(timer, bucket_index);
-
-  buckets_mut.unlock();
+  wheel.schedule(timer, timer->expires);
+  wheel_mut.unlock();
 
- return true;
+  return true;
 }
 
 bool RegistrationTimer::remove_timer(RegTimer* timer) {
@@ -122,26 +65,12 @@ bool RegistrationTimer::remove_timer(RegTimer* timer) {
 
   bool res = false;
 
-  buckets_mut.lock();
-  int bucket_index = get_bucket_index(timer->expires);
-
-  if (bucket_index < 0) {
-    buckets_mut.unlock();
-    return false;
-  }
-
-  std::list<RegTimer*>& timerlist = buckets[bucket_index].timers;
-
-  for (std::list<RegTimer*>::iterator it = timerlist.begin();
-       it != timerlist.end(); it++) {
-    if (*it == timer) {
-      timerlist.erase(it);
-      res = true;
-      break;
-    }
+  wheel_mut.lock();
+  if (timer->isScheduled()) {
+    wheel.cancel(timer);
+    res = true;
   }
-
-  buckets_mut.unlock();  
+  wheel_mut.unlock();
 
   if (res) {
     DBG("successfully removed timer [%p]\n", timer);
@@ -151,44 +80,32 @@ bool RegistrationTimer::remove_timer(RegTimer* timer) {
   return res;
 }
 
-void RegistrationTimer::run_timers() {
-  std::list<RegTimer*> timers_tbf;
-
-  struct timeval now;
-  gettimeofday(&now, 0);
-
-  buckets_mut.lock();
+bool RegistrationTimer::is_scheduled(RegTimer* timer) {
+  wheel_mut.lock();
+  bool res = timer->isScheduled();
+  wheel_mut.unlock();
+  return res;
+}
 
-  // bucket over?
-  if (now.tv_sec > current_bucket_start + TIMER_BUCKET_LENGTH) {
-    timers_tbf.insert(timers_tbf.begin(),
-		      buckets[current_bucket].timers.begin(),
-		      buckets[current_bucket].timers.end());
-    buckets[current_bucket].timers.clear();
-    current_bucket++;
-    current_bucket %= TIMER_BUCKETS;
-    current_bucket_start += TIMER_BUCKET_LENGTH;
-    // DBG("turned bucket to %i\n", current_bucket);
-  }
+void RegistrationTimer::run_timers(time_t now) {
+  // the timers may be removed and deleted as soon as we unlock,
+  // so callback and data are copied
+  std::vector<AmWheelTimer*> fired;
+  std::vector<RegTimer> timers_tbf;
 
-  // move timers from current_bucket
-  RegTimerBucket& bucket = buckets[current_bucket];
-  std::list<RegTimer*>::iterator it = bucket.timers.begin();
-  while (it != bucket.timers.end() &&
-	 now.tv_sec > (*it)->expires) {
-    std::list<RegTimer*>::iterator c_it = it;
-    it++;
-    timers_tbf.push_back(*c_it);
-    bucket.timers.erase(c_it);
-  }
-
-  buckets_mut.unlock();
+  wheel_mut.lock();
+  wheel.expire(now, fired);
+  for (size_t i=0; i<fired.size(); i++)
+    timers_tbf.push_back(*static_cast<RegTimer*>(fired[i]));
+  wheel_mut.unlock();
 
   if (!timers_tbf.empty()) {
     DBG("firing %zd timers\n", timers_tbf.size());
-    for (std::list<RegTimer*>::iterator it=timers_tbf.begin();
-	 it != timers_tbf.end(); it++) {
-      fire_timer(*it);
+    for (size_t i=0; i<timers_tbf.size(); i++) {
+      if (timers_tbf[i].cb) {
+	timers_tbf[i].cb(static_cast<RegTimer*>(fired[i]),
+			 timers_tbf[i].data1, timers_tbf[i].data2);
+      }
     }
   }
 }
@@ -225,7 +142,7 @@ void RegistrationTimer::run()
     //printf("missed one tick\n");
     //}
 
-    run_timers();
+    run_timers(now.tv_sec);
     timeradd(&tick,&next_tick,&next_tick);
   }
 
@@ -240,60 +157,45 @@ bool RegistrationTimer::insert_timer_leastloaded(RegTimer* timer,
 						 time_t from_time,
 						 time_t to_time) {
 
-  buckets_mut.lock();
-
-  int from_index = get_bucket_index(from_time);
-  int to_index = get_bucket_index(to_time);
+  wheel_mut.lock();
+  wheel.cancel(timer);
 
-  if (from_index < 0 && to_index < 0) {
-    ERROR("could not find timer bucket indices - "
-	  "from_index = %d, to_index = %d, from_time = %ld, to_time %ld, "
-	  "current_bucket_start = %ld\n",
-	  from_index, to_index, from_time, to_time, current_bucket_start);
-    buckets_mut.unlock();
+  time_t bucket_start;
+  if (!wheel.leastLoaded(from_time, to_time, bucket_start)) {
+    ERROR("could not find timer bucket - from_time = %ld, to_time %ld, "
+	  "now = %ld\n", from_time, to_time, wheel.getTime());
+    wheel_mut.unlock();
     return false;
   }
+  DBG("found bucket at %ld with load %u (between %ld and %ld)\n",
+      bucket_start, wheel.getLoad(bucket_start), from_time, to_time);
 
-  if (from_index < 0) {
-    // use now .. to_index
-    DBG("from_time (%ld) in the past - searching load loaded from now()\n", from_time);
-    from_index  = current_bucket;
-  }
-  // find least loaded bucket
-  int res_index = from_index;
-  size_t least_load = buckets[from_index].timers.size();
-
-  int i = from_index;
-  while  (i != to_index) {
-    if (buckets[i].timers.size() <= least_load) {
-      least_load = buckets[i].timers.size();
-      res_index = i;
-    }
+  // update expires to some random value inside the selected bucket
+  timer->expires = bucket_start + rand() % TIMER_BUCKET_LENGTH;
+  DBG("setting expires to %ld (between %ld and %ld)\n",
+      timer->expires, from_time, to_time);
 
-    i++;
-    i %= TIMER_BUCKETS;
-  }
-  DBG("found bucket %i with least load %zd (between %i and %i)\n",
-      res_index, least_load, from_index, to_index);
+  wheel.schedule(timer, timer->expires);
 
-  // update expires to some random value inside the selected bucket
-  int diff = (unsigned)res_index - current_bucket;
+  wheel_mut.unlock();
+
+  return true;
+}
+
+bool RegistrationTimer::insert_timer_jittered(RegTimer* timer,
+					      time_t from_time,
+					      time_t to_time) {
+  if (!timer)
+    return false;
+
+  timer->expires = to_time;
+  if (from_time < to_time)
+    timer->expires = from_time + rand() % (to_time - from_time + 1);
 
-  if ((unsigned)res_index < current_bucket) {
-    diff+=TIMER_BUCKETS;
-  }
-  
-  timer->expires = current_bucket_start + 
-    diff * TIMER_BUCKET_LENGTH + // bucket start
-    rand() % TIMER_BUCKET_LENGTH;
   DBG("setting expires to %ld (between %ld and %ld)\n",
       timer->expires, from_time, to_time);
 
-  place_timer(timer, res_index);
-     
-  buckets_mut.unlock();
-
-  return false;
+  return insert_timer(timer);
 }
 
 
@@ -26,13 +26,13 @@
 #ifndef _RegistrationTimer_h_
 #define _RegistrationTimer_h_
 
-#include <list>
 #include <vector>
 
 #include <sys/time.h>
 
 #include "log.h"
 #include "AmThread.h"
+#include "AmTimerWheel.h"
 
 #define TIMER_BUCKET_LENGTH 10     // 10 sec
 #define TIMER_BUCKETS       40000  // 40000 buckets (400000 sec, 111 hrs)
@@ -43,9 +43,9 @@
 class RegTimer;
 typedef void (*timer_cb)(RegTimer*, long /*data1*/,int /*data2*/);
 
-class RegTimerBucket;
-
-class RegTimer {
+class RegTimer
+  : public AmWheelTimer
+{
  public:
     time_t expires;
 
@@ -57,13 +57,6 @@ class RegTimer {
       : expires(0), cb(0), data1(0), data2(0) { }
 };
 
-class RegTimerBucket {
- public:
-  std::list<RegTimer*> timers;
-
- RegTimerBucket() { }
-};
-
 /**
   Additionally to normal timer operation (setting and removing timer,
   fire the timer when it is expired), this RegistrationTimer timers 
@@ -71,29 +64,27 @@ class RegTimerBucket {
   the timer in some least loaded interval between from_time and to_time
   in order to flatten out re-register spikes (due to restart etc).
 
-  Timer granularity is seconds.
+  Timer granularity is seconds; a timer fires in the first run after
+  its expires time.
 
-  Timers are saved in buckets of TIMER_BUCKET_LENGTH seconds. the buckets
-  array is a circular one, the current bucket starts from the time 
-  current_bucket_start (in seconds as in time(2)).
+  Timers are kept in an AmTimerWheel with buckets of TIMER_BUCKET_LENGTH
+  seconds, so inserting and removing is O(1) also with some 100k
+  timers. The wheel is locked here, as timers are inserted and removed
+  from the processing threads.
 
   The timer object is owned by the caller, and MUST be valid until it is
-  fired or removed.
+  fired or removed. The callback gets the timer pointer, but the timer
+  may have been removed or re-inserted by someone else meanwhile; check
+  with is_scheduled() under the owner's lock before using it.
  */
 
 class RegistrationTimer
 : public AmThread
 {
-  time_t current_bucket_start;
-  // every bucket contains TIMER_BUCKET_LENGTH seconds of timers
-  RegTimerBucket buckets[TIMER_BUCKETS];
-  unsigned int current_bucket;
-  AmMutex buckets_mut;
-
-  int get_bucket_index(time_t tv);
-  void place_timer(RegTimer* timer, int bucket_index);
+  AmTimerWheel wheel;
+  AmMutex wheel_mut;
+
   void fire_timer(RegTimer* timer);
-  void run_timers();
 
  protected:
   void run();
@@ -102,11 +93,20 @@ class RegistrationTimer
  public:
   bool insert_timer(RegTimer* timer);
   bool remove_timer(RegTimer* timer);
+  bool is_scheduled(RegTimer* timer);
 
   bool insert_timer_leastloaded(RegTimer* timer,
 				time_t from_time,
 				time_t to_time);
 
+  /** insert the timer at a random time between from_time and to_time */
+  bool insert_timer_jittered(RegTimer* timer,
+			     time_t from_time,
+			     time_t to_time);
+
+  /** fire the timers expired at now (timer thread: every TIMER_RESOLUTION) */
+  void run_timers(time_t now);
+
   RegistrationTimer(); 
   bool _timer_thread_running;
   bool _shutdown_finished;
@@ -43,6 +43,8 @@
 #include <fstream>
 
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <errno.h>
 #include <dirent.h>
 
 #define MOD_NAME "dsm"
@@ -65,6 +67,7 @@ bool DSMFactory::DebugDSM;
 string DSMFactory::InboundStartDiag;
 string DSMFactory::OutboundStartDiag;
 bool DSMFactory::CheckDSM;
+string DSMFactory::ChartCachePath;
 
 #ifdef USE_MONITORING
 bool DSMFactory::MonitoringFullCallgraph;
@@ -106,11 +109,19 @@ DSMFactory::~DSMFactory() {
 	 prompt_sets.begin(); it != prompt_sets.end(); it++)
     delete it->second;
 
-  for (std::set<DSMStateDiagramCollection*>::iterator it=
-	 old_diags.begin(); it != old_diags.end(); it++)
-    delete *it;
+  std::set<DSMStateDiagramCollection*> used_diags;
+  used_diags.insert(MainScriptConfig.diags);
+  for (map<string, DSMScriptConfig>::iterator it=
+	 ScriptConfigs.begin(); it != ScriptConfigs.end(); it++)
+    used_diags.insert(it->second.diags);
+  for (map<string, DSMScriptConfig>::iterator it=
+	 Name2ScriptConfig.begin(); it != Name2ScriptConfig.end(); it++)
+    used_diags.insert(it->second.diags);
+  used_diags.erase(NULL);
 
-  delete MainScriptConfig.diags;
+  for (std::set<DSMStateDiagramCollection*>::iterator it=
+	 used_diags.begin(); it != used_diags.end(); it++)
+    (*it)->release();
 }
 
 int DSMFactory::onLoad()
@@ -127,6 +138,12 @@ int DSMFactory::onLoad()
 
   DebugDSM = cfg.getParameter("debug_raw_dsm") == "yes";
   CheckDSM = cfg.getParameter("dsm_consistency_check", "yes") == "yes";
+  ChartCachePath = cfg.getParameter("chart_cache_path");
+  if (!ChartCachePath.empty() &&
+      mkdir(ChartCachePath.c_str(), 0755) && errno != EEXIST) {
+    WARN("creating chart_cache_path '%s': %s - compiled charts not cached\n",
+	 ChartCachePath.c_str(), strerror(errno));
+  }
  
   if (!loadPrompts(cfg))
     return -1;
@@ -365,6 +382,8 @@ bool DSMFactory::loadDiags(AmConfigReader& cfg, DSMStateDiagramCollection* m_dia
 
   // todo: pass preloaded mods to chart reader
 
+  m_diags->setCachePath(ChartCachePath);
+
   string LoadDiags = cfg.getParameter("load_diags");
   vector<string> diags_names = explode(LoadDiags, ",");
   for (vector<string>::iterator it=
@@ -452,32 +471,37 @@ bool DSMFactory::loadConfig(const string& conf_file_name, const string& conf_nam
     used_diags = script_config.diags = new DSMStateDiagramCollection();
   }
 
-  if (!loadDiags(cfg, used_diags))
-    return false;
-
   vector<string> registered_apps;
-  if (!registerApps(cfg, used_diags, registered_apps))
+  if (!loadDiags(cfg, used_diags) ||
+      !registerApps(cfg, used_diags, registered_apps)) {
+    if (script_config.diags != NULL)
+      script_config.diags->release();
     return false;
+  }
 
   ScriptConfigs_mut.lock();
   try {
+    std::set<DSMStateDiagramCollection*> replaced_diags;
+    map<string, DSMScriptConfig>::iterator n_it=Name2ScriptConfig.find(script_name);
+    if (n_it != Name2ScriptConfig.end())
+      replaced_diags.insert(n_it->second.diags);
     Name2ScriptConfig[script_name] = script_config;
     // set ScriptConfig to this for all registered apps' names
     for (vector<string>::iterator reg_app_it=
 	   registered_apps.begin(); reg_app_it != registered_apps.end(); reg_app_it++) {
       string& app_name = *reg_app_it;
-      // dispose of the old one, if it exists
       map<string, DSMScriptConfig>::iterator it=ScriptConfigs.find(app_name);
-      if (it != ScriptConfigs.end()) {
-	// may be in use by active call - don't delete but save to 
-	// old_diags for garbage collection (destructor)
-	if (it->second.diags != NULL)
-	  old_diags.insert(it->second.diags);   
-      }
+      if (it != ScriptConfigs.end())
+	replaced_diags.insert(it->second.diags);
       
       // overwrite with new config
       ScriptConfigs[app_name] = script_config;
     }
+
+    // may be in use by active calls - they hold a reference
+    for (std::set<DSMStateDiagramCollection*>::iterator it=
+	   replaced_diags.begin(); it != replaced_diags.end(); it++)
+      retireDiags(*it);
   } catch(...) {
     ScriptConfigs_mut.unlock();
     throw;
@@ -843,6 +867,7 @@ void DSMFactory::reloadDSMs(const AmArg& args, AmArg& ret) {
   }
 
   DSMStateDiagramCollection* new_diags = new DSMStateDiagramCollection();
+  new_diags->setCachePath(ChartCachePath);
 
   string DiagPath = cfg.getParameter("diag_path");
   if (DiagPath.length() && DiagPath[DiagPath.length()-1] != '/')
@@ -860,12 +885,16 @@ void DSMFactory::reloadDSMs(const AmArg& args, AmArg& ret) {
 	    it->c_str(), (DiagPath+*it+".dsm").c_str());
       ret.push(500);
       ret.push("loading " +*it+ " from "+ DiagPath+*it+".dsm");
+      new_diags->release();
       return;
     }
   }
+
+  // running calls keep the old diags
   ScriptConfigs_mut.lock();
-  old_diags.insert(MainScriptConfig.diags);
+  DSMStateDiagramCollection* old_diags = MainScriptConfig.diags;
   MainScriptConfig.diags = new_diags; 
+  retireDiags(old_diags);
   ScriptConfigs_mut.unlock();
 
   ret.push(200);
@@ -1052,28 +1081,7 @@ void DSMFactory::loadDSM(const AmArg& args, AmArg& ret) {
 
   string ModPath = cfg.getParameter("mod_path");
 
-  string dsm_file_name = DiagPath+dsm_name+".dsm";
-  string res = "OK";
-
-  ScriptConfigs_mut.lock();
-  try {
-    if (MainScriptConfig.diags->hasDiagram(dsm_name)) {
-      ret.push(400);
-      ret.push("DSM named '" + dsm_name + "' already loaded (use reloadDSMs to reload all)");
-    } else {
-      if (!MainScriptConfig.diags->loadFile(dsm_file_name, dsm_name, DiagPath, ModPath, DebugDSM, CheckDSM)) {
-	ret.push(500);
-	ret.push("error loading "+dsm_name+" from "+ dsm_file_name);
-      } else {
-	ret.push(200);
-	ret.push("loaded "+dsm_name+" from "+ dsm_file_name);
-      }
-    }
-  } catch(...) {
-    ScriptConfigs_mut.unlock();
-    throw;
-  }
-  ScriptConfigs_mut.unlock();
+  loadMainDiag(dsm_name, DiagPath, ModPath, ret);
 }
 
 void DSMFactory::loadDSMWithPaths(const AmArg& args, AmArg& ret) {
@@ -1081,26 +1089,69 @@ void DSMFactory::loadDSMWithPaths(const AmArg& args, AmArg& ret) {
   string diag_path = args.get(1).asCStr();
   string mod_path  = args.get(2).asCStr();
 
-  string res = "OK";
+  loadMainDiag(dsm_name, diag_path, mod_path, ret);
+}
+
+void DSMFactory::loadMainDiag(const string& dsm_name, const string& diag_path,
+			      const string& mod_path, AmArg& ret) {
+  string dsm_file_name = diag_path+dsm_name+".dsm";
+
   ScriptConfigs_mut.lock();
-  try {
-    if (MainScriptConfig.diags->hasDiagram(dsm_name)) {
-      ret.push(400);
-      ret.push("DSM named '" + dsm_name + "' already loaded (use reloadDSMs to reload all)");
+  DSMStateDiagramCollection* cur_diags = MainScriptConfig.diags;
+  cur_diags->addRef();
+  ScriptConfigs_mut.unlock();
+
+  // running calls use the current diags, so load them again
+  // with the new one into a new set (quick from the chart cache)
+  DSMStateDiagramCollection* new_diags = NULL;
+  if (cur_diags->hasDiagram(dsm_name)) {
+    ret.push(400);
+    ret.push("DSM named '" + dsm_name + "' already loaded (use reloadDSMs to reload all)");
+  } else {
+    new_diags = new DSMStateDiagramCollection();
+    new_diags->setCachePath(ChartCachePath);
+    if (!new_diags->loadFilesOf(cur_diags, DebugDSM, CheckDSM) ||
+	!new_diags->loadFile(dsm_file_name, dsm_name, diag_path, mod_path,
+			     DebugDSM, CheckDSM)) {
+      ret.push(500);
+      ret.push("error loading "+dsm_name+" from "+ dsm_file_name);
+      new_diags->release();
+      new_diags = NULL;
+    }
+  }
+
+  if (new_diags != NULL) {
+    ScriptConfigs_mut.lock();
+    if (MainScriptConfig.diags == cur_diags) {
+      MainScriptConfig.diags = new_diags;
+      retireDiags(cur_diags);
+      ret.push(200);
+      ret.push("loaded "+dsm_name+" from "+ dsm_file_name);
     } else {
-      if (!MainScriptConfig.diags->loadFile(diag_path+dsm_name+".dsm", dsm_name, diag_path, mod_path, DebugDSM, CheckDSM)) {
-	ret.push(500);
-	ret.push("error loading "+dsm_name+" from "+ diag_path+dsm_name+".dsm");
-      } else {
-	ret.push(200);
-	ret.push("loaded "+dsm_name+" from "+ diag_path+dsm_name+".dsm");
-      }
+      new_diags->release();
+      ret.push(500);
+      ret.push("DSMs reloaded while loading "+dsm_name+", try again");
     }
-  } catch(...) {
     ScriptConfigs_mut.unlock();
-    throw;
   }
-  ScriptConfigs_mut.unlock();
+
+  cur_diags->release();
+}
+
+void DSMFactory::retireDiags(DSMStateDiagramCollection* diags) {
+  if (diags == NULL || diags == MainScriptConfig.diags)
+    return;
+
+  for (map<string, DSMScriptConfig>::iterator it=
+	 ScriptConfigs.begin(); it != ScriptConfigs.end(); it++)
+    if (it->second.diags == diags)
+      return;
+  for (map<string, DSMScriptConfig>::iterator it=
+	 Name2ScriptConfig.begin(); it != Name2ScriptConfig.end(); it++)
+    if (it->second.diags == diags)
+      return;
+
+  diags->release();
 }
 
 bool DSMFactory::addScriptDiagsToEngine(const string& config_set,
@@ -64,10 +64,9 @@ class DSMFactory
   AmPromptCollection prompts;
   AmMutex main_diags_mut;
 
-  std::set<DSMStateDiagramCollection*> old_diags;
-
   static bool DebugDSM;
   static bool CheckDSM;
+  static string ChartCachePath;
 
   static string InboundStartDiag;
   static string OutboundStartDiag;
@@ -99,6 +98,8 @@ class DSMFactory
   bool loadDiags(AmConfigReader& cfg, DSMStateDiagramCollection* m_diags);
   bool registerApps(AmConfigReader& cfg, DSMStateDiagramCollection* m_diags, 
 		    vector<string>& register_names /* out */);
+  /** release diags unless a script config still uses them (ScriptConfigs_mut) */
+  void retireDiags(DSMStateDiagramCollection* diags);
   bool loadPromptSets(AmConfigReader& cfg);
   bool loadPrompts(AmConfigReader& cfg);
   bool hasDSM(const string& dsm_name, const string& conf_name);
@@ -120,6 +121,8 @@ class DSMFactory
   void preloadModule(const AmArg& args, AmArg& ret);
   void loadDSM(const AmArg& args, AmArg& ret);
   void loadDSMWithPaths(const AmArg& args, AmArg& ret);
+  void loadMainDiag(const string& dsm_name, const string& diag_path,
+		    const string& mod_path, AmArg& ret);
   void registerApplication(const AmArg& args, AmArg& ret);
   void loadConfig(const AmArg& args, AmArg& ret);
 
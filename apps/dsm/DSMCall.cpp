@@ -36,6 +36,7 @@
 #include "AmSipSubscription.h"
 
 #include "../apps/jsonrpc/JsonRPCEvents.h" // todo!
+#include "ampi/HttpClientAPI.h"
 
 DSMCall::DSMCall(const DSMScriptConfig& config,
 		 AmPromptCollection* prompts,
@@ -523,6 +524,20 @@ void DSMCall::process(AmEvent* event)
     engine.runEvent(this, this, DSMCondition::DSMEvent, &params);
   }
 
+  HttpResponseEvent* http_ev = dynamic_cast<HttpResponseEvent*>(event);
+  if (http_ev) {
+    map<string, string> params;
+    params["type"] = "http.response";
+    params["id"] = http_ev->token;
+    params["url"] = http_ev->url;
+    params["status"] = int2str((int)http_ev->status);
+    params["body"] = http_ev->body;
+    params["content_type"] = http_ev->content_type;
+    params["error"] = http_ev->error_str;
+    params["time_ms"] = int2str(http_ev->time_ms);
+    engine.runEvent(this, this, DSMCondition::DSMEvent, &params);
+  }
+
   // todo: give modules the possibility to define/process events
   JsonRpcEvent* jsonrpc_ev = dynamic_cast<JsonRpcEvent*>(event);
   if (jsonrpc_ev) { 
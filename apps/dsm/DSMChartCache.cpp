@@ -0,0 +1,220 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "DSMChartCache.h"
+#include "log.h"
+#include "AmUtils.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <fstream>
+#include <sstream>
+
+// file layout (host byte order):
+//   "DSMC" u32 version u64 text_hash u64 text_length
+//   u32 n_modules { str file u64 size u64 mtime }
+//   u32 n_tokens  { u8 resolved_by str token }
+// str is u32 length and the bytes
+
+#define DSM_CHART_CACHE_MAGIC "DSMC"
+
+static void put_u32(string& s, uint32_t v) {
+  s.append((const char*)&v, sizeof(v));
+}
+
+static void put_u64(string& s, uint64_t v) {
+  s.append((const char*)&v, sizeof(v));
+}
+
+static void put_str(string& s, const string& v) {
+  put_u32(s, v.length());
+  s.append(v);
+}
+
+/** reads what put_* wrote, fails on truncated data */
+struct CacheBuf {
+  const string& s;
+  size_t pos;
+
+  CacheBuf(const string& s) : s(s), pos(0) { }
+
+  bool get(void* v, size_t len) {
+    if (s.length() - pos < len)
+      return false;
+    memcpy(v, s.data() + pos, len);
+    pos += len;
+    return true;
+  }
+  bool get_u32(uint32_t& v) { return get(&v, sizeof(v)); }
+  bool get_u64(uint64_t& v) { return get(&v, sizeof(v)); }
+  bool get_str(string& v) {
+    uint32_t len;
+    if (!get_u32(len) || s.length() - pos < len)
+      return false;
+    v.assign(s, pos, len);
+    pos += len;
+    return true;
+  }
+};
+
+/** identifies a version of a module file */
+static bool mod_file_stat(const string& file, uint64_t& size, uint64_t& mtime) {
+  struct stat st;
+  if (stat(file.c_str(), &st))
+    return false;
+  size = st.st_size;
+  mtime = st.st_mtime;
+  return true;
+}
+
+DSMChartCache::DSMChartCache(const string& cache_path, const string& text)
+  : text(text), text_hash(hash(text))
+{
+  char hash_hex[17];
+  snprintf(hash_hex, sizeof(hash_hex), "%016llx", text_hash);
+  file_name = cache_path;
+  if (file_name.length() && file_name[file_name.length()-1] != '/')
+    file_name += '/';
+  file_name += string(hash_hex) + ".dsmc";
+}
+
+unsigned long long DSMChartCache::hash(const string& text) {
+  // FNV-1a
+  uint64_t h = 14695981039346656037ULL;
+  for (size_t i=0; i<text.length(); i++) {
+    h ^= (unsigned char)text[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+bool DSMChartCache::read(vector<DSMChartToken>& tokens) {
+  std::ifstream ifs(file_name.c_str(), std::ios::in | std::ios::binary);
+  if (!ifs.good()) {
+    DBG("no compiled chart '%s'\n", file_name.c_str());
+    return false;
+  }
+  std::stringstream buf;
+  buf << ifs.rdbuf();
+  string data = buf.str();
+
+  CacheBuf b(data);
+  char magic[4];
+  uint32_t version;
+  uint64_t c_hash, c_length;
+  if (!b.get(magic, sizeof(magic)) || memcmp(magic, DSM_CHART_CACHE_MAGIC, 4) ||
+      !b.get_u32(version) || version != DSM_CHART_CACHE_VERSION ||
+      !b.get_u64(c_hash) || c_hash != text_hash ||
+      !b.get_u64(c_length) || c_length != text.length()) {
+    DBG("compiled chart '%s' is not for this chart or version\n", file_name.c_str());
+    return false;
+  }
+
+  uint32_t n_mods;
+  if (!b.get_u32(n_mods))
+    goto error;
+  for (uint32_t i=0; i<n_mods; i++) {
+    string mod_file;
+    uint64_t size, mtime, c_size, c_mtime;
+    if (!b.get_str(mod_file) || !b.get_u64(c_size) || !b.get_u64(c_mtime))
+      goto error;
+    if (!mod_file_stat(mod_file, size, mtime) || size != c_size || mtime != c_mtime) {
+      DBG("module '%s' changed since chart '%s' was compiled\n",
+	  mod_file.c_str(), file_name.c_str());
+      return false;
+    }
+  }
+
+  uint32_t n_tokens;
+  if (!b.get_u32(n_tokens))
+    goto error;
+  tokens.reserve(n_tokens);
+  for (uint32_t i=0; i<n_tokens; i++) {
+    unsigned char resolved_by;
+    tokens.push_back(DSMChartToken(""));
+    if (!b.get(&resolved_by, 1) || !b.get_str(tokens.back().str))
+      goto error;
+    tokens.back().resolved_by = resolved_by;
+  }
+  if (b.pos != data.length())
+    goto error;
+
+  return true;
+
+ error:
+  WARN("compiled chart '%s' is damaged, ignoring it\n", file_name.c_str());
+  tokens.clear();
+  return false;
+}
+
+bool DSMChartCache::write(const vector<DSMChartToken>& tokens,
+			  const vector<string>& mod_files) {
+  string data;
+  data.append(DSM_CHART_CACHE_MAGIC, 4);
+  put_u32(data, DSM_CHART_CACHE_VERSION);
+  put_u64(data, text_hash);
+  put_u64(data, text.length());
+
+  put_u32(data, mod_files.size());
+  for (vector<string>::const_iterator it=
+	 mod_files.begin(); it != mod_files.end(); it++) {
+    uint64_t size, mtime;
+    if (!mod_file_stat(*it, size, mtime)) {
+      WARN("not caching chart: module file '%s' not found\n", it->c_str());
+      return false;
+    }
+    put_str(data, *it);
+    put_u64(data, size);
+    put_u64(data, mtime);
+  }
+
+  put_u32(data, tokens.size());
+  for (vector<DSMChartToken>::const_iterator it=
+	 tokens.begin(); it != tokens.end(); it++) {
+    data += (char)it->resolved_by;
+    put_str(data, it->str);
+  }
+
+  string tmp_name = file_name + "." + int2str((int)getpid());
+  FILE* fp = fopen(tmp_name.c_str(), "wb");
+  if (!fp) {
+    WARN("writing compiled chart '%s': %s\n", tmp_name.c_str(), strerror(errno));
+    return false;
+  }
+  bool ok = fwrite(data.data(), 1, data.length(), fp) == data.length();
+  ok = !fclose(fp) && ok;
+  if (!ok || rename(tmp_name.c_str(), file_name.c_str())) {
+    WARN("writing compiled chart '%s': %s\n", file_name.c_str(), strerror(errno));
+    unlink(tmp_name.c_str());
+    return false;
+  }
+
+  DBG("wrote compiled chart '%s' (%zd tokens)\n", file_name.c_str(), tokens.size());
+  return true;
+}
@@ -0,0 +1,68 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef _DSMChartCache_h_
+#define _DSMChartCache_h_
+
+#include "DSMChartReader.h"
+
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+/** change if the cache file layout or the chart syntax changes */
+#define DSM_CHART_CACHE_VERSION 1
+
+/**
+ * compiled chart, stored in cache_path under the hash of the chart
+ * text (with includes): the tokens, and for every action and condition
+ * the module that understood it. Reading it saves tokenizing the chart
+ * and looking up actions in all modules.
+ *
+ * An entry is used only if chart text, cache version and the imported
+ * module files (size, mtime) are unchanged; else the chart is decoded
+ * from text and the entry rewritten.
+ */
+class DSMChartCache
+{
+  string file_name;
+  const string& text;
+  unsigned long long text_hash;
+
+ public:
+  DSMChartCache(const string& cache_path, const string& text);
+
+  static unsigned long long hash(const string& text);
+
+  const string& getFileName() { return file_name; }
+
+  /** @return false if no valid entry for the text */
+  bool read(vector<DSMChartToken>& tokens);
+  /** write the entry atomically (temporary file and rename) */
+  bool write(const vector<DSMChartToken>& tokens,
+	     const vector<string>& mod_files);
+};
+
+#endif
@@ -50,7 +50,7 @@ bool DSMChartReader::is_snt(const char c) {
   return c== ';' || c == '{' || c == '}' || c == '[' || c == ']';
 }
 
-string DSMChartReader::getToken(string str, size_t& pos) {
+string DSMChartReader::getToken(const string& str, size_t& pos) {
   while (pos<str.length() && is_wsp(str[pos]))
     pos++;
 
@@ -118,15 +118,28 @@ string DSMChartReader::getToken(string str, size_t& pos) {
   return res;
 }
 
-DSMAction* DSMChartReader::actionFromToken(const string& str) {
-  for (vector<DSMModule*>::iterator it=
-	 mods.begin(); it!= mods.end(); it++) {
-    DSMAction* a = (*it)->getAction(str);
-    if (a) return a;
+DSMAction* DSMChartReader::actionFromToken(const string& str,
+					   unsigned char& resolved_by) {
+  DSMAction* a = NULL;
+  if (resolved_by < mods.size())
+    a = mods[resolved_by]->getAction(str);
+  else if (resolved_by == DSMChartToken::ResolvedByCore)
+    a = core_mod.getAction(str);
+  if (a) return a;
+
+  for (size_t i=0; i<mods.size() && i<DSMChartToken::ResolvedByCore; i++) {
+    a = mods[i]->getAction(str);
+    if (a) {
+      resolved_by = i;
+      return a;
+    }
   }
 
-  DSMAction* a = core_mod.getAction(str);
-  if (a) return a;
+  a = core_mod.getAction(str);
+  if (a) {
+    resolved_by = DSMChartToken::ResolvedByCore;
+    return a;
+  }
 
   ERROR("could not find action for '%s' (missing import?)\n", str.c_str());
   return NULL;
@@ -200,21 +213,30 @@ bool DSMChartReader::forFromToken(DSMArrayFor& af, const string& token) {
   return true;
 }
 
-DSMCondition* DSMChartReader::conditionFromToken(const string& str, bool invert) {
-  for (vector<DSMModule*>::iterator it=
-	 mods.begin(); it!= mods.end(); it++) {
-    DSMCondition* c=(*it)->getCondition(str);
-    if (c) {
-      c->invert = invert;
-      return c;
-    }
+DSMCondition* DSMChartReader::conditionFromToken(const string& str, bool invert,
+						 unsigned char& resolved_by) {
+  DSMCondition* c = NULL;
+  if (resolved_by < mods.size())
+    c = mods[resolved_by]->getCondition(str);
+  else if (resolved_by == DSMChartToken::ResolvedByCore)
+    c = core_mod.getCondition(str);
+
+  for (size_t i=0; !c && i<mods.size() && i<DSMChartToken::ResolvedByCore; i++) {
+    c = mods[i]->getCondition(str);
+    if (c)
+      resolved_by = i;
   }
 
-  DSMCondition* c = core_mod.getCondition(str);
-  if (c) 
-    c->invert = invert;
+  if (!c) {
+    c = core_mod.getCondition(str);
+    if (c)
+      resolved_by = DSMChartToken::ResolvedByCore;
+  }
 
-  if (c)  return c;
+  if (c) {
+    c->invert = invert;
+    return c;
+  }
   ERROR("could not find condition for '%s' (missing import?)\n", str.c_str());
   return NULL;
 }
@@ -255,20 +277,36 @@ bool DSMChartReader::importModule(const string& mod_cmd, const string& mod_path)
     return false;
   }
   mods.push_back(mod);
+  mod_files.push_back(fname);
   DBG("loaded module '%s' from '%s'\n", 
       params.c_str(), fname.c_str());
   return true;
 }
 
+void DSMChartReader::tokenize(const string& chart, vector<DSMChartToken>& tokens) {
+  size_t pos = 0;
+  while (pos < chart.length()) {
+    string token = getToken(chart, pos);
+    if (token.length())
+      tokens.push_back(DSMChartToken(token));
+  }
+}
+
 bool DSMChartReader::decode(DSMStateDiagram* e, const string& chart, 
 			    const string& mod_path, DSMElemContainer* owner,
 			    vector<DSMModule*>& out_mods) {
+  vector<DSMChartToken> tokens;
+  tokenize(chart, tokens);
+  return decode(e, tokens, mod_path, owner, out_mods);
+}
+
+bool DSMChartReader::decode(DSMStateDiagram* e, vector<DSMChartToken>& tokens,
+			    const string& mod_path, DSMElemContainer* owner,
+			    vector<DSMModule*>& out_mods) {
   vector<DSMElement*> stack;
-  size_t pos = 0;
-  while (pos < chart.length()) {
-    string token = getToken(chart, pos);
-    if (!token.length())
-      continue;
+  for (vector<DSMChartToken>::iterator t_it=
+	 tokens.begin(); t_it != tokens.end(); t_it++) {
+    const string& token = t_it->str;
     
     if (token.length()>6 && token.substr(0, 6) == "import") {
       if (!importModule(token, mod_path)) {
@@ -574,7 +612,7 @@ bool DSMChartReader::decode(DSMStateDiagram* e, const string& chart,
       }
 
       DBG("adding action '%s'\n", token.c_str());
-      DSMAction* a = actionFromToken(token);
+      DSMAction* a = actionFromToken(token, t_it->resolved_by);
       if (!a)
 	return false;
       owner->transferElem(a);
@@ -652,7 +690,7 @@ bool DSMChartReader::decode(DSMStateDiagram* e, const string& chart,
       }
       
       DBG("new condition: '%s'\n", token.c_str());
-      DSMCondition* c = conditionFromToken(token, cl->invert_next);
+      DSMCondition* c = conditionFromToken(token, cl->invert_next, t_it->resolved_by);
       cl->invert_next = false;
       if (!c) 
       	return false;
@@ -749,4 +787,5 @@ void DSMChartReader::cleanup() {
   for (vector<DSMModule*>::iterator it=mods.begin(); it != mods.end(); it++)
     delete *it;
   mods.clear();  
+  mod_files.clear();
 }
@@ -84,19 +84,37 @@ struct DSMConditionList : public DSMElement {
   bool is_if;
 };
 
+/** a token of a chart, with the module that understood it */
+struct DSMChartToken {
+  enum {
+    ResolvedByCore = 0xfe,
+    Unresolved = 0xff
+  };
+
+  string str;
+  /** index of the imported module that made the action or condition */
+  unsigned char resolved_by;
+
+  DSMChartToken(const string& str)
+    : str(str), resolved_by(Unresolved) { }
+};
+
 class DSMChartReader {
 
   bool is_wsp(const char c);
   bool is_snt(const char c);
 
-  string getToken(string str, size_t& pos);
+  string getToken(const string& str, size_t& pos);
   DSMFunction* functionFromToken(const string& str);
-  DSMAction* actionFromToken(const string& str);
-  DSMCondition* conditionFromToken(const string& str, bool invert);
+  DSMAction* actionFromToken(const string& str, unsigned char& resolved_by);
+  DSMCondition* conditionFromToken(const string& str, bool invert,
+				   unsigned char& resolved_by);
   bool forFromToken(DSMArrayFor& af, const string& token);
 
   bool importModule(const string& mod_cmd, const string& mod_path);
   vector<DSMModule*> mods;
+  /** files of mods */
+  vector<string> mod_files;
   DSMCoreModule core_mod;
 
   vector<DSMFunction*> funcs;
@@ -108,6 +126,20 @@ class DSMChartReader {
 	      const string& mod_path, DSMElemContainer* owner,
 	      vector<DSMModule*>& out_mods);
 
+  /** split chart text into tokens */
+  void tokenize(const string& chart, vector<DSMChartToken>& tokens);
+  /**
+   * decode a tokenized chart; notes in the tokens which module
+   * understood each action and condition, and asks that module
+   * first if already noted (e.g. tokens from the chart cache)
+   */
+  bool decode(DSMStateDiagram* e, vector<DSMChartToken>& tokens,
+	      const string& mod_path, DSMElemContainer* owner,
+	      vector<DSMModule*>& out_mods);
+
+  /** module files imported by the charts decoded */
+  const vector<string>& getModuleFiles() { return mod_files; }
+
   friend class DSMFactory;
   void cleanup();
 };
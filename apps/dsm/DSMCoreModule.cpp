@@ -272,15 +272,15 @@ DSMCondition* DSMCoreModule::getCondition(const string& from_str) {
 }
 
 EXEC_ACTION_START(SCPlayPromptAction) {
-  sc_sess->playPrompt(resolveVars(arg, sess, sc_sess, event_params));
+  sc_sess->playPrompt(arg_tpl.resolve(sess, sc_sess, event_params));
 } EXEC_ACTION_END;
 
 EXEC_ACTION_START(SCPlayPromptFrontAction) {
-  sc_sess->playPrompt(resolveVars(arg, sess, sc_sess, event_params), false, true);
+  sc_sess->playPrompt(arg_tpl.resolve(sess, sc_sess, event_params), false, true);
 } EXEC_ACTION_END;
 
 EXEC_ACTION_START(SCSetPromptsAction) {
-  sc_sess->setPromptSet(resolveVars(arg, sess, sc_sess, event_params));
+  sc_sess->setPromptSet(arg_tpl.resolve(sess, sc_sess, event_params));
 } EXEC_ACTION_END;
 
 CONST_ACTION_2P(SCAddSeparatorAction, ',', true);
@@ -290,7 +290,7 @@ EXEC_ACTION_START(SCAddSeparatorAction){
 } EXEC_ACTION_END;
 
 EXEC_ACTION_START(SCPlayPromptLoopedAction){
-  sc_sess->playPrompt(resolveVars(arg, sess, sc_sess, event_params), true);
+  sc_sess->playPrompt(arg_tpl.resolve(sess, sc_sess, event_params), true);
 } EXEC_ACTION_END;
 
 void setEventParameters(const DSMSession* sc_sess, const string& var, VarMapT& params) {
@@ -370,18 +370,18 @@ EXEC_ACTION_START(SCB2BSetRelayOnlyAction) {
 CONST_ACTION_2P(SCPlayFileAction, ',', true);
 EXEC_ACTION_START(SCPlayFileAction) {
   bool loop = 
-    resolveVars(par2, sess, sc_sess, event_params) == "true";
+    par2_tpl.resolve(sess, sc_sess, event_params) == "true";
   DBG("par1 = '%s', par2 = %s\n", par1.c_str(), par2.c_str());
-  sc_sess->playFile(resolveVars(par1, sess, sc_sess, event_params), 
+  sc_sess->playFile(par1_tpl.resolve(sess, sc_sess, event_params), 
 		    loop);
 } EXEC_ACTION_END;
 
 CONST_ACTION_2P(SCPlayFileFrontAction, ',', true);
 EXEC_ACTION_START(SCPlayFileFrontAction) {
   bool loop = 
-    resolveVars(par2, sess, sc_sess, event_params) == "true";
+    par2_tpl.resolve(sess, sc_sess, event_params) == "true";
   DBG("par1 = '%s', par2 = %s\n", par1.c_str(), par2.c_str());
-  sc_sess->playFile(resolveVars(par1, sess, sc_sess, event_params), 
+  sc_sess->playFile(par1_tpl.resolve(sess, sc_sess, event_params), 
 		    loop, true);
 } EXEC_ACTION_END;
 
@@ -597,7 +597,7 @@ DSMAction::SEAction SCJumpFSMAction::getSEAction(string& param,
 						 AmSession* sess, DSMSession* sc_sess,
 						 DSMCondition::EventType event,
 						 map<string,string>* event_params) {
-  param = resolveVars(arg, sess, sc_sess, event_params);
+  param = arg_tpl.resolve(sess, sc_sess, event_params);
   return Jump; 
 }
 
@@ -615,7 +615,7 @@ DSMAction::SEAction SCCallFSMAction::getSEAction(string& param,
 						 AmSession* sess, DSMSession* sc_sess,
 						 DSMCondition::EventType event,
 						 map<string,string>* event_params) {
-  param = resolveVars(arg, sess, sc_sess, event_params);
+  param = arg_tpl.resolve(sess, sc_sess, event_params);
   return Call; 
 }
 
@@ -632,11 +632,11 @@ DSMAction::SEAction SCReturnFSMAction::getSEAction(string& param,
 CONST_ACTION_2P(SCLogAction, ',', false);
 EXEC_ACTION_START(SCLogAction) {
   unsigned int lvl;
-  if (str2i(resolveVars(par1, sess, sc_sess, event_params), lvl)) {
+  if (str2i(par1_tpl.resolve(sess, sc_sess, event_params), lvl)) {
     ERROR("unknown log level '%s'\n", par1.c_str());
     EXEC_ACTION_STOP;
   }
-  string l_line = resolveVars(par2, sess, sc_sess, event_params).c_str();
+  string l_line = par2_tpl.resolve(sess, sc_sess, event_params);
   _LOG((int)lvl, "FSM: %s '%s'\n", (par2 != l_line)?par2.c_str():"",
        l_line.c_str());
 } EXEC_ACTION_END;
@@ -760,21 +760,18 @@ EXEC_ACTION_START(SCSetAction) {
   if (par1.length() && par1[0] == '#') {
     // set param
     if (NULL != event_params) {
-      string res = resolveVars(par2, sess, sc_sess, event_params);
-      (*event_params)[par1.substr(1)] = res;
-      DBG("set #%s='%s'\n", par1.substr(1).c_str(), res.c_str());
+      string res = par2_tpl.resolve(sess, sc_sess, event_params);
+      (*event_params)[par1_tpl.getName()] = res;
+      DBG("set #%s='%s'\n", par1_tpl.getName().c_str(), res.c_str());
     } else {
       DBG("not setting %s (no param set)\n", par1.c_str());
     }
   } else {
     // set variable
-    string var_name = (par1.length() && par1[0] == '$')?
-      par1.substr(1) : par1;
-
-    sc_sess->var[var_name] = resolveVars(par2, sess, sc_sess, event_params);
+    string& var = par1_tpl.getVar(sc_sess);
+    var = par2_tpl.resolve(sess, sc_sess, event_params);
     
-    DBG("set $%s='%s'\n", 
-	var_name.c_str(), sc_sess->var[var_name].c_str());
+    DBG("set $%s='%s'\n", par1_tpl.getName().c_str(), var.c_str());
   }
 } EXEC_ACTION_END;
 
@@ -1036,13 +1033,10 @@ EXEC_ACTION_START(SCArrayIndexAction) {
 
 CONST_ACTION_2P(SCAppendAction,',', false);
 EXEC_ACTION_START(SCAppendAction) {
-  string var_name = (par1.length() && par1[0] == '$')?
-    par1.substr(1) : par1;
-
-  sc_sess->var[var_name] += resolveVars(par2, sess, sc_sess, event_params);
+  string& var = par1_tpl.getVar(sc_sess);
+  var += par2_tpl.resolve(sess, sc_sess, event_params);
 
-  DBG("$%s now '%s'\n", 
-      var_name.c_str(), sc_sess->var[var_name].c_str());
+  DBG("$%s now '%s'\n", par1_tpl.getName().c_str(), var.c_str());
 } EXEC_ACTION_END;
 
 CONST_ACTION_2P(SCSubStrAction,',', false);
@@ -1087,14 +1081,12 @@ EXEC_ACTION_START(SCSubStrAction) {
 } EXEC_ACTION_END;
 
 EXEC_ACTION_START(SCIncAction) {
-  string var_name = (arg.length() && arg[0] == '$')?
-    arg.substr(1) : arg;
+  string& var = arg_tpl.getVar(sc_sess);
   unsigned int val = 0;
-  str2i(sc_sess->var[var_name], val);
-  sc_sess->var[var_name] = int2str(val+1);
+  str2i(var, val);
+  var = int2str(val+1);
 
-  DBG("inc: $%s now '%s'\n", 
-      var_name.c_str(), sc_sess->var[var_name].c_str());
+  DBG("inc: $%s now '%s'\n", arg_tpl.getName().c_str(), var.c_str());
 
 } EXEC_ACTION_END;
 
@@ -1102,24 +1094,20 @@ CONST_ACTION_2P(SCSetTimerAction,',', false);
 EXEC_ACTION_START(SCSetTimerAction) {
 
   unsigned int timerid;
-  if (str2i(resolveVars(par1, sess, sc_sess, event_params), timerid)) {
-    ERROR("timer id '%s' not decipherable\n", 
-	  resolveVars(par1, sess, sc_sess, event_params).c_str());
+  string timerid_s = par1_tpl.resolve(sess, sc_sess, event_params);
+  if (str2i(timerid_s, timerid)) {
+    ERROR("timer id '%s' not decipherable\n", timerid_s.c_str());
     sc_sess->SET_ERRNO(DSM_ERRNO_UNKNOWN_ARG);
-    sc_sess->SET_STRERROR("timer id '"+
-			  resolveVars(par1, sess, sc_sess, event_params)+
-			  "' not decipherable\n");
+    sc_sess->SET_STRERROR("timer id '"+timerid_s+"' not decipherable\n");
     EXEC_ACTION_STOP;
   }
 
   unsigned int timeout;
-  if (str2i(resolveVars(par2, sess, sc_sess, event_params), timeout)) {
-    ERROR("timeout value '%s' not decipherable\n", 
-	  resolveVars(par2, sess, sc_sess, event_params).c_str());
+  string timeout_s = par2_tpl.resolve(sess, sc_sess, event_params);
+  if (str2i(timeout_s, timeout)) {
+    ERROR("timeout value '%s' not decipherable\n", timeout_s.c_str());
     sc_sess->SET_ERRNO(DSM_ERRNO_UNKNOWN_ARG);
-    sc_sess->SET_STRERROR("timeout value '"+
-			  resolveVars(par2, sess, sc_sess, event_params)+
-			  "' not decipherable\n");
+    sc_sess->SET_STRERROR("timeout value '"+timeout_s+"' not decipherable\n");
     EXEC_ACTION_STOP;
   }
 
@@ -1171,7 +1159,8 @@ EXEC_ACTION_START(SCRemoveTimersAction) {
 
 
 // TODO: replace with real expression matching 
-TestDSMCondition::TestDSMCondition(const string& expr, DSMCondition::EventType evt) {
+TestDSMCondition::TestDSMCondition(const string& expr, DSMCondition::EventType evt)
+  : lhs_len(false), rhs_len(false) {
 
   type = evt;
 
@@ -1209,10 +1198,23 @@ TestDSMCondition::TestDSMCondition(const string& expr, DSMCondition::EventType e
 
   lhs = trim(expr.substr(0, p), " ");
   rhs = trim(expr.substr(p2,expr.length()-p2+1), " ");
+  lhs_len = parseLen(lhs, lhs_tpl);
+  rhs_len = parseLen(rhs, rhs_tpl);
 
   name = expr;
 }
 
+/** @return whether s is len(...) */
+bool TestDSMCondition::parseLen(const string& s, DSMVarTemplate& tpl) {
+  if (s.length() > 5 && 
+      (s.substr(0, 4) == "len(") && s[s.length()-1] == ')') {
+    tpl = DSMVarTemplate(s.substr(4, s.length()-5));
+    return true;
+  }
+  tpl = DSMVarTemplate(s);
+  return false;
+}
+
 bool TestDSMCondition::match(AmSession* sess, DSMSession* sc_sess, DSMCondition::EventType event,
 			  map<string,string>* event_params) {
   if (ttype == None || (type != DSMCondition::Any && type != event))
@@ -1226,22 +1228,12 @@ bool TestDSMCondition::match(AmSession* sess, DSMSession* sc_sess, DSMCondition:
     return false;
   }
   
-  string l;
-  string r;
-  if (lhs.length() > 5 && 
-      (lhs.substr(0, 4) == "len(") && lhs[lhs.length()-1] == ')') {
-    l = int2str((unsigned int)resolveVars(lhs.substr(4, lhs.length()-5), sess, sc_sess, event_params).length());
-  } else {    
-    l   = resolveVars(lhs, sess, sc_sess, event_params);
-  }
-  if (rhs.length() > 5 && 
-      rhs.substr(0, 4) == "len(" && rhs[rhs.length()-1] == ')') {
-    r = resolveVars(rhs.substr(4, rhs.length()-5), sess, sc_sess, event_params).length();
-  } else {    
-    r   = resolveVars(rhs, sess, sc_sess, event_params);
-  }
-
-//   string r = resolveVars(rhs, sess, sc_sess, event_params);
+  string l = lhs_tpl.resolve(sess, sc_sess, event_params);
+  if (lhs_len)
+    l = int2str((unsigned int)l.length());
+  string r = rhs_tpl.resolve(sess, sc_sess, event_params);
+  if (rhs_len)
+    r = int2str((unsigned int)r.length());
 
   DBG("test '%s' vs '%s'\n", l.c_str(), r.c_str());
 
@@ -168,6 +168,14 @@ class TestDSMCondition
   string rhs;
   CondType ttype;
 
+  // lhs and rhs, without len()
+  DSMVarTemplate lhs_tpl;
+  DSMVarTemplate rhs_tpl;
+  bool lhs_len;
+  bool rhs_len;
+
+  static bool parseLen(const string& s, DSMVarTemplate& tpl);
+
  public:
   TestDSMCondition(const string& expr, DSMCondition::EventType e);
   bool match(AmSession* sess, DSMSession* sc_sess, DSMCondition::EventType event,
@@ -29,6 +29,7 @@
 #include "DSMModule.h"
 #include "DSMSession.h"
 #include "AmSession.h"
+#include "AmThread.h"
 
 DSMModule::DSMModule() {
 }
@@ -42,6 +43,7 @@ SCStrArgAction::SCStrArgAction(const string& m_arg) {
     arg = trim(arg, "\"");
   else if (arg.length() && arg[0] == '\'')
     arg = trim(arg, "'");
+  arg_tpl = DSMVarTemplate(arg);
 }
 
 bool isNumber(const std::string& s) {
@@ -142,6 +144,166 @@ string resolveVars(const string ts, AmSession* sess,
   return s;
 }
 
+static AmMutex var_names_mut;
+static map<string, unsigned int> var_names;
+
+unsigned int internVarName(const string& name) {
+  AmLock l(var_names_mut);
+  map<string, unsigned int>::iterator it = var_names.find(name);
+  if (it != var_names.end())
+    return it->second;
+
+  unsigned int slot = var_names.size();
+  var_names[name] = slot;
+  return slot;
+}
+
+DSMVarTemplate::DSMVarTemplate()
+  : kind(Literal), slot(0), select(SelLocalTag), op(0) {
+}
+
+DSMVarTemplate::DSMVarTemplate(const string& ts, bool eval_ops)
+  : kind(Literal), slot(0), select(SelLocalTag), op(0) {
+  string s = ts;
+  if (s.empty())
+    return;
+
+  if (eval_ops) {
+    // same as resolveVars: spaces removed, split at the first '-', else '+'
+    string::size_type p;
+    for (p = s.find(" ", 0); p != string::npos; p = s.find(" ", p))
+      s.erase(p, 1);
+
+    if ((p = s.find("-")) != string::npos)
+      op = '-';
+    else if ((p = s.find("+")) != string::npos)
+      op = '+';
+
+    if (op) {
+      lhs.reset(new DSMVarTemplate(s.substr(0, p), true));
+      rhs.reset(new DSMVarTemplate(s.substr(p+1, string::npos), true));
+    }
+  }
+
+  parse(s);
+}
+
+void DSMVarTemplate::parse(const string& s) {
+  if (s.empty())
+    return;
+
+  switch (s[0]) {
+  case '$':
+    if (s.substr(1, 1) == "$") {
+      name = "$";
+    } else {
+      kind = Var;
+      name = s.substr(1);
+      slot = internVarName(name);
+    }
+    return;
+
+  case '#':
+    if (s.substr(1, 1) == "#") {
+      name = "#";
+    } else {
+      kind = Param;
+      name = s.substr(1);
+    }
+    return;
+
+  case '@': {
+    if (s.substr(1, 1) == "@" || s.length() < 2) {
+      name = "@";
+      return;
+    }
+
+    static const struct {
+      const char* name;
+      SelectType select;
+    } selects[] = {
+      { "local_tag",    SelLocalTag },
+      { "user",         SelUser },
+      { "domain",       SelDomain },
+      { "remote_tag",   SelRemoteTag },
+      { "callid",       SelCallId },
+      { "local_uri",    SelLocalUri },
+      { "local_party",  SelLocalParty },
+      { "remote_uri",   SelRemoteUri },
+      { "remote_party", SelRemoteParty }
+    };
+
+    string s1 = s.substr(1);
+    for (size_t i = 0; i < sizeof(selects)/sizeof(selects[0]); i++) {
+      if (s1 == selects[i].name) {
+	kind = Select;
+	select = selects[i].select;
+	name = s1;
+	return;
+      }
+    }
+    // unknown select: empty
+  } return;
+
+  default:
+    name = trim(s, "\"");
+    return;
+  }
+}
+
+string DSMVarTemplate::resolve(AmSession* sess, DSMSession* sc_sess,
+			       map<string,string>* event_params) const {
+  if (op) {
+    string a = lhs->resolve(sess, sc_sess, event_params);
+    string b = rhs->resolve(sess, sc_sess, event_params);
+    if (isNumber(a) && isNumber(b)) {
+      int res = op == '-' ?
+	atoi(a.c_str()) - atoi(b.c_str()) : atoi(a.c_str()) + atoi(b.c_str());
+      return int2str(res);
+    }
+  }
+
+  switch (kind) {
+  case Literal: return name;
+
+  case Var: {
+    VarMapT::iterator it = sc_sess->findVar(slot, name);
+    if (it != sc_sess->var.end())
+      return it->second;
+    return "";
+  }
+
+  case Param: {
+    if (!event_params)
+      return string();
+    map<string, string>::iterator it = event_params->find(name);
+    if (it != event_params->end())
+      return it->second;
+    return "";
+  }
+
+  case Select:
+    switch (select) {
+    case SelLocalTag:    return sess->getLocalTag();
+    case SelUser:        return sess->dlg->getUser();
+    case SelDomain:      return sess->dlg->getDomain();
+    case SelRemoteTag:   return sess->getRemoteTag();
+    case SelCallId:      return sess->getCallID();
+    case SelLocalUri:    return sess->dlg->getLocalUri();
+    case SelLocalParty:  return sess->dlg->getLocalParty();
+    case SelRemoteUri:   return sess->dlg->getRemoteUri();
+    case SelRemoteParty: return sess->dlg->getRemoteParty();
+    }
+  }
+  return string();
+}
+
+string& DSMVarTemplate::getVar(DSMSession* sc_sess) const {
+  if (kind == Var)
+    return sc_sess->getVar(slot, name);
+  return sc_sess->var[name];
+}
+
 void splitCmd(const string& from_str, 
 			    string& cmd, string& params) {
   size_t b_pos = from_str.find('(');
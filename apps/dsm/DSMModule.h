@@ -37,6 +37,7 @@ class DSMSession;
 using std::string;
 
 #include <typeinfo>
+#include <memory>
 
 // script modules interface
 // factory only: it produces actions and conditions from script statements.
@@ -83,10 +84,66 @@ typedef void* (*SCFactoryCreate)();
 #define SC_EXPORT(class_name)			\
   EXPORT_SC_FACTORY(SC_FACTORY_EXPORT,class_name)
 
+/** @return the slot of a $variable name, the same for every chart */
+unsigned int internVarName(const string& name);
+
+/**
+ * an argument as understood by resolveVars(), parsed once when the
+ * chart is read: a literal, $variable (by slot), #param or @select
+ */
+class DSMVarTemplate {
+ public:
+  enum Kind {
+    Literal,
+    Var,
+    Param,
+    Select
+  };
+
+  enum SelectType {
+    SelLocalTag,
+    SelUser,
+    SelDomain,
+    SelRemoteTag,
+    SelCallId,
+    SelLocalUri,
+    SelLocalParty,
+    SelRemoteUri,
+    SelRemoteParty
+  };
+
+  DSMVarTemplate();
+  DSMVarTemplate(const string& s, bool eval_ops = false);
+
+  string resolve(AmSession* sess, DSMSession* sc_sess,
+		 map<string,string>* event_params) const;
+
+  /** as destination of an assignment ($var or var): the variable */
+  string& getVar(DSMSession* sc_sess) const;
+
+  Kind getKind() const { return kind; }
+  /** literal, or name of the variable/param/select */
+  const string& getName() const { return name; }
+
+ private:
+  Kind kind;
+  string name;
+  unsigned int slot;    // Var
+  SelectType select;    // Select
+
+  // eval_ops: '-' or '+' of two numbers, this one otherwise
+  char op;
+  std::shared_ptr<DSMVarTemplate> lhs;
+  std::shared_ptr<DSMVarTemplate> rhs;
+
+  void parse(const string& s);
+};
+
 class SCStrArgAction   
 : public DSMAction {
  protected:
   string arg;
+  DSMVarTemplate arg_tpl;
  public:
   SCStrArgAction(const string& m_arg); 
 };
@@ -123,6 +180,8 @@ class SCStrArgAction
   : public DSMAction {							\
     string par1;							\
     string par2;							\
+    DSMVarTemplate par1_tpl;						\
+    DSMVarTemplate par2_tpl;						\
   public:								\
     CL_Name(const string& arg);						\
     bool execute(AmSession* sess, DSMSession* sc_sess,			\
@@ -201,6 +260,8 @@ class SCStrArgAction
 #define CONST_ACTION_2P(CL_name, _sep, _optional)			\
   CL_name::CL_name(const string& arg) {					\
     SPLIT_ARGS(_sep, _optional);					\
+    par1_tpl = DSMVarTemplate(par1);					\
+    par2_tpl = DSMVarTemplate(par2);					\
   }
 
 
@@ -34,3 +34,29 @@ DSMSession::DSMSession()
 DSMSession::~DSMSession() {
 }
 
+VarMapT::iterator DSMSession::findVar(unsigned int slot, const string& name) {
+  if (slot >= var_slots.size())
+    var_slots.resize(slot + 1);
+
+  VarSlot& s = var_slots[slot];
+  if (s.generation == var.getGeneration())
+    return s.it;
+
+  VarMapT::iterator it = var.find(name);
+  if (it != var.end()) {
+    s.generation = var.getGeneration();
+    s.it = it;
+  }
+  return it;
+}
+
+string& DSMSession::getVar(unsigned int slot, const string& name) {
+  VarMapT::iterator it = findVar(slot, name);
+  if (it == var.end()) {
+    it = var.insert(VarMapT::value_type(name, string())).first;
+    var_slots[slot].generation = var.getGeneration();
+    var_slots[slot].it = it;
+  }
+  return it->second;
+}
+
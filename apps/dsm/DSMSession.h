@@ -114,6 +114,41 @@ using std::map;
 typedef map<string, string> VarMapT;
 typedef map<string, AmArg>  AVarMapT;
 
+/**
+ * session variables: counts everything that may invalidate
+ * an iterator, so that DSMSession::findVar can cache them
+ */
+class DSMVarMap
+  : public VarMapT {
+  unsigned int generation;
+
+ public:
+  DSMVarMap() : generation(1) { }
+  DSMVarMap(const DSMVarMap& m) : VarMapT(m), generation(1) { }
+
+  DSMVarMap& operator=(const VarMapT& m) {
+    VarMapT::operator=(m); generation++; return *this;
+  }
+  DSMVarMap& operator=(const DSMVarMap& m) {
+    VarMapT::operator=(m); generation++; return *this;
+  }
+
+  iterator erase(iterator it) {
+    generation++; return VarMapT::erase(it);
+  }
+  size_type erase(const string& key) {
+    generation++; return VarMapT::erase(key);
+  }
+  iterator erase(iterator first, iterator last) {
+    generation++; return VarMapT::erase(first, last);
+  }
+  void clear() {
+    generation++; VarMapT::clear();
+  }
+
+  unsigned int getGeneration() const { return generation; }
+};
+
 class DSMDisposable;
 struct AmPlaylistItem;
 
@@ -176,7 +211,15 @@ class DSMSession {
   virtual void releaseOwnership(DSMDisposable* d) = 0;
 
   /* holds variables which are accessed by $varname */
-  VarMapT var;
+  DSMVarMap var;
+
+  /**
+   * variable by slot of its interned name (see DSMVarTemplate)
+   * @return var.end() if not set
+   */
+  VarMapT::iterator findVar(unsigned int slot, const string& name);
+  /** variable by slot of its interned name, created if not set */
+  string& getVar(unsigned int slot, const string& name);
 
   /* holds AmArg variables. todo(?): merge var with these */
   AVarMapT avar;
@@ -186,6 +229,14 @@ class DSMSession {
 
   /* last received request */
   std::unique_ptr<AmSipRequest> last_req;
+
+ private:
+  struct VarSlot {
+    unsigned int generation; // of var when it was cached
+    VarMapT::iterator it;
+    VarSlot() : generation(0) { }
+  };
+  vector<VarSlot> var_slots;
 };
 
 class DSMStateDiagramCollection;
@@ -27,13 +27,16 @@
 #include "DSMStateDiagramCollection.h"
 
 #include "DSMChartReader.h"
+#include "DSMChartCache.h"
 #include <fstream>
 using std::ifstream;
 
 #include <cerrno>
 #include <dirent.h>
+#include <sys/time.h>
 
-DSMStateDiagramCollection::DSMStateDiagramCollection() {
+DSMStateDiagramCollection::DSMStateDiagramCollection()
+  : ref_cnt(1) {
 }
 
 DSMStateDiagramCollection::~DSMStateDiagramCollection() {
@@ -140,6 +143,9 @@ bool DSMStateDiagramCollection::loadFile(const string& filename, const string& n
 					 const string& load_path,
 					 const string& mod_path, bool debug_dsm, bool check_dsm) {
 
+  struct timeval start, end;
+  gettimeofday(&start, NULL);
+
   string s;
   if (!readFile(filename, name, load_path, s))
     return false;
@@ -148,12 +154,36 @@ bool DSMStateDiagramCollection::loadFile(const string& filename, const string& n
     DBG("dsm text\n------------------\n%s\n------------------\n", s.c_str());
   }
 
-  diags.push_back(DSMStateDiagram(name));
+  DiagSource src;
+  src.filename = filename;
+  src.name = name;
+  src.load_path = load_path;
+  src.mod_path = mod_path;
+  sources.push_back(src);
+
+  vector<DSMChartToken> tokens;
+  bool cached = false;
+  DSMChartCache cache(cache_path, s);
+  if (!cache_path.empty())
+    cached = cache.read(tokens);
   DSMChartReader cr;
-  if (!cr.decode(&diags.back(), s, mod_path, this, mods)) {
+  if (!cached)
+    cr.tokenize(s, tokens);
+
+  diags.push_back(DSMStateDiagram(name));
+  if (!cr.decode(&diags.back(), tokens, mod_path, this, mods)) {
     ERROR("DonkeySM decode script error!\n");
     return false;
   }
+  diags.back().compile();
+
+  if (!cache_path.empty() && !cached)
+    cache.write(tokens, cr.getModuleFiles());
+
+  gettimeofday(&end, NULL);
+  DBG("loaded DSM '%s' in %ld us%s\n", name.c_str(),
+      (long)((end.tv_sec - start.tv_sec) * 1000000 + (end.tv_usec - start.tv_usec)),
+      cached ? " (compiled chart from cache)" : "");
   if (check_dsm) {
     string report;
     if (!diags.back().checkConsistency(report)) {
@@ -170,6 +200,17 @@ bool DSMStateDiagramCollection::loadFile(const string& filename, const string& n
   return true;
 }
 
+bool DSMStateDiagramCollection::loadFilesOf(DSMStateDiagramCollection* other,
+					    bool debug_dsm, bool check_dsm) {
+  for (vector<DiagSource>::iterator it=
+	 other->sources.begin(); it != other->sources.end(); it++) {
+    if (!loadFile(it->filename, it->name, it->load_path, it->mod_path,
+		  debug_dsm, check_dsm))
+      return false;
+  }
+  return true;
+}
+
 bool DSMStateDiagramCollection::hasDiagram(const string& name) {
   for (vector<DSMStateDiagram>::iterator it=
 	 diags.begin(); it != diags.end(); it++) 
@@ -194,4 +235,16 @@ void DSMStateDiagramCollection::addToEngine(DSMStateEngine* e) {
     e->addDiagram(&(*it));
   
   e->addModules(mods);
+  e->addCollection(this);
+}
+
+void DSMStateDiagramCollection::addRef() {
+  __sync_add_and_fetch(&ref_cnt, 1);
+}
+
+void DSMStateDiagramCollection::release() {
+  if (!__sync_sub_and_fetch(&ref_cnt, 1)) {
+    DBG("deleting unused DSM diagrams (%zd)\n", diags.size());
+    delete this;
+  }
 }
@@ -33,24 +33,55 @@
 using std::string;
 class DSMModule;
 
+/**
+ * the diagrams of a configuration
+ *
+ * Not changed once sessions use it: reloading builds a new collection,
+ * which replaces this one. Engines using it hold a reference, so it is
+ * deleted when the last of them and its owner (DSMFactory) let go.
+ */
 class DSMStateDiagramCollection  
 : public DSMElemContainer
 {
   vector<DSMStateDiagram> diags;
   vector<DSMModule*> mods;
 
+  /** where a diagram was loaded from */
+  struct DiagSource {
+    string filename;
+    string name;
+    string load_path;
+    string mod_path;
+  };
+  vector<DiagSource> sources;
+
+  /** compiled charts, empty for none */
+  string cache_path;
+
+  unsigned int ref_cnt;
+
  public: 
   DSMStateDiagramCollection();
   ~DSMStateDiagramCollection();
 
+  void setCachePath(const string& path) { cache_path = path; }
+
   bool readFile(const string& filename, const string& name, 
 		const string& load_path, string& s);
   bool loadFile(const string& filename, const string& name, 
 		const string& load_path,
 		const string& mod_path, bool debug_dsm, bool check_dsm);
+  /** load the diagrams of other again, e.g. to add one to a copy */
+  bool loadFilesOf(DSMStateDiagramCollection* other,
+		   bool debug_dsm, bool check_dsm);
   void addToEngine(DSMStateEngine* e);
   bool hasDiagram(const string& name);
   vector<string> getDiagramNames();
+
+  /** the creator holds the first reference */
+  void addRef();
+  /** deletes the collection with the last reference */
+  void release();
 };
 
 #endif
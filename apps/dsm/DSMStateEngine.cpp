@@ -27,6 +27,7 @@
 
 #include "DSMStateEngine.h"
 #include "DSMModule.h"
+#include "DSMStateDiagramCollection.h"
 
 #include "AmUtils.h"
 #include "AmSession.h"
@@ -111,7 +112,7 @@ const char* DSMCondition::type2str(EventType event) {
 }
 
 DSMStateDiagram::DSMStateDiagram(const string& name) 
-  : name(name) {
+  : name(name), initial_state_idx(-1) {
 }
 
 DSMStateDiagram::~DSMStateDiagram() {
@@ -186,6 +187,7 @@ bool DSMStateDiagram::addTransition(const DSMTransition& trans) {
     }
     
     source_st->transitions.push_back(trans);
+    source_st->trans_index.clear(); // until compiled again
   }
 
   return true;
@@ -203,6 +205,9 @@ State* DSMStateDiagram::getState(const string& s_name) {
 }
 
 State* DSMStateDiagram::getInitialState() {
+  if (initial_state_idx >= 0)
+    return &states[initial_state_idx];
+
   if (initial_state.empty()) {
     ERROR("diag '%s' doesn't have an initial state!\n",
 	  name.c_str());
@@ -211,6 +216,62 @@ State* DSMStateDiagram::getInitialState() {
   return getState(initial_state);
 }
 
+State* DSMStateDiagram::getTargetState(const DSMTransition& trans) {
+  if (trans.to_state_idx >= 0)
+    return &states[trans.to_state_idx];
+  return getState(trans.to_state);
+}
+
+static int findStateIndex(const vector<State>& states, const string& s_name) {
+  for (size_t i = 0; i < states.size(); i++) {
+    if (states[i].name == s_name)
+      return i;
+  }
+  return -1;
+}
+
+/** whether the preconditions of trans can hold for an event of a type */
+static bool mayMatch(const DSMTransition& trans, DSMCondition::EventType event) {
+  for (vector<DSMCondition*>::const_iterator it =
+	 trans.precond.begin(); it != trans.precond.end(); it++) {
+    // an inverted condition holds for all other events
+    if (!(*it)->invert && (*it)->type != DSMCondition::Any &&
+	(*it)->type != event)
+      return false;
+  }
+  return true;
+}
+
+void DSMStateDiagram::compile() {
+  DBG("compiling '%s'\n", name.c_str());
+  initial_state_idx = initial_state.empty() ? -1 :
+    findStateIndex(states, initial_state);
+
+  for (vector<State>::iterator it=
+	 states.begin(); it != states.end(); it++) {
+    for (vector<DSMTransition>::iterator t_it=
+	   it->transitions.begin(); t_it != it->transitions.end(); t_it++)
+      t_it->to_state_idx = findStateIndex(states, t_it->to_state);
+
+    it->trans_index.assign(2 * DSMCondition::EventTypeCount,
+			   vector<unsigned int>());
+    for (int e = 0; e < DSMCondition::EventTypeCount; e++) {
+      for (unsigned int t = 0; t < it->transitions.size(); t++) {
+	const DSMTransition& trans = it->transitions[t];
+	if (mayMatch(trans, (DSMCondition::EventType)e))
+	  it->trans_index[2 * e + trans.is_exception].push_back(t);
+      }
+    }
+  }
+}
+
+const vector<unsigned int>* State::getTransitions(DSMCondition::EventType event,
+						  bool is_exception) const {
+  if (trans_index.empty() || event < 0 || event >= DSMCondition::EventTypeCount)
+    return NULL;
+  return &trans_index[2 * event + is_exception];
+}
+
 
 bool DSMStateDiagram::checkConsistency(string& report) {
   bool res = true;
@@ -281,6 +342,9 @@ DSMStateEngine::DSMStateEngine()
 }
 
 DSMStateEngine::~DSMStateEngine() {
+  for (vector<DSMStateDiagramCollection*>::iterator it=
+	 collections.begin(); it != collections.end(); it++)
+    (*it)->release();
 }
 
 bool DSMStateEngine::onInvite(const AmSipRequest& req, DSMSession* sess) {
@@ -549,6 +613,11 @@ void DSMStateEngine::addModules(vector<DSMModule*> modules) {
     mods.push_back(*it);
 }
 
+void DSMStateEngine::addCollection(DSMStateDiagramCollection* collection) {
+  collection->addRef();
+  collections.push_back(collection);
+}
+
 bool DSMStateEngine::init(AmSession* sess, DSMSession* sc_sess,
 			  const string& startDiagram,
 			  DSMCondition::EventType init_event) {
@@ -622,8 +691,14 @@ void DSMStateEngine::runEvent(AmSession* sess, DSMSession* sc_sess,
 
 
       DBG(" > state '%s'\n", current->name.c_str());
-      for (vector<DSMTransition>::iterator tr = current->transitions.begin();
-	   tr != current->transitions.end();tr++) {
+      // only those which may match, if the chart is compiled
+      const vector<unsigned int>* candidates =
+	current->getTransitions(active_event, is_exception);
+      size_t n_candidates = candidates ?
+	candidates->size() : current->transitions.size();
+
+      for (size_t i = 0; i < n_candidates; i++) {
+	DSMTransition* tr = &current->transitions[candidates ? (*candidates)[i] : i];
 	if (tr->is_exception != is_exception)
 	  continue;
 	
@@ -640,7 +715,7 @@ void DSMStateEngine::runEvent(AmSession* sess, DSMSession* sc_sess,
 	  
 	  //  matched all preconditions
 	  // find target state
-	  State* target_st = current_diag->getState(tr->to_state);
+	  State* target_st = current_diag->getTargetState(*tr);
 	  if (!target_st) {
 	    ERROR("script writer error: transition '%s' from "
 		  "state '%s' to unknown state '%s'\n",
@@ -833,7 +908,7 @@ State::~State() {
 }
 
 DSMTransition::DSMTransition()
-  : is_exception(false)
+  : to_state_idx(-1), is_exception(false)
 {
 }
 
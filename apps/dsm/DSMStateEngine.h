@@ -34,6 +34,7 @@
 
 class AmSession;
 class DSMSession;
+class DSMStateDiagramCollection;
 
 #include <map>
 using std::map;
@@ -121,21 +122,27 @@ class DSMCondition
     RelayOnSipRequest,
     RelayOnSipReply,
     RelayOnB2BRequest,
-    RelayOnB2BReply
+    RelayOnB2BReply,
 
 #ifdef WITH_ZRTP
-    , ZRTPProtocolEvent,
-    ZRTPSecurityEvent
+    ZRTPProtocolEvent,
+    ZRTPSecurityEvent,
 #endif
+
+    EventTypeCount // not an event: number of event types
   };
 
   static const char* type2str(EventType event);
 
   bool invert; 
   
-  DSMCondition() : invert(false) { }
+  DSMCondition() : invert(false), type(Any) { }
   virtual ~DSMCondition() { }
 
+  /**
+   * a condition never matches events of another type, unless this
+   * is Any (transitions are indexed by it, see DSMStateDiagram::compile)
+   */
   EventType type;
   map<string, string> params;
 
@@ -185,6 +192,18 @@ class State
   vector<DSMElement*> post_actions;
   
   vector<DSMTransition> transitions;
+
+  /**
+   * transitions (indexes, in chart order) which may match an event,
+   * by is_exception and event type; built by DSMStateDiagram::compile
+   * @return NULL if not compiled
+   */
+  const vector<unsigned int>* getTransitions(DSMCondition::EventType event,
+					     bool is_exception) const;
+
+ private:
+  friend class DSMStateDiagram;
+  vector<vector<unsigned int> > trans_index;
 };
 
 class DSMTransition
@@ -197,6 +216,8 @@ class DSMTransition
   vector<DSMElement*> actions;
   string from_state;
   string to_state;
+  /** index of to_state in its diagram, -1 if not resolved */
+  int to_state_idx;
 
   bool is_exception;
 };
@@ -241,6 +262,7 @@ class DSMStateDiagram  {
   vector<State> states;
   string name;
   string initial_state;
+  int initial_state_idx;
 
   bool checkInitialState(string& report);
   bool checkDestinationStates(string& report);
@@ -252,11 +274,19 @@ class DSMStateDiagram  {
 
   State* getInitialState();
   State* getState(const string& s_name);
+  /** target of a transition of one of our states */
+  State* getTargetState(const DSMTransition& trans);
 
   void addState(const State& state, bool is_initial = false);
   bool addTransition(const DSMTransition& trans);
   const string& getName() { return name; }
   bool checkConsistency(string& report);
+
+  /**
+   * resolve state names and index the transitions of every state by
+   * event type; done after the chart has been read completely
+   */
+  void compile();
 };
 
 class DSMException {
@@ -320,12 +350,16 @@ class DSMStateEngine {
 
   vector<DSMModule*> mods;
 
+  /** where diags are from, referenced while we run */
+  vector<DSMStateDiagramCollection*> collections;
+
  public: 
   DSMStateEngine();
   ~DSMStateEngine();
 
   void addDiagram(DSMStateDiagram* diag); 
   void addModules(vector<DSMModule*> modules);
+  void addCollection(DSMStateDiagramCollection* collection);
 
   bool init(AmSession* sess, DSMSession* sc_sess,
 	    const string& startDiagram,
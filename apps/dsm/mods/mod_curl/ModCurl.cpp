@@ -30,6 +30,8 @@
 
 #include "DSMSession.h"
 #include "AmSession.h"
+#include "AmEventDispatcher.h"
+#include "ampi/HttpClientAPI.h"
 
 #include <curl/curl.h> 
 #include <sstream>
@@ -75,6 +77,8 @@ DSMAction* CurlModule::getAction(const string& from_str) {
   DEF_CMD("curl.getForm", SCJCurlGetFormAction);
   DEF_CMD("curl.post", SCJCurlPOSTGetResultAction);
   DEF_CMD("curl.postDiscardResult", SCJCurlPOSTAction);
+  DEF_CMD("curl.getAsync", SCJCurlGetAsyncAction);
+  DEF_CMD("curl.postAsync", SCJCurlPOSTAsyncAction);
 
   return NULL;
 }
@@ -467,3 +471,61 @@ EXEC_ACTION_START(SCJCurlPOSTGetResultAction) {
 		par2, true);
   return false;
 } EXEC_ACTION_END;
+
+/** hand a request to the http_client module; sets $curl.request_id */
+bool curl_post_request(AmSession* sess, DSMSession* sc_sess,
+		       HttpRequestEvent::Method method, const string& url,
+		       const string& body) {
+  static unsigned int request_seq = 0;
+
+  unsigned int timeout_ms = 0;
+  if (!sc_sess->var["curl.timeout"].empty())  {
+    unsigned int curl_timeout = 0;
+    if (str2i(sc_sess->var["curl.timeout"], curl_timeout)) {
+      WARN("curl.timeout '%s' not understood\n", sc_sess->var["curl.timeout"].c_str());
+    } else {
+      timeout_ms = curl_timeout * 1000;
+    }
+  }
+
+  string request_id = int2str(__sync_add_and_fetch(&request_seq, 1));
+  HttpRequestEvent* req =
+    new HttpRequestEvent(method, url, sess->getLocalTag(), request_id, timeout_ms);
+  if (method == HttpRequestEvent::Post) {
+    req->body = body;
+    req->content_type = "application/x-www-form-urlencoded";
+  }
+
+  if (!AmEventDispatcher::instance()->post(HTTP_CLIENT_QUEUE, req)) {
+    ERROR("posting request for '%s': http_client module not loaded?\n", url.c_str());
+    delete req;
+    sc_sess->SET_ERRNO(DSM_ERRNO_GENERAL);
+    sc_sess->SET_STRERROR("http_client module not loaded");
+    return false;
+  }
+
+  sc_sess->var["curl.request_id"] = request_id;
+  sc_sess->CLR_ERRNO;
+  return true;
+}
+
+EXEC_ACTION_START(SCJCurlGetAsyncAction) {
+  curl_post_request(sess, sc_sess, HttpRequestEvent::Get,
+		    resolveVars(arg, sess, sc_sess, event_params), "");
+} EXEC_ACTION_END;
+
+CONST_ACTION_2P(SCJCurlPOSTAsyncAction, ',', true);
+EXEC_ACTION_START(SCJCurlPOSTAsyncAction) {
+  string body;
+  vector<string> p_vars=explode(par2, ";");
+  for (vector<string>::iterator it=
+	 p_vars.begin();it != p_vars.end();it++) {
+    string varname = (it->size() && ((*it)[0]=='$')) ? (it->substr(1)) : (*it);
+    if (!body.empty())
+      body += "&";
+    body += URL_encode(varname) + "=" + URL_encode(sc_sess->var[varname]);
+  }
+
+  curl_post_request(sess, sc_sess, HttpRequestEvent::Post,
+		    resolveVars(par1, sess, sc_sess, event_params), body);
+} EXEC_ACTION_END;
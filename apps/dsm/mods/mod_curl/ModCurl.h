@@ -48,5 +48,7 @@ DEF_ACTION_2P(SCJCurlGetFileAction);
 DEF_ACTION_2P(SCJCurlGetFormAction);
 DEF_ACTION_2P(SCJCurlPOSTAction);
 DEF_ACTION_2P(SCJCurlPOSTGetResultAction);
+DEF_ACTION_1P(SCJCurlGetAsyncAction);
+DEF_ACTION_2P(SCJCurlPOSTAsyncAction);
 
 #endif
@@ -32,6 +32,7 @@
 #include "DSMSession.h"
 #include "AmSession.h"
 #include "AmPlaylist.h"
+#include "AmConfigReader.h"
 
 #include <stdio.h>
 #include <fstream>
@@ -39,10 +40,29 @@
 
 SC_EXPORT(SCMysqlModule);
 
-SCMysqlModule::SCMysqlModule() {
+SCMysqlModule::SCMysqlModule()
+  : pool_owner(false) {
 }
 
 SCMysqlModule::~SCMysqlModule() {
+  // preloaded modules are deleted at server shutdown
+  if (pool_owner)
+    MyConnectionPool::dispose();
+}
+
+int SCMysqlModule::preload() {
+  AmConfigReader cfg;
+  if (cfg.loadPluginConf(MOD_NAME)) {
+    INFO("no module configuration for '%s' found, no connection pool\n",
+	 MOD_NAME);
+    return 0;
+  }
+  if (NULL != MyConnectionPool::instance())
+    return 0;
+
+  int res = MyConnectionPool::create(cfg);
+  pool_owner = NULL != MyConnectionPool::instance();
+  return res;
 }
 
 
@@ -67,6 +87,9 @@ DSMAction* SCMysqlModule::getAction(const string& from_str) {
   DEF_CMD("mysql.getFileFromDB",      SCMyGetFileFromDBAction);
   DEF_CMD("mysql.putFileToDB",        SCMyPutFileToDBAction);
   DEF_CMD("mysql.escape",             SCMyEscapeAction);
+  DEF_CMD("mysql.queryAsync",         SCMyQueryAsyncAction);
+  DEF_CMD("mysql.getAsyncResult",     SCMyGetAsyncResultAction);
+  DEF_CMD("mysql.getPoolStats",       SCMyGetPoolStatsAction);
   return NULL;
 }
 
@@ -178,16 +201,83 @@ string replaceQueryParams(const string& q, DSMSession* sc_sess,
   return res;
 }
 
-string str_between(const string s, char b, char e) {
-  size_t pos1 = s.find(b);
-  if (b == '\0' || pos1 == string::npos)
-    pos1 = 0;
-  else
-    pos1++;
-  size_t pos2 = s.find(e, pos1);
-  if (e == '\0' || pos2 == string::npos)
-    pos2 = s.length();
-  return s.substr(pos1, pos2-pos1);
+/** escape s for a quoted literal, like mysql_real_escape_string */
+static string escapeLiteral(const string& s) {
+  string res;
+  for (size_t i=0; i<s.length(); i++) {
+    switch (s[i]) {
+    case '\0':   res += "\\0"; break;
+    case '\n':   res += "\\n"; break;
+    case '\r':   res += "\\r"; break;
+    case '\032': res += "\\Z"; break;
+    case '\\': case '\'': case '"':
+      res += '\\'; res += s[i]; break;
+    default: res += s[i];
+    }
+  }
+  return res;
+}
+
+/**
+ * like replaceQueryParams, but $vars and #params become ? placeholders
+ * with their values in values; a quoted '$var' is one placeholder.
+ * Inside other literals ('%$var%') the values are escaped and replaced.
+ */
+string bindQueryParams(const string& q, DSMSession* sc_sess,
+		       map<string,string>* event_params, vector<string>& values) {
+  string res;
+  char quote = '\0';
+  size_t lit_start = 0; // of the current literal in res
+  size_t pos = 0;
+  while (pos<q.length()) {
+    char c = q[pos];
+    if (quote && (c == '\\' || // escaped in literal
+		  (c == quote && pos+1 < q.length() && q[pos+1] == quote))) {
+      res += q.substr(pos, 2);
+      pos += 2;
+      continue;
+    }
+    if (c == '\'' || c == '"') {
+      if (!quote) {
+	quote = c;
+	lit_start = res.length();
+      } else if (c == quote)
+	quote = '\0';
+      res += c;
+      pos++;
+      continue;
+    }
+    if ((c != '$' && c != '#') ||
+	(pos && q[pos-1] == '\\') || // escaped
+	(c == '#' && NULL == event_params)) {
+      res += c;
+      pos++;
+      continue;
+    }
+
+    size_t rend = q.find_first_of(" ,()$#\t;'\"", pos+1);
+    if (rend==string::npos)
+      rend = q.length();
+    string name = q.substr(pos+1, rend-pos-1);
+    const string& value = c == '$' ? sc_sess->var[name] : (*event_params)[name];
+
+    if (quote && lit_start == res.length()-1 &&
+	rend < q.length() && q[rend] == quote) {
+      // the whole literal
+      res[res.length()-1] = '?';
+      values.push_back(value);
+      quote = '\0';
+      pos = rend+1;
+    } else if (quote) {
+      res += escapeLiteral(value);
+      pos = rend;
+    } else {
+      res += "?";
+      values.push_back(value);
+      pos = rend;
+    }
+  }
+  return res;
 }
 
 EXEC_ACTION_START(SCMyConnectAction) {
@@ -199,44 +289,26 @@ EXEC_ACTION_START(SCMyConnectAction) {
     sc_sess->SET_STRERROR("missing correct db_url config or connect parameter\n");
     return false;
   }
-  // split url
-  db_url = db_url.substr(8); 
-  string db_user = str_between(db_url, '\0', ':');
-  string db_pwd  = str_between(db_url,  ':', '@');
-  string db_host = str_between(db_url,  '@', '/');
-  string db_db   = str_between(db_url,  '/', '\0');
+  MyConnectParams conn_params;
+  conn_params.parseUrl(db_url);
 
-  string db_ca_cert = sc_sess->var["config.mysql_ca_cert"];
-  if (!db_ca_cert.empty() && (access(db_ca_cert.c_str(), R_OK ) != 0)) {
-    ERROR("cannot access mysql_ca_cert file %s\n", db_ca_cert.c_str());
+  conn_params.ca_cert = sc_sess->var["config.mysql_ca_cert"];
+  if (!conn_params.ca_cert.empty() &&
+      (access(conn_params.ca_cert.c_str(), R_OK ) != 0)) {
+    ERROR("cannot access mysql_ca_cert file %s\n", conn_params.ca_cert.c_str());
     sc_sess->SET_ERRNO(DSM_ERRNO_CONFIG);
     sc_sess->SET_STRERROR("cannot access mysql_ca_cert file\n");
     return false;
   }
 
   try {
-    bool reconnect_state = true;
-    sql::ConnectOptionsMap connection_properties;
-    sql::Driver *driver;
-    DSMMyConnection* conn = NULL;
-    connection_properties["hostName"] = sql::ConnectPropertyVal(db_host);
-    connection_properties["userName"] = sql::ConnectPropertyVal(db_user);
-    connection_properties["password"] = sql::ConnectPropertyVal(db_pwd);
-    if (!db_ca_cert.empty()) {
-      connection_properties["sslCa"] =
-	sql::ConnectPropertyVal(sql::SQLString(db_ca_cert));
-      connection_properties["sslCAPath"] =
-	sql::ConnectPropertyVal(sql::SQLString(""));
-      connection_properties["sslCipher"] =
-	sql::ConnectPropertyVal(sql::SQLString("DHE-RSA-AES256-SHA"));
-      connection_properties["sslEnforce"] =
-	sql::ConnectPropertyVal(true);
+    DSMMyConnection* conn = new DSMMyConnection();
+    try {
+      conn->con = myConnect(conn_params, true);
+    } catch (...) {
+      delete conn;
+      throw;
     }
-    driver = get_driver_instance();
-    conn = new DSMMyConnection();
-    conn->con = driver->connect(connection_properties);
-    conn->con->setClientOption("OPT_RECONNECT", &reconnect_state);
-    conn->con->setSchema(db_db);
     // save connection for later use
     AmArg c_arg_con;
     c_arg_con.setBorrowedPointer(conn);
@@ -278,25 +350,6 @@ EXEC_ACTION_START(SCMyResolveQueryParams) {
     replaceQueryParams(arg, sc_sess, event_params);
 } EXEC_ACTION_END;
 
-unsigned long getInsertId(sql::Connection* conn) {
-  try {
-    sql::Statement* stmt = conn->createStatement();
-    sql::ResultSet* res = stmt->executeQuery("SELECT @@identity AS id");
-    unsigned long retVal = 0;
-    if (res->next()) {
-      retVal = res->getInt64("id");
-    } else {
-      ERROR("DB query 'SELECT @@identity AS id' gave no result'\n");
-    }
-    delete stmt;
-    delete res;
-    return retVal;
-  } catch (const sql::SQLException& e) {
-    ERROR("DB query 'SELECT @@identity AS id' failed: '%s'\n", e.what());
-    return 0;
-  }
-}
-
 EXEC_ACTION_START(SCMyExecuteAction) {
   sql::Connection* conn = getMyDSMSessionConnection(sc_sess);
   if (NULL == conn) 
@@ -737,3 +790,80 @@ EXEC_ACTION_START(SCMyEscapeAction) {
   DBG("escaped: $%s = escape(%s) = %s\n",
       dstvar.c_str(), val.c_str(), res.c_str());
 } EXEC_ACTION_END;
+
+EXEC_ACTION_START(SCMyQueryAsyncAction) {
+  MyConnectionPool* pool = MyConnectionPool::instance();
+  if (NULL == pool) {
+    ERROR("mysql.queryAsync needs mod_mysql preloaded with a db_url\n");
+    sc_sess->SET_ERRNO(DSM_ERRNO_MY_CONNECTION);
+    sc_sess->SET_STRERROR("no connection pool (preload mod_mysql)");
+    return false;
+  }
+
+  MyQueryJob* job = new MyQueryJob();
+  job->sess_id = sess->getLocalTag();
+  job->query_id = int2str(pool->nextQueryId());
+  job->sql = bindQueryParams(arg, sc_sess, event_params, job->params);
+
+  string query_id = job->query_id;
+  DBG("mysql.queryAsync %s '%s'\n", query_id.c_str(), job->sql.c_str());
+  if (!pool->submit(job)) {
+    ERROR("mysql.queryAsync: too many queued queries\n");
+    sc_sess->SET_ERRNO(DSM_ERRNO_MY_QUERY);
+    sc_sess->SET_STRERROR("too many queued queries");
+    return false;
+  }
+
+  sc_sess->var["db.query_id"] = query_id;
+  sc_sess->CLR_ERRNO;
+} EXEC_ACTION_END;
+
+EXEC_ACTION_START(SCMyGetAsyncResultAction) {
+  if (NULL == event_params || (*event_params)["type"] != "mysql.result") {
+    sc_sess->SET_ERRNO(DSM_ERRNO_MY_NORESULT);
+    sc_sess->SET_STRERROR("not in a mysql.result event");
+    return false;
+  }
+
+  unsigned int rowindex_i = 0;
+  string rowindex = resolveVars(arg, sess, sc_sess, event_params);
+  if (rowindex.length() && str2i(rowindex, rowindex_i)) {
+    ERROR("row index '%s' not understood\n", rowindex.c_str());
+    sc_sess->SET_ERRNO(DSM_ERRNO_UNKNOWN_ARG);
+    sc_sess->SET_STRERROR("row index '"+rowindex+"' not understood");
+    return false;
+  }
+
+  unsigned int rows = 0;
+  str2i((*event_params)["db.rows"], rows);
+  // only the first max_result_rows rows are in the event
+  string prefix = int2str(rowindex_i) + ".";
+  map<string,string>::iterator it = event_params->lower_bound(prefix);
+  if (rowindex_i >= rows || it == event_params->end() ||
+      it->first.compare(0, prefix.length(), prefix)) {
+    sc_sess->SET_ERRNO(DSM_ERRNO_MY_NOROW);
+    sc_sess->SET_STRERROR("row index out of result rows bounds");
+    return false;
+  }
+
+  for (; it != event_params->end() &&
+	 !it->first.compare(0, prefix.length(), prefix); it++) {
+    sc_sess->var[it->first.substr(prefix.length())] = it->second;
+  }
+  sc_sess->CLR_ERRNO;
+} EXEC_ACTION_END;
+
+EXEC_ACTION_START(SCMyGetPoolStatsAction) {
+  MyConnectionPool* pool = MyConnectionPool::instance();
+  if (NULL == pool) {
+    sc_sess->SET_ERRNO(DSM_ERRNO_MY_CONNECTION);
+    sc_sess->SET_STRERROR("no connection pool (preload mod_mysql)");
+    return false;
+  }
+
+  map<string, string> stats;
+  pool->getStats(stats);
+  for (map<string, string>::iterator it = stats.begin(); it != stats.end(); it++)
+    sc_sess->var["db.pool."+it->first] = it->second;
+  sc_sess->CLR_ERRNO;
+} EXEC_ACTION_END;
@@ -36,6 +36,8 @@
 #include <cppconn/statement.h>
 #include <mysql_connection.h>
 
+#include "MyConnectionPool.h"
+
 #define MY_AKEY_DRIVER     "db.dri"
 #define MY_AKEY_CONNECTION "db.con"
 #define MY_AKEY_RESULT     "db.res"
@@ -51,12 +53,16 @@
 class SCMysqlModule 
 : public DSMModule {
 
+  /** the connection pool was started by this (preloaded) instance */
+  bool pool_owner;
+
  public:
   SCMysqlModule();
   ~SCMysqlModule();
   
   DSMAction* getAction(const string& from_str);
   DSMCondition* getCondition(const string& from_str);
+  int preload();
 
 };
 
@@ -109,5 +115,8 @@ DEF_ACTION_2P(SCMyPlayDBAudioLoopedAction);
 DEF_ACTION_2P(SCMyGetFileFromDBAction);
 DEF_ACTION_2P(SCMyPutFileToDBAction);
 DEF_ACTION_2P(SCMyEscapeAction);
+DEF_ACTION_1P(SCMyQueryAsyncAction);
+DEF_ACTION_1P(SCMyGetAsyncResultAction);
+DEF_ACTION_1P(SCMyGetPoolStatsAction);
 
 #endif
@@ -7,9 +7,12 @@
 #include "AmUtils.h"
 #include "AmArg.h"
 
-#include "XmlRpc.h"
-#include "XmlRpcClient.h"
-using namespace XmlRpc;
+#include "TOXmlRpcClient.h"
+
+#define ACC_SERVER_ADDRESS "localhost"
+#define ACC_SERVER_PORT    8000
+// seconds
+#define ACC_SERVER_TIMEOUT 5.0
 
 
 class CCAccFactory : public AmDynInvokeFactory
@@ -62,39 +65,39 @@ void CCAcc::invoke(const string& method, const AmArg& args, AmArg& ret)
 	throw AmDynInvoke::NotImplemented(method);
 }
 
-/* accounting functions... */;
+/* accounting functions... */
+static bool accExecute(const char* method, const AmArg& params, int& res) {
+   TOXmlRpcClient xmlrpccall(ACC_SERVER_ADDRESS, ACC_SERVER_PORT);
+   AmArg result;
+   if (!xmlrpccall.execute(method, params, result, ACC_SERVER_TIMEOUT) ||
+       xmlrpccall.isFault() || !isArgInt(result)) {
+     ERROR("XMLRPC %s failed\n", method);
+     return false;
+   }
+   res = result.asInt();
+   return true;
+}
+
 int CCAcc::getCredit(string pin) {	
-   const char* serverAddress;
-   int port;
-   serverAddress = "localhost";
-   const char* uri = 0;
-   port = 8000;
-   XmlRpcClient xmlrpccall(serverAddress, port, uri, false);
-   XmlRpcValue noArgs, result;
-   XmlRpcValue xmlArg;
-   xmlArg[0] = pin;
-   xmlrpccall.execute("getCredit", xmlArg, result);
-   int res = result;
-   DBG("Credit Left '%u' .\n", res);
+   AmArg xmlArg;
+   xmlArg.push(pin);
+   int res = -1;
+   accExecute("getCredit", xmlArg, res);
+   DBG("Credit Left '%d' .\n", res);
    return res;
 }
 
 int CCAcc::subtractCredit(string pin, int amount) {
-   const char* serverAddress;
-   int port;
-   serverAddress = "localhost";
-   const char* uri = 0;
-   port = 8000;
-   XmlRpcClient xmlrpccall(serverAddress, port, uri, false);
-   XmlRpcValue noArgs, result;
-   XmlRpcValue xmlArg;
-   xmlArg[0][0]["methodName"] = "subtractCredit";
-   xmlArg[0][0]["pin"] = pin;
-   xmlArg[0][0]["amount"] = amount;	
-   DBG("subtractCredit pin# '%s', Seconds '%u'.\n", pin.c_str(),  
-amount );
-   xmlrpccall.execute("subtractCredit", xmlArg, result);
-   int res = result;
-   DBG("Credit Left '%u' .\n", res);
+   AmArg req;
+   req["methodName"] = "subtractCredit";
+   req["pin"] = pin;
+   req["amount"] = amount;
+   AmArg xmlArg;
+   xmlArg.push(AmArg());
+   xmlArg.get(0).push(req);
+   DBG("subtractCredit pin# '%s', Seconds '%u'.\n", pin.c_str(), amount);
+   int res = -1;
+   accExecute("subtractCredit", xmlArg, res);
+   DBG("Credit Left '%d' .\n", res);
    return res;
 }
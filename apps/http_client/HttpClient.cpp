@@ -0,0 +1,427 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "HttpClient.h"
+
+#include "log.h"
+#include "AmUtils.h"
+#include "AmPlugIn.h"
+#include "AmConfigReader.h"
+#include "AmEventDispatcher.h"
+#include "AmSessionContainer.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#define MOD_NAME "http_client"
+
+/** longest sleep in curl_multi_wait, to look for shutdown */
+#define HTTP_CLIENT_MAX_WAIT_MS 1000
+
+HttpClient* HttpClient::_instance = NULL;
+
+HttpClient* HttpClient::instance()
+{
+  if(_instance == NULL){
+    _instance = new HttpClient(MOD_NAME);
+  }
+  return _instance;
+}
+
+HttpClient::HttpClient(const string& name)
+  : AmDynInvokeFactory(name),
+    AmEventQueue(this),
+    multi(NULL),
+    max_connections(64), max_host_connections(0),
+    dns_cache_timeout(60), default_timeout_ms(10000),
+    connect_timeout_ms(3000), max_body_size(1024*1024),
+    user_agent("SEMS http_client"),
+    stop_requested(false),
+    n_requests(0), n_failed(0), n_new_connections(0),
+    time_ms_total(0), n_active(0)
+{
+  wakeup_pipe[0] = wakeup_pipe[1] = -1;
+}
+
+HttpClient::~HttpClient()
+{
+  if (wakeup_pipe[0] >= 0) close(wakeup_pipe[0]);
+  if (wakeup_pipe[1] >= 0) close(wakeup_pipe[1]);
+}
+
+int HttpClient::configure()
+{
+  AmConfigReader cfg;
+  if (cfg.loadPluginConf(MOD_NAME)) {
+    INFO("no configuration for " MOD_NAME " found, using defaults\n");
+    return 0;
+  }
+
+  max_connections = cfg.getParameterInt("max_connections", max_connections);
+  max_host_connections = cfg.getParameterInt("max_host_connections",
+					     max_host_connections);
+  dns_cache_timeout = cfg.getParameterInt("dns_cache_timeout", dns_cache_timeout);
+  default_timeout_ms = cfg.getParameterInt("timeout_ms", default_timeout_ms);
+  connect_timeout_ms = cfg.getParameterInt("connect_timeout_ms", connect_timeout_ms);
+  max_body_size = cfg.getParameterInt("max_body_size", max_body_size);
+  if (cfg.hasParameter("user_agent"))
+    user_agent = cfg.getParameter("user_agent");
+
+  return 0;
+}
+
+int HttpClient::onLoad()
+{
+  if (configure())
+    return -1;
+
+  if (curl_global_init(CURL_GLOBAL_ALL)) {
+    ERROR("initializing libcurl\n");
+    return -1;
+  }
+
+  if (pipe(wakeup_pipe)) {
+    ERROR("creating wakeup pipe: %s\n", strerror(errno));
+    return -1;
+  }
+  fcntl(wakeup_pipe[0], F_SETFL, O_NONBLOCK);
+  fcntl(wakeup_pipe[1], F_SETFL, O_NONBLOCK);
+
+  multi = curl_multi_init();
+  if (NULL == multi) {
+    ERROR("initializing curl multi handle\n");
+    return -1;
+  }
+  // the connection cache of the multi handle is shared by all requests
+  curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, (long)max_connections);
+  if (max_host_connections)
+    curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, (long)max_host_connections);
+
+  AmEventDispatcher::instance()->addEventQueue(HTTP_CLIENT_QUEUE, this);
+  setEventNotificationSink(this);
+
+  if (!AmPlugIn::registerDIInterface(MOD_NAME, this)) {
+    ERROR("registering " MOD_NAME " DI interface\n");
+    return -1;
+  }
+
+  start();
+
+  DBG(MOD_NAME " loaded: %u connections kept, timeout %u ms\n",
+      max_connections, default_timeout_ms);
+  return 0;
+}
+
+void HttpClient::notify(AmEventQueue* sender)
+{
+  wakeup();
+}
+
+void HttpClient::wakeup()
+{
+  char c = 0;
+  if (write(wakeup_pipe[1], &c, 1) < 0 && errno != EAGAIN)
+    DBG("writing to wakeup pipe: %s\n", strerror(errno));
+}
+
+void HttpClient::drainWakeup()
+{
+  char buf[64];
+  while (read(wakeup_pipe[0], buf, sizeof(buf)) > 0) { }
+}
+
+void HttpClient::invoke(const string& method, const AmArg& args, AmArg& ret)
+{
+  if (method == "get") {
+    args.assertArrayFmt("sss");
+    HttpRequestEvent* req =
+      new HttpRequestEvent(HttpRequestEvent::Get, args.get(0).asCStr(),
+			   args.get(1).asCStr(), args.get(2).asCStr(),
+			   args.size() > 3 ? args.get(3).asInt() : 0);
+    postEvent(req);
+    ret.push(0);
+  } else if (method == "post") {
+    args.assertArrayFmt("sssss");
+    HttpRequestEvent* req =
+      new HttpRequestEvent(HttpRequestEvent::Post, args.get(0).asCStr(),
+			   args.get(3).asCStr(), args.get(4).asCStr(),
+			   args.size() > 5 ? args.get(5).asInt() : 0);
+    req->body = args.get(1).asCStr();
+    req->content_type = args.get(2).asCStr();
+    postEvent(req);
+    ret.push(0);
+  } else if (method == "getStats") {
+    getStats(ret);
+  } else if (method == "_list") {
+    ret.push(AmArg("get"));
+    ret.push(AmArg("post"));
+    ret.push(AmArg("getStats"));
+  } else
+    throw AmDynInvoke::NotImplemented(method);
+}
+
+void HttpClient::process(AmEvent* ev)
+{
+  if (ev->event_id == E_SYSTEM) {
+    AmSystemEvent* sys_ev = dynamic_cast<AmSystemEvent*>(ev);
+    if (sys_ev && sys_ev->sys_event == AmSystemEvent::ServerShutdown) {
+      DBG(MOD_NAME " stopping\n");
+      stop_requested.set(true);
+    }
+    return;
+  }
+
+  HttpRequestEvent* req = dynamic_cast<HttpRequestEvent*>(ev);
+  if (req) {
+    startTransfer(req);
+    return;
+  }
+
+  ERROR("unknown event received\n");
+}
+
+size_t HttpClient::writeBody(char* ptr, size_t size, size_t nmemb, void* userdata)
+{
+  HttpTransfer* t = (HttpTransfer*)userdata;
+  size_t len = size * nmemb;
+  if (t->body.length() + len > _instance->max_body_size) {
+    t->body_truncated = true;
+    return 0; // aborts the transfer
+  }
+  t->body.append(ptr, len);
+  return len;
+}
+
+void HttpClient::startTransfer(HttpRequestEvent* req)
+{
+  CURL* h;
+  if (idle_handles.empty()) {
+    h = curl_easy_init();
+    if (NULL == h) {
+      ERROR("getting curl handle\n");
+      failRequest(req, CURLE_FAILED_INIT, "no curl handle");
+      return;
+    }
+  } else {
+    h = idle_handles.back();
+    idle_handles.pop_back();
+    curl_easy_reset(h);
+  }
+
+  HttpTransfer* t = new HttpTransfer();
+  t->handle = h;
+  t->url = req->url;
+  t->sess_link = req->sess_link;
+  t->token = req->token;
+  gettimeofday(&t->start, NULL);
+
+  curl_easy_setopt(h, CURLOPT_URL, t->url.c_str());
+  curl_easy_setopt(h, CURLOPT_PRIVATE, t);
+  curl_easy_setopt(h, CURLOPT_WRITEFUNCTION, writeBody);
+  curl_easy_setopt(h, CURLOPT_WRITEDATA, t);
+  curl_easy_setopt(h, CURLOPT_ERRORBUFFER, t->error_buf);
+  curl_easy_setopt(h, CURLOPT_NOSIGNAL, 1L);
+  curl_easy_setopt(h, CURLOPT_USERAGENT, user_agent.c_str());
+  curl_easy_setopt(h, CURLOPT_DNS_CACHE_TIMEOUT, (long)dns_cache_timeout);
+  curl_easy_setopt(h, CURLOPT_CONNECTTIMEOUT_MS, (long)connect_timeout_ms);
+  curl_easy_setopt(h, CURLOPT_TIMEOUT_MS,
+		   (long)(req->timeout_ms ? req->timeout_ms : default_timeout_ms));
+
+  if (req->event_id == HttpRequestEvent::Post) {
+    t->post_data = req->body;
+    curl_easy_setopt(h, CURLOPT_POST, 1L);
+    curl_easy_setopt(h, CURLOPT_POSTFIELDS, t->post_data.c_str());
+    curl_easy_setopt(h, CURLOPT_POSTFIELDSIZE, (long)t->post_data.length());
+    if (!req->content_type.empty()) {
+      t->headers = curl_slist_append(t->headers,
+				     ("Content-Type: " + req->content_type).c_str());
+      curl_easy_setopt(h, CURLOPT_HTTPHEADER, t->headers);
+    }
+  }
+
+  CURLMcode rc = curl_multi_add_handle(multi, h);
+  if (rc != CURLM_OK) {
+    ERROR("adding request for '%s': %s\n", t->url.c_str(), curl_multi_strerror(rc));
+    // never started: the handle is not in the multi handle
+    if (t->headers)
+      curl_slist_free_all(t->headers);
+    delete t;
+    idle_handles.push_back(h);
+    failRequest(req, CURLE_FAILED_INIT, curl_multi_strerror(rc));
+    return;
+  }
+
+  transfers[h] = t;
+  stats_mut.lock();
+  n_active++;
+  stats_mut.unlock();
+  DBG("started request '%s' for '%s'\n", t->url.c_str(), t->sess_link.c_str());
+}
+
+void HttpClient::failRequest(HttpRequestEvent* req, CURLcode error,
+			     const string& error_str)
+{
+  stats_mut.lock();
+  n_requests++;
+  n_failed++;
+  stats_mut.unlock();
+
+  HttpResponseEvent* resp = new HttpResponseEvent(req->token, req->url);
+  resp->error = error;
+  resp->error_str = error_str;
+  if (!AmEventDispatcher::instance()->post(req->sess_link, resp))
+    delete resp;
+}
+
+void HttpClient::finishTransfer(CURL* h, CURLcode result)
+{
+  std::map<CURL*, HttpTransfer*>::iterator it = transfers.find(h);
+  if (it == transfers.end()) {
+    ERROR("finished unknown curl handle %p\n", h);
+    return;
+  }
+  HttpTransfer* t = it->second;
+  transfers.erase(it);
+
+  struct timeval now, diff;
+  gettimeofday(&now, NULL);
+  timersub(&now, &t->start, &diff);
+
+  HttpResponseEvent* resp = new HttpResponseEvent(t->token, t->url);
+  resp->time_ms = diff.tv_sec * 1000 + diff.tv_usec / 1000;
+  resp->error = result;
+  if (result != CURLE_OK) {
+    resp->error_str = t->body_truncated ? "response body too large" :
+      (t->error_buf[0] ? t->error_buf : curl_easy_strerror(result));
+  }
+
+  long status = 0, new_connections = 0;
+  char* content_type = NULL;
+  curl_easy_getinfo(h, CURLINFO_RESPONSE_CODE, &status);
+  curl_easy_getinfo(h, CURLINFO_NUM_CONNECTS, &new_connections);
+  if (curl_easy_getinfo(h, CURLINFO_CONTENT_TYPE, &content_type) == CURLE_OK &&
+      content_type)
+    resp->content_type = content_type;
+  resp->status = status;
+  resp->body.swap(t->body);
+
+  curl_multi_remove_handle(multi, h);
+  if (t->headers)
+    curl_slist_free_all(t->headers);
+  idle_handles.push_back(h);
+
+  stats_mut.lock();
+  if (n_active) n_active--;
+  n_requests++;
+  if (result != CURLE_OK) n_failed++;
+  n_new_connections += new_connections;
+  time_ms_total += resp->time_ms;
+  stats_mut.unlock();
+
+  DBG("request '%s' for '%s' done: %ld, %u ms%s%s\n", t->url.c_str(),
+      t->sess_link.c_str(), status, resp->time_ms,
+      resp->error_str.empty() ? "" : ", ", resp->error_str.c_str());
+
+  if (!AmEventDispatcher::instance()->post(t->sess_link, resp)) {
+    DBG("'%s' gone, dropping response of '%s'\n", t->sess_link.c_str(),
+	t->url.c_str());
+    delete resp;
+  }
+  delete t;
+}
+
+void HttpClient::readCompleted()
+{
+  CURLMsg* msg;
+  int msgs_left;
+  while ((msg = curl_multi_info_read(multi, &msgs_left)) != NULL) {
+    if (msg->msg == CURLMSG_DONE)
+      finishTransfer(msg->easy_handle, msg->data.result);
+  }
+}
+
+void HttpClient::run()
+{
+  DBG(MOD_NAME " thread starting\n");
+
+  struct curl_waitfd wakeup_fd;
+  wakeup_fd.fd = wakeup_pipe[0];
+  wakeup_fd.events = CURL_WAIT_POLLIN;
+  wakeup_fd.revents = 0;
+
+  while (!stop_requested.get()) {
+    processEvents();
+
+    int running_handles = 0;
+    curl_multi_perform(multi, &running_handles);
+    readCompleted();
+
+    // curl knows when its next timeout (e.g. a request deadline) is due
+    long timeout_ms = -1;
+    curl_multi_timeout(multi, &timeout_ms);
+    if (timeout_ms < 0 || timeout_ms > HTTP_CLIENT_MAX_WAIT_MS)
+      timeout_ms = HTTP_CLIENT_MAX_WAIT_MS;
+
+    int numfds = 0;
+    curl_multi_wait(multi, &wakeup_fd, 1, timeout_ms, &numfds);
+    drainWakeup();
+  }
+
+  // requests still running are not answered
+  for (std::map<CURL*, HttpTransfer*>::iterator it = transfers.begin();
+       it != transfers.end(); it++) {
+    curl_multi_remove_handle(multi, it->first);
+    curl_easy_cleanup(it->first);
+    if (it->second->headers)
+      curl_slist_free_all(it->second->headers);
+    delete it->second;
+  }
+  transfers.clear();
+  for (size_t i = 0; i < idle_handles.size(); i++)
+    curl_easy_cleanup(idle_handles[i]);
+  idle_handles.clear();
+
+  AmEventDispatcher::instance()->delEventQueue(HTTP_CLIENT_QUEUE);
+  curl_multi_cleanup(multi);
+  multi = NULL;
+  DBG(MOD_NAME " thread stopped\n");
+}
+
+void HttpClient::on_stop()
+{
+  stop_requested.set(true);
+  wakeup();
+}
+
+void HttpClient::getStats(AmArg& ret)
+{
+  stats_mut.lock();
+  ret["requests"] = (int)n_requests;
+  ret["failed"] = (int)n_failed;
+  ret["active"] = (int)n_active;
+  ret["new_connections"] = (int)n_new_connections;
+  ret["avg_time_ms"] = (int)(n_requests ? time_ms_total / n_requests : 0);
+  stats_mut.unlock();
+}
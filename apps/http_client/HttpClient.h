@@ -0,0 +1,147 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _HTTP_CLIENT_H
+#define _HTTP_CLIENT_H
+
+#include "AmApi.h"
+#include "AmEventQueue.h"
+#include "AmThread.h"
+#include "ampi/HttpClientAPI.h"
+
+#include <curl/curl.h>
+
+#include <sys/time.h>
+
+#include <map>
+#include <string>
+#include <vector>
+using std::string;
+
+/** a request being served */
+struct HttpTransfer
+{
+  CURL* handle;
+  string url;
+  string sess_link;
+  string token;
+  /** POST data, curl reads it from here */
+  string post_data;
+  struct curl_slist* headers;
+
+  string body;
+  bool body_truncated;
+  char error_buf[CURL_ERROR_SIZE];
+  struct timeval start;
+
+  HttpTransfer()
+    : handle(NULL), headers(NULL), body_truncated(false) {
+    error_buf[0] = '\0';
+  }
+};
+
+/**
+ * HTTP client for all modules, on curl-multi in one thread
+ *
+ * Requests come as HttpRequestEvent, responses go as HttpResponseEvent
+ * to the sess_link of the request; no session thread waits for a web
+ * service. Connections are kept alive per host and DNS lookups cached
+ * by the multi handle, across requests of all sessions.
+ */
+class HttpClient
+  : public AmDynInvokeFactory,
+    public AmDynInvoke,
+    public AmThread,
+    public AmEventQueue,
+    public AmEventHandler,
+    public AmEventNotificationSink
+{
+  static HttpClient* _instance;
+
+  CURLM* multi;
+  /** handles of finished requests, for reuse */
+  std::vector<CURL*> idle_handles;
+  std::map<CURL*, HttpTransfer*> transfers;
+
+  /** written to by notify() to wake up curl_multi_wait */
+  int wakeup_pipe[2];
+
+  // configuration
+  unsigned int max_connections;
+  unsigned int max_host_connections;
+  unsigned int dns_cache_timeout;
+  unsigned int default_timeout_ms;
+  unsigned int connect_timeout_ms;
+  unsigned int max_body_size;
+  string user_agent;
+
+  AmSharedVar<bool> stop_requested;
+
+  // statistics
+  AmMutex stats_mut;
+  unsigned long long n_requests;
+  unsigned long long n_failed;
+  unsigned long long n_new_connections;
+  unsigned long long time_ms_total;
+  unsigned int n_active;
+
+  int configure();
+
+  void startTransfer(HttpRequestEvent* req);
+  /** answer a request that could not be started */
+  void failRequest(HttpRequestEvent* req, CURLcode error, const string& error_str);
+  void finishTransfer(CURL* handle, CURLcode result);
+  void readCompleted();
+  void wakeup();
+  void drainWakeup();
+
+  static size_t writeBody(char* ptr, size_t size, size_t nmemb, void* userdata);
+
+ public:
+  HttpClient(const string& name);
+  ~HttpClient();
+
+  static HttpClient* instance();
+
+  // DI factory
+  AmDynInvoke* getInstance() { return instance(); }
+  int onLoad();
+
+  // DI API
+  void invoke(const string& method, const AmArg& args, AmArg& ret);
+
+  // AmEventHandler
+  void process(AmEvent* ev);
+  // AmEventNotificationSink
+  void notify(AmEventQueue* sender);
+
+  // AmThread
+  void run();
+  void on_stop();
+
+  void getStats(AmArg& ret);
+};
+
+#endif
@@ -57,18 +57,9 @@ int JsonRpcServer::createRequest(const string& evq_link, const string& method,
 
   }
 
-  string rpc_params_json = arg2json(rpc_params);
-  if (rpc_params_json.length() > MAX_RPC_MSG_SIZE) {
-    ERROR("internal error: message exceeded MAX_RPC_MSG_SIZE (%d)\n", 
-	  MAX_RPC_MSG_SIZE);
+  if (!netstringsAppend(peer->wbuf, rpc_params))
     return -3;
-  }
 
-  DBG("RPC message: >>%.*s<<\n", (int)rpc_params_json.length(), rpc_params_json.c_str());
-  memcpy(peer->msgbuf, rpc_params_json.c_str(), rpc_params_json.length());
-  peer->msg_size = rpc_params_json.length();
-  // set peer connection up for sending
-  peer->msg_recv = false;
   return 0;
 }
 
@@ -83,27 +74,19 @@ int JsonRpcServer::createReply(JsonrpcNetstringsConnection* peer,
   else
     rpc_res["result"] = result;
 
-  string res_s = arg2json(rpc_res);
-  if (res_s.length() > MAX_RPC_MSG_SIZE) {
-    ERROR("internal error: reply exceeded MAX_RPC_MSG_SIZE (%d)\n", 
-	  MAX_RPC_MSG_SIZE);
+  if (!netstringsAppend(peer->wbuf, rpc_res))
     return -3;
-  }
-
-  DBG("created RPC reply: >>%.*s<<\n", (int)res_s.length(), res_s.c_str());
-  memcpy(peer->msgbuf, res_s.c_str(), res_s.length());
-  peer->msg_size = res_s.length();
 
   return 0;
 }
 
-int JsonRpcServer::processMessage(char* msgbuf, unsigned int* msg_size, 
-				  JsonrpcPeerConnection* peer) {
+int JsonRpcServer::processMessage(const char* msg, size_t msg_len,
+				  JsonrpcPeerConnection* peer, string& reply_buf) {
   DBG("parsing message ...\n");
   // const char* txt = "{\"jsonrpc\": \"2.0\", \"result\": 19, \"id\": 1}";
   AmArg rpc_params;
-  if (!json2arg(msgbuf, rpc_params)) {
-    INFO("Error parsing message '%.*s'\n", (int)*msg_size, msgbuf);
+  if (!json2arg(msg, msg_len, rpc_params)) {
+    INFO("Error parsing message '%.*s'\n", (int)msg_len, msg);
     return -1;
   }
 
@@ -130,7 +113,6 @@ int JsonRpcServer::processMessage(char* msgbuf, unsigned int* msg_size,
       rep_recv_q = peer->replyReceivers.find(id);
     if (rep_recv_q == peer->replyReceivers.end()) {
       DBG("received reply for unknown request");
-      *msg_size = 0;
 
       if (peer->flags & JsonrpcPeerConnection::FL_CLOSE_WRONG_REPLY) {
 	INFO("closing connection after unknown reply id %s received\n", id.c_str());
@@ -158,7 +140,6 @@ int JsonRpcServer::processMessage(char* msgbuf, unsigned int* msg_size,
     if (!posted) {
       DBG("receiver event queue does not exist (any more)\n");
       peer->replyReceivers.erase(rep_recv_q);
-      *msg_size = 0;
       if (peer->flags & JsonrpcPeerConnection::FL_CLOSE_NO_REPLYLINK) {
 	INFO("closing connection where reply link missing");
 	return -2;
@@ -168,7 +149,6 @@ int JsonRpcServer::processMessage(char* msgbuf, unsigned int* msg_size,
     DBG("successfully posted reply to event queue\n");
     peer->replyReceivers.erase(rep_recv_q);
     // don't send a reply
-    *msg_size = 0;
     return 0;
   }
 
@@ -192,7 +172,6 @@ int JsonRpcServer::processMessage(char* msgbuf, unsigned int* msg_size,
   if ((id.empty() && !peer->notificationReceiver.empty()) || 
       (!id.empty() && !peer->requestReceiver.empty())) {
     // don't send a reply
-    *msg_size = 0;
 
     string dst_evqueue = id.empty() ? 
       peer->notificationReceiver.c_str() : peer->requestReceiver.c_str();
@@ -250,16 +229,8 @@ int JsonRpcServer::processMessage(char* msgbuf, unsigned int* msg_size,
     }
   }
 
-  string res_s = arg2json(rpc_res);
-  if (res_s.length() > MAX_RPC_MSG_SIZE) {
-    ERROR("internal error: reply exceeded MAX_RPC_MSG_SIZE (%d)\n", 
-	  MAX_RPC_MSG_SIZE);
+  if (!netstringsAppend(reply_buf, rpc_res))
     return -3;
-  }
-
-  DBG("RPC result: >>%.*s<<\n", (int)res_s.length(), res_s.c_str());
-  memcpy(msgbuf, res_s.c_str(), res_s.length());
-  *msg_size = res_s.length();
 
   return 0;
 }
@@ -51,8 +51,13 @@ class JsonRpcServer {
   static void execRpc(const string& method, const string& id, const AmArg& params, AmArg& rpc_res);
   static void runCoreMethod(const string& method, const AmArg& params, AmArg& res);
  public:
-  static int processMessage(char* msgbuf, unsigned int* msg_size,
-			    JsonrpcPeerConnection* peer);
+  /**
+     process a received message, a reply to it is appended
+     to reply_buf as netstring
+     @return <0 if the connection should be closed
+  */
+  static int processMessage(const char* msg, size_t msg_len,
+			    JsonrpcPeerConnection* peer, string& reply_buf);
 
   static int createRequest(const string& evq_link, const string& method, AmArg& params, 
 			   JsonrpcNetstringsConnection* peer, const AmArg& udata,
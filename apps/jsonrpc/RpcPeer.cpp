@@ -39,6 +39,7 @@
 using std::string;
 
 #include "AmUtils.h"
+#include "jsonArg.h"
 #include "AmEventDispatcher.h"
 #include "JsonRPCEvents.h"
 #include "sip/resolver.h"
@@ -65,7 +66,7 @@ void JsonrpcPeerConnection::notifyDisconnect() {
 
 JsonrpcNetstringsConnection::JsonrpcNetstringsConnection(const std::string& id) 
   : JsonrpcPeerConnection(id), 
-    fd(0), msg_size(0), rcvd_size(0), in_msg(false), msg_recv(true)
+    fd(0), rbuf_pos(0)
 {
 }
 
@@ -172,115 +173,92 @@ int JsonrpcNetstringsConnection::connect(const string& host, int port,
 }
 
 
-void JsonrpcNetstringsConnection::resetRead() {
-  in_msg = false;
-  msg_size = 0;
-  rcvd_size = 0;
-  msg_recv = true;
+bool netstringsAppend(string& buf, const AmArg& msg) {
+  size_t start = buf.size();
+  arg2json(msg, buf);
+  size_t len = buf.size() - start;
+  if (len > MAX_RPC_MSG_SIZE - 2) {
+    ERROR("internal error: message exceeded MAX_RPC_MSG_SIZE (%d)\n", 
+	  MAX_RPC_MSG_SIZE);
+    buf.resize(start);
+    return false;
+  }
+  DBG("RPC message: >>%.*s<<\n", (int)len, buf.c_str() + start);
+
+  string len_s = int2str((unsigned int)len) + ":";
+  buf.insert(start, len_s);
+  buf += ',';
+  return true;
+}
+
+int JsonrpcNetstringsConnection::parseMessage(size_t& msg_start, size_t& msg_len) {
+  size_t p = rbuf_pos;
+  size_t len = 0;
+  for (; p < rbuf.size() && rbuf[p] != ':'; p++) {
+    if (p - rbuf_pos >= MAX_NS_LEN_SIZE) {
+      INFO("Protocol error on connection [%p/%d]: oversize length\n", this, fd);
+      return MSG_ERROR;
+    }
+    if (rbuf[p] < '0' || rbuf[p] > '9') {
+      INFO("Protocol error on connection [%p/%d]: invalid character in size\n",
+	   this, fd);
+      return MSG_ERROR;
+    }
+    len = len * 10 + (rbuf[p] - '0');
+  }
+  if (p == rbuf.size())
+    return MSG_INCOMPLETE;
+
+  if (p == rbuf_pos) {
+    INFO("Protocol error on connection [%p/%d]: empty size\n", this, fd);
+    return MSG_ERROR;
+  }
+  // subtraction avoids unsigned wrap when len is near the maximum
+  if (len > MAX_RPC_MSG_SIZE - 2) {
+    INFO("closing connection [%p/%d]: declared netstring size %zu exceeds buffer %u\n",
+	 this, fd, len, (unsigned int)MAX_RPC_MSG_SIZE);
+    return MSG_ERROR;
+  }
+  p++;
+  if (rbuf.size() - p < len + 1)
+    return MSG_INCOMPLETE;
+
+  if (rbuf[p + len] != ',') {
+    INFO("Protocol error on connection [%p/%d]: netstring not terminated with ','\n",
+	 this, fd);
+    return MSG_ERROR;
+  }
+
+  msg_start = p;
+  msg_len = len;
+  return MSG_COMPLETE;
+}
+
+int JsonrpcNetstringsConnection::nextMessage(const char*& msg, size_t& msg_len) {
+  size_t msg_start;
+  int res = parseMessage(msg_start, msg_len);
+  if (res == MSG_COMPLETE) {
+    msg = rbuf.data() + msg_start;
+    rbuf_pos = msg_start + msg_len + 1;
+  }
+  return res;
 }
 
 int JsonrpcNetstringsConnection::netstringsRead() {
-  if (!in_msg) {
-    while (true) {
-      if (rcvd_size > MAX_NS_LEN_SIZE) {
-	DBG("closing connection [%p/%d]: oversize length\n", this, fd);
-	close();
-	return REMOVE;
-      }
-      // reading length
-      ssize_t r=read(fd,&msgbuf[rcvd_size],1);
-      if (!r) {
-	DBG("closing connection [%p/%d] on peer hangup\n", this, fd);
-	close();
-	return REMOVE;
-      }
+  // drop what was processed
+  if (rbuf_pos) {
+    rbuf.erase(0, rbuf_pos);
+    rbuf_pos = 0;
+  }
 
-      if ((r<0 && errno == EAGAIN) || 
-	  (r<0 && errno == EWOULDBLOCK))
-	return CONTINUE;
-     
-      if (r != 1) {
-	INFO("socket error on connection [%p/%d]: %s\n",
-	     this, fd, strerror(errno));
-	close();
-	return REMOVE;
-      }
-      
-      DBG("received '%c'\n", msgbuf[rcvd_size]);
-      if (msgbuf[rcvd_size] == ':') {
-	msgbuf[rcvd_size] = '\0';
-	if (str2i(std::string(msgbuf, rcvd_size), msg_size)) {
-	  ERROR("Protocol error decoding size '%s'\n", msgbuf);
-	  close();
-	  return REMOVE;
-	}
-	// subtraction avoids unsigned wrap when msg_size is near UINT_MAX
-	if (msg_size > MAX_RPC_MSG_SIZE - 2) {
-	  INFO("closing connection [%p/%d]: declared netstring size %u exceeds buffer %u\n",
-	       this, fd, msg_size, (unsigned int)MAX_RPC_MSG_SIZE);
-	  close();
-	  return REMOVE;
-	}
-	// received len - switch to receive msg mode
-	in_msg = true;
-	rcvd_size = read(fd,msgbuf,msg_size+1);
-	// DBG("received '%.*s'\n", rcvd_size, msgbuf);
-
-	if (rcvd_size == msg_size+1) { 
-	  if (msgbuf[msg_size] == ',') {
-	    msgbuf[msg_size+1] = '\0';
-	    return DISPATCH;
-	  }
-	  INFO("Protocol error on connection [%p/%d]: netstring not terminated with ','\n",
-	       this, fd);
-	  close();
-	  return REMOVE;
-	}
-
-	if (!rcvd_size) {
-	  DBG("closing connection [%p/%d] on peer hangup\n", this, fd);
-	  close();
-	  return REMOVE;
-	}
-
-	if (((ssize_t)rcvd_size<0 && errno == EAGAIN) || 
-	    ((ssize_t)rcvd_size<0 && errno == EWOULDBLOCK))
-	  return CONTINUE; // necessary?
-
-	if ((ssize_t)rcvd_size<0) {
-	  INFO("socket error on connection [%p/%d]: %s\n",
-	       this, fd, strerror(errno));
-	  close();
-	  return REMOVE;
-	}
-	       
-	return CONTINUE; 	
-      } 
-
-      if (msgbuf[rcvd_size] < '0' || msgbuf[rcvd_size] > '9') {
-	INFO("Protocol error on connection [%p/%d]: invalid character in size\n",
-	     this, fd);
-	close();
-	return REMOVE;
-      }
-    
-      rcvd_size++;
-    }
-  } else {
-    ssize_t r = read(fd,msgbuf+rcvd_size,msg_size-rcvd_size+1);
-    if (r>0) {
-      rcvd_size += r;
-      DBG("msgbuf='%.*s'\n", msg_size+1,msgbuf);
-      if (rcvd_size == msg_size+1) { 
-	DBG("msg_size = %d, rcvd_size = %d, <%c> \n", msg_size, rcvd_size, msgbuf[msg_size-1]);
-	if (msgbuf[msg_size] == ',')
-	  return DISPATCH;
-	INFO("Protocol error on connection [%p/%d]: netstring not terminated with ','\n",
-	     this, fd);
-	close();
-	return REMOVE;
-      }
-      return CONTINUE;
+  char buf[RPC_READ_SIZE];
+  while (true) {
+    ssize_t r = read(fd, buf, sizeof(buf));
+    if (r > 0) {
+      rbuf.append(buf, r);
+      if ((size_t)r < sizeof(buf) || rbuf.size() >= MAX_RPC_READ_AHEAD)
+	break;
+      continue;
     }
 
     if (!r) {
@@ -289,55 +267,45 @@ int JsonrpcNetstringsConnection::netstringsRead() {
       return REMOVE;
     }
 
-    if ((r<0 && errno == EAGAIN) || 
-	(r<0 && errno == EWOULDBLOCK))
-      return CONTINUE; // necessary?
+    if (errno == EINTR)
+      continue;
+    if (errno == EAGAIN || errno == EWOULDBLOCK)
+      break;
 
     INFO("socket error on connection [%p/%d]: %s\n",
 	 this, fd, strerror(errno));
     close();
     return REMOVE;
   }
-}
 
-int JsonrpcNetstringsConnection::netstringsBlockingWrite() {
-  if ((ssize_t)msg_size<0) {
+  size_t msg_start, msg_len;
+  switch (parseMessage(msg_start, msg_len)) {
+  case MSG_COMPLETE:
+    return DISPATCH;
+  case MSG_ERROR:
     close();
     return REMOVE;
-  }
-  if (msg_size==0)
+  default:
     return CONTINUE;
-
-  // write size to snd_size
-  string msg_size_s = int2str(msg_size);
-  if (msg_size_s.length()>MAX_NS_LEN_SIZE) {
-    ERROR("too large return message size len\n");
-    close();
-    return REMOVE;
   }
-  char* ns_begin = msgbuf-(msg_size_s.length()+1);
-  memcpy(ns_begin, 
-	 msg_size_s.c_str(),
-	 msg_size_s.length());
-  ns_begin[msg_size_s.length()]=':';
-  msgbuf[msg_size]=',';
-  
-  rcvd_size = 0;
-  size_t ns_total_len = msg_size+msg_size_s.length()+2;
-  while (rcvd_size != ns_total_len) {
-    size_t written = send(fd, &ns_begin[rcvd_size], ns_total_len - rcvd_size, 
+}
+
+int JsonrpcNetstringsConnection::netstringsBlockingWrite() {
+  size_t written_total = 0;
+  while (written_total != wbuf.size()) {
+    ssize_t written = send(fd, wbuf.data() + written_total, wbuf.size() - written_total, 
 #ifdef MSG_NOSIGNAL
 			  MSG_NOSIGNAL
 #else
 			  0
 #endif
 			  );
-    if (((ssize_t)written<0 && (errno==EAGAIN || errno==EWOULDBLOCK)) ||
+    if ((written<0 && (errno==EAGAIN || errno==EWOULDBLOCK || errno==EINTR)) ||
 	written==0) {
 	usleep(SEND_SLEEP);
 	continue;
     }
-    if ((ssize_t)written<0) {
+    if (written<0) {
       if (errno == ECONNRESET) {
 	DBG("closing connection [%p/%d] on peer hangup\n", this, fd);
 	close();
@@ -347,11 +315,10 @@ int JsonrpcNetstringsConnection::netstringsBlockingWrite() {
       close();
       return REMOVE;
     }
-    rcvd_size+=written;
+    written_total+=written;
   }
 
-  rcvd_size = 0;
-  msg_size = 0;
+  wbuf.clear();
   return CONTINUE;
 }
 
@@ -363,9 +330,5 @@ void JsonrpcNetstringsConnection::close() {
 }
 
 bool JsonrpcNetstringsConnection::messagePending() {
-  return msg_size != 0;
-}
-
-bool JsonrpcNetstringsConnection::messageIsRecv() { 
-  return msg_recv; 
+  return !wbuf.empty();
 }
@@ -33,9 +33,11 @@
 #include "log.h"
 #include "AmArg.h"
 
-#define MAX_RPC_MSG_SIZE 20*1024*1024 // 20k
+#define MAX_RPC_MSG_SIZE 20*1024*1024 // 20M
 #define MAX_NS_LEN_SIZE 10 
 #define SEND_SLEEP 10000 // 10 ms send retry
+#define RPC_READ_SIZE 65536 // read at once
+#define MAX_RPC_READ_AHEAD 1024*1024 // pipelined data to read before processing
 
 #include <map>
 #include <string>
@@ -85,6 +87,15 @@ struct JsonrpcPeerConnection {
   void notifyDisconnect();
 };
 
+/** encode msg as netstring at the end of buf @return false if too large */
+bool netstringsAppend(std::string& buf, const AmArg& msg);
+
+/**
+ * Netstrings connection. Requests may be pipelined: everything that
+ * arrived is read into rbuf at once, all complete messages in it are
+ * processed in order, and the replies collected in wbuf and written
+ * together.
+ */
 struct JsonrpcNetstringsConnection 
   : public JsonrpcPeerConnection
 {
@@ -92,12 +103,12 @@ struct JsonrpcNetstringsConnection
   ev_io ev_write;
   ev_io ev_read;
 
-  char snd_size[MAX_NS_LEN_SIZE+1];
-  char msgbuf[MAX_RPC_MSG_SIZE];
-  unsigned int msg_size;
-  unsigned int rcvd_size;
-  bool in_msg;
-  bool msg_recv;
+  /** received data, processed up to rbuf_pos */
+  std::string rbuf;
+  size_t rbuf_pos;
+
+  /** netstrings to send */
+  std::string wbuf;
 
   JsonrpcNetstringsConnection(const std::string& id); 
   ~JsonrpcNetstringsConnection(); 
@@ -114,17 +125,28 @@ struct JsonrpcNetstringsConnection
   /** @returns ReadResult */
   int netstringsRead();
 
+  enum {
+    MSG_INCOMPLETE = 0,
+    MSG_COMPLETE,
+    MSG_ERROR
+  } MessageResult;
+
+  /**
+     get the next received message (valid until the next read)
+     @returns MessageResult
+  */
+  int nextMessage(const char*& msg, size_t& msg_len);
+
   /** 
-      blocking write: blocks until message in msgbuf 
-      with size msg_size is written
+      blocking write: blocks until wbuf is written
   */
   int netstringsBlockingWrite();
 
-  void resetRead();
-
   bool messagePending();
 
-  bool messageIsRecv();
+ private:
+  /** check for a complete message at rbuf_pos */
+  int parseMessage(size_t& msg_start, size_t& msg_len);
 };
 
 #endif
@@ -226,7 +226,6 @@ void JsonRPCServerLoop::process(AmEvent* ev) {
     DBG("no pending events for connection %p/%s, starting read loop\n",
 	a_client, a_client->id.c_str());
 
-    a_client->resetRead();
     ev_io_init(&a_client->ev_read,read_cb,a_client->fd,EV_READ);
     ev_io_start(loop,&a_client->ev_read);
   }; break;
@@ -105,17 +105,18 @@ void RpcServerThread::process(AmEvent* event) {
 	return;
       }
     }
-    connection->msg_recv = false;
-
   }
 
   bool processed_message = false;
 
-  int res = 0;
-  if (connection->messagePending() && connection->messageIsRecv()) {
-    DBG("processing message >%.*s<\n", connection->msg_size, connection->msgbuf);
-    res = JsonRpcServer::processMessage(connection->msgbuf, &connection->msg_size, 
-					connection);
+  // everything received, in order - replies are collected in wbuf
+  const char* msg;
+  size_t msg_len;
+  int msg_res;
+  while ((msg_res = connection->nextMessage(msg, msg_len)) ==
+	 JsonrpcNetstringsConnection::MSG_COMPLETE) {
+    DBG("processing message >%.*s<\n", (int)msg_len, msg);
+    int res = JsonRpcServer::processMessage(msg, msg_len, connection, connection->wbuf);
     if (res<0) {
       INFO("error processing message - closing connection\n");
       connection->close();
@@ -124,16 +125,25 @@ void RpcServerThread::process(AmEvent* event) {
       delete connection;
       return;
     }
-
-    connection->msg_recv = false;
     processed_message = true;
+
+    if (connection->flags & JsonrpcPeerConnection::FL_CLOSE_ALWAYS)
+      break;
+  }
+
+  if (msg_res == JsonrpcNetstringsConnection::MSG_ERROR) {
+    connection->close();
+    connection->notifyDisconnect();
+    JsonRPCServerLoop::removeConnection(connection->id);
+    delete connection;
+    return;
   }
 
   DBG("connection->messagePending() = %s\n", connection->messagePending()?"true":"false");
 
-  if (connection->messagePending() && !connection->messageIsRecv()) {
+  if (connection->messagePending()) {
     DBG("calling write\n");
-    res = connection->netstringsBlockingWrite();
+    int res = connection->netstringsBlockingWrite();
     if (res == JsonrpcNetstringsConnection::REMOVE) {
       connection->notifyDisconnect();
       JsonRPCServerLoop::removeConnection(connection->id);
@@ -36,9 +36,6 @@
 class RpcServerThread
 : public AmEventQueue, public AmThread, public AmEventHandler
 {
-
-  char rcvbuf[MAX_RPC_MSG_SIZE];
-
  public:
   RpcServerThread();
   ~RpcServerThread();
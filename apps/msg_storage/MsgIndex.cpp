@@ -0,0 +1,457 @@
+#include "MsgIndex.h"
+#include "MsgStorageAPI.h"
+
+#include "AmUtils.h"
+#include "log.h"
+
+#include <sys/stat.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MSG_INDEX_HEADER "SEMS msgindex 1\n"
+
+// fold the journal into a snapshot when it has more records than this
+// and than there are messages
+#define MSG_JOURNAL_MIN_COMPACT 64
+
+/** read a whole file; @return false if it could not be opened */
+static bool read_file(const string& path, string& data, bool& exists)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    exists = errno != ENOENT;
+    if (exists)
+      ERROR("opening '%s': %s\n", path.c_str(), strerror(errno));
+    return !exists;
+  }
+  exists = true;
+
+  char buf[16384];
+  ssize_t n;
+  while ((n = read(fd, buf, sizeof(buf))) > 0)
+    data.append(buf, n);
+  close(fd);
+  if (n < 0) {
+    ERROR("reading '%s': %s\n", path.c_str(), strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+/** next complete line; an incomplete last line (torn write) is not */
+static bool next_line(const string& data, size_t& pos, string& line)
+{
+  size_t end = data.find('\n', pos);
+  if (end == string::npos)
+    return false;
+  line.assign(data, pos, end - pos);
+  pos = end + 1;
+  return true;
+}
+
+/** "<a> <b> <c> <rest>" */
+static bool split_record(const string& line, unsigned long& a, unsigned long& b,
+			 unsigned long& c, string& rest)
+{
+  const char* p = line.c_str();
+  char* end;
+  a = strtoul(p, &end, 10);
+  if (*end != ' ') return false;
+  b = strtoul(end + 1, &end, 10);
+  if (*end != ' ') return false;
+  c = strtoul(end + 1, &end, 10);
+  if (*end != ' ') return false;
+  rest = end + 1;
+  return !rest.empty();
+}
+
+MsgIndex::MsgIndex(const string& dir)
+  : dir(dir), n_new(0), n_saved(0), loaded(false), journal_records(0),
+    journal_ino(0), journal_size(0)
+{
+}
+
+void MsgIndex::count(const MsgIndexEntry& e, int d) {
+  if (!e.size)
+    return;
+  if (e.is_new)
+    n_new += d;
+  else
+    n_saved += d;
+}
+
+void MsgIndex::apply(char op, const string& name, const MsgIndexEntry& e) {
+  std::map<string, MsgIndexEntry>::iterator it = msgs.find(name);
+  switch (op) {
+  case 'N':
+    if (it != msgs.end()) {
+      count(it->second, -1);
+      it->second = e;
+    } else {
+      msgs[name] = e;
+    }
+    count(e, 1);
+    break;
+
+  case 'R':
+    if (it != msgs.end() && it->second.is_new) {
+      count(it->second, -1);
+      it->second.is_new = false;
+      count(it->second, 1);
+    }
+    break;
+
+  case 'D':
+    if (it != msgs.end()) {
+      count(it->second, -1);
+      msgs.erase(it);
+    }
+    break;
+  }
+}
+
+bool MsgIndex::readSnapshot(bool& exists) {
+  string data;
+  if (!read_file(dir + MSG_INDEX_FILE, data, exists))
+    return false;
+  if (!exists)
+    return true;
+
+  if (data.compare(0, strlen(MSG_INDEX_HEADER), MSG_INDEX_HEADER)) {
+    ERROR("'%s' is not a message index\n", (dir + MSG_INDEX_FILE).c_str());
+    return false;
+  }
+
+  size_t pos = strlen(MSG_INDEX_HEADER);
+  string line, name;
+  while (next_line(data, pos, line)) {
+    unsigned long is_new, size, created;
+    if (!split_record(line, is_new, size, created, name)) {
+      ERROR("damaged record in '%s'\n", (dir + MSG_INDEX_FILE).c_str());
+      return false;
+    }
+    MsgIndexEntry e;
+    e.is_new = is_new;
+    e.size = size;
+    e.created = created;
+    apply('N', name, e);
+  }
+  return true;
+}
+
+bool MsgIndex::readJournal(bool& exists) {
+  string data;
+  if (!read_file(dir + MSG_JOURNAL_FILE, data, exists))
+    return false;
+
+  size_t pos = 0;
+  string line, name;
+  MsgIndexEntry e;
+  e.is_new = true;
+  e.size = 0;
+  e.created = 0;
+  while (next_line(data, pos, line)) {
+    if (line.length() < 3 || line[1] != ' ') {
+      WARN("skipping damaged record in '%s'\n", (dir + MSG_JOURNAL_FILE).c_str());
+      continue;
+    }
+    if (line[0] == 'N') {
+      unsigned long is_new, size, created;
+      if (!split_record(line.substr(2), is_new, size, created, name)) {
+	WARN("skipping damaged record in '%s'\n", (dir + MSG_JOURNAL_FILE).c_str());
+	continue;
+      }
+      e.is_new = is_new;
+      e.size = size;
+      e.created = created;
+    } else {
+      name = line.substr(2);
+    }
+    apply(line[0], name, e);
+    journal_records++;
+  }
+  // a torn record at the end is overwritten by the next append
+  journal_size = pos;
+  if (exists) {
+    struct stat st;
+    if (!stat((dir + MSG_JOURNAL_FILE).c_str(), &st)) {
+      journal_ino = st.st_ino;
+      if (st.st_size != journal_size && truncate((dir + MSG_JOURNAL_FILE).c_str(), pos))
+	journal_size = st.st_size;
+    }
+  }
+  return true;
+}
+
+bool MsgIndex::scanDir() {
+  DIR* d = opendir(dir.c_str());
+  if (!d)
+    return false;
+
+  DBG("building message index of '%s'\n", dir.c_str());
+  struct dirent* entry;
+  while ((entry = readdir(d)) != NULL) {
+    string msgname(entry->d_name);
+    if (!msgname.length() || msgname[0] == '.')
+      continue;
+    struct stat e_stat;
+    if (stat((dir + msgname).c_str(), &e_stat)) {
+      ERROR("cannot stat '%s': %s\n", (dir + msgname).c_str(), strerror(errno));
+      continue;
+    }
+    // read status as it used to be kept: in the atime
+    MsgIndexEntry e;
+    e.is_new = e_stat.st_atime == e_stat.st_mtime;
+    e.size = e_stat.st_size;
+    e.created = e_stat.st_mtime;
+    apply('N', msgname, e);
+  }
+  closedir(d);
+  return true;
+}
+
+bool MsgIndex::load() {
+  msgs.clear();
+  n_new = n_saved = 0;
+  journal_records = 0;
+  journal_ino = 0;
+  journal_size = 0;
+  loaded = false;
+
+  bool snapshot_exists = false, journal_exists = false;
+  if (!readSnapshot(snapshot_exists) || !readJournal(journal_exists)) {
+    WARN("message index of '%s' unusable, rebuilding it\n", dir.c_str());
+    msgs.clear();
+    n_new = n_saved = 0;
+    snapshot_exists = journal_exists = false;
+  }
+
+  if (!snapshot_exists && !journal_exists) {
+    if (!scanDir())
+      return false;
+    loaded = true;
+    compact();
+    return true;
+  }
+
+  loaded = true;
+  if (!journal_exists)
+    compact();
+  return true;
+}
+
+bool MsgIndex::isCurrent() {
+  if (!loaded)
+    return false;
+  struct stat st;
+  if (stat((dir + MSG_JOURNAL_FILE).c_str(), &st))
+    return false;
+  return st.st_ino == journal_ino && st.st_size == journal_size;
+}
+
+bool MsgIndex::appendJournal(const string& record) {
+  string path = dir + MSG_JOURNAL_FILE;
+  int fd = open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0660);
+  if (fd < 0) {
+    ERROR("opening '%s': %s\n", path.c_str(), strerror(errno));
+    return false;
+  }
+
+  // one write: records are appended whole, or not at all
+  ssize_t n = write(fd, record.data(), record.length());
+  struct stat st;
+  bool have_st = !fstat(fd, &st);
+  close(fd);
+  if (n != (ssize_t)record.length()) {
+    ERROR("writing '%s': %s\n", path.c_str(), n < 0 ? strerror(errno) : "short write");
+    if (n > 0 && have_st && truncate(path.c_str(), st.st_size - n))
+      ERROR("truncating '%s': %s\n", path.c_str(), strerror(errno));
+    return false;
+  }
+
+  if (have_st && st.st_ino == journal_ino &&
+      st.st_size == journal_size + (off_t)record.length()) {
+    journal_size = st.st_size;
+  } else {
+    // someone else wrote, too: read it all again next time
+    journal_ino = 0;
+  }
+  journal_records++;
+  return true;
+}
+
+int MsgIndex::add(const string& name, unsigned int size, time_t created) {
+  if (name.empty() || name[0] == '.' || name.find('\n') != string::npos)
+    return MSG_ESTORAGE;
+
+  if (!appendJournal("N 1 " + int2str(size) + " " + long2str(created) +
+		     " " + name + "\n"))
+    return MSG_ESTORAGE;
+
+  MsgIndexEntry e;
+  e.is_new = true;
+  e.size = size;
+  e.created = created;
+  apply('N', name, e);
+
+  if (journal_records > MSG_JOURNAL_MIN_COMPACT && journal_records > msgs.size())
+    compact();
+  return MSG_OK;
+}
+
+int MsgIndex::markRead(const string& name) {
+  std::map<string, MsgIndexEntry>::iterator it = msgs.find(name);
+  if (it == msgs.end())
+    return MSG_EMSGNOTFOUND;
+  if (!it->second.is_new)
+    return MSG_OK;
+
+  if (!appendJournal("R " + name + "\n"))
+    return MSG_ESTORAGE;
+  apply('R', name, it->second);
+  return MSG_OK;
+}
+
+int MsgIndex::remove(const string& name) {
+  std::map<string, MsgIndexEntry>::iterator it = msgs.find(name);
+  if (it == msgs.end())
+    return MSG_EMSGNOTFOUND;
+
+  if (!appendJournal("D " + name + "\n"))
+    return MSG_ESTORAGE;
+  apply('D', name, it->second);
+
+  if (journal_records > MSG_JOURNAL_MIN_COMPACT && journal_records > msgs.size())
+    compact();
+  return MSG_OK;
+}
+
+bool MsgIndex::writeFile(const string& name, const string& data) {
+  string path = dir + name;
+  string tmp_path = path + "." + int2str((int)getpid());
+  FILE* fp = fopen(tmp_path.c_str(), "wb");
+  if (!fp) {
+    ERROR("creating '%s': %s\n", tmp_path.c_str(), strerror(errno));
+    return false;
+  }
+  bool ok = fwrite(data.data(), 1, data.length(), fp) == data.length();
+  ok = !fclose(fp) && ok;
+  if (!ok || rename(tmp_path.c_str(), path.c_str())) {
+    ERROR("writing '%s': %s\n", path.c_str(), strerror(errno));
+    unlink(tmp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool MsgIndex::compact() {
+  string data = MSG_INDEX_HEADER;
+  for (std::map<string, MsgIndexEntry>::iterator it =
+	 msgs.begin(); it != msgs.end(); it++) {
+    data += (it->second.is_new ? "1 " : "0 ") + int2str(it->second.size) +
+      " " + long2str(it->second.created) + " " + it->first + "\n";
+  }
+
+  // snapshot first: replaying the old journal over it changes nothing
+  if (!writeFile(MSG_INDEX_FILE, data) || !writeFile(MSG_JOURNAL_FILE, ""))
+    return false;
+
+  struct stat st;
+  if (stat((dir + MSG_JOURNAL_FILE).c_str(), &st))
+    return false;
+  journal_ino = st.st_ino;
+  journal_size = 0;
+  journal_records = 0;
+  return true;
+}
+
+void MsgIndex::list(AmArg& msglist) {
+  msglist.assertArray(0); // make it an array
+  for (std::map<string, MsgIndexEntry>::iterator it =
+	 msgs.begin(); it != msgs.end(); it++) {
+    AmArg msg;
+    msg.push(it->first.c_str());
+    msg.push(it->second.is_new ? 1 : 0);
+    msg.push((int)it->second.size);
+    msglist.push(msg);
+  }
+}
+
+MsgIndexCache::MsgIndexCache(unsigned int max_size)
+  : max_size(max_size)
+{
+}
+
+MsgIndexCache::~MsgIndexCache() {
+  for (std::map<string, CacheEntry>::iterator it =
+	 entries.begin(); it != entries.end(); it++) {
+    delete it->second.index;
+    delete it->second.mut;
+  }
+}
+
+MsgIndex* MsgIndexCache::get(const string& dir) {
+  mut.lock();
+  std::map<string, CacheEntry>::iterator it = entries.find(dir);
+  if (it == entries.end()) {
+    CacheEntry e;
+    e.index = new MsgIndex(dir);
+    e.mut = new AmMutex();
+    e.users = 0;
+    e.lru_it = lru.insert(lru.end(), dir);
+    it = entries.insert(std::make_pair(dir, e)).first;
+  } else {
+    lru.splice(lru.end(), lru, it->second.lru_it);
+  }
+  it->second.users++;
+  MsgIndex* index = it->second.index;
+  AmMutex* index_mut = it->second.mut;
+  mut.unlock();
+
+  index_mut->lock();
+  if (!index->isCurrent() && !index->load()) {
+    index_mut->unlock();
+    put(index);
+    return NULL;
+  }
+  return index;
+}
+
+void MsgIndexCache::put(MsgIndex* index) {
+  mut.lock();
+  std::map<string, CacheEntry>::iterator it = entries.find(index->getDir());
+  if (it != entries.end()) {
+    if (index->isLoaded())
+      it->second.mut->unlock();
+    it->second.users--;
+    if (!it->second.users && !index->isLoaded()) {
+      // directory does not exist
+      lru.erase(it->second.lru_it);
+      delete it->second.index;
+      delete it->second.mut;
+      entries.erase(it);
+    }
+  }
+  evict();
+  mut.unlock();
+}
+
+void MsgIndexCache::evict() {
+  std::list<string>::iterator l_it = lru.begin();
+  while (entries.size() > max_size && l_it != lru.end()) {
+    std::map<string, CacheEntry>::iterator it = entries.find(*l_it);
+    if (it == entries.end() || it->second.users) {
+      l_it++;
+      continue;
+    }
+    l_it = lru.erase(l_it);
+    delete it->second.index;
+    delete it->second.mut;
+    entries.erase(it);
+  }
+}
@@ -0,0 +1,123 @@
+#ifndef _MSG_INDEX_H
+#define _MSG_INDEX_H
+
+#include "AmArg.h"
+#include "AmThread.h"
+
+#include <sys/types.h>
+#include <time.h>
+
+#include <list>
+#include <map>
+#include <string>
+using std::string;
+
+#define MSG_INDEX_FILE   ".msgindex"
+#define MSG_JOURNAL_FILE ".msgjournal"
+
+struct MsgIndexEntry {
+  bool is_new;
+  unsigned int size;
+  time_t created;
+};
+
+/**
+ * index of the messages of a user directory
+ *
+ * Kept in the directory as snapshot (MSG_INDEX_FILE) and append-only
+ * journal of changes since (MSG_JOURNAL_FILE), so listing and counting
+ * messages does not need to read the directory or stat the messages.
+ * The journal is folded into a new snapshot when it gets long. If
+ * neither exists, the index is built from the directory once.
+ *
+ * Not thread safe, see MsgIndexCache.
+ */
+class MsgIndex
+{
+  string dir;
+  std::map<string, MsgIndexEntry> msgs;
+
+  /** non-empty messages */
+  unsigned int n_new;
+  unsigned int n_saved;
+
+  bool loaded;
+  unsigned int journal_records;
+  /** journal as last read or written by us */
+  ino_t journal_ino;
+  off_t journal_size;
+
+  void count(const MsgIndexEntry& e, int d);
+  void apply(char op, const string& name, const MsgIndexEntry& e);
+
+  bool readSnapshot(bool& exists);
+  bool readJournal(bool& exists);
+  bool scanDir();
+  bool appendJournal(const string& record);
+  bool writeFile(const string& name, const string& data);
+
+ public:
+  /** @param dir user directory, with trailing / */
+  MsgIndex(const string& dir);
+
+  const string& getDir() { return dir; }
+  bool isLoaded() { return loaded; }
+
+  /** @return false if the user directory does not exist */
+  bool load();
+  /** @return false if not loaded or someone else changed the journal since */
+  bool isCurrent();
+
+  // these return MSG_OK, MSG_EMSGNOTFOUND or MSG_ESTORAGE
+
+  /** new (or overwritten) message */
+  int add(const string& name, unsigned int size, time_t created);
+  int markRead(const string& name);
+  int remove(const string& name);
+
+  /** write a snapshot and start a new journal */
+  bool compact();
+
+  /** [name, is_new, size] per message, as userdir_open */
+  void list(AmArg& msglist);
+  void getCounts(unsigned int& new_msgs, unsigned int& saved_msgs) {
+    new_msgs = n_new;
+    saved_msgs = n_saved;
+  }
+  size_t size() { return msgs.size(); }
+};
+
+/**
+ * the indexes of recently used user directories, at most max_size
+ * (and those in use)
+ */
+class MsgIndexCache
+{
+  struct CacheEntry {
+    MsgIndex* index;
+    AmMutex* mut;
+    unsigned int users;
+    std::list<string>::iterator lru_it;
+  };
+
+  std::map<string, CacheEntry> entries;
+  /** least recently used first */
+  std::list<string> lru;
+  unsigned int max_size;
+  AmMutex mut;
+
+  void evict();
+
+ public:
+  MsgIndexCache(unsigned int max_size);
+  ~MsgIndexCache();
+
+  /**
+   * index of the user dir, locked, to give back with put()
+   * @return NULL if the directory does not exist
+   */
+  MsgIndex* get(const string& dir);
+  void put(MsgIndex* index);
+};
+
+#endif
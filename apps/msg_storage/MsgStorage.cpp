@@ -13,8 +13,10 @@
 #include <errno.h>
 #include <dirent.h>
 #include <unistd.h>
+#include <time.h>
 
 #define MSG_DIR "/var/spool/voicebox/" // default
+#define INDEX_CACHE_SIZE 1000 // default
 
 MsgStorage* MsgStorage::_instance = 0;
 
@@ -22,16 +24,21 @@ EXPORT_PLUGIN_CLASS_FACTORY(MsgStorage, MOD_NAME);
 
 MsgStorage::MsgStorage(const string& name)
   : AmDynInvokeFactory(name),
+    index_cache(NULL),
     listeners()
 { 
       _instance = this; 
 }
 
-MsgStorage::~MsgStorage() { }
+MsgStorage::~MsgStorage() {
+  delete index_cache;
+}
 
 int MsgStorage::onLoad() {
 
   msg_dir = MSG_DIR;
+  bool use_index = true;
+  unsigned int index_cache_size = INDEX_CACHE_SIZE;
   
   AmConfigReader cfg;
   if(cfg.loadFile(AmConfig::ModConfigPath + string(MOD_NAME ".conf"))) {
@@ -39,6 +46,18 @@ int MsgStorage::onLoad() {
   } else {
       msg_dir = cfg.getParameter("storage_dir",MSG_DIR);
       DBG("storage_dir set to '%s'.\n", msg_dir.c_str());
+      use_index = cfg.getParameter("use_index", "yes") == "yes";
+      if (cfg.hasParameter("index_cache_size") &&
+	  str2i(cfg.getParameter("index_cache_size"), index_cache_size)) {
+	ERROR("index_cache_size '%s' not understood\n",
+	      cfg.getParameter("index_cache_size").c_str());
+	return -1;
+      }
+  }
+
+  if (use_index) {
+    index_cache = new MsgIndexCache(index_cache_size);
+    DBG("using message indexes, caching %u\n", index_cache_size);
   }
 
   string path = msg_dir;
@@ -146,17 +165,35 @@ int MsgStorage::msg_new(string domain, string user,
 
   DBG("creating '%s'\n", (path + msg_name).c_str());
 
+  // the user's index stays locked until the message is in it
+  MsgIndex* index = NULL;
+  if (index_cache && !(index = index_cache->get(path)))
+    return MSG_EUSRNOTFOUND;
+
   FILE* fp = fopen((path + msg_name).c_str(), "wb");
   if (!fp) {
     ERROR("creating '%s': %s\n", 
 	  (path + msg_name).c_str(),strerror(errno));
+    if (index)
+      index_cache->put(index);
     return MSG_ESTORAGE;
   }
 
   if (data)
     filecopy(data, fp);
+  long size = ftell(fp);
   fclose(fp);
 
+  if (index) {
+    int res = index->add(msg_name, size > 0 ? size : 0, time(NULL));
+    index_cache->put(index);
+    if (res != MSG_OK) {
+      ERROR("adding '%s' to message index failed\n", (path + msg_name).c_str());
+      unlink((path + msg_name).c_str());
+      return res;
+    }
+  }
+
   event_notify(domain,user,"msg_new");
 
   return MSG_OK;
@@ -179,6 +216,17 @@ void MsgStorage::msg_get(string domain, string user,
 }
 
 int MsgStorage::msg_markread(string domain, string user, string msg_name) { 
+  if (index_cache) {
+    MsgIndex* index = index_cache->get(msg_dir + "/" +  domain + "/" + user + "/");
+    if (!index)
+      return MSG_EMSGNOTFOUND;
+    int res = index->markRead(msg_name);
+    index_cache->put(index);
+    if (res != MSG_OK)
+      return res;
+  }
+
+  // also in the atime, as before the index
   string path = msg_dir + "/" +  domain + "/" + user + "/" + msg_name;
 
   struct stat e_stat;
@@ -206,11 +254,26 @@ int MsgStorage::msg_markread(string domain, string user, string msg_name) {
 int MsgStorage::msg_delete(string domain, string user, string msg_name) { 
   // TODO: check the directory lock
   string path = msg_dir + "/" + domain + "/" + user + "/" + msg_name;
-  if (unlink(path.c_str())) {
+
+  int res = MSG_EMSGNOTFOUND;
+  MsgIndex* index = NULL;
+  if (index_cache && (index = index_cache->get(msg_dir + "/" + domain + "/" + user + "/")))
+    res = index->remove(msg_name);
+  if (res == MSG_ESTORAGE) {
+    index_cache->put(index);
+    return res;
+  }
+
+  // out of the index first: a message is never listed without its file
+  if (unlink(path.c_str()) && (res != MSG_OK || errno != ENOENT)) {
       ERROR("cannot unlink '%s': %s\n", 
 	    path.c_str(),strerror(errno));
+      if (index)
+	index_cache->put(index);
       return MSG_EMSGNOTFOUND;
   }
+  if (index)
+    index_cache->put(index);
 
   event_notify(domain,user,"msg_delete");
 
@@ -221,6 +284,26 @@ void MsgStorage::userdir_open(string domain, string user, AmArg& ret) {
   // TODO: block the directory from delete (increase lock)
   string path = msg_dir + "/" +  domain + "/" + user + "/";
   DBG("trying to list '%s'\n", path.c_str());
+
+  if (index_cache) {
+    MsgIndex* index = index_cache->get(path);
+    if (!index) {
+      ret.push(MSG_EUSRNOTFOUND);
+      ret.push(AmArg()); // empty list
+      return;
+    }
+    AmArg msglist;
+    index->list(msglist);
+    index_cache->put(index);
+    ret.push(MSG_OK);
+    ret.push(msglist);
+    return;
+  }
+
+  userdir_scan(path, ret);
+}
+
+void MsgStorage::userdir_scan(const string& path, AmArg& ret) {
   DIR* dir = opendir(path.c_str());
   if (!dir) {
     ret.push(MSG_EUSRNOTFOUND);
@@ -270,8 +353,42 @@ int MsgStorage::userdir_close(string domain, string user) {
 }
 
 void MsgStorage::userdir_getcount(string domain, string user, AmArg& ret) { 
-  // TODO: return some useful value
-  ret.push(-1);
+  string path = msg_dir + "/" +  domain + "/" + user + "/";
+  unsigned int new_msgs = 0, saved_msgs = 0;
+
+  if (index_cache) {
+    MsgIndex* index = index_cache->get(path);
+    if (!index) {
+      ret.push(MSG_EUSRNOTFOUND);
+      ret.push(0);
+      ret.push(0);
+      return;
+    }
+    index->getCounts(new_msgs, saved_msgs);
+    index_cache->put(index);
+  } else {
+    AmArg list_ret;
+    userdir_scan(path, list_ret);
+    if (list_ret.get(0).asInt() != MSG_OK) {
+      ret.push(list_ret.get(0).asInt());
+      ret.push(0);
+      ret.push(0);
+      return;
+    }
+    AmArg& msglist = list_ret.get(1);
+    for (size_t i = 0; i < msglist.size(); i++) {
+      if (!msglist.get(i).get(2).asInt()) // empty message
+	continue;
+      if (msglist.get(i).get(1).asInt())
+	new_msgs++;
+      else
+	saved_msgs++;
+    }
+  }
+
+  ret.push(MSG_OK);
+  ret.push((int)new_msgs);
+  ret.push((int)saved_msgs);
 }
 
 void MsgStorage::events_subscribe(AmDynInvoke* event_sink, string method)
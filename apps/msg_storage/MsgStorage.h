@@ -2,6 +2,7 @@
 #define _MSG_STORAGE_H
 
 #include "AmApi.h"
+#include "MsgIndex.h"
 
 #include <map>
 using std::map;
@@ -14,6 +15,9 @@ class MsgStorage : public AmDynInvokeFactory,
 
   string msg_dir;
 
+  /** NULL if not using indexes (use_index=no) */
+  MsgIndexCache* index_cache;
+
   typedef map<AmDynInvoke*,string> Listeners;
   Listeners  listeners;
   AmMutex    listeners_mut;
@@ -24,6 +28,7 @@ class MsgStorage : public AmDynInvokeFactory,
   int msg_delete(string domain, string user, string msg_name);
 
   void userdir_open(string domain, string user, AmArg& ret);
+  void userdir_scan(const string& path, AmArg& ret);
   int userdir_close(string domain, string user);
   void userdir_getcount(string domain, string user, AmArg& ret);
 
@@ -71,22 +71,17 @@ void MWI::publish(const string& user, const string& domain)
   di_args.push(domain.c_str());
   di_args.push(user.c_str());
     
-  MessageStorage->invoke("userdir_open",di_args,ret);
+  // counts without empty messages
+  MessageStorage->invoke("userdir_getcount",di_args,ret);
     
-  if (!ret.size() || !isArgInt(ret.get(0))) {
-    ERROR("userdir_open for user '%s' domain '%s' returned no (valid) result.\n", user.c_str(), domain.c_str());
+  if (ret.size() < 3 || !isArgInt(ret.get(0)) ||
+      !isArgInt(ret.get(1)) || !isArgInt(ret.get(2))) {
+    ERROR("userdir_getcount for user '%s' domain '%s' returned no (valid) result.\n", user.c_str(), domain.c_str());
     return;
   };
     
-  all_msgs = ret.get(1).size();
-  for (size_t i = 0; i < ret.get(1).size(); i++) {
-    AmArg& elem = ret.get(1).get(i);
-    
-    if (elem.get(2).asInt()) // skip empty messages
-      new_msgs += elem.get(1).asInt();
-    else
-      all_msgs--;
-  };
+  new_msgs = ret.get(1).asInt();
+  all_msgs = new_msgs + ret.get(2).asInt();
                                                   
   DBG("Found %d new and %d old messages\n", new_msgs, all_msgs - new_msgs);
   string vm_buf = int2str(new_msgs) + "/" + int2str(all_msgs - new_msgs);
@@ -0,0 +1,405 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "RegClientShard.h"
+
+#include "AmEventDispatcher.h"
+#include "AmSessionContainer.h"
+#include "AmPlugIn.h"
+#include "log.h"
+
+#include <unistd.h>
+
+void RegClientRegistration::postRegistrationEvent(SIPRegistrationEvent* ev)
+{
+  shard->postStatus(getEventSink(), ev);
+}
+
+RegClientShard::RegClientShard(unsigned int id)
+  : AmEventQueue(this),
+    id(id),
+    wheel(time(NULL), REG_CLIENT_WHEEL_SLOTS),
+    uac_auth_i(NULL),
+    stop_requested(false),
+    shutdown(false)
+{
+}
+
+RegClientShard::~RegClientShard()
+{
+  for (std::map<string, RegClientRegistration*>::iterator it =
+	 registrations.begin(); it != registrations.end(); it++) {
+    AmEventDispatcher::instance()->delEventQueue(it->first);
+    delete it->second;
+  }
+
+  for (std::vector<AmEventBatch*>::iterator it = batches.begin();
+       it != batches.end(); it++)
+    delete *it;
+
+  for (std::map<string, Listener>::iterator it = listeners.begin();
+       it != listeners.end(); it++)
+    dec_ref(it->second.mailbox);
+}
+
+void RegClientShard::run()
+{
+  DBG("registrar client shard %u starting...\n", id);
+  AmDynInvokeFactory* uac_auth_f = AmPlugIn::instance()->getFactory4Di("uac_auth");
+  if (uac_auth_f == NULL) {
+    DBG("unable to get a uac_auth factory. registrations will not be authenticated.\n");
+    DBG("(do you want to load uac_auth module?)\n");
+  } else {
+    uac_auth_i = uac_auth_f->getInstance();
+  }
+
+  while (!stop_requested.get()) {
+    ev_pending.wait_for_to(REG_CLIENT_TICK);
+    processEvents();
+    runTimers(time(NULL));
+    postBatches();
+  }
+}
+
+void RegClientShard::on_stop()
+{
+  stop_requested.set(true);
+  ev_pending.set(true);
+}
+
+void RegClientShard::stop_and_wait()
+{
+  if (!is_stopped()) {
+    stop();
+
+    while (!is_stopped())
+      usleep(10000);
+  }
+}
+
+void RegClientShard::runTimers(time_t now)
+{
+  std::vector<AmWheelTimer*> fired;
+  wheel.expire(now, fired);
+  for (std::vector<AmWheelTimer*>::iterator it = fired.begin();
+       it != fired.end(); it++)
+    onTimer(static_cast<RegClientRegistration*>(*it), now);
+}
+
+void RegClientShard::onTimer(RegClientRegistration* reg, time_t now)
+{
+  if (reg->active) {
+    if (reg->registerExpired(now)) {
+      reg->onRegisterExpired();
+    } else if (!reg->waiting_result && reg->timeToReregister(now)) {
+      reg->doRegistration();
+    }
+  } else if (!reg->remove && reg->waiting_result &&
+	     reg->registerSendTimeout(now)) {
+    reg->onRegisterSendTimeout();
+  }
+
+  update(reg);
+}
+
+void RegClientShard::update(RegClientRegistration* reg)
+{
+  if (reg->remove) {
+    remove_reg(reg);
+    return;
+  }
+
+  // checks are true after the TS
+  if (reg->active) {
+    wheel.schedule(reg, reg->waiting_result ?
+		   reg->getExpiresTS() : reg->getRefreshTS());
+  } else if (reg->waiting_result) {
+    wheel.schedule(reg, reg->getSendTimeoutTS());
+  } else {
+    // failed to send: nothing to wait for
+    wheel.cancel(reg);
+  }
+}
+
+void RegClientShard::process(AmEvent* ev)
+{
+  if (ev->event_id == E_SYSTEM) {
+    AmSystemEvent* sys_ev = dynamic_cast<AmSystemEvent*>(ev);
+    if(sys_ev){
+      DBG("registrar client shard %u received system Event\n", id);
+      if (sys_ev->sys_event == AmSystemEvent::ServerShutdown) {
+	onServerShutdown();
+      }
+      return;
+    }
+  }
+
+  AmSipReplyEvent* sip_rep = dynamic_cast<AmSipReplyEvent*>(ev);
+  if (sip_rep) {
+    onSipReplyEvent(sip_rep);
+    return;
+  }
+
+  SIPNewRegistrationEvent* new_reg = dynamic_cast<SIPNewRegistrationEvent*>(ev);
+  if (new_reg) {
+    onNewRegistration(new_reg);
+    return;
+  }
+
+  SIPRemoveRegistrationEvent* rem_reg = dynamic_cast<SIPRemoveRegistrationEvent*>(ev);
+  if (rem_reg) {
+    onRemoveRegistration(rem_reg);
+    return;
+  }
+}
+
+void RegClientShard::onSipReplyEvent(AmSipReplyEvent* ev)
+{
+  RegClientRegistration* reg = get_reg_unsafe(ev->reply.from_tag);
+  if (reg != NULL) {
+    reg->onRxReply(ev->reply);
+    update(reg);
+  }
+}
+
+RegClientRegistration* RegClientShard::newRegistration(const string& handle,
+							const SIPRegistrationInfo& info,
+							const string& sess_link)
+{
+  return new RegClientRegistration(this, handle, info, sess_link);
+}
+
+void RegClientShard::onNewRegistration(SIPNewRegistrationEvent* new_reg)
+{
+  RegClientRegistration* reg = newRegistration(new_reg->handle, new_reg->info,
+					       new_reg->sess_link);
+
+  if (uac_auth_i != NULL) {
+    DBG("enabling UAC Auth for new registration.\n");
+
+    // get a sessionEventHandler from uac_auth
+    AmArg di_args,ret;
+    AmArg a;
+    a.setBorrowedPointer(reg);
+    di_args.push(a);
+    di_args.push(a);
+
+    uac_auth_i->invoke("getHandler", di_args, ret);
+    if (!ret.size()) {
+      ERROR("Can not add auth handler to new registration!\n");
+    } else {
+      AmObject* p = ret.get(0).asObject();
+      if (p != NULL) {
+	AmSessionEventHandler* h = dynamic_cast<AmSessionEventHandler*>(p);
+	if (h != NULL)
+	  reg->setSessionEventHandler(h);
+      }
+    }
+  }
+
+  add_reg(reg);
+  reg->doRegistration();
+  update(reg);
+}
+
+void RegClientShard::onRemoveRegistration(SIPRemoveRegistrationEvent* rem_reg)
+{
+  RegClientRegistration* reg = get_reg_unsafe(rem_reg->handle);
+  if (reg) {
+    reg->doUnregister();
+    update(reg);
+  }
+}
+
+void RegClientShard::onServerShutdown()
+{
+  // the broadcast comes once per registration handle
+  if (shutdown)
+    return;
+  shutdown = true;
+
+  // TODO: properly wait until unregistered, with timeout
+  DBG("shutdown registrar client shard %u: deregistering\n", id);
+  for (std::map<string, RegClientRegistration*>::iterator it =
+	 registrations.begin(); it != registrations.end(); it++) {
+    it->second->doUnregister();
+    AmEventDispatcher::instance()->delEventQueue(it->first);
+  }
+
+  stop_requested.set(true);
+}
+
+void RegClientShard::add_reg(RegClientRegistration* new_reg)
+{
+  const string& handle = new_reg->getHandle();
+  DBG("adding registration '%s' to shard %u\n", handle.c_str(), id);
+
+  RegClientRegistration* reg = NULL;
+  reg_mut.lock();
+  std::map<string, RegClientRegistration*>::iterator it =
+    registrations.find(handle);
+  if (it != registrations.end())
+    reg = it->second;
+  registrations[handle] = new_reg;
+  reg_mut.unlock();
+
+  addListener(new_reg->getEventSink());
+  AmEventDispatcher::instance()->addEventQueue(handle, this);
+
+  if (reg != NULL) {
+    // old one with the same handle
+    wheel.cancel(reg);
+    releaseListener(reg->getEventSink());
+    delete reg;
+  }
+}
+
+void RegClientShard::remove_reg(RegClientRegistration* reg)
+{
+  DBG("removing registration '%s'\n", reg->getHandle().c_str());
+  wheel.cancel(reg);
+
+  reg_mut.lock();
+  registrations.erase(reg->getHandle());
+  reg_mut.unlock();
+
+  AmEventDispatcher::instance()->delEventQueue(reg->getHandle());
+  releaseListener(reg->getEventSink());
+  delete reg;
+}
+
+RegClientRegistration* RegClientShard::get_reg_unsafe(const string& handle)
+{
+  std::map<string, RegClientRegistration*>::iterator it =
+    registrations.find(handle);
+  if (it != registrations.end())
+    return it->second;
+  return NULL;
+}
+
+void RegClientShard::addListener(const string& sess_link)
+{
+  if (sess_link.empty())
+    return;
+
+  std::map<string, Listener>::iterator it = listeners.find(sess_link);
+  if (it == listeners.end()) {
+    Listener& l = listeners[sess_link];
+    l.mailbox = new AmEventMailbox(sess_link);
+    inc_ref(l.mailbox);
+    l.registrations = 1;
+  } else {
+    it->second.registrations++;
+  }
+}
+
+void RegClientShard::releaseListener(const string& sess_link)
+{
+  std::map<string, Listener>::iterator it = listeners.find(sess_link);
+  if (it == listeners.end())
+    return;
+
+  if (!--it->second.registrations) {
+    // events still to be posted hold their own reference
+    dec_ref(it->second.mailbox);
+    listeners.erase(it);
+  }
+}
+
+void RegClientShard::postStatus(const string& sess_link, SIPRegistrationEvent* ev)
+{
+  std::map<string, Listener>::iterator it = listeners.find(sess_link);
+  if (it == listeners.end()) {
+    AmSessionContainer::instance()->postEvent(sess_link, ev);
+    return;
+  }
+
+  AmEventBatch* batch = it->second.mailbox->add(ev);
+  if (batch)
+    batches.push_back(batch);
+}
+
+void RegClientShard::postBatches()
+{
+  for (std::vector<AmEventBatch*>::iterator it = batches.begin();
+       it != batches.end(); it++)
+    (*it)->getMailbox()->post(*it);
+  batches.clear();
+}
+
+bool RegClientShard::hasRegistration(const string& handle)
+{
+  reg_mut.lock();
+  bool res = registrations.find(handle) != registrations.end();
+  reg_mut.unlock();
+  return res;
+}
+
+bool RegClientShard::getRegistrationState(const string& handle,
+					  unsigned int& state,
+					  unsigned int& expires_left)
+{
+  bool res = false;
+  reg_mut.lock();
+
+  RegClientRegistration* reg = get_reg_unsafe(handle);
+  if (reg) {
+    res = true;
+    state = reg->getState();
+    expires_left = reg->getExpiresLeft();
+  }
+
+  reg_mut.unlock();
+  return res;
+}
+
+void RegClientShard::listRegistrations(AmArg& res)
+{
+  reg_mut.lock();
+
+  for (std::map<string, RegClientRegistration*>::iterator it =
+	 registrations.begin(); it != registrations.end(); it++) {
+    AmArg r;
+    r["handle"] = it->first;
+    r["domain"] = it->second->getInfo().domain;
+    r["user"] = it->second->getInfo().user;
+    r["name"] = it->second->getInfo().name;
+    r["auth_user"] = it->second->getInfo().auth_user;
+    r["proxy"] = it->second->getInfo().proxy;
+    r["event_sink"] = it->second->getEventSink();
+    r["contact"] = it->second->getInfo().contact;
+    res.push(r);
+  }
+
+  reg_mut.unlock();
+}
+
+size_t RegClientShard::size()
+{
+  reg_mut.lock();
+  size_t res = registrations.size();
+  reg_mut.unlock();
+  return res;
+}
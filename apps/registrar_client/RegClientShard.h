@@ -0,0 +1,181 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _RegClientShard_h_
+#define _RegClientShard_h_
+
+#include "AmSipRegistration.h"
+#include "AmSipEvent.h"
+#include "AmEventQueue.h"
+#include "AmThread.h"
+#include "AmApi.h"
+#include "AmTimerWheel.h"
+
+#include <map>
+#include <string>
+#include <vector>
+using std::string;
+
+// ms between timer checks
+#define REG_CLIENT_TICK 100
+
+// timer wheel slots of one second
+#define REG_CLIENT_WHEEL_SLOTS 4096
+
+class RegClientShard;
+struct SIPNewRegistrationEvent;
+class SIPRemoveRegistrationEvent;
+
+/** registration of a shard, with its timer in the shard's wheel */
+class RegClientRegistration
+  : public AmSIPRegistration,
+    public AmWheelTimer
+{
+  RegClientShard* shard;
+
+ protected:
+  void postRegistrationEvent(SIPRegistrationEvent* ev);
+
+ public:
+  RegClientRegistration(RegClientShard* shard,
+			const string& handle,
+			const SIPRegistrationInfo& info,
+			const string& sess_link)
+    : AmSIPRegistration(handle, info, sess_link), shard(shard) { }
+};
+
+/**
+  A part of the registrations with its own thread and event queue.
+
+  The registration handles are registered for the shard's event queue,
+  so replies to the REGISTERs go straight to the shard of the
+  registration. Instead of checking all registrations periodically,
+  each one has a timer for its next refresh, expiry or send timeout in
+  the shard's timer wheel, updated after every change.
+
+  Status events are collected per event sink (sess_link) in an
+  AmEventMailbox and posted after each round of events and timers, so
+  a listener of many registrations is woken up once per round.
+ */
+class RegClientShard
+  : public AmEventQueue,
+    public AmThread,
+    public AmEventHandler
+{
+  unsigned int id;
+
+  // written only by the shard thread; locked for reading by others
+  AmMutex reg_mut;
+  std::map<string, RegClientRegistration*> registrations;
+
+  AmTimerWheel wheel;
+
+  struct Listener {
+    AmEventMailbox* mailbox;
+    unsigned int registrations;
+  };
+  std::map<string, Listener> listeners;
+  std::vector<AmEventBatch*> batches;
+
+  AmDynInvoke* uac_auth_i;
+
+  AmSharedVar<bool> stop_requested;
+  bool shutdown;
+
+  void add_reg(RegClientRegistration* reg);
+  void remove_reg(RegClientRegistration* reg);
+  RegClientRegistration* get_reg_unsafe(const string& handle);
+
+  void addListener(const string& sess_link);
+  void releaseListener(const string& sess_link);
+
+  /** schedule the next check of reg, or remove it */
+  void update(RegClientRegistration* reg);
+  void onTimer(RegClientRegistration* reg, time_t now);
+  void postBatches();
+
+  void onSipReplyEvent(AmSipReplyEvent* ev);
+  void onNewRegistration(SIPNewRegistrationEvent* new_reg);
+  void onRemoveRegistration(SIPRemoveRegistrationEvent* rem_reg);
+  void onServerShutdown();
+
+ protected:
+  /** create the registration object */
+  virtual RegClientRegistration* newRegistration(const string& handle,
+						 const SIPRegistrationInfo& info,
+						 const string& sess_link);
+
+  void run();
+  void on_stop();
+
+ public:
+  RegClientShard(unsigned int id);
+  ~RegClientShard();
+
+  void process(AmEvent* ev);
+
+  /** fire the timers due until now (shard thread) */
+  void runTimers(time_t now);
+
+  /** queue a status event for the listener (shard thread) */
+  void postStatus(const string& sess_link, SIPRegistrationEvent* ev);
+
+  bool hasRegistration(const string& handle);
+  bool getRegistrationState(const string& handle, unsigned int& state,
+			    unsigned int& expires_left);
+  void listRegistrations(AmArg& res);
+  size_t size();
+
+  void stop_and_wait();
+
+  enum {
+    AddRegistration,
+    RemoveRegistration
+  } RegEvents;
+};
+
+struct SIPNewRegistrationEvent : public AmEvent {
+
+  SIPNewRegistrationEvent(const SIPRegistrationInfo& info,
+			  const string& handle,
+			  const string& sess_link)
+    : AmEvent(RegClientShard::AddRegistration),
+      handle(handle), sess_link(sess_link), info(info) { }
+
+
+  string handle;
+  string sess_link;
+  SIPRegistrationInfo info;
+};
+
+class SIPRemoveRegistrationEvent : public AmEvent {
+ public:
+  string handle;
+  SIPRemoveRegistrationEvent(const string& handle)
+    : AmEvent(RegClientShard::RemoveRegistration),
+    handle(handle) { }
+};
+
+#endif
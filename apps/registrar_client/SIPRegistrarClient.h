@@ -28,48 +28,27 @@
 #ifndef RegisterClient_h
 #define RegisterClient_h
 
-#include "AmSipRegistration.h"
+#include "RegClientShard.h"
 #include "AmApi.h"
 
-#include <sys/time.h>
-
-#include <map>
 #include <string>
-using std::map;
+#include <vector>
 using std::string;
 
-struct SIPNewRegistrationEvent;
-class SIPRemoveRegistrationEvent;
+#define REG_CLIENT_DEF_SHARDS 4
 
-class SIPRegistrarClient  : public AmEventQueue,
-			    public AmThread,
-			    public AmEventHandler,
-			    public AmDynInvoke,
+class SIPRegistrarClient  : public AmDynInvoke,
 			    public AmDynInvokeFactory
 {
-  // registrations container
-  AmMutex                       reg_mut;
-  std::map<std::string, AmSIPRegistration*> registrations;
+  // registrations are kept by the shard of their handle
+  std::vector<RegClientShard*> shards;
 
-  void add_reg(const string& reg_id, 
-	       AmSIPRegistration* new_reg);
-  AmSIPRegistration* remove_reg(const string& reg_id);
-  AmSIPRegistration* remove_reg_unsafe(const string& reg_id);
-  AmSIPRegistration* get_reg(const string& reg_id);
-  AmSIPRegistration* get_reg_unsafe(const string& reg_id);
+  RegClientShard* get_shard(const string& handle);
 
-  void onSipReplyEvent(AmSipReplyEvent* ev);	
-  void onNewRegistration(SIPNewRegistrationEvent* new_reg);
-  void onRemoveRegistration(SIPRemoveRegistrationEvent* new_reg);
   void listRegistrations(AmArg& res);
 
   static SIPRegistrarClient* _instance;
 
-  AmDynInvoke* uac_auth_i;
-
-  AmSharedVar<bool> stop_requested;
-  void checkTimeouts();
-  void onServerShutdown();
  public:
   SIPRegistrarClient(const string& name);
   // DI factory
@@ -81,11 +60,6 @@ class SIPRegistrarClient  : public AmEventQueue,
 	
   bool onSipReply(const AmSipReply& rep, AmSipDialog::Status old_dlg_status);
   int onLoad();
-	
-  void run();
-  void on_stop();
-  void process(AmEvent* ev);
-
 
   // API
   string createRegistration(const string& domain, 
@@ -103,34 +77,6 @@ class SIPRegistrarClient  : public AmEventQueue,
 
   bool getRegistrationState(const string& handle, unsigned int& state, 
 			    unsigned int& expires_left);
-
-  enum {
-    AddRegistration,
-    RemoveRegistration
-  } RegEvents;
-
-};
-
-struct SIPNewRegistrationEvent : public AmEvent {
- 
-  SIPNewRegistrationEvent(const SIPRegistrationInfo& info,
-			  const string& handle, 
-			  const string& sess_link)
-    : AmEvent(SIPRegistrarClient::AddRegistration),
-      handle(handle), sess_link(sess_link), info(info) { }
-
-
-  string handle;
-  string sess_link;
-  SIPRegistrationInfo info;
-};
-
-class SIPRemoveRegistrationEvent : public AmEvent {
- public:
-  string handle;
-  SIPRemoveRegistrationEvent(const string& handle) 
-    : AmEvent(SIPRegistrarClient::RemoveRegistration),
-    handle(handle) { }
 };
 
 #endif
@@ -0,0 +1,179 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _CallCounterTable_h_
+#define _CallCounterTable_h_
+
+#include "hash_table.h"
+#include "sip/hash.h"
+#include "AmArg.h"
+
+#include <string>
+#include <map>
+using std::string;
+using std::map;
+
+#define CALL_COUNTER_TABLE_ENTRIES 1024 /* must be a power of 2 */
+
+/**
+ * Hash-table bucket:
+ *   key -> counter
+ */
+class CallCounterBucket
+  : public AmMutex
+{
+  unsigned long id;
+
+public:
+  typedef map<string, int> counter_map;
+  counter_map counters;
+
+  CallCounterBucket(unsigned long id) : id(id) {}
+  unsigned long get_id() const { return id; }
+
+  void dump() const {
+    for (counter_map::const_iterator it = counters.begin();
+	 it != counters.end(); it++)
+      DBG("'%s' -> %i\n", it->first.c_str(), it->second);
+  }
+};
+
+/**
+ * Counters keyed by string (uuid, PIN, ...), sharded over
+ * CALL_COUNTER_TABLE_ENTRIES independently locked buckets, so
+ * that calls for different keys do not serialize on one lock.
+ */
+class CallCounterTable
+{
+  hash_table<CallCounterBucket> table;
+
+  CallCounterBucket* get_bucket(const string& key) {
+    unsigned int h = hashlittle(key.c_str(), key.length(), 0);
+    return table.get_bucket(h & (CALL_COUNTER_TABLE_ENTRIES-1));
+  }
+
+public:
+  CallCounterTable()
+    : table(CALL_COUNTER_TABLE_ENTRIES)
+  {}
+
+  /** @return false if key does not exist */
+  bool get(const string& key, int& value) {
+    CallCounterBucket* b = get_bucket(key);
+    AmLock l(*b);
+    CallCounterBucket::counter_map::iterator it = b->counters.find(key);
+    if (it == b->counters.end())
+      return false;
+    value = it->second;
+    return true;
+  }
+
+  /** @return new value */
+  int set(const string& key, int value) {
+    CallCounterBucket* b = get_bucket(key);
+    AmLock l(*b);
+    return b->counters[key] = value;
+  }
+
+  /**
+   * add delta to the counter, create it (starting with 0) if not existing
+   * @param found set to whether the counter existed before
+   * @return new value
+   */
+  int add(const string& key, int delta, bool& found) {
+    CallCounterBucket* b = get_bucket(key);
+    AmLock l(*b);
+    CallCounterBucket::counter_map::iterator it = b->counters.find(key);
+    if (it == b->counters.end()) {
+      found = false;
+      return b->counters[key] = delta;
+    }
+    found = true;
+    return it->second += delta;
+  }
+
+  int add(const string& key, int delta) {
+    bool found;
+    return add(key, delta, found);
+  }
+
+  /**
+   * compare-and-increment: increment the counter only if
+   * it is below limit
+   * @param current set to the counter value after the operation
+   * @return true if incremented
+   */
+  bool inc_below(const string& key, int limit, int& current) {
+    CallCounterBucket* b = get_bucket(key);
+    AmLock l(*b);
+    CallCounterBucket::counter_map::iterator it = b->counters.find(key);
+    if (it == b->counters.end()) {
+      if (limit <= 0) {
+	current = 0;
+	return false;
+      }
+      current = b->counters[key] = 1;
+      return true;
+    }
+    if (it->second >= limit) {
+      current = it->second;
+      return false;
+    }
+    current = ++it->second;
+    return true;
+  }
+
+  /**
+   * decrement the counter, removing it once it drops to zero
+   * @return new value
+   */
+  int dec(const string& key) {
+    CallCounterBucket* b = get_bucket(key);
+    AmLock l(*b);
+    CallCounterBucket::counter_map::iterator it = b->counters.find(key);
+    if (it == b->counters.end())
+      return 0;
+    if (it->second > 1)
+      return --it->second;
+    b->counters.erase(it);
+    return 0;
+  }
+
+  /** list all counters as struct key -> value (locks one bucket at a time) */
+  void list(AmArg& res) {
+    res.assertStruct();
+    for (unsigned long i=0; i<table.get_size(); i++) {
+      CallCounterBucket* b = table[i];
+      AmLock l(*b);
+      for (CallCounterBucket::counter_map::iterator it = b->counters.begin();
+	   it != b->counters.end(); it++)
+	res[it->first] = it->second;
+    }
+  }
+
+  void dump() const { table.dump(); }
+};
+
+#endif
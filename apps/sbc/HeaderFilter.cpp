@@ -28,6 +28,8 @@
 #include "log.h"
 #include "AmUtils.h"
 #include <algorithm>
+#include <string.h>
+#include <strings.h>
 
 const char* FilterType2String(FilterType ft) {
     switch(ft) {
@@ -58,6 +60,111 @@ bool isActiveFilter(FilterType ft) {
     return (ft != Undefined) && (ft != Transparent);
 }
 
+// number of hash seeds tried per table size before growing the table
+#define FILTER_NAME_SEEDS 16
+// max. table size is FILTER_NAME_MAX_GROW times the initial size
+#define FILTER_NAME_MAX_GROW 8
+
+static inline unsigned char lower_char(char c) {
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+/** case-insensitive FNV-1a */
+static inline unsigned int filter_name_hash(const char* s, size_t len,
+					    unsigned int seed) {
+    unsigned int h = 2166136261u ^ (seed * 0x9e3779b9u);
+    for (size_t i=0; i<len; i++) {
+	h ^= lower_char(s[i]);
+	h *= 16777619u;
+    }
+    return h;
+}
+
+FilterNameSet::FilterNameSet()
+  : mask(0), seed(0), max_probes(0)
+{
+}
+
+void FilterNameSet::insert(const string& name) {
+    string c = name;
+    std::transform(c.begin(), c.end(), c.begin(), ::tolower);
+    if (names.insert(c).second)
+	compile();
+}
+
+void FilterNameSet::clear() {
+    names.clear();
+    compile();
+}
+
+void FilterNameSet::compile() {
+    keys.assign(names.begin(), names.end());
+    slots.clear();
+    mask = seed = max_probes = 0;
+    if (keys.empty())
+	return;
+
+    unsigned int size = 8;
+    while (size < 2 * keys.size())
+	size <<= 1;
+
+    // look for a collision-free placement (perfect hash)
+    for (unsigned int max_size = size * FILTER_NAME_MAX_GROW;
+	 size <= max_size; size <<= 1) {
+	for (unsigned int s=0; s<FILTER_NAME_SEEDS; s++) {
+	    slots.assign(size, -1);
+	    size_t i = 0;
+	    for (; i<keys.size(); i++) {
+		unsigned int h = filter_name_hash(keys[i].c_str(), keys[i].length(), s)
+		    & (size - 1);
+		if (slots[h] >= 0)
+		    break;
+		slots[h] = i;
+	    }
+	    if (i == keys.size()) {
+		mask = size - 1;
+		seed = s;
+		max_probes = 1;
+		return;
+	    }
+	}
+    }
+
+    // fall back to linear probing in the largest table
+    size >>= 1;
+    mask = size - 1;
+    slots.assign(size, -1);
+    for (size_t i=0; i<keys.size(); i++) {
+	unsigned int h = filter_name_hash(keys[i].c_str(), keys[i].length(), 0) & mask;
+	unsigned int probes = 1;
+	while (slots[h] >= 0) {
+	    h = (h + 1) & mask;
+	    probes++;
+	}
+	slots[h] = i;
+	if (probes > max_probes)
+	    max_probes = probes;
+    }
+    DBG("no perfect hash for %zd filter names, max. %u probes\n",
+	keys.size(), max_probes);
+}
+
+bool FilterNameSet::contains(const char* name, size_t len) const {
+    if (!max_probes)
+	return false;
+
+    unsigned int h = filter_name_hash(name, len, seed) & mask;
+    for (unsigned int p=0; p<max_probes; p++, h = (h + 1) & mask) {
+	int k = slots[h];
+	if (k < 0)
+	    return false;
+	const string& key = keys[k];
+	if (key.length() == len && !strncasecmp(key.c_str(), name, len))
+	    return true;
+    }
+    return false;
+}
+
 /** @return whether successful */
 bool readFilter(AmConfigReader& cfg, const char* cfg_key_filter, const char* cfg_key_list,
 		vector<FilterEntry>& filter_list, bool keep_transparent_entry) {
@@ -78,9 +185,7 @@ bool readFilter(AmConfigReader& cfg, const char* cfg_key_filter, const char* cfg
 
     vector<string> elems = explode(cfg.getParameter(cfg_key_list), ",");
     for (vector<string>::iterator it=elems.begin(); it != elems.end(); it++) {
-	string c = *it;
-	std::transform(c.begin(), c.end(), c.begin(), ::tolower);
-	hf.filter_list.insert(c);
+	hf.filter_list.insert(*it);
     }
 
     filter_list.push_back(hf);
@@ -196,41 +301,54 @@ int inplaceHeaderFilter(string& hdrs, const vector<FilterEntry>& filter_list) {
 
     DBG("applying %zd header filters\n", filter_list.size());
 
-    for (vector<FilterEntry>::const_iterator fe =
-	     filter_list.begin(); fe != filter_list.end(); fe++) {
-	const set<string>& headerfilter_list = fe->filter_list;
-	const FilterType& f_type = fe->filter_type; 
+    // single pass over the headers: every header is checked against all
+    // filters, kept headers are moved to the front (out_pos)
+
+    // todo: multi-line header support
+
+    int res = 0;
+    size_t start_pos = 0;
+    size_t out_pos = 0;
+    while (start_pos<hdrs.length()) {
+	size_t name_end, val_begin, val_end, hdr_end;
+	if ((res = skip_header(hdrs, start_pos, name_end, val_begin,
+			       val_end, hdr_end)) != 0) {
+	    break;
+	}
 
-	if (!isActiveFilter(f_type))
-	  continue;
+	const char* hdr_name = hdrs.data() + start_pos;
+	size_t hdr_name_len = name_end - start_pos;
 
-	// todo: multi-line header support
+	bool erase = false;
+	for (vector<FilterEntry>::const_iterator fe =
+		 filter_list.begin(); fe != filter_list.end(); fe++) {
+	    if (!isActiveFilter(fe->filter_type))
+		continue;
 
-	size_t start_pos = 0;
-	while (start_pos<hdrs.length()) {
-	    size_t name_end, val_begin, val_end, hdr_end;
-	    int res;
-	    if ((res = skip_header(hdrs, start_pos, name_end, val_begin,
-				   val_end, hdr_end)) != 0) {
-		return res;
-	    }
-	    string hdr_name = hdrs.substr(start_pos, name_end-start_pos);
-	    std::transform(hdr_name.begin(), hdr_name.end(), hdr_name.begin(), ::tolower);
-	    bool erase = false;
-	    if (f_type == Whitelist) {
-		erase = headerfilter_list.find(hdr_name)==headerfilter_list.end();
-	    } else if (f_type == Blacklist) {
-		erase = headerfilter_list.find(hdr_name)!=headerfilter_list.end();
-	    }
-	    if (erase) {
-		DBG("erasing header '%s' by %s\n", hdr_name.c_str(), FilterType2String(f_type));
-		hdrs.erase(start_pos, hdr_end-start_pos);
-	    } else {
-		start_pos = hdr_end;
+	    if ((fe->filter_type == Whitelist) ^
+		fe->filter_list.contains(hdr_name, hdr_name_len)) {
+		DBG("erasing header '%.*s' by %s\n", (int)hdr_name_len, hdr_name,
+		    FilterType2String(fe->filter_type));
+		erase = true;
+		break;
 	    }
 	}
 
+	if (!erase) {
+	    if (out_pos != start_pos)
+		memmove(&hdrs[out_pos], &hdrs[start_pos], hdr_end - start_pos);
+	    out_pos += hdr_end - start_pos;
+	}
+	start_pos = hdr_end;
     }
 
-    return 0;
+    if (start_pos < hdrs.length()) {
+	// parse error: leave the rest untouched
+	if (out_pos != start_pos)
+	    memmove(&hdrs[out_pos], &hdrs[start_pos], hdrs.length() - start_pos);
+	out_pos += hdrs.length() - start_pos;
+    }
+    hdrs.resize(out_pos);
+
+    return res;
 }
@@ -38,9 +38,58 @@ using std::vector;
 
 enum FilterType { Transparent=0, Whitelist, Blacklist, Undefined };
 
+/**
+ * Set of lowercased names (headers, codecs, a-lines, methods).
+ *
+ * Besides the sorted set, the names are compiled into an open
+ * addressing hash index (case-insensitive hash); the table size and
+ * seed are chosen on insert so that lookups usually hit the name
+ * at the first probe. contains() compares case-insensitively
+ * against the original buffer and does not allocate.
+ */
+class FilterNameSet
+{
+  set<string> names;
+
+  // compiled index: slot -> index into keys, -1 if empty
+  vector<string> keys;
+  vector<int> slots;
+  unsigned int mask;
+  unsigned int seed;
+  unsigned int max_probes;
+
+  void compile();
+
+public:
+  typedef set<string>::const_iterator const_iterator;
+
+  FilterNameSet();
+
+  /** insert a name (lowercased) */
+  void insert(const string& name);
+  void clear();
+
+  bool contains(const char* name, size_t len) const;
+  bool contains(const string& name) const {
+    return contains(name.c_str(), name.length());
+  }
+
+  size_t size() const { return names.size(); }
+  bool empty() const { return names.empty(); }
+  const_iterator begin() const { return names.begin(); }
+  const_iterator end() const { return names.end(); }
+
+  /** max. number of probes of a lookup (1: perfect hash) */
+  unsigned int get_max_probes() const { return max_probes; }
+
+  bool operator==(const FilterNameSet& rhs) const {
+    return names == rhs.names;
+  }
+};
+
 struct FilterEntry {
   FilterType filter_type;
-  set<string> filter_list;
+  FilterNameSet filter_list;
 
   bool operator==(const FilterEntry& rhs) const {
     return (filter_type == rhs.filter_type) &&
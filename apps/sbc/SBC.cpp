@@ -38,6 +38,7 @@ SBC - feature-wishlist
 #include "log.h"
 #include "AmUtils.h"
 #include "AmAudio.h"
+#include "AmAudioProfiler.h"
 #include "AmPlugIn.h"
 #include "AmMediaProcessor.h"
 #include "AmConfigReader.h"
@@ -54,6 +55,7 @@ SBC - feature-wishlist
 #include "ParamReplacer.h"
 #include "SDPFilter.h"
 #include "SBCCallLeg.h"
+#include "SBCCallRegistry.h"
 
 #include "AmEventQueueProcessor.h"
 
@@ -475,6 +477,8 @@ void SBCFactory::invoke(const string& method, const AmArg& args,
   } else if (method == "postControlCmd"){
     args.assertArrayFmt("ss"); // at least call-ltag, cmd
     postControlCmd(args,ret);
+  } else if (method == "listCallRegistry"){
+    SBCCallRegistry::listCalls(ret);
   } else if(method == "_list"){ 
     ret.push(AmArg("listProfiles"));
     ret.push(AmArg("reloadProfiles"));
@@ -487,8 +491,14 @@ void SBCFactory::invoke(const string& method, const AmArg& args,
     ret.push(AmArg("loadCallcontrolModules"));
     ret.push(AmArg("postControlCmd"));
     ret.push(AmArg("printCallStats"));
+    ret.push(AmArg("listCallRegistry"));
+    ret.push(AmArg("getTranscodingStats"));
   } else if(method == "printCallStats"){ 
     B2BMediaStatistics::instance()->getReport(args, ret);
+  } else if(method == "getTranscodingStats"){
+    // rates since the previous getTranscodingStats
+    static AmAudioProfileSnapshot last;
+    AmAudioProfiler::getStats(ret, &last);
   }  else
     throw AmDynInvoke::NotImplemented(method);
 }
@@ -546,11 +546,8 @@ void SBCCallLeg::onSipRequest(const AmSipRequest& req) {
 	 it != call_profile.messagefilter.end(); it++) {
 
       if (isActiveFilter(it->filter_type)) {
-	string method = req.method;
-	std::transform(method.begin(), method.end(), method.begin(), ::tolower);
-
 	bool is_filtered = (it->filter_type == Whitelist) ^ 
-	  (it->filter_list.find(method) != it->filter_list.end());
+	  it->filter_list.contains(req.method);
 	if (is_filtered) {
 	  DBG("replying 405 to filtered message '%s'\n", req.method.c_str());
 	  // RFC 3261 Section 8.2.6: 405 MUST include Allow header
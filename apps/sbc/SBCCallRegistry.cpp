@@ -24,41 +24,53 @@
  */
 
 #include "SBCCallRegistry.h"
+#include "sip/hash.h"
 #include "log.h"
 
-AmMutex SBCCallRegistry::registry_mutex;
-std::map<string, SBCCallRegistryEntry> SBCCallRegistry::registry;
+hash_table<SBCCallRegistryBucket> SBCCallRegistry::registry(SBC_CALL_REGISTRY_ENTRIES);
+atomic_int SBCCallRegistry::registry_size;
+
+SBCCallRegistryBucket* SBCCallRegistry::get_bucket(const string& ltag) {
+  unsigned int h = hashlittle(ltag.c_str(), ltag.length(), 0);
+  return registry.get_bucket(h & (SBC_CALL_REGISTRY_ENTRIES-1));
+}
 
 void SBCCallRegistry::addCall(const string& ltag, const SBCCallRegistryEntry& other_dlg) {
-  registry_mutex.lock();
-  registry[ltag] = other_dlg;
-  registry_mutex.unlock();
+  SBCCallRegistryBucket* b = get_bucket(ltag);
+  b->lock();
+  if (b->entries.insert(std::make_pair(ltag, other_dlg)).second)
+    registry_size.inc();
+  else
+    b->entries[ltag] = other_dlg;
+  b->unlock();
 
   DBG("SBCCallRegistry: Added call '%s' - mapped to: '%s'/'%s'/'%s'\n", ltag.c_str(), other_dlg.ltag.c_str(), other_dlg.rtag.c_str(), other_dlg.callid.c_str());
 }
 
 void SBCCallRegistry::updateCall(const string& ltag, const string& other_rtag) {
-  registry_mutex.lock();
+  SBCCallRegistryBucket* b = get_bucket(ltag);
+  b->lock();
 
-  std::map<string, SBCCallRegistryEntry>::iterator it = registry.find(ltag);
-  if (it != registry.end()) {
+  SBCCallRegistryBucket::entry_map::iterator it = b->entries.find(ltag);
+  if (it != b->entries.end()) {
     it->second.rtag = other_rtag;
   }
 
-  registry_mutex.unlock();
+  b->unlock();
 
   DBG("SBCCallRegistry: Updated call '%s' - rtag to: '%s'\n", ltag.c_str(), other_rtag.c_str());
 }
 
 void SBCCallRegistry::updateCallId(const string& ltag, const string& other_callid) {
-  registry_mutex.lock();
+  SBCCallRegistryBucket* b = get_bucket(ltag);
+  b->lock();
 
-  std::map<string, SBCCallRegistryEntry>::iterator it = registry.find(ltag);
-  if (it != registry.end()) {
+  SBCCallRegistryBucket::entry_map::iterator it = b->entries.find(ltag);
+  if (it != b->entries.end()) {
     it->second.callid = other_callid;
   }
 
-  registry_mutex.unlock();
+  b->unlock();
 
   DBG("SBCCallRegistry: Updated call '%s' - callid to: '%s'\n", ltag.c_str(), other_callid.c_str());
 }
@@ -66,13 +78,14 @@ void SBCCallRegistry::updateCallId(const string& ltag, const string& other_calli
 bool SBCCallRegistry::lookupCall(const string& ltag, SBCCallRegistryEntry& other_dlg) {
   bool res = false;
 
-  registry_mutex.lock();
-  std::map<string, SBCCallRegistryEntry>::iterator it = registry.find(ltag);
-  if (it != registry.end()) {
+  SBCCallRegistryBucket* b = get_bucket(ltag);
+  b->lock();
+  SBCCallRegistryBucket::entry_map::iterator it = b->entries.find(ltag);
+  if (it != b->entries.end()) {
     res = true;
     other_dlg = it->second;
   }
-  registry_mutex.unlock();
+  b->unlock();
 
   if (res) {
     DBG("SBCCallRegistry: found call mapping '%s' -> '%s'/'%s'/'%s'\n",
@@ -84,9 +97,33 @@ bool SBCCallRegistry::lookupCall(const string& ltag, SBCCallRegistryEntry& other
 }
 
 void SBCCallRegistry::removeCall(const string& ltag) {
-  registry_mutex.lock();
-  registry.erase(ltag);
-  registry_mutex.unlock();  
+  SBCCallRegistryBucket* b = get_bucket(ltag);
+  b->lock();
+  if (b->entries.erase(ltag))
+    registry_size.dec();
+  b->unlock();  
 
   DBG("SBCCallRegistry: removed entry for call '%s'\n", ltag.c_str());
 }
+
+unsigned int SBCCallRegistry::getSize() {
+  return registry_size.get();
+}
+
+void SBCCallRegistry::listCalls(AmArg& ret) {
+  ret.assertArray();
+  for (unsigned long i=0; i<registry.get_size(); i++) {
+    SBCCallRegistryBucket* b = registry[i];
+    b->lock();
+    for (SBCCallRegistryBucket::entry_map::iterator it = b->entries.begin();
+	 it != b->entries.end(); it++) {
+      AmArg e;
+      e["ltag"] = it->first;
+      e["other_ltag"] = it->second.ltag;
+      e["other_rtag"] = it->second.rtag;
+      e["other_callid"] = it->second.callid;
+      ret.push(e);
+    }
+    b->unlock();
+  }
+}
@@ -27,11 +27,16 @@
 #define _SBCCallRegistry_H
 
 #include "AmThread.h"
+#include "AmArg.h"
+#include "hash_table.h"
+#include "atomic_types.h"
 
 #include <string>
 using std::string;
 #include <map>
 
+#define SBC_CALL_REGISTRY_ENTRIES 1024 /* must be a power of 2 */
+
 struct SBCCallRegistryEntry
 {
   string ltag;
@@ -43,10 +48,40 @@ SBCCallRegistryEntry(const string& callid, const string& ltag, const string& rta
   : ltag(ltag), rtag(rtag), callid(callid) { }
 };
 
+/**
+ * Hash-table bucket:
+ *   ltag -> other leg
+ */
+class SBCCallRegistryBucket
+  : public AmMutex
+{
+  unsigned long id;
+
+public:
+  typedef std::map<string, SBCCallRegistryEntry> entry_map;
+  entry_map entries;
+
+  SBCCallRegistryBucket(unsigned long id) : id(id) {}
+  unsigned long get_id() const { return id; }
+
+  void dump() const {
+    for (entry_map::const_iterator it = entries.begin();
+	 it != entries.end(); it++)
+      DBG("'%s' -> '%s'/'%s'/'%s'\n", it->first.c_str(), it->second.ltag.c_str(),
+	  it->second.rtag.c_str(), it->second.callid.c_str());
+  }
+};
+
+/**
+ * ltag -> other leg mapping, sharded over SBC_CALL_REGISTRY_ENTRIES
+ * independently locked buckets.
+ */
 class SBCCallRegistry 
 {
-  static AmMutex registry_mutex;
-  static std::map<string, SBCCallRegistryEntry> registry;
+  static hash_table<SBCCallRegistryBucket> registry;
+  static atomic_int registry_size;
+
+  static SBCCallRegistryBucket* get_bucket(const string& ltag);
 
  public:
   SBCCallRegistry() { }
@@ -57,6 +92,16 @@ class SBCCallRegistry
   static void updateCallId(const string& ltag, const string& other_callid);
   static bool lookupCall(const string& ltag, SBCCallRegistryEntry& other_dlg);
   static void removeCall(const string& ltag);
+
+  /** number of registered call legs */
+  static unsigned int getSize();
+
+  /**
+   * list all entries as array of struct
+   * { ltag, other_ltag, other_rtag, other_callid };
+   * locks one bucket at a time, so call setup is not blocked
+   */
+  static void listCalls(AmArg& ret);
 };
 
 #endif                           
@@ -35,7 +35,7 @@ int filterSDP(AmSdp& sdp, const vector<FilterEntry>& filter_list) {
 	 filter_list.begin(); it!=filter_list.end(); it++){
 
     const FilterType& sdpfilter = it->filter_type;
-    const std::set<string>& sdpfilter_list = it->filter_list;
+    const FilterNameSet& sdpfilter_list = it->filter_list;
 
     bool media_line_filtered_out = false;
     bool media_line_left = false;
@@ -51,13 +51,10 @@ int filterSDP(AmSdp& sdp, const vector<FilterEntry>& filter_list) {
       for (std::vector<SdpPayload>::iterator p_it =
 	     media.payloads.begin(); p_it != media.payloads.end(); p_it++) {
       
-	string c = p_it->encoding_name;
-	std::transform(c.begin(), c.end(), c.begin(), ::tolower);
-
 	bool is_filtered =  (sdpfilter == Whitelist) ^
-	  (sdpfilter_list.find(c) != sdpfilter_list.end());
+	  sdpfilter_list.contains(p_it->encoding_name);
 
-	// DBG("%s (%s) is_filtered: %s\n", p_it->encoding_name.c_str(), c.c_str(), 
+	// DBG("%s is_filtered: %s\n", p_it->encoding_name.c_str(),
 	// 	  is_filtered?"true":"false");
 
 	if (!is_filtered)
@@ -92,7 +89,7 @@ int filterMedia(AmSdp& sdp, const vector<FilterEntry>& filter_list)
   for (vector<FilterEntry>::const_iterator i = filter_list.begin(); i !=filter_list.end(); ++i) {
 
     const FilterType& filter = i->filter_type;
-    const std::set<string>& media_list = i->filter_list;
+    const FilterNameSet& media_list = i->filter_list;
 
     if (!isActiveFilter(filter)) continue;
 
@@ -102,7 +99,7 @@ int filterMedia(AmSdp& sdp, const vector<FilterEntry>& filter_list)
       string type(SdpMedia::type2str(m->type));
       DBG("checking whether to filter out '%s'\n", type.c_str());
 
-      bool is_filtered = (filter == Whitelist) ^ (media_list.find(type) != media_list.end());
+      bool is_filtered = (filter == Whitelist) ^ media_list.contains(type);
       if (is_filtered) {
         m->port = 0;
         filtered_out++;
@@ -160,29 +157,28 @@ void fix_incomplete_silencesupp(SdpMedia& m) {
   }
 }
 
-std::vector<SdpAttribute> filterSDPAttributes(std::vector<SdpAttribute> attributes,
-  FilterType sdpalinesfilter, const std::set<string>& sdpalinesfilter_list) {
+static void filterSDPAttributes(std::vector<SdpAttribute>& attributes,
+  FilterType sdpalinesfilter, const FilterNameSet& sdpalinesfilter_list) {
 
-  std::vector<SdpAttribute> res;
+  std::vector<SdpAttribute>::iterator out = attributes.begin();
   for (std::vector<SdpAttribute>::iterator a_it =
     attributes.begin(); a_it != attributes.end(); a_it++) {
     
-    // Case insensitive search:
-    string c = a_it->attribute;
-    std::transform(c.begin(), c.end(), c.begin(), ::tolower);
-    
-    // Check, if this should be filtered:
+    // Check (case insensitive), if this should be filtered:
     bool is_filtered =  (sdpalinesfilter == Whitelist) ^
-      (sdpalinesfilter_list.find(c) != sdpalinesfilter_list.end());
+      sdpalinesfilter_list.contains(a_it->attribute);
 
-    DBG("%s (%s) is_filtered: %s\n", a_it->attribute.c_str(), c.c_str(), 
+    DBG("%s is_filtered: %s\n", a_it->attribute.c_str(),
      	  is_filtered?"true":"false");
  
-    // If it is not filtered, just add it to the list:
-    if (!is_filtered)
-	res.push_back(*a_it);
+    // If it is not filtered, keep it:
+    if (!is_filtered) {
+      if (out != a_it)
+	std::swap(*out, *a_it);
+      out++;
+    }
   }
-  return res;
+  attributes.erase(out, attributes.end());
 }
 
 int filterSDPalines(AmSdp& sdp, const vector<FilterEntry>& filter_list) {
@@ -190,22 +186,20 @@ int filterSDPalines(AmSdp& sdp, const vector<FilterEntry>& filter_list) {
 	 filter_list.begin(); it!=filter_list.end(); it++){
 
     const FilterType& sdpalinesfilter = it->filter_type;
-    const std::set<string>& sdpalinesfilter_list = it->filter_list;
+    const FilterNameSet& sdpalinesfilter_list = it->filter_list;
 
     // If not Black- or Whitelist, simply return
     if (!isActiveFilter(sdpalinesfilter))
       continue;
   
     // We start with per Session-alines
-    sdp.attributes =
-      filterSDPAttributes(sdp.attributes, sdpalinesfilter, sdpalinesfilter_list);
+    filterSDPAttributes(sdp.attributes, sdpalinesfilter, sdpalinesfilter_list);
 
     for (std::vector<SdpMedia>::iterator m_it =
 	   sdp.media.begin(); m_it != sdp.media.end(); m_it++) {
       SdpMedia& media = *m_it;
       // todo: what if no payload supported any more?
-      media.attributes =
-	filterSDPAttributes(media.attributes, sdpalinesfilter, sdpalinesfilter_list);
+      filterSDPAttributes(media.attributes, sdpalinesfilter, sdpalinesfilter_list);
     }
   }
 
@@ -34,11 +34,14 @@
 #include <string.h>
 
 #define SBCVAR_PARALLEL_CALLS_UUID "uuid"
+#define SBCVAR_PARALLEL_CALLS_CLUSTER "cluster_counted"
 
 unsigned int CCParallelCalls::refuse_code = 402;
 string CCParallelCalls::refuse_reason = "Too Many Simultaneous Calls";
+string CCParallelCalls::cluster_sync_interface;
 
 CCParallelCalls::CCParallelCalls()
+  : cluster_sync(NULL)
 {
 }
 
@@ -64,9 +67,62 @@ int CCParallelCalls::onLoad() {
     }
   }
 
+  cluster_sync_interface = cfg.getParameter("cluster_sync_interface");
+  if (!cluster_sync_interface.empty()) {
+    AmDynInvokeFactory* di_f =
+      AmPlugIn::instance()->getFactory4Di(cluster_sync_interface);
+    if (NULL == di_f || NULL == (cluster_sync = di_f->getInstance())) {
+      ERROR("cluster sync interface '%s' not found - "
+	    "module loaded before " MOD_NAME "?\n",
+	    cluster_sync_interface.c_str());
+      return -1;
+    }
+    DBG("sharing call counts through '%s'\n", cluster_sync_interface.c_str());
+  }
+
   return 0;
 }
 
+bool CCParallelCalls::clusterInc(const string& uuid, unsigned int max_calls,
+				 bool& counted) {
+  counted = false;
+  if (NULL == cluster_sync)
+    return true;
+
+  AmArg di_args, ret;
+  di_args.push(uuid.c_str());
+  di_args.push((int)max_calls);
+  try {
+    cluster_sync->invoke("inc", di_args, ret);
+  } catch (...) {
+    // fail open: the local limit has already been enforced
+    ERROR("cluster sync 'inc' failed for uuid '%s'\n", uuid.c_str());
+    return true;
+  }
+
+  if (ret.size() && isArgInt(ret.get(0))) {
+    counted = ret.get(0).asInt() != 0;
+    return counted;
+  }
+
+  ERROR("unexpected result from cluster sync 'inc': %s\n",
+	AmArg::print(ret).c_str());
+  return true;
+}
+
+void CCParallelCalls::clusterDec(const string& uuid) {
+  if (NULL == cluster_sync)
+    return;
+
+  AmArg di_args, ret;
+  di_args.push(uuid.c_str());
+  try {
+    cluster_sync->invoke("dec", di_args, ret);
+  } catch (...) {
+    ERROR("cluster sync 'dec' failed for uuid '%s'\n", uuid.c_str());
+  }
+}
+
 void CCParallelCalls::invoke(const string& method, const AmArg& args, AmArg& ret)
 {
   // DBG("CCParallelCalls: %s(%s)\n", method.c_str(), AmArg::print(args).c_str());
@@ -92,10 +148,13 @@ void CCParallelCalls::invoke(const string& method, const AmArg& args, AmArg& ret
 
   } else if(method == CC_INTERFACE_MAND_VALUES_METHOD){
     ret.push("uuid");
+  } else if(method == "listCalls"){
+    call_control_calls.list(ret);
   } else if(method == "_list"){
     ret.push("start");
     ret.push("connect");
     ret.push("end");
+    ret.push("listCalls");
   }
   else
     throw AmDynInvoke::NotImplemented(method);
@@ -139,25 +198,20 @@ void CCParallelCalls::start(const string& cc_namespace,
   DBG("enforcing limit of %i calls for uuid '%s'\n", max_calls, uuid.c_str());
 
   bool do_limit = !max_calls;
-  unsigned int current_calls = 0;
+  int current_calls = 0;
   if (max_calls) {
-    call_control_calls_mut.lock();
-    map<string, unsigned int>::iterator it=call_control_calls.find(uuid);
-    if (it==call_control_calls.end()) {
-      call_control_calls[uuid] = current_calls = 1;
-    } else {
-      if (it->second < max_calls) {
-	it->second++;
-      } else {
-	do_limit = true;
-      }
-      current_calls = it->second;
+    do_limit = !call_control_calls.inc_below(uuid, max_calls, current_calls);
+    bool cluster_counted = false;
+    if (!do_limit && !clusterInc(uuid, max_calls, cluster_counted)) {
+      current_calls = call_control_calls.dec(uuid);
+      do_limit = true;
     }
+    // only what has been counted in the cluster is released in end()
+    if (cluster_counted)
+      call_profile->cc_vars[cc_namespace+"::"+SBCVAR_PARALLEL_CALLS_CLUSTER] = 1;
   }
 
-  call_control_calls_mut.unlock();
-
-  DBG("uuid %s has %u active calls (limit = %s)\n",
+  DBG("uuid %s has %i active calls (limit = %s)\n",
       uuid.c_str(), current_calls, do_limit?"true":"false");
 
   if (do_limit) {
@@ -187,17 +241,16 @@ void CCParallelCalls::end(const string& cc_namespace, const string& ltag,
   string uuid = vars_it->second.asCStr();
   call_profile->cc_vars.erase(cc_namespace+"::"+SBCVAR_PARALLEL_CALLS_UUID);
 
-  unsigned int new_call_count  = 0;
+  int new_call_count = call_control_calls.dec(uuid);
 
-  call_control_calls_mut.lock();
-  if (call_control_calls[uuid] > 1) {
-    new_call_count = --call_control_calls[uuid];
-  }  else {
-    call_control_calls.erase(uuid);
+  vars_it =
+    call_profile->cc_vars.find(cc_namespace+"::"+SBCVAR_PARALLEL_CALLS_CLUSTER);
+  if (vars_it != call_profile->cc_vars.end()) {
+    call_profile->cc_vars.erase(vars_it);
+    clusterDec(uuid);
   }
-  call_control_calls_mut.unlock();
 
-  DBG("uuid '%s' now has %u active calls\n", uuid.c_str(), new_call_count);
+  DBG("uuid '%s' now has %i active calls\n", uuid.c_str(), new_call_count);
 }
 
 CCParallelCalls* CCParallelCalls::_instance=0;
@@ -27,11 +27,9 @@
 #define _CC_TEMPLATE_H
 
 #include "AmApi.h"
-#include <map>
 
 #include "SBCCallProfile.h"
-
-using std::map;
+#include "CallCounterTable.h"
 
 /**
  * call control module limiting parallel number of calls
@@ -41,9 +39,19 @@ class CCParallelCalls : public AmDynInvoke
   static unsigned int refuse_code;
   static string refuse_reason;
 
-  // this map contains # of calls per uuid
-  map<string, unsigned int> call_control_calls;
-  AmMutex call_control_calls_mut;
+  // # of calls per uuid
+  CallCounterTable call_control_calls;
+
+  /** DI interface of the cluster sync backend (optional) */
+  static string cluster_sync_interface;
+  AmDynInvoke* cluster_sync;
+
+  /**
+   * @param counted set if the cluster counter was incremented
+   * @return false if the cluster-wide limit is reached
+   */
+  bool clusterInc(const string& uuid, unsigned int max_calls, bool& counted);
+  void clusterDec(const string& uuid);
 
   static CCParallelCalls* _instance;
 
@@ -282,47 +282,23 @@ void Prepaid::end(const string& cc_name,
 
 /* accounting functions... */
 int Prepaid::getCredit(string pin, bool& found) {
-  credits_mut.lock();
-  std::map<string, unsigned int>::iterator it =  credits.find(pin);
-  if (it == credits.end()) {
-    found = false;
-    credits_mut.unlock();
+  int res = 0;
+  found = credits.get(pin, res);
+  if (!found) {
     DBG("PIN '%s' does not exist.\n", pin.c_str());
     return 0;
   }
-  unsigned int res = it->second;
-  credits_mut.unlock();
-  found = true;
   return res;
 }
 
 int Prepaid::setCredit(string pin, int amount) {
-  credits_mut.lock();
-  credits[pin] = amount;
-  credits_mut.unlock();
-  return amount;
+  return credits.set(pin, amount);
 }
 
 int Prepaid::addCredit(string pin, int amount) {
-  credits_mut.lock();
-  int res = (credits[pin] += amount);
-  credits_mut.unlock();
-  return res;
+  return credits.add(pin, amount);
 }
 
 int Prepaid::subtractCredit(string pin, int amount, bool& found) {
-  credits_mut.lock();
-  std::map<string, unsigned int>::iterator it =  credits.find(pin);
-  if (it == credits.end()) {
-    credits[pin] = -amount;
-    credits_mut.unlock();
-    found = false;
-    return -amount;
-  }
-  credits[pin] = it->second - amount;
-  int res =  credits[pin];
-  credits_mut.unlock();
-  found = true;
-  return res;
+  return credits.add(pin, -amount, found);
 }
-
@@ -29,8 +29,7 @@
 #include "AmApi.h"
 
 #include "SBCCallProfile.h"
-
-#include <map>
+#include "CallCounterTable.h"
 
 /**
  * sample call control module
@@ -39,8 +38,7 @@ class Prepaid : public AmDynInvoke
 {
   static Prepaid* _instance;
 
-  std::map<string, unsigned int> credits;
-  AmMutex credits_mut;
+  CallCounterTable credits;
 
 
   /** @returns credit for pin, found=false if pin wrong */
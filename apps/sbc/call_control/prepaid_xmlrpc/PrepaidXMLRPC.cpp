@@ -32,9 +32,7 @@
 
 #include "SBCCallControlAPI.h"
 
-#include "XmlRpc.h"
-#include "XmlRpcClient.h"
-using namespace XmlRpc;
+#include "TOXmlRpcClient.h"
 
 #include <string.h>
 
@@ -72,7 +70,7 @@ PrepaidXMLRPC* PrepaidXMLRPC::instance()
 }
 
 PrepaidXMLRPC::PrepaidXMLRPC()
-  : serverAddress("localhost"), port(8000), uri("")
+  : serverAddress("localhost"), port(8000), uri(""), timeout(5.0)
 {
 }
 
@@ -93,6 +91,8 @@ int PrepaidXMLRPC::onLoad() {
   serverAddress = cfg.getParameter("server_address", serverAddress);
   port = cfg.getParameterInt("server_port", port);
   uri = cfg.getParameter("server_uri", uri);
+  if (cfg.hasParameter("server_timeout"))
+    timeout = atof(cfg.getParameter("server_timeout").c_str());
   INFO("using accounting XMLRPC server %s:%i/%s\n",
        serverAddress.c_str(), port, uri.c_str());
   return 0;
@@ -275,42 +275,38 @@ void PrepaidXMLRPC::end(const string& cc_name, const string& ltag,
 }
 
 /* accounting functions... */
-int PrepaidXMLRPC::getCredit(string pin, bool& found) {
-
-  const char* _uri = 0;
-  if (!uri.empty())
-    _uri = uri.c_str();
+bool PrepaidXMLRPC::execute(const char* method, const AmArg& params, int& res) {
+  TOXmlRpcClient xmlrpccall(serverAddress, port, uri);
+  AmArg result;
+  if (!xmlrpccall.execute(method, params, result, timeout) ||
+      xmlrpccall.isFault() || !isArgInt(result)) {
+    DBG("XMLRPC %s at %s:%u failed\n", method, serverAddress.c_str(), port);
+    return false;
+  }
+  res = result.asInt();
+  return true;
+}
 
-  XmlRpcClient xmlrpccall(serverAddress.c_str(), port, _uri, false);
-  XmlRpcValue result;
-  XmlRpcValue xmlArg;
-  xmlArg[0] = pin;
-  found = xmlrpccall.execute("getCredit", xmlArg, result);
+int PrepaidXMLRPC::getCredit(string pin, bool& found) {
+  AmArg xmlArg;
+  xmlArg.push(pin);
   int res = 0;
-  if (found)
-    res = result;
+  found = execute("getCredit", xmlArg, res);
   DBG("Credit Left '%u' .\n", res);
   return res;
 }
 
 int PrepaidXMLRPC::subtractCredit(string pin, int amount, bool& found) {
-  const char* _uri = 0;
-  if (!uri.empty())
-    _uri = uri.c_str();
-
-  XmlRpcClient xmlrpccall(serverAddress.c_str(), port, _uri, false);
-  XmlRpcValue result;
-  XmlRpcValue xmlArg;
-  xmlArg[0][0]["methodName"] = "subtractCredit";
-  xmlArg[0][0]["pin"] = pin;
-  xmlArg[0][0]["amount"] = amount;	
-  DBG("subtractCredit pin# '%s', Seconds '%u'.\n", pin.c_str(),  
-amount );
-  found = xmlrpccall.execute("subtractCredit", xmlArg, result);
+  AmArg req;
+  req["methodName"] = "subtractCredit";
+  req["pin"] = pin;
+  req["amount"] = amount;
+  AmArg xmlArg;
+  xmlArg.push(AmArg());
+  xmlArg.get(0).push(req);
+  DBG("subtractCredit pin# '%s', Seconds '%u'.\n", pin.c_str(), amount);
   int res = 0;
-  if (found)
-    res = result;
+  found = execute("subtractCredit", xmlArg, res);
   DBG("Credit Left '%u' .\n", res);
   return res;
 }
-
@@ -42,11 +42,16 @@ class PrepaidXMLRPC : public AmDynInvoke
   string serverAddress;
   unsigned int port;
   string uri;
+  /** seconds */
+  double timeout;
 
   std::map<string, unsigned int> credits;
   AmMutex credits_mut;
 
 
+  /** call method with params, expecting an int result */
+  bool execute(const char* method, const AmArg& params, int& res);
+
   /** @returns credit for pin, found=false if pin wrong */
   int getCredit(string pin, bool& found);
   /** @returns remaining credit */
@@ -23,6 +23,10 @@ public:
   CCSiprecFactory(const string& name)
     : AmDynInvokeFactory(name) {}
 
+  ~CCSiprecFactory() {
+    SrsCounters::dispose();
+  }
+
   AmDynInvoke* getInstance() {
     return CCSiprec::instance();
   }
@@ -114,6 +118,15 @@ int CCSiprec::onLoad() {
   if (!port_max_str.empty()) rtp_port_max = (unsigned short)atoi(port_max_str.c_str());
   SiprecPortAllocator::configure(rtp_port_min, rtp_port_max);
 
+  // Forked RTP: queue per RTP receiver thread and send with sendmmsg()
+  string fwd_mode = cfg.getParameter("rtp_forward_mode", "batch");
+  if (fwd_mode != "batch" && fwd_mode != "direct") {
+    WARN("SIPREC: unknown rtp_forward_mode '%s', using 'batch'\n",
+         fwd_mode.c_str());
+    fwd_mode = "batch";
+  }
+  RtpForwarder::setBatching(fwd_mode == "batch");
+
   if (srs_uri_.empty()) {
     ERROR("SIPREC: srs_uri is not configured in cc_siprec.conf\n");
     return -1;
@@ -168,11 +181,15 @@ void CCSiprec::invoke(const string& method, const AmArg& args, AmArg& ret) {
   } else if (method == "getExtendedInterfaceHandler") {
     ret.push((AmObject*)this);
 
+  } else if (method == "getStats") {
+    SrsCounters::getAll(ret);
+
   } else if (method == "_list") {
     ret.push("start");
     ret.push("connect");
     ret.push("end");
     ret.push("route");
+    ret.push("getStats");
 
   } else {
     throw AmDynInvoke::NotImplemented(method);
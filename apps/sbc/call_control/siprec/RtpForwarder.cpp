@@ -7,12 +7,217 @@
 
 #include "RtpForwarder.h"
 #include "AmRtpPacket.h"
+#include "AmRtpReceiver.h"
 #include "log.h"
 #include "sip/ip_util.h"
 
+#include <event2/event.h>
+
+#include <sys/uio.h>
 #include <unistd.h>
 #include <cstring>
 #include <errno.h>
+#include <map>
+
+// max. forked packets queued per RTP receiver thread
+#define FWD_BATCH_SIZE    32
+// larger packets are sent directly
+#define FWD_BATCH_MAX_PKT 2048
+
+// --- SrsCounters ---
+
+static std::map<string, SrsCounters*> srs_counters;
+static AmMutex srs_counters_mut;
+
+SrsCounters* SrsCounters::get(const string& dest_ip) {
+  AmLock lock(srs_counters_mut);
+  SrsCounters*& c = srs_counters[dest_ip];
+  if (!c) {
+    c = new SrsCounters();
+    inc_ref(c);
+  }
+  inc_ref(c);
+  return c;
+}
+
+void SrsCounters::dispose() {
+  AmLock lock(srs_counters_mut);
+  for (std::map<string, SrsCounters*>::iterator it = srs_counters.begin();
+       it != srs_counters.end(); ++it)
+    dec_ref(it->second);
+  srs_counters.clear();
+}
+
+void SrsCounters::getAll(AmArg& ret) {
+  ret.assertStruct();
+  AmLock lock(srs_counters_mut);
+  for (std::map<string, SrsCounters*>::iterator it = srs_counters.begin();
+       it != srs_counters.end(); ++it) {
+    AmArg& c = ret[it->first];
+    c["packets"] = (long long int)it->second->packets.load();
+    c["bytes"] = (long long int)it->second->bytes.load();
+    c["drops"] = (long long int)it->second->drops.load();
+  }
+}
+
+ForwarderSocket::~ForwarderSocket() {
+  if (sd >= 0) close(sd);
+}
+
+// --- per RTP receiver thread batch ---
+
+/** Forked packets queued in one RTP receiver thread.
+ *  Flushed from an event activated when the first packet is queued;
+ *  libevent runs it after the read events already pending in this
+ *  loop iteration, i.e. once per receive cycle. */
+class RtpForwardBatch {
+  struct Entry {
+    ForwarderSocket* sock;
+    SrsCounters* counters;
+    struct sockaddr_storage dest;
+    socklen_t dest_len;
+    unsigned int len;
+    unsigned char buf[FWD_BATCH_MAX_PKT];
+  };
+
+  Entry entries_[FWD_BATCH_SIZE];
+  unsigned int n_;
+  struct event* ev_flush_;
+
+  static void flush_cb(evutil_socket_t sd, short what, void* arg) {
+    static_cast<RtpForwardBatch*>(arg)->flush();
+  }
+
+  void sendAll(ForwarderSocket* sock, unsigned int first, bool* done);
+
+public:
+  RtpForwardBatch(struct event_base* evbase)
+    : n_(0) {
+    ev_flush_ = event_new(evbase, -1, 0, flush_cb, this);
+  }
+
+  ~RtpForwardBatch() {
+    flush();
+    if (ev_flush_) event_free(ev_flush_);
+  }
+
+  bool add(ForwarderSocket* sock, SrsCounters* counters,
+           const struct sockaddr_storage& dest, socklen_t dest_len,
+           const unsigned char* buf, unsigned int len);
+  void flush();
+};
+
+static AmThreadLocalStorage<RtpForwardBatch> fwd_batch;
+
+bool RtpForwardBatch::add(ForwarderSocket* sock, SrsCounters* counters,
+                          const struct sockaddr_storage& dest,
+                          socklen_t dest_len,
+                          const unsigned char* buf, unsigned int len) {
+  if (!ev_flush_ || len > FWD_BATCH_MAX_PKT)
+    return false;
+
+  if (n_ == FWD_BATCH_SIZE)
+    flush();
+
+  Entry& e = entries_[n_];
+  inc_ref(sock);
+  e.sock = sock;
+  inc_ref(counters);
+  e.counters = counters;
+  memcpy(&e.dest, &dest, dest_len);
+  e.dest_len = dest_len;
+  e.len = len;
+  memcpy(e.buf, buf, len);
+
+  if (!n_++)
+    event_active(ev_flush_, 0, 0);
+
+  return true;
+}
+
+/** send all queued entries for one socket with as few syscalls as possible */
+void RtpForwardBatch::sendAll(ForwarderSocket* sock, unsigned int first,
+                              bool* done) {
+  struct iovec iov[FWD_BATCH_SIZE];
+  unsigned int idx[FWD_BATCH_SIZE];
+  unsigned int m = 0;
+
+#ifdef __linux__
+  struct mmsghdr msgs[FWD_BATCH_SIZE];
+  memset(msgs, 0, sizeof(msgs));
+#endif
+
+  for (unsigned int i = first; i < n_; i++) {
+    if (done[i] || entries_[i].sock != sock) continue;
+    done[i] = true;
+
+    Entry& e = entries_[i];
+    iov[m].iov_base = e.buf;
+    iov[m].iov_len = e.len;
+#ifdef __linux__
+    msgs[m].msg_hdr.msg_name = &e.dest;
+    msgs[m].msg_hdr.msg_namelen = e.dest_len;
+    msgs[m].msg_hdr.msg_iov = &iov[m];
+    msgs[m].msg_hdr.msg_iovlen = 1;
+#endif
+    idx[m++] = i;
+  }
+
+  unsigned int sent = 0;
+#ifdef __linux__
+  while (sent < m) {
+    int ret = sendmmsg(sock->sd, msgs + sent, m - sent, MSG_DONTWAIT);
+    if (ret <= 0) {
+      if (ret < 0 && errno == EINTR) continue;
+      break;
+    }
+    sent += ret;
+  }
+#else
+  for (; sent < m; sent++) {
+    Entry& e = entries_[idx[sent]];
+    if (::sendto(sock->sd, e.buf, e.len, MSG_DONTWAIT,
+                 (struct sockaddr*)&e.dest, e.dest_len) < 0)
+      break;
+  }
+#endif
+
+  for (unsigned int k = 0; k < m; k++) {
+    Entry& e = entries_[idx[k]];
+    if (k < sent) {
+      e.counters->packets++;
+      e.counters->bytes += e.len;
+    } else {
+      e.counters->drops++;
+    }
+  }
+
+  if (sent < m) {
+    static std::atomic<unsigned int> err_count(0);
+    if (err_count++ % 1000 == 0) {
+      ERROR("SIPREC RtpForwarder: sending %u forked packets failed: %s\n",
+            m - sent, strerror(errno));
+    }
+  }
+}
+
+void RtpForwardBatch::flush() {
+  if (!n_) return;
+
+  bool done[FWD_BATCH_SIZE];
+  memset(done, 0, sizeof(done));
+
+  for (unsigned int i = 0; i < n_; i++) {
+    if (!done[i])
+      sendAll(entries_[i].sock, i, done);
+  }
+
+  for (unsigned int i = 0; i < n_; i++) {
+    dec_ref(entries_[i].sock);
+    dec_ref(entries_[i].counters);
+  }
+  n_ = 0;
+}
 
 // --- SiprecPortAllocator ---
 
@@ -49,22 +254,34 @@ unsigned short SiprecPortAllocator::allocate() {
 
 // --- RtpForwarder ---
 
+bool RtpForwarder::batching_ = true;
+
 RtpForwarder::RtpForwarder()
-  : sd_(-1), rtcp_sd_(-1), local_port_(0), active_(false)
+  : sock_(NULL), rtcp_sd_(-1), dest_len_(0), local_port_(0), active_(false),
+    counters_(NULL)
 {
   memset(&dest_, 0, sizeof(dest_));
 }
 
 RtpForwarder::~RtpForwarder() {
   stop();
-  if (sd_ >= 0) {
-    close(sd_);
-    sd_ = -1;
+  release();
+}
+
+void RtpForwarder::release() {
+  if (sock_) {
+    // closed once no queued packet refers to it anymore
+    dec_ref(sock_);
+    sock_ = NULL;
   }
   if (rtcp_sd_ >= 0) {
     close(rtcp_sd_);
     rtcp_sd_ = -1;
   }
+  if (counters_) {
+    dec_ref(counters_);
+    counters_ = NULL;
+  }
 }
 
 static int create_and_bind_udp(const string& local_ip, unsigned short port, int af) {
@@ -124,19 +341,33 @@ int RtpForwarder::init(const string& local_ip, unsigned short local_port,
     return -1;
   }
 
+  if (active_.load()) {
+    ERROR("SIPREC RtpForwarder: init() while forwarding\n");
+    return -1;
+  }
+  // re-init: don't leak the sockets of the previous one
+  release();
+
   // Parse destination address
   if (am_inet_pton(dest_ip.c_str(), &dest_) != 1) {
     ERROR("SIPREC RtpForwarder: invalid SRS IP '%s'\n", dest_ip.c_str());
     return -1;
   }
   am_set_port(&dest_, dest_port);
+  dest_len_ = (dest_.ss_family == AF_INET)
+    ? sizeof(struct sockaddr_in)
+    : sizeof(struct sockaddr_in6);
 
   int af = dest_.ss_family;
   local_port_ = local_port;
 
   // Create and bind RTP socket to local port (symmetric RTP - RFC 7866 8.1.8)
-  sd_ = create_and_bind_udp(local_ip, local_port, af);
-  if (sd_ < 0) return -1;
+  int sd = create_and_bind_udp(local_ip, local_port, af);
+  if (sd < 0) return -1;
+  sock_ = new ForwarderSocket(sd);
+  inc_ref(sock_);
+
+  counters_ = SrsCounters::get(dest_ip);
 
   // Create and bind RTCP socket on port+1 (RFC 7866 8.1.1 - RTCP REQUIRED)
   rtcp_sd_ = create_and_bind_udp(local_ip, local_port + 1, af);
@@ -162,22 +393,43 @@ void RtpForwarder::stop() {
   DBG("SIPREC RtpForwarder: stopped\n");
 }
 
-void RtpForwarder::sendPacket(AmRtpPacket* p) {
-  if (!active_.load() || sd_ < 0 || !p)
+void RtpForwarder::sendDirect(const unsigned char* buf, unsigned int len) {
+  ssize_t ret = ::sendto(sock_->sd, buf, len, 0,
+                         (struct sockaddr*)&dest_, dest_len_);
+  if (ret < 0) {
+    counters_->drops++;
+    // Don't flood logs - only log occasionally
+    static std::atomic<unsigned int> err_count(0);
+    unsigned int n = ++err_count;
+    if (n % 1000 == 1) {
+      ERROR("SIPREC RtpForwarder: sendto() failed: %s (error #%u)\n",
+            strerror(errno), n);
+    }
     return;
+  }
 
-  socklen_t addr_len = (dest_.ss_family == AF_INET)
-    ? sizeof(struct sockaddr_in)
-    : sizeof(struct sockaddr_in6);
+  counters_->packets++;
+  counters_->bytes += len;
+}
 
-  ssize_t ret = ::sendto(sd_, p->getBuffer(), p->getBufferSize(), 0,
-                         (struct sockaddr*)&dest_, addr_len);
-  if (ret < 0) {
-    // Don't flood logs - only log occasionally
-    static int err_count = 0;
-    if (++err_count % 1000 == 1) {
-      ERROR("SIPREC RtpForwarder: sendto() failed: %s (error #%d)\n",
-            strerror(errno), err_count);
+void RtpForwarder::sendPacket(AmRtpPacket* p) {
+  if (!active_.load() || !sock_ || !p)
+    return;
+
+  if (batching_) {
+    RtpForwardBatch* batch = fwd_batch.get();
+    if (!batch) {
+      struct event_base* evbase = AmRtpReceiver::instance()->getCurrentEventBase();
+      if (evbase) {
+        batch = new RtpForwardBatch(evbase);
+        fwd_batch.set(batch);
+      }
     }
+
+    if (batch && batch->add(sock_, counters_, dest_, dest_len_,
+                            p->getBuffer(), p->getBufferSize()))
+      return;
   }
+
+  sendDirect(p->getBuffer(), p->getBufferSize());
 }
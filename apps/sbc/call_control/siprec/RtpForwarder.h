@@ -2,9 +2,13 @@
  * RTP stream forwarder for SIPREC recording.
  *
  * Forwards (forks) RTP packets to the Session Recording Server
- * via raw UDP sendto(). Designed to be called from the RTP receiver
+ * via raw UDP. Designed to be called from the RTP receiver
  * thread (non-blocking, no allocation).
  *
+ * In batch mode, forked packets are queued per RTP receiver thread and
+ * sent with sendmmsg() once the receiver has processed the currently
+ * pending read events, instead of one sendto() per packet.
+ *
  * Binds to a known local port for symmetric RTP (RFC 7866 Section 8.1.8)
  * and opens an RTCP socket on port+1 (RFC 7866 Section 8.1.1).
  */
@@ -13,6 +17,8 @@
 #define _RTP_FORWARDER_H
 
 #include "AmThread.h"
+#include "AmArg.h"
+#include "atomic_types.h"
 
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -41,14 +47,51 @@ public:
   static unsigned short allocate();
 };
 
+/** Packet/byte/drop counters per SRS destination address.
+ *  Ref-counted: held by the table, the forwarders and queued packets. */
+struct SrsCounters : public atomic_ref_cnt {
+  std::atomic<unsigned long long> packets;
+  std::atomic<unsigned long long> bytes;
+  std::atomic<unsigned long long> drops;
+
+  SrsCounters() : packets(0), bytes(0), drops(0) {}
+
+  /** Counters for an SRS IP (created on first use),
+   *  with a reference for the caller */
+  static SrsCounters* get(const string& dest_ip);
+  /** Dump all counters as struct dest_ip -> {packets, bytes, drops} */
+  static void getAll(AmArg& ret);
+  /** Release the table's references (module unload) */
+  static void dispose();
+};
+
+/** RTP socket, kept open while packets sent on it are still queued */
+class ForwarderSocket : public atomic_ref_cnt {
+public:
+  int sd;
+  ForwarderSocket(int sd) : sd(sd) {}
+  ~ForwarderSocket();
+};
+
 class RtpForwarder {
-  int sd_;                        // RTP UDP socket descriptor
+  ForwarderSocket* sock_;         // RTP UDP socket (ref-counted)
   int rtcp_sd_;                   // RTCP UDP socket descriptor (port+1)
   struct sockaddr_storage dest_;  // SRS destination address (RTP)
+  socklen_t dest_len_;
   unsigned short local_port_;     // local RTP port (for symmetric RTP)
   std::atomic<bool> active_;
+  SrsCounters* counters_;
+
+  static bool batching_;
+
+  /** release sockets and counters of a previous init() */
+  void release();
+  void sendDirect(const unsigned char* buf, unsigned int len);
 
 public:
+  /** Enable queueing forked packets per RTP receiver thread */
+  static void setBatching(bool enable) { batching_ = enable; }
+
   RtpForwarder();
   ~RtpForwarder();
 
@@ -0,0 +1,325 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "CDRWriter.h"
+#include "sip/async_file_writer.h"
+#include "log.h"
+#include "AmUtils.h"
+
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <syslog.h>
+
+#include <event2/event.h>
+
+// files opened within the same second: <timestamp>-<n>.csv
+#define MAX_FILE_SEQ 1000
+
+CDRWriter::CDRWriter(unsigned int buffer_size)
+  : async_file(buffer_size),
+    rotate_size(0), rotate_interval(0), fsync_policy(FsyncRotate),
+    fd(-1), file_size(0), file_opened(0), at_record_start(true),
+    syslog_level(LOG_INFO),
+    flush_interval_ms(0), ev_flush(NULL), flushed(false), orphaned(false)
+{
+}
+
+CDRWriter::~CDRWriter()
+{
+  if (ev_flush)
+    event_free(ev_flush);
+  closeFile();
+}
+
+void CDRWriter::setFileOutput(const string& _dir, const string& prefix,
+			      unsigned long long _rotate_size,
+			      unsigned int _rotate_interval,
+			      FsyncPolicy _fsync_policy)
+{
+  dir = _dir;
+  file_prefix = prefix;
+  rotate_size = _rotate_size;
+  rotate_interval = _rotate_interval;
+  fsync_policy = _fsync_policy;
+}
+
+void CDRWriter::setSyslogOutput(int level, const string& prefix)
+{
+  dir.clear();
+  syslog_level = level;
+  syslog_prefix = prefix;
+}
+
+int CDRWriter::start(unsigned int _flush_interval_ms)
+{
+  flush_interval_ms = _flush_interval_ms;
+  if (!flush_interval_ms)
+    return 0;
+
+  struct event_base* evbase = async_file_writer::instance()->get_evbase();
+  if (!evbase) {
+    ERROR("async file writer not available\n");
+    return -1;
+  }
+
+  ev_flush = event_new(evbase, -1, EV_PERSIST, flush_cb, this);
+  if (!ev_flush) {
+    ERROR("event_new() failed\n");
+    return -1;
+  }
+
+  struct timeval tv;
+  tv.tv_sec = flush_interval_ms / 1000;
+  tv.tv_usec = (flush_interval_ms % 1000) * 1000;
+  event_add(ev_flush, &tv);
+  return 0;
+}
+
+bool CDRWriter::stop(unsigned int timeout_ms)
+{
+  if (ev_flush)
+    event_del(ev_flush);
+
+  // retry once more what failed before
+  clear_error();
+  close();
+
+  if (!flushed.wait_for_to(timeout_ms)) {
+    // on_flushed() runs under the lock
+    lock();
+    if (!flushed.get()) {
+      orphaned = true;
+      ERROR("CDR writer not finished after %u ms, %u bytes of CDRs left; "
+	    "it is deleted when finished\n", timeout_ms, get_buffered_bytes());
+      unlock();
+      return false;
+    }
+    unlock();
+  }
+  return true;
+}
+
+bool CDRWriter::write(const string& cdr)
+{
+  struct iovec iov[2];
+  iov[0].iov_base = (void*)cdr.c_str();
+  iov[0].iov_len = cdr.length();
+  iov[1].iov_base = (void*)"\n";
+  iov[1].iov_len = 1;
+
+  if (async_file::writev(iov, 2) < 0) {
+    cdrs_overflow.inc();
+    return false;
+  }
+
+  cdrs_queued.inc();
+  return true;
+}
+
+void CDRWriter::flush_cb(int sd, short what, void* ctx)
+{
+  ((CDRWriter*)ctx)->on_flush_timer();
+}
+
+void CDRWriter::delete_cb(int sd, short what, void* ctx)
+{
+  delete (CDRWriter*)ctx;
+}
+
+void CDRWriter::on_flush_timer()
+{
+  // close files that are due even if no new CDRs arrive,
+  // so that they can be picked up by the collector
+  if (fd >= 0 && at_record_start && rotationDue(time(NULL))) {
+    closeFile();
+    files_rotated.inc();
+  }
+
+  // after a write error, try again with a newly opened file
+  if (clear_error()) {
+    closeFile();
+    DBG("retrying to write CDRs after write error\n");
+  }
+
+  flush();
+}
+
+bool CDRWriter::rotationDue(time_t now)
+{
+  if (rotate_size && file_size >= rotate_size)
+    return true;
+  if (rotate_interval && file_size &&
+      (now - file_opened) >= (time_t)rotate_interval)
+    return true;
+  return false;
+}
+
+int CDRWriter::openFile()
+{
+  file_opened = time(NULL);
+
+  struct tm t;
+  char ts[32];
+  localtime_r(&file_opened, &t);
+  strftime(ts, sizeof(ts), "%Y%m%d-%H%M%S", &t);
+
+  // always a new file, also if rotated within the same second
+  string base = dir + "/" + file_prefix + "-" + ts;
+  string fname = base + ".csv";
+  for (unsigned int seq = 1; ; seq++) {
+    fd = ::open(fname.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_APPEND,
+		S_IRUSR | S_IWUSR | S_IRGRP);
+    if (fd >= 0 || errno != EEXIST || seq > MAX_FILE_SEQ)
+      break;
+    fname = base + "-" + int2str(seq) + ".csv";
+  }
+  if (fd < 0) {
+    ERROR("could not open CDR file '%s': %s\n", fname.c_str(), strerror(errno));
+    return -1;
+  }
+
+  file_size = 0;
+  DBG("writing CDRs to '%s'\n", fname.c_str());
+  return 0;
+}
+
+void CDRWriter::closeFile()
+{
+  if (fd < 0)
+    return;
+
+  if (fsync_policy != FsyncNever)
+    fsync(fd);
+
+  ::close(fd);
+  fd = -1;
+  file_size = 0;
+}
+
+int CDRWriter::writeSyslog(const char* buf, unsigned int len)
+{
+  const char* end = buf + len;
+  const char* p = buf;
+
+  while (p < end) {
+    const char* eol = (const char*)memchr(p, '\n', end - p);
+    if (!eol) {
+      partial.append(p, end - p);
+      break;
+    }
+
+    if (!partial.empty()) {
+      partial.append(p, eol - p);
+      syslog(syslog_level, "%s%s", syslog_prefix.c_str(), partial.c_str());
+      partial.clear();
+    } else {
+      syslog(syslog_level, "%s%.*s", syslog_prefix.c_str(), (int)(eol - p), p);
+    }
+    p = eol + 1;
+  }
+
+  bytes_written.inc(len);
+  return len;
+}
+
+int CDRWriter::write_to_file(const void* buf, unsigned int len)
+{
+  if (dir.empty())
+    return writeSyslog((const char*)buf, len);
+
+  if (fd >= 0 && at_record_start && rotationDue(time(NULL))) {
+    closeFile();
+    files_rotated.inc();
+  }
+
+  if (fd < 0 && openFile() < 0) {
+    write_errors.inc();
+    return -1;
+  }
+
+  int res = 0;
+  int retries = 0;
+  do {
+    res = ::write(fd, buf, len);
+  } while ((res < 0) && (errno == EINTR) && (++retries < 10));
+
+  if (res < 0) {
+    ERROR("writing CDRs: %s\n", strerror(errno));
+    write_errors.inc();
+    return -1;
+  }
+
+  if (res > 0)
+    at_record_start = ((const char*)buf)[res-1] == '\n';
+
+  file_size += res;
+  bytes_written.inc(res);
+
+  if (fsync_policy == FsyncAlways)
+    fdatasync(fd);
+
+  return res;
+}
+
+void CDRWriter::on_flushed()
+{
+  // the file could not be written: don't lose the rest of the CDRs
+  if (!dir.empty()) {
+    int read_bs;
+    while ((read_bs = get_read_bs()) > 0) {
+      ERROR("writing %d bytes of CDRs to syslog instead\n", read_bs);
+      writeSyslog((const char*)get_read_ptr(), read_bs);
+      skip(read_bs);
+    }
+  }
+
+  if (!partial.empty()) {
+    syslog(syslog_level, "%s%s", syslog_prefix.c_str(), partial.c_str());
+    partial.clear();
+  }
+  closeFile();
+  flushed.set(true);
+
+  if (orphaned) {
+    // not from within write_cycle(), it still uses this object
+    struct timeval tv = { 0, 0 };
+    event_base_once(async_file_writer::instance()->get_evbase(), -1, EV_TIMEOUT,
+		    delete_cb, this, &tv);
+  }
+}
+
+void CDRWriter::getStats(AmArg& ret)
+{
+  ret["queued"] = (long int)cdrs_queued.get();
+  ret["overflow"] = (long int)cdrs_overflow.get();
+  ret["bytes_written"] = (long int)bytes_written.get();
+  ret["write_errors"] = (long int)write_errors.get();
+  ret["files_rotated"] = (long int)files_rotated.get();
+  ret["buffered_bytes"] = (int)get_buffered_bytes();
+}
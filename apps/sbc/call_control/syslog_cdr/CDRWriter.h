@@ -0,0 +1,135 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _CDR_WRITER_H
+#define _CDR_WRITER_H
+
+#include "sip/async_file.h"
+#include "atomic_types.h"
+#include "AmArg.h"
+#include "AmThread.h"
+
+#include <string>
+using std::string;
+
+#include <time.h>
+
+/**
+ * Asynchronous CDR writer.
+ *
+ * CDR lines are appended to a buffer from the call leg threads; the
+ * async_file_writer thread drains the buffer in large chunks, either
+ * into rotating local files or into syslog.
+ */
+class CDRWriter
+  : public async_file
+{
+public:
+  enum FsyncPolicy {
+    FsyncNever=0,
+    FsyncRotate,   // fsync before a file is closed
+    FsyncAlways    // fsync after every write
+  };
+
+private:
+  // file output; if dir is empty, CDRs are written to syslog
+  string dir;
+  string file_prefix;
+  unsigned long long rotate_size;
+  unsigned int rotate_interval;
+  FsyncPolicy fsync_policy;
+
+  int fd;
+  unsigned long long file_size;
+  time_t file_opened;
+  bool at_record_start;
+
+  // syslog output
+  int syslog_level;
+  string syslog_prefix;
+  // record split by the buffer wrap-around
+  string partial;
+
+  unsigned int flush_interval_ms;
+  struct event* ev_flush;
+
+  // set by on_flushed() after close()
+  AmCondition<bool> flushed;
+  // given up by stop(): deleted by the writer thread when flushed
+  bool orphaned;
+
+  atomic_int64 cdrs_queued;
+  atomic_int64 cdrs_overflow;
+  atomic_int64 bytes_written;
+  atomic_int64 write_errors;
+  atomic_int64 files_rotated;
+
+  static void flush_cb(int sd, short what, void* ctx);
+  static void delete_cb(int sd, short what, void* ctx);
+  void on_flush_timer();
+
+  int openFile();
+  void closeFile();
+  bool rotationDue(time_t now);
+
+  int writeSyslog(const char* buf, unsigned int len);
+
+protected:
+  // async_file API (executed in async_file_writer thread)
+  int write_to_file(const void* buf, unsigned int len);
+  void on_flushed();
+
+public:
+  CDRWriter(unsigned int buffer_size);
+  ~CDRWriter();
+
+  /** log to rotating files <dir>/<prefix>-<timestamp>[-<n>].csv */
+  void setFileOutput(const string& dir, const string& prefix,
+		     unsigned long long rotate_size, unsigned int rotate_interval,
+		     FsyncPolicy fsync_policy);
+  /** log to syslog (from the writer thread) */
+  void setSyslogOutput(int level, const string& prefix);
+
+  /** start the periodic flush timer */
+  int start(unsigned int flush_interval_ms);
+
+  /**
+   * Write out the queued CDRs and close the output.
+   * @return false if not finished within timeout_ms; the writer
+   *         thread then deletes the writer when it is finished, it
+   *         must not be used or deleted any more
+   */
+  bool stop(unsigned int timeout_ms);
+
+  /**
+   * Queue a CDR line (without trailing newline).
+   * @return false if the buffer is full
+   */
+  bool write(const string& cdr);
+
+  void getStats(AmArg& ret);
+};
+
+#endif
@@ -43,6 +43,13 @@
 #define DISPOSITION "disposition"
 #define DST_IP "destination_ip"
 
+#define DEFAULT_CDR_BUFFER_SIZE   (4*1024*1024) /* 4 MB */
+#define MIN_CDR_BUFFER_SIZE       (256*1024)
+#define DEFAULT_FLUSH_INTERVAL_MS 1000
+
+static const int log2syslog_level[] = { LOG_ERR, LOG_WARNING, LOG_INFO,
+					LOG_DEBUG, LOG_NOTICE };
+
 
 struct HangupCause: public B2BEvent
 {
@@ -61,6 +68,10 @@ public:
 	return SyslogCDR::instance();
     }
 
+    ~SyslogCDRFactory(){
+      SyslogCDR::dispose();
+    }
+
     int onLoad(){
       DBG(" syslog CSV CDR generation loaded.\n");
 
@@ -83,11 +94,25 @@ SyslogCDR* SyslogCDR::instance()
 }
 
 SyslogCDR::SyslogCDR()
-  : level(2), syslog_prefix("CDR: "), quoting_enabled(true)
+  : level(2), syslog_prefix("CDR: "), quoting_enabled(true), writer(NULL)
 {
 }
 
-SyslogCDR::~SyslogCDR() { }
+SyslogCDR::~SyslogCDR()
+{
+  // if not finished, the writer thread still uses the writer
+  // and deletes it when done
+  if (writer && writer->stop(WRITER_STOP_TIMEOUT_MS))
+    delete writer;
+}
+
+void SyslogCDR::dispose()
+{
+  if (_instance) {
+    delete _instance;
+    _instance = NULL;
+  }
+}
 
 int SyslogCDR::onLoad() {
   AmConfigReader cfg;
@@ -117,6 +142,61 @@ int SyslogCDR::onLoad() {
     level = 4;
   }
 
+  return initWriter(cfg);
+}
+
+int SyslogCDR::initWriter(AmConfigReader& cfg) {
+  string mode = cfg.getParameter("cdr_writer", "sync");
+  if (mode == "sync")
+    return 0;
+
+  if (mode != "async_syslog" && mode != "file") {
+    ERROR("unknown cdr_writer '%s'\n", mode.c_str());
+    return -1;
+  }
+
+  unsigned int buffer_size = cfg.getParameterInt("buffer_size",
+						 DEFAULT_CDR_BUFFER_SIZE);
+  if (buffer_size < MIN_CDR_BUFFER_SIZE) {
+    WARN("buffer_size %u too small, using %u\n",
+	 buffer_size, MIN_CDR_BUFFER_SIZE);
+    buffer_size = MIN_CDR_BUFFER_SIZE;
+  }
+
+  writer = new CDRWriter(buffer_size);
+  // also used for the CDRs left over if the file can't be written
+  writer->setSyslogOutput(log2syslog_level[level], syslog_prefix);
+
+  if (mode == "file") {
+    string dir = cfg.getParameter("cdr_dir");
+    if (dir.empty()) {
+      ERROR("cdr_writer=file needs cdr_dir\n");
+      return -1;
+    }
+
+    CDRWriter::FsyncPolicy fsync_policy = CDRWriter::FsyncRotate;
+    string fsync_str = cfg.getParameter("fsync", "rotate");
+    if (fsync_str == "never") {
+      fsync_policy = CDRWriter::FsyncNever;
+    } else if (fsync_str == "always") {
+      fsync_policy = CDRWriter::FsyncAlways;
+    } else if (fsync_str != "rotate") {
+      ERROR("unknown fsync policy '%s'\n", fsync_str.c_str());
+      return -1;
+    }
+
+    writer->setFileOutput(dir, cfg.getParameter("cdr_file_prefix", "cdr"),
+			  (unsigned long long)
+			  cfg.getParameterInt("rotate_size_mb", 64) * 1024 * 1024,
+			  cfg.getParameterInt("rotate_interval", 3600),
+			  fsync_policy);
+  }
+
+  if (writer->start(cfg.getParameterInt("flush_interval",
+					DEFAULT_FLUSH_INTERVAL_MS)))
+    return -1;
+
+  DBG("using asynchronous CDR writer (%s)\n", mode.c_str());
   return 0;
 }
 
@@ -151,10 +231,14 @@ void SyslogCDR::invoke(const string& method, const AmArg& args, AmArg& ret)
       // ret.push("From-tag");
     } else if (method == "getExtendedInterfaceHandler") {
       ret.push((AmObject*)this);
+    } else if (method == "getStats") {
+      if (writer)
+	writer->getStats(ret);
     } else if(method == "_list"){
       ret.push("start");
       ret.push("connect");
       ret.push("end");
+      ret.push("getStats");
     }
     else
 	throw AmDynInvoke::NotImplemented(method);
@@ -237,9 +321,6 @@ void SyslogCDR::end(const string& ltag, SBCCallProfile* call_profile,
 		    int end_ts_sec, int end_ts_usec) {
   if (!call_profile) return;
 
-  static const int log2syslog_level[] = { LOG_ERR, LOG_WARNING, LOG_INFO,
-					  LOG_DEBUG, LOG_NOTICE };
-
   struct timeval start;
   start.tv_sec = connect_ts_sec;
   start.tv_usec = connect_ts_usec;
@@ -372,6 +453,15 @@ void SyslogCDR::end(const string& ltag, SBCCallProfile* call_profile,
   if (cdr.size() && cdr[cdr.size()-1]==',')
     cdr.erase(cdr.size()-1, 1);
 
+  if (writer) {
+    if (writer->write(cdr)) {
+      DBG("queued CDR '%s'\n", ltag.c_str());
+      return;
+    }
+    // don't lose the CDR if the writer can't keep up
+    WARN("CDR buffer full, writing CDR '%s' to syslog\n", ltag.c_str());
+  }
+
   syslog(log2syslog_level[level], "%s%s", syslog_prefix.c_str(), cdr.c_str());
   DBG("written CDR '%s' to syslog\n", ltag.c_str());
 }
@@ -32,6 +32,7 @@
 
 #include "SBCCallProfile.h"
 #include "SBCCallLeg.h"
+#include "CDRWriter.h"
 
 #include <sys/time.h>
 #include <stdio.h>
@@ -39,6 +40,9 @@
 #include <map>
 #include <memory>
 
+// max ms to wait for the queued CDRs to be written at shutdown
+#define WRITER_STOP_TIMEOUT_MS 5000
+
 /**
  * accounting for generating CDR lines in CSV format in syslog
  */
@@ -52,6 +56,9 @@ class SyslogCDR : public AmDynInvoke, public ExtendedCCInterface, public AmObjec
 
   bool quoting_enabled;
 
+  /** asynchronous writer (NULL: write to syslog from the call leg thread) */
+  CDRWriter* writer;
+
   /* map<string, CDR*> cdrs; */
   /* AmMutex cdrs_mut; */
 
@@ -62,10 +69,14 @@ class SyslogCDR : public AmDynInvoke, public ExtendedCCInterface, public AmObjec
 	   int connect_ts_sec, int connect_ts_usec,
 	   int end_ts_sec, int end_ts_usec);
 
+  int initWriter(AmConfigReader& cfg);
+
  public:
   SyslogCDR();
   ~SyslogCDR();
   static SyslogCDR* instance();
+  /** write out the queued CDRs and delete the instance */
+  static void dispose();
   void invoke(const string& method, const AmArg& args, AmArg& ret);
   int onLoad();
 
@@ -0,0 +1,584 @@
+#include "AsyncXmlRpcServer.h"
+
+#include "log.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+#define XMLRPC_READ_SIZE       16384
+#define XMLRPC_MAX_HEADER_SIZE 16384
+
+XmlRpcMethod::XmlRpcMethod(const string& name, AsyncXmlRpcServer* s)
+  : name(name)
+{
+  if (s)
+    s->addMethod(this);
+}
+
+XmlRpcConnection::XmlRpcConnection(AsyncXmlRpcServer* server, int sd)
+  : server(server), sd(sd), read_ev(NULL), write_ev(NULL),
+    wpos(0), keep_alive(true), busy(false)
+{
+}
+
+XmlRpcConnection::~XmlRpcConnection()
+{
+  if (read_ev)
+    event_free(read_ev);
+  if (write_ev)
+    event_free(write_ev);
+  if (sd >= 0)
+    close(sd);
+}
+
+void XmlRpcWorker::run()
+{
+  XmlRpcJob* job;
+  while ((job = server->getJob()) != NULL) {
+    server->executeRequest(job->request.data(), job->request.length(),
+			   job->response);
+    server->jobDone(job);
+  }
+  DBG("XMLRPC worker thread stopped.\n");
+}
+
+AsyncXmlRpcServer::AsyncXmlRpcServer(unsigned int threads,
+				     unsigned int max_queue,
+				     unsigned int keepalive_timeout,
+				     size_t max_request_size)
+  : n_threads(threads), max_queue(max_queue),
+    max_request_size(max_request_size),
+    sd(-1), evbase(NULL), accept_ev(NULL), wakeup_ev(NULL),
+    have_jobs(false), stopping(false), rejected(0)
+{
+  this->keepalive_timeout.tv_sec = keepalive_timeout;
+  this->keepalive_timeout.tv_usec = 0;
+  wakeup_fds[0] = wakeup_fds[1] = -1;
+}
+
+AsyncXmlRpcServer::~AsyncXmlRpcServer()
+{
+  if (accept_ev)
+    event_free(accept_ev);
+  if (wakeup_ev)
+    event_free(wakeup_ev);
+  if (evbase)
+    event_base_free(evbase);
+  if (sd >= 0)
+    close(sd);
+  if (wakeup_fds[0] >= 0) close(wakeup_fds[0]);
+  if (wakeup_fds[1] >= 0) close(wakeup_fds[1]);
+}
+
+void AsyncXmlRpcServer::addMethod(XmlRpcMethod* m)
+{
+  methods[m->getName()] = m;
+}
+
+XmlRpcMethod* AsyncXmlRpcServer::findMethod(const string& name)
+{
+  std::map<string, XmlRpcMethod*>::iterator it = methods.find(name);
+  if (it == methods.end())
+    return NULL;
+  return it->second;
+}
+
+bool AsyncXmlRpcServer::bindAndListen(unsigned int port, const string& bind_ip)
+{
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  if (bind_ip.empty()) {
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  } else if (inet_pton(AF_INET, bind_ip.c_str(), &addr.sin_addr) != 1) {
+    ERROR("invalid XMLRPC server address '%s'\n", bind_ip.c_str());
+    return false;
+  }
+
+  sd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (sd < 0) {
+    ERROR("socket(): %s\n", strerror(errno));
+    return false;
+  }
+  int on = 1;
+  setsockopt(sd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  if (bind(sd, (struct sockaddr*)&addr, sizeof(addr)) ||
+      listen(sd, SOMAXCONN)) {
+    ERROR("binding XMLRPC server to %s:%u: %s\n",
+	  bind_ip.empty() ? "ANY" : bind_ip.c_str(), port, strerror(errno));
+    return false;
+  }
+
+  evbase = event_base_new();
+  if (!evbase) {
+    ERROR("event_base_new() failed\n");
+    return false;
+  }
+  if (pipe2(wakeup_fds, O_NONBLOCK | O_CLOEXEC)) {
+    ERROR("pipe(): %s\n", strerror(errno));
+    return false;
+  }
+  accept_ev = event_new(evbase, sd, EV_READ|EV_PERSIST,
+			AsyncXmlRpcServer::on_accept, this);
+  wakeup_ev = event_new(evbase, wakeup_fds[0], EV_READ|EV_PERSIST,
+			AsyncXmlRpcServer::on_wakeup, this);
+  if (!accept_ev || !wakeup_ev) {
+    ERROR("event_new() failed\n");
+    return false;
+  }
+  event_add(accept_ev, NULL);
+  event_add(wakeup_ev, NULL);
+  return true;
+}
+
+unsigned int AsyncXmlRpcServer::getPort()
+{
+  struct sockaddr_in addr;
+  socklen_t len = sizeof(addr);
+  if (sd < 0 || getsockname(sd, (struct sockaddr*)&addr, &len))
+    return 0;
+  return ntohs(addr.sin_port);
+}
+
+void AsyncXmlRpcServer::run()
+{
+  if (!evbase) {
+    ERROR("XMLRPC server not bound\n");
+    return;
+  }
+
+  for (unsigned int i=0; i<n_threads; i++) {
+    workers.push_back(new XmlRpcWorker(this));
+    workers.back()->start();
+  }
+
+  DBG("XMLRPC server running with %u worker threads\n", n_threads);
+  event_base_dispatch(evbase);
+
+  event_free(accept_ev);
+  accept_ev = NULL;
+  close(sd);
+  sd = -1;
+
+  // stop the workers, then drop what is left
+  jobs_mut.lock();
+  stopping = true;
+  jobs_mut.unlock();
+  have_jobs.set(true);
+  for (std::vector<XmlRpcWorker*>::iterator it=workers.begin();
+       it != workers.end(); it++) {
+    (*it)->join();
+    delete *it;
+  }
+  workers.clear();
+
+  while (!jobs.empty()) {
+    delete jobs.front();
+    jobs.pop();
+  }
+  for (std::vector<XmlRpcJob*>::iterator it=done.begin(); it != done.end(); it++)
+    delete *it;
+  done.clear();
+
+  for (std::set<XmlRpcConnection*>::iterator it=connections.begin();
+       it != connections.end(); it++)
+    delete *it;
+  connections.clear();
+
+  DBG("XMLRPC server stopped.\n");
+}
+
+void AsyncXmlRpcServer::on_stop()
+{
+  jobs_mut.lock();
+  stopping = true;
+  jobs_mut.unlock();
+  wakeup();
+}
+
+void AsyncXmlRpcServer::stop_and_wait()
+{
+  if (!is_stopped()) {
+    stop();
+
+    while (!is_stopped())
+      usleep(10000);
+  }
+}
+
+void AsyncXmlRpcServer::wakeup()
+{
+  char c = 0;
+  if (write(wakeup_fds[1], &c, 1) < 0 && errno != EAGAIN)
+    ERROR("writing to XMLRPC server wakeup pipe: %s\n", strerror(errno));
+}
+
+void AsyncXmlRpcServer::on_accept(int sd, short ev, void* arg)
+{
+  ((AsyncXmlRpcServer*)arg)->acceptConnections();
+}
+
+void AsyncXmlRpcServer::on_read(int sd, short ev, void* arg)
+{
+  XmlRpcConnection* c = (XmlRpcConnection*)arg;
+  c->server->readConnection(c, ev);
+}
+
+void AsyncXmlRpcServer::on_write(int sd, short ev, void* arg)
+{
+  XmlRpcConnection* c = (XmlRpcConnection*)arg;
+  c->server->writeConnection(c, ev);
+}
+
+void AsyncXmlRpcServer::on_wakeup(int sd, short ev, void* arg)
+{
+  char buf[64];
+  while (read(sd, buf, sizeof(buf)) > 0) { }
+  ((AsyncXmlRpcServer*)arg)->processDone();
+}
+
+void AsyncXmlRpcServer::acceptConnections()
+{
+  while (true) {
+    int s = accept4(sd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (s < 0) {
+      if (errno == EMFILE || errno == ENFILE)
+	ERROR("XMLRPC server: could not accept connection: %s\n", strerror(errno));
+      else if (errno == EINTR || errno == ECONNABORTED)
+	continue;
+      return;
+    }
+
+    int on = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    XmlRpcConnection* c = new XmlRpcConnection(this, s);
+    c->read_ev = event_new(evbase, s, EV_READ|EV_PERSIST,
+			   AsyncXmlRpcServer::on_read, c);
+    c->write_ev = event_new(evbase, s, EV_WRITE|EV_PERSIST,
+			    AsyncXmlRpcServer::on_write, c);
+    if (!c->read_ev || !c->write_ev) {
+      ERROR("event_new() failed\n");
+      delete c;
+      continue;
+    }
+    connections.insert(c);
+    event_add(c->read_ev, idleTimeout());
+  }
+}
+
+void AsyncXmlRpcServer::closeConnection(XmlRpcConnection* c)
+{
+  connections.erase(c);
+  delete c;
+}
+
+void AsyncXmlRpcServer::readConnection(XmlRpcConnection* c, short ev)
+{
+  if (ev & EV_TIMEOUT) {
+    DBG("XMLRPC connection idle, closing\n");
+    closeConnection(c);
+    return;
+  }
+
+  size_t old_size = c->rbuf.size();
+  c->rbuf.resize(old_size + XMLRPC_READ_SIZE);
+  ssize_t n = recv(c->sd, &c->rbuf[old_size], XMLRPC_READ_SIZE, 0);
+  c->rbuf.resize(old_size + (n > 0 ? n : 0));
+  if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+    closeConnection(c);
+    return;
+  }
+  processInput(c);
+}
+
+/** dispatch the complete requests in the read buffer, one at a time */
+void AsyncXmlRpcServer::processInput(XmlRpcConnection* c)
+{
+  while (!c->busy) {
+    size_t hdr_end = c->rbuf.find("\r\n\r\n");
+    if (hdr_end == string::npos) {
+      if (c->rbuf.size() > XMLRPC_MAX_HEADER_SIZE)
+	sendError(c, "400 Bad Request");
+      return;
+    }
+
+    const char* hdr = c->rbuf.c_str();
+    if (strncmp(hdr, "POST ", 5)) {
+      sendError(c, "405 Method Not Allowed");
+      return;
+    }
+
+    // request line and headers, each ending with CRLF
+    const char* hdr_last = hdr + hdr_end + 2;
+    const char* eol = (const char*)memmem(hdr, hdr_last - hdr, "\r\n", 2);
+    bool http10 = eol - hdr >= 8 && !strncmp(eol - 8, "HTTP/1.0", 8);
+
+    long content_length = -1;
+    bool conn_close = false, conn_keep_alive = false;
+    for (const char* l = eol + 2; l < hdr_last; ) {
+      const char* l_end = (const char*)memmem(l, hdr_last - l, "\r\n", 2);
+      if (!strncasecmp(l, "Content-Length:", 15)) {
+	content_length = strtol(l + 15, NULL, 10);
+      } else if (!strncasecmp(l, "Connection:", 11)) {
+	const char* v = l + 11;
+	while (*v == ' ' || *v == '\t') v++;
+	conn_close = !strncasecmp(v, "close", 5);
+	conn_keep_alive = !strncasecmp(v, "keep-alive", 10);
+      }
+      l = l_end + 2;
+    }
+
+    if (content_length < 0) {
+      sendError(c, "411 Length Required");
+      return;
+    }
+    if ((size_t)content_length > max_request_size) {
+      sendError(c, "413 Request Entity Too Large");
+      return;
+    }
+
+    size_t body_start = hdr_end + 4;
+    if (c->rbuf.size() < body_start + content_length)
+      return; // rest of the body still to come
+
+    c->keep_alive = http10 ? conn_keep_alive : !conn_close;
+
+    XmlRpcJob* job = new XmlRpcJob(c);
+    job->request.assign(c->rbuf, body_start, content_length);
+    c->rbuf.erase(0, body_start + content_length);
+    dispatch(c, job);
+    // connection closed if the response could not be written
+    if (connections.find(c) == connections.end())
+      return;
+  }
+}
+
+void AsyncXmlRpcServer::dispatch(XmlRpcConnection* c, XmlRpcJob* job)
+{
+  c->busy = true;
+  event_del(c->read_ev);
+
+  if (!n_threads) {
+    executeRequest(job->request.data(), job->request.length(), job->response);
+    respond(c, job->response);
+    delete job;
+    return;
+  }
+
+  jobs_mut.lock();
+  if (jobs.size() >= max_queue) {
+    jobs_mut.unlock();
+    rejected++;
+    delete job;
+    string fault;
+    xmlrpcAppendFault(XMLRPC_FAULT_OVERLOAD, "server overloaded, try again later",
+		      fault);
+    respond(c, fault);
+    return;
+  }
+  jobs.push(job);
+  have_jobs.set(true);
+  jobs_mut.unlock();
+}
+
+XmlRpcJob* AsyncXmlRpcServer::getJob()
+{
+  while (true) {
+    jobs_mut.lock();
+    if (stopping) {
+      jobs_mut.unlock();
+      return NULL;
+    }
+    if (!jobs.empty()) {
+      XmlRpcJob* job = jobs.front();
+      jobs.pop();
+      have_jobs.set(!jobs.empty());
+      jobs_mut.unlock();
+      return job;
+    }
+    jobs_mut.unlock();
+    have_jobs.wait_for();
+  }
+}
+
+void AsyncXmlRpcServer::jobDone(XmlRpcJob* job)
+{
+  done_mut.lock();
+  bool first = done.empty();
+  done.push_back(job);
+  done_mut.unlock();
+  if (first)
+    wakeup();
+}
+
+void AsyncXmlRpcServer::processDone()
+{
+  jobs_mut.lock();
+  bool stop = stopping;
+  jobs_mut.unlock();
+  if (stop) {
+    event_base_loopbreak(evbase);
+    return;
+  }
+
+  std::vector<XmlRpcJob*> finished;
+  done_mut.lock();
+  finished.swap(done);
+  done_mut.unlock();
+
+  for (std::vector<XmlRpcJob*>::iterator it=finished.begin();
+       it != finished.end(); it++) {
+    XmlRpcConnection* c = (*it)->conn;
+    if (respond(c, (*it)->response))
+      processInput(c);
+    delete *it;
+  }
+}
+
+bool AsyncXmlRpcServer::respond(XmlRpcConnection* c, const string& body)
+{
+  char hdr[160];
+  snprintf(hdr, sizeof(hdr),
+	   "HTTP/1.1 200 OK\r\nServer: SEMS xmlrpc2di\r\n"
+	   "Content-Type: text/xml\r\nContent-Length: %zu\r\n%s\r\n",
+	   body.length(), c->keep_alive ? "" : "Connection: close\r\n");
+  c->wbuf = hdr;
+  c->wbuf += body;
+  c->wpos = 0;
+  return flush(c);
+}
+
+bool AsyncXmlRpcServer::sendError(XmlRpcConnection* c, const char* status)
+{
+  DBG("XMLRPC request rejected: %s\n", status);
+  c->busy = true;
+  c->keep_alive = false;
+  event_del(c->read_ev);
+  c->wbuf = string("HTTP/1.1 ") + status +
+    "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+  c->wpos = 0;
+  return flush(c);
+}
+
+/** write what can be written, then read again or close */
+bool AsyncXmlRpcServer::flush(XmlRpcConnection* c)
+{
+  while (c->wpos < c->wbuf.length()) {
+    ssize_t n = send(c->sd, c->wbuf.data() + c->wpos,
+		     c->wbuf.length() - c->wpos, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR)
+	continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+	event_add(c->write_ev, idleTimeout());
+	return true;
+      }
+      closeConnection(c);
+      return false;
+    }
+    c->wpos += n;
+  }
+
+  event_del(c->write_ev);
+  c->wbuf.clear();
+  c->wpos = 0;
+  if (!c->keep_alive) {
+    closeConnection(c);
+    return false;
+  }
+  c->busy = false;
+  event_add(c->read_ev, idleTimeout());
+  return true;
+}
+
+void AsyncXmlRpcServer::writeConnection(XmlRpcConnection* c, short ev)
+{
+  if (ev & EV_TIMEOUT) {
+    DBG("XMLRPC client not reading the response, closing\n");
+    closeConnection(c);
+    return;
+  }
+  if (flush(c) && !c->busy)
+    processInput(c);
+}
+
+void AsyncXmlRpcServer::executeRequest(const char* req, size_t len,
+				       string& response)
+{
+  string method;
+  AmArg params, result;
+  XmlRpcReader reader(req, len);
+  if (!reader.readCall(method, params)) {
+    DBG("XMLRPC parse error: %s\n", reader.error().c_str());
+    xmlrpcAppendFault(-1, "parse error: " + reader.error(), response);
+    return;
+  }
+
+  try {
+    if (method == "system.multicall") {
+      executeMulticall(params, result);
+    } else {
+      XmlRpcMethod* m = findMethod(method);
+      if (!m) {
+	xmlrpcAppendFault(-1, method + ": unknown method name", response);
+	return;
+      }
+      m->execute(params, result);
+    }
+    xmlrpcAppendResponse(result, response);
+  } catch (const XmlRpcFault& f) {
+    xmlrpcAppendFault(f.code, f.message, response);
+  } catch (const AmArg::OutOfBoundsException& e) {
+    xmlrpcAppendFault(300, "Exception: AmArg out of bounds - parameter number mismatch.",
+		      response);
+  } catch (const AmArg::TypeMismatchException& e) {
+    xmlrpcAppendFault(300, "Exception: Type mismatch in arguments.", response);
+  } catch (...) {
+    xmlrpcAppendFault(500, "Exception occured.", response);
+  }
+}
+
+/** params: array of structs with methodName and params */
+void AsyncXmlRpcServer::executeMulticall(const AmArg& params, AmArg& result)
+{
+  if (!isArgArray(params) || params.size() != 1 || !isArgArray(params.get(0)))
+    throw XmlRpcFault("system.multicall expects an array of calls", 400);
+
+  result.assertArray();
+  const AmArg& calls = params.get(0);
+  for (size_t i=0; i<calls.size(); i++) {
+    AmArg res;
+    try {
+      const AmArg& call = calls.get(i);
+      if (!isArgStruct(call) || !call.hasMember("methodName") ||
+	  !isArgCStr(call["methodName"]))
+	throw XmlRpcFault("system.multicall: malformed call", 400);
+      string name = call["methodName"].asCStr();
+      XmlRpcMethod* m = findMethod(name);
+      if (!m)
+	throw XmlRpcFault(name + ": unknown method name");
+      AmArg call_params;
+      if (call.hasMember("params"))
+	call_params = call["params"];
+      AmArg call_res;
+      m->execute(call_params, call_res);
+      res.push(call_res);
+    } catch (const XmlRpcFault& f) {
+      res["faultCode"] = f.code;
+      res["faultString"] = f.message;
+    } catch (...) {
+      res["faultCode"] = 500;
+      res["faultString"] = "Exception occured.";
+    }
+    result.push(res);
+  }
+}
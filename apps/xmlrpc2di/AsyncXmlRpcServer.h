@@ -0,0 +1,182 @@
+#ifndef _ASYNC_XMLRPCSERVER_H
+#define _ASYNC_XMLRPCSERVER_H
+
+#include "AmThread.h"
+#include "AmArg.h"
+#include "XmlRpcAmArg.h"
+
+#include <event2/event.h>
+
+#include <map>
+#include <queue>
+#include <set>
+#include <string>
+#include <vector>
+using std::string;
+
+#define XMLRPC_DEF_MAX_QUEUE         100
+#define XMLRPC_DEF_KEEPALIVE_TIMEOUT 30 /* s */
+#define XMLRPC_DEF_MAX_REQUEST_SIZE  (4 * 1024 * 1024)
+
+/** fault code of requests rejected because the queue is full */
+#define XMLRPC_FAULT_OVERLOAD 503
+
+class AsyncXmlRpcServer;
+
+/** server method, called with the params and returning the result as AmArg */
+class XmlRpcMethod
+{
+  string name;
+
+ public:
+  /** registers the method with s, if given */
+  XmlRpcMethod(const string& name, AsyncXmlRpcServer* s = NULL);
+  virtual ~XmlRpcMethod() { }
+
+  const string& getName() const { return name; }
+
+  /**
+   * @param params array of the params, Undef if there are none
+   * @throw XmlRpcFault to return a fault
+   */
+  virtual void execute(const AmArg& params, AmArg& result) = 0;
+};
+
+/** a client connection, owned by the server's event loop */
+struct XmlRpcConnection
+{
+  AsyncXmlRpcServer* server;
+  int sd;
+  struct event* read_ev;
+  struct event* write_ev;
+
+  string rbuf;
+  string wbuf;
+  size_t wpos;
+
+  bool keep_alive;
+  /** a request is being executed: not reading further */
+  bool busy;
+
+  XmlRpcConnection(AsyncXmlRpcServer* server, int sd);
+  ~XmlRpcConnection();
+};
+
+/** request body, handed to the workers and back with the response */
+struct XmlRpcJob
+{
+  XmlRpcConnection* conn;
+  string request;
+  string response;
+
+  XmlRpcJob(XmlRpcConnection* conn) : conn(conn) { }
+};
+
+class XmlRpcWorker
+  : public AmThread
+{
+  AsyncXmlRpcServer* server;
+
+ protected:
+  void run();
+  void on_stop() { }
+
+ public:
+  XmlRpcWorker(AsyncXmlRpcServer* server) : server(server) { }
+};
+
+/**
+ * non-blocking XML-RPC server
+ *
+ * One libevent loop accepts the connections, reads the HTTP requests
+ * and writes the responses, with keep-alive. Requests are parsed and
+ * executed by the worker threads from a bounded queue; if the queue
+ * is full the request is answered right away with an overload fault.
+ * Without worker threads, requests are executed in the loop.
+ */
+class AsyncXmlRpcServer
+  : public AmThread
+{
+  std::map<string, XmlRpcMethod*> methods;
+
+  unsigned int n_threads;
+  unsigned int max_queue;
+  struct timeval keepalive_timeout;
+  size_t max_request_size;
+
+  int sd;
+  struct event_base* evbase;
+  struct event* accept_ev;
+  struct event* wakeup_ev;
+  int wakeup_fds[2];
+
+  std::set<XmlRpcConnection*> connections;
+  std::vector<XmlRpcWorker*> workers;
+
+  AmMutex jobs_mut;
+  std::queue<XmlRpcJob*> jobs;
+  AmCondition<bool> have_jobs;
+  bool stopping;
+
+  AmMutex done_mut;
+  std::vector<XmlRpcJob*> done;
+
+  unsigned long rejected;
+
+  static void on_accept(int sd, short ev, void* arg);
+  static void on_read(int sd, short ev, void* arg);
+  static void on_write(int sd, short ev, void* arg);
+  static void on_wakeup(int sd, short ev, void* arg);
+
+  void acceptConnections();
+  void readConnection(XmlRpcConnection* c, short ev);
+  void writeConnection(XmlRpcConnection* c, short ev);
+  void processDone();
+
+  void processInput(XmlRpcConnection* c);
+  void dispatch(XmlRpcConnection* c, XmlRpcJob* job);
+  /** @return false if the connection was closed */
+  bool respond(XmlRpcConnection* c, const string& body);
+  bool sendError(XmlRpcConnection* c, const char* status);
+  bool flush(XmlRpcConnection* c);
+  void closeConnection(XmlRpcConnection* c);
+
+  /** NULL (none) if keepalive_timeout is 0 */
+  struct timeval* idleTimeout() {
+    return keepalive_timeout.tv_sec ? &keepalive_timeout : NULL;
+  }
+
+  void wakeup();
+  void executeMulticall(const AmArg& params, AmArg& result);
+
+ protected:
+  void run();
+  void on_stop();
+
+ public:
+  AsyncXmlRpcServer(unsigned int threads,
+		    unsigned int max_queue = XMLRPC_DEF_MAX_QUEUE,
+		    unsigned int keepalive_timeout = XMLRPC_DEF_KEEPALIVE_TIMEOUT,
+		    size_t max_request_size = XMLRPC_DEF_MAX_REQUEST_SIZE);
+  ~AsyncXmlRpcServer();
+
+  /** methods are added before the server is started, and not owned */
+  void addMethod(XmlRpcMethod* m);
+  XmlRpcMethod* findMethod(const string& name);
+
+  bool bindAndListen(unsigned int port, const string& bind_ip);
+  void stop_and_wait();
+  /** bound port, e.g. if bound to port 0 */
+  unsigned int getPort();
+
+  /** parse and execute a methodCall, appending the methodResponse */
+  void executeRequest(const char* req, size_t len, string& response);
+
+  /** next job for a worker, NULL if stopping */
+  XmlRpcJob* getJob();
+  void jobDone(XmlRpcJob* job);
+
+  unsigned long getRejected() { return rejected; }
+};
+
+#endif
@@ -1,42 +1,247 @@
-#include "XmlRpc.h"
 #include "TOXmlRpcClient.h"
-// Clear the referenced flag even if exceptions or errors occur.
-struct ClearFlagOnExit {
-  ClearFlagOnExit(bool& flag) : _flag(flag) {}
-  ~ClearFlagOnExit() { _flag = false; }
-  bool& _flag;
-};
+#include "XmlRpcAmArg.h"
 
-bool TOXmlRpcClient::execute(const char* method, XmlRpcValue const& params, XmlRpcValue& result, double timeout) {
+#include "log.h"
 
-  XmlRpcUtil::log(1, "XmlRpcClient::execute: method %s (_connectionState %d).", method, _connectionState);
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
 
-  // This is not a thread-safe operation, if you want to do multithreading, use separate
-  // clients for each thread. If you want to protect yourself from multiple threads
-  // accessing the same client, replace this code with a real mutex.
-  if (_executing)
-    return false;
+#define XMLRPC_CLIENT_READ_SIZE 16384
+
+TOXmlRpcClient::TOXmlRpcClient(const string& host, int port, const string& uri)
+  : host(host), port(port), uri(uri.empty() ? "/RPC2" : uri),
+    sd(-1), is_fault(false)
+{
+}
 
-  _executing = true;
-  ClearFlagOnExit cf(_executing);
+TOXmlRpcClient::~TOXmlRpcClient()
+{
+  close();
+}
 
-  _sendAttempts = 0;
-  _isFault = false;
+void TOXmlRpcClient::close()
+{
+  if (sd >= 0) {
+    ::close(sd);
+    sd = -1;
+  }
+  rbuf.clear();
+}
 
-  if ( ! setupConnection())
-    return false;
+/** wait for events on the socket until deadline (tv_sec 0: no deadline) */
+bool TOXmlRpcClient::wait(short events, const struct timeval& deadline)
+{
+  struct pollfd pfd;
+  pfd.fd = sd;
+  pfd.events = events;
+  while (true) {
+    int timeout_ms = -1;
+    if (deadline.tv_sec) {
+      struct timeval now;
+      gettimeofday(&now, NULL);
+      long ms = (deadline.tv_sec - now.tv_sec) * 1000 +
+	(deadline.tv_usec - now.tv_usec) / 1000;
+      timeout_ms = ms > 0 ? ms : 0;
+    }
+    int res = poll(&pfd, 1, timeout_ms);
+    if (res > 0)
+      return true;
+    if (res == 0) {
+      DBG("XMLRPC call to %s:%d timed out\n", host.c_str(), port);
+      return false;
+    }
+    if (errno != EINTR)
+      return false;
+  }
+}
+
+bool TOXmlRpcClient::connect(const struct timeval& deadline)
+{
+  struct addrinfo hints, *res;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  char port_s[16];
+  snprintf(port_s, sizeof(port_s), "%d", port);
 
-  if ( ! generateRequest(method, params))
+  int err = getaddrinfo(host.c_str(), port_s, &hints, &res);
+  if (err) {
+    WARN("resolving XMLRPC server '%s': %s\n", host.c_str(), gai_strerror(err));
     return false;
+  }
 
-  result.clear();
-  //  double msTime = -1.0;   // Process until exit is called
-  _disp.work(timeout);
+  for (struct addrinfo* ai = res; ai && sd < 0; ai = ai->ai_next) {
+    sd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+		ai->ai_protocol);
+    if (sd < 0)
+      continue;
+    if (::connect(sd, ai->ai_addr, ai->ai_addrlen) && errno != EINPROGRESS) {
+      close();
+      continue;
+    }
+    int so_err = 0;
+    socklen_t len = sizeof(so_err);
+    if (!wait(POLLOUT, deadline) ||
+	getsockopt(sd, SOL_SOCKET, SO_ERROR, &so_err, &len) || so_err) {
+      close();
+      continue;
+    }
+  }
+  freeaddrinfo(res);
 
-  if (_connectionState != IDLE || ! parseResponse(result))
+  if (sd < 0) {
+    DBG("could not connect to XMLRPC server %s:%d\n", host.c_str(), port);
     return false;
+  }
+  int on = 1;
+  setsockopt(sd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  return true;
+}
 
-  XmlRpcUtil::log(1, "XmlRpcClient::execute: method %s completed.", method);
-  _response = "";
+bool TOXmlRpcClient::send(const string& data, const struct timeval& deadline)
+{
+  size_t pos = 0;
+  while (pos < data.length()) {
+    ssize_t n = ::send(sd, data.data() + pos, data.length() - pos, MSG_NOSIGNAL);
+    if (n >= 0) {
+      pos += n;
+    } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      if (!wait(POLLOUT, deadline))
+	return false;
+    } else if (errno != EINTR) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int TOXmlRpcClient::readResponse(string& body, bool& close_after,
+				 const struct timeval& deadline)
+{
+  size_t hdr_end = string::npos;
+  long content_length = -1;
+  bool eof = false;
+
+  while (true) {
+    if (hdr_end == string::npos) {
+      hdr_end = rbuf.find("\r\n\r\n");
+      if (hdr_end != string::npos) {
+	const char* hdr = rbuf.c_str();
+	if (strncmp(hdr, "HTTP/1.", 7) || strncmp(hdr + 8, " 200", 4)) {
+	  DBG("XMLRPC server %s:%d replied '%.*s'\n", host.c_str(), port,
+	      (int)rbuf.find("\r\n"), hdr);
+	  return -1;
+	}
+	close_after = hdr[7] == '0';
+	const char* hdr_last = hdr + hdr_end + 2;
+	for (const char* l = (const char*)memmem(hdr, hdr_last - hdr, "\r\n", 2) + 2;
+	     l < hdr_last; ) {
+	  const char* l_end = (const char*)memmem(l, hdr_last - l, "\r\n", 2);
+	  if (!strncasecmp(l, "Content-Length:", 15)) {
+	    content_length = strtol(l + 15, NULL, 10);
+	  } else if (!strncasecmp(l, "Connection:", 11)) {
+	    const char* v = l + 11;
+	    while (*v == ' ' || *v == '\t') v++;
+	    if (!strncasecmp(v, "close", 5))
+	      close_after = true;
+	    else if (!strncasecmp(v, "keep-alive", 10))
+	      close_after = false;
+	  }
+	  l = l_end + 2;
+	}
+	hdr_end += 4;
+      }
+    }
+
+    if (hdr_end != string::npos) {
+      if (content_length >= 0 && rbuf.size() >= hdr_end + content_length) {
+	body.assign(rbuf, hdr_end, content_length);
+	rbuf.erase(0, hdr_end + content_length);
+	return 1;
+      }
+      if (content_length < 0 && eof) {
+	// no length: the body ends with the connection
+	body.assign(rbuf, hdr_end, string::npos);
+	rbuf.clear();
+	close_after = true;
+	return 1;
+      }
+    }
+    if (eof)
+      return rbuf.empty() ? 0 : -1;
+
+    if (!wait(POLLIN, deadline))
+      return -1;
+    size_t old_size = rbuf.size();
+    rbuf.resize(old_size + XMLRPC_CLIENT_READ_SIZE);
+    ssize_t n = recv(sd, &rbuf[old_size], XMLRPC_CLIENT_READ_SIZE, 0);
+    rbuf.resize(old_size + (n > 0 ? n : 0));
+    if (n == 0) {
+      eof = true;
+    } else if (n < 0 && errno != EAGAIN && errno != EINTR) {
+      // reset before the response: as closed
+      if (rbuf.empty() && errno == ECONNRESET)
+	return 0;
+      return -1;
+    }
+  }
+}
+
+bool TOXmlRpcClient::execute(const char* method, const AmArg& params,
+			     AmArg& result, double timeout)
+{
+  struct timeval deadline;
+  deadline.tv_sec = deadline.tv_usec = 0;
+  if (timeout >= 0) {
+    gettimeofday(&deadline, NULL);
+    long us = deadline.tv_usec + (long)(timeout * 1000000.0);
+    deadline.tv_sec += us / 1000000;
+    deadline.tv_usec = us % 1000000;
+  }
+
+  is_fault = false;
+  string xml;
+  xmlrpcAppendCall(method, params, xml);
+  char hdr[512];
+  snprintf(hdr, sizeof(hdr),
+	   "POST %s HTTP/1.1\r\nHost: %s:%d\r\nUser-Agent: SEMS xmlrpc2di\r\n"
+	   "Content-Type: text/xml\r\nContent-Length: %zu\r\n\r\n",
+	   uri.c_str(), host.c_str(), port, xml.length());
+  string req = hdr + xml;
+
+  string body;
+  bool close_after = false;
+  for (int attempt = 0; ; attempt++) {
+    bool reused = sd >= 0;
+    if (!reused && !connect(deadline))
+      return false;
+
+    int res = send(req, deadline) ? readResponse(body, close_after, deadline) : 0;
+    if (res > 0)
+      break;
+    close();
+    // closed by the server while idle: once more on a new connection
+    if (res < 0 || !reused || attempt)
+      return false;
+  }
+  if (close_after)
+    close();
+
+  XmlRpcReader reader(body.data(), body.length());
+  if (!reader.readResponse(result, is_fault)) {
+    DBG("reading XMLRPC response from %s:%d: %s\n", host.c_str(), port,
+	reader.error().c_str());
+    close();
+    return false;
+  }
   return true;
 }
@@ -1,26 +1,54 @@
 #ifndef _TO_XMLRPCCLIENT_H
 #define _TO_XMLRPCCLIENT_H
-#include "XmlRpcClient.h"
-using namespace XmlRpc;
 
-/* xmlrpc client with timeout */
-class TOXmlRpcClient : public XmlRpc::XmlRpcClient {
+#include "AmArg.h"
+
+#include <sys/time.h>
+
+#include <string>
+using std::string;
+
+/**
+ * xmlrpc client with timeout
+ *
+ * The connection is kept open between calls (HTTP keep-alive); a call
+ * on a connection the server has closed meanwhile is sent again on a
+ * new one. Not thread-safe, use one client per thread.
+ */
+class TOXmlRpcClient
+{
+  string host;
+  int port;
+  string uri;
+
+  int sd;
+  string rbuf;
+  bool is_fault;
+
+  bool connect(const struct timeval& deadline);
+  bool send(const string& data, const struct timeval& deadline);
+  /** @return 1 response read, 0 closed before any response, -1 error */
+  int readResponse(string& body, bool& close_after,
+		   const struct timeval& deadline);
+  bool wait(short events, const struct timeval& deadline);
+
  public:
-  TOXmlRpcClient(const char* host, int port, const char* uri=0
-#ifdef HAVE_XMLRPCPP_SSL
-		 , bool ssl=false
-#endif
-		 )
-    : XmlRpcClient(host, port, uri
-#ifdef HAVE_XMLRPCPP_SSL
-		   , ssl
-#else
-		   , false
-#endif
-		   ) { }
+  TOXmlRpcClient(const string& host, int port, const string& uri = "");
+  ~TOXmlRpcClient();
+
+  /**
+   * @param params array of the params
+   * @param timeout in seconds, negative for none
+   * @return false on connection errors, timeouts and unreadable
+   *         responses; a fault is a result, see isFault()
+   */
+  bool execute(const char* method, const AmArg& params,
+	       AmArg& result, double timeout);
+
+  bool isFault() const { return is_fault; }
+  bool isConnected() const { return sd >= 0; }
 
-  bool execute(const char* method, XmlRpcValue const& params, 
-	       XmlRpcValue& result, double timeout);
+  void close();
 };
 
 #endif
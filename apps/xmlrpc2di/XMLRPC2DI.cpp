@@ -32,7 +32,6 @@
 #include "AmArg.h"
 #include "AmSessionContainer.h"
 #include "AmEventDispatcher.h"
-#include "TOXmlRpcClient.h"
 
 #include <exception>
 
@@ -82,7 +81,6 @@ int XMLRPC2DI::load() {
   DebugServerResult = cfg.getParameter("debug_server_result", "no") == "yes";
   DebugServerParams = cfg.getParameter("debug_server_params", "no") == "yes";
 
-  XmlRpcServer* s;
   unsigned int threads = 0;
   if (multithreaded == "yes") {
     if (!cfg.getParameter("threads").length())
@@ -91,14 +89,17 @@ int XMLRPC2DI::load() {
       threads = cfg.getParameterInt("threads", 5);
 
     DBG("Running multi-threaded XMLRPC server with %u threads\n", threads);
-    MultithreadXmlRpcServer* mt_s = new MultithreadXmlRpcServer();
-    mt_s->createThreads(threads);    
-    s = mt_s;
   } else {
     DBG("Running single-threaded XMLRPC server\n");
-    s = new XmlRpcServer();
   }
 
+  unsigned int max_queue =
+    cfg.getParameterInt("max_queue", XMLRPC_DEF_MAX_QUEUE);
+  unsigned int keepalive_timeout =
+    cfg.getParameterInt("keepalive_timeout", XMLRPC_DEF_KEEPALIVE_TIMEOUT);
+  DBG("XMLRPC server: queueing up to %u requests, keep-alive timeout %u s\n",
+      max_queue, keepalive_timeout);
+
   ServerRetryAfter = cfg.getParameterInt("server_retry_after", 10);
   DBG("retrying failed server after %u seconds\n", ServerRetryAfter);
 
@@ -157,6 +158,8 @@ int XMLRPC2DI::load() {
   INFO("XMLRPC Server: %snabling builtin method 'di'.\n", export_di?"E":"Not e");
 
 
+  AsyncXmlRpcServer* s =
+    new AsyncXmlRpcServer(threads, max_queue, keepalive_timeout);
   server = new XMLRPC2DIServer(XMLRPCPort, bind_ip, export_di, direct_export, s);
   if (!server->initialize()) {
     return -1;
@@ -173,7 +176,11 @@ XMLRPCServerEntry::XMLRPCServerEntry(string s, int p, string u)
 { }
 
 XMLRPCServerEntry::~XMLRPCServerEntry() 
-{ }
+{
+  for (vector<TOXmlRpcClient*>::iterator it=idle_clients.begin();
+       it != idle_clients.end(); it++)
+    delete *it;
+}
 
 bool XMLRPCServerEntry::is_active() {
   if (!active && 
@@ -189,6 +196,31 @@ void XMLRPCServerEntry::set_failed() {
   time(&last_try);
 }
 
+TOXmlRpcClient* XMLRPCServerEntry::getClient() {
+  TOXmlRpcClient* c = NULL;
+  clients_mut.lock();
+  if (!idle_clients.empty()) {
+    c = idle_clients.back();
+    idle_clients.pop_back();
+  }
+  clients_mut.unlock();
+  if (!c)
+    c = new TOXmlRpcClient(server, port, uri);
+  return c;
+}
+
+void XMLRPCServerEntry::putClient(TOXmlRpcClient* c) {
+  if (c->isConnected()) {
+    clients_mut.lock();
+    if (idle_clients.size() < XMLRPC_MAX_IDLE_CLIENTS) {
+      idle_clients.push_back(c);
+      c = NULL;
+    }
+    clients_mut.unlock();
+  }
+  delete c;
+}
+
 void XMLRPC2DI::newConnection(const AmArg& args, AmArg& ret) {
   string app_name     = args.get(0).asCStr();
   string server_name  = args.get(1).asCStr();
@@ -238,27 +270,22 @@ void XMLRPC2DI::sendRequest(const AmArg& args, AmArg& ret) {
       ret.push("no active connections");
       return;
     }
-    TOXmlRpcClient c((const char*)srv->server.c_str(), (int)srv->port, 
-		   (const char*)srv->uri.empty()?NULL:srv->uri.c_str()
-#ifdef HAVE_XMLRPCPP_SSL
-		   , false
-#endif
-		   );
+    TOXmlRpcClient* c = srv->getClient();
+    AmArg result;
 
-    XmlRpcValue x_args, x_result;
-    XMLRPC2DIServer::amarg2xmlrpcval(params, x_args);
-
-    if (c.execute(method.c_str(), x_args, x_result, XMLRPC2DI::ServerTimeout) &&  !c.isFault()) {
+    if (c->execute(method.c_str(), params, result, XMLRPC2DI::ServerTimeout) &&
+	!c->isFault()) {
       DBG("successfully executed method %s on server %s:%d\n",
 	  method.c_str(), srv->server.c_str(), srv->port);
+      srv->putClient(c);
       ret.push(0);
       ret.push("OK");
-      ret.assertArray(3);
-      XMLRPC2DIServer::xmlrpcval2amarg(x_result, ret[2]);
+      ret.push(result);
       return;      
     } else {
       DBG("executing method %s failed on server %s:%d\n",
 	  method.c_str(), srv->server.c_str(), srv->port);
+      delete c;
       srv->set_failed();
     }
   }
@@ -275,30 +302,33 @@ void XMLRPC2DI::sendRequestList(const AmArg& args, AmArg& ret) {
       ret.push("no active connections");
       return;
     }
-    TOXmlRpcClient c((const char*)srv->server.c_str(), (int)srv->port, 
-		   (const char*)srv->uri.empty()?NULL:srv->uri.c_str()
-#ifdef HAVE_XMLRPCPP_SSL
-		   , false
-#endif
-		   );
-
-    XmlRpcValue x_args, x_result;
+    TOXmlRpcClient* c = srv->getClient();
+    AmArg params, result;
 
-    x_args.setSize(args.size()-2);
+    params.assertArray();
     for (size_t i=2;i<args.size();i++) {
-      XMLRPC2DIServer::amarg2xmlrpcval(args.get(i), x_args[i-2]);
+      params.push(args.get(i));
     }
 
-    if (c.execute(method.c_str(), x_args, x_result, XMLRPC2DI::ServerTimeout) &&  !c.isFault()) {
+    if (c->execute(method.c_str(), params, result, XMLRPC2DI::ServerTimeout) &&
+	!c->isFault()) {
       DBG("successfully executed method %s on server %s:%d\n",
 	  method.c_str(), srv->server.c_str(), srv->port);
+      srv->putClient(c);
       ret.push(0);
       ret.push("OK");
-      XMLRPC2DIServer::xmlrpcval2amarg(x_result, ret);
+      // elements of an array result follow the status
+      if (isArgArray(result)) {
+	for (size_t i=0;i<result.size();i++)
+	  ret.push(result.get(i));
+      } else {
+	ret.push(result);
+      }
       return;      
     } else {
       DBG("executing method %s failed on server %s:%d\n",
 	  method.c_str(), srv->server.c_str(), srv->port);
+      delete c;
       srv->set_failed();
     }
   }
@@ -331,7 +361,7 @@ XMLRPC2DIServer::XMLRPC2DIServer(unsigned int port,
 				 const string& bind_ip,
 				 bool di_export, 
 				 string direct_export,
-				 XmlRpcServer* s) 
+				 AsyncXmlRpcServer* s) 
   : AmEventQueue(this),
     s(s),
     port(port),
@@ -457,13 +487,16 @@ void XMLRPC2DIServer::run() {
   AmEventDispatcher::instance()->addEventQueue(MOD_NAME, this);
 
   DBG("starting XMLRPC2DIServer...\n");
+  s->start();
   running.set(true);
   do {
-    s->work(DEF_XMLRPCSERVER_WORK_INTERVAL);
+    ev_pending.wait_for_to(500);
     processEvents();
   } 
   while(running.get());
 
+  s->stop_and_wait();
+
   AmEventDispatcher::instance()->delEventQueue(MOD_NAME);
   DBG("Exiting XMLRPC2DIServer.\n");
 }
@@ -489,63 +522,66 @@ void XMLRPC2DIServer::on_stop() {
   running.set(false);
 }
 
-void XMLRPC2DIServerCallsMethod::execute(XmlRpcValue& params, XmlRpcValue& result) {
+void XMLRPC2DIServerCallsMethod::execute(const AmArg& params, AmArg& result) {
   int res = AmSession::getSessionNum();
   DBG("XMLRPC2DI: calls = %d\n", res);
   result = res;
 }
 
-void XMLRPC2DIServerGetLoglevelMethod::execute(XmlRpcValue& params, XmlRpcValue& result) {
+void XMLRPC2DIServerGetLoglevelMethod::execute(const AmArg& params, AmArg& result) {
   int res = log_level;
   DBG("XMLRPC2DI: get_loglevel returns %d\n", res);
   result = res;
 }
 
-void XMLRPC2DIServerSetLoglevelMethod::execute(XmlRpcValue& params, XmlRpcValue& result) {
-  log_level = params[0];
-  DBG("XMLRPC2DI: set log level to %d.\n", (int)params[0]);
+void XMLRPC2DIServerSetLoglevelMethod::execute(const AmArg& params, AmArg& result) {
+  assertArgInt(params.get(0));
+  log_level = params.get(0).asInt();
+  DBG("XMLRPC2DI: set log level to %d.\n", log_level);
   result = "200 OK";
 }
 
 
-void XMLRPC2DIServerGetShutdownmodeMethod::execute(XmlRpcValue& params, XmlRpcValue& result) {
+void XMLRPC2DIServerGetShutdownmodeMethod::execute(const AmArg& params, AmArg& result) {
   DBG("XMLRPC2DI: get_shutdownmode returns %s\n", AmConfig::ShutdownMode?"true":"false");
   result = (bool)AmConfig::ShutdownMode;
 }
 
-void XMLRPC2DIServerSetShutdownmodeMethod::execute(XmlRpcValue& params, XmlRpcValue& result) {
-  AmConfig::ShutdownMode = params[0];
+void XMLRPC2DIServerSetShutdownmodeMethod::execute(const AmArg& params, AmArg& result) {
+  assertArgBool(params.get(0));
+  AmConfig::ShutdownMode = params.get(0).asBool();
   DBG("XMLRPC2DI: set shutdownmode to %s.\n", AmConfig::ShutdownMode?"true":"false");
   result = "200 OK";
 }
 
-void XMLRPC2DIServerGetCPSLimitMethod::execute(XmlRpcValue& params, XmlRpcValue& result) {
+void XMLRPC2DIServerGetCPSLimitMethod::execute(const AmArg& params, AmArg& result) {
   pair<unsigned int, unsigned int> l = AmSessionContainer::instance()->getCPSLimit();
   DBG("XMLRPC2DI: get_cpslimit returns %d and %d\n", l.first, l.second);
   result = int2str(l.first) + " " + int2str(l.second);
 }
 
-void XMLRPC2DIServerSetCPSLimitMethod::execute(XmlRpcValue& params, XmlRpcValue& result) {
-  AmSessionContainer::instance()->setCPSLimit((int)params[0]);
+void XMLRPC2DIServerSetCPSLimitMethod::execute(const AmArg& params, AmArg& result) {
+  assertArgInt(params.get(0));
+  AmSessionContainer::instance()->setCPSLimit(params.get(0).asInt());
   DBG("XMLRPC2DI: set cpslimit to %u.\n",
     AmSessionContainer::instance()->getCPSLimit().first);
   result = "200 OK";
 }
 
-void XMLRPC2DIServerGetCpsavgMethod::execute(XmlRpcValue& params, XmlRpcValue& result) {
+void XMLRPC2DIServerGetCpsavgMethod::execute(const AmArg& params, AmArg& result) {
   int l = AmSessionContainer::instance()->getAvgCPS();
   DBG("XMLRPC2DI: get_cpsavg returns %d\n", l);
   result = l;
 }
 
-void XMLRPC2DIServerGetCpsmaxMethod::execute(XmlRpcValue& params, XmlRpcValue& result) {
+void XMLRPC2DIServerGetCpsmaxMethod::execute(const AmArg& params, AmArg& result) {
   int l = AmSessionContainer::instance()->getMaxCPS();
   DBG("XMLRPC2DI: get_cpsmax returns %d\n", l);
   result = l;
 }
 
 #define XMLMETH_EXEC(_meth, _sess_func, _descr)				\
-  void _meth::execute(XmlRpcValue& params, XmlRpcValue& result) {	\
+  void _meth::execute(const AmArg& params, AmArg& result) {		\
   unsigned int res = AmSession::_sess_func();				\
   result = (int)res;							\
   DBG("XMLRPC2DI: " _descr "(): %u\n", res);				\
@@ -556,237 +592,100 @@ XMLMETH_EXEC(XMLRPC2DIServerGetCallsavgMethod, getAvgSessionNum, "get_callsavg")
 XMLMETH_EXEC(XMLRPC2DIServerGetCallsmaxMethod, getMaxSessionNum, "get_callsmax");
 #undef XMLMETH_EXEC
 
-void XMLRPC2DIServerDIMethod::execute(XmlRpcValue& params, XmlRpcValue& result) {
+/** DI exceptions as XMLRPC faults */
+static void invoke_di(AmDynInvoke* di, const string& fct_name,
+		      const AmArg& args, AmArg& ret) {
   try {
-    if (params.size() < 2) {
-      DBG("XMLRPC2DI: ERROR: need at least factory name"
-	  " and function name to call\n");
-      throw XmlRpcException("need at least factory name"
-			    " and function name to call", 400);
-    }
-    
-    string fact_name = params[0];
-    string fct_name = params[1];
-
-    DBG("XMLRPC2DI: factory '%s' function '%s'\n", 
-	fact_name.c_str(), fct_name.c_str());
-
-    // get args
-    AmArg args;
-    XMLRPC2DIServer::xmlrpcval2amargarray(params, args, 2);
-  
-    if (XMLRPC2DI::DebugServerParams) {
-      DBG(" params: <%s>\n", AmArg::print(args).c_str()); 
-    }
-
-    AmDynInvokeFactory* di_f = AmPlugIn::instance()->getFactory4Di(fact_name);
-    if(!di_f){
-      throw XmlRpcException("could not get factory", 500);
-    }
-    AmDynInvoke* di = di_f->getInstance();
-    if(!di){
-      throw XmlRpcException("could not get instance from factory", 500);
-    }
-    AmArg ret;
     di->invoke(fct_name, args, ret);
-
-
-    if (XMLRPC2DI::DebugServerResult) {
-      DBG(" result: <%s>\n", AmArg::print(ret).c_str()); 
-    }
-  
-    XMLRPC2DIServer::amarg2xmlrpcval(ret, result);
-
-
-  } catch (const XmlRpcException& e) {
+  } catch (const XmlRpcFault& e) {
     throw;
   } catch (const AmDynInvoke::NotImplemented& e) {
-    throw XmlRpcException("Exception: AmDynInvoke::NotImplemented: "
-			  + e.what, 504);
+    throw XmlRpcFault("Exception: AmDynInvoke::NotImplemented: "
+		      + e.what, 504);
   } catch (const AmArg::OutOfBoundsException& e) {
-    throw XmlRpcException("Exception: AmArg out of bounds - parameter number mismatch.", 300);
+    throw XmlRpcFault("Exception: AmArg out of bounds - parameter number mismatch.", 300);
   } catch (const AmArg::TypeMismatchException& e) {
-    throw XmlRpcException("Exception: Type mismatch in arguments.", 300);
+    throw XmlRpcFault("Exception: Type mismatch in arguments.", 300);
   } catch (const string& e) {
-    throw XmlRpcException("Exception: "+e, 500);
+    throw XmlRpcFault("Exception: "+e, 500);
   } catch (const std::exception& e) {
-    throw XmlRpcException("Exception: " + string(e.what()), 500);
+    throw XmlRpcFault("Exception: " + string(e.what()), 500);
   } catch (...) {
-    throw XmlRpcException("Exception occured.", 500);
+    throw XmlRpcFault("Exception occured.", 500);
   }
 }
 
+void XMLRPC2DIServerDIMethod::execute(const AmArg& params, AmArg& result) {
+  if (!isArgArray(params) || params.size() < 2) {
+    DBG("XMLRPC2DI: ERROR: need at least factory name"
+	" and function name to call\n");
+    throw XmlRpcFault("need at least factory name"
+		      " and function name to call", 400);
+  }
+  if (!isArgCStr(params.get(0)) || !isArgCStr(params.get(1)))
+    throw XmlRpcFault("Exception: Type mismatch in arguments.", 300);
 
-void XMLRPC2DIServer::xmlrpcval2amargarray(XmlRpcValue& v, AmArg& a, 
-					   unsigned int start_index) {
-  if (v.valid()) {
-    a.assertArray();
-    size_t a_array_pos = a.size();
+  string fact_name = params.get(0).asCStr();
+  string fct_name = params.get(1).asCStr();
 
-    for (int i=start_index; i<v.size();i++) {
-      xmlrpcval2amarg(v[i], a[a_array_pos]);
-      a_array_pos++;
-    }
-  }
-}
-void XMLRPC2DIServer::xmlrpcval2amarg(XmlRpcValue& v, AmArg& a) {
-  if (v.valid()) {
-    switch (v.getType()) {
-    case XmlRpcValue::TypeInt:   {  /* DBG("X->A INT\n"); */ a = (int)v;    }  break;
-    case XmlRpcValue::TypeDouble:{  /*  DBG("X->A DBL\n"); */ a = (double)v; }  break;
-    case XmlRpcValue::TypeString:{  /*  DBG("X->A STR\n"); */ a = ((string)v).c_str(); }  break;
-    case XmlRpcValue::TypeBoolean : { /*   DBG("X->A BOL\n"); */ a = (bool)v;  } break;
-    case XmlRpcValue::TypeInvalid : { /*   DBG("X->A Inv\n"); */  a = AmArg();  } break;
-      
-    case XmlRpcValue::TypeArray: { 
-      // DBG("X->A ARR\n");
-      a.assertArray();
-      xmlrpcval2amargarray(v, a, 0);
-    } break;
-#ifdef XMLRPCPP_SUPPORT_STRUCT_ACCESS
-    case XmlRpcValue::TypeStruct: {
-       // DBG("X->A STR\n");
-      a.assertStruct();
-      const XmlRpc::XmlRpcValue::ValueStruct& xvs = 
-	(XmlRpc::XmlRpcValue::ValueStruct)v;
-      for (XmlRpc::XmlRpcValue::ValueStruct::const_iterator it=
-	     xvs.begin(); it != xvs.end(); ++it) {
-	// not nice but cast operators in XmlRpcValue are not const
-	XmlRpcValue& var = const_cast<XmlRpcValue&>(it->second);
-	a[it->first] = AmArg();
-	xmlrpcval2amarg(var, a[it->first]);
-      }      
-    } break;
-#endif
-
-    case XmlRpcValue::TypeBase64: {
-      ArgBlob ab;
-      const XmlRpcValue::BinaryData& bd = v;
-      ab.len = bd.size();
-      ab.data = ab.len ? malloc(ab.len) : NULL;
-      if (!ab.data && ab.len) {
-        // preserve ArgBlob's len/data invariant on OOM and reject the RPC
-        ab.len = 0;
-        throw XmlRpcException("out of memory decoding Base64 parameter", 500);
-      }
-      XmlRpcValue::BinaryData::size_type i = 0;
-      for (XmlRpcValue::BinaryData::const_iterator it=
-       bd.begin(); it != bd.end(); ++it) {
-        ((char*)ab.data)[i] = *it;
-        ++i;
-      }
-      a = ab;
-    } break;
+  DBG("XMLRPC2DI: factory '%s' function '%s'\n", 
+      fact_name.c_str(), fct_name.c_str());
 
-      // TODO: support more types (datetime, struct, ...)
-    default:     throw XmlRpcException("unsupported parameter type", 400);
-    };
-  }
-}
+  // get args
+  AmArg args;
+  args.assertArray();
+  for (size_t i=2; i<params.size(); i++)
+    args.push(params.get(i));
 
-void XMLRPC2DIServer::amarg2xmlrpcval(const AmArg& a, 
-				      XmlRpcValue& result) {
-  switch (a.getType()) {
+  if (XMLRPC2DI::DebugServerParams) {
+    DBG(" params: <%s>\n", AmArg::print(args).c_str()); 
+  }
 
-  case AmArg::Undef:
-    result = 0; // XmlRpcValue();
-    break;
-  
-  case AmArg::Bool:  
-    result = a.asBool();
-    break;
-
-  case AmArg::CStr:  
-    //    DBG("a->X CSTR\n");
-    result = string(a.asCStr()); break;
-
-  case AmArg::Int:
-    //    DBG("a->X INT\n");  
-    result=a.asInt(); break;
-
-  case AmArg::Double: 
-    //    DBG("a->X DOUBLE\n");  
-    result=a.asDouble(); break;
-
-  case AmArg::Array:
-    //    DBG("a->X ARRAY size %u\n", a.size());  
-    result.setSize(a.size());
-    for (size_t i=0;i<a.size();i++) {
-      // duh... recursion...
-      amarg2xmlrpcval(a.get(i), result[i]);
-    }
-    break;
-
-  case AmArg::Struct:
-    //    DBG("a->X STRUCT size %u\n", a.size());  
-    for (AmArg::ValueStruct::const_iterator it = 
-	   a.begin(); it != a.end(); it++) {
-      // duh... recursion...
-      amarg2xmlrpcval(it->second, result[it->first]);
-    }
-    break;
+  AmDynInvokeFactory* di_f = AmPlugIn::instance()->getFactory4Di(fact_name);
+  if(!di_f){
+    throw XmlRpcFault("could not get factory", 500);
+  }
+  AmDynInvoke* di = di_f->getInstance();
+  if(!di){
+    throw XmlRpcFault("could not get instance from factory", 500);
+  }
+  invoke_di(di, fct_name, args, result);
 
-  default: { WARN("unsupported return value type %d\n", a.getType()); } break;
-    // TODO: do sth with the data here ?
+  if (XMLRPC2DI::DebugServerResult) {
+    DBG(" result: <%s>\n", AmArg::print(result).c_str()); 
   }
 }
 
 DIMethodProxy::DIMethodProxy(std::string const &server_method_name, 
 			     std::string const &di_method_name, 
 			     AmDynInvokeFactory* di_factory)
-  : XmlRpcServerMethod(server_method_name),
+  : XmlRpcMethod(server_method_name),
     di_method_name(di_method_name),
     server_method_name(server_method_name),
     di_factory(di_factory)
 { }    
   
-void DIMethodProxy::execute(XmlRpcValue& params, 
-			    XmlRpcValue& result) {
-
-  try {
-    if (NULL == di_factory) {
-      throw XmlRpcException("could not get DI factory", 500);
-    }
+void DIMethodProxy::execute(const AmArg& params, AmArg& result) {
+  if (NULL == di_factory) {
+    throw XmlRpcFault("could not get DI factory", 500);
+  }
   
-    AmDynInvoke* di = di_factory->getInstance();
-    if(NULL == di){
-      throw XmlRpcException("could not get instance from factory", 500);
-    }
-    
-    AmArg args, ret;
-
-    
-    DBG("XMLRPC2DI '%s': function '%s'\n", 
-	server_method_name.c_str(),
-	di_method_name.c_str());
+  AmDynInvoke* di = di_factory->getInstance();
+  if(NULL == di){
+    throw XmlRpcFault("could not get instance from factory", 500);
+  }
 
-    XMLRPC2DIServer::xmlrpcval2amarg(params, args);
-    if (XMLRPC2DI::DebugServerParams) {
-      DBG(" params: <%s>\n", AmArg::print(args).c_str()); 
-    }
+  DBG("XMLRPC2DI '%s': function '%s'\n", 
+      server_method_name.c_str(),
+      di_method_name.c_str());
 
-    di->invoke(di_method_name, args, ret);
+  if (XMLRPC2DI::DebugServerParams) {
+    DBG(" params: <%s>\n", AmArg::print(params).c_str()); 
+  }
 
-    if (XMLRPC2DI::DebugServerResult) {
-      DBG(" result: <%s>\n", AmArg::print(ret).c_str()); 
-    }
-    
-    XMLRPC2DIServer::amarg2xmlrpcval(ret, result);
+  invoke_di(di, di_method_name, params, result);
 
-  } catch (const XmlRpcException& e) {
-    throw;
-  } catch (const AmDynInvoke::NotImplemented& e) {
-    throw XmlRpcException("Exception: AmDynInvoke::NotImplemented: "
-			  + e.what, 504);
-  } catch (const AmArg::OutOfBoundsException& e) {
-    throw XmlRpcException("Exception: AmArg out of bounds - parameter number mismatch.", 300);
-  } catch (const AmArg::TypeMismatchException& e) {
-    throw XmlRpcException("Exception: Type mismatch in arguments.", 300);
-  } catch (const string& e) {
-    throw XmlRpcException("Exception: "+e, 500);
-  } catch (const std::exception& e) {
-    throw XmlRpcException("Exception: " + string(e.what()), 500);
-  } catch (...) {
-    throw XmlRpcException("Exception occured.", 500);
+  if (XMLRPC2DI::DebugServerResult) {
+    DBG(" result: <%s>\n", AmArg::print(result).c_str()); 
   }
 }
@@ -25,9 +25,8 @@
 #ifndef XMLRPC2DISERVER_H
 #define XMLRPC2DISERVER_H
 
-#include "XmlRpc.h"
-#include "MultithreadXmlRpcServer.h"
-using namespace XmlRpc;
+#include "AsyncXmlRpcServer.h"
+#include "TOXmlRpcClient.h"
 
 #include "AmThread.h"
 #include "AmApi.h"
@@ -39,19 +38,23 @@ using std::multimap;
 #include <string>
 using std::string;
 
+#include <vector>
+using std::vector;
+
 #include <time.h>
 
-#define DEF_XMLRPCSERVER_WORK_INTERVAL .200 /* 200 ms */
+/** idle client connections kept per server */
+#define XMLRPC_MAX_IDLE_CLIENTS 16
 
 #define DEF_XMLRPCSERVERMETHOD(cls_name, func_name)		\
   class cls_name						\
-  :  public XmlRpcServerMethod {				\
+  :  public XmlRpcMethod {					\
 								\
   public:							\
-  cls_name(XmlRpcServer* s) :					\
-    XmlRpcServerMethod(func_name, s) { }			\
+  cls_name(AsyncXmlRpcServer* s) :				\
+    XmlRpcMethod(func_name, s) { }				\
 								\
-	void execute(XmlRpcValue& params, XmlRpcValue& result); \
+	void execute(const AmArg& params, AmArg& result);	\
   }
 
 
@@ -73,16 +76,16 @@ DEF_XMLRPCSERVERMETHOD(XMLRPC2DIServerGetCPSLimitMethod, "get_cpslimit");
 
 
 class XMLRPC2DIServerDIMethod 
-:  public XmlRpcServerMethod { 
+:  public XmlRpcMethod { 
   
  public: 
-  XMLRPC2DIServerDIMethod(XmlRpcServer* s) : 
-    XmlRpcServerMethod("di", s) { } 
+  XMLRPC2DIServerDIMethod(AsyncXmlRpcServer* s) : 
+    XmlRpcMethod("di", s) { } 
 
-  void execute(XmlRpcValue& params, XmlRpcValue& result); 
+  void execute(const AmArg& params, AmArg& result); 
 };
 
-struct DIMethodProxy : public XmlRpcServerMethod
+struct DIMethodProxy : public XmlRpcMethod
 {
   std::string di_method_name;
   std::string server_method_name;
@@ -93,7 +96,7 @@ struct DIMethodProxy : public XmlRpcServerMethod
 		std::string const &di_method_name,
 		AmDynInvokeFactory* di_factory);
   
-  void execute(XmlRpcValue& params, XmlRpcValue& result);
+  void execute(const AmArg& params, AmArg& result);
 };
 
 class XMLRPC2DIServer
@@ -101,7 +104,7 @@ class XMLRPC2DIServer
   public AmThread,
   public AmEventHandler
 {
-  XmlRpcServer* s;
+  AsyncXmlRpcServer* s;
 
   unsigned int port; 
   string bind_ip;
@@ -133,7 +136,7 @@ class XMLRPC2DIServer
 		  const string& bind_ip,
 		  bool di_export, 
 		  string direct_export,
-		  XmlRpcServer* s);
+		  AsyncXmlRpcServer* s);
 
   bool initialize();
 
@@ -141,14 +144,6 @@ class XMLRPC2DIServer
   void on_stop();
 
   void waitUntilStarted() { running.wait_for(); }
-  
-  static void xmlrpcval2amargarray(XmlRpcValue& v, AmArg& a, 
-				   unsigned int start_index);
-
-  static void xmlrpcval2amarg(XmlRpcValue& v, AmArg& a);
-
-  /** convert all args in a into result*/
-  static void amarg2xmlrpcval(const AmArg& a, XmlRpcValue& result);
 };
 
 class  XMLRPCServerEntry {
@@ -165,6 +160,15 @@ class  XMLRPCServerEntry {
   string server;
   int port;
   string uri;
+
+  /** an idle client connected to this server, or a new one */
+  TOXmlRpcClient* getClient();
+  /** keep the client for the next request (or delete it) */
+  void putClient(TOXmlRpcClient* c);
+
+ private:
+  AmMutex clients_mut;
+  vector<TOXmlRpcClient*> idle_clients;
 };
 
 class XMLRPC2DI 
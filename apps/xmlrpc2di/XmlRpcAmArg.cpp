@@ -0,0 +1,585 @@
+#include "XmlRpcAmArg.h"
+
+#include "log.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static inline bool xml_space(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool all_space(const string& s) {
+  for (size_t i=0; i<s.length(); i++)
+    if (!xml_space(s[i]))
+      return false;
+  return true;
+}
+
+static void trim(string& s) {
+  size_t b = 0, e = s.length();
+  while (b < e && xml_space(s[b])) b++;
+  while (e > b && xml_space(s[e-1])) e--;
+  if (b || e < s.length())
+    s = s.substr(b, e - b);
+}
+
+static void append_utf8(unsigned long c, string& out) {
+  if (c < 0x80) {
+    out += (char)c;
+  } else if (c < 0x800) {
+    out += (char)(0xc0 | (c >> 6));
+    out += (char)(0x80 | (c & 0x3f));
+  } else if (c < 0x10000) {
+    out += (char)(0xe0 | (c >> 12));
+    out += (char)(0x80 | ((c >> 6) & 0x3f));
+    out += (char)(0x80 | (c & 0x3f));
+  } else {
+    out += (char)(0xf0 | (c >> 18));
+    out += (char)(0x80 | ((c >> 12) & 0x3f));
+    out += (char)(0x80 | ((c >> 6) & 0x3f));
+    out += (char)(0x80 | (c & 0x3f));
+  }
+}
+
+static const char b64_chars[] =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static bool base64_decode(const string& in, ArgBlob& blob) {
+  blob.data = malloc(in.length() / 4 * 3 + 3);
+  if (!blob.data)
+    return false;
+  unsigned char* out = (unsigned char*)blob.data;
+  unsigned int acc = 0, bits = 0;
+  int len = 0;
+  for (size_t i=0; i<in.length(); i++) {
+    char c = in[i];
+    unsigned int v;
+    if (c >= 'A' && c <= 'Z') v = c - 'A';
+    else if (c >= 'a' && c <= 'z') v = c - 'a' + 26;
+    else if (c >= '0' && c <= '9') v = c - '0' + 52;
+    else if (c == '+') v = 62;
+    else if (c == '/') v = 63;
+    else if (c == '=' || xml_space(c)) continue;
+    else return false;
+    acc = (acc << 6) | v;
+    bits += 6;
+    if (bits >= 8) {
+      bits -= 8;
+      out[len++] = (acc >> bits) & 0xff;
+    }
+  }
+  blob.len = len;
+  return true;
+}
+
+static void base64_append(const unsigned char* in, size_t len, string& out) {
+  size_t i = 0;
+  for (; i + 2 < len; i += 3) {
+    out += b64_chars[in[i] >> 2];
+    out += b64_chars[((in[i] & 0x03) << 4) | (in[i+1] >> 4)];
+    out += b64_chars[((in[i+1] & 0x0f) << 2) | (in[i+2] >> 6)];
+    out += b64_chars[in[i+2] & 0x3f];
+  }
+  if (i < len) {
+    out += b64_chars[in[i] >> 2];
+    if (i + 1 < len) {
+      out += b64_chars[((in[i] & 0x03) << 4) | (in[i+1] >> 4)];
+      out += b64_chars[(in[i+1] & 0x0f) << 2];
+    } else {
+      out += b64_chars[(in[i] & 0x03) << 4];
+      out += '=';
+    }
+    out += '=';
+  }
+}
+
+bool XmlRpcReader::Tag::is(const char* n) const {
+  return strlen(n) == len && !memcmp(name, n, len);
+}
+
+XmlRpcReader::XmlRpcReader(const char* buf, size_t len)
+  : p(buf), end(buf + len)
+{
+}
+
+bool XmlRpcReader::fail(const char* what) {
+  if (err.empty())
+    err = what;
+  return false;
+}
+
+void XmlRpcReader::skipSpace() {
+  while (p < end && xml_space(*p))
+    p++;
+}
+
+/** next tag, skipping white space, comments and processing instructions */
+bool XmlRpcReader::nextTag(Tag& tag) {
+  while (true) {
+    skipSpace();
+    if (p >= end)
+      return fail("unexpected end of document");
+    if (*p != '<')
+      return fail("unexpected text");
+
+    if (end - p >= 4 && !memcmp(p, "<!--", 4)) {
+      const char* c = (const char*)memmem(p + 4, end - p - 4, "-->", 3);
+      if (!c)
+	return fail("unterminated comment");
+      p = c + 3;
+      continue;
+    }
+    if (end - p >= 2 && p[1] == '?') {
+      const char* c = (const char*)memmem(p + 2, end - p - 2, "?>", 2);
+      if (!c)
+	return fail("unterminated processing instruction");
+      p = c + 2;
+      continue;
+    }
+    break;
+  }
+
+  p++;
+  tag.closing = p < end && *p == '/';
+  if (tag.closing)
+    p++;
+  tag.name = p;
+  while (p < end && !xml_space(*p) && *p != '/' && *p != '>')
+    p++;
+  tag.len = p - tag.name;
+  // attributes are not used in XML-RPC
+  while (p < end && *p != '>')
+    p++;
+  if (p >= end || !tag.len)
+    return fail("malformed tag");
+  tag.empty = !tag.closing && p[-1] == '/';
+  p++;
+  return true;
+}
+
+/** text up to the next tag, entities and CDATA decoded */
+bool XmlRpcReader::readText(string& text) {
+  text.clear();
+  while (p < end) {
+    const char* s = p;
+    while (p < end && *p != '<' && *p != '&')
+      p++;
+    text.append(s, p - s);
+    if (p >= end)
+      break;
+
+    if (*p == '<') {
+      if (end - p >= 9 && !memcmp(p, "<![CDATA[", 9)) {
+	const char* c = (const char*)memmem(p + 9, end - p - 9, "]]>", 3);
+	if (!c)
+	  return fail("unterminated CDATA");
+	text.append(p + 9, c - p - 9);
+	p = c + 3;
+	continue;
+      }
+      return true;
+    }
+
+    // entity
+    const char* semi = (const char*)memchr(p, ';', end - p < 12 ? end - p : 12);
+    if (!semi)
+      return fail("malformed entity");
+    string ent(p + 1, semi - p - 1);
+    if (ent == "lt") text += '<';
+    else if (ent == "gt") text += '>';
+    else if (ent == "amp") text += '&';
+    else if (ent == "quot") text += '"';
+    else if (ent == "apos") text += '\'';
+    else if (ent.length() > 1 && ent[0] == '#') {
+      char* e;
+      unsigned long c = ent[1] == 'x' ?
+	strtoul(ent.c_str() + 2, &e, 16) : strtoul(ent.c_str() + 1, &e, 10);
+      if (*e || c > 0x10ffff)
+	return fail("malformed character reference");
+      append_utf8(c, text);
+    }
+    else
+      return fail("unknown entity");
+    p = semi + 1;
+  }
+  return fail("unexpected end of document");
+}
+
+bool XmlRpcReader::expectOpen(const char* name, bool* empty) {
+  Tag t;
+  if (!nextTag(t))
+    return false;
+  if (t.closing || !t.is(name) || (t.empty && !empty)) {
+    err = string("expected <") + name + ">";
+    return false;
+  }
+  if (empty)
+    *empty = t.empty;
+  return true;
+}
+
+bool XmlRpcReader::expectClose(const char* name) {
+  Tag t;
+  if (!nextTag(t))
+    return false;
+  if (!t.closing || !t.is(name)) {
+    err = string("expected </") + name + ">";
+    return false;
+  }
+  return true;
+}
+
+bool XmlRpcReader::skipDecl() {
+  skipSpace();
+  // '<?xml ...?>' and comments are skipped by nextTag
+  return p < end || fail("empty document");
+}
+
+/** value after its <value> tag, up to and including </value> */
+bool XmlRpcReader::readValue(AmArg& a, unsigned int depth) {
+  if (depth > XMLRPC_MAX_DEPTH)
+    return fail("values nested too deep");
+
+  string text;
+  if (!readText(text))
+    return false;
+  Tag t;
+  if (!nextTag(t))
+    return false;
+  if (t.closing) {
+    if (!t.is("value"))
+      return fail("expected </value>");
+    // no type: string
+    a = AmArg(text);
+    return true;
+  }
+  if (!all_space(text))
+    return fail("text before value type");
+
+  return readTyped(t, a, depth) && expectClose("value");
+}
+
+bool XmlRpcReader::readTyped(const Tag& type, AmArg& a, unsigned int depth) {
+  string name(type.name, type.len);
+
+  if (name == "array") {
+    if (type.empty) {
+      a.assertArray();
+      return true;
+    }
+    return readArray(a, depth) && expectClose("array");
+  }
+  if (name == "struct") {
+    a.assertStruct();
+    if (type.empty)
+      return true;
+    return readStruct(a, depth);
+  }
+  if (name == "nil") {
+    a = AmArg();
+    return type.empty || expectClose("nil");
+  }
+
+  string text;
+  if (!type.empty && (!readText(text) || !expectClose(name.c_str())))
+    return false;
+
+  if (name == "string" || name == "dateTime.iso8601") {
+    a = AmArg(text);
+    return true;
+  }
+  if (name == "base64") {
+    ArgBlob blob;
+    if (!base64_decode(text, blob))
+      return fail("malformed base64");
+    a = AmArg(blob);
+    return true;
+  }
+
+  trim(text);
+  char* e;
+  errno = 0;
+  if (name == "i4" || name == "int" || name == "i8") {
+    long long v = strtoll(text.c_str(), &e, 10);
+    if (text.empty() || *e || errno)
+      return fail("malformed integer");
+    if (name == "i8")
+      a = AmArg(v);
+    else
+      a = AmArg((long int)v);
+    return true;
+  }
+  if (name == "boolean") {
+    if (text == "1" || text == "true")
+      a = AmArg(true);
+    else if (text == "0" || text == "false")
+      a = AmArg(false);
+    else
+      return fail("malformed boolean");
+    return true;
+  }
+  if (name == "double") {
+    double v = strtod(text.c_str(), &e);
+    if (text.empty() || *e)
+      return fail("malformed double");
+    a = AmArg(v);
+    return true;
+  }
+  return fail("unsupported value type");
+}
+
+/** after <array>, up to and including </data> */
+bool XmlRpcReader::readArray(AmArg& a, unsigned int depth) {
+  a.assertArray();
+  bool empty;
+  if (!expectOpen("data", &empty))
+    return false;
+  if (empty)
+    return true;
+
+  Tag t;
+  while (true) {
+    if (!nextTag(t))
+      return false;
+    if (t.closing && t.is("data"))
+      return true;
+    if (t.closing || !t.is("value"))
+      return fail("expected <value>");
+    if (t.empty) {
+      a.push(AmArg(""));
+      continue;
+    }
+    a.push(AmArg());
+    if (!readValue(a.back(), depth + 1))
+      return false;
+  }
+}
+
+/** after <struct>, up to and including </struct> */
+bool XmlRpcReader::readStruct(AmArg& a, unsigned int depth) {
+  Tag t;
+  string name;
+  while (true) {
+    if (!nextTag(t))
+      return false;
+    if (t.closing && t.is("struct"))
+      return true;
+    if (t.closing || t.empty || !t.is("member"))
+      return fail("expected <member>");
+
+    if (!expectOpen("name") || !readText(name) || !expectClose("name"))
+      return false;
+    bool empty;
+    if (!expectOpen("value", &empty))
+      return false;
+    AmArg& v = a[name];
+    if (empty)
+      v = AmArg("");
+    else if (!readValue(v, depth + 1))
+      return false;
+    if (!expectClose("member"))
+      return false;
+  }
+}
+
+bool XmlRpcReader::readCall(string& method, AmArg& params) {
+  params = AmArg();
+  if (!skipDecl() || !expectOpen("methodCall") || !expectOpen("methodName") ||
+      !readText(method) || !expectClose("methodName"))
+    return false;
+  trim(method);
+  if (method.empty())
+    return fail("empty methodName");
+
+  Tag t;
+  if (!nextTag(t))
+    return false;
+  if (t.closing)
+    return t.is("methodCall") || fail("expected </methodCall>");
+  if (!t.is("params"))
+    return fail("expected <params>");
+
+  if (!t.empty) {
+    while (true) {
+      if (!nextTag(t))
+	return false;
+      if (t.closing && t.is("params"))
+	break;
+      if (t.closing || t.empty || !t.is("param"))
+	return fail("expected <param>");
+      bool empty;
+      if (!expectOpen("value", &empty))
+	return false;
+      params.assertArray();
+      if (empty) {
+	params.push(AmArg(""));
+      } else {
+	params.push(AmArg());
+	if (!readValue(params.back(), 0))
+	  return false;
+      }
+      if (!expectClose("param"))
+	return false;
+    }
+  }
+  return expectClose("methodCall");
+}
+
+bool XmlRpcReader::readResponse(AmArg& result, bool& is_fault) {
+  result = AmArg();
+  is_fault = false;
+  if (!skipDecl() || !expectOpen("methodResponse"))
+    return false;
+
+  Tag t;
+  if (!nextTag(t))
+    return false;
+  if (t.closing || t.empty)
+    return fail("expected <params> or <fault>");
+
+  bool empty;
+  if (t.is("params")) {
+    if (!expectOpen("param") || !expectOpen("value", &empty))
+      return false;
+    if (empty)
+      result = AmArg("");
+    else if (!readValue(result, 0))
+      return false;
+    if (!expectClose("param") || !expectClose("params"))
+      return false;
+  } else if (t.is("fault")) {
+    is_fault = true;
+    if (!expectOpen("value") || !readValue(result, 0) || !expectClose("fault"))
+      return false;
+  } else {
+    return fail("expected <params> or <fault>");
+  }
+  return expectClose("methodResponse");
+}
+
+void xmlrpcAppendEscaped(const char* s, size_t len, string& out) {
+  const char* e = s + len;
+  while (s < e) {
+    const char* r = s;
+    while (r < e && *r != '<' && *r != '>' && *r != '&')
+      r++;
+    out.append(s, r - s);
+    if (r >= e)
+      break;
+    switch (*r) {
+    case '<': out += "&lt;"; break;
+    case '>': out += "&gt;"; break;
+    default:  out += "&amp;"; break;
+    }
+    s = r + 1;
+  }
+}
+
+static void append_int(long long v, string& out) {
+  char buf[32];
+  bool i4 = v >= -2147483648LL && v <= 2147483647LL;
+  snprintf(buf, sizeof(buf), i4 ? "<i4>%lld</i4>" : "<i8>%lld</i8>", v);
+  out += buf;
+}
+
+void xmlrpcAppendValue(const AmArg& a, string& out) {
+  out += "<value>";
+  switch (a.getType()) {
+  case AmArg::Undef:
+    out += "<i4>0</i4>";
+    break;
+
+  case AmArg::Int:
+    append_int(a.asInt(), out);
+    break;
+
+  case AmArg::LongLong:
+    append_int(a.asLongLong(), out);
+    break;
+
+  case AmArg::Bool:
+    out += a.asBool() ? "<boolean>1</boolean>" : "<boolean>0</boolean>";
+    break;
+
+  case AmArg::Double: {
+    // same format as xmlrpc++ (no exponent in XML-RPC)
+    char buf[400];
+    snprintf(buf, sizeof(buf), "<double>%f</double>", a.asDouble());
+    out += buf;
+  } break;
+
+  case AmArg::CStr: {
+    const char* s = a.asCStr();
+    out += "<string>";
+    xmlrpcAppendEscaped(s, strlen(s), out);
+    out += "</string>";
+  } break;
+
+  case AmArg::Blob: {
+    const ArgBlob* b = a.asBlob();
+    out += "<base64>";
+    base64_append((const unsigned char*)b->data, b->len, out);
+    out += "</base64>";
+  } break;
+
+  case AmArg::Array:
+    out += "<array><data>";
+    for (size_t i=0; i<a.size(); i++)
+      xmlrpcAppendValue(a.get(i), out);
+    out += "</data></array>";
+    break;
+
+  case AmArg::Struct:
+    out += "<struct>";
+    for (AmArg::ValueStruct::const_iterator it = a.begin(); it != a.end(); it++) {
+      out += "<member><name>";
+      xmlrpcAppendEscaped(it->first.c_str(), it->first.length(), out);
+      out += "</name>";
+      xmlrpcAppendValue(it->second, out);
+      out += "</member>";
+    }
+    out += "</struct>";
+    break;
+
+  default:
+    WARN("unsupported return value type %d\n", a.getType());
+    break;
+  }
+  out += "</value>";
+}
+
+void xmlrpcAppendCall(const string& method, const AmArg& params, string& out) {
+  out += "<?xml version=\"1.0\"?>\r\n<methodCall><methodName>";
+  xmlrpcAppendEscaped(method.c_str(), method.length(), out);
+  out += "</methodName><params>";
+  if (isArgArray(params)) {
+    for (size_t i=0; i<params.size(); i++) {
+      out += "<param>";
+      xmlrpcAppendValue(params.get(i), out);
+      out += "</param>";
+    }
+  } else if (!isArgUndef(params)) {
+    out += "<param>";
+    xmlrpcAppendValue(params, out);
+    out += "</param>";
+  }
+  out += "</params></methodCall>\r\n";
+}
+
+void xmlrpcAppendResponse(const AmArg& result, string& out) {
+  out += "<?xml version=\"1.0\"?>\r\n<methodResponse><params><param>";
+  xmlrpcAppendValue(result, out);
+  out += "</param></params></methodResponse>\r\n";
+}
+
+void xmlrpcAppendFault(int code, const string& message, string& out) {
+  out += "<?xml version=\"1.0\"?>\r\n<methodResponse><fault><value><struct>"
+    "<member><name>faultCode</name><value>";
+  append_int(code, out);
+  out += "</value></member><member><name>faultString</name><value><string>";
+  xmlrpcAppendEscaped(message.c_str(), message.length(), out);
+  out += "</string></value></member></struct></value></fault></methodResponse>\r\n";
+}
@@ -0,0 +1,91 @@
+#ifndef _XMLRPC_AMARG_H
+#define _XMLRPC_AMARG_H
+
+#include "AmArg.h"
+
+#include <string>
+using std::string;
+
+/** maximum nesting of arrays and structs in a value */
+#define XMLRPC_MAX_DEPTH 64
+
+/** thrown by server methods to return a fault */
+struct XmlRpcFault
+{
+  int code;
+  string message;
+
+  XmlRpcFault(const string& message, int code = -1)
+    : code(code), message(message) { }
+};
+
+/**
+ * XML-RPC reader converting straight into AmArg
+ *
+ * Single pass over the buffer without building a document tree:
+ * the tags are matched as they come, and values are created in place
+ * in the result. Types map as in XMLRPC2DI before: i4/int to Int, i8
+ * to LongLong, double, boolean, string (and untyped values), base64
+ * to Blob, array and struct; nil to Undef and dateTime.iso8601 as
+ * string.
+ */
+class XmlRpcReader
+{
+  const char* p;
+  const char* end;
+  string err;
+
+  struct Tag {
+    const char* name;
+    size_t len;
+    bool closing;
+    bool empty;
+
+    bool is(const char* n) const;
+  };
+
+  bool fail(const char* what);
+  void skipSpace();
+  bool nextTag(Tag& tag);
+  bool readText(string& text);
+  bool expectOpen(const char* name, bool* empty = NULL);
+  bool expectClose(const char* name);
+  bool skipDecl();
+
+  bool readValue(AmArg& a, unsigned int depth);
+  bool readTyped(const Tag& type, AmArg& a, unsigned int depth);
+  bool readArray(AmArg& a, unsigned int depth);
+  bool readStruct(AmArg& a, unsigned int depth);
+
+ public:
+  XmlRpcReader(const char* buf, size_t len);
+
+  /**
+   * read a methodCall
+   * @param params array of the params, Undef if there are none
+   */
+  bool readCall(string& method, AmArg& params);
+
+  /**
+   * read a methodResponse
+   * @param is_fault set if it is a fault, result is then the
+   *        struct with faultCode and faultString
+   */
+  bool readResponse(AmArg& result, bool& is_fault);
+
+  const string& error() const { return err; }
+};
+
+/** append a value (Undef as 0, as XMLRPC2DI did) */
+void xmlrpcAppendValue(const AmArg& a, string& out);
+
+/** append a methodCall, params being the array of params */
+void xmlrpcAppendCall(const string& method, const AmArg& params, string& out);
+
+void xmlrpcAppendResponse(const AmArg& result, string& out);
+void xmlrpcAppendFault(int code, const string& message, string& out);
+
+/** append text with the XML special characters escaped */
+void xmlrpcAppendEscaped(const char* s, size_t len, string& out);
+
+#endif
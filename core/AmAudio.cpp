@@ -31,6 +31,8 @@
 #include "AmSdp.h"
 #include "AmRtpStream.h"
 #include "AmConfig.h"
+#include "AmAudioProfiler.h"
+#include "AmPolyphaseResampler.h"
 #include "amci/codecs.h"
 #include "log.h"
 
@@ -262,12 +264,53 @@ unsigned int AmInternalResamplerState::resample(unsigned char *samples, unsigned
 }
 #endif
 
+AmPolyphaseResamplingState::AmPolyphaseResamplingState()
+  : poly_ratio(0.0)
+{
+}
+
+AmPolyphaseResamplingState::~AmPolyphaseResamplingState()
+{
+}
+
+unsigned int AmPolyphaseResamplingState::resample(unsigned char *samples, unsigned int s, double ratio)
+{
+  if (ratio != poly_ratio) {
+    poly.reset(AmPolyphaseResampler::create(ratio));
+    poly_ratio = ratio;
+    if (!poly.get() && (ratio != 1.0))
+      DBG("no polyphase filter for ratio %f\n", ratio);
+  }
+
+  if (poly.get()) {
+    unsigned int n = poly->resample((short*)samples, PCM16_B2S(s),
+				    (short*)samples, PCM16_B2S(AUDIO_BUFFER_SIZE));
+    return PCM16_S2B(n);
+  }
+
+  if (ratio == 1.0)
+    return s;
+
+  if (!fallback.get()) {
+#ifdef USE_LIBSAMPLERATE
+    fallback.reset(new AmLibSamplerateResamplingState());
+#elif defined(USE_INTERNAL_RESAMPLER)
+    fallback.reset(new AmInternalResamplerState());
+#else
+    return s;
+#endif
+  }
+
+  return fallback->resample(samples, s, ratio);
+}
+
 AmAudio::AmAudio()
   : rec_time(0),
     max_rec_time(-1),
     fmt(new AmAudioFormat(CODEC_PCM16)),
     input_resampling_state(nullptr),
-    output_resampling_state(nullptr)
+    output_resampling_state(nullptr),
+    resampling_type(AmConfig::ResamplingImplementationType)
 {
 }
 
@@ -276,7 +319,8 @@ AmAudio::AmAudio(AmAudioFormat *_fmt)
     max_rec_time(-1),
     fmt(_fmt),
     input_resampling_state(nullptr),
-    output_resampling_state(nullptr)
+    output_resampling_state(nullptr),
+    resampling_type(AmConfig::ResamplingImplementationType)
 {
 }
 
@@ -389,6 +433,7 @@ int AmAudio::decode(unsigned int size)
   }
 
   if(codec->decode){
+    AmAudioProfileScope prof(codec->id, AmAudioProfiler::Decode);
     s = (*codec->decode)(samples.back_buffer(),samples,s,
 			 fmt->channels,getSampleRate(),h_codec);
     if(s<0) return s;
@@ -407,6 +452,7 @@ int AmAudio::encode(unsigned int size)
 
   assert(codec);
   if(codec->encode){
+    AmAudioProfileScope prof(codec->id, AmAudioProfiler::Encode);
     s = (*codec->encode)(samples.back_buffer(),samples,(unsigned int) size,
 			 fmt->channels,getSampleRate(),h_codec);
     if(s<0) return s;
@@ -427,6 +473,34 @@ unsigned int AmAudio::downMix(unsigned int size)
   return s;
 }
 
+AmResamplingState* AmAudio::createResamplingState()
+{
+  switch (resampling_type) {
+  case POLYPHASE_RESAMPLER:
+    return new AmPolyphaseResamplingState();
+#ifdef USE_INTERNAL_RESAMPLER
+  case INTERNAL_RESAMPLER:
+    return new AmInternalResamplerState();
+#endif
+#ifdef USE_LIBSAMPLERATE
+  case LIBSAMPLERATE:
+    return new AmLibSamplerateResamplingState();
+#endif
+  default:
+    return NULL;
+  }
+}
+
+void AmAudio::setResamplingImplementation(ResamplingImplementationType type)
+{
+  if (type == resampling_type)
+    return;
+
+  resampling_type = type;
+  input_resampling_state.reset();
+  output_resampling_state.reset();
+}
+
 unsigned int AmAudio::resampleInput(unsigned char* buffer, unsigned int s, int input_sample_rate, int output_sample_rate)
 {
   if ((input_sample_rate == output_sample_rate) && !input_resampling_state.get()) {
@@ -434,20 +508,9 @@ unsigned int AmAudio::resampleInput(unsigned char* buffer, unsigned int s, int i
   }
 
   if (!input_resampling_state.get()) {
-#ifdef USE_INTERNAL_RESAMPLER
-    if (AmConfig::ResamplingImplementationType == AmAudio::INTERNAL_RESAMPLER) {
-      DBG("using internal resampler for input");
-      input_resampling_state.reset(new AmInternalResamplerState());
-    } else
-#endif
-#ifdef USE_LIBSAMPLERATE
-      if (AmConfig::ResamplingImplementationType == AmAudio::LIBSAMPLERATE) {
-	input_resampling_state.reset(new AmLibSamplerateResamplingState());
-      } else
-#endif
-	{
-	  return s;
-	}
+    input_resampling_state.reset(createResamplingState());
+    if (!input_resampling_state.get())
+      return s;
   }
 
   return resample(*input_resampling_state, buffer, s, input_sample_rate, output_sample_rate);
@@ -461,20 +524,9 @@ unsigned int AmAudio::resampleOutput(unsigned char* buffer, unsigned int s, int
   }
 
   if (!output_resampling_state.get()) {
-#ifdef USE_INTERNAL_RESAMPLER
-    if (AmConfig::ResamplingImplementationType == AmAudio::INTERNAL_RESAMPLER) {
-      DBG("using internal resampler for output");
-      output_resampling_state.reset(new AmInternalResamplerState());
-    } else
-#endif
-#ifdef USE_LIBSAMPLERATE
-      if (AmConfig::ResamplingImplementationType == AmAudio::LIBSAMPLERATE) {
-	output_resampling_state.reset(new AmLibSamplerateResamplingState());
-      } else
-#endif
-	{
-	  return s;
-	}
+    output_resampling_state.reset(createResamplingState());
+    if (!output_resampling_state.get())
+      return s;
   }
 
   return resample(*output_resampling_state, buffer, s, input_sample_rate, output_sample_rate);
@@ -485,6 +537,7 @@ unsigned int AmAudio::resample(AmResamplingState& rstate, unsigned char* buffer,
   if (!input_sample_rate)
     return 0;
 
+  AmAudioProfileScope prof(getCodecId(), AmAudioProfiler::Resample);
   return rstate.resample((unsigned char*) buffer, s, ((double) output_sample_rate) / ((double) input_sample_rate));
 }
 
@@ -49,6 +49,8 @@ using std::string;
 #include "resample/resample.h"
 #endif
 
+class AmPolyphaseResampler;
+
 #define PCM16_B2S(b) ((b) >> 1)
 #define PCM16_S2B(s) ((s) << 1)
 
@@ -121,6 +123,7 @@ public:
 };
 
 class AmAudio;
+class AmAudioRtpFormat;
 
 /**
  * \brief Audio format structure.
@@ -150,6 +153,9 @@ public:
   virtual amci_codec_t* getCodec();
   void resetCodec();
 
+  /** @return codec id (amci/codecs.h) */
+  int getCodecId() const { return codec_id; }
+
   /** return the sampling rate */
   unsigned int getRate() { return rate; }
 
@@ -230,6 +236,26 @@ public:
 };
 #endif
 
+/**
+ * \brief polyphase resampler (AmPolyphaseResampler)
+ *
+ * Ratios without a specialized filter are resampled with the
+ * libsamplerate or internal resampler, whichever is compiled in.
+ */
+class AmPolyphaseResamplingState: public AmResamplingState
+{
+private:
+  unique_ptr<AmPolyphaseResampler> poly;
+  double poly_ratio;
+  unique_ptr<AmResamplingState> fallback;
+
+public:
+  AmPolyphaseResamplingState();
+  virtual ~AmPolyphaseResamplingState();
+
+  virtual unsigned int resample(unsigned char* samples, unsigned int size, double ratio);
+};
+
 /**
  * \brief base for classes that input or output audio.
  *
@@ -248,6 +274,7 @@ public:
   enum ResamplingImplementationType {
 	LIBSAMPLERATE,
 	INTERNAL_RESAMPLER,
+	POLYPHASE_RESAMPLER,
 	UNAVAILABLE
   };
 
@@ -261,6 +288,9 @@ protected:
   /** Resampling states. @see AmResamplingState */
   unique_ptr<AmResamplingState> input_resampling_state;
   unique_ptr<AmResamplingState> output_resampling_state;
+  ResamplingImplementationType resampling_type;
+
+  AmResamplingState* createResamplingState();
 
   AmAudio();
   AmAudio(AmAudioFormat *);
@@ -366,14 +396,27 @@ public:
    */
   virtual int put(unsigned long long system_ts, unsigned char* buffer, 
 		  int input_sample_rate, unsigned int size);
+
+  /**
+   * Get the next frame already encoded for the RTP stream's format,
+   * if this source has it (e.g. prompts from the AmPromptCache).
+   * @return # bytes, 0 if not available (use get())
+   */
+  virtual int getEncoded(unsigned long long system_ts, unsigned char* buffer,
+			 AmAudioRtpFormat* rtp_fmt) { return 0; }
   
   int  getSampleRate();
+  /** @return codec id of the current format, -1 if none */
+  int  getCodecId() { return fmt.get() ? fmt->getCodecId() : -1; }
 
   void setRecordTime(unsigned int ms);
   int  incRecordTime(unsigned int samples);
 
   void setBufferedOutput(unsigned int buffer_size);
 
+  /** resampler for this audio (default: resampling_library) */
+  void setResamplingImplementation(ResamplingImplementationType type);
+
   void setFormat(AmAudioFormat* new_fmt);
 };
 
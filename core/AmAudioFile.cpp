@@ -26,8 +26,10 @@
  */
 
 #include "AmAudioFile.h"
+#include "AmAudioFileWriter.h"
 #include "AmPlugIn.h"
 #include "AmUtils.h"
+#include "AmConfig.h"
 
 #include <string.h>
 
@@ -244,6 +246,11 @@ int AmAudioFile::fpopen_int(const string& filename, OpenMode mode,
       setBufferSize(fd.buffer_size, fd.buffer_thresh, fd.buffer_full_thresh);
     }
     begin = ftell(fp);
+
+    if (mode == AmAudioFile::Write && async_write) {
+      writer = new AmAudioFileWriter(fp, AmConfig::AsyncAudioFileBuffer);
+      inc_ref(writer);
+    }
   } else {
     if(!iofmt->open)
       ERROR("no open function\n");
@@ -269,6 +276,7 @@ AmAudioFile::AmAudioFile()
   : AmBufferedAudio(0, 0, 0), fp(0),
     begin(0), iofmt(NULL), open_mode(0),
     data_size(0), on_close_done(false), close_on_exit(true),
+    async_write(AmConfig::AsyncAudioFileWrite), writer(NULL),
     loop(false),
     autorewind(false)
 {
@@ -317,6 +325,13 @@ void AmAudioFile::forward(unsigned int msec)
 
 void AmAudioFile::on_close()
 {
+  if(writer){
+    // wait until everything queued is in the file
+    writer->drain();
+    dec_ref(writer);
+    writer = NULL;
+  }
+
   if(fp && !on_close_done){
 
     AmAudioFileFormat* f_fmt = 
@@ -351,6 +366,31 @@ void AmAudioFile::on_close()
 
 void AmAudioFile::close()
 {
+  if(fp && writer && close_on_exit && !on_close_done){
+    // the writer thread updates the header and closes the file
+    // once everything queued is written
+    AmAudioFileFormat* f_fmt = 
+      dynamic_cast<AmAudioFileFormat*>(fmt.get());
+
+    if(f_fmt && iofmt){
+      amci_file_desc_t fmt_desc = { f_fmt->getSubtypeId(), 
+				    (int)f_fmt->getRate(),
+				    f_fmt->channels, 
+				    data_size ,
+				    0, 0, 0};
+
+      writer->finish(iofmt, new AmAudioFileFormat(f_fmt->getName(),
+						  f_fmt->getSubtypeId(),
+						  f_fmt->getSubtype()),
+		     fmt_desc, open_mode);
+      dec_ref(writer);
+      writer = NULL;
+      on_close_done = true;
+      fp = 0;
+      return;
+    }
+  }
+
   if(fp){
     on_close();
 
@@ -460,6 +500,16 @@ int AmAudioFile::write(unsigned int user_ts, unsigned int size)
     return size;
   }
 
+  if (writer) {
+    int s = writer->write((unsigned char*)samples,size);
+    if (s == AmAudioFileWriter::BufferFull)
+      return size; // frame dropped (overrun)
+    if (s < 0)
+      return -1;
+    data_size += size;
+    return size;
+  }
+
   int s = fwrite((void*)((unsigned char*)samples),1,size,fp);
   if(s>0)
     data_size += s;
@@ -31,6 +31,8 @@
 #include "AmAudio.h"
 #include "AmBufferedAudio.h"
 
+class AmAudioFileWriter;
+
 /** \brief \ref AmAudioFormat for file */
 class AmAudioFileFormat: public AmAudioFormat
 {
@@ -97,6 +99,10 @@ protected:
   bool on_close_done;
   bool close_on_exit;
 
+  /** write through the async file writer thread */
+  bool async_write;
+  AmAudioFileWriter* writer;
+
   /** @see AmAudio::read */
   int read(unsigned int user_ts, unsigned int size);
 
@@ -173,6 +179,18 @@ public:
   void setCloseOnDestroy(bool cod){
     close_on_exit = cod;
   }
+
+  /**
+   * In write mode, have the frames written to the file by the async
+   * file writer thread instead of the caller (media processor) thread.
+   * Takes effect at the next open(); default: async_audio_file_write
+   * in sems.conf. While recording, getfp() must not be used; on_close()
+   * waits until everything is written, close() leaves header update
+   * and closing of the file to the writer thread (if close-on-destroy).
+   */
+  void setAsyncWrite(bool aw) {
+    async_write = aw;
+  }
 };
 
 #endif
@@ -0,0 +1,119 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "AmAudioFileWriter.h"
+#include "AmAudioFile.h"
+#include "sip/async_file_writer.h"
+#include "log.h"
+
+#include <event2/event.h>
+#include <errno.h>
+#include <string.h>
+
+atomic_int64 AmAudioFileWriter::total_overruns;
+atomic_int64 AmAudioFileWriter::total_bytes;
+atomic_int   AmAudioFileWriter::active_writers;
+
+AmAudioFileWriter::AmAudioFileWriter(FILE* fp, unsigned int buffer_size)
+  : async_file(buffer_size), fp(fp), finish_file(false),
+    iofmt(NULL), open_mode(0), flushed(false), overruns(0)
+{
+  memset(&fmt_desc, 0, sizeof(amci_file_desc_t));
+  active_writers.inc();
+  // writer thread's reference, released after on_flushed()
+  inc_ref(this);
+}
+
+AmAudioFileWriter::~AmAudioFileWriter()
+{
+  active_writers.dec();
+}
+
+int AmAudioFileWriter::write(const void* buf, unsigned int len)
+{
+  int res = async_file::write(buf, len);
+  if (res == BufferFull) {
+    // drop the frame rather than blocking the media processor
+    overruns++;
+    total_overruns.inc();
+  }
+  return res;
+}
+
+int AmAudioFileWriter::write_to_file(const void* buf, unsigned int len)
+{
+  size_t res = fwrite(buf, 1, len, fp);
+  if (res != len) {
+    ERROR("writing audio file: %s\n", strerror(errno));
+    return -1;
+  }
+  total_bytes.inc(len);
+  return res;
+}
+
+void AmAudioFileWriter::on_flushed()
+{
+  if (finish_file) {
+    if (iofmt->on_close)
+      (*iofmt->on_close)(fp, &fmt_desc, open_mode,
+			 fmt->getHCodec(), fmt->getCodec());
+    fclose(fp);
+    fp = NULL;
+  } else {
+    fflush(fp);
+  }
+
+  if (overruns)
+    WARN("%llu frames dropped while recording (disk too slow?)\n", overruns);
+
+  flushed.set(true);
+
+  // still in write_cycle() with the lock held: release later
+  struct timeval tv = { 0, 0 };
+  event_base_once(async_file_writer::instance()->get_evbase(), -1, EV_TIMEOUT,
+		  release_cb, this, &tv);
+}
+
+void AmAudioFileWriter::release_cb(int sd, short what, void* ctx)
+{
+  dec_ref((AmAudioFileWriter*)ctx);
+}
+
+void AmAudioFileWriter::drain()
+{
+  async_file::close();
+  flushed.wait_for();
+}
+
+void AmAudioFileWriter::finish(amci_inoutfmt_t* _iofmt, AmAudioFileFormat* _fmt,
+			       const amci_file_desc_t& _fmt_desc, int _open_mode)
+{
+  finish_file = true;
+  iofmt = _iofmt;
+  fmt.reset(_fmt);
+  fmt_desc = _fmt_desc;
+  open_mode = _open_mode;
+  async_file::close();
+}
@@ -0,0 +1,110 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+/** @file AmAudioFileWriter.h */
+#ifndef _AmAudioFileWriter_h_
+#define _AmAudioFileWriter_h_
+
+#include "sip/async_file.h"
+#include "amci/amci.h"
+#include "atomic_types.h"
+#include "AmThread.h"
+
+#include <stdio.h>
+#include <memory>
+
+class AmAudioFileFormat;
+
+/**
+ * \brief buffer between AmAudioFile::write and the recording file
+ *
+ * The media processor thread only copies the encoded frames into
+ * the buffer; the async_file_writer thread writes them to the file
+ * in chunks of at least the write threshold.
+ *
+ * On close, the writer either hands back the file once everything
+ * is written (drain()), or finishes it itself: patches the header
+ * (iofmt->on_close) and closes the file (finish()).
+ *
+ * Reference counted: one reference is held by the owner and one by
+ * the writer thread until the buffer has been flushed.
+ */
+class AmAudioFileWriter
+  : public atomic_ref_cnt,
+    public async_file
+{
+  FILE* fp;
+
+  // for finish()
+  bool finish_file;
+  amci_inoutfmt_t* iofmt;
+  std::unique_ptr<AmAudioFileFormat> fmt;
+  amci_file_desc_t fmt_desc;
+  int open_mode;
+
+  AmCondition<bool> flushed;
+
+  unsigned long long overruns;
+
+  static atomic_int64 total_overruns;
+  static atomic_int64 total_bytes;
+  static atomic_int   active_writers;
+
+  static void release_cb(int sd, short what, void* ctx);
+
+protected:
+  // async_file API (executed in async_file_writer thread)
+  int write_to_file(const void* buf, unsigned int len);
+  void on_flushed();
+
+  ~AmAudioFileWriter();
+
+public:
+  AmAudioFileWriter(FILE* fp, unsigned int buffer_size);
+
+  /** queue a frame; counts an overrun if the buffer is full */
+  int write(const void* buf, unsigned int len);
+
+  unsigned long long getOverruns() { return overruns; }
+
+  /**
+   * Write everything buffered and wait for it.
+   * Only dec_ref() the writer afterwards.
+   */
+  void drain();
+
+  /**
+   * Write everything buffered, then update the header and close
+   * the file - all in the writer thread. Only dec_ref() the writer
+   * afterwards; fmt is owned by the writer.
+   */
+  void finish(amci_inoutfmt_t* iofmt, AmAudioFileFormat* fmt,
+	      const amci_file_desc_t& fmt_desc, int open_mode);
+
+  static unsigned long long getTotalOverruns() { return total_overruns.get(); }
+  static unsigned long long getTotalBytes() { return total_bytes.get(); }
+  static unsigned int getActiveWriters() { return active_writers.get(); }
+};
+
+#endif
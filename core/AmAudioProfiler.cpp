@@ -0,0 +1,202 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "AmAudioProfiler.h"
+#include "AmPlugIn.h"
+#include "AmThread.h"
+#include "AmUtils.h"
+#include "atomic_types.h"
+#include "amci/amci.h"
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <new>
+
+#include <stdlib.h>
+#include <string.h>
+
+#define PROFILE_ROWS AUDIO_PROFILE_ROWS
+#define CACHE_LINE 64
+
+struct alignas(CACHE_LINE) AmAudioProfileSlot
+{
+  atomic_int64 frames[PROFILE_ROWS][AmAudioProfiler::StageCount];
+  atomic_int64 ns[PROFILE_ROWS][AmAudioProfiler::StageCount];
+};
+
+/** releases the thread's slot on thread exit */
+struct AmAudioProfileSlotRef
+{
+  AmAudioProfileSlot* slot;
+
+  AmAudioProfileSlotRef(AmAudioProfileSlot* slot) : slot(slot) {}
+  ~AmAudioProfileSlotRef();
+};
+
+static AmMutex slots_mut;
+static std::vector<AmAudioProfileSlot*> slots;
+static std::vector<AmAudioProfileSlot*> free_slots;
+static AmThreadLocalStorage<AmAudioProfileSlotRef> thread_slot;
+
+AmAudioProfileSnapshot::AmAudioProfileSnapshot()
+  : taken(0)
+{
+  memset(frames, 0, sizeof(frames));
+}
+
+AmAudioProfileSlotRef::~AmAudioProfileSlotRef()
+{
+  AmLock l(slots_mut);
+  free_slots.push_back(slot);
+}
+
+static AmAudioProfileSlot* get_thread_slot()
+{
+  AmAudioProfileSlotRef* ref = thread_slot.get();
+  if (ref)
+    return ref->slot;
+
+  AmAudioProfileSlot* slot;
+  {
+    AmLock l(slots_mut);
+    if (!free_slots.empty()) {
+      slot = free_slots.back();
+      free_slots.pop_back();
+    } else {
+      // new does not align beyond max_align_t before C++17
+      void* mem = NULL;
+      if (posix_memalign(&mem, CACHE_LINE, sizeof(AmAudioProfileSlot)))
+	throw std::bad_alloc();
+      slot = new (mem) AmAudioProfileSlot();
+      slots.push_back(slot);
+    }
+  }
+
+  thread_slot.set(new AmAudioProfileSlotRef(slot));
+  return slot;
+}
+
+void AmAudioProfiler::add(int codec_id, Stage stage, unsigned long long ns)
+{
+  if (codec_id < 0 || codec_id >= AUDIO_PROFILE_CODECS)
+    codec_id = AUDIO_PROFILE_CODECS;
+
+  AmAudioProfileSlot* slot = get_thread_slot();
+  slot->frames[codec_id][stage].inc();
+  slot->ns[codec_id][stage].inc(ns);
+}
+
+const char* AmAudioProfiler::stageName(Stage stage)
+{
+  switch (stage) {
+  case Decode:      return "decode";
+  case Encode:      return "encode";
+  case Resample:    return "resample";
+  case PLC:         return "plc";
+  case WriteStream: return "write_stream";
+  default:          return "unknown";
+  }
+}
+
+/** name of the first payload using each codec */
+static void get_codec_names(std::map<int, string>& names)
+{
+  AmPlugIn* plugin = AmPlugIn::instance();
+  vector<SdpPayload> pl_vec;
+  plugin->getPayloads(pl_vec);
+
+  for (vector<SdpPayload>::iterator it = pl_vec.begin();
+       it != pl_vec.end(); it++) {
+    amci_payload_t* p = plugin->payload(it->payload_type);
+    if (p && names.find(p->codec_id) == names.end())
+      names[p->codec_id] = p->name;
+  }
+}
+
+void AmAudioProfiler::getStats(AmArg& ret, AmAudioProfileSnapshot* last)
+{
+  ret.assertStruct();
+  ret["enabled"] = AmConfig::AudioProfiling ? 1 : 0;
+
+  unsigned long long frames[PROFILE_ROWS][StageCount] = {};
+  unsigned long long ns[PROFILE_ROWS][StageCount] = {};
+
+  {
+    AmLock l(slots_mut);
+
+    for (std::vector<AmAudioProfileSlot*>::iterator it = slots.begin();
+	 it != slots.end(); it++) {
+      for (int c = 0; c < PROFILE_ROWS; c++) {
+	for (int s = 0; s < StageCount; s++) {
+	  frames[c][s] += (*it)->frames[c][s].get();
+	  ns[c][s] += (*it)->ns[c][s].get();
+	}
+      }
+    }
+  }
+
+  std::unique_ptr<AmLock> last_lock;
+  double interval = 0.0;
+  if (last) {
+    last_lock.reset(new AmLock(last->mut));
+    unsigned long long t = now();
+    interval = last->taken ? (t - last->taken) / 1e9 : 0.0;
+    last->taken = t;
+    ret["interval"] = interval;
+  }
+
+  std::map<int, string> names;
+  get_codec_names(names);
+
+  AmArg& codecs = ret["codecs"];
+  codecs.assertStruct();
+
+  for (int c = 0; c < PROFILE_ROWS; c++) {
+    string name;
+    if (c == AUDIO_PROFILE_CODECS) {
+      name = "other";
+    } else {
+      std::map<int, string>::iterator n_it = names.find(c);
+      name = n_it != names.end() ? n_it->second : "codec_" + int2str(c);
+    }
+
+    for (int s = 0; s < StageCount; s++) {
+      if (!frames[c][s])
+	continue;
+
+      AmArg& st = codecs[name][stageName((Stage)s)];
+      st["frames"] = (long int)frames[c][s];
+      st["ns"] = (long int)ns[c][s];
+      st["ns_per_frame"] = (long int)(ns[c][s] / frames[c][s]);
+      if (!last)
+	continue;
+
+      st["frames_per_sec"] = interval > 0.0 ?
+	(double)(frames[c][s] - last->frames[c][s]) / interval : 0.0;
+      last->frames[c][s] = frames[c][s];
+    }
+  }
+}
@@ -0,0 +1,127 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+/** @file AmAudioProfiler.h */
+#ifndef _AmAudioProfiler_h_
+#define _AmAudioProfiler_h_
+
+#include "AmConfig.h"
+#include "AmArg.h"
+#include "AmThread.h"
+
+#include <time.h>
+
+/** codec ids (amci/codecs.h) below this are accounted per codec */
+#define AUDIO_PROFILE_CODECS 128
+// last row: codecs without id or with id >= AUDIO_PROFILE_CODECS
+#define AUDIO_PROFILE_ROWS (AUDIO_PROFILE_CODECS + 1)
+
+class AmAudioProfileSnapshot;
+
+/**
+ * \brief CPU time accounting of the audio pipeline stages
+ *
+ * Every thread accounts into its own slot of counters (codec x stage),
+ * so that the media threads never share a lock or a cache line (the
+ * slots are cache line aligned); getStats() sums up the slots of all
+ * threads. Slots of exited
+ * threads are reused by new threads and keep their counters.
+ *
+ * Only active with audio_profiling=yes.
+ */
+class AmAudioProfiler
+{
+public:
+  enum Stage {
+    Decode = 0,
+    Encode,
+    Resample,
+    PLC,
+    WriteStream,
+    StageCount
+  };
+
+  static unsigned long long now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+  }
+
+  /** account one frame of stage for codec_id (-1: unknown codec) */
+  static void add(int codec_id, Stage stage, unsigned long long ns);
+
+  /**
+   * per-codec frames, ns and ns/frame for each stage; with last,
+   * also frames/s since last was taken, and last is updated
+   */
+  static void getStats(AmArg& ret, AmAudioProfileSnapshot* last = NULL);
+
+  static const char* stageName(Stage stage);
+};
+
+/**
+ * \brief counters of a previous AmAudioProfiler::getStats()
+ *
+ * Each consumer of the rates (stats server, SBC DI, ...) keeps its
+ * own, so that their queries don't shorten each other's interval.
+ */
+class AmAudioProfileSnapshot
+{
+  friend class AmAudioProfiler;
+
+  AmMutex mut;
+  unsigned long long frames[AUDIO_PROFILE_ROWS][AmAudioProfiler::StageCount];
+  unsigned long long taken;
+
+public:
+  AmAudioProfileSnapshot();
+};
+
+/** times its own scope as one frame of stage */
+class AmAudioProfileScope
+{
+  int codec_id;
+  AmAudioProfiler::Stage stage;
+  unsigned long long start;
+
+public:
+  AmAudioProfileScope(int codec_id, AmAudioProfiler::Stage stage)
+    : codec_id(codec_id), stage(stage),
+      start(AmConfig::AudioProfiling ? AmAudioProfiler::now() : 0)
+  {}
+
+  ~AmAudioProfileScope() {
+    if (start)
+      AmAudioProfiler::add(codec_id, stage, AmAudioProfiler::now() - start);
+  }
+
+  /** the codec is only known after the scope was entered */
+  void setCodec(int id) { codec_id = id; }
+};
+
+#endif
+
+// Local Variables:
+// mode:C++
+// End:
@@ -1,5 +1,6 @@
 #include "AmB2BMedia.h"
 #include "AmAudio.h"
+#include "AmAudioProfiler.h"
 #include "amci/codecs.h"
 #include <string.h>
 #include <strings.h>
@@ -159,6 +160,13 @@ void B2BMediaStatistics::getReport(const AmArg &args, AmArg &ret)
 
   ret["write"] = write_usage;
   ret["read"] = read_usage;
+
+  AmArg& pt = ret["passthrough"];
+  pt["passthrough_frames"] = (long int)passthrough_frames.get();
+  pt["passthrough_ms"] = (long int)passthrough_ms.get();
+  pt["transcoded_frames"] = (long int)transcoded_frames.get();
+  pt["transcoded_ms"] = (long int)transcoded_ms.get();
+  pt["switches"] = (long int)passthrough_switches.get();
 }
 
 //////////////////////////////////////////////////////////////////////////////////
@@ -448,6 +456,28 @@ void AudioStreamData::updateRecvStats(AmRtpStream *s)
   }
 }
 
+bool AudioStreamData::canPassthrough(AmRtpAudio *src_stream)
+{
+  if (!AmConfig::B2BMediaPassthrough) return false;
+
+  // somebody needs the decoded audio
+  if (dtmf_queue && enable_dtmf_transcoding) return false;
+
+  return src_stream->getPacketSamples() == stream->getFrameSize() &&
+    src_stream->sameEncoding(stream->getRtpFormat());
+}
+
+void AudioStreamData::setPassthrough(AmRtpAudio *src_stream, bool enable,
+                                     unsigned long long ts)
+{
+  if (src_stream->getPassthrough() == enable) return;
+
+  DBG("%s passthrough - RTP stream [%p] -> [%p]\n",
+      enable ? "entering" : "leaving", src_stream, stream);
+  src_stream->setPassthrough(enable, ts);
+  b2b_stats.incPassthroughSwitches();
+}
+
 int AudioStreamData::writeStream(unsigned long long ts, unsigned char *buffer, AudioStreamData &src)
 {
   if (!initialized) return 0;
@@ -456,16 +486,37 @@ int AudioStreamData::writeStream(unsigned long long ts, unsigned char *buffer, A
   unsigned int f_size = stream->getFrameSize();
   if (stream->sendIntReached(ts)) {
     // A leg is ready to send data
+    unsigned long long prof_start =
+      AmConfig::AudioProfiling ? AmAudioProfiler::now() : 0;
     int sample_rate = stream->getSampleRate();
+    unsigned int f_ms = sample_rate ? f_size * 1000 / sample_rate : 0;
     int got = 0;
-    if (in) got = in->get(ts, buffer, sample_rate, f_size);
+    if (in) {
+      if (src.isInitialized()) setPassthrough(src.getStream(), false, ts);
+      got = in->get(ts, buffer, sample_rate, f_size);
+    }
     else {
       if (!src.isInitialized()) return 0;
       AmRtpAudio *src_stream = src.getStream();
       if (src_stream->checkInterval(ts)) {
+        setPassthrough(src_stream, canPassthrough(src_stream), ts);
+
+        if (src_stream->getPassthrough()) {
+          // same encoding on both sides: forward the frame untouched
+          got = stream->getEncodedFrom(ts, src_stream, buffer);
+          if (got < 0) return -1;
+          if (got == 0) return 0;
+
+          updateRecvStats(src_stream);
+          updateSendStats();
+          b2b_stats.incPassthroughFrames(f_ms);
+          return stream->putEncoded(ts, buffer, got);
+        }
+
         got = src_stream->get(ts, buffer, sample_rate, f_size);
         if (got > 0) {
           updateRecvStats(src_stream);
+          b2b_stats.incTranscodedFrames(f_ms);
           if (dtmf_queue && enable_dtmf_transcoding) { 
 	    dtmf_queue->putDtmfAudio(buffer, got, ts);
 	  }
@@ -476,7 +527,12 @@ int AudioStreamData::writeStream(unsigned long long ts, unsigned char *buffer, A
     if (got > 0) {
       // we have data to be sent
       updateSendStats();
-      return stream->put(ts, buffer, sample_rate, got);
+      int res = stream->put(ts, buffer, sample_rate, got);
+      if (prof_start) {
+        AmAudioProfiler::add(stream->getCodecId(), AmAudioProfiler::WriteStream,
+                             AmAudioProfiler::now() - prof_start);
+      }
+      return res;
     }
   }
   return 0;
@@ -6,6 +6,7 @@
 #include "AmRtpAudio.h"
 #include "AmMediaProcessor.h"
 #include "AmDtmfDetector.h"
+#include "atomic_types.h"
 
 #include <map>
 
@@ -18,6 +19,13 @@ class B2BMediaStatistics
     std::map<string, int> codec_read_usage;
     AmMutex mutex;
 
+    // frames (and their duration) sent without / after transcoding
+    atomic_int64 passthrough_frames;
+    atomic_int64 passthrough_ms;
+    atomic_int64 transcoded_frames;
+    atomic_int64 transcoded_ms;
+    atomic_int64 passthrough_switches;
+
   public:
     void reportCodecWriteUsage(string &dst);
     void reportCodecReadUsage(string &dst);
@@ -28,6 +36,16 @@ class B2BMediaStatistics
     void decCodecWriteUsage(const string &codec_name);
     void incCodecReadUsage(const string &codec_name);
     void decCodecReadUsage(const string &codec_name);
+
+    void incPassthroughFrames(unsigned int ms) {
+      passthrough_frames.inc();
+      passthrough_ms.inc(ms);
+    }
+    void incTranscodedFrames(unsigned int ms) {
+      transcoded_frames.inc();
+      transcoded_ms.inc(ms);
+    }
+    void incPassthroughSwitches() { passthrough_switches.inc(); }
 };
 
 /** \brief Class for computing mask of payloads to relay
@@ -99,6 +117,10 @@ class AudioStreamData {
 
     bool receiving;
 
+    /** forward frames from src encoded instead of transcoding? */
+    bool canPassthrough(AmRtpAudio *src_stream);
+    void setPassthrough(AmRtpAudio *src_stream, bool enable, unsigned long long ts);
+
     // for performance monitoring
     int outgoing_payload;
     int incoming_payload;
@@ -24,6 +24,9 @@
  */
 
 #include "AmCachedAudioFile.h"
+#include "AmPromptCache.h"
+#include "AmRtpAudio.h"
+#include "AmConfig.h"
 #include "AmUtils.h"
 #include "log.h"
 #include "AmPlugIn.h"
@@ -105,17 +108,23 @@ int AmFileCache::read(void* buf,
   return r_size;
 }
 
-inline size_t AmFileCache::getSize() {
-  return data_size;
+AmCachedAudioFile::AmCachedAudioFile(AmFileCache* cache) 
+  : cache(cache), prompt(NULL), frames(NULL),
+    fpos(0), begin(0), good(false), loop(false)
+{
+  init();
 }
 
-inline const string& AmFileCache::getFilename() {
-  return name;
+AmCachedAudioFile::AmCachedAudioFile(AmPromptCacheEntry* prompt) 
+  : cache(prompt ? prompt->getFile() : NULL), prompt(prompt), frames(NULL),
+    fpos(0), begin(0), good(false), loop(false)
+{
+  if (prompt)
+    inc_ref(prompt);
+  init();
 }
 
-
-AmCachedAudioFile::AmCachedAudioFile(AmFileCache* cache) 
-  : cache(cache), fpos(0), begin(0), good(false), loop(false)
+void AmCachedAudioFile::init()
 {
   if (!cache) {
     ERROR("Need open file cache.\n");
@@ -163,6 +172,8 @@ AmCachedAudioFile::AmCachedAudioFile(AmFileCache* cache)
 }
 
 AmCachedAudioFile::~AmCachedAudioFile() {
+  if (prompt)
+    dec_ref(prompt);
 }
 
 AmAudioFileFormat* AmCachedAudioFile::fileName2Fmt(const string& name)
@@ -203,6 +214,9 @@ int AmCachedAudioFile::read(unsigned int user_ts, unsigned int size) {
   }
 
   int ret = cache->read((void*)((unsigned char*)samples),&fpos,size);
+
+  if (prompt)
+    AmPromptCache::frames_decoded.inc();
 	
   //DBG("s = %i; ret = %i\n",s,ret);
   if(loop.get() && (ret <= 0) && fpos==cache->getSize()){
@@ -220,6 +234,126 @@ int AmCachedAudioFile::read(unsigned int user_ts, unsigned int size) {
   return (fpos==cache->getSize() && !loop.get() ? -2 : ret);
 }
 
+int AmCachedAudioFile::getEncoded(unsigned long long system_ts,
+				  unsigned char* buffer,
+				  AmAudioRtpFormat* rtp_fmt)
+{
+  if (!good || !prompt || !rtp_fmt || !AmConfig::PromptCacheEncode)
+    return 0;
+
+  if (!frames || !frames->matches(rtp_fmt)) {
+    frames = prompt->getFrames(rtp_fmt);
+    if (!frames)
+      return 0;
+  }
+
+  // not encoded yet, anything not on a frame boundary (or the end
+  // of the file) goes the normal way through get()
+  if (!frames->ready || !frames->src_frame_bytes || fpos < begin)
+    return 0;
+
+  size_t offset = fpos - begin;
+  if (offset % frames->src_frame_bytes)
+    return 0;
+
+  size_t i = offset / frames->src_frame_bytes;
+  if (i >= frames->count())
+    return 0;
+
+  unsigned int len = frames->offsets[i+1] - frames->offsets[i];
+  if (!len || len > AUDIO_BUFFER_SIZE)
+    return 0;
+
+  memcpy(buffer, &frames->data[frames->offsets[i]], len);
+  fpos += frames->src_frame_bytes;
+
+  AmPromptCache::frames_encoded.inc();
+  return len;
+}
+
+bool AmCachedAudioFile::encodeFrames(amci_codec_t* codec,
+				     AmPromptFrames& f)
+{
+  if (!good)
+    return false;
+
+  unsigned int in_rate = getSampleRate();
+  unsigned int out_rate = f.rate;
+  if (!codec || !in_rate || !out_rate || !f.frame_size)
+    return false;
+
+  // a frame needs to map to a whole number of samples of the file
+  if (((unsigned long long)f.frame_size * in_rate) % out_rate)
+    return false;
+
+  unsigned int in_samples = f.frame_size * in_rate / out_rate;
+  unsigned int src_bytes = calcBytesToRead(in_samples);
+  if (!src_bytes || src_bytes > AUDIO_BUFFER_SIZE ||
+      PCM16_S2B(in_samples) > AUDIO_BUFFER_SIZE ||
+      PCM16_S2B(f.frame_size) > AUDIO_BUFFER_SIZE)
+    return false;
+
+  long h_codec = 0;
+  if (codec->init) {
+    const char* fmt_params_out = NULL;
+    amci_codec_fmt_info_t* fmt_i = NULL;
+    h_codec = (*codec->init)(f.format_parameters.c_str(),
+			     &fmt_params_out, &fmt_i);
+    if (h_codec == -1) {
+      ERROR("could not initialize codec %i\n", codec->id);
+      return false;
+    }
+  }
+
+  unsigned char enc_buf[AUDIO_BUFFER_SIZE];
+  const unsigned char* data = (const unsigned char*)cache->getData();
+  unsigned int n = (cache->getSize() - begin) / src_bytes;
+  bool ok = true;
+
+  f.offsets.reserve(n + 1);
+  f.offsets.push_back(0);
+
+  for (unsigned int i = 0; i < n; i++) {
+    memcpy((unsigned char*)samples, data + begin + i * src_bytes, src_bytes);
+
+    int s = decode(src_bytes);
+    if (s < 0) {
+      ok = false;
+      break;
+    }
+    s = downMix(s);
+    s = resampleOutput((unsigned char*)samples, s, in_rate, out_rate);
+
+    if (codec->encode) {
+      s = (*codec->encode)(enc_buf, samples, (unsigned int)s,
+			   f.channels, out_rate, h_codec);
+      if (s < 0) {
+	ok = false;
+	break;
+      }
+      f.data.insert(f.data.end(), enc_buf, enc_buf + s);
+    }
+    else {
+      f.data.insert(f.data.end(), (unsigned char*)samples,
+		    (unsigned char*)samples + s);
+    }
+    f.offsets.push_back(f.data.size());
+  }
+
+  if (codec->init && codec->destroy)
+    (*codec->destroy)(h_codec);
+
+  if (!ok) {
+    f.offsets.clear();
+    f.data.clear();
+    return false;
+  }
+
+  f.data.shrink_to_fit();
+  f.src_frame_bytes = src_bytes;
+  return true;
+}
+
 int AmCachedAudioFile::write(unsigned int user_ts, unsigned int size) {
   ERROR("AmCachedAudioFile writing not supported!\n");
   return -1;
@@ -30,6 +30,10 @@
 
 #include <string>
 
+class AmPromptCacheEntry;
+struct AmPromptFrames;
+class AmAudioRtpFormat;
+
 /**
  * \brief memory cache for AmAudioFile 
  * 
@@ -51,11 +55,11 @@ class AmFileCache
    */
   int load(const std::string& filename);
   /** get the size of the file */
-  size_t getSize();
+  size_t getSize() { return data_size; }
   /** read size bytes from pos into buf */
   int read(void* buf, size_t* pos, size_t size);
   /** get the filename */
-  const string& getFilename();
+  const string& getFilename() { return name; }
   /** get a pointer to the file's data - use with caution! */
   void* getData() { return data; }
 };
@@ -64,12 +68,19 @@ class AmFileCache
  * \brief AmAudio implementation for cached file
  *  
  *  This uses an AmFileCache instance to read the data 
- *  rather than a file. 
+ *  rather than a file. If opened from the AmPromptCache,
+ *  pre-encoded frames are sent where possible.
  */
 class AmCachedAudioFile 
 : public AmAudio
 {
+  friend class AmPromptCacheEntry;
+
   AmFileCache* cache;
+  /** shared prompt (referenced) if opened from the AmPromptCache */
+  AmPromptCacheEntry* prompt;
+  /** encoded frames last used */
+  AmPromptFrames* frames;
   /** current position */
   size_t fpos;
   /** beginning of data in file */
@@ -88,10 +99,20 @@ class AmCachedAudioFile
   /** Format of that file. @see fp, open(). */
   amci_inoutfmt_t* iofmt;
 
+  void init();
+
+  /** encode the whole file with codec into the format of f */
+  bool encodeFrames(amci_codec_t* codec, AmPromptFrames& f);
+
  public:
   AmCachedAudioFile(AmFileCache* cache);
+  AmCachedAudioFile(AmPromptCacheEntry* prompt);
   ~AmCachedAudioFile();
 
+  /** @see AmAudio::getEncoded */
+  int getEncoded(unsigned long long system_ts, unsigned char* buffer,
+		 AmAudioRtpFormat* rtp_fmt);
+
   /** loop the file? */
   AmSharedVar<bool> loop;
 
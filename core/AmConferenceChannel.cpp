@@ -99,6 +99,20 @@ int AmConferenceChannel::get(unsigned long long system_ts, unsigned char* buffer
   return size;
 }
 
+int AmConferenceChannel::getEncoded(unsigned long long system_ts,
+				    unsigned char* buffer,
+				    AmAudioRtpFormat* rtp_fmt)
+{
+  if (AmConfig::DumpConferenceStreams)
+    return 0;
+
+  AmMultiPartyMixer* mixer = status->getMixer();
+  mixer->lock();
+  int size = mixer->GetChannelPacketEncoded(channel_id,system_ts,buffer,rtp_fmt);
+  mixer->unlock();
+  return size;
+}
+
 ChannelWritingFile::ChannelWritingFile(const char* path) 
   : async_file(256*1024) // 256k buffer
 {
@@ -79,6 +79,9 @@ class AmConferenceChannel: public AmAudio
   int put(unsigned long long system_ts, unsigned char* buffer, 
 	  int input_sample_rate, unsigned int size);
 
+  int getEncoded(unsigned long long system_ts, unsigned char* buffer,
+		 AmAudioRtpFormat* rtp_fmt);
+
  public:
   AmConferenceChannel(AmConferenceStatus* status,
 		      int channel_id, string channel_tag, bool own_channel);
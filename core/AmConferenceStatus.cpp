@@ -26,153 +26,191 @@
 #include "AmConferenceStatus.h"
 #include "AmConferenceChannel.h"
 #include "AmMultiPartyMixer.h"
-#include "AmSessionContainer.h"
 
 #include "AmAudio.h"
+#include "sip/hash.h"
 #include "log.h"
 
 #include <assert.h>
 #include <unistd.h>
 
-std::map<std::string,AmConferenceStatus*> AmConferenceStatus::cid2status;
-AmMutex                         AmConferenceStatus::cid2s_mut;
+std::map<std::string,AmConferenceStatus*> AmConferenceStatus::cid2status[CONFERENCE_STATUS_BUCKETS];
+AmMutex                         AmConferenceStatus::cid2s_mut[CONFERENCE_STATUS_BUCKETS];
 
 //
 // static methods
 //
-AmConferenceChannel* AmConferenceStatus::getChannel(const string& cid, 
-						    const string& local_tag, int input_sample_rate)
+unsigned int AmConferenceStatus::hash(const string& cid)
 {
-  AmConferenceStatus*  st = 0;
-  AmConferenceChannel* ch = 0;
+  return hashlittle(cid.c_str(),cid.length(),0)
+    & (CONFERENCE_STATUS_BUCKETS-1);
+}
 
-  cid2s_mut.lock();
-  std::map<std::string,AmConferenceStatus*>::iterator it = cid2status.find(cid);
+AmConferenceStatus* AmConferenceStatus::get(unsigned int bucket, const string& cid)
+{
+  std::map<std::string,AmConferenceStatus*>::iterator it = cid2status[bucket].find(cid);
+  if(it != cid2status[bucket].end())
+    return it->second;
 
-  if(it != cid2status.end()){
+  AmConferenceStatus* st = new AmConferenceStatus(cid);
+  cid2status[bucket][cid] = st;
+  return st;
+}
 
-    st = it->second;
-  }
-  else {
-	
-    st = new AmConferenceStatus(cid);
-    cid2status[cid] = st;
+void AmConferenceStatus::postBatches(BatchList& to_post)
+{
+  for(BatchList::iterator it = to_post.begin(); it != to_post.end(); it++) {
+    (*it)->getMailbox()->post(*it);
   }
+  to_post.clear();
+}
 
-  ch = st->getChannel(local_tag, input_sample_rate);
-  cid2s_mut.unlock();
+AmConferenceChannel* AmConferenceStatus::getChannel(const string& cid, 
+						    const string& local_tag, int input_sample_rate)
+{
+  AmConferenceChannel* ch = 0;
+  BatchList to_post;
+
+  unsigned int bucket = hash(cid);
+  cid2s_mut[bucket].lock();
+  ch = get(bucket, cid)->getChannel(local_tag, input_sample_rate, to_post);
+  cid2s_mut[bucket].unlock();
 
+  postBatches(to_post);
   return ch;
 }
 
 size_t AmConferenceStatus::getConferenceSize(const string& cid) {
 
-  cid2s_mut.lock();
-  std::map<std::string,AmConferenceStatus*>::iterator it = cid2status.find(cid);
+  unsigned int bucket = hash(cid);
+  cid2s_mut[bucket].lock();
+  std::map<std::string,AmConferenceStatus*>::iterator it = cid2status[bucket].find(cid);
 
   size_t res = 0;
-  if(it != cid2status.end())
+  if(it != cid2status[bucket].end())
     res = it->second->channels.size();
 
-  cid2s_mut.unlock();
+  cid2s_mut[bucket].unlock();
 
   return res;
 }
 
 void AmConferenceStatus::postConferenceEvent(const string& cid, 
 					     int event_id, const string& sess_id) {
-  AmConferenceStatus*  st = 0;
+  BatchList to_post;
 
-  cid2s_mut.lock();
-  std::map<std::string,AmConferenceStatus*>::iterator it = cid2status.find(cid);
-
-  if(it != cid2status.end()){
-
-    st = it->second;
-  }
-  else {
-	
-    st = new AmConferenceStatus(cid);
-    cid2status[cid] = st;
-  }
+  unsigned int bucket = hash(cid);
+  cid2s_mut[bucket].lock();
+  get(bucket, cid)->postConferenceEvent(event_id, sess_id, to_post);
+  cid2s_mut[bucket].unlock();
 
-  st->postConferenceEvent(event_id, sess_id);
-  cid2s_mut.unlock();
+  postBatches(to_post);
 }
 
 void AmConferenceStatus::releaseChannel(const string& cid, unsigned int ch_id)
 {
-  cid2s_mut.lock();
-  std::map<std::string,AmConferenceStatus*>::iterator it = cid2status.find(cid);
+  BatchList to_post;
 
-  if(it != cid2status.end()){
+  unsigned int bucket = hash(cid);
+  cid2s_mut[bucket].lock();
+  std::map<std::string,AmConferenceStatus*>::iterator it = cid2status[bucket].find(cid);
+
+  if(it != cid2status[bucket].end()){
 
     AmConferenceStatus* st = it->second;
-    if(!st->releaseChannel(ch_id)){
-      cid2status.erase(it);
+    if(!st->releaseChannel(ch_id, to_post)){
+      cid2status[bucket].erase(it);
       delete st;
     }
   }
   else {
     ERROR("conference '%s' does not exists\n",cid.c_str());
   }
-  cid2s_mut.unlock();
+  cid2s_mut[bucket].unlock();
+
+  postBatches(to_post);
 }
 
 //
 // instance methods
 //
 
+AmConferenceStatus::Members::~Members()
+{
+  for(std::vector<AmEventMailbox*>::iterator it = mailboxes.begin();
+      it != mailboxes.end(); it++)
+    dec_ref(*it);
+}
+
+AmConferenceStatus::Members* AmConferenceStatus::Members::copy(const string& except_sess_id)
+{
+  Members* m = new Members();
+  m->mailboxes.reserve(mailboxes.size() + 1);
+  for(std::vector<AmEventMailbox*>::iterator it = mailboxes.begin();
+      it != mailboxes.end(); it++) {
+    if((*it)->getLocalTag() == except_sess_id)
+      continue;
+    inc_ref(*it);
+    m->mailboxes.push_back(*it);
+  }
+  inc_ref(m);
+  return m;
+}
+
 AmConferenceStatus::AmConferenceStatus(const string& conference_id)
-  : conf_id(conference_id), mixer(), sessions(), channels()
+  : conf_id(conference_id), mixer(), sessions(), channels(),
+    members(new Members())
 {
+  inc_ref(members);
 }
 
 AmConferenceStatus::~AmConferenceStatus()
 {
   DBG("AmConferenceStatus::~AmConferenceStatus(): conf_id = %s\n",conf_id.c_str());
+  dec_ref(members);
 }
 
-void AmConferenceStatus::postConferenceEvent(int event_id, const string& sess_id)
+AmConferenceStatus::Members* AmConferenceStatus::getMembers()
 {
   sessions_mut.lock();
-  int participants = sessions.size();
-  for(std::map<std::string, unsigned int>::iterator it = sessions.begin(); 
-      it != sessions.end(); it++){
-    AmSessionContainer::instance()->postEvent(
-					      it->first,
-					      new ConferenceEvent(event_id,
-								  participants,conf_id,sess_id)
-					      );
-  }
+  Members* m = members;
+  inc_ref(m);
   sessions_mut.unlock();
+  return m;
 }
 
-AmConferenceChannel* AmConferenceStatus::getChannel(const string& sess_id, int input_sample_rate)
+void AmConferenceStatus::addEvent(Members* to, int event_id, unsigned int participants,
+				  const string& sess_id, BatchList& to_post)
+{
+  for(std::vector<AmEventMailbox*>::iterator it = to->mailboxes.begin();
+      it != to->mailboxes.end(); it++) {
+    AmEventBatch* batch =
+      (*it)->add(new ConferenceEvent(event_id,participants,conf_id,sess_id));
+    if(batch)
+      to_post.push_back(batch);
+  }
+}
+
+void AmConferenceStatus::postConferenceEvent(int event_id, const string& sess_id,
+					     BatchList& to_post)
+{
+  Members* m = getMembers();
+  addEvent(m, event_id, m->mailboxes.size(), sess_id, to_post);
+  dec_ref(m);
+}
+
+AmConferenceChannel* AmConferenceStatus::getChannel(const string& sess_id, int input_sample_rate,
+						    BatchList& to_post)
 {
   AmConferenceChannel* ch = 0;
+  Members* notify = NULL;
+  unsigned int participants = 0;
 
   sessions_mut.lock();
   std::map<std::string, unsigned int>::iterator it = sessions.find(sess_id);
   if(it != sessions.end()){
     ch = new AmConferenceChannel(this,it->second,sess_id,false);
   } else {
-    if(!sessions.empty()){
-      int participants = sessions.size()+1;
-      for(it = sessions.begin(); it != sessions.end(); it++){
-	AmSessionContainer::instance()->postEvent(
-						  it->first,
-						  new ConferenceEvent(ConfNewParticipant,
-								      participants,conf_id,sess_id)
-						  );
-      }
-    } else {
-      // The First participant gets its own NewParticipant message
-      AmSessionContainer::instance()->postEvent(
-						sess_id, new ConferenceEvent(ConfNewParticipant,1,
-									     conf_id,sess_id));
-    }
-
     unsigned int ch_id = mixer.addChannel(input_sample_rate);
     SessInfo* si = new SessInfo(sess_id,ch_id);
 
@@ -181,15 +219,39 @@ AmConferenceChannel* AmConferenceStatus::getChannel(const string& sess_id, int i
 
     ch = new AmConferenceChannel(this,ch_id,sess_id, true);
 
+    Members* m = members->copy(sess_id);
+    m->mailboxes.push_back(new AmEventMailbox(sess_id));
+    inc_ref(m->mailboxes.back());
+
+    // the others get the NewParticipant message -
+    // the first participant gets its own
+    if(!members->mailboxes.empty())
+      notify = members;
+    else
+      dec_ref(members);
+
+    members = m;
+    if(!notify) {
+      notify = members;
+      inc_ref(notify);
+    }
+    participants = sessions.size();
   }
   sessions_mut.unlock();
 
+  if(notify) {
+    addEvent(notify, ConfNewParticipant, participants, sess_id, to_post);
+    dec_ref(notify);
+  }
+
   return ch;
 }
 
-int AmConferenceStatus::releaseChannel(unsigned int ch_id)
+int AmConferenceStatus::releaseChannel(unsigned int ch_id, BatchList& to_post)
 {
   unsigned int participants=0;
+  Members* notify = NULL;
+  string sess_id;
 
   sessions_mut.lock();
   std::map<unsigned int, SessInfo*>::iterator it = channels.find(ch_id);
@@ -202,17 +264,14 @@ int AmConferenceStatus::releaseChannel(unsigned int ch_id)
     mixer.removeChannel(ch_id);
 
     participants = channels.size();
-    std::map<std::string, unsigned int>::iterator s_it;
-    for(s_it = sessions.begin(); s_it != sessions.end(); s_it++){
-	    
-      AmSessionContainer::instance()->postEvent(
-						s_it->first,
-						new ConferenceEvent(ConfParticipantLeft,
-								    participants,
-								    conf_id, si->sess_id));
-    }
+    sess_id = si->sess_id;
+
+    notify = members->copy(sess_id);
+    dec_ref(members);
+    members = notify;
+    inc_ref(notify);
+
     delete si;
-	
   }
   else {
     participants = channels.size();
@@ -221,5 +280,10 @@ int AmConferenceStatus::releaseChannel(unsigned int ch_id)
   }
   sessions_mut.unlock();
 
+  if(notify) {
+    addEvent(notify, ConfParticipantLeft, participants, sess_id, to_post);
+    dec_ref(notify);
+  }
+
   return participants;
 }
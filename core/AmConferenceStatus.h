@@ -32,6 +32,7 @@
 #include "AmEventQueue.h"
 
 #include <map>
+#include <vector>
 #include <string>
 using std::string;
 
@@ -58,15 +59,26 @@ struct ConferenceEvent: public AmEvent
   {}
 };
 
+#define CONFERENCE_STATUS_POWER   6
+#define CONFERENCE_STATUS_BUCKETS (1<<CONFERENCE_STATUS_POWER)
+
 /**
  * \brief One conference (room).
  * 
  * The ConferenceStatus manages one conference.
+ *
+ * Conferences are kept in CONFERENCE_STATUS_BUCKETS buckets by
+ * conference ID, each with its own lock, so joins and leaves in
+ * different conferences do not wait for each other. Conference events
+ * are added to per participant AmEventMailbox'es under that lock (which
+ * keeps their order), but posted to the sessions after it is released.
  */
 class AmConferenceStatus
 {
-  static std::map<string,AmConferenceStatus*> cid2status;
-  static AmMutex                         cid2s_mut;
+  static std::map<string,AmConferenceStatus*> cid2status[CONFERENCE_STATUS_BUCKETS];
+  static AmMutex                         cid2s_mut[CONFERENCE_STATUS_BUCKETS];
+
+  static unsigned int hash(const string& cid);
 
   struct SessInfo {
 
@@ -80,6 +92,22 @@ class AmConferenceStatus
     {}
   };
 
+  /**
+   * the participants at some point in time, with the mailboxes for their
+   * events. Never changed once set up: a changed copy replaces it.
+   */
+  struct Members
+    : public atomic_ref_cnt
+  {
+    std::vector<AmEventMailbox*> mailboxes;
+
+    ~Members();
+    /** copy without the participant sess_id */
+    Members* copy(const string& except_sess_id);
+  };
+
+  typedef std::vector<AmEventBatch*> BatchList;
+
   string                 conf_id;
   AmMultiPartyMixer      mixer;
     
@@ -89,16 +117,33 @@ class AmConferenceStatus
   // ch_id -> sess_id
   std::map<unsigned int, SessInfo*> channels;
 
+  /** current participants, replaced under sessions_mut */
+  Members*               members;
+
   AmMutex                      sessions_mut;
 
   AmConferenceStatus(const string& conference_id);
   ~AmConferenceStatus();
 
-  AmConferenceChannel* getChannel(const string& sess_id, int input_sample_rate);
+  /** current participants, to dec_ref() after use */
+  Members* getMembers();
+
+  /** status of cid from its bucket, created if not there */
+  static AmConferenceStatus* get(unsigned int bucket, const string& cid);
+
+  AmConferenceChannel* getChannel(const string& sess_id, int input_sample_rate,
+				  BatchList& to_post);
+
+  int releaseChannel(unsigned int ch_id, BatchList& to_post);
 
-  int releaseChannel(unsigned int ch_id);
+  void postConferenceEvent(int event_id, const string& sess_id,
+			   BatchList& to_post);
 
-  void postConferenceEvent(int event_id, const string& sess_id);
+  /** add event to the members' mailboxes, collects batches to post */
+  void addEvent(Members* to, int event_id, unsigned int participants,
+		const string& sess_id, BatchList& to_post);
+  /** post collected batches, without locks held */
+  static void postBatches(BatchList& to_post);
 
 public:
   const string&      getConfID() { return conf_id; }
@@ -86,7 +86,16 @@ unsigned int AmConfig::RtpMuxMTUThreshold      = DEFAULT_MUX_MTU_THRESHOLD;
 unsigned int AmConfig::RtpMuxMaxFrameAgeMs     = DEFAULT_MUX_MAX_FRAME_AGE_MS;
 
 int          AmConfig::SessionProcessorThreads = NUM_SESSION_PROCESSORS;
+AmConfig::SessionExecutorType AmConfig::SessionExecutor = AmConfig::SessionExecThread;
+int          AmConfig::SessionExecutorThreads  = 0;
 int          AmConfig::MediaProcessorThreads   = NUM_MEDIA_PROCESSORS;
+bool         AmConfig::AsyncAudioFileWrite     = false;
+int          AmConfig::AsyncAudioFileBuffer    = 256*1024;
+bool         AmConfig::PromptCacheEncode       = true;
+unsigned long long AmConfig::PromptCacheMaxEncoded = 64*1024*1024;
+unsigned long long AmConfig::PromptCacheMaxMapped = 256*1024*1024;
+bool         AmConfig::AudioProfiling          = false;
+bool         AmConfig::B2BMediaPassthrough     = false;
 int          AmConfig::RTPReceiverThreads      = NUM_RTP_RECEIVERS;
 int          AmConfig::SIPServerThreads        = NUM_SIP_SERVERS;
 string       AmConfig::OutboundProxy           = "";
@@ -141,6 +150,7 @@ string AmConfig::TranscoderOutStatsHdr; // empty by default
 string AmConfig::TranscoderInStatsHdr; // empty by default
 
 bool AmConfig::DumpConferenceStreams = false;
+unsigned int AmConfig::ConferenceActiveSpeakers = 0;
 string AmConfig::DumpConferencePath = "/tmp";
 
 Am100rel::State AmConfig::rel100 = Am100rel::REL100_SUPPORTED;
@@ -587,6 +597,46 @@ int AmConfig::readConfiguration()
 #endif
   }
 
+  if(cfg.hasParameter("session_executor")){
+    string se = cfg.getParameter("session_executor");
+    if (se == "thread") {
+      SessionExecutor = SessionExecThread;
+    } else if (se == "workstealing") {
+#ifdef SESSION_THREADPOOL
+      WARN("session_executor=workstealing ignored, SEMS is compiled with"
+	   " SESSION_THREADPOOL support.\n");
+#else
+      SessionExecutor = SessionExecWorkStealing;
+#endif
+    } else {
+      ERROR("invalid session_executor value '%s' specified\n", se.c_str());
+      ret = -1;
+    }
+  }
+
+  SessionExecutorThreads =
+    cfg.getParameterInt("session_executor_threads", SessionExecutorThreads);
+
+  AsyncAudioFileWrite = cfg.getParameter("async_audio_file_write") == "yes";
+  AsyncAudioFileBuffer = cfg.getParameterInt("async_audio_file_buffer",
+					     AsyncAudioFileBuffer);
+  if (AsyncAudioFileWrite && AsyncAudioFileBuffer <= 128*1024) {
+    ERROR("async_audio_file_buffer must be larger than 128k\n");
+    ret = -1;
+  }
+
+  if (cfg.hasParameter("prompt_cache_encode"))
+    PromptCacheEncode = cfg.getParameter("prompt_cache_encode") == "yes";
+  if (cfg.hasParameter("prompt_cache_max_encoded"))
+    PromptCacheMaxEncoded = (unsigned long long)
+      cfg.getParameterInt("prompt_cache_max_encoded") * 1024 * 1024;
+  if (cfg.hasParameter("prompt_cache_max_mapped"))
+    PromptCacheMaxMapped = (unsigned long long)
+      cfg.getParameterInt("prompt_cache_max_mapped") * 1024 * 1024;
+
+  AudioProfiling = cfg.getParameter("audio_profiling") == "yes";
+  B2BMediaPassthrough = cfg.getParameter("b2b_media_passthrough") == "yes";
+
   if(cfg.hasParameter("media_processor_threads")){
     if(!setMediaProcessorThreads(cfg.getParameter("media_processor_threads"))){
       ERROR("invalid media_processor_threads value specified");
@@ -712,6 +762,8 @@ int AmConfig::readConfiguration()
   TranscoderInStatsHdr = cfg.getParameter("transcoder_in_stats_hdr");
 
   DumpConferenceStreams =  cfg.getParameter("dump_conference_streams")=="true";
+  ConferenceActiveSpeakers =
+    cfg.getParameterInt("conference_active_speakers", ConferenceActiveSpeakers);
   DumpConferencePath = cfg.getParameter("dump_conference_path");
 
   if (cfg.hasParameter("100rel")) {
@@ -734,6 +786,14 @@ int AmConfig::readConfiguration()
 	if (resamplings == "libsamplerate") {
 	  ResamplingImplementationType = AmAudio::LIBSAMPLERATE;
 	}
+	else if (resamplings == "polyphase") {
+	  ResamplingImplementationType = AmAudio::POLYPHASE_RESAMPLER;
+	}
+#ifdef USE_INTERNAL_RESAMPLER
+	else if (resamplings == "internal") {
+	  ResamplingImplementationType = AmAudio::INTERNAL_RESAMPLER;
+	}
+#endif
   }
 
   return ret;
@@ -181,8 +181,30 @@ struct AmConfig
 
   /** number of session (signaling/application) processor threads */
   static int SessionProcessorThreads;
+  /** how sessions are run: own thread or session executor */
+  enum SessionExecutorType {
+    SessionExecThread = 0,
+    SessionExecWorkStealing
+  };
+  static SessionExecutorType SessionExecutor;
+  /** number of session executor threads (0: one per CPU) */
+  static int SessionExecutorThreads;
   /** number of media processor threads */
   static int MediaProcessorThreads;
+  /** write recorded audio files from the async file writer thread */
+  static bool AsyncAudioFileWrite;
+  /** buffer size per recorded file with async_audio_file_write */
+  static int AsyncAudioFileBuffer;
+  /** send prompts from the prompt cache pre-encoded */
+  static bool PromptCacheEncode;
+  /** max bytes of pre-encoded prompt frames */
+  static unsigned long long PromptCacheMaxEncoded;
+  /** max bytes of mapped prompt files, unused ones are dropped above */
+  static unsigned long long PromptCacheMaxMapped;
+  /** account CPU time of codecs, resampling and PLC (AmAudioProfiler) */
+  static bool AudioProfiling;
+  /** forward frames between B2B legs with the same codec undecoded */
+  static bool B2BMediaPassthrough;
   /** number of RTP receiver threads */
   static int RTPReceiverThreads;
   /** number of SIP server threads */
@@ -271,6 +293,8 @@ struct AmConfig
   static string TranscoderInStatsHdr;
 
   static bool DumpConferenceStreams;
+  /** mix only this many loudest conference participants (0: all) */
+  static unsigned int ConferenceActiveSpeakers;
   static string DumpConferencePath;
 
   static Am100rel::State rel100;
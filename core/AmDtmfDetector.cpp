@@ -34,6 +34,7 @@
 #include <netinet/in.h>
 #include <math.h>
 #include <sys/time.h>
+#include <string.h>
 
 // per RFC this is 5000ms, but in reality then 
 // one needs to wait 5 sec on the first keypress
@@ -530,28 +531,9 @@ static int IVR_dtmf_matrix[4][4] =
 
 #define REL_DTMF_TRESH     4000     /* above this is dtmf                         */
 #define REL_SILENCE_TRESH   200     /* below this is silence                      */
-#define REL_AMP_BITS          9     /* bits per sample, reduced to avoid overflow */
-#define PI              3.1415926
+#define REL_AMP_BITS        GOERTZEL_AMP_BITS
 #define NELEMSOF(x) (sizeof(x)/sizeof(*x))
 
-/** \brief DTMF tone filter type */
-typedef struct {
-  int freq;			/* frequency */
-  int grp;			/* low/high group */
-} dtmf_t;
-
-static dtmf_t dtmf_tones[8] = 
-  {
-    { 697, LOGRP},
-    { 770, LOGRP},
-    { 852, LOGRP},
-    { 941, LOGRP},
-    {1209, HIGRP},
-    {1336, HIGRP},
-    {1477, HIGRP},
-    {1633, HIGRP}
-  };
-
 static char dtmf_matrix[4][4] =
   {
     {'1', '2', '3', 'A'},
@@ -560,7 +542,8 @@ static char dtmf_matrix[4][4] =
     {'*', '0', '#', 'D'}
   };
 
-AmSemsInbandDtmfDetector::AmSemsInbandDtmfDetector(AmKeyPressSink *keysink, int sample_rate)
+AmSemsInbandDtmfDetector::AmSemsInbandDtmfDetector(AmKeyPressSink *keysink, int sample_rate,
+						   const AmGoertzelKernels* kernels)
   : AmInbandDtmfDetector(keysink),
     SAMPLERATE(sample_rate),
     m_buf(),
@@ -569,58 +552,30 @@ AmSemsInbandDtmfDetector::AmSemsInbandDtmfDetector(AmKeyPressSink *keysink, int
     m_result(),
     m_lastCode(0),
     m_last_ts(0),
-    m_count(0)
+    m_count(0),
+    kernels(kernels ? kernels : AmGoertzelKernels::get())
 {
-  /* precalculate 2 * cos (2 PI k / N) */
-  for(unsigned i = 0; i < NELEMSOF(rel_cos2pik); i++) {
-    // FIXME: fixed samplerate. won't work for wideband
-    int k = (int)((double)dtmf_tones[i].freq * REL_DTMF_NPOINTS / SAMPLERATE + 0.5);
-    rel_cos2pik[i] = (int)(2 * 32768 * cos(2 * PI * k / REL_DTMF_NPOINTS));
-  }
+  AmGoertzelKernels::toneCoefficients(SAMPLERATE, rel_cos2pik);
+  AmGoertzelKernels::toneCoefficients(SAMPLERATE, rel_cos2pik + REL_NCOEFF);
 }
+
 AmSemsInbandDtmfDetector::~AmSemsInbandDtmfDetector() {
+  AmInbandDtmfBatch* batch = AmInbandDtmfBatch::current();
+  if (batch)
+    batch->cancel(this);
 }
 
 /*
- * Goertzel algorithm.
- * See http://ptolemy.eecs.berkeley.edu/~pino/Ptolemy/papers/96/dtmf_ict/
- * for more info.
+ * Goertzel algorithm over the tones of one block (the other half of
+ * the lanes is not used here; batches fill it with another stream).
  */
-
 void AmSemsInbandDtmfDetector::isdn_audio_goertzel_relative()
 {
-  int sk, sk1, sk2;
-
-  for (int k = 0; k < REL_NCOEFF; k++) {
-    // like m_buf, sk..sk2 are in (32-REL_AMP_BITS).REL_AMP_BITS fixed-point format
-    sk = sk1 = sk2 = 0;
-    for (int n = 0; n < REL_DTMF_NPOINTS; n++) {
-      sk = m_buf[n] + ((rel_cos2pik[k] * sk1) >> 15) - sk2;
-      sk2 = sk1;
-      sk1 = sk;
-    }
-    /* Avoid overflows */
-    sk >>= 1;
-    sk2 >>= 1;
-    /* compute |X(k)|**2 */
-    /* report overflows. This should not happen. */
-    /* Comment this out if desired */
-    /*if (sk < -32768 || sk > 32767)
-      DBG("isdn_audio: dtmf goertzel overflow, sk=%d\n", sk);
-      if (sk2 < -32768 || sk2 > 32767)
-      DBG("isdn_audio: dtmf goertzel overflow, sk2=%d\n", sk2);
-    */
-
-    // note that the result still is in (32-REL_AMP_BITS).REL_AMP_BITS format
-    m_result[k] =
-      ((sk * sk) >> REL_AMP_BITS) -
-      ((((rel_cos2pik[k] * sk) >> 15) * sk2) >> REL_AMP_BITS) +
-      ((sk2 * sk2) >> REL_AMP_BITS);
-  }
+  kernels->goertzel(m_buf, m_buf, rel_cos2pik, m_result);
 }
 
 
-void AmSemsInbandDtmfDetector::isdn_audio_eval_dtmf_relative()
+void AmSemsInbandDtmfDetector::isdn_audio_eval_dtmf_relative(const int* result, int block_ts)
 {
   int silence;
   int grp[2];
@@ -633,11 +588,11 @@ void AmSemsInbandDtmfDetector::isdn_audio_eval_dtmf_relative()
 
   for (int i = 0; i < REL_NCOEFF; i++) 
     {
-      if (m_result[i] > REL_DTMF_TRESH) {
-	if (m_result[i] > thresh)
-	  thresh = m_result[i];
+      if (result[i] > REL_DTMF_TRESH) {
+	if (result[i] > thresh)
+	  thresh = result[i];
       }
-      else if (m_result[i] < REL_SILENCE_TRESH)
+      else if (result[i] < REL_SILENCE_TRESH)
 	silence++;
     }
   if (silence == REL_NCOEFF)
@@ -647,7 +602,7 @@ void AmSemsInbandDtmfDetector::isdn_audio_eval_dtmf_relative()
       thresh = thresh >> 4;  /* touchtones must match within 12 dB */
 
       for (int i = 0; i < REL_NCOEFF; i++) {
-	if (m_result[i] < thresh)
+	if (result[i] < thresh)
 	  continue;  /* ignore */
 
 	/* good level found. This is allowed only one time per group */
@@ -677,8 +632,8 @@ void AmSemsInbandDtmfDetector::isdn_audio_eval_dtmf_relative()
 		
 	if (what != m_last)
 	  {
-	    m_startTime.tv_sec = m_last_ts / SAMPLERATE;
-	    m_startTime.tv_usec = ((m_last_ts * 10000) / (SAMPLERATE/100)) 
+	    m_startTime.tv_sec = block_ts / SAMPLERATE;
+	    m_startTime.tv_usec = ((block_ts * 10000) / (SAMPLERATE/100)) 
 	      % 1000000;
 	  }
       } else
@@ -699,8 +654,8 @@ void AmSemsInbandDtmfDetector::isdn_audio_eval_dtmf_relative()
       if (m_last != ' ' && m_last != '.' && m_count >= DTMF_INTERVAL)
         {
 	  struct timeval stop;
-	  stop.tv_sec = m_last_ts / SAMPLERATE;
-	  stop.tv_usec = ((m_last_ts * 10000) / (SAMPLERATE/100)) % 1000000;
+	  stop.tv_sec = block_ts / SAMPLERATE;
+	  stop.tv_usec = ((block_ts * 10000) / (SAMPLERATE/100)) % 1000000;
 	  m_keysink->registerKeyReleased(m_lastCode, Dtmf::SOURCE_INBAND, m_startTime, stop);
         }
       m_count = 0;
@@ -726,8 +681,13 @@ void AmSemsInbandDtmfDetector::isdn_audio_calc_dtmf(const signed short* buf, int
       m_buf[m_idx++] = (*buf++) >> (15 - REL_AMP_BITS);
     }
     if (m_idx == NELEMSOF(m_buf)) {
-      isdn_audio_goertzel_relative();
-      isdn_audio_eval_dtmf_relative();
+      AmInbandDtmfBatch* batch = AmInbandDtmfBatch::current();
+      if (batch) {
+	batch->put(this, m_buf, m_last_ts);
+      } else {
+	isdn_audio_goertzel_relative();
+	isdn_audio_eval_dtmf_relative(m_result, m_last_ts);
+      }
       m_idx = 0;
       m_last_ts = ts + c;
     }
@@ -746,6 +706,92 @@ int AmSemsInbandDtmfDetector::streamPut(const unsigned char* samples, unsigned i
   return size;
 }
 
+//
+// AmInbandDtmfBatch methods
+
+static AmThreadLocalStorage<AmInbandDtmfBatch> thread_batch;
+
+AmInbandDtmfBatch::AmInbandDtmfBatch(const AmGoertzelKernels* kernels)
+  : used(0), kernels(kernels ? kernels : AmGoertzelKernels::get())
+{
+}
+
+AmInbandDtmfBatch* AmInbandDtmfBatch::enable()
+{
+  AmInbandDtmfBatch* batch = thread_batch.get();
+  if (!batch) {
+    batch = new AmInbandDtmfBatch();
+    thread_batch.set(batch);
+  }
+  return batch;
+}
+
+void AmInbandDtmfBatch::disable()
+{
+  AmInbandDtmfBatch* batch = thread_batch.get();
+  if (batch) {
+    thread_batch.set(NULL);
+    batch->flush();
+    delete batch;
+  }
+}
+
+AmInbandDtmfBatch* AmInbandDtmfBatch::current()
+{
+  return thread_batch.get();
+}
+
+void AmInbandDtmfBatch::put(AmSemsInbandDtmfDetector* detector, const int* buf, int ts)
+{
+  if (used == blocks.size())
+    blocks.resize(used + 1);
+
+  Block& b = blocks[used++];
+  b.detector = detector;
+  b.ts = ts;
+  memcpy(b.buf, buf, sizeof(b.buf));
+}
+
+void AmInbandDtmfBatch::cancel(AmSemsInbandDtmfDetector* detector)
+{
+  for (unsigned int i = 0; i < used; i++)
+    if (blocks[i].detector == detector)
+      blocks[i].detector = NULL;
+}
+
+void AmInbandDtmfBatch::flush()
+{
+  int coef[GOERTZEL_LANES];
+  int result[GOERTZEL_LANES];
+
+  // two blocks per kernel call
+  for (unsigned int i = 0; i < used; i += 2) {
+    Block& b0 = blocks[i];
+    Block& b1 = blocks[i + 1 < used ? i + 1 : i];
+    if (!b0.detector && !b1.detector)
+      continue;
+
+    // a cancelled block is filtered with the other one's coefficients
+    AmSemsInbandDtmfDetector* d0 = b0.detector ? b0.detector : b1.detector;
+    AmSemsInbandDtmfDetector* d1 = b1.detector ? b1.detector : b0.detector;
+    memcpy(coef, d0->rel_cos2pik, sizeof(int) * GOERTZEL_NTONES);
+    memcpy(coef + GOERTZEL_NTONES, d1->rel_cos2pik,
+	   sizeof(int) * GOERTZEL_NTONES);
+    kernels->goertzel(b0.buf, b1.buf, coef, result);
+    memcpy(b0.result, result, sizeof(b0.result));
+    memcpy(b1.result, result + GOERTZEL_NTONES, sizeof(b1.result));
+  }
+
+  // in order, a detector may have more than one block
+  for (unsigned int i = 0; i < used; i++) {
+    Block& b = blocks[i];
+    if (b.detector)
+      b.detector->isdn_audio_eval_dtmf_relative(b.result, b.ts);
+  }
+
+  used = 0;
+}
+
 #ifdef USE_SPANDSP
 
 AmSpanDSPInbandDtmfDetector::AmSpanDSPInbandDtmfDetector(AmKeyPressSink *keysink, int sample_rate)
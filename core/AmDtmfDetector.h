@@ -29,10 +29,12 @@
 #define _AmDtmfDetector_h_
 
 #include "AmEventQueue.h"
+#include "AmDtmfGoertzel.h"
 #include "rtp/telephone_event.h"
 
 #include <string>
 #include <memory>
+#include <vector>
 
 #ifdef USE_SPANDSP
 #include <math.h>
@@ -243,8 +245,8 @@ class AmSemsInbandDtmfDetector
    */
   struct timeval m_startTime;
 
-  static const int REL_DTMF_NPOINTS = 205;    /* Number of samples for DTMF recognition */
-  static const int REL_NCOEFF = 8;            /* number of frequencies to be analyzed   */
+  static const int REL_DTMF_NPOINTS = GOERTZEL_NPOINTS; /* Number of samples for DTMF recognition */
+  static const int REL_NCOEFF = GOERTZEL_NTONES;        /* number of frequencies to be analyzed   */
 
   const int SAMPLERATE;
   /**
@@ -254,25 +256,32 @@ class AmSemsInbandDtmfDetector
   static const int DTMF_INTERVAL = 3;
 
   /* For DTMF recognition:
-   * 2 * cos(2 * PI * k / N) precalculated for all k
+   * 2 * cos(2 * PI * k / N) precalculated for all k, twice
+   * (a kernel call filters two streams; one block uses the first half)
    */
-  int rel_cos2pik[REL_NCOEFF];
+  int rel_cos2pik[GOERTZEL_LANES];
 
   int m_buf[REL_DTMF_NPOINTS];
   char m_last;
   int m_idx;
-  int m_result[16];
+  int m_result[GOERTZEL_LANES];
   int m_lastCode;
   int m_last_ts;	// timestamp representative for the currently analysed filter block
 
   int m_count;
 
+  const AmGoertzelKernels* kernels;
+
   void isdn_audio_goertzel_relative();
-  void isdn_audio_eval_dtmf_relative();
+  void isdn_audio_eval_dtmf_relative(const int* result, int block_ts);
   void isdn_audio_calc_dtmf(const signed short* buf, int len, unsigned int ts);
 
+  friend class AmInbandDtmfBatch;
+
  public:
-  AmSemsInbandDtmfDetector(AmKeyPressSink *keysink, int sample_rate);
+  /** @param kernels Goertzel kernels, NULL for the best ones */
+  AmSemsInbandDtmfDetector(AmKeyPressSink *keysink, int sample_rate,
+			   const AmGoertzelKernels* kernels = NULL);
   ~AmSemsInbandDtmfDetector();
   /**
    * Entry point for audio stream
@@ -281,6 +290,45 @@ class AmSemsInbandDtmfDetector
 };
 
 
+/**
+ * \brief Goertzel filters of many inband detectors in one go
+ *
+ * A media processor thread collects the complete blocks of all its
+ * AmSemsInbandDtmfDetectors during one tick and evaluates them at the
+ * end of the tick, filtering two streams per kernel call. The
+ * results are the same as with evaluation per block.
+ */
+class AmInbandDtmfBatch
+{
+  struct Block
+  {
+    AmSemsInbandDtmfDetector* detector;
+    int ts;
+    int buf[GOERTZEL_NPOINTS];
+    int result[GOERTZEL_NTONES];
+  };
+
+  std::vector<Block> blocks;
+  unsigned int used;
+  const AmGoertzelKernels* kernels;
+
+ public:
+  AmInbandDtmfBatch(const AmGoertzelKernels* kernels = NULL);
+
+  /** batch the detectors running in the calling thread */
+  static AmInbandDtmfBatch* enable();
+  /** evaluate the pending blocks and stop batching in the calling thread */
+  static void disable();
+  /** @return the calling thread's batch, NULL if it has none */
+  static AmInbandDtmfBatch* current();
+
+  void put(AmSemsInbandDtmfDetector* detector, const int* buf, int ts);
+  /** drop the pending blocks of a detector */
+  void cancel(AmSemsInbandDtmfDetector* detector);
+  /** filter and evaluate all pending blocks */
+  void flush();
+};
+
 #ifdef USE_SPANDSP
 
 class AmSpanDSPInbandDtmfDetector 
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2005 Andriy I Pylypenko
+ *
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "AmDtmfGoertzel.h"
+
+#include <math.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GOERTZEL_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+#define PI 3.1415926
+
+static const int dtmf_freqs[GOERTZEL_NTONES] =
+  { 697, 770, 852, 941, 1209, 1336, 1477, 1633 };
+
+/* precalculate 2 * cos (2 PI k / N) */
+static int goertzel_coef(int freq, int sample_rate)
+{
+  // FIXME: fixed samplerate. won't work for wideband
+  int k = (int)((double)freq * GOERTZEL_NPOINTS / sample_rate + 0.5);
+  return (int)(2 * 32768 * cos(2 * PI * k / GOERTZEL_NPOINTS));
+}
+
+void AmGoertzelKernels::toneCoefficients(int sample_rate, int* coef)
+{
+  for (int i = 0; i < GOERTZEL_NTONES; i++)
+    coef[i] = goertzel_coef(dtmf_freqs[i], sample_rate);
+}
+
+/*
+ * Goertzel algorithm.
+ * See http://ptolemy.eecs.berkeley.edu/~pino/Ptolemy/papers/96/dtmf_ict/
+ * for more info.
+ */
+
+static void goertzel_scalar(const int* x0, const int* x1, const int* coef,
+			    int* result)
+{
+  int sk, sk1, sk2;
+
+  for (int k = 0; k < GOERTZEL_LANES; k++) {
+    const int* x = k < GOERTZEL_NTONES ? x0 : x1;
+
+    // like x, sk..sk2 are in (32-GOERTZEL_AMP_BITS).GOERTZEL_AMP_BITS fixed-point format
+    sk = sk1 = sk2 = 0;
+    for (int n = 0; n < GOERTZEL_NPOINTS; n++) {
+      sk = x[n] + ((coef[k] * sk1) >> 15) - sk2;
+      sk2 = sk1;
+      sk1 = sk;
+    }
+    /* Avoid overflows */
+    sk >>= 1;
+    sk2 >>= 1;
+
+    /* compute |X(k)|**2 */
+    // note that the result still is in (32-GOERTZEL_AMP_BITS).GOERTZEL_AMP_BITS format
+    result[k] =
+      ((sk * sk) >> GOERTZEL_AMP_BITS) -
+      ((((coef[k] * sk) >> 15) * sk2) >> GOERTZEL_AMP_BITS) +
+      ((sk2 * sk2) >> GOERTZEL_AMP_BITS);
+  }
+}
+
+#ifdef GOERTZEL_X86_KERNELS
+
+// low 32 bit of a 32x32 bit multiplication (SSE2 has no pmulld)
+__attribute__((target("sse2")))
+static inline __m128i mullo_epi32_sse2(__m128i a, __m128i b)
+{
+  __m128i even = _mm_mul_epu32(a, b);
+  __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0,0,2,0)),
+			    _mm_shuffle_epi32(odd, _MM_SHUFFLE(0,0,2,0)));
+}
+
+__attribute__((target("sse2")))
+static inline __m128i goertzel_power_sse2(__m128i c, __m128i sk, __m128i sk2)
+{
+  sk = _mm_srai_epi32(sk, 1);
+  sk2 = _mm_srai_epi32(sk2, 1);
+  __m128i p = _mm_srai_epi32(mullo_epi32_sse2(sk, sk), GOERTZEL_AMP_BITS);
+  __m128i x = _mm_srai_epi32(mullo_epi32_sse2(c, sk), 15);
+  p = _mm_sub_epi32(p, _mm_srai_epi32(mullo_epi32_sse2(x, sk2), GOERTZEL_AMP_BITS));
+  return _mm_add_epi32(p, _mm_srai_epi32(mullo_epi32_sse2(sk2, sk2), GOERTZEL_AMP_BITS));
+}
+
+__attribute__((target("sse2")))
+static void goertzel_sse2(const int* x0, const int* x1, const int* coef,
+			  int* result)
+{
+  __m128i c[4], sk1[4], sk2[4];
+  for (int v = 0; v < 4; v++) {
+    c[v] = _mm_loadu_si128((const __m128i*)(coef + 4 * v));
+    sk1[v] = sk2[v] = _mm_setzero_si128();
+  }
+
+  for (int n = 0; n < GOERTZEL_NPOINTS; n++) {
+    __m128i in[2] = { _mm_set1_epi32(x0[n]), _mm_set1_epi32(x1[n]) };
+    for (int v = 0; v < 4; v++) {
+      __m128i sk = _mm_sub_epi32(_mm_add_epi32(in[v / 2],
+			_mm_srai_epi32(mullo_epi32_sse2(c[v], sk1[v]), 15)),
+				 sk2[v]);
+      sk2[v] = sk1[v];
+      sk1[v] = sk;
+    }
+  }
+
+  for (int v = 0; v < 4; v++)
+    _mm_storeu_si128((__m128i*)(result + 4 * v),
+		     goertzel_power_sse2(c[v], sk1[v], sk2[v]));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i goertzel_power_avx2(__m256i c, __m256i sk, __m256i sk2)
+{
+  sk = _mm256_srai_epi32(sk, 1);
+  sk2 = _mm256_srai_epi32(sk2, 1);
+  __m256i p = _mm256_srai_epi32(_mm256_mullo_epi32(sk, sk), GOERTZEL_AMP_BITS);
+  __m256i x = _mm256_srai_epi32(_mm256_mullo_epi32(c, sk), 15);
+  p = _mm256_sub_epi32(p, _mm256_srai_epi32(_mm256_mullo_epi32(x, sk2), GOERTZEL_AMP_BITS));
+  return _mm256_add_epi32(p, _mm256_srai_epi32(_mm256_mullo_epi32(sk2, sk2), GOERTZEL_AMP_BITS));
+}
+
+__attribute__((target("avx2")))
+static void goertzel_avx2(const int* x0, const int* x1, const int* coef,
+			  int* result)
+{
+  const __m256i c0 = _mm256_loadu_si256((const __m256i*)coef);
+  const __m256i c1 = _mm256_loadu_si256((const __m256i*)(coef + 8));
+  __m256i a1 = _mm256_setzero_si256(), a2 = _mm256_setzero_si256();
+  __m256i b1 = _mm256_setzero_si256(), b2 = _mm256_setzero_si256();
+
+  for (int n = 0; n < GOERTZEL_NPOINTS; n++) {
+    __m256i a = _mm256_sub_epi32(_mm256_add_epi32(_mm256_set1_epi32(x0[n]),
+			_mm256_srai_epi32(_mm256_mullo_epi32(c0, a1), 15)), a2);
+    __m256i b = _mm256_sub_epi32(_mm256_add_epi32(_mm256_set1_epi32(x1[n]),
+			_mm256_srai_epi32(_mm256_mullo_epi32(c1, b1), 15)), b2);
+    a2 = a1; a1 = a;
+    b2 = b1; b1 = b;
+  }
+
+  _mm256_storeu_si256((__m256i*)result, goertzel_power_avx2(c0, a1, a2));
+  _mm256_storeu_si256((__m256i*)(result + 8), goertzel_power_avx2(c1, b1, b2));
+}
+
+#endif // GOERTZEL_X86_KERNELS
+
+static const AmGoertzelKernels kernels_scalar = { "scalar", goertzel_scalar };
+
+#ifdef GOERTZEL_X86_KERNELS
+static const AmGoertzelKernels kernels_sse2 = { "sse2", goertzel_sse2 };
+static const AmGoertzelKernels kernels_avx2 = { "avx2", goertzel_avx2 };
+#endif
+
+const AmGoertzelKernels* AmGoertzelKernels::get(const string& name)
+{
+  if (name == "scalar")
+    return &kernels_scalar;
+
+#ifdef GOERTZEL_X86_KERNELS
+  __builtin_cpu_init();
+  if (name == "sse2" && __builtin_cpu_supports("sse2"))
+    return &kernels_sse2;
+  if (name == "avx2" && __builtin_cpu_supports("avx2"))
+    return &kernels_avx2;
+#endif
+
+  return NULL;
+}
+
+const AmGoertzelKernels* AmGoertzelKernels::get()
+{
+  static const AmGoertzelKernels* best = NULL;
+  if (!best) {
+    const AmGoertzelKernels* k = get("avx2");
+    if (!k) k = get("sse2");
+    if (!k) k = &kernels_scalar;
+    best = k;
+  }
+  return best;
+}
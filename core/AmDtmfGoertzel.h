@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2005 Andriy I Pylypenko
+ *
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+/** @file AmDtmfGoertzel.h */
+#ifndef _AmDtmfGoertzel_h_
+#define _AmDtmfGoertzel_h_
+
+#include <string>
+using std::string;
+
+/** Number of samples for DTMF recognition */
+#define GOERTZEL_NPOINTS 205
+/** DTMF frequencies */
+#define GOERTZEL_NTONES 8
+/** bins computed by one kernel call */
+#define GOERTZEL_LANES 16
+/** bits per sample, reduced to avoid overflow */
+#define GOERTZEL_AMP_BITS 9
+
+/**
+ * \brief Goertzel filter bank for the inband DTMF detector
+ *
+ * One call computes |X(k)|**2 of 16 bins over a block of
+ * GOERTZEL_NPOINTS samples in (32-GOERTZEL_AMP_BITS).GOERTZEL_AMP_BITS
+ * fixed point. Bins 0..7 run over x0, bins 8..15 over x1, i.e. the
+ * 8 DTMF tones of two streams. All kernels give the same results as
+ * the original scalar integer code.
+ */
+struct AmGoertzelKernels
+{
+  const char* name;
+
+  /**
+   * result[k] = |X(k)|**2
+   * @param coef 2 * cos(2 * PI * k / N) in Q15, per bin
+   */
+  void (*goertzel)(const int* x0, const int* x1, const int* coef,
+		   int* result);
+
+  /** best kernels for this CPU */
+  static const AmGoertzelKernels* get();
+  /** kernels by name ("scalar", "sse2", "avx2"), NULL if not supported */
+  static const AmGoertzelKernels* get(const string& name);
+
+  /** coefficients of the 8 DTMF tones at sample_rate */
+  static void toneCoefficients(int sample_rate, int* coef);
+};
+
+#endif
+
+// Local Variables:
+// mode:C++
+// End:
@@ -38,6 +38,7 @@ using std::string;
 #define E_SIP_SUBSCRIPTION 102
 #define E_B2B_APP          103
 #define E_IVR              104
+#define E_EVENT_BATCH      105
 
 
 /** \brief base event class */
@@ -28,6 +28,7 @@
 #include "AmEventQueue.h"
 #include "log.h"
 #include "AmConfig.h"
+#include "AmEventDispatcher.h"
 
 #include <memory>
 #include <typeinfo>
@@ -84,7 +85,7 @@ void AmEventQueue::processEvents()
     if (AmConfig::LogEvents)
       DBG("before processing event (%s)\n",
 	  typeid(*event.get()).name());
-    handler->process(event.get());
+    processEvent(event.get());
     if (AmConfig::LogEvents)
       DBG("event processed (%s)\n",
 	  typeid(*event.get()).name());
@@ -97,6 +98,31 @@ void AmEventQueue::processEvents()
   m_queue.unlock();
 }
 
+void AmEventQueue::processEvent(AmEvent* event)
+{
+  AmEventBatch* batch = NULL;
+  if (event->event_id == E_EVENT_BATCH)
+    batch = dynamic_cast<AmEventBatch*>(event);
+
+  if (!batch) {
+    handler->process(event);
+    return;
+  }
+
+  std::vector<AmEvent*> evs;
+  batch->take(evs);
+  for (size_t i=0; i<evs.size(); i++) {
+    try {
+      handler->process(evs[i]);
+    } catch (...) {
+      for (; i<evs.size(); i++)
+	delete evs[i];
+      throw;
+    }
+    delete evs[i];
+  }
+}
+
 void AmEventQueue::waitForEvent()
 {
   ev_pending.wait_for();
@@ -114,7 +140,7 @@ void AmEventQueue::processSingleEvent()
 
     if (AmConfig::LogEvents)
       DBG("before processing event\n");
-    handler->process(event.get());
+    processEvent(event.get());
     if (AmConfig::LogEvents)
       DBG("event processed\n");
 
@@ -144,3 +170,94 @@ void AmEventQueue::setEventNotificationSink(AmEventNotificationSink*
     wakeup_handler->notify(this);
   m_queue.unlock();
 }
+
+AmEventMailbox::AmEventMailbox(const string& local_tag)
+  : local_tag(local_tag), posted_seq(0), seq(0)
+{
+}
+
+AmEventMailbox::~AmEventMailbox()
+{
+  clear();
+}
+
+void AmEventMailbox::clear()
+{
+  mut.lock();
+  for (std::vector<AmEvent*>::iterator it=events.begin(); it != events.end(); it++)
+    delete *it;
+  events.clear();
+  mut.unlock();
+}
+
+AmEventBatch* AmEventMailbox::add(AmEvent* ev)
+{
+  AmEventBatch* batch = NULL;
+
+  mut.lock();
+  events.push_back(ev);
+  if (!posted_seq) {
+    if (!++seq)
+      ++seq;
+    posted_seq = seq;
+    batch = new AmEventBatch(this, seq);
+  }
+  mut.unlock();
+
+  return batch;
+}
+
+bool AmEventMailbox::post(AmEventBatch* batch)
+{
+  // the batch (and with it our last reference) may be gone
+  // as soon as it is posted
+  inc_ref(this);
+
+  bool posted = AmEventDispatcher::instance()->post(local_tag, batch);
+  if (!posted) {
+    DBG("receiver '%s' not found, dropping its events\n", local_tag.c_str());
+    delete batch;
+    clear();
+  }
+
+  dec_ref(this);
+  return posted;
+}
+
+bool AmEventMailbox::post(AmEvent* ev)
+{
+  AmEventBatch* batch = add(ev);
+  if (!batch)
+    return true;
+  return post(batch);
+}
+
+void AmEventMailbox::take(unsigned int batch_seq, std::vector<AmEvent*>& evs)
+{
+  mut.lock();
+  if (posted_seq == batch_seq)
+    posted_seq = 0;
+  evs.swap(events);
+  mut.unlock();
+}
+
+void AmEventMailbox::release(unsigned int batch_seq)
+{
+  mut.lock();
+  if (posted_seq == batch_seq)
+    posted_seq = 0;
+  mut.unlock();
+}
+
+AmEventBatch::AmEventBatch(AmEventMailbox* mailbox, unsigned int seq)
+  : AmEvent(E_EVENT_BATCH), mailbox(mailbox), seq(seq)
+{
+  inc_ref(mailbox);
+}
+
+AmEventBatch::~AmEventBatch()
+{
+  // not processed (receiver gone): the next add() posts a new one
+  mailbox->release(seq);
+  dec_ref(mailbox);
+}
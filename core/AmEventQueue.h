@@ -33,6 +33,8 @@
 #include "atomic_types.h"
 
 #include <queue>
+#include <vector>
+#include <string>
 
 class AmEventQueueInterface
 {
@@ -91,6 +93,78 @@ public:
   virtual bool startup() { return true; }
   virtual bool processingCycle() { processEvents(); return true; }
   virtual void finalize() { finalized = true; }
+
+ private:
+  void processEvent(AmEvent* event);
+};
+
+class AmEventBatch;
+
+/**
+ * \brief Events for one receiver, delivered in batches
+ *
+ * For posting many events to the same receiver (identified by local
+ * tag) from several places, e.g. conference notifications: events
+ * are collected here, and only one AmEventBatch is posted to the
+ * receiver as long as that has not been processed. AmEventQueue takes
+ * the events out of the batch and processes them one by one in the
+ * order they were added, so the receiver does not see the difference -
+ * but it is woken up and looked up once per batch instead of per event.
+ */
+class AmEventMailbox
+  : public atomic_ref_cnt
+{
+  string local_tag;
+
+  AmMutex mut;
+  std::vector<AmEvent*> events;
+  /** batch posted and not processed yet, 0 for none */
+  unsigned int posted_seq;
+  unsigned int seq;
+
+  friend class AmEventBatch;
+  void take(unsigned int batch_seq, std::vector<AmEvent*>& evs);
+  void release(unsigned int batch_seq);
+  void clear();
+
+public:
+  AmEventMailbox(const string& local_tag);
+  ~AmEventMailbox();
+
+  const string& getLocalTag() { return local_tag; }
+
+  /**
+   * add an event (owned by the mailbox then)
+   * @return the batch event to post with post(AmEventBatch*),
+   *         or NULL if one is on its way already
+   */
+  AmEventBatch* add(AmEvent* ev);
+
+  /**
+   * post a batch event returned by add()
+   * @return false if the receiver does not exist (anymore),
+   *         the pending events are deleted then
+   */
+  bool post(AmEventBatch* batch);
+
+  /** add() and post() */
+  bool post(AmEvent* ev);
+};
+
+/** \brief the events of an AmEventMailbox, see there */
+class AmEventBatch
+  : public AmEvent
+{
+  AmEventMailbox* mailbox;
+  unsigned int seq;
+
+public:
+  AmEventBatch(AmEventMailbox* mailbox, unsigned int seq);
+  ~AmEventBatch();
+
+  /** takes the events added to the mailbox until now */
+  void take(std::vector<AmEvent*>& evs) { mailbox->take(seq, evs); }
+  AmEventMailbox* getMailbox() { return mailbox; }
 };
 
 #endif
@@ -238,6 +238,9 @@ void AmMediaProcessorThread::run()
   tick.tv_sec  = 0;
   tick.tv_usec = 1000*WC_INC_MS;
 
+  // inband DTMF is filtered for all sessions at the end of a tick
+  AmInbandDtmfBatch* dtmf_batch = AmInbandDtmfBatch::enable();
+
   gettimeofday(&now,NULL);
   timeradd(&tick,&now,&next_tick);
     
@@ -258,12 +261,15 @@ void AmMediaProcessorThread::run()
     }
 
     processAudio(ts);
+    dtmf_batch->flush();
     events.processEvents();
     processDtmfEvents();
 
     ts = (ts + WC_INC) & WALLCLOCK_MASK;
     timeradd(&tick,&next_tick,&next_tick);
   }
+
+  AmInbandDtmfBatch::disable();
 }
 
 /**
@@ -25,10 +25,19 @@
 
 #include "AmMultiPartyMixer.h"
 #include "AmRtpStream.h"
+#include "AmRtpAudio.h"
+#include "AmConfig.h"
 #include "log.h"
 
 #include <assert.h>
 #include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MIXER_X86_KERNELS
+#include <immintrin.h>
+#endif
 
 // PCM16 range: [-32767:32768]
 #define MAX_LINEAR_SAMPLE 32737
@@ -38,6 +47,233 @@
 
 #define MAX_BUFFER_STATES 50 // 1 sec max @ 20ms
 
+// a speaker keeps its place unless another channel is louder by 1/4
+#define SPEAKER_HYSTERESIS(l) ((l) + ((l) >> 2))
+
+static short silence[AUDIO_BUFFER_SIZE/2] = { 0 };
+
+static inline bool is_silent(const short* buffer, unsigned int samples)
+{
+  for (unsigned int i = 0; i < samples; i++) {
+    if (buffer[i])
+      return false;
+  }
+  return true;
+}
+
+/*
+ * mixing kernels
+ */
+
+static void mix_add_scalar(int* dest, const int* src1, const short* src2,
+			   unsigned int size)
+{
+  int* end_dest = dest + size;
+
+  while(dest != end_dest)
+    *(dest++) = *(src1++) + int(*(src2++));
+}
+
+static void mix_sub_scalar(int* dest, const int* src1, const short* src2,
+			   unsigned int size)
+{
+  int* end_dest = dest + size;
+
+  while(dest != end_dest)
+    *(dest++) = *(src1++) - int(*(src2++));
+}
+
+static int scale_scalar(short* buffer, const int* tmp_buf, unsigned int size,
+			int scaling_factor)
+{
+  short* end_dest = buffer + size;
+
+  while(buffer != end_dest){
+
+    int s = (*tmp_buf * scaling_factor) >> 6;
+    if(abs(s) > MAX_LINEAR_SAMPLE){
+      scaling_factor = abs( (MAX_LINEAR_SAMPLE<<6) / (*tmp_buf) );
+      if(s < 0)
+	s = -MAX_LINEAR_SAMPLE;
+      else
+	s = MAX_LINEAR_SAMPLE;
+    }
+    *(buffer++) = short(s);
+    tmp_buf++;
+  }
+
+  return scaling_factor;
+}
+
+#ifdef MIXER_X86_KERNELS
+
+__attribute__((target("sse2")))
+static void mix_add_sse2(int* dest, const int* src1, const short* src2,
+			 unsigned int size)
+{
+  unsigned int i = 0;
+  for (; i + 8 <= size; i += 8) {
+    __m128i s = _mm_loadu_si128((const __m128i*)(src2 + i));
+    // sign extend 16 -> 32 bit
+    __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+    __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+    __m128i a0 = _mm_loadu_si128((const __m128i*)(src1 + i));
+    __m128i a1 = _mm_loadu_si128((const __m128i*)(src1 + i + 4));
+    _mm_storeu_si128((__m128i*)(dest + i), _mm_add_epi32(a0, lo));
+    _mm_storeu_si128((__m128i*)(dest + i + 4), _mm_add_epi32(a1, hi));
+  }
+  mix_add_scalar(dest + i, src1 + i, src2 + i, size - i);
+}
+
+__attribute__((target("sse2")))
+static void mix_sub_sse2(int* dest, const int* src1, const short* src2,
+			 unsigned int size)
+{
+  unsigned int i = 0;
+  for (; i + 8 <= size; i += 8) {
+    __m128i s = _mm_loadu_si128((const __m128i*)(src2 + i));
+    __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+    __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+    __m128i a0 = _mm_loadu_si128((const __m128i*)(src1 + i));
+    __m128i a1 = _mm_loadu_si128((const __m128i*)(src1 + i + 4));
+    _mm_storeu_si128((__m128i*)(dest + i), _mm_sub_epi32(a0, lo));
+    _mm_storeu_si128((__m128i*)(dest + i + 4), _mm_sub_epi32(a1, hi));
+  }
+  mix_sub_scalar(dest + i, src1 + i, src2 + i, size - i);
+}
+
+// low 32 bit of a 32x32 bit multiplication (SSE2 has no pmulld)
+__attribute__((target("sse2")))
+static inline __m128i mullo_epi32_sse2(__m128i a, __m128i b)
+{
+  __m128i even = _mm_mul_epu32(a, b);
+  __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0,0,2,0)),
+			    _mm_shuffle_epi32(odd, _MM_SHUFFLE(0,0,2,0)));
+}
+
+__attribute__((target("sse2")))
+static int scale_sse2(short* buffer, const int* tmp_buf, unsigned int size,
+		      int scaling_factor)
+{
+  const __m128i max_s = _mm_set1_epi32(MAX_LINEAR_SAMPLE);
+  const __m128i min_s = _mm_set1_epi32(-MAX_LINEAR_SAMPLE);
+
+  unsigned int i = 0;
+  while (i + 8 <= size) {
+    __m128i f = _mm_set1_epi32(scaling_factor);
+    __m128i s0 = _mm_srai_epi32(mullo_epi32_sse2(_mm_loadu_si128((const __m128i*)(tmp_buf + i)), f), 6);
+    __m128i s1 = _mm_srai_epi32(mullo_epi32_sse2(_mm_loadu_si128((const __m128i*)(tmp_buf + i + 4)), f), 6);
+
+    __m128i clip = _mm_or_si128(_mm_or_si128(_mm_cmpgt_epi32(s0, max_s),
+					     _mm_cmplt_epi32(s0, min_s)),
+				_mm_or_si128(_mm_cmpgt_epi32(s1, max_s),
+					     _mm_cmplt_epi32(s1, min_s)));
+    if (_mm_movemask_epi8(clip)) {
+      // the factor changes within this block
+      scaling_factor = scale_scalar(buffer + i, tmp_buf + i, 8, scaling_factor);
+    } else {
+      _mm_storeu_si128((__m128i*)(buffer + i), _mm_packs_epi32(s0, s1));
+    }
+    i += 8;
+  }
+
+  return scale_scalar(buffer + i, tmp_buf + i, size - i, scaling_factor);
+}
+
+__attribute__((target("avx2")))
+static void mix_add_avx2(int* dest, const int* src1, const short* src2,
+			 unsigned int size)
+{
+  unsigned int i = 0;
+  for (; i + 8 <= size; i += 8) {
+    __m256i s = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src2 + i)));
+    __m256i a = _mm256_loadu_si256((const __m256i*)(src1 + i));
+    _mm256_storeu_si256((__m256i*)(dest + i), _mm256_add_epi32(a, s));
+  }
+  mix_add_scalar(dest + i, src1 + i, src2 + i, size - i);
+}
+
+__attribute__((target("avx2")))
+static void mix_sub_avx2(int* dest, const int* src1, const short* src2,
+			 unsigned int size)
+{
+  unsigned int i = 0;
+  for (; i + 8 <= size; i += 8) {
+    __m256i s = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src2 + i)));
+    __m256i a = _mm256_loadu_si256((const __m256i*)(src1 + i));
+    _mm256_storeu_si256((__m256i*)(dest + i), _mm256_sub_epi32(a, s));
+  }
+  mix_sub_scalar(dest + i, src1 + i, src2 + i, size - i);
+}
+
+__attribute__((target("avx2")))
+static int scale_avx2(short* buffer, const int* tmp_buf, unsigned int size,
+		      int scaling_factor)
+{
+  const __m256i max_s = _mm256_set1_epi32(MAX_LINEAR_SAMPLE);
+  const __m256i min_s = _mm256_set1_epi32(-MAX_LINEAR_SAMPLE);
+
+  unsigned int i = 0;
+  while (i + 8 <= size) {
+    __m256i f = _mm256_set1_epi32(scaling_factor);
+    __m256i s = _mm256_srai_epi32(_mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)(tmp_buf + i)), f), 6);
+
+    __m256i clip = _mm256_or_si256(_mm256_cmpgt_epi32(s, max_s),
+				   _mm256_cmpgt_epi32(min_s, s));
+    if (_mm256_movemask_epi8(clip)) {
+      scaling_factor = scale_scalar(buffer + i, tmp_buf + i, 8, scaling_factor);
+    } else {
+      _mm_storeu_si128((__m128i*)(buffer + i),
+		       _mm_packs_epi32(_mm256_castsi256_si128(s),
+				       _mm256_extracti128_si256(s, 1)));
+    }
+    i += 8;
+  }
+
+  return scale_scalar(buffer + i, tmp_buf + i, size - i, scaling_factor);
+}
+
+#endif // MIXER_X86_KERNELS
+
+static const AmMixerKernels kernels_scalar =
+  { "scalar", mix_add_scalar, mix_sub_scalar, scale_scalar };
+
+#ifdef MIXER_X86_KERNELS
+static const AmMixerKernels kernels_sse2 =
+  { "sse2", mix_add_sse2, mix_sub_sse2, scale_sse2 };
+static const AmMixerKernels kernels_avx2 =
+  { "avx2", mix_add_avx2, mix_sub_avx2, scale_avx2 };
+#endif
+
+const AmMixerKernels* AmMixerKernels::get(const string& name)
+{
+  if (name == "scalar")
+    return &kernels_scalar;
+
+#ifdef MIXER_X86_KERNELS
+  __builtin_cpu_init();
+  if (name == "sse2" && __builtin_cpu_supports("sse2"))
+    return &kernels_sse2;
+  if (name == "avx2" && __builtin_cpu_supports("avx2"))
+    return &kernels_avx2;
+#endif
+
+  return NULL;
+}
+
+const AmMixerKernels* AmMixerKernels::get()
+{
+  static const AmMixerKernels* best = NULL;
+  if (!best) {
+    const AmMixerKernels* k = get("avx2");
+    if (!k) k = get("sse2");
+    if (!k) k = &kernels_scalar;
+    best = k;
+  }
+  return best;
+}
+
 void DEBUG_MIXER_BUFFER_STATE(const MixerBufferState& mbs, const string& context)
 {
   DBG("XXDebugMixerXX: dump of MixerBufferState %s", context.c_str());
@@ -51,8 +287,12 @@ void DEBUG_MIXER_BUFFER_STATE(const MixerBufferState& mbs, const string& context
 
 AmMultiPartyMixer::AmMultiPartyMixer()
   : sampleratemap(), samplerates(),
-    channelids(), buffer_state(),
-    audio_mut(), scaling_factor(16)
+    channelids(), channels_version(0), buffer_state(),
+    audio_mut(), scaling_factor(16),
+    kernels(AmMixerKernels::get()),
+    active_speakers(AmConfig::ConferenceActiveSpeakers), speakers_ts(0),
+    listener_valid(false), listener_ts(0), listener_samples(0),
+    listener_rate(0)
 {
 }
 
@@ -75,6 +315,7 @@ unsigned int AmMultiPartyMixer::addChannel(unsigned int external_sample_rate)
   }
 
   channelids.insert(cur_channel_id);
+  channels_version++;
 
   for (std::deque<MixerBufferState>::iterator it = buffer_state.begin(); it != buffer_state.end(); it++) {
     //DBG("XXDebugMixerXX: AmMultiPartyMixer::addChannel(): processing buffer state with sample rate %d", it->sample_rate);
@@ -89,6 +330,9 @@ unsigned int AmMultiPartyMixer::addChannel(unsigned int external_sample_rate)
   sampleratemap.insert(std::make_pair(cur_channel_id,external_sample_rate));
   samplerates.insert(external_sample_rate);
 
+  if (active_speakers)
+    levels[cur_channel_id] = 0;
+
   audio_mut.unlock();
   return cur_channel_id;
 }
@@ -101,6 +345,9 @@ void AmMultiPartyMixer::removeChannel(unsigned int channel_id)
   }
 
   channelids.erase(channel_id);
+  channels_version++;
+  levels.erase(channel_id);
+  speakers.erase(channel_id);
 
   SampleRateMap::iterator sit = sampleratemap.find(channel_id);
   if (sit != sampleratemap.end()) {
@@ -136,11 +383,28 @@ void AmMultiPartyMixer::PutChannelPacket(unsigned int   channel_id,
     unsigned long long put_ts = system_ts + (MIXER_DELAY_MS * WALLCLOCK_RATE / 1000);
     unsigned long long user_put_ts = put_ts * (srate/100) / (WALLCLOCK_RATE/100);
 
-    channel->put(user_put_ts,(short*)buffer,samples);
-    bstate->mixed_channel->get(user_put_ts,tmp_buffer,samples);
+    bool mixed = true;
+    if (active_speakers) {
+      if ((unsigned int)user_put_ts != speakers_ts) {
+	// next frame: choose the speakers by the levels so far
+	selectSpeakers();
+	speakers_ts = (unsigned int)user_put_ts;
+      }
+      updateLevel(channel_id,(short*)buffer,samples);
+      mixed = isSpeaker(channel_id);
+    }
+
+    if (mixed) {
+      channel->put(user_put_ts,(short*)buffer,samples);
+      bstate->mixed_channel->get(user_put_ts,tmp_buffer,samples);
 
-    mix_add(tmp_buffer,tmp_buffer,(short*)buffer,samples);
-    bstate->mixed_channel->put(user_put_ts,tmp_buffer,samples);
+      mix_add(tmp_buffer,tmp_buffer,(short*)buffer,samples);
+      bstate->mixed_channel->put(user_put_ts,tmp_buffer,samples);
+    }
+    else {
+      // not in the mix: nothing to subtract for this channel
+      channel->put(user_put_ts,silence,samples);
+    }
     bstate->last_ts = put_ts + (samples * (WALLCLOCK_RATE/100) / (srate/100));
   } else {
     /*
@@ -180,11 +444,20 @@ void AmMultiPartyMixer::GetChannelPacket(unsigned int   channel_id,
     assert(samples <= PCM16_B2S(AUDIO_BUFFER_SIZE));
 
     unsigned long long cur_ts = system_ts * (bstate->sample_rate/100) / (WALLCLOCK_RATE/100);
-    bstate->mixed_channel->get(cur_ts,tmp_buffer,samples);
+
     channel->get(cur_ts,(short*)buffer,samples);
 
-    mix_sub(tmp_buffer,tmp_buffer,(short*)buffer,samples);
-    scale((short*)buffer,tmp_buffer,samples);
+    if (active_speakers && is_silent((short*)buffer,samples)) {
+      // own audio is not in the mix
+      getListenerFrame(*bstate,cur_ts,samples);
+      memcpy(buffer,listener_buf,PCM16_S2B(samples));
+    }
+    else {
+      bstate->mixed_channel->get(cur_ts,tmp_buffer,samples);
+
+      mix_sub(tmp_buffer,tmp_buffer,(short*)buffer,samples);
+      scale((short*)buffer,tmp_buffer,samples);
+    }
     size = PCM16_S2B(samples);
     output_sample_rate = bstate->sample_rate;
   } else if (bstate != buffer_state.end()) {
@@ -204,6 +477,151 @@ void AmMultiPartyMixer::GetChannelPacket(unsigned int   channel_id,
   cleanupBufferStates(last_ts);
 }
 
+int AmMultiPartyMixer::GetChannelPacketEncoded(unsigned int   channel_id,
+					       unsigned long long system_ts,
+					       unsigned char* buffer,
+					       AmAudioRtpFormat* rtp_fmt)
+{
+  if (!active_speakers)
+    return 0;
+
+  // encoders with state can not share frames between listeners
+  amci_codec_t* codec = rtp_fmt->getCodec();
+  if (!codec || codec->init)
+    return 0;
+
+  int srate = GetCurrentSampleRate();
+  if (srate < 100 || (unsigned int)srate != rtp_fmt->getRate())
+    return 0;
+
+  unsigned int samples = rtp_fmt->getFrameSize();
+  if (!samples || PCM16_S2B(samples) > AUDIO_BUFFER_SIZE)
+    return 0;
+
+  unsigned int last_ts = system_ts + (samples * (WALLCLOCK_RATE/100) / (srate/100));
+  std::deque<MixerBufferState>::iterator bstate = findBufferStateForReading(srate, last_ts);
+  if (bstate == buffer_state.end() || bstate->sample_rate != (unsigned int)srate)
+    return 0;
+
+  MixerBufferState::ChannelMap::iterator ch = bstate->channels.find(channel_id);
+  if (ch == bstate->channels.end())
+    return 0;
+
+  // only if the own audio is not in the mix
+  unsigned long long cur_ts = system_ts * (bstate->sample_rate/100) / (WALLCLOCK_RATE/100);
+  short own[AUDIO_BUFFER_SIZE/2];
+  ch->second->get(cur_ts,own,samples);
+  if (!is_silent(own,samples))
+    return 0;
+
+  getListenerFrame(*bstate,cur_ts,samples);
+
+  std::vector<EncodedFrame>::iterator it = listener_encoded.begin();
+  for (; it != listener_encoded.end(); it++) {
+    if (it->codec_id == codec->id)
+      break;
+  }
+
+  if (it == listener_encoded.end()) {
+    listener_encoded.push_back(EncodedFrame());
+    it = listener_encoded.end() - 1;
+    it->codec_id = codec->id;
+
+    if (codec->encode) {
+      it->len = (*codec->encode)(it->data,(unsigned char*)listener_buf,
+				 PCM16_S2B(samples),1,srate,0);
+    } else {
+      it->len = PCM16_S2B(samples);
+      memcpy(it->data,listener_buf,it->len);
+    }
+  }
+
+  cleanupBufferStates(last_ts);
+
+  if (it->len <= 0)
+    return 0;
+
+  memcpy(buffer,it->data,it->len);
+  return it->len;
+}
+
+void AmMultiPartyMixer::getListenerFrame(MixerBufferState& bstate, unsigned int ts,
+					 unsigned int samples)
+{
+  if (listener_valid && listener_ts == ts && listener_samples == samples &&
+      listener_rate == bstate.sample_rate)
+    return;
+
+  bstate.mixed_channel->get(ts,tmp_buffer,samples);
+  scale(listener_buf,tmp_buffer,samples);
+
+  listener_valid = true;
+  listener_ts = ts;
+  listener_samples = samples;
+  listener_rate = bstate.sample_rate;
+  listener_encoded.clear();
+}
+
+void AmMultiPartyMixer::updateLevel(unsigned int channel_id, short* buffer,
+				    unsigned int samples)
+{
+  if (!samples)
+    return;
+
+  unsigned int sum = 0;
+  for (unsigned int i = 0; i < samples; i++)
+    sum += abs(buffer[i]);
+
+  // mean absolute amplitude, smoothed over ~4 frames
+  unsigned int& level = levels[channel_id];
+  level = (level * 3 + sum / samples) >> 2;
+}
+
+void AmMultiPartyMixer::selectSpeakers()
+{
+  if (levels.size() <= active_speakers) {
+    if (speakers.size() != levels.size()) {
+      speakers.clear();
+      for (std::map<int,unsigned int>::iterator it = levels.begin();
+	   it != levels.end(); it++)
+	speakers.insert(it->first);
+    }
+    return;
+  }
+
+  std::vector<std::pair<unsigned int,int> > ranked;
+  ranked.reserve(levels.size());
+  for (std::map<int,unsigned int>::iterator it = levels.begin();
+       it != levels.end(); it++) {
+    unsigned int l = it->second;
+    if (isSpeaker(it->first))
+      l = SPEAKER_HYSTERESIS(l);
+    ranked.push_back(std::make_pair(l, it->first));
+  }
+
+  std::nth_element(ranked.begin(), ranked.begin() + active_speakers,
+		   ranked.end(), std::greater<std::pair<unsigned int,int> >());
+
+  speakers.clear();
+  for (unsigned int i = 0; i < active_speakers; i++)
+    speakers.insert(ranked[i].second);
+}
+
+void AmMultiPartyMixer::setActiveSpeakers(unsigned int n)
+{
+  audio_mut.lock();
+  active_speakers = n;
+  levels.clear();
+  speakers.clear();
+  if (n) {
+    for (ChannelIdSet::iterator it = channelids.begin();
+	 it != channelids.end(); it++)
+      levels[*it] = 0;
+  }
+  listener_valid = false;
+  audio_mut.unlock();
+}
+
 int AmMultiPartyMixer::GetCurrentSampleRate()
 {
   SampleRateSet::reverse_iterator sit = samplerates.rbegin();
@@ -220,47 +638,27 @@ int AmMultiPartyMixer::GetCurrentSampleRate()
 //
 void AmMultiPartyMixer::mix_add(int* dest,int* src1,short* src2,unsigned int size)
 {
-  int* end_dest = dest + size;
-
-  while(dest != end_dest)
-    *(dest++) = *(src1++) + int(*(src2++));
+  kernels->mix_add(dest,src1,src2,size);
 }
 
 void AmMultiPartyMixer::mix_sub(int* dest,int* src1,short* src2,unsigned int size)
 {
-  int* end_dest = dest + size;
-
-  while(dest != end_dest)
-    *(dest++) = *(src1++) - int(*(src2++));
+  kernels->mix_sub(dest,src1,src2,size);
 }
 
 void AmMultiPartyMixer::scale(short* buffer,int* tmp_buf,unsigned int size)
 {
-  short* end_dest = buffer + size;
-    
   if(scaling_factor<64)
     scaling_factor++;
-    
-  while(buffer != end_dest){
-	
-    int s = (*tmp_buf * scaling_factor) >> 6;
-    if(abs(s) > MAX_LINEAR_SAMPLE){
-      scaling_factor = abs( (MAX_LINEAR_SAMPLE<<6) / (*tmp_buf) );
-      if(s < 0)
-	s = -MAX_LINEAR_SAMPLE;
-      else
-	s = MAX_LINEAR_SAMPLE;
-    }
-    *(buffer++) = short(s);
-    tmp_buf++;
-  }
+
+  scaling_factor = kernels->scale(buffer,tmp_buf,size,scaling_factor);
 }
 
 std::deque<MixerBufferState>::iterator AmMultiPartyMixer::findOrCreateBufferState(unsigned int sample_rate)
 {
   for (std::deque<MixerBufferState>::iterator it = buffer_state.begin(); it != buffer_state.end(); it++) {
     if (it->sample_rate == sample_rate) {
-      it->fix_channels(channelids);
+      it->fix_channels(channelids, channels_version);
       //DEBUG_MIXER_BUFFER_STATE(*it, "returned to PutChannelPacket");
       return it;
     }
@@ -282,7 +680,7 @@ AmMultiPartyMixer::findBufferStateForReading(unsigned int sample_rate,
 
     if (sys_ts_less()(last_ts,it->last_ts) 
 	|| (last_ts == it->last_ts)) {
-      it->fix_channels(channelids);
+      it->fix_channels(channelids, channels_version);
       //DEBUG_MIXER_BUFFER_STATE(*it, "returned to PutChannelPacket");
       return it;
     }
@@ -320,7 +718,8 @@ void AmMultiPartyMixer::unlock()
 }
 
 MixerBufferState::MixerBufferState(unsigned int sample_rate, std::set<int>& channelids)
-  : sample_rate(sample_rate), last_ts(0), channels(), mixed_channel(NULL)
+  : sample_rate(sample_rate), last_ts(0), channels_version(0),
+    channels(), mixed_channel(NULL)
 {
   for (std::set<int>::iterator it = channelids.begin(); it != channelids.end(); it++) {
     channels.insert(std::make_pair(*it,new SampleArrayShort()));
@@ -331,6 +730,7 @@ MixerBufferState::MixerBufferState(unsigned int sample_rate, std::set<int>& chan
 
 MixerBufferState::MixerBufferState(const MixerBufferState& other)
   : sample_rate(other.sample_rate), last_ts(other.last_ts), 
+    channels_version(other.channels_version),
     channels(other.channels), mixed_channel(other.mixed_channel)
 {
 }
@@ -365,8 +765,13 @@ SampleArrayShort* MixerBufferState::get_channel(unsigned int channel_id)
   return channel_it->second;
 }
 
-void MixerBufferState::fix_channels(std::set<int>& curchannelids)
+void MixerBufferState::fix_channels(std::set<int>& curchannelids,
+				    unsigned int version)
 {
+  if (version == channels_version)
+    return;
+  channels_version = version;
+
   for (std::set<int>::iterator it = curchannelids.begin(); it != curchannelids.end(); it++) {
     if (channels.find(*it) == channels.end()) {
       DBG("XXMixerDebugXX: fixing channel #%d", *it);
@@ -38,6 +38,39 @@
 
 #include <map>
 #include <set>
+#include <vector>
+
+class AmAudioRtpFormat;
+
+/**
+ * \brief sample mixing kernels
+ *
+ * Scalar, SSE2 and AVX2 implementations; all give the same results.
+ * get() returns the best one supported by the CPU.
+ */
+struct AmMixerKernels
+{
+  const char* name;
+
+  /** dest[i] = src1[i] + src2[i] */
+  void (*mix_add)(int* dest, const int* src1, const short* src2,
+		  unsigned int size);
+  /** dest[i] = src1[i] - src2[i] */
+  void (*mix_sub)(int* dest, const int* src1, const short* src2,
+		  unsigned int size);
+  /**
+   * buffer[i] = tmp_buf[i] * scaling_factor / 64, clipped; the factor
+   * is lowered at the first sample that would clip.
+   * @return new scaling factor
+   */
+  int (*scale)(short* buffer, const int* tmp_buf, unsigned int size,
+	       int scaling_factor);
+
+  /** best kernels for this CPU */
+  static const AmMixerKernels* get();
+  /** kernels by name ("scalar", "sse2", "avx2"), NULL if not supported */
+  static const AmMixerKernels* get(const string& name);
+};
 
 struct MixerBufferState
 {
@@ -45,6 +78,8 @@ struct MixerBufferState
 
   unsigned int sample_rate;
   unsigned int last_ts;
+  /** channel set version the channels have been fixed for */
+  unsigned int channels_version;
   ChannelMap channels;
   SampleArrayInt *mixed_channel;
 
@@ -55,7 +90,7 @@ struct MixerBufferState
   void add_channel(unsigned int channel_id);
   void remove_channel(unsigned int channel_id);
   SampleArrayShort* get_channel(unsigned int channel_id);
-  void fix_channels(std::set<int>& curchannelids);
+  void fix_channels(std::set<int>& curchannelids, unsigned int version);
   void free_channels();
 };
 
@@ -64,6 +99,11 @@ struct MixerBufferState
  * 
  * AmMultiPartyMixer mixes the audio from all channels,
  * and returns the audio of all other channels. 
+ *
+ * In active speaker mode (conference_active_speakers in sems.conf)
+ * only the loudest channels are mixed. All other listeners get the
+ * same frame, which is scaled only once and, for codecs without
+ * encoder state, also encoded only once per codec.
  */
 class AmMultiPartyMixer
 {
@@ -74,12 +114,37 @@ class AmMultiPartyMixer
   SampleRateMap    sampleratemap;
   SampleRateSet    samplerates;
   ChannelIdSet     channelids;
+  /** incremented on every channel set change */
+  unsigned int     channels_version;
   std::deque<MixerBufferState> buffer_state;
 
   AmMutex          audio_mut;
   int              scaling_factor; 
   int              tmp_buffer[AUDIO_BUFFER_SIZE/2];
 
+  const AmMixerKernels* kernels;
+
+  // active speaker mode (0: mix all channels)
+  unsigned int     active_speakers;
+  std::map<int,unsigned int> levels;
+  ChannelIdSet     speakers;
+  unsigned int     speakers_ts;
+
+  // frame for the listeners that are not speaking
+  short            listener_buf[AUDIO_BUFFER_SIZE/2];
+  bool             listener_valid;
+  unsigned int     listener_ts;
+  unsigned int     listener_samples;
+  unsigned int     listener_rate;
+
+  struct EncodedFrame {
+    int codec_id;
+    int len;
+    unsigned char data[AUDIO_BUFFER_SIZE];
+  };
+  // listener frame encoded per codec
+  std::vector<EncodedFrame> listener_encoded;
+
   std::deque<MixerBufferState>::iterator findOrCreateBufferState(unsigned int sample_rate);
   std::deque<MixerBufferState>::iterator findBufferStateForReading(unsigned int sample_rate, 
 								   unsigned long long last_ts);
@@ -89,6 +154,14 @@ class AmMultiPartyMixer
   void mix_sub(int* dest,int* src1,short* src2,unsigned int size);
   void scale(short* buffer,int* tmp_buf,unsigned int size);
 
+  void updateLevel(unsigned int channel_id, short* buffer, unsigned int samples);
+  void selectSpeakers();
+  bool isSpeaker(unsigned int channel_id) {
+    return speakers.find(channel_id) != speakers.end();
+  }
+  void getListenerFrame(MixerBufferState& bstate, unsigned int ts,
+			unsigned int samples);
+
 public:
   AmMultiPartyMixer();
   ~AmMultiPartyMixer();
@@ -107,8 +180,21 @@ public:
 			unsigned int&  size,
 			unsigned int&  output_sample_rate);
 
+  /**
+   * Get the shared frame of a listener that is not speaking,
+   * encoded for rtp_fmt (active speaker mode only).
+   * @return # bytes, 0 if the channel needs its own frame
+   */
+  int GetChannelPacketEncoded(unsigned int   channel,
+			      unsigned long long system_ts,
+			      unsigned char* buffer,
+			      AmAudioRtpFormat* rtp_fmt);
+
   int GetCurrentSampleRate();
 
+  /** mix only the n loudest channels (0: all) */
+  void setActiveSpeakers(unsigned int n);
+
   void lock();
   void unlock();
 };
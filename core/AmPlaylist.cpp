@@ -85,6 +85,21 @@ int AmPlaylist::get(unsigned long long system_ts, unsigned char* buffer,
   return ret;
 }
 
+int AmPlaylist::getEncoded(unsigned long long system_ts, unsigned char* buffer,
+			   AmAudioRtpFormat* rtp_fmt)
+{
+  int ret = 0;
+
+  // item changes are left to get()
+  cur_mut.lock();
+  updateCurrentItem();
+  if(cur_item && cur_item->play)
+    ret = cur_item->play->getEncoded(system_ts,buffer,rtp_fmt);
+  cur_mut.unlock();
+
+  return ret;
+}
+
 int AmPlaylist::put(unsigned long long system_ts, unsigned char* buffer, 
 		    int input_sample_rate, unsigned int size)
 {
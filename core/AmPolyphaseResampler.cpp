@@ -0,0 +1,338 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "AmPolyphaseResampler.h"
+#include "log.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RESAMPLER_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+// filter coefficients are Q14
+#define COEFF_SHIFT 14
+
+// zero crossings of the prototype filter on each side, in samples
+// of the lower rate: taps per phase = 2 * ZC * max(L,M) / L
+#define POLY_ZERO_CROSSINGS 8
+
+// cutoff relative to the Nyquist frequency of the lower rate
+#define POLY_CUTOFF 0.91
+
+#define POLY_KAISER_BETA 7.0
+
+enum {
+  KERNEL_SCALAR = 0,
+  KERNEL_SSE2,
+  KERNEL_AVX2,
+  KERNEL_COUNT
+};
+
+static const char* kernel_names[KERNEL_COUNT] = { "scalar", "sse2", "avx2" };
+
+typedef unsigned int (*poly_filter_t)(short* out, unsigned int out_max,
+				      const short* buf, unsigned int n_in,
+				      unsigned int& pos);
+
+struct PolyphaseRatio
+{
+  unsigned int L;
+  unsigned int M;
+  unsigned int taps;
+  poly_filter_t filter[KERNEL_COUNT];
+};
+
+static inline short clip16(int v)
+{
+  if (v > 32767) return 32767;
+  if (v < -32768) return -32768;
+  return (short)v;
+}
+
+/** zeroth order modified Bessel function (for the Kaiser window) */
+static double bessel_i0(double x)
+{
+  double sum = 1.0, term = 1.0;
+  for (int k = 1; k < 50; k++) {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum += term;
+    if (term < sum * 1e-12)
+      break;
+  }
+  return sum;
+}
+
+/**
+ * Phase p of the filter, reversed so that it is applied to the
+ * input window ending at the current sample: c[p*taps + t] =
+ * h[p + (taps-1-t)*L]. Each phase is normalized to unity DC gain.
+ */
+static void design_filter(unsigned int L, unsigned int M, unsigned int taps,
+			  short* coeffs)
+{
+  unsigned int len = taps * L;
+  double fc = POLY_CUTOFF * 0.5 / (L > M ? L : M);
+  double center = (len - 1) / 2.0;
+  double i0_beta = bessel_i0(POLY_KAISER_BETA);
+
+  std::vector<double> h(len);
+  for (unsigned int j = 0; j < len; j++) {
+    double x = j - center;
+    double sinc = x == 0.0 ? 1.0 : sin(2.0 * M_PI * fc * x) / (2.0 * M_PI * fc * x);
+    double r = x / (center + 1.0);
+    double w = bessel_i0(POLY_KAISER_BETA * sqrt(1.0 - r * r)) / i0_beta;
+    h[j] = 2.0 * fc * L * sinc * w;
+  }
+
+  for (unsigned int p = 0; p < L; p++) {
+    double sum = 0.0;
+    for (unsigned int k = 0; k < taps; k++)
+      sum += h[p + k * L];
+
+    int q_sum = 0;
+    unsigned int peak = 0;
+    for (unsigned int t = 0; t < taps; t++) {
+      unsigned int k = taps - 1 - t;
+      int q = (int)lrint(h[p + k * L] / sum * (1 << COEFF_SHIFT));
+      coeffs[p * taps + t] = (short)q;
+      q_sum += q;
+      if (abs(q) > abs(coeffs[p * taps + peak]))
+	peak = t;
+    }
+    // exact unity gain: put the rounding error on the largest tap
+    coeffs[p * taps + peak] += (1 << COEFF_SHIFT) - q_sum;
+  }
+}
+
+template<unsigned int L, unsigned int M, unsigned int TAPS>
+static const short* get_coeffs()
+{
+  struct Coeffs {
+    short c[L * TAPS] __attribute__((aligned(32)));
+    Coeffs() { design_filter(L, M, TAPS, c); }
+  };
+  static const Coeffs coeffs;
+  return coeffs.c;
+}
+
+template<unsigned int TAPS>
+static inline int dot_scalar(const short* x, const short* c)
+{
+  int acc = 0;
+  for (unsigned int t = 0; t < TAPS; t++)
+    acc += x[t] * c[t];
+  return acc;
+}
+
+#ifdef RESAMPLER_X86_KERNELS
+
+template<unsigned int TAPS>
+__attribute__((target("sse2")))
+static inline int dot_sse2(const short* x, const short* c)
+{
+  __m128i acc = _mm_setzero_si128();
+  for (unsigned int t = 0; t < TAPS; t += 8) {
+    __m128i xv = _mm_loadu_si128((const __m128i*)(x + t));
+    __m128i cv = _mm_load_si128((const __m128i*)(c + t));
+    acc = _mm_add_epi32(acc, _mm_madd_epi16(xv, cv));
+  }
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(acc);
+}
+
+template<unsigned int TAPS>
+__attribute__((target("avx2")))
+static inline int dot_avx2(const short* x, const short* c)
+{
+  __m256i acc = _mm256_setzero_si256();
+  for (unsigned int t = 0; t < TAPS; t += 16) {
+    __m256i xv = _mm256_loadu_si256((const __m256i*)(x + t));
+    __m256i cv = _mm256_load_si256((const __m256i*)(c + t));
+    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(xv, cv));
+  }
+  __m128i s = _mm_add_epi32(_mm256_castsi256_si128(acc),
+			    _mm256_extracti128_si256(acc, 1));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(s);
+}
+
+#endif // RESAMPLER_X86_KERNELS
+
+/*
+ * Output sample n is y[n*M] of the L times upsampled and filtered
+ * input, i.e. the dot product of phase (n*M)%L with the taps input
+ * samples ending at (n*M)/L. buf holds taps-1 samples of history
+ * before the n_in new samples.
+ */
+#define POLY_FILTER(kernel, attr)					\
+  template<unsigned int L, unsigned int M, unsigned int TAPS>		\
+  attr static unsigned int poly_filter_##kernel(short* out, unsigned int out_max, \
+						const short* buf, unsigned int n_in, \
+						unsigned int& pos)	\
+  {									\
+    const short* coeffs = get_coeffs<L, M, TAPS>();			\
+    const unsigned int end = n_in * L;					\
+    unsigned int n = 0;							\
+    for (; pos < end && n < out_max; pos += M) {			\
+      int acc = dot_##kernel<TAPS>(buf + pos / L, coeffs + (pos % L) * TAPS); \
+      out[n++] = clip16((acc + (1 << (COEFF_SHIFT - 1))) >> COEFF_SHIFT); \
+    }									\
+    while (pos < end) pos += M;						\
+    pos -= end;								\
+    return n;								\
+  }
+
+POLY_FILTER(scalar, )
+#ifdef RESAMPLER_X86_KERNELS
+POLY_FILTER(sse2, __attribute__((target("sse2"))))
+POLY_FILTER(avx2, __attribute__((target("avx2"))))
+#endif
+
+#define TAPS_FOR(L, M) (2 * POLY_ZERO_CROSSINGS * ((L) > (M) ? (L) : (M)) / (L) + 15) / 16 * 16
+
+#ifdef RESAMPLER_X86_KERNELS
+#define POLY_RATIO(L, M)						\
+  { L, M, TAPS_FOR(L, M),						\
+    { poly_filter_scalar<L, M, TAPS_FOR(L, M)>,				\
+      poly_filter_sse2<L, M, TAPS_FOR(L, M)>,				\
+      poly_filter_avx2<L, M, TAPS_FOR(L, M)> } }
+#else
+#define POLY_RATIO(L, M)						\
+  { L, M, TAPS_FOR(L, M),						\
+    { poly_filter_scalar<L, M, TAPS_FOR(L, M)>, NULL, NULL } }
+#endif
+
+static const PolyphaseRatio poly_ratios[] = {
+  POLY_RATIO(2, 1),  // 8 -> 16, 16 -> 32 kHz
+  POLY_RATIO(1, 2),
+  POLY_RATIO(6, 1),  // 8 -> 48 kHz
+  POLY_RATIO(1, 6),
+  POLY_RATIO(3, 1),  // 16 -> 48 kHz
+  POLY_RATIO(1, 3),
+  POLY_RATIO(4, 1),  // 8 -> 32 kHz
+  POLY_RATIO(1, 4),
+  POLY_RATIO(3, 2),  // 32 -> 48 kHz
+  POLY_RATIO(2, 3)
+};
+
+#define POLY_RATIO_COUNT (sizeof(poly_ratios) / sizeof(poly_ratios[0]))
+
+static const PolyphaseRatio* find_ratio(double ratio)
+{
+  for (unsigned int i = 0; i < POLY_RATIO_COUNT; i++) {
+    if (fabs(ratio - (double)poly_ratios[i].L / poly_ratios[i].M) < 1e-6)
+      return &poly_ratios[i];
+  }
+  return NULL;
+}
+
+static bool kernel_supported(int kernel)
+{
+  if (kernel == KERNEL_SCALAR)
+    return true;
+
+#ifdef RESAMPLER_X86_KERNELS
+  __builtin_cpu_init();
+  if (kernel == KERNEL_SSE2)
+    return __builtin_cpu_supports("sse2");
+  if (kernel == KERNEL_AVX2)
+    return __builtin_cpu_supports("avx2");
+#endif
+
+  return false;
+}
+
+AmPolyphaseResampler::AmPolyphaseResampler(const PolyphaseRatio* ratio, int kernel)
+  : ratio(ratio), kernel(kernel), buf(ratio->taps - 1), pos(0)
+{
+}
+
+AmPolyphaseResampler* AmPolyphaseResampler::create(double r, const string& kernels)
+{
+  const PolyphaseRatio* ratio = find_ratio(r);
+  if (!ratio)
+    return NULL;
+
+  int kernel = -1;
+  if (kernels.empty()) {
+    for (int k = KERNEL_COUNT - 1; k >= 0; k--) {
+      if (kernel_supported(k)) {
+	kernel = k;
+	break;
+      }
+    }
+  } else {
+    for (int k = 0; k < KERNEL_COUNT; k++) {
+      if (kernels == kernel_names[k] && kernel_supported(k))
+	kernel = k;
+    }
+  }
+
+  if (kernel < 0)
+    return NULL;
+
+  return new AmPolyphaseResampler(ratio, kernel);
+}
+
+bool AmPolyphaseResampler::supported(double ratio)
+{
+  return find_ratio(ratio) != NULL;
+}
+
+unsigned int AmPolyphaseResampler::resample(const short* in, unsigned int n_in,
+					    short* out, unsigned int out_max)
+{
+  unsigned int hist = ratio->taps - 1;
+  if (buf.size() < hist + n_in)
+    buf.resize(hist + n_in);
+
+  memcpy(&buf[hist], in, n_in * sizeof(short));
+
+  unsigned int n = (*ratio->filter[kernel])(out, out_max, &buf[0], n_in, pos);
+
+  memmove(&buf[0], &buf[n_in], hist * sizeof(short));
+  return n;
+}
+
+void AmPolyphaseResampler::reset()
+{
+  memset(&buf[0], 0, (ratio->taps - 1) * sizeof(short));
+  pos = 0;
+}
+
+const char* AmPolyphaseResampler::kernelName() const
+{
+  return kernel_names[kernel];
+}
+
+unsigned int AmPolyphaseResampler::taps() const
+{
+  return ratio->taps;
+}
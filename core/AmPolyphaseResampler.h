@@ -0,0 +1,84 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+/** @file AmPolyphaseResampler.h */
+#ifndef _AmPolyphaseResampler_h_
+#define _AmPolyphaseResampler_h_
+
+#include <string>
+#include <vector>
+using std::string;
+
+struct PolyphaseRatio;
+
+/**
+ * \brief fixed-ratio polyphase FIR resampler
+ *
+ * Resamples 16 bit mono by L/M with a windowed-sinc filter in
+ * Q14. Filters and loops are specialized at compile time for the
+ * ratios between 8, 16, 32 and 48 kHz; the dot products use scalar,
+ * SSE2 or AVX2 code, all with the same results.
+ */
+class AmPolyphaseResampler
+{
+  const PolyphaseRatio* ratio;
+  int kernel;
+
+  /** taps-1 samples of history followed by the new input */
+  std::vector<short> buf;
+  /** position of the next output sample, in 1/L input samples */
+  unsigned int pos;
+
+  AmPolyphaseResampler(const PolyphaseRatio* ratio, int kernel);
+
+public:
+  /**
+   * @param ratio output rate / input rate
+   * @param kernels "scalar", "sse2", "avx2"; empty for the best one
+   * @return NULL if ratio (or kernels) is not supported
+   */
+  static AmPolyphaseResampler* create(double ratio, const string& kernels = "");
+
+  /** is there a specialized filter for ratio? */
+  static bool supported(double ratio);
+
+  /**
+   * @return number of samples written to out (at most out_max);
+   *         in and out may be the same buffer
+   */
+  unsigned int resample(const short* in, unsigned int n_in,
+			short* out, unsigned int out_max);
+
+  /** forget the history (e.g. after a gap) */
+  void reset();
+
+  const char* kernelName() const;
+  unsigned int taps() const;
+};
+
+#endif
+
+// Local Variables:
+// mode:C++
+// End:
@@ -0,0 +1,308 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "AmPromptCache.h"
+#include "AmRtpAudio.h"
+#include "AmPlugIn.h"
+#include "AmConfig.h"
+#include "log.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+AmPromptCache* AmPromptCache::_instance = NULL;
+
+atomic_int64 AmPromptCache::hits;
+atomic_int64 AmPromptCache::misses;
+atomic_int64 AmPromptCache::evictions;
+atomic_int64 AmPromptCache::mapped_bytes;
+atomic_int64 AmPromptCache::encoded_bytes;
+atomic_int64 AmPromptCache::encoded_variants;
+atomic_int64 AmPromptCache::frames_encoded;
+atomic_int64 AmPromptCache::frames_decoded;
+atomic_int64 AmPromptCache::encode_skipped;
+
+bool AmPromptFrames::matches(AmAudioRtpFormat* rtp_fmt)
+{
+  amci_codec_t* codec = rtp_fmt->getCodec();
+  return codec && (codec->id == codec_id) &&
+    (rtp_fmt->getRate() == rate) &&
+    (rtp_fmt->getFrameSize() == frame_size) &&
+    (rtp_fmt->sdp_format_parameters == format_parameters);
+}
+
+AmPromptCacheEntry::AmPromptCacheEntry()
+  : mtime(0), last_used(0)
+{
+}
+
+AmPromptCacheEntry::~AmPromptCacheEntry()
+{
+  AmPromptCache::mapped_bytes.dec(file.getSize());
+
+  for (std::vector<AmPromptFrames*>::iterator it = frames.begin();
+       it != frames.end(); it++) {
+    AmPromptCache::encoded_bytes.dec((*it)->data.size());
+    delete *it;
+  }
+}
+
+AmPromptFrames* AmPromptCacheEntry::getFrames(AmAudioRtpFormat* rtp_fmt)
+{
+  AmLock l(frames_mut);
+
+  for (std::vector<AmPromptFrames*>::iterator it = frames.begin();
+       it != frames.end(); it++) {
+    if ((*it)->matches(rtp_fmt))
+      return *it;
+  }
+
+  amci_codec_t* codec = rtp_fmt->getCodec();
+  if (!codec)
+    return NULL;
+
+  AmPromptFrames* f = new AmPromptFrames();
+  f->codec_id = codec->id;
+  f->rate = rtp_fmt->getRate();
+  f->frame_size = rtp_fmt->getFrameSize();
+  f->channels = rtp_fmt->channels;
+  f->format_parameters = rtp_fmt->sdp_format_parameters;
+
+  // keep failed variants too, so they are not tried again
+  frames.push_back(f);
+  AmPromptCache::instance()->encodeLater(this, f);
+  return f;
+}
+
+void AmPromptCacheEntry::encode(AmPromptFrames* f)
+{
+  if ((unsigned long long)AmPromptCache::encoded_bytes.get() >=
+      AmConfig::PromptCacheMaxEncoded) {
+    DBG("prompt cache full, not encoding '%s'\n", file.getFilename().c_str());
+    AmPromptCache::encode_skipped.inc();
+    f->ready = true;
+    return;
+  }
+
+  // encode with a player of its own (fresh decoder/resampler state)
+  AmCachedAudioFile player(this);
+  if (player.encodeFrames(AmPlugIn::instance()->codec(f->codec_id), *f)) {
+    if ((unsigned long long)AmPromptCache::encoded_bytes.get() + f->data.size() >
+	AmConfig::PromptCacheMaxEncoded) {
+      DBG("prompt cache full, dropping encoded '%s'\n",
+	  file.getFilename().c_str());
+      AmPromptCache::encode_skipped.inc();
+      f->src_frame_bytes = 0;
+      std::vector<unsigned int>().swap(f->offsets);
+      std::vector<unsigned char>().swap(f->data);
+    }
+    else {
+      DBG("encoded '%s' for codec %i/%u Hz/%u samples: %u frames, %zu bytes\n",
+	  file.getFilename().c_str(), f->codec_id, f->rate, f->frame_size,
+	  f->count(), f->data.size());
+      AmPromptCache::encoded_bytes.inc(f->data.size());
+      AmPromptCache::encoded_variants.inc();
+    }
+  }
+  else {
+    DBG("'%s' can not be pre-encoded for codec %i/%u Hz/%u samples\n",
+	file.getFilename().c_str(), f->codec_id, f->rate, f->frame_size);
+  }
+
+  f->ready = true;
+}
+
+AmPromptEncoder::AmPromptEncoder()
+  : has_jobs(false), stop_requested(false)
+{
+}
+
+AmPromptEncoder::~AmPromptEncoder()
+{
+  for (std::deque<Job>::iterator it = jobs.begin(); it != jobs.end(); it++)
+    dec_ref(it->entry);
+}
+
+void AmPromptEncoder::post(AmPromptCacheEntry* entry, AmPromptFrames* f)
+{
+  Job j;
+  j.entry = entry;
+  j.frames = f;
+  inc_ref(entry);
+
+  jobs_mut.lock();
+  jobs.push_back(j);
+  has_jobs.set(true);
+  jobs_mut.unlock();
+}
+
+void AmPromptEncoder::run()
+{
+  DBG("prompt encoder thread started\n");
+
+  while (!stop_requested.get()) {
+    has_jobs.wait_for();
+
+    jobs_mut.lock();
+    if (jobs.empty()) {
+      has_jobs.set(false);
+      jobs_mut.unlock();
+      continue;
+    }
+    Job j = jobs.front();
+    jobs.pop_front();
+    jobs_mut.unlock();
+
+    j.entry->encode(j.frames);
+    dec_ref(j.entry);
+  }
+}
+
+void AmPromptEncoder::on_stop()
+{
+  stop_requested.set(true);
+  has_jobs.set(true);
+}
+
+AmPromptCache* AmPromptCache::instance()
+{
+  if (!_instance)
+    _instance = new AmPromptCache();
+  return _instance;
+}
+
+void AmPromptCache::dispose()
+{
+  if (!_instance)
+    return;
+
+  AmLock l(_instance->encoder_mut);
+  if (_instance->encoder) {
+    _instance->encoder->stop();
+    while (!_instance->encoder->is_stopped())
+      usleep(10000);
+    delete _instance->encoder;
+    _instance->encoder = NULL;
+  }
+}
+
+void AmPromptCache::encodeLater(AmPromptCacheEntry* entry, AmPromptFrames* f)
+{
+  AmLock l(encoder_mut);
+  if (!encoder) {
+    encoder = new AmPromptEncoder();
+    encoder->start();
+  }
+  encoder->post(entry, f);
+}
+
+AmPromptCacheEntry* AmPromptCache::get(const string& filename)
+{
+  struct stat st;
+  if (stat(filename.c_str(), &st)) {
+    ERROR("cannot stat file '%s'.\n", filename.c_str());
+    return NULL;
+  }
+
+  AmLock l(entries_mut);
+
+  std::map<string, AmPromptCacheEntry*>::iterator it = entries.find(filename);
+  if (it != entries.end() &&
+      it->second->mtime == st.st_mtime &&
+      it->second->file.getSize() == (size_t)st.st_size) {
+    hits.inc();
+    it->second->last_used = ++use_cnt;
+    inc_ref(it->second);
+    return it->second;
+  }
+
+  misses.inc();
+
+  AmPromptCacheEntry* e = new AmPromptCacheEntry();
+  inc_ref(e);
+  if (e->file.load(filename)) {
+    dec_ref(e);
+    return NULL;
+  }
+  e->mtime = st.st_mtime;
+  e->last_used = ++use_cnt;
+  mapped_bytes.inc(e->file.getSize());
+
+  if (it != entries.end()) {
+    // changed on disk: files still playing keep the old one
+    DBG("reloading changed prompt file '%s'\n", filename.c_str());
+    dec_ref(it->second);
+    it->second = e;
+  }
+  else {
+    entries[filename] = e;
+  }
+
+  inc_ref(e);
+  evict();
+  return e;
+}
+
+void AmPromptCache::evict()
+{
+  while ((unsigned long long)mapped_bytes.get() > AmConfig::PromptCacheMaxMapped) {
+    std::map<string, AmPromptCacheEntry*>::iterator lru = entries.end();
+    for (std::map<string, AmPromptCacheEntry*>::iterator it = entries.begin();
+	 it != entries.end(); it++) {
+      if (it->second->unused() &&
+	  (lru == entries.end() || it->second->last_used < lru->second->last_used))
+	lru = it;
+    }
+
+    if (lru == entries.end())
+      break; // all being played
+
+    DBG("dropping prompt file '%s' from the cache\n", lru->first.c_str());
+    evictions.inc();
+    dec_ref(lru->second);
+    entries.erase(lru);
+  }
+}
+
+size_t AmPromptCache::getSize()
+{
+  AmLock l(entries_mut);
+  return entries.size();
+}
+
+void AmPromptCache::getStats(AmArg& ret)
+{
+  ret["files"] = (int)getSize();
+  ret["hits"] = (long int)hits.get();
+  ret["misses"] = (long int)misses.get();
+  ret["evictions"] = (long int)evictions.get();
+  ret["mapped_bytes"] = (long int)mapped_bytes.get();
+  ret["encoded_bytes"] = (long int)encoded_bytes.get();
+  ret["encoded_variants"] = (long int)encoded_variants.get();
+  ret["frames_encoded"] = (long int)frames_encoded.get();
+  ret["frames_decoded"] = (long int)frames_decoded.get();
+  ret["encode_skipped"] = (long int)encode_skipped.get();
+}
@@ -0,0 +1,212 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+/** @file AmPromptCache.h */
+#ifndef _AmPromptCache_h_
+#define _AmPromptCache_h_
+
+#include "AmCachedAudioFile.h"
+#include "AmThread.h"
+#include "AmArg.h"
+#include "atomic_types.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <atomic>
+using std::string;
+
+class AmAudioRtpFormat;
+
+/**
+ * \brief a prompt file encoded for one RTP format
+ *
+ * Frame i holds the encoded audio of the source bytes
+ * [begin + i*src_frame_bytes, begin + (i+1)*src_frame_bytes)
+ * of the file.
+ */
+struct AmPromptFrames
+{
+  int codec_id;
+  unsigned int rate;
+  unsigned int frame_size;
+  unsigned int channels;
+  string format_parameters;
+
+  /** set by the encoder thread once the fields below are final */
+  std::atomic<bool> ready;
+
+  /** bytes of the file per frame; 0 if it could not be encoded */
+  unsigned int src_frame_bytes;
+
+  /** frame i is data[offsets[i] .. offsets[i+1]) */
+  std::vector<unsigned int> offsets;
+  std::vector<unsigned char> data;
+
+  AmPromptFrames()
+    : codec_id(-1), rate(0), frame_size(0), channels(1),
+      ready(false), src_frame_bytes(0) {}
+
+  unsigned int count() const {
+    return offsets.empty() ? 0 : offsets.size() - 1;
+  }
+
+  /** does this encoding fit the stream's current format? */
+  bool matches(AmAudioRtpFormat* rtp_fmt);
+};
+
+/**
+ * \brief process-wide shared prompt file
+ *
+ * The file is mmapped once; encoded variants for the RTP formats
+ * that play it are created by the prompt encoder thread when first
+ * asked for, and kept with the file.
+ */
+class AmPromptCacheEntry
+  : public atomic_ref_cnt
+{
+  friend class AmPromptCache;
+
+  AmFileCache file;
+  time_t mtime;
+
+  /** last get() from the cache, for dropping unused entries */
+  unsigned long long last_used;
+
+  AmMutex frames_mut;
+  std::vector<AmPromptFrames*> frames;
+
+  AmPromptCacheEntry();
+
+  /** only referenced by the cache? */
+  bool unused() const { return _get_ref() == 1; }
+
+protected:
+  ~AmPromptCacheEntry();
+
+public:
+  AmFileCache* getFile() { return &file; }
+
+  /**
+   * get the frames encoded for rtp_fmt; if not there yet, queue the
+   * file for encoding and return the variant before it is ready.
+   * Does not block.
+   * @return NULL if rtp_fmt has no codec; if ready, check
+   *         src_frame_bytes for whether the file could be encoded
+   */
+  AmPromptFrames* getFrames(AmAudioRtpFormat* rtp_fmt);
+
+  /** encode the file into f (encoder thread) */
+  void encode(AmPromptFrames* f);
+};
+
+/**
+ * \brief encodes prompt files in the background
+ *
+ * Keeps the encoding of whole files off the media processor threads.
+ */
+class AmPromptEncoder
+  : public AmThread
+{
+  struct Job {
+    AmPromptCacheEntry* entry;
+    AmPromptFrames* frames;
+  };
+
+  AmMutex jobs_mut;
+  std::deque<Job> jobs;
+  AmCondition<bool> has_jobs;
+  AmSharedVar<bool> stop_requested;
+
+protected:
+  void run();
+  void on_stop();
+
+public:
+  AmPromptEncoder();
+  ~AmPromptEncoder();
+
+  /** encode f of entry (referenced until done) */
+  void post(AmPromptCacheEntry* entry, AmPromptFrames* f);
+};
+
+/**
+ * \brief process-wide cache of prompt files
+ *
+ * All prompt collections share one mapping per file. Playback from
+ * the cache (AmCachedAudioFile) sends the pre-encoded frames directly
+ * in the RTP stream's format when possible.
+ */
+class AmPromptCache
+{
+  static AmPromptCache* _instance;
+
+  AmMutex entries_mut;
+  std::map<string, AmPromptCacheEntry*> entries;
+  unsigned long long use_cnt;
+
+  AmMutex encoder_mut;
+  AmPromptEncoder* encoder;
+
+  AmPromptCache() : use_cnt(0), encoder(NULL) {}
+
+  /** drop least recently used, unused entries while above
+      prompt_cache_max_mapped (entries_mut locked) */
+  void evict();
+  ~AmPromptCache() {}
+
+public:
+  // stats (entries may outlive lookups in the cache)
+  static atomic_int64 hits;
+  static atomic_int64 misses;
+  static atomic_int64 evictions;
+  static atomic_int64 mapped_bytes;
+  static atomic_int64 encoded_bytes;
+  static atomic_int64 encoded_variants;
+  static atomic_int64 frames_encoded;
+  static atomic_int64 frames_decoded;
+  static atomic_int64 encode_skipped;
+
+  static AmPromptCache* instance();
+  /** stop the encoder thread */
+  static void dispose();
+
+  /**
+   * get the cached file, load it if not cached or
+   * changed on disk
+   * @return referenced entry (release with dec_ref), NULL on error
+   */
+  AmPromptCacheEntry* get(const string& filename);
+
+  /** number of cached files */
+  size_t getSize();
+
+  /** queue f of entry for encoding */
+  void encodeLater(AmPromptCacheEntry* entry, AmPromptFrames* f);
+
+  void getStats(AmArg& ret);
+};
+
+#endif
@@ -84,23 +84,29 @@ int AmPromptCollection::setPrompt(const std::string& name,
 
 
 AudioFileEntry::AudioFileEntry()
-  : isopen(false)
+  : prompt(NULL), isopen(false)
 {
 }
 
 AudioFileEntry::~AudioFileEntry() {
+  if (prompt)
+    dec_ref(prompt);
 }
 
 int AudioFileEntry::load(const std::string& filename) {
-  int res = cache.load(filename);
-  isopen = !res;
-  return res;
+  if (prompt)
+    dec_ref(prompt);
+
+  // shared by all prompt collections in the process
+  prompt = AmPromptCache::instance()->get(filename);
+  isopen = (prompt != NULL);
+  return isopen ? 0 : -1;
 }
 
 AmCachedAudioFile* AudioFileEntry::getAudio(){
   if (!isopen)
     return NULL;
-  return new AmCachedAudioFile(&cache);
+  return new AmCachedAudioFile(prompt);
 }
 
 bool AmPromptCollection::hasPrompt(const string& name) {
@@ -53,7 +53,7 @@
 #include <utility>
 using std::string;
 
-#include "AmCachedAudioFile.h"
+#include "AmPromptCache.h"
 #include "AmPlaylist.h"
 #include "AmConfigReader.h"
 
@@ -114,7 +114,7 @@ class AmPromptCollection {
  */
 
 class AudioFileEntry : public AmAudioFile {
-  AmFileCache cache;
+  AmPromptCacheEntry* prompt;
   bool isopen;
 
 public:
@@ -30,6 +30,7 @@
 #include <assert.h>
 #include "AmSession.h"
 #include "AmPlayoutBuffer.h"
+#include "AmAudioProfiler.h"
 
 AmAudioRtpFormat::AmAudioRtpFormat()
   : AmAudioFormat(-1),
@@ -112,7 +113,10 @@ AmRtpAudio::AmRtpAudio(AmSession* _s, int _if)
     playout_buffer(nullptr),
     /*last_ts_i(false),*/ use_default_plc(true),
     last_check(0),last_check_i(false),send_int(false),
-    last_send_ts_i(false)
+    last_send_ts_i(false),
+    passthrough(false), pt_head(0), pt_len(0),
+    pt_last_rtp_ts(0), pt_last_rtp_ts_i(false),
+    packet_samples(0)
 {
 #ifdef USE_SPANDSP_PLC
   plc_state = plc_init(NULL);
@@ -219,35 +223,17 @@ int AmRtpAudio::receive(unsigned long long system_ts)
       continue;
     }
 
-    size = decode(size);
-    if(size < 0){
-      ERROR("decode() returned %i\n",size);
-      return -1;
-    }
-    if(size == 0){
-      DBG("decode() returned 0, skipping packet\n");
-      continue;
+    if (passthrough) {
+      queueEncoded(new_payload, rtp_ts, size);
     }
-
-    // This only works because the possible ratio (Rate/TSRate)
-    // is 2. Rate and TSRate are only different in case of g722.
-    // For g722, TSRate=8000 and Rate=16000
-    //
-    AmAudioRtpFormat* rtp_fmt = (AmAudioRtpFormat*)fmt.get();
-    unsigned long long adjusted_rtp_ts = rtp_ts;
-
-    if(rtp_fmt->getRate() != rtp_fmt->getTSRate() &&
-       rtp_fmt->getTSRate() != 0) {
-      adjusted_rtp_ts =
-	(unsigned long long)rtp_ts *
-	(unsigned long long)rtp_fmt->getRate()
-	/ (unsigned long long)rtp_fmt->getTSRate();
+    else {
+      size = decodeToPlayout(wallclock_ts, rtp_ts, size, begin_talk);
+      if(size < 0)
+	return -1;
+      if(size == 0)
+	continue;
     }
 
-    playout_buffer->write(wallclock_ts, adjusted_rtp_ts,
-			  (ShortSample*)((unsigned char *)samples),
-			  PCM16_B2S(size), begin_talk);
-
     if(!active) {
       DBG("switching to active-mode\t(ts=%u;stream=%p)\n",
 	  rtp_ts,this);
@@ -257,6 +243,141 @@ int AmRtpAudio::receive(unsigned long long system_ts)
   return size;
 }
 
+int AmRtpAudio::decodeToPlayout(unsigned int wallclock_ts, unsigned int rtp_ts,
+				int size, bool begin_talk)
+{
+  size = decode(size);
+  if(size < 0){
+    ERROR("decode() returned %i\n",size);
+    return -1;
+  }
+  if(size == 0){
+    DBG("decode() returned 0, skipping packet\n");
+    return 0;
+  }
+
+  packet_samples = PCM16_B2S(size);
+
+  // This only works because the possible ratio (Rate/TSRate)
+  // is 2. Rate and TSRate are only different in case of g722.
+  // For g722, TSRate=8000 and Rate=16000
+  //
+  AmAudioRtpFormat* rtp_fmt = (AmAudioRtpFormat*)fmt.get();
+  unsigned long long adjusted_rtp_ts = rtp_ts;
+
+  if(rtp_fmt->getRate() != rtp_fmt->getTSRate() &&
+     rtp_fmt->getTSRate() != 0) {
+    adjusted_rtp_ts =
+      (unsigned long long)rtp_ts *
+      (unsigned long long)rtp_fmt->getRate()
+      / (unsigned long long)rtp_fmt->getTSRate();
+  }
+
+  playout_buffer->write(wallclock_ts, adjusted_rtp_ts,
+			(ShortSample*)((unsigned char *)samples),
+			PCM16_B2S(size), begin_talk);
+  return size;
+}
+
+void AmRtpAudio::queueEncoded(int payload, unsigned int rtp_ts, unsigned int size)
+{
+  // the frames are only forwarded 1:1 as long as the packet
+  // length stays the same
+  AmAudioRtpFormat* rtp_fmt = (AmAudioRtpFormat*)fmt.get();
+  if (pt_last_rtp_ts_i && packet_samples) {
+    unsigned int ts_len = packet_samples;
+    if (rtp_fmt->getRate() != rtp_fmt->getTSRate() && rtp_fmt->getRate())
+      ts_len = ts_len * rtp_fmt->getTSRate() / rtp_fmt->getRate();
+
+    unsigned int ts_diff = rtp_ts - pt_last_rtp_ts;
+    if (!ts_len || ts_diff < ts_len || (ts_diff % ts_len)) {
+      DBG("packet length changed (ts diff %u), leaving passthrough\n", ts_diff);
+      packet_samples = 0;
+    }
+  }
+  pt_last_rtp_ts = rtp_ts;
+  pt_last_rtp_ts_i = true;
+
+  if (pt_len == PASSTHROUGH_QUEUE_FRAMES) {
+    // drop the oldest frame
+    pt_head = (pt_head + 1) % PASSTHROUGH_QUEUE_FRAMES;
+    pt_len--;
+  }
+
+  EncodedFrame& f = pt_queue[(pt_head + pt_len) % PASSTHROUGH_QUEUE_FRAMES];
+  f.payload = payload;
+  f.rtp_ts = rtp_ts;
+  f.begin_talk = begin_talk;
+  f.data.assign((unsigned char*)samples, (unsigned char*)samples + size);
+  pt_len++;
+}
+
+void AmRtpAudio::setPassthrough(bool enable, unsigned long long system_ts)
+{
+  if (passthrough == enable)
+    return;
+
+  passthrough = enable;
+  pt_last_rtp_ts_i = false;
+
+  if (enable || !playout_buffer.get())
+    return;
+
+  // the queued frames have not been played out yet:
+  // decode them so that get() continues where passthrough stopped
+  playout_buffer->clearLastTs();
+  unsigned int wallclock_ts = scaleSystemTS(system_ts);
+
+  for (; pt_len; pt_len--, pt_head = (pt_head + 1) % PASSTHROUGH_QUEUE_FRAMES) {
+    EncodedFrame& f = pt_queue[pt_head];
+    if (setCurrentPayload(f.payload))
+      continue;
+
+    memcpy((unsigned char*)samples, &f.data[0], f.data.size());
+    decodeToPlayout(wallclock_ts, f.rtp_ts, f.data.size(), f.begin_talk);
+  }
+  pt_head = 0;
+}
+
+bool AmRtpAudio::sameEncoding(AmAudioRtpFormat* rtp_fmt)
+{
+  AmAudioRtpFormat* own = (AmAudioRtpFormat*)fmt.get();
+  if (!own || !rtp_fmt)
+    return false;
+
+  return (own->getCodecId() == rtp_fmt->getCodecId()) &&
+    (own->getRate() == rtp_fmt->getRate()) &&
+    (own->getTSRate() == rtp_fmt->getTSRate()) &&
+    (own->channels == rtp_fmt->channels) &&
+    (own->sdp_format_parameters == rtp_fmt->sdp_format_parameters);
+}
+
+int AmRtpAudio::getEncoded(unsigned long long system_ts, unsigned char* buffer,
+			   AmAudioRtpFormat* rtp_fmt)
+{
+  if (!passthrough) return 0;
+  if (!(receiving || getPassiveMode())) return 0; // like nothing received
+
+  int ret = receive(system_ts);
+  if(ret < 0)
+    return ret;
+
+  if (!pt_len)
+    return 0;
+
+  EncodedFrame& f = pt_queue[pt_head];
+  pt_head = (pt_head + 1) % PASSTHROUGH_QUEUE_FRAMES;
+  pt_len--;
+
+  if (setCurrentPayload(f.payload))
+    return 0;
+  if (!sameEncoding(rtp_fmt))
+    return 0; // the other side switches back to decoding
+
+  memcpy(buffer, &f.data[0], f.data.size());
+  return f.data.size();
+}
+
 int AmRtpAudio::get(unsigned long long system_ts, unsigned char* buffer, 
 		    int output_sample_rate, unsigned int nb_samples)
 {
@@ -320,6 +441,30 @@ int AmRtpAudio::put(unsigned long long system_ts, unsigned char* buffer,
   return send((unsigned int)user_ts,(unsigned char*)samples,s);
 }
 
+int AmRtpAudio::getEncodedFrom(unsigned long long system_ts, AmAudio* src,
+			       unsigned char* buffer)
+{
+  if (mute || !fmt.get())
+    return 0;
+
+  return src->getEncoded(system_ts, buffer, (AmAudioRtpFormat*)fmt.get());
+}
+
+int AmRtpAudio::putEncoded(unsigned long long system_ts, unsigned char* buffer,
+			   unsigned int size)
+{
+  last_send_ts_i = true;
+  last_send_ts = system_ts;
+
+  AmAudioRtpFormat* rtp_fmt = (AmAudioRtpFormat*)fmt.get();
+
+  unsigned long long user_ts =
+    system_ts * ((unsigned long long)rtp_fmt->getTSRate() / 100)
+    / (WALLCLOCK_RATE/100);
+
+  return send((unsigned int)user_ts,buffer,size);
+}
+
 void AmRtpAudio::getSdpOffer(unsigned int index, SdpMedia& offer)
 {
   if (offer.type != MT_AUDIO) return;
@@ -411,6 +556,7 @@ int AmRtpAudio::setCurrentPayload(int payload)
 unsigned int AmRtpAudio::conceal_loss(unsigned int ts_diff, unsigned char *buffer)
 {
   int s=0;
+  AmAudioProfileScope prof(getCodecId(), AmAudioProfiler::PLC);
   if(!use_default_plc){
 
     amci_codec_t* codec = fmt->getCodec();
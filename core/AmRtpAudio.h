@@ -39,6 +39,9 @@
 
 class AmPlayoutBuffer;
 
+/** received frames buffered by a stream in passthrough mode */
+#define PASSTHROUGH_QUEUE_FRAMES 8
+
 enum PlayoutType {
   ADAPTIVE_PLAYOUT,
   JB_PLAYOUT,
@@ -115,6 +118,30 @@ class AmRtpAudio: public AmRtpStream, public AmAudio, public AmPLCBuffer
   unsigned long long last_send_ts;
   bool               last_send_ts_i;
 
+  /** passthrough mode: received frames are queued undecoded */
+  struct EncodedFrame {
+    int          payload;
+    unsigned int rtp_ts;
+    bool         begin_talk;
+    std::vector<unsigned char> data;
+  };
+
+  bool         passthrough;
+  EncodedFrame pt_queue[PASSTHROUGH_QUEUE_FRAMES];
+  unsigned int pt_head;
+  unsigned int pt_len;
+  unsigned int pt_last_rtp_ts;
+  bool         pt_last_rtp_ts_i;
+
+  /** samples per received packet, 0 if unknown or not constant */
+  unsigned int packet_samples;
+
+  /** decode the frame in samples and write it to the playout buffer */
+  int decodeToPlayout(unsigned int wallclock_ts, unsigned int rtp_ts,
+		      int size, bool begin_talk);
+
+  void queueEncoded(int payload, unsigned int rtp_ts, unsigned int size);
+
   //
   // Default packet loss concealment functions
   //
@@ -145,6 +172,38 @@ public:
   int put(unsigned long long system_ts, unsigned char* buffer, 
 	  int input_sample_rate, unsigned int size);
 
+  /**
+   * Get the next frame from src already encoded
+   * in the current payload's format.
+   * @return # bytes, 0 if src can not provide it
+   */
+  int getEncodedFrom(unsigned long long system_ts, AmAudio* src,
+		     unsigned char* buffer);
+
+  /** send a frame encoded in the current payload's format */
+  int putEncoded(unsigned long long system_ts, unsigned char* buffer,
+		 unsigned int size);
+
+  /**
+   * Passthrough mode: received frames are not decoded, but queued
+   * for getEncoded(). When leaving passthrough mode, the queued
+   * frames are decoded into the playout buffer, so that get()
+   * continues without a gap.
+   */
+  void setPassthrough(bool enable, unsigned long long system_ts);
+  bool getPassthrough() { return passthrough; }
+
+  /** @return samples per received packet, 0 if unknown or varying */
+  unsigned int getPacketSamples() { return packet_samples; }
+
+  /** does rtp_fmt encode like the current payload? */
+  bool sameEncoding(AmAudioRtpFormat* rtp_fmt);
+  AmAudioRtpFormat* getRtpFormat() { return (AmAudioRtpFormat*)fmt.get(); }
+
+  /** next received frame, in passthrough mode only */
+  int getEncoded(unsigned long long system_ts, unsigned char* buffer,
+		 AmAudioRtpFormat* rtp_fmt);
+
   unsigned int bytes2samples(unsigned int) const;
 
   // AmRtpStream interface
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2002-2003 Fhg Fokus
+ *
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "AmRtpReceiveBuffer.h"
+
+#include <string.h>
+
+// sequence numbers are 16 bit and wrap around
+#define SEQ_MASK 0xFFFF
+#define SEQ_DIFF(a, b) ((short)(unsigned short)((a) - (b)))
+
+AmRtpReceiveBuffer::AmRtpReceiveBuffer()
+  : n_spare(MAX_PACKETS),
+    returned_head(0), returned_tail(0),
+    ring_head(-1), ring_ssrc(0), ring_tail(-1),
+    late_head(0), late_tail(0),
+    events_head(0), events_tail(0),
+    clear_requested(0)
+{
+  for (int i = 0; i < MAX_PACKETS; i++)
+    spare[i] = &packets[MAX_PACKETS - 1 - i];
+  memset(returned, 0, sizeof(returned));
+  memset(ring, 0, sizeof(ring));
+  memset(late, 0, sizeof(late));
+  memset(events, 0, sizeof(events));
+}
+
+AmRtpPacket* AmRtpReceiveBuffer::newPacket()
+{
+  if (!n_spare) {
+    // collect what the consumer has released
+    unsigned int head = __atomic_load_n(&returned_head, __ATOMIC_ACQUIRE);
+    while (returned_tail != head) {
+      spare[n_spare++] = returned[returned_tail & (MAX_PACKETS - 1)];
+      returned_tail++;
+    }
+  }
+
+  if (!n_spare)
+    return NULL;
+
+  return spare[--n_spare];
+}
+
+void AmRtpReceiveBuffer::freePacket(AmRtpPacket* p)
+{
+  if (!p) return;
+  spare[n_spare++] = p;
+}
+
+void AmRtpReceiveBuffer::release(AmRtpPacket* p)
+{
+  if (!p) return;
+  // never overflows: there are only MAX_PACKETS packets
+  returned[returned_head & (MAX_PACKETS - 1)] = p;
+  __atomic_store_n(&returned_head, returned_head + 1, __ATOMIC_RELEASE);
+}
+
+AmRtpPacket* AmRtpReceiveBuffer::reusePacket()
+{
+  // oldest first: from the consumer's position, or a ring behind the newest
+  int tail = __atomic_load_n(&ring_tail, __ATOMIC_ACQUIRE);
+  if (tail < 0)
+    tail = ring_head;
+  if (tail < 0)
+    return NULL;
+  unsigned int start = tail;
+
+  for (unsigned int i = 0; i < RECV_RING_SLOTS; i++) {
+    AmRtpPacket* p = __atomic_exchange_n(&ring[(start + i) & RECV_RING_MASK],
+					 (AmRtpPacket*)NULL, __ATOMIC_ACQ_REL);
+    if (p)
+      return p;
+  }
+  return NULL;
+}
+
+bool AmRtpReceiveBuffer::putPacket(AmRtpPacket* p)
+{
+  unsigned int seq = p->sequence;
+  bool new_ssrc = ring_head >= 0 && p->ssrc != ring_ssrc;
+
+  int tail = __atomic_load_n(&ring_tail, __ATOMIC_ACQUIRE);
+  if (tail >= 0 && !new_ssrc &&
+      (unsigned int)SEQ_DIFF(ring_head, tail) <= RECV_RING_SLOTS) {
+    int d = SEQ_DIFF(seq, tail);
+    if (d < 0 && d >= -RECV_RING_SLOTS) {
+      // already passed by the consumer: pop it out of order
+      unsigned int l_tail = __atomic_load_n(&late_tail, __ATOMIC_ACQUIRE);
+      if (late_head - l_tail >= RECV_LATE_SLOTS)
+	return false;
+
+      late[late_head % RECV_LATE_SLOTS] = p;
+      __atomic_store_n(&late_head, late_head + 1, __ATOMIC_RELEASE);
+      return true;
+    }
+  }
+
+  AmRtpPacket** slot = &ring[seq & RECV_RING_MASK];
+  AmRtpPacket* old = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+  if (old && old->sequence == seq)
+    return false; // duplicate
+
+  // an older packet in the slot has not been popped for a whole ring
+  old = __atomic_exchange_n(slot, p, __ATOMIC_ACQ_REL);
+  if (old)
+    freePacket(old);
+
+  // a jump back by more than the ring or a new SSRC is a new sequence
+  int d = SEQ_DIFF(seq + 1, ring_head);
+  if (ring_head < 0 || new_ssrc || d > 0 || d < -RECV_RING_SLOTS) {
+    __atomic_store_n(&ring_ssrc, p->ssrc, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring_head, (int)((seq + 1) & SEQ_MASK), __ATOMIC_RELEASE);
+  }
+
+  return true;
+}
+
+bool AmRtpReceiveBuffer::putEvent(AmRtpPacket* p)
+{
+  unsigned int tail = __atomic_load_n(&events_tail, __ATOMIC_ACQUIRE);
+  if (events_head - tail >= RECV_EVENT_SLOTS)
+    return false;
+
+  events[events_head % RECV_EVENT_SLOTS] = p;
+  __atomic_store_n(&events_head, events_head + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+AmRtpPacket* AmRtpReceiveBuffer::pop()
+{
+  if (__atomic_load_n(&clear_requested, __ATOMIC_ACQUIRE)) {
+    __atomic_store_n(&clear_requested, 0, __ATOMIC_RELEASE);
+    drain();
+  }
+
+  // telephone events first
+  if (events_tail != __atomic_load_n(&events_head, __ATOMIC_ACQUIRE)) {
+    AmRtpPacket* p = events[events_tail % RECV_EVENT_SLOTS];
+    __atomic_store_n(&events_tail, events_tail + 1, __ATOMIC_RELEASE);
+    return p;
+  }
+
+  // then what arrived after we had passed it
+  if (late_tail != __atomic_load_n(&late_head, __ATOMIC_ACQUIRE)) {
+    AmRtpPacket* p = late[late_tail % RECV_LATE_SLOTS];
+    __atomic_store_n(&late_tail, late_tail + 1, __ATOMIC_RELEASE);
+    return p;
+  }
+
+  int head = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+  if (head < 0)
+    return NULL;
+  // at least as new as head
+  unsigned int ssrc = __atomic_load_n(&ring_ssrc, __ATOMIC_ACQUIRE);
+
+  // (re)synchronize to the last ring of sequence numbers
+  int tail = ring_tail;
+  int d = SEQ_DIFF(head, tail);
+  if (tail < 0 || d < 0 || d > RECV_RING_SLOTS)
+    tail = (head - RECV_RING_SLOTS) & SEQ_MASK;
+
+  AmRtpPacket* p = NULL;
+  while (tail != head) {
+    unsigned int seq = tail;
+    tail = (tail + 1) & SEQ_MASK;
+
+    p = __atomic_exchange_n(&ring[seq & RECV_RING_MASK], (AmRtpPacket*)NULL,
+			    __ATOMIC_ACQ_REL);
+    if (!p)
+      continue; // lost (or not yet received)
+
+    if (p->ssrc == ssrc && p->sequence == seq)
+      break;
+
+    bool newer = p->ssrc == ssrc ? SEQ_DIFF(p->sequence, seq) > 0 :
+      p->ssrc == __atomic_load_n(&ring_ssrc, __ATOMIC_ACQUIRE);
+    if (!newer) {
+      // stale: previous SSRC, or put after we had passed it
+      release(p);
+    } else {
+      // newer than our view of the head: leave it for the next pop
+      AmRtpPacket* expected = NULL;
+      if (!__atomic_compare_exchange_n(&ring[seq & RECV_RING_MASK], &expected, p,
+				       false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+	release(p);
+      tail = seq;
+      p = NULL;
+      break;
+    }
+    p = NULL;
+  }
+
+  __atomic_store_n(&ring_tail, tail, __ATOMIC_RELEASE);
+  return p;
+}
+
+void AmRtpReceiveBuffer::drain()
+{
+  unsigned int head = __atomic_load_n(&events_head, __ATOMIC_ACQUIRE);
+  while (events_tail != head) {
+    release(events[events_tail % RECV_EVENT_SLOTS]);
+    __atomic_store_n(&events_tail, events_tail + 1, __ATOMIC_RELEASE);
+  }
+
+  head = __atomic_load_n(&late_head, __ATOMIC_ACQUIRE);
+  while (late_tail != head) {
+    release(late[late_tail % RECV_LATE_SLOTS]);
+    __atomic_store_n(&late_tail, late_tail + 1, __ATOMIC_RELEASE);
+  }
+
+  for (unsigned int i = 0; i < RECV_RING_SLOTS; i++)
+    release(__atomic_exchange_n(&ring[i], (AmRtpPacket*)NULL, __ATOMIC_ACQ_REL));
+
+  __atomic_store_n(&ring_tail, -1, __ATOMIC_RELEASE);
+}
+
+void AmRtpReceiveBuffer::clear()
+{
+  __atomic_store_n(&clear_requested, 1, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2002-2003 Fhg Fokus
+ *
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+/** @file AmRtpReceiveBuffer.h */
+#ifndef _AmRtpReceiveBuffer_h_
+#define _AmRtpReceiveBuffer_h_
+
+#include "AmRtpPacket.h"
+
+#define MAX_PACKETS_BITS 5
+#define MAX_PACKETS (1<<MAX_PACKETS_BITS)
+
+/** slots of the audio ring, indexed by sequence number */
+#define RECV_RING_BITS 6
+#define RECV_RING_SLOTS (1<<RECV_RING_BITS)
+#define RECV_RING_MASK (RECV_RING_SLOTS-1)
+
+/** slots of the telephone event queue */
+#define RECV_EVENT_SLOTS 16
+/** slots of the queue of packets arriving behind the consumer */
+#define RECV_LATE_SLOTS 16
+
+/**
+ * \brief receive buffer and packet memory of an RTP stream
+ *
+ * Handoff between exactly one producer (the RTP receiver thread of
+ * the stream) and one consumer (the media processor thread), without
+ * a lock:
+ *  - audio packets go to a ring indexed by sequence number and are
+ *    popped in sequence order; duplicates still in the ring are dropped,
+ *  - packets arriving after the consumer has passed their sequence
+ *    number (reordered by the network) go to a FIFO and are popped
+ *    as soon as possible; the playout buffer puts them in place by
+ *    their timestamp,
+ *  - a new SSRC starts a new sequence,
+ *  - telephone events go to a FIFO and are popped first,
+ *  - packets the consumer is done with go back to the producer's pool
+ *    through a FIFO.
+ *
+ * Methods are marked with the thread they may be called from.
+ */
+class AmRtpReceiveBuffer
+{
+  AmRtpPacket packets[MAX_PACKETS];
+
+  /** free packets; producer only */
+  AmRtpPacket* spare[MAX_PACKETS];
+  unsigned int n_spare;
+
+  /** packets released by the consumer */
+  AmRtpPacket* returned[MAX_PACKETS];
+  unsigned int returned_head; // written by the consumer
+  unsigned int returned_tail; // written by the producer
+
+  AmRtpPacket* ring[RECV_RING_SLOTS];
+  /** next sequence number after the newest packet, -1 if none yet */
+  int ring_head; // written by the producer
+  /** SSRC of the sequence, written before ring_head */
+  unsigned int ring_ssrc; // written by the producer
+  /** next sequence number to pop, -1 if not synchronized */
+  int ring_tail; // written by the consumer
+
+  AmRtpPacket* late[RECV_LATE_SLOTS];
+  unsigned int late_head; // written by the producer
+  unsigned int late_tail; // written by the consumer
+
+  AmRtpPacket* events[RECV_EVENT_SLOTS];
+  unsigned int events_head; // written by the producer
+  unsigned int events_tail; // written by the consumer
+
+  /** set by clear(), served by the consumer */
+  int clear_requested;
+
+  void drain();
+
+ public:
+  AmRtpReceiveBuffer();
+
+  /** packet from the pool, NULL if empty (producer) */
+  AmRtpPacket* newPacket();
+  /** return a packet to the pool (producer) */
+  void freePacket(AmRtpPacket* p);
+  /** take back the oldest buffered audio packet, NULL if none (producer) */
+  AmRtpPacket* reusePacket();
+
+  /**
+   * buffer an audio packet (producer)
+   * @return false if p is a duplicate or too many packets are late;
+   *         p then still belongs to the caller
+   */
+  bool putPacket(AmRtpPacket* p);
+  /** @return false if the queue is full (producer) */
+  bool putEvent(AmRtpPacket* p);
+
+  /** next telephone event or audio packet, NULL if none (consumer) */
+  AmRtpPacket* pop();
+  /** return a popped packet to the pool (consumer) */
+  void release(AmRtpPacket* p);
+
+  /** drop all buffered packets before the next pop (any thread) */
+  void clear();
+};
+
+#endif
+
+// Local Variables:
+// mode:C++
+// End:
@@ -303,6 +303,16 @@ void _AmRtpReceiver::removeStream(int sd, int local_port)
   receivers[i].removeStream(sd, local_port);
 }
 
+struct event_base* _AmRtpReceiver::getCurrentEventBase()
+{
+  unsigned long self = (unsigned long)pthread_self();
+  for(unsigned int i=0; i<n_receivers; i++) {
+    if(receivers[i]._pid == self)
+      return receivers[i].getEventBase();
+  }
+  return NULL;
+}
+
 int _AmRtpReceiver::recvdPacket(int recvd_port, int local_port, unsigned char* buf, size_t len) {
   unsigned int i = local_port % n_receivers;
   // need to lock if received on different receiver than the stream is handled by
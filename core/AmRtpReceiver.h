@@ -111,6 +111,8 @@ public:
   void removeStream(int sd, int local_port);
   int recvdPacket(bool need_lock, int local_port, unsigned char* buf, size_t len);
 
+  struct event_base* getEventBase() { return ev_base; }
+
   void stop_and_wait();
 };
 
@@ -137,6 +139,12 @@ public:
 
   int recvdPacket(int recvd_port, int local_port, unsigned char* buf, size_t len);
   void startRtpMuxReceiver();
+
+  /**
+   * @return event base of the RTP receiver thread calling this,
+   *         NULL if not called from an RTP receiver thread
+   */
+  struct event_base* getCurrentEventBase();
 };
 
 typedef singleton<_AmRtpReceiver> AmRtpReceiver;
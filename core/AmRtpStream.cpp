@@ -379,21 +379,21 @@ int AmRtpStream::receive( unsigned char* buffer, unsigned int size,
   if(!rp->getDataSize()) {
     WARN("discarding RTP packet with zero payload data: ssrc=0x%x, seq=%u, pt=%u\n",
 	 rp->ssrc, rp->sequence, rp->payload);
-    mem.freePacket(rp);
+    receive_buf.release(rp);
     return RTP_EMPTY;
   }
 
   if (rp->payload == getLocalTelephoneEventPT())
     {
       recvDtmfPacket(rp);
-      mem.freePacket(rp);
+      receive_buf.release(rp);
       return RTP_DTMF;
     }
 
   assert(rp->getData());
   if(rp->getDataSize() > size){
     ERROR("received too big RTP packet\n");
-    mem.freePacket(rp);
+    receive_buf.release(rp);
     return RTP_BUFFER_SIZE;
   }
 
@@ -402,7 +402,7 @@ int AmRtpStream::receive( unsigned char* buffer, unsigned int size,
   out_payload = rp->payload;
 
   int res = rp->getDataSize();
-  mem.freePacket(rp);
+  receive_buf.release(rp);
   return res;
 }
 
@@ -822,12 +822,7 @@ void AmRtpStream::resume()
 {
   DBG("RTP Stream instance [%p] resuming (receiving=true, clearing biffers/TS/TO)\n", this);
   clearRTPTimeout();
-  receive_mut.lock();
-  mem.clear();
   receive_buf.clear();
-  while (!rtp_ev_qu.empty())
-    rtp_ev_qu.pop();
-  receive_mut.unlock();
   receiving = true;
 
 #ifdef WITH_ZRTP
@@ -878,7 +873,7 @@ void AmRtpStream::bufferPacket(AmRtpPacket* p)
       recvDtmfPacket(p);
     }
 
-    mem.freePacket(p);
+    receive_buf.freePacket(p);
     return;
   }
 
@@ -911,7 +906,7 @@ void AmRtpStream::bufferPacket(AmRtpPacket* p)
         relay_stream->relay(p);
       }
 
-      mem.freePacket(p);
+      receive_buf.freePacket(p);
       return;
     }
     else if (!active) {
@@ -929,7 +924,7 @@ void AmRtpStream::bufferPacket(AmRtpPacket* p)
       // - telephone-event when not in relay_raw mode and active=false
       DBG("dropping non-relayed packet (payload %d) in relay-only mode (stream [%p])\n",
           p->payload, this);
-      mem.freePacket(p);
+      receive_buf.freePacket(p);
       return;
     }
     // else: transcoding mode (active==true) - allow fall-through to buffer
@@ -939,20 +934,17 @@ void AmRtpStream::bufferPacket(AmRtpPacket* p)
 #ifndef WITH_ZRTP
   // throw away ZRTP packets 
   if(p->version != RTP_VERSION) {
-      mem.freePacket(p);
+      receive_buf.freePacket(p);
       return;
   }
 #endif
 
-  receive_mut.lock();
-
 #ifdef WITH_ZRTP
   if (session && session->enable_zrtp) {
 
     if (NULL == session->zrtp_session_state.zrtp_audio) {
       WARN("dropping received packet, as there's no ZRTP stream initialized\n");
-      receive_mut.unlock();
-      mem.freePacket(p);
+      receive_buf.freePacket(p);
       return;      
     }
  
@@ -964,17 +956,10 @@ void AmRtpStream::bufferPacket(AmRtpPacket* p)
 	p->setBufferSize(size);
 	if (p->parse() < 0) {
 	  ERROR("parsing decoded packet!\n");
-	  mem.freePacket(p);
+	  receive_buf.freePacket(p);
 	} else {
 
-          if(p->payload == getLocalTelephoneEventPT()) {
-            rtp_ev_qu.push(p);
-          } else {
-	    if(!receive_buf.insert(ReceiveBuffer::value_type(p->timestamp,p)).second) {
-	      // insert failed
-	      mem.freePacket(p);
-	    }
-          }
+	  queuePacket(p);
 
 	}
       }	break;
@@ -984,7 +969,7 @@ void AmRtpStream::bufferPacket(AmRtpPacket* p)
 	// This is a protocol ZRTP packet or masked RTP media.
 	// In either case the packet must be dropped to protect your 
 	// media codec
-	mem.freePacket(p);
+	receive_buf.freePacket(p);
 	
       } break;
 
@@ -994,25 +979,29 @@ void AmRtpStream::bufferPacket(AmRtpPacket* p)
         //
         // This is some kind of error - see logs for more information
         //
-	mem.freePacket(p);
+	receive_buf.freePacket(p);
       } break;
       }
   } else {
 #endif // WITH_ZRTP
 
-    if(p->payload == getLocalTelephoneEventPT()) {
-      rtp_ev_qu.push(p);
-    } else {
-      if(!receive_buf.insert(ReceiveBuffer::value_type(p->timestamp,p)).second) {
-	// insert failed
-	mem.freePacket(p);
-      }
-    }
+    queuePacket(p);
 
 #ifdef WITH_ZRTP
   }
 #endif
-  receive_mut.unlock();
+}
+
+void AmRtpStream::queuePacket(AmRtpPacket* p)
+{
+  bool queued;
+  if(p->payload == getLocalTelephoneEventPT())
+    queued = receive_buf.putEvent(p);
+  else
+    queued = receive_buf.putPacket(p); // late or duplicate if not
+
+  if(!queued)
+    receive_buf.freePacket(p);
 }
 
 void AmRtpStream::clearRTPTimeout(struct timeval* recv_time) {
@@ -1052,7 +1041,6 @@ int AmRtpStream::nextPacket(AmRtpPacket*& p)
   struct timeval diff;
   gettimeofday(&now,NULL);
 
-  receive_mut.lock();
   timersub(&now,&last_recv_time,&diff);
   if(monitor_rtp_timeout &&
      AmConfig::DeadRtpTime && 
@@ -1060,43 +1048,17 @@ int AmRtpStream::nextPacket(AmRtpPacket*& p)
      ((unsigned int)diff.tv_sec > AmConfig::DeadRtpTime)){
     WARN("RTP Timeout detected. Last received packet is too old "
 	 "(diff.tv_sec = %i\n",(unsigned int)diff.tv_sec);
-    receive_mut.unlock();
     return RTP_TIMEOUT;
   }
 
-  if(!rtp_ev_qu.empty()) {
-    // first return RTP telephone event payloads
-    p = rtp_ev_qu.front();
-    rtp_ev_qu.pop();
-    receive_mut.unlock();
-    return 1;
-  }
-
-  if(receive_buf.empty()){
-    receive_mut.unlock();
+  // RTP telephone event payloads come first
+  p = receive_buf.pop();
+  if(!p)
     return RTP_EMPTY;
-  }
-
-  p = receive_buf.begin()->second;
-  receive_buf.erase(receive_buf.begin());
-  receive_mut.unlock();
 
   return 1;
 }
 
-AmRtpPacket *AmRtpStream::reuseBufferedPacket()
-{
-  AmRtpPacket *p = NULL;
-
-  receive_mut.lock();
-  if(!receive_buf.empty()) {
-    p = receive_buf.begin()->second;
-    receive_buf.erase(receive_buf.begin());
-  }
-  receive_mut.unlock();
-  return p;
-}
-
 void AmRtpStream::recvPacket(int fd, unsigned char* pkt, size_t len)
 {
   if(fd == l_rtcp_sd){
@@ -1104,27 +1066,11 @@ void AmRtpStream::recvPacket(int fd, unsigned char* pkt, size_t len)
     return;
   }
 
-  AmRtpPacket* p = mem.newPacket();
-  if (!p) p = reuseBufferedPacket();
-  if (!p) {
-    // Last-resort recovery for issue #92. The relay-mode prevention in
-    // bufferPacket() covers the common case, but packets can still get
-    // stranded in rtp_ev_qu (which reuseBufferedPacket() never recycles
-    // from) or via race conditions around SDP renegotiation. Clearing the
-    // mem pool, receive_buf and rtp_ev_qu restores the stream instead of
-    // dropping every further packet until the call ends. This mirrors the
-    // semantics of AmRtpStream::resume() which already performs the same
-    // clear under receive_mut.
-    WARN("out of buffers for RTP packets, clearing buffers (stream [%p])\n",
-	this);
-    receive_mut.lock();
-    mem.clear();
-    receive_buf.clear();
-    while (!rtp_ev_qu.empty())
-      rtp_ev_qu.pop();
-    receive_mut.unlock();
-    p = mem.newPacket();
-  }
+  AmRtpPacket* p = receive_buf.newPacket();
+  // Packets cannot get stranded (issue #92): the telephone event and
+  // late packet queues are bounded, and all other buffered packets
+  // can be reused.
+  if (!p) p = receive_buf.reusePacket();
   if (!p) {
     DBG("out of buffers for RTP packets, dropping (stream [%p])\n",
 	this);
@@ -1163,12 +1109,12 @@ void AmRtpStream::recvPacket(int fd, unsigned char* pkt, size_t len)
     if (parse_res == -1) {
       DBG("error while parsing RTP packet.\n");
       clearRTPTimeout(&p->recv_time);
-      mem.freePacket(p);	  
+      receive_buf.freePacket(p);	  
     } else {
       bufferPacket(p);
     }
   } else {
-    mem.freePacket(p);
+    receive_buf.freePacket(p);
   }
 }
 
@@ -1378,52 +1324,6 @@ string AmRtpStream::getPayloadName(int payload_type)
   return string("");
 }
 
-PacketMem::PacketMem()
-  : cur_idx(0), n_used(0)
-{
-  memset(used, 0, sizeof(used));
-}
-
-inline AmRtpPacket* PacketMem::newPacket() 
-{
-  if(n_used >= MAX_PACKETS)
-    return NULL; // full
-
-  while(used[cur_idx])
-    cur_idx = (cur_idx + 1) & MAX_PACKETS_MASK;
-
-  used[cur_idx] = true;
-  n_used++;
-
-  AmRtpPacket* p = &packets[cur_idx];
-  cur_idx = (cur_idx + 1) & MAX_PACKETS_MASK;
-
-  return p;
-}
-
-inline void PacketMem::freePacket(AmRtpPacket* p) 
-{
-  if (!p)  return;
-
-  int idx = p-packets;
-  assert(idx >= 0);
-  assert(idx < MAX_PACKETS);
-
-  if(!used[idx]) {
-    ERROR("freePacket() double free: n_used = %d, idx = %d",n_used,idx);
-    return;
-  }
-
-  used[p-packets] = false;
-  n_used--;
-}
-
-inline void PacketMem::clear() 
-{
-  memset(used, 0, sizeof(used));
-  n_used = cur_idx = 0;
-}
-
 void AmRtpStream::setLogger(msg_logger* _logger)
 {
   if (logger) dec_ref(logger);
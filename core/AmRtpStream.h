@@ -33,6 +33,7 @@
 #include "AmThread.h"
 #include "SampleArray.h"
 #include "AmRtpPacket.h"
+#include "AmRtpReceiveBuffer.h"
 #include "AmEvent.h"
 #include "AmDtmfSender.h"
 
@@ -65,28 +66,6 @@ struct SdpPayload;
 struct amci_payload_t;
 class msg_logger;
 
-/**
- * This provides the memory for the receive buffer.
- */
-struct PacketMem {
-#define MAX_PACKETS_BITS 5
-#define MAX_PACKETS (1<<MAX_PACKETS_BITS)
-#define MAX_PACKETS_MASK (MAX_PACKETS-1)
-
-  AmRtpPacket packets[MAX_PACKETS];
-  bool        used[MAX_PACKETS];
-
-  PacketMem();
-
-  inline AmRtpPacket* newPacket();
-  inline void freePacket(AmRtpPacket* p);
-  inline void clear();
-
-private:
-  unsigned int cur_idx;
-  unsigned int n_used;
-};
-
 /** \brief event fired on RTP timeout */
 class AmRtpTimeoutEvent
   : public AmEvent
@@ -168,8 +147,6 @@ protected:
     uint8_t index;
   };
 
-  typedef std::map<unsigned int, AmRtpPacket*, ts_less> ReceiveBuffer;
-  typedef std::queue<AmRtpPacket*>                      RtpEventQueue;
   typedef std::map<unsigned char, PayloadMapping>       PayloadMappingTable;
   
   // mapping from local payload type to PayloadMapping
@@ -249,12 +226,10 @@ protected:
   AmDtmfSender   dtmf_sender;
 
   /**
-   * Receive buffer, queue and mutex
+   * Receive buffer and packet memory, shared by the RTP receiver
+   * (producer) and the media processor (consumer) without a lock
    */
-  PacketMem       mem;
-  ReceiveBuffer   receive_buf;
-  RtpEventQueue   rtp_ev_qu;
-  AmMutex         receive_mut;
+  AmRtpReceiveBuffer receive_buf;
 
   /** should we receive packets? if not -> drop */
   bool receiving;
@@ -292,11 +267,10 @@ protected:
 
   /** Insert an RTP packet to the buffer queue */
   void bufferPacket(AmRtpPacket* p);
+  /** hand a received packet over to the media processor */
+  void queuePacket(AmRtpPacket* p);
   /* Get next packet from the buffer queue */
   int nextPacket(AmRtpPacket*& p);
-  
-  /** Try to reuse oldest buffered packet for newly coming packet */
-  AmRtpPacket *reuseBufferedPacket();
 
   /** handle symmetric RTP/RTCP - if in passive mode, update raddr from rp */
   void handleSymmetricRtp(struct sockaddr_storage* recv_addr, bool rtcp);
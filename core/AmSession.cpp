@@ -33,6 +33,7 @@
 #include "AmApi.h"
 #include "AmSessionContainer.h"
 #include "AmSessionProcessor.h"
+#include "AmSessionExecutor.h"
 #include "AmMediaProcessor.h"
 #include "AmDtmfDetector.h"
 #include "AmPlayoutBuffer.h"
@@ -71,6 +72,9 @@ AmSession::AmSession(AmSipDialog* p_dlg)
     m_dtmfEventQueue(&m_dtmfDetector),
     m_dtmfDetectionEnabled(true),
     processing_status(SESSION_PROCESSING_EVENTS),
+#ifndef SESSION_THREADPOOL
+    exec_mode(false), exec_started(false),
+#endif
     sess_stopped(false),
     accept_early_session(false),
     rtp_interface(-1),
@@ -257,6 +261,32 @@ bool AmSession::is_stopped() {
   return processing_status == SESSION_ENDED_DISCONNECTED;
 }
 #else
+void AmSession::start() {
+  if (AmSessionExecutor::isRunning()) {
+    AmSessionExecutor::instance()->startSession(this);
+    return;
+  }
+
+  AmThread::start();
+}
+
+bool AmSession::is_stopped() {
+  if (exec_mode)
+    return exec_state.get() == AmSessionExecutor::EXEC_FINISHED;
+
+  return AmThread::is_stopped();
+}
+
+void AmSession::stopSession() {
+  if (exec_mode) {
+    // no thread to detach
+    on_stop();
+    return;
+  }
+
+  AmThread::stop();
+}
+
 // in this case every session has its own thread 
 // - this is the main processing loop
 void AmSession::run() {
@@ -448,10 +478,10 @@ void AmSession::finalize()
 #ifndef SESSION_THREADPOOL
   void AmSession::on_stop() 
 #else
-  void AmSession::stop()
+  void AmSession::stopSession()
 #endif  
 {
-  DBG("AmSession::stop()\n");
+  DBG("AmSession::stopSession()\n");
 
   if (!isDetached())
     AmMediaProcessor::instance()->clearSession(this);
@@ -1331,9 +1361,15 @@ int AmSession::writeStreams(unsigned long long ts, unsigned char *buffer)
       return 0;
     }
     int got = 0;
-    if (output) got = output->get(ts, buffer, sample_rate, f_size);
-    if (got < 0) res = -1;
-    if (got > 0) res = stream->put(ts, buffer, sample_rate, got);
+    if (output && (got = stream->getEncodedFrom(ts, output, buffer)) > 0) {
+      // pre-encoded prompt frame
+      res = stream->putEncoded(ts, buffer, got);
+    }
+    else {
+      if (output) got = output->get(ts, buffer, sample_rate, f_size);
+      if (got < 0) res = -1;
+      if (got > 0) res = stream->put(ts, buffer, sample_rate, got);
+    }
   }
 
   unlockAudio();
@@ -102,13 +102,29 @@ private:
   /** @see AmThread::run() */
   void run();
   void on_stop();
+
+  // session executor (session_executor=workstealing)
+  bool exec_mode;
+  bool exec_started;
+  atomic_int exec_state;
+  // executor thread the session is queued on (changed by stealing)
+  atomic_int exec_thread;
+
+public:
+  /** start the session's own thread, or schedule it on the executor */
+  void start();
+  bool is_stopped();
+
+private:
+  /** stop the session's thread, or its processing on the executor */
+  void stopSession();
 #else
 public:
   void start();
   bool is_stopped();
 
 private:
-  void stop();
+  void stopSession();
   void* _pid;
 #endif
 
@@ -126,6 +142,8 @@ private:
   friend class AmSessionContainer;
   friend class AmSessionFactory;
   friend class AmSessionProcessorThread;
+  friend class AmSessionExecutor;
+  friend class AmSessionExecutorThread;
 
   std::unique_ptr<AmRtpAudio> _rtp_str;
 
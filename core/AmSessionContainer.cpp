@@ -184,7 +184,7 @@ void AmSessionContainer::stopAndQueue(AmSession* s)
 	 s->getLocalTag().c_str());
   }
 
-  s->stop();
+  s->stopSession();
 
   ds_mut.lock();
   d_sessions.push(s);
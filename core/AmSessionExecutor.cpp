@@ -0,0 +1,304 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SESSION_THREADPOOL
+
+#include "AmSessionExecutor.h"
+#include "AmSession.h"
+#include "log.h"
+
+#include <unistd.h>
+
+AmSessionExecutor* AmSessionExecutor::_instance = NULL;
+
+AmSessionExecutor* AmSessionExecutor::instance()
+{
+  if (_instance == NULL)
+    _instance = new AmSessionExecutor();
+  return _instance;
+}
+
+void AmSessionExecutor::dispose()
+{
+  if (_instance != NULL) {
+    _instance->stop();
+    delete _instance;
+    _instance = NULL;
+  }
+}
+
+AmSessionExecutor::AmSessionExecutor()
+  : running(false)
+{
+}
+
+AmSessionExecutor::~AmSessionExecutor()
+{
+}
+
+void AmSessionExecutor::start(unsigned int num_threads)
+{
+  if (running) {
+    ERROR("session executor already running\n");
+    return;
+  }
+
+  if (!num_threads) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    num_threads = cpus > 0 ? cpus : 1;
+  }
+
+  DBG("starting %u session executor threads\n", num_threads);
+  for (unsigned int i=0; i<num_threads; i++)
+    threads.push_back(new AmSessionExecutorThread(this, i));
+  for (unsigned int i=0; i<num_threads; i++)
+    threads[i]->start();
+
+  running = true;
+}
+
+void AmSessionExecutor::stop()
+{
+  if (!running)
+    return;
+  running = false;
+
+  for (unsigned int i=0; i<threads.size(); i++)
+    threads[i]->stop();
+
+  bool threads_stopped;
+  do {
+    usleep(10000); // 10ms
+    threads_stopped = true;
+    for (unsigned int i=0; i<threads.size(); i++) {
+      if (!threads[i]->is_stopped()) {
+	threads_stopped = false;
+	break;
+      }
+    }
+  } while(!threads_stopped);
+
+  for (unsigned int i=0; i<threads.size(); i++) {
+    if (!threads[i]->run_queue.empty()) {
+      WARN("%zd sessions left in run queue of session executor thread %u\n",
+	   threads[i]->run_queue.size(), i);
+    }
+    delete threads[i];
+  }
+  threads.clear();
+}
+
+void AmSessionExecutor::startSession(AmSession* s)
+{
+  s->exec_mode = true;
+  s->exec_started = false;
+  s->exec_thread.set(next_thread.inc() % threads.size());
+
+  // queued from now on, so that notify() does not schedule it twice
+  s->exec_state.set(EXEC_QUEUED);
+
+  // register us to be notified if some event comes to the session
+  s->setEventNotificationSink(this);
+
+  // run startup() and events already in queue
+  enqueue(s);
+}
+
+void AmSessionExecutor::notify(AmEventQueue* sender)
+{
+  AmSession* s = static_cast<AmSession*>(sender);
+
+  while (true) {
+    switch (s->exec_state.get()) {
+    case EXEC_IDLE:
+      if (s->exec_state.cas(EXEC_IDLE, EXEC_QUEUED)) {
+	enqueue(s);
+	return;
+      }
+      break;
+
+    case EXEC_RUNNING:
+      // the worker queues it again after the processing cycle
+      if (s->exec_state.cas(EXEC_RUNNING, EXEC_NOTIFIED))
+	return;
+      break;
+
+    default: // already queued/notified, or finished
+      return;
+    }
+  }
+}
+
+void AmSessionExecutor::enqueue(AmSession* s)
+{
+  AmSessionExecutorThread* t = threads[s->exec_thread.get()];
+  t->push(s);
+
+  // if the home thread is busy, have an idle one steal it
+  if (idle_threads.get() && !t->isIdle()) {
+    for (unsigned int i=1; i<threads.size(); i++) {
+      AmSessionExecutorThread* o = threads[(s->exec_thread.get() + i) % threads.size()];
+      if (o->isIdle()) {
+	o->runcond.set(true);
+	break;
+      }
+    }
+  }
+}
+
+bool AmSessionExecutor::steal(unsigned int thief, AmSession*& s)
+{
+  for (unsigned int i=1; i<threads.size(); i++) {
+    if (threads[(thief + i) % threads.size()]->popBack(s))
+      return true;
+  }
+  return false;
+}
+
+void AmSessionExecutor::getStats(AmArg& ret)
+{
+  ret.assertArray();
+  for (unsigned int i=0; i<threads.size(); i++) {
+    AmArg t;
+    t["runs"] = (long int)threads[i]->runs.get();
+    t["steals"] = (long int)threads[i]->steals.get();
+    threads[i]->run_queue_mut.lock();
+    t["queued"] = (int)threads[i]->run_queue.size();
+    threads[i]->run_queue_mut.unlock();
+    ret.push(t);
+  }
+}
+
+
+AmSessionExecutorThread::AmSessionExecutorThread(AmSessionExecutor* executor,
+						 unsigned int idx)
+  : executor(executor), idx(idx), runcond(false),
+    stop_requested(false), idle(false)
+{
+}
+
+AmSessionExecutorThread::~AmSessionExecutorThread()
+{
+}
+
+void AmSessionExecutorThread::push(AmSession* s)
+{
+  run_queue_mut.lock();
+  run_queue.push_back(s);
+  run_queue_mut.unlock();
+  runcond.set(true);
+}
+
+bool AmSessionExecutorThread::pop(AmSession*& s)
+{
+  AmLock l(run_queue_mut);
+  if (run_queue.empty())
+    return false;
+  s = run_queue.front();
+  run_queue.pop_front();
+  return true;
+}
+
+bool AmSessionExecutorThread::popBack(AmSession*& s)
+{
+  AmLock l(run_queue_mut);
+  if (run_queue.empty())
+    return false;
+  s = run_queue.back();
+  run_queue.pop_back();
+  return true;
+}
+
+void AmSessionExecutorThread::run()
+{
+  while (!stop_requested.get()) {
+    AmSession* s = NULL;
+    if (pop(s) || executor->steal(idx, s)) {
+      if (s->exec_thread.get() != idx)
+	steals.inc();
+      runSession(s);
+      continue;
+    }
+
+    // check again after resetting runcond, so that no push is missed
+    runcond.set(false);
+    if (pop(s) || executor->steal(idx, s)) {
+      if (s->exec_thread.get() != idx)
+	steals.inc();
+      runSession(s);
+      continue;
+    }
+
+    idle = true;
+    executor->idle_threads.inc();
+    runcond.wait_for();
+    executor->idle_threads.dec();
+    idle = false;
+  }
+}
+
+void AmSessionExecutorThread::runSession(AmSession* s)
+{
+  runs.inc();
+
+  s->exec_state.set(AmSessionExecutor::EXEC_RUNNING);
+  s->exec_thread.set(idx);
+
+  if (!s->exec_started) {
+    s->exec_started = true;
+    DBG("starting up [%s|%s]: [%p]\n",
+	s->getCallID().c_str(), s->getLocalTag().c_str(), s);
+    if (!s->startup()) {
+      s->exec_state.set(AmSessionExecutor::EXEC_FINISHED);
+      return;
+    }
+  }
+
+  if (!s->processingCycle()) {
+    DBG("finalizing session [%p/%s/%s]\n",
+	s, s->getCallID().c_str(), s->getLocalTag().c_str());
+    s->finalize();
+    // from here on the session may be deleted by the session container
+    s->exec_state.set(AmSessionExecutor::EXEC_FINISHED);
+    return;
+  }
+
+  if (s->exec_state.cas(AmSessionExecutor::EXEC_RUNNING,
+			AmSessionExecutor::EXEC_IDLE))
+    return;
+
+  // events arrived while processing
+  s->exec_state.set(AmSessionExecutor::EXEC_QUEUED);
+  push(s);
+}
+
+void AmSessionExecutorThread::on_stop()
+{
+  INFO("requesting session executor thread to stop.\n");
+  stop_requested.set(true);
+  runcond.set(true);
+}
+
+#endif // #ifndef SESSION_THREADPOOL
@@ -0,0 +1,143 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SESSION_THREADPOOL
+
+#ifndef _AmSessionExecutor_h_
+#define _AmSessionExecutor_h_
+
+#include "AmThread.h"
+#include "AmEventQueue.h"
+#include "AmArg.h"
+#include "atomic_types.h"
+
+#include <vector>
+#include <deque>
+
+class AmSession;
+class AmSessionExecutor;
+
+/**
+ * \brief worker thread of the session executor
+ *
+ * Runs the sessions from its own run queue (front); when that is
+ * empty, it steals from the back of the other workers' queues.
+ */
+class AmSessionExecutorThread
+  : public AmThread
+{
+  friend class AmSessionExecutor;
+
+  AmSessionExecutor* executor;
+  unsigned int idx;
+
+  std::deque<AmSession*> run_queue;
+  AmMutex run_queue_mut;
+
+  AmCondition<bool> runcond;
+  AmSharedVar<bool> stop_requested;
+  volatile bool idle;
+
+  atomic_int64 runs;
+  atomic_int64 steals;
+
+  bool pop(AmSession*& s);
+  bool popBack(AmSession*& s);
+  void runSession(AmSession* s);
+
+ protected:
+  // AmThread interface
+  void run();
+  void on_stop();
+
+ public:
+  AmSessionExecutorThread(AmSessionExecutor* executor, unsigned int idx);
+  ~AmSessionExecutorThread();
+
+  void push(AmSession* s);
+  bool isIdle() { return idle; }
+};
+
+/**
+ * \brief runs sessions on a fixed set of worker threads
+ *
+ * With session_executor=workstealing, sessions do not get an own
+ * thread; a session is put on a worker's run queue only when an
+ * event is posted to its event queue, and runs one processing cycle
+ * there. Idle workers steal sessions queued at busy ones.
+ */
+class AmSessionExecutor
+  : public AmEventNotificationSink
+{
+ public:
+  /** scheduling state of a session (AmSession::exec_state) */
+  enum ExecState {
+    EXEC_IDLE = 0,  // no events pending
+    EXEC_QUEUED,    // on a run queue
+    EXEC_RUNNING,   // processing
+    EXEC_NOTIFIED,  // processing, and new events arrived meanwhile
+    EXEC_FINISHED   // finalized, may be deleted
+  };
+
+ private:
+  static AmSessionExecutor* _instance;
+
+  std::vector<AmSessionExecutorThread*> threads;
+  atomic_int next_thread;
+  atomic_int idle_threads;
+  bool running;
+
+  AmSessionExecutor();
+  ~AmSessionExecutor();
+
+  void enqueue(AmSession* s);
+
+  friend class AmSessionExecutorThread;
+  bool steal(unsigned int thief, AmSession*& s);
+
+ public:
+  static AmSessionExecutor* instance();
+  static void dispose();
+
+  /** whether sessions are to be run on the executor */
+  static bool isRunning() { return _instance && _instance->running; }
+
+  /** start num_threads workers (0: one per online CPU) */
+  void start(unsigned int num_threads);
+  void stop();
+
+  /** schedule a new session (instead of AmThread::start()) */
+  void startSession(AmSession* s);
+
+  // AmEventNotificationSink interface
+  void notify(AmEventQueue* sender);
+
+  /** per worker runs/steals/queued */
+  void getStats(AmArg& ret);
+};
+
+#endif // _AmSessionExecutor_h_
+
+#endif // #ifndef SESSION_THREADPOOL
@@ -128,7 +128,7 @@ bool AmSIPRegistration::doRegistration()
     flags = SIP_FLAGS_NOCONTACT;
   }
     
-  if (dlg.sendRequest(req.method, NULL, hdrs, flags) < 0) {
+  if (sendRegisterRequest(hdrs, flags) < 0) {
     ERROR("failed to send registration.\n");
     res = false;
     waiting_result = false;
@@ -160,12 +160,12 @@ bool AmSIPRegistration::doUnregister()
   int flags=0;
   string hdrs = SIP_HDR_COLSP(SIP_HDR_EXPIRES) "0" CRLF;
   if(!info.contact.empty()) {
-    hdrs = SIP_HDR_COLSP(SIP_HDR_CONTACT) "<";
+    hdrs += SIP_HDR_COLSP(SIP_HDR_CONTACT) "<";
     hdrs += info.contact + ">" + CRLF;
     flags = SIP_FLAGS_NOCONTACT;
   }
     
-  if (dlg.sendRequest(req.method, NULL, hdrs, flags) < 0) {
+  if (sendRegisterRequest(hdrs, flags) < 0) {
     ERROR("failed to send deregistration.\n");
     res = false;
     waiting_result = false;
@@ -176,6 +176,24 @@ bool AmSIPRegistration::doUnregister()
   return res;
 }
 
+int AmSIPRegistration::sendRegisterRequest(const string& hdrs, int flags)
+{
+  return dlg.sendRequest(req.method, NULL, hdrs, flags);
+}
+
+void AmSIPRegistration::onRxReply(const AmSipReply& reply)
+{
+  dlg.onRxReply(reply);
+}
+
+void AmSIPRegistration::postRegistrationEvent(SIPRegistrationEvent* ev)
+{
+  if (sess_link.length())
+    AmSessionContainer::instance()->postEvent(sess_link, ev);
+  else
+    delete ev;
+}
+
 void AmSIPRegistration::onSendRequest(AmSipRequest& req, int& flags)
 {
   if (seh)
@@ -212,12 +230,19 @@ unsigned int AmSIPRegistration::getExpiresLeft() {
 time_t AmSIPRegistration::getExpiresTS() {
   return reg_begin + reg_expires;
 }
+
+time_t AmSIPRegistration::getRefreshTS() {
+  return reg_begin + reg_expires/2;
+}
+
+time_t AmSIPRegistration::getSendTimeoutTS() {
+  return reg_send_begin + REGISTER_SEND_TIMEOUT;
+}
 	
 void AmSIPRegistration::onRegisterExpired() {
   if (sess_link.length()) {
-    AmSessionContainer::instance()->postEvent(sess_link,
-					      new SIPRegistrationEvent(SIPRegistrationEvent::RegisterTimeout,
-								       req.from_tag));
+    postRegistrationEvent(new SIPRegistrationEvent(SIPRegistrationEvent::RegisterTimeout,
+						   req.from_tag));
   }
   DBG("Registration '%s' expired.\n", (info.user+"@"+info.domain).c_str());
   active = false;
@@ -226,10 +251,8 @@ void AmSIPRegistration::onRegisterExpired() {
 
 void AmSIPRegistration::onRegisterSendTimeout() {
   if (sess_link.length()) {
-    AmSessionContainer::instance()->
-      postEvent(sess_link,
-		new SIPRegistrationEvent(SIPRegistrationEvent::RegisterSendTimeout,
-					 req.from_tag));
+    postRegistrationEvent(new SIPRegistrationEvent(SIPRegistrationEvent::RegisterSendTimeout,
+						   req.from_tag));
   }
   DBG("Registration '%s' REGISTER request timeout.\n", 
       (info.user+"@"+info.domain).c_str());
@@ -276,11 +299,9 @@ void AmSIPRegistration::onSipReply(const AmSipRequest& req,
 	DBG("no contacts registered any more\n");
       }
       if (sess_link.length()) {
-	AmSessionContainer::instance()->
-	  postEvent(sess_link,
-		    new SIPRegistrationEvent(SIPRegistrationEvent::RegisterNoContact,
-					     req.from_tag,
-					     reply.code, reply.reason));
+	postRegistrationEvent(new SIPRegistrationEvent(SIPRegistrationEvent::RegisterNoContact,
+						       req.from_tag,
+						       reply.code, reply.reason));
       }
 
     } else {
@@ -325,11 +346,9 @@ void AmSIPRegistration::onSipReply(const AmSipRequest& req,
 
 	    if (sess_link.length()) {
 	      DBG("posting SIPRegistrationEvent to '%s'\n", sess_link.c_str());
-	      AmSessionContainer::instance()->
-		postEvent(sess_link,
-			  new SIPRegistrationEvent(SIPRegistrationEvent::RegisterSuccess,
-						   req.from_tag,
-						   reply.code, reply.reason));
+	      postRegistrationEvent(new SIPRegistrationEvent(SIPRegistrationEvent::RegisterSuccess,
+							     req.from_tag,
+							     reply.code, reply.reason));
 	    }
 	    break;
 	  }
@@ -337,11 +356,9 @@ void AmSIPRegistration::onSipReply(const AmSipRequest& req,
       }
       if (!found) {
 	if (sess_link.length()) {
-	  AmSessionContainer::instance()->
-	    postEvent(sess_link,
-		      new SIPRegistrationEvent(SIPRegistrationEvent::RegisterNoContact,
-					       req.from_tag,
-					       reply.code, reply.reason));
+	  postRegistrationEvent(new SIPRegistrationEvent(SIPRegistrationEvent::RegisterNoContact,
+							 req.from_tag,
+							 reply.code, reply.reason));
 	}
 	DBG("no matching Contact - deregistered.\n");
 	active = false;
@@ -352,11 +369,9 @@ void AmSIPRegistration::onSipReply(const AmSipRequest& req,
   } else if (reply.code >= 300) {
     DBG("Registration failed.\n");
     if (sess_link.length()) {
-      AmSessionContainer::instance()->
-	postEvent(sess_link,
-		  new SIPRegistrationEvent(SIPRegistrationEvent::RegisterFailed,
-					   req.from_tag,
-					   reply.code, reply.reason));
+      postRegistrationEvent(new SIPRegistrationEvent(SIPRegistrationEvent::RegisterFailed,
+						     req.from_tag,
+						     reply.code, reply.reason));
     }
     active = false;
     remove = true;		
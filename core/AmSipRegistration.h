@@ -87,6 +87,13 @@ class AmSIPRegistration
 
   unsigned int expires_interval;
 
+ protected:
+  /** send the REGISTER through the dialog */
+  virtual int sendRegisterRequest(const string& hdrs, int flags);
+
+  /** report a status change to the event sink (sess_link) */
+  virtual void postRegistrationEvent(SIPRegistrationEvent* ev);
+
  public:
   AmSIPRegistration(const string& handle,
 		    const SIPRegistrationInfo& info,
@@ -109,6 +116,9 @@ class AmSIPRegistration
 
   bool registerSendTimeout(time_t now_sec);
 
+  /** feed a reply to the REGISTER into the dialog */
+  virtual void onRxReply(const AmSipReply& reply);
+
   void onSendRequest(AmSipRequest& req, int& flags);
   void onSendReply(const AmSipRequest& req, AmSipReply& reply, int& flags);
 
@@ -141,6 +151,10 @@ class AmSIPRegistration
   unsigned int getExpiresLeft();
   /** return the expires TS for the registration */
   time_t getExpiresTS();
+  /** return the TS after which timeToReregister() */
+  time_t getRefreshTS();
+  /** return the TS after which registerSendTimeout() */
+  time_t getSendTimeoutTS();
 
   bool getUnregistering();
 
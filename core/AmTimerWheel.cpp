@@ -0,0 +1,146 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "AmTimerWheel.h"
+
+AmTimerWheel::AmTimerWheel(time_t now, unsigned int n_slots,
+			   unsigned int slot_len)
+  : n_slots(n_slots ? n_slots : 1),
+    slot_len(slot_len ? slot_len : 1),
+    start(now), current(now), timers(0)
+{
+  slots = new AmWheelTimer[this->n_slots];
+  loads = new unsigned int[this->n_slots];
+  for (unsigned int i=0; i<this->n_slots; i++) {
+    slots[i].prev = slots[i].next = &slots[i];
+    loads[i] = 0;
+  }
+}
+
+AmTimerWheel::~AmTimerWheel()
+{
+  delete [] slots;
+  delete [] loads;
+}
+
+long AmTimerWheel::slotNumber(time_t t) const
+{
+  if (t < start)
+    return 0;
+  return (t - start) / slot_len;
+}
+
+void AmTimerWheel::unlink(AmWheelTimer* t)
+{
+  t->prev->next = t->next;
+  t->next->prev = t->prev;
+  t->prev = t->next = NULL;
+  loads[t->slot]--;
+  timers--;
+}
+
+void AmTimerWheel::schedule(AmWheelTimer* t, time_t due)
+{
+  if (t->isScheduled())
+    unlink(t);
+
+  t->due = due;
+  if (due < current)
+    due = current;
+
+  t->slot = slotNumber(due) % n_slots;
+  AmWheelTimer* head = &slots[t->slot];
+  t->prev = head->prev;
+  t->next = head;
+  head->prev->next = t;
+  head->prev = t;
+  loads[t->slot]++;
+  timers++;
+}
+
+void AmTimerWheel::cancel(AmWheelTimer* t)
+{
+  if (t->isScheduled())
+    unlink(t);
+}
+
+void AmTimerWheel::expire(time_t now, std::vector<AmWheelTimer*>& fired)
+{
+  if (now <= current)
+    return;
+
+  // after a long sleep, every slot once is enough
+  long first = slotNumber(current);
+  long n = slotNumber(now - 1) - first + 1;
+  if (n > (long)n_slots)
+    n = n_slots;
+
+  for (long s = first; s < first + n; s++) {
+    AmWheelTimer* head = &slots[s % n_slots];
+    AmWheelTimer* t = head->next;
+    while (t != head) {
+      AmWheelTimer* next = t->next;
+      if (t->due < now) {
+	unlink(t);
+	fired.push_back(t);
+      }
+      t = next;
+    }
+  }
+
+  current = now;
+}
+
+bool AmTimerWheel::leastLoaded(time_t from_time, time_t to_time,
+			       time_t& slot_start) const
+{
+  if (to_time < current)
+    return false;
+
+  if (from_time < current)
+    from_time = current;
+
+  long first = slotNumber(from_time);
+  long last = slotNumber(to_time);
+  if (last - first >= (long)n_slots)
+    last = first + n_slots - 1;
+
+  long res = first;
+  unsigned int least_load = loads[first % n_slots];
+  for (long s = first; s < last; s++) {
+    if (loads[s % n_slots] <= least_load) {
+      least_load = loads[s % n_slots];
+      res = s;
+    }
+  }
+
+  slot_start = start + (time_t)res * slot_len;
+  return true;
+}
+
+unsigned int AmTimerWheel::getLoad(time_t t) const
+{
+  return loads[slotNumber(t) % n_slots];
+}
@@ -0,0 +1,111 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+/** @file AmTimerWheel.h */
+#ifndef _AmTimerWheel_h_
+#define _AmTimerWheel_h_
+
+#include <time.h>
+
+#include <vector>
+
+/** timer of an AmTimerWheel, to be inherited by its owner */
+struct AmWheelTimer
+{
+  time_t due;
+
+  // slot list, NULL if not scheduled
+  AmWheelTimer* prev;
+  AmWheelTimer* next;
+  unsigned int slot;
+
+  AmWheelTimer()
+    : due(0), prev(NULL), next(NULL), slot(0) { }
+
+  bool isScheduled() const { return next != NULL; }
+};
+
+/**
+  Hashed timer wheel with second resolution.
+
+  The wheel has n_slots slots of slot_len seconds each, counted from
+  the time it was created. A timer is linked into the slot of its due
+  time (modulo n_slots), so scheduling and cancelling are O(1) with any
+  number of timers. A timer fires with the first expire() after its due
+  time; expire() visits the slots of the time passed since it was last
+  called, a timer due more than one round ahead stays in its slot for
+  the next round(s).
+
+  The number of timers per slot is kept, so a timer can be put into the
+  least loaded slot of an interval to spread out load peaks.
+
+  Timers are not owned. Not locked: use it from one thread, or lock it.
+ */
+class AmTimerWheel
+{
+  unsigned int n_slots;
+  unsigned int slot_len;
+
+  // the slots are the list heads
+  AmWheelTimer* slots;
+  unsigned int* loads;
+
+  time_t start;
+  // last expire() time
+  time_t current;
+  size_t timers;
+
+  /** slot number from the start on */
+  long slotNumber(time_t t) const;
+  void unlink(AmWheelTimer* t);
+
+ public:
+  AmTimerWheel(time_t now, unsigned int n_slots, unsigned int slot_len = 1);
+  ~AmTimerWheel();
+
+  /** (re-)schedule t; if due is before the current time, t is taken
+      by the next expire() */
+  void schedule(AmWheelTimer* t, time_t due);
+  void cancel(AmWheelTimer* t);
+
+  /** take the timers due before now */
+  void expire(time_t now, std::vector<AmWheelTimer*>& fired);
+
+  /**
+     find the least loaded slot from from_time on, before the slot of
+     to_time (the latest one of equally loaded slots)
+     @param slot_start start time of the slot found
+     @return false if the interval is over already
+  */
+  bool leastLoaded(time_t from_time, time_t to_time, time_t& slot_start) const;
+
+  /** timers in the slot of t */
+  unsigned int getLoad(time_t t) const;
+
+  size_t size() const { return timers; }
+  time_t getTime() const { return current; }
+  unsigned int getSlotLength() const { return slot_len; }
+};
+
+#endif
@@ -0,0 +1,108 @@
+/*
+ * This file is part of SEMS, a free SIP media server.
+ *
+ * SEMS is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version. This program is released under
+ * the GPL with the additional exemption that compiling, linking,
+ * and/or using OpenSSL is allowed.
+ *
+ * For a license to use the SEMS software under conditions
+ * other than those described here, or to purchase support for this
+ * software, please contact iptel.org by e-mail at the following addresses:
+ *    info@iptel.org
+ *
+ * SEMS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _HTTPCLIENTAPI_H
+#define _HTTPCLIENTAPI_H
+
+#include <string>
+#include "AmEvent.h"
+
+using std::string;
+
+// the http_client module serves requests posted to this event queue
+// (AmEventDispatcher::instance()->post(HTTP_CLIENT_QUEUE, req)), or
+// through its DI interface:
+//
+// get
+//   string url
+//   string sess_link
+//   string token
+//   [int timeout_ms]
+//
+// post
+//   string url
+//   string body
+//   string content_type
+//   string sess_link
+//   string token
+//   [int timeout_ms]
+//
+//  returns :
+//    0    OK
+//    != 0 error
+//
+// and posts an HttpResponseEvent to sess_link when the request is done.
+
+#define HTTP_CLIENT_QUEUE "http_client"
+
+#define HTTP_RESPONSE_EVENT_ID 124
+
+struct HttpRequestEvent : public AmEvent {
+  enum Method {
+    Get = 0,
+    Post
+  };
+
+  string url;
+  /** POST body and its type */
+  string body;
+  string content_type;
+
+  /** event queue to post the response to */
+  string sess_link;
+  /** returned with the response */
+  string token;
+  /** deadline for the whole request, 0 for the configured default */
+  unsigned int timeout_ms;
+
+  HttpRequestEvent(Method method, const string& url,
+		   const string& sess_link, const string& token,
+		   unsigned int timeout_ms = 0)
+    : AmEvent(method), url(url), sess_link(sess_link), token(token),
+      timeout_ms(timeout_ms) { }
+};
+
+struct HttpResponseEvent : public AmEvent {
+  string token;
+  string url;
+
+  /** HTTP status code, 0 if there was no response */
+  long status;
+  string body;
+  string content_type;
+
+  /** 0 if the request went through, else the curl error code */
+  int error;
+  string error_str;
+
+  /** time the request took */
+  unsigned int time_ms;
+
+  HttpResponseEvent(const string& token, const string& url)
+    : AmEvent(HTTP_RESPONSE_EVENT_ID), token(token), url(url),
+      status(0), error(0), time_ms(0) { }
+};
+
+#endif
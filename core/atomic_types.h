@@ -65,6 +65,11 @@ public:
   unsigned int dec(unsigned int sub=1) {
     return __sync_sub_and_fetch(&i,sub);
   }
+
+  // if (i == oldval) { i = newval; return true; } else return false;
+  bool cas(unsigned int oldval, unsigned int newval) {
+    return __sync_bool_compare_and_swap(&i,oldval,newval);
+  }
 #else // if HAVE_ATOMIC_CAS
   // ++i;
   unsigned int inc(unsigned int add=1) {
@@ -83,6 +88,18 @@ public:
     unlock();
     return res;
   }
+
+  // if (i == oldval) { i = newval; return true; } else return false;
+  bool cas(unsigned int oldval, unsigned int newval) {
+    bool res = false;
+    lock();
+    if (i == oldval) {
+      i = newval;
+      res = true;
+    }
+    unlock();
+    return res;
+  }
 #endif
 
   // return --ll != 0;
@@ -201,6 +218,7 @@ protected:
 
   void _inc_ref() { ref_cnt.inc(); }
   bool _dec_ref() { return ref_cnt.dec_and_test(); }
+  unsigned int _get_ref() const { return ref_cnt.get(); }
 
   virtual ~atomic_ref_cnt() {}
   virtual void on_destroy() {}
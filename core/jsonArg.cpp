@@ -51,108 +51,136 @@ string str2json(const string& str)
 }
 
 string str2json(const char* str, size_t len)
+{
+  string result;
+  str2json(str, len, result);
+  return result;
+}
+
+void str2json(const char* str, size_t len, string& out)
 {
     // borrowed from jsoncpp
     // Not sure how to handle unicode...
-    if (strpbrk(str, "\"\\\b\f\n\r\t") == NULL)
-      return string("\"") + str + "\"";
+    const char* end = str + len;
+    const char* c = str;
+    for (; c != end && *c != 0; ++c) {
+      if (*c == '"' || *c == '\\' || (unsigned char)*c < ' ')
+	break;
+    }
+    if (c == end || *c == 0) {
+      out += '"';
+      out.append(str, c - str);
+      out += '"';
+      return;
+    }
     // We have to walk value and escape any special characters.
-    // Appending to std::string is not efficient, but this should be rare.
     // (Note: forward slashes are *not* rare, but I am not escaping them.)
-    unsigned maxsize = len*2 + 3; // allescaped+quotes+NULL
-    std::string result;
-    result.reserve(maxsize); // to avoid lots of mallocs
-    result += "\"";
-    const char* end = str + len;
-    for (const char* c = str; (c != end) && (*c != 0); ++c){
+    out.reserve(out.size() + len*2 + 2);
+    out += '"';
+    out.append(str, c - str);
+    for (; (c != end) && (*c != 0); ++c){
       switch(*c){
       case '\"':
-	result += "\\\"";
+	out += "\\\"";
 	break;
       case '\\':
-	result += "\\\\";
+	out += "\\\\";
 	break;
       case '\b':
-	result += "\\b";
+	out += "\\b";
 	break;
       case '\f':
-	 result += "\\f";
+	 out += "\\f";
 	 break;
       case '\n':
-	result += "\\n";
+	out += "\\n";
 	break;
       case '\r':
-	result += "\\r";
+	out += "\\r";
 	break;
       case '\t':
-	result += "\\t";
+	out += "\\t";
 	break;
       case '/':
 	// Even though \/ is considered a legal escape in JSON, a bare
 	// slash is also legal, so I see no reason to escape it.
 	// (I hope I am not misunderstanding something.)
       default:{
-	if (*c < ' ') 
-	  result += "\\u00" + string() + hex_chars[*c >> 4] + string() + hex_chars[*c & 0xf];
-	else 
-	  result += *c;
+	if ((unsigned char)*c < ' ') {
+	  out += "\\u00";
+	  out += hex_chars[*c >> 4];
+	  out += hex_chars[*c & 0xf];
+	} else
+	  out += *c;
       } break;
       }
     }
-    result += "\"";
-    return result;
+    out += '"';
 }
 
 string arg2json(const AmArg &a) {
-  // TODO: optimize to avoid lots of mallocs
-  // TODO: how to get a bool? 
   string s;
+  arg2json(a, s);
+  return s;
+}
+
+void arg2json(const AmArg &a, string& out) {
+  // TODO: how to get a bool? 
+  char buf[32];
   switch (a.getType()) {
   case AmArg::Undef:
-    return "null";
+    out += "null";
+    return;
 
   case AmArg::Int:
-    return a.asInt()<0?"-"+int2str(abs(a.asInt())):int2str(abs(a.asInt()));
+    out.append(buf, snprintf(buf, sizeof(buf), "%d", a.asInt()));
+    return;
 
   case AmArg::LongLong:
-    return longlong2str(a.asLongLong());
+    out.append(buf, snprintf(buf, sizeof(buf), "%lld", a.asLongLong()));
+    return;
 
   case AmArg::Bool:
-    return a.asBool()?"true":"false";
+    out += a.asBool()?"true":"false";
+    return;
 
   case AmArg::Double:
     if (std::isnan(a.asDouble()) || std::isinf(a.asDouble()))
-      return "null";
-    return double2str(a.asDouble());
+      out += "null";
+    else
+      out += double2str(a.asDouble());
+    return;
 
   case AmArg::CStr:
-    return str2json(a.asCStr());
+    str2json(a.asCStr(), strlen(a.asCStr()), out);
+    return;
 
   case AmArg::Array:
-    s = "[";
-    for (size_t i = 0; i < a.size(); i ++)
-      s += arg2json(a[i]) + ", ";
-    if (1 < s.size()) 
-      s.resize(s.size() - 2); // strip last ", "
-    s += "]";
-    return s;
+    out += '[';
+    for (size_t i = 0; i < a.size(); i ++) {
+      if (i)
+	out += ", ";
+      arg2json(a[i], out);
+    }
+    out += ']';
+    return;
 
   case AmArg::Struct:
-    s = "{";
+    out += '{';
     for (AmArg::ValueStruct::const_iterator it = a.asStruct()->begin();
 	 it != a.asStruct()->end(); it ++) {
-      s += '"'+it->first + "\": ";
-      s += arg2json(it->second);
-      s += ", ";
+      if (it != a.asStruct()->begin())
+	out += ", ";
+      str2json(it->first.c_str(), it->first.length(), out);
+      out += ": ";
+      arg2json(it->second, out);
     }
-    if (1 < s.size())
-      s.resize(s.size() - 2); // strip last ", "
-    s += "}";
-    return s;
+    out += '}';
+    return;
   default: break;
   }
 
-  return "{}";
+  out += "{}";
 }
 
 // based on jsonxx
@@ -224,14 +252,28 @@ bool object_parse(std::istream& input, AmArg& res) {
   return true;
 }
 
+/** read-only stream buffer on memory owned by someone else */
+struct json_membuf
+  : public std::streambuf
+{
+  json_membuf(const char* input, size_t len) {
+    char* p = const_cast<char*>(input);
+    setg(p, p, p + len);
+  }
+};
+
+bool json2arg(const char* input, size_t len, AmArg& res) {
+  json_membuf buf(input, len);
+  std::istream is(&buf);
+  return json2arg(is, res);
+}
+
 bool json2arg(const std::string& input, AmArg& res) {
-  std::istringstream iss(input);
-  return json2arg(iss, res);
+  return json2arg(input.c_str(), input.length(), res);
 }
 
 bool json2arg(const char* input, AmArg& res) {
-  std::istringstream iss(input);
-  return json2arg(iss, res);
+  return json2arg(input, strlen(input), res);
 }
 
 bool json2arg(std::istream& input, AmArg& res) {
@@ -35,8 +35,17 @@ std::string str2json(const char* str);
 std::string str2json(const std::string& str);
 std::string str2json(const char* str, size_t len);
 
+/** append the JSON encoding of str to out */
+void str2json(const char* str, size_t len, std::string& out);
+
 string arg2json(const AmArg &a);
 
+/**
+ * append the JSON encoding of a to out - no intermediate
+ * strings, e.g. to encode straight into an output buffer
+ */
+void arg2json(const AmArg &a, std::string& out);
+
 /** @return true on success */
 bool json2arg(std::istream& input, AmArg& res);
 
@@ -45,4 +54,7 @@ bool json2arg(const char* input, AmArg& res);
 
 /** @return true on success */
 bool json2arg(const std::string& input, AmArg& res);
+
+/** parses input in place (need not be 0-terminated) @return true on success */
+bool json2arg(const char* input, size_t len, AmArg& res);
 #endif
@@ -324,6 +324,7 @@ bool parse_float(std::istream& input, double* value) {
     bool correct = true;
     int e_value;
     bool has_dot = false;
+    char sign_ch = 0;
 
     enum {
       p_number,
@@ -333,8 +334,9 @@ bool parse_float(std::istream& input, double* value) {
 
     if (match("-", input)) {
         sign = -1;
-    } else {
-        match("+", input);
+        sign_ch = '-';
+    } else if (match("+", input)) {
+        sign_ch = '+';
     }
 
     while(input && !input.eof()) {
@@ -413,6 +415,9 @@ bool parse_float(std::istream& input, double* value) {
       for (std::string::reverse_iterator r_it=
     	     value_str.rbegin(); r_it != value_str.rend(); r_it++)
     	input.putback(*r_it);
+      // leave the sign to parse_number
+      if (sign_ch)
+        input.putback(sign_ch);
       return false;
     }
     
@@ -35,6 +35,10 @@
 #include "log.h"
 #include "AmPlugIn.h"
 #include "AmApi.h"
+#include "AmPromptCache.h"
+#include "AmAudioProfiler.h"
+#include "AmSessionExecutor.h"
+#include "AmAudioFileWriter.h"
 
 #include "sip/trans_table.h"
 
@@ -309,6 +313,10 @@ int StatsUDPServer::execute(char* msg_buf, string& reply,
       "get_callsmax                       -  get maximum of active calls since the last query\n"
       "get_cpsavg                         -  get calls per second (5 sec average)\n"
       "get_cpsmax                         -  get maximum of CPS since the last query\n"
+      "get_promptcache                    -  get prompt cache statistics\n"
+      "get_audioprofile                   -  get codec/resampler/PLC CPU time (audio_profiling=yes)\n"
+      "get_executor                       -  get session executor thread statistics\n"
+      "get_audiofilewriter                -  get async audio file writer statistics\n"
       "\n"
       "get_rtp_mux_mtu_threshold          -  RTP MUX: get MTU queue threshold\n"
       "set_rtp_mux_mtu_threshold <thresh> -  RTP MUX: set MTU queue threshold\n"
@@ -421,6 +429,37 @@ int StatsUDPServer::execute(char* msg_buf, string& reply,
 	}
     }
 
+    else if(cmd_str.substr(4) == "promptcache") {
+      AmArg stats;
+      AmPromptCache::instance()->getStats(stats);
+      reply = "Prompt cache: " + AmArg::print(stats) + "\n";
+    }
+
+    else if(cmd_str.substr(4) == "audioprofile") {
+      // rates since the previous query of the stats server
+      static AmAudioProfileSnapshot last;
+      AmArg stats;
+      AmAudioProfiler::getStats(stats, &last);
+      reply = "Audio profile: " + AmArg::print(stats) + "\n";
+    }
+
+    else if(cmd_str.substr(4) == "audiofilewriter") {
+      reply = "active_writers=" + int2str(AmAudioFileWriter::getActiveWriters()) +
+	" bytes=" + ulonglong2str(AmAudioFileWriter::getTotalBytes()) +
+	" overruns=" + ulonglong2str(AmAudioFileWriter::getTotalOverruns()) + "\n";
+    }
+
+    else if(cmd_str.substr(4) == "executor") {
+#ifndef SESSION_THREADPOOL
+      if (AmSessionExecutor::isRunning()) {
+	AmArg stats;
+	AmSessionExecutor::instance()->getStats(stats);
+	reply = "Session executor: " + AmArg::print(stats) + "\n";
+      } else
+#endif
+	reply = "session executor not running.\n";
+    }
+
     else if(cmd_str.substr(4) == "rtp_mux_mtu_threshold")
       reply = "rtp_mux_mtu_threshold=" + int2str(AmConfig::RtpMuxMTUThreshold) +"\n";
     else if(cmd_str.substr(4) == "rtp_mux_max_frame_age_ms")
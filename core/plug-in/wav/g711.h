@@ -10,16 +10,23 @@
 ** implied warranty.
 */
 
+#ifndef _G711_H_
+#define _G711_H_
+
 #include <inttypes.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #define FAST_ALAW_CONVERSION
 #define FAST_ULAW_CONVERSION
 
 #ifdef FAST_ALAW_CONVERSION
 extern uint8_t _st_13linear2alaw[0x2000];
 extern int16_t _st_alaw2linear16[256];
-#define st_13linear2alaw(sw) (_st_13linear2alaw[(sw + 0x1000)])
-#define st_alaw2linear16(uc) (_st_alaw2linear16[uc])
+#define st_13linear2alaw(sw) (_st_13linear2alaw[(sw) + 0x1000])
+#define st_alaw2linear16(uc) (_st_alaw2linear16[(uc)])
 #else
 unsigned char st_13linear2alaw(int16_t pcm_val); /*  REGPARM(1); */
 int16_t st_alaw2linear16(unsigned char); /*  REGPARM(1); */
@@ -28,11 +35,32 @@ int16_t st_alaw2linear16(unsigned char); /*  REGPARM(1); */
 #ifdef FAST_ULAW_CONVERSION
 extern uint8_t _st_14linear2ulaw[0x4000];
 extern int16_t _st_ulaw2linear16[256];
-#define st_14linear2ulaw(sw) (_st_14linear2ulaw[(sw + 0x2000)])
-#define st_ulaw2linear16(uc) (_st_ulaw2linear16[uc])
+#define st_14linear2ulaw(sw) (_st_14linear2ulaw[(sw) + 0x2000])
+#define st_ulaw2linear16(uc) (_st_ulaw2linear16[(uc)])
 #else
 unsigned char st_14linear2ulaw(int16_t pcm_val); /*  REGPARM(1); */
 int16_t st_ulaw2linear16(unsigned char); /*  REGPARM(1); */
 #endif
 
+/*
+ * Bulk conversion of whole frames (g711_bulk.c). All kernels give the
+ * same results as the per-sample macros above; in-place encoding
+ * (out == in) is allowed.
+ */
+typedef struct {
+  const char* name;
+  void (*ulaw_encode)(uint8_t* out, const int16_t* in, unsigned int n);
+  void (*alaw_encode)(uint8_t* out, const int16_t* in, unsigned int n);
+  void (*ulaw_decode)(int16_t* out, const uint8_t* in, unsigned int n);
+  void (*alaw_decode)(int16_t* out, const uint8_t* in, unsigned int n);
+} g711_kernels_t;
+
+/* kernels by name ("scalar", "ssse3", "avx2"), NULL if not supported;
+ * name == NULL: the best ones for this CPU */
+const g711_kernels_t* g711_kernels(const char* name);
+
+#ifdef __cplusplus
+}
+#endif
 
+#endif /* _G711_H_ */
@@ -0,0 +1,411 @@
+/*
+ * g711_bulk.c
+ *
+ * Frame-wise u-law and A-law conversions.
+ *
+ * The scalar kernels run the lookup tables of g711.c over a frame.
+ * The SIMD kernels compute the same mapping arithmetically, in 16 bit
+ * lanes: the segment is the bit length of the magnitude, and the
+ * per-sample shifts are multiplications by a power of two; both are
+ * looked up with pshufb.
+ */
+
+#include "g711.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define G711_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+#define	BIAS		(0x84)		/* Bias for linear code. */
+#define CLIP            8159
+
+static void ulaw_encode_scalar(uint8_t* out, const int16_t* in, unsigned int n)
+{
+  unsigned int i;
+  for (i = 0; i < n; i++)
+    out[i] = st_14linear2ulaw(in[i] >> 2);
+}
+
+static void alaw_encode_scalar(uint8_t* out, const int16_t* in, unsigned int n)
+{
+  unsigned int i;
+  for (i = 0; i < n; i++)
+    out[i] = st_13linear2alaw(in[i] >> 3);
+}
+
+static void ulaw_decode_scalar(int16_t* out, const uint8_t* in, unsigned int n)
+{
+  unsigned int i;
+  for (i = 0; i < n; i++)
+    out[i] = st_ulaw2linear16(in[i]);
+}
+
+static void alaw_decode_scalar(int16_t* out, const uint8_t* in, unsigned int n)
+{
+  unsigned int i;
+  for (i = 0; i < n; i++)
+    out[i] = st_alaw2linear16(in[i]);
+}
+
+#ifdef G711_X86_KERNELS
+
+/*
+ * pshufb tables, indexed by segment (low byte of a 16 bit lane)
+ */
+
+/* u-law encode: high byte of 0x8000 >> seg, i.e. mulhi gives v >> (seg + 1) */
+#define ULAW_ENC_SHIFT 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01, \
+    0, 0, 0, 0, 0, 0, 0, 0
+/* A-law encode: high byte of 0x8000 >> (max(seg, 1) - 1) */
+#define ALAW_ENC_SHIFT 0x80, 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, \
+    0, 0, 0, 0, 0, 0, 0, 0
+/* u-law decode: 1 << seg */
+#define ULAW_DEC_SHIFT 1, 2, 4, 8, 16, 32, 64, (char)128, \
+    0, 0, 0, 0, 0, 0, 0, 0
+/* A-law decode: 1 << max(seg - 1, 0) */
+#define ALAW_DEC_SHIFT 1, 1, 2, 4, 8, 16, 32, 64, \
+    0, 0, 0, 0, 0, 0, 0, 0
+
+/* bit length of a nibble, and of a high nibble (4 + bit length) */
+#define BITLEN_LO 0, 1, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4
+#define BITLEN_HI 0, 5, 6, 6, 7, 7, 7, 7, 8, 8, 8, 8, 8, 8, 8, 8
+
+/* bit length of each lane (x < 256) */
+__attribute__((target("ssse3")))
+static inline __m128i bitlen_128(__m128i x)
+{
+  return _mm_max_epi16(_mm_shuffle_epi8(_mm_setr_epi8(BITLEN_HI), _mm_srli_epi16(x, 4)),
+		       _mm_shuffle_epi8(_mm_setr_epi8(BITLEN_LO),
+					_mm_and_si128(x, _mm_set1_epi16(0xF))));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i bitlen_256(__m256i x)
+{
+  return _mm256_max_epi16(_mm256_shuffle_epi8(_mm256_setr_epi8(BITLEN_HI, BITLEN_HI),
+					      _mm256_srli_epi16(x, 4)),
+			  _mm256_shuffle_epi8(_mm256_setr_epi8(BITLEN_LO, BITLEN_LO),
+					      _mm256_and_si256(x, _mm256_set1_epi16(0xF))));
+}
+
+/* pshufb index of the high byte of each lane; the low byte is zeroed */
+#define HI_BYTE_INDEX_128(seg) \
+  _mm_or_si128(_mm_slli_epi16(seg, 8), _mm_set1_epi16(0x0080))
+#define HI_BYTE_INDEX_256(seg) \
+  _mm256_or_si256(_mm256_slli_epi16(seg, 8), _mm256_set1_epi16(0x0080))
+/* pshufb index of the low byte of each lane; the high byte is zeroed */
+#define LO_BYTE_INDEX_128(seg) \
+  _mm_or_si128(seg, _mm_set1_epi16((short)0x8000))
+#define LO_BYTE_INDEX_256(seg) \
+  _mm256_or_si256(seg, _mm256_set1_epi16((short)0x8000))
+
+/* 16 bit linear -> u-law in the low byte of each lane */
+__attribute__((target("ssse3")))
+static inline __m128i ulaw_encode_128(__m128i x, __m128i ulaw_shift)
+{
+  __m128i s = _mm_srai_epi16(x, 2);
+  __m128i sign = _mm_srai_epi16(s, 15);
+  __m128i v = _mm_add_epi16(_mm_min_epi16(_mm_abs_epi16(s), _mm_set1_epi16(CLIP)),
+			    _mm_set1_epi16(BIAS >> 2));
+  /* segment: v <= 0x3F is 0, v <= 0x7F is 1, ... 8 is out of range */
+  __m128i seg = bitlen_128(_mm_srli_epi16(v, 6));
+
+  __m128i q = _mm_and_si128(_mm_mulhi_epu16(v, _mm_shuffle_epi8(ulaw_shift,
+								 HI_BYTE_INDEX_128(seg))),
+			    _mm_set1_epi16(0xF));
+  /* seg 8 (q == 0) is out of range: maximum value */
+  __m128i u = _mm_min_epi16(_mm_or_si128(_mm_slli_epi16(seg, 4), q),
+			    _mm_set1_epi16(0x7F));
+  return _mm_xor_si128(u, _mm_xor_si128(_mm_set1_epi16(0xFF),
+					_mm_and_si128(sign, _mm_set1_epi16(0x80))));
+}
+
+/* 16 bit linear -> A-law in the low byte of each lane */
+__attribute__((target("ssse3")))
+static inline __m128i alaw_encode_128(__m128i x, __m128i alaw_shift)
+{
+  __m128i s = _mm_srai_epi16(x, 3);
+  __m128i sign = _mm_srai_epi16(s, 15);
+  /* -s - 1 for negative values */
+  __m128i v = _mm_xor_si128(s, sign);
+  /* segment: v <= 0x1F is 0, v <= 0x3F is 1, ... */
+  __m128i seg = bitlen_128(_mm_srli_epi16(v, 5));
+
+  __m128i q = _mm_and_si128(_mm_mulhi_epu16(v, _mm_shuffle_epi8(alaw_shift,
+								 HI_BYTE_INDEX_128(seg))),
+			    _mm_set1_epi16(0xF));
+  __m128i a = _mm_or_si128(_mm_slli_epi16(seg, 4), q);
+  return _mm_xor_si128(a, _mm_or_si128(_mm_set1_epi16(0x55),
+				       _mm_andnot_si128(sign, _mm_set1_epi16(0x80))));
+}
+
+/* u-law in the low byte of each lane -> 16 bit linear */
+__attribute__((target("ssse3")))
+static inline __m128i ulaw_decode_128(__m128i x, __m128i ulaw_shift)
+{
+  __m128i u = _mm_xor_si128(x, _mm_set1_epi16(0xFF));
+  __m128i t = _mm_add_epi16(_mm_slli_epi16(_mm_and_si128(u, _mm_set1_epi16(0xF)), 3),
+			    _mm_set1_epi16(BIAS));
+  __m128i seg = _mm_srli_epi16(_mm_and_si128(u, _mm_set1_epi16(0x70)), 4);
+  t = _mm_mullo_epi16(t, _mm_shuffle_epi8(ulaw_shift, LO_BYTE_INDEX_128(seg)));
+  t = _mm_sub_epi16(t, _mm_set1_epi16(BIAS));
+
+  __m128i neg = _mm_cmpeq_epi16(_mm_and_si128(u, _mm_set1_epi16(0x80)),
+				_mm_set1_epi16(0x80));
+  return _mm_sub_epi16(_mm_xor_si128(t, neg), neg);
+}
+
+/* A-law in the low byte of each lane -> 16 bit linear */
+__attribute__((target("ssse3")))
+static inline __m128i alaw_decode_128(__m128i x, __m128i alaw_shift)
+{
+  __m128i a = _mm_xor_si128(x, _mm_set1_epi16(0x55));
+  __m128i t = _mm_slli_epi16(_mm_and_si128(a, _mm_set1_epi16(0xF)), 4);
+  __m128i seg = _mm_srli_epi16(_mm_and_si128(a, _mm_set1_epi16(0x70)), 4);
+  /* t + 8 in segment 0, (t + 0x108) << (seg - 1) above */
+  __m128i add = _mm_add_epi16(_mm_set1_epi16(8),
+			      _mm_andnot_si128(_mm_cmpeq_epi16(seg, _mm_setzero_si128()),
+					       _mm_set1_epi16(0x100)));
+  t = _mm_mullo_epi16(_mm_add_epi16(t, add),
+		      _mm_shuffle_epi8(alaw_shift, LO_BYTE_INDEX_128(seg)));
+
+  __m128i neg = _mm_cmpeq_epi16(_mm_and_si128(a, _mm_set1_epi16(0x80)),
+				_mm_setzero_si128());
+  return _mm_sub_epi16(_mm_xor_si128(t, neg), neg);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i ulaw_encode_256(__m256i x, __m256i ulaw_shift)
+{
+  __m256i s = _mm256_srai_epi16(x, 2);
+  __m256i sign = _mm256_srai_epi16(s, 15);
+  __m256i v = _mm256_add_epi16(_mm256_min_epi16(_mm256_abs_epi16(s), _mm256_set1_epi16(CLIP)),
+			       _mm256_set1_epi16(BIAS >> 2));
+  /* segment: v <= 0x3F is 0, v <= 0x7F is 1, ... 8 is out of range */
+  __m256i seg = bitlen_256(_mm256_srli_epi16(v, 6));
+
+  __m256i q = _mm256_and_si256(_mm256_mulhi_epu16(v, _mm256_shuffle_epi8(ulaw_shift,
+									  HI_BYTE_INDEX_256(seg))),
+			       _mm256_set1_epi16(0xF));
+  __m256i u = _mm256_min_epi16(_mm256_or_si256(_mm256_slli_epi16(seg, 4), q),
+			       _mm256_set1_epi16(0x7F));
+  return _mm256_xor_si256(u, _mm256_xor_si256(_mm256_set1_epi16(0xFF),
+					      _mm256_and_si256(sign, _mm256_set1_epi16(0x80))));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i alaw_encode_256(__m256i x, __m256i alaw_shift)
+{
+  __m256i s = _mm256_srai_epi16(x, 3);
+  __m256i sign = _mm256_srai_epi16(s, 15);
+  __m256i v = _mm256_xor_si256(s, sign);
+  /* segment: v <= 0x1F is 0, v <= 0x3F is 1, ... */
+  __m256i seg = bitlen_256(_mm256_srli_epi16(v, 5));
+
+  __m256i q = _mm256_and_si256(_mm256_mulhi_epu16(v, _mm256_shuffle_epi8(alaw_shift,
+									  HI_BYTE_INDEX_256(seg))),
+			       _mm256_set1_epi16(0xF));
+  __m256i a = _mm256_or_si256(_mm256_slli_epi16(seg, 4), q);
+  return _mm256_xor_si256(a, _mm256_or_si256(_mm256_set1_epi16(0x55),
+					     _mm256_andnot_si256(sign, _mm256_set1_epi16(0x80))));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i ulaw_decode_256(__m256i x, __m256i ulaw_shift)
+{
+  __m256i u = _mm256_xor_si256(x, _mm256_set1_epi16(0xFF));
+  __m256i t = _mm256_add_epi16(_mm256_slli_epi16(_mm256_and_si256(u, _mm256_set1_epi16(0xF)), 3),
+			       _mm256_set1_epi16(BIAS));
+  __m256i seg = _mm256_srli_epi16(_mm256_and_si256(u, _mm256_set1_epi16(0x70)), 4);
+  t = _mm256_mullo_epi16(t, _mm256_shuffle_epi8(ulaw_shift, LO_BYTE_INDEX_256(seg)));
+  t = _mm256_sub_epi16(t, _mm256_set1_epi16(BIAS));
+
+  __m256i neg = _mm256_cmpeq_epi16(_mm256_and_si256(u, _mm256_set1_epi16(0x80)),
+				   _mm256_set1_epi16(0x80));
+  return _mm256_sub_epi16(_mm256_xor_si256(t, neg), neg);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i alaw_decode_256(__m256i x, __m256i alaw_shift)
+{
+  __m256i a = _mm256_xor_si256(x, _mm256_set1_epi16(0x55));
+  __m256i t = _mm256_slli_epi16(_mm256_and_si256(a, _mm256_set1_epi16(0xF)), 4);
+  __m256i seg = _mm256_srli_epi16(_mm256_and_si256(a, _mm256_set1_epi16(0x70)), 4);
+  __m256i add = _mm256_add_epi16(_mm256_set1_epi16(8),
+				 _mm256_andnot_si256(_mm256_cmpeq_epi16(seg, _mm256_setzero_si256()),
+						     _mm256_set1_epi16(0x100)));
+  t = _mm256_mullo_epi16(_mm256_add_epi16(t, add),
+			 _mm256_shuffle_epi8(alaw_shift, LO_BYTE_INDEX_256(seg)));
+
+  __m256i neg = _mm256_cmpeq_epi16(_mm256_and_si256(a, _mm256_set1_epi16(0x80)),
+				   _mm256_setzero_si256());
+  return _mm256_sub_epi16(_mm256_xor_si256(t, neg), neg);
+}
+
+__attribute__((target("ssse3")))
+static void ulaw_encode_ssse3(uint8_t* out, const int16_t* in, unsigned int n)
+{
+  const __m128i ulaw_shift = _mm_setr_epi8(ULAW_ENC_SHIFT);
+  unsigned int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i x0 = _mm_loadu_si128((const __m128i*)(in + i));
+    __m128i x1 = _mm_loadu_si128((const __m128i*)(in + i + 8));
+    __m128i r0 = ulaw_encode_128(x0, ulaw_shift);
+    __m128i r1 = ulaw_encode_128(x1, ulaw_shift);
+    _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(r0, r1));
+  }
+  ulaw_encode_scalar(out + i, in + i, n - i);
+}
+
+__attribute__((target("ssse3")))
+static void alaw_encode_ssse3(uint8_t* out, const int16_t* in, unsigned int n)
+{
+  const __m128i alaw_shift = _mm_setr_epi8(ALAW_ENC_SHIFT);
+  unsigned int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i x0 = _mm_loadu_si128((const __m128i*)(in + i));
+    __m128i x1 = _mm_loadu_si128((const __m128i*)(in + i + 8));
+    __m128i r0 = alaw_encode_128(x0, alaw_shift);
+    __m128i r1 = alaw_encode_128(x1, alaw_shift);
+    _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(r0, r1));
+  }
+  alaw_encode_scalar(out + i, in + i, n - i);
+}
+
+__attribute__((target("ssse3")))
+static void ulaw_decode_ssse3(int16_t* out, const uint8_t* in, unsigned int n)
+{
+  const __m128i ulaw_shift = _mm_setr_epi8(ULAW_DEC_SHIFT);
+  unsigned int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i b = _mm_loadu_si128((const __m128i*)(in + i));
+    __m128i x0 = _mm_unpacklo_epi8(b, _mm_setzero_si128());
+    __m128i x1 = _mm_unpackhi_epi8(b, _mm_setzero_si128());
+    _mm_storeu_si128((__m128i*)(out + i), ulaw_decode_128(x0, ulaw_shift));
+    _mm_storeu_si128((__m128i*)(out + i + 8), ulaw_decode_128(x1, ulaw_shift));
+  }
+  ulaw_decode_scalar(out + i, in + i, n - i);
+}
+
+__attribute__((target("ssse3")))
+static void alaw_decode_ssse3(int16_t* out, const uint8_t* in, unsigned int n)
+{
+  const __m128i alaw_shift = _mm_setr_epi8(ALAW_DEC_SHIFT);
+  unsigned int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i b = _mm_loadu_si128((const __m128i*)(in + i));
+    __m128i x0 = _mm_unpacklo_epi8(b, _mm_setzero_si128());
+    __m128i x1 = _mm_unpackhi_epi8(b, _mm_setzero_si128());
+    _mm_storeu_si128((__m128i*)(out + i), alaw_decode_128(x0, alaw_shift));
+    _mm_storeu_si128((__m128i*)(out + i + 8), alaw_decode_128(x1, alaw_shift));
+  }
+  alaw_decode_scalar(out + i, in + i, n - i);
+}
+
+/* packs 32 lanes to bytes, in order (packus works per 128 bit lane) */
+#define PACK_256(r0, r1) \
+  _mm256_permute4x64_epi64(_mm256_packus_epi16(r0, r1), _MM_SHUFFLE(3,1,2,0))
+
+__attribute__((target("avx2")))
+static void ulaw_encode_avx2(uint8_t* out, const int16_t* in, unsigned int n)
+{
+  const __m256i ulaw_shift = _mm256_setr_epi8(ULAW_ENC_SHIFT, ULAW_ENC_SHIFT);
+  unsigned int i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i x0 = _mm256_loadu_si256((const __m256i*)(in + i));
+    __m256i x1 = _mm256_loadu_si256((const __m256i*)(in + i + 16));
+    __m256i r0 = ulaw_encode_256(x0, ulaw_shift);
+    __m256i r1 = ulaw_encode_256(x1, ulaw_shift);
+    _mm256_storeu_si256((__m256i*)(out + i), PACK_256(r0, r1));
+  }
+  ulaw_encode_ssse3(out + i, in + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void alaw_encode_avx2(uint8_t* out, const int16_t* in, unsigned int n)
+{
+  const __m256i alaw_shift = _mm256_setr_epi8(ALAW_ENC_SHIFT, ALAW_ENC_SHIFT);
+  unsigned int i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i x0 = _mm256_loadu_si256((const __m256i*)(in + i));
+    __m256i x1 = _mm256_loadu_si256((const __m256i*)(in + i + 16));
+    __m256i r0 = alaw_encode_256(x0, alaw_shift);
+    __m256i r1 = alaw_encode_256(x1, alaw_shift);
+    _mm256_storeu_si256((__m256i*)(out + i), PACK_256(r0, r1));
+  }
+  alaw_encode_ssse3(out + i, in + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void ulaw_decode_avx2(int16_t* out, const uint8_t* in, unsigned int n)
+{
+  const __m256i ulaw_shift = _mm256_setr_epi8(ULAW_DEC_SHIFT, ULAW_DEC_SHIFT);
+  unsigned int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i x = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(in + i)));
+    _mm256_storeu_si256((__m256i*)(out + i), ulaw_decode_256(x, ulaw_shift));
+  }
+  ulaw_decode_scalar(out + i, in + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void alaw_decode_avx2(int16_t* out, const uint8_t* in, unsigned int n)
+{
+  const __m256i alaw_shift = _mm256_setr_epi8(ALAW_DEC_SHIFT, ALAW_DEC_SHIFT);
+  unsigned int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i x = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(in + i)));
+    _mm256_storeu_si256((__m256i*)(out + i), alaw_decode_256(x, alaw_shift));
+  }
+  alaw_decode_scalar(out + i, in + i, n - i);
+}
+
+#endif /* G711_X86_KERNELS */
+
+static const g711_kernels_t kernels_scalar = {
+  "scalar", ulaw_encode_scalar, alaw_encode_scalar,
+  ulaw_decode_scalar, alaw_decode_scalar
+};
+
+#ifdef G711_X86_KERNELS
+static const g711_kernels_t kernels_ssse3 = {
+  "ssse3", ulaw_encode_ssse3, alaw_encode_ssse3,
+  ulaw_decode_ssse3, alaw_decode_ssse3
+};
+static const g711_kernels_t kernels_avx2 = {
+  "avx2", ulaw_encode_avx2, alaw_encode_avx2,
+  ulaw_decode_avx2, alaw_decode_avx2
+};
+#endif
+
+const g711_kernels_t* g711_kernels(const char* name)
+{
+  static const g711_kernels_t* best = NULL;
+
+  if (name == NULL) {
+    if (!best) {
+      const g711_kernels_t* k = g711_kernels("avx2");
+      if (!k) k = g711_kernels("ssse3");
+      if (!k) k = &kernels_scalar;
+      best = k;
+    }
+    return best;
+  }
+
+  if (!strcmp(name, "scalar"))
+    return &kernels_scalar;
+
+#ifdef G711_X86_KERNELS
+  __builtin_cpu_init();
+  if (!strcmp(name, "ssse3") && __builtin_cpu_supports("ssse3"))
+    return &kernels_ssse3;
+  if (!strcmp(name, "avx2") && __builtin_cpu_supports("avx2"))
+    return &kernels_avx2;
+#endif
+
+  return NULL;
+}
@@ -135,59 +135,28 @@ static unsigned int g711_samples2bytes(long h_codec, unsigned int num_samples)
 static int ULaw_2_Pcm16( unsigned char* out_buf, unsigned char* in_buf, unsigned int size,
 			 unsigned int channels, unsigned int rate, long h_codec )
 {
-  unsigned short* out_b = (unsigned short*)out_buf;
-  unsigned char*  in_b  = in_buf;
-  unsigned char*  end   = in_b + size;
-
-  while(in_b != end){
-    //	int i = st_ulaw2linear16(*(in_b++));
-    //	*(out_b++) = i;
-    *(out_b++) = st_ulaw2linear16(*(in_b++));
-  }
+  g711_kernels(NULL)->ulaw_decode((int16_t*)out_buf, in_buf, size);
   return size*2;
 }
 
 static int ALaw_2_Pcm16( unsigned char* out_buf, unsigned char* in_buf, unsigned int size,
 			 unsigned int channels, unsigned int rate, long h_codec )
 {
-  unsigned short* out_b = (unsigned short*)out_buf;
-  unsigned char*  in_b  = in_buf;
-  unsigned char*  end   = in_b + size;
-
-  while(in_b != end){
-    //	int i = st_alaw2linear16(*(in_b++));
-    //	*(out_b++) = i;
-    *(out_b++) = st_alaw2linear16(*(in_b++));
-  }
+  g711_kernels(NULL)->alaw_decode((int16_t*)out_buf, in_buf, size);
   return size*2;
 }
 
 int Pcm16_2_ULaw( unsigned char* out_buf, unsigned char* in_buf, unsigned int size,
 		  unsigned int channels, unsigned int rate, long h_codec )
 {
-  unsigned char* out_b = out_buf;
-  short* in_b          = (short*)(in_buf);
-  short* end           = (short*)((unsigned char*)in_buf + size);
-
-  while(in_b + 1 <= end){
-    short s = *(in_b++) >> 2;
-    *(out_b++) = st_14linear2ulaw(s);
-  }
+  g711_kernels(NULL)->ulaw_encode(out_buf, (int16_t*)in_buf, size/2);
   return size/2;
 }
 
 int Pcm16_2_ALaw( unsigned char* out_buf, unsigned char* in_buf, unsigned int size,
 		  unsigned int channels, unsigned int rate, long h_codec )
 {
-  unsigned char* out_b = out_buf;
-  short* in_b          = (short*)(in_buf);
-  short* end           = (short*)((unsigned char*)in_buf + size);
-
-  while(in_b + 1 <= end){
-    short s = (*(in_b++)) >> 3;
-    *(out_b++) = st_13linear2alaw(s);
-  }
-
+  g711_kernels(NULL)->alaw_encode(out_buf, (int16_t*)in_buf, size/2);
   return size/2;
 }
 
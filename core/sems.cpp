@@ -34,7 +34,9 @@
 #include "AmRtpReceiver.h"
 #include "AmEventDispatcher.h"
 #include "AmSessionProcessor.h"
+#include "AmSessionExecutor.h"
 #include "AmAppTimer.h"
+#include "AmPromptCache.h"
 
 #ifdef WITH_ZRTP
 # include "AmZRTP.h"
@@ -633,6 +635,11 @@ int main(int argc, char* argv[])
 #ifdef SESSION_THREADPOOL
   INFO("Starting session processor threads\n");
   AmSessionProcessor::addThreads(AmConfig::SessionProcessorThreads);
+#else
+  if (AmConfig::SessionExecutor == AmConfig::SessionExecWorkStealing) {
+    INFO("Starting session executor\n");
+    AmSessionExecutor::instance()->start(AmConfig::SessionExecutorThreads);
+  }
 #endif 
 
   INFO("Starting media processor\n");
@@ -691,6 +698,11 @@ int main(int argc, char* argv[])
   INFO("Disposing session container\n");
   AmSessionContainer::dispose();
 
+#ifndef SESSION_THREADPOOL
+  INFO("Disposing session executor\n");
+  AmSessionExecutor::dispose();
+#endif
+
   DBG("** Transaction table dump: **\n");
   dumps_transactions();
   DBG("*****************************\n");
@@ -701,6 +713,9 @@ int main(int argc, char* argv[])
   INFO("Disposing media processor\n");
   AmMediaProcessor::dispose();
 
+  INFO("Disposing prompt encoder\n");
+  AmPromptCache::dispose();
+
   INFO("Disposing event dispatcher\n");
   AmEventDispatcher::dispose();
 
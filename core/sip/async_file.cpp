@@ -73,6 +73,14 @@ int async_file::writev(const struct iovec *iov, int iovcnt)
   return ret;
 }
 
+void async_file::flush()
+{
+  AmLock _l(*this);
+  if(closed || error) return;
+  if(fifo_buffer::get_buffered_bytes())
+    event_active(ev_write, 0, 0);
+}
+
 void async_file::close()
 {
   AmLock _l(*this);
@@ -80,6 +88,18 @@ void async_file::close()
   event_active(ev_write, 0, 0);
 }
 
+bool async_file::clear_error()
+{
+  AmLock _l(*this);
+  if(!error) return false;
+
+  error = false;
+  if(fifo_buffer::get_buffered_bytes())
+    event_active(ev_write, 0, 0);
+
+  return true;
+}
+
 void async_file::write_cb(int sd, short what, void* ctx)
 {
   ((async_file*)ctx)->write_cycle();
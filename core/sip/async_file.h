@@ -1,4 +1,5 @@
 #ifndef _async_file_h_
+#define _async_file_h_
 
 #include "fifo_buffer.h"
 
@@ -58,11 +59,25 @@ public:
   int write(const void* buf, unsigned int len);
   int writev(const struct iovec *iov, int iovcnt);
 
+  /**
+   * Trigger writing the buffered data,
+   * even if below the write threshold.
+   */
+  void flush();
+
   /**
    * Mark the file as closed
    */
   void close();
 
+  /**
+   * Resume writing after a write error; the data not written
+   * is still in the buffer and is written first.
+   *
+   * return false if there was no error.
+   */
+  bool clear_error();
+
   unsigned int get_buffered_bytes();
 };
 
@@ -1,4 +1,5 @@
 #ifndef _async_file_writer_h_
+#define _async_file_writer_h_
 
 #include "AmThread.h"
 #include "singleton.h"
@@ -7,6 +7,7 @@
 #include <map>
 
 #include <string.h>
+#include <stdlib.h>
 
 #include "AmConfig.h"
 
@@ -25,14 +26,52 @@ FCT_BGN() {
   FCTMF_SUITE_CALL(test_sdp);
   FCTMF_SUITE_CALL(test_auth);
   FCTMF_SUITE_CALL(test_headers);
+  FCTMF_SUITE_CALL(test_headerfilter);
   FCTMF_SUITE_CALL(test_uriparser);
   FCTMF_SUITE_CALL(test_jsonarg);
   FCTMF_SUITE_CALL(test_replaces);
+  FCTMF_SUITE_CALL(test_call_counters);
   FCTMF_SUITE_CALL(test_parser);
   FCTMF_SUITE_CALL(test_rfc3261_parser);
   FCTMF_SUITE_CALL(test_rfc3261_musts);
   FCTMF_SUITE_CALL(test_extensions);
   FCTMF_SUITE_CALL(test_amconfig);
+  FCTMF_SUITE_CALL(test_session_executor);
+  FCTMF_SUITE_CALL(test_mixer);
+  FCTMF_SUITE_CALL(test_resampler);
+  FCTMF_SUITE_CALL(test_dtmf);
+  FCTMF_SUITE_CALL(test_g711);
+  FCTMF_SUITE_CALL(test_rtp_buffer);
+  FCTMF_SUITE_CALL(test_timer_wheel);
+  FCTMF_SUITE_CALL(test_dsm);
+  FCTMF_SUITE_CALL(test_msg_storage);
+  FCTMF_SUITE_CALL(test_db_reg_agent);
+  FCTMF_SUITE_CALL(test_conference);
+  FCTMF_SUITE_CALL(test_xmlrpc);
+  FCTMF_SUITE_CALL(test_registrar_client);
+  FCTMF_SUITE_CALL(test_prompt_cache);
+  FCTMF_SUITE_CALL(test_audio_file_writer);
+#ifdef WITH_HTTP_CLIENT
+  FCTMF_SUITE_CALL(test_http_client);
+#endif
+  FCTMF_SUITE_CALL(test_b2b_passthrough);
+
+  // benchmarks: large loads, no pass/fail on timings
+  if (getenv("SEMS_TEST_BENCH")) {
+    FCTMF_SUITE_CALL(bench_session_executor);
+    FCTMF_SUITE_CALL(bench_mixer);
+    FCTMF_SUITE_CALL(bench_resampler);
+    FCTMF_SUITE_CALL(bench_dtmf);
+    FCTMF_SUITE_CALL(bench_g711);
+    FCTMF_SUITE_CALL(bench_rtp_buffer);
+    FCTMF_SUITE_CALL(bench_dsm);
+    FCTMF_SUITE_CALL(bench_msg_storage);
+    FCTMF_SUITE_CALL(bench_db_reg_agent);
+    FCTMF_SUITE_CALL(bench_conference);
+    FCTMF_SUITE_CALL(bench_xmlrpc);
+    FCTMF_SUITE_CALL(bench_registrar_client);
+    FCTMF_SUITE_CALL(bench_headerfilter);
+  }
 }
 FCT_END();
 
@@ -0,0 +1,230 @@
+#include "fct.h"
+
+#include "log.h"
+
+#include "AmAudioFile.h"
+#include "AmAudioFileWriter.h"
+#include "AmPlugIn.h"
+#include "amci/codecs.h"
+#include "sip/async_file_writer.h"
+
+#include <event2/thread.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define AFW_RATE     8000
+#define AFW_FRAME    320     // 20 ms of 16 bit @ 8 kHz
+#define AFW_FRAMES   100
+#define AFW_HDR      4
+#define AFW_BUFFER   (256*1024)
+
+/* what the file format's on_close saw */
+static long afw_close_pos = -1;
+static int  afw_close_data_size = -1;
+
+/* 16 bit mono file with the data size as header */
+static int afw_open(FILE* fp, struct amci_file_desc_t* fmt_desc,
+		    int options, long h_codec)
+{
+  fmt_desc->subtype = 0;
+  fmt_desc->rate = AFW_RATE;
+  fmt_desc->channels = 1;
+  if (options == AmAudioFile::Write) {
+    unsigned int size = 0;
+    fwrite(&size, sizeof(size), 1, fp);
+  }
+  return 0;
+}
+
+static int afw_on_close(FILE* fp, struct amci_file_desc_t* fmt_desc,
+			int options, long h_codec, struct amci_codec_t* codec)
+{
+  if (options != AmAudioFile::Write)
+    return 0;
+
+  afw_close_pos = ftell(fp);
+  afw_close_data_size = fmt_desc->data_size;
+
+  unsigned int size = fmt_desc->data_size;
+  fseek(fp, 0, SEEK_SET);
+  fwrite(&size, sizeof(size), 1, fp);
+  return 0;
+}
+
+static amci_subtype_t afw_subtypes[] = {
+  { 0, "L16", AFW_RATE, 1, CODEC_PCM16 },
+  { -1, 0, -1, -1, -1 }
+};
+
+static amci_inoutfmt_t afw_file_fmt = {
+  (char*)"afw_test", (char*)"afwtest", (char*)"audio/x-test",
+  afw_open, afw_on_close, NULL, NULL, afw_subtypes
+};
+
+static void afw_init()
+{
+  if (!AmPlugIn::instance()->codec(CODEC_PCM16))
+    AmPlugIn::instance()->init();
+  if (!AmPlugIn::instance()->fileFormat("afw_test"))
+    AmPlugIn::instance()->addFileFormat(&afw_file_fmt);
+
+  static bool writer_started = false;
+  if (!writer_started) {
+    // as in sems.cpp: the writer's event base is used by other threads
+    evthread_use_pthreads();
+    async_file_writer::instance()->start();
+    writer_started = true;
+  }
+}
+
+/** wait until all writers have been released */
+static bool afw_wait_released(unsigned int active)
+{
+  for (int i = 0; i < 5000; i++) { // max 5s
+    if (AmAudioFileWriter::getActiveWriters() == active)
+      return true;
+    usleep(1000);
+  }
+  return false;
+}
+
+/** compares the file's data with frames filled with 1, 2, 3... */
+static bool afw_check_data(FILE* fp, long offset, unsigned int frames,
+			   unsigned int frame_len)
+{
+  unsigned char buf[AFW_FRAME * 4];
+  if (frame_len > sizeof(buf))
+    return false;
+
+  fseek(fp, offset, SEEK_SET);
+  for (unsigned int i = 0; i < frames; i++) {
+    if (fread(buf, 1, frame_len, fp) != frame_len)
+      return false;
+    for (unsigned int j = 0; j < frame_len; j++)
+      if (buf[j] != (unsigned char)(i + 1))
+	return false;
+  }
+  // nothing more
+  return fread(buf, 1, 1, fp) == 0;
+}
+
+FCTMF_SUITE_BGN(test_audio_file_writer) {
+
+  FCT_TEST_BGN(audio_file_writer_record) {
+    afw_init();
+    string name = "/tmp/sems_test_afw_record.afwtest";
+    unsigned int active = AmAudioFileWriter::getActiveWriters();
+    long long bytes = AmAudioFileWriter::getTotalBytes();
+    afw_close_pos = -1;
+    afw_close_data_size = -1;
+
+    AmAudioFile* f = new AmAudioFile();
+    f->setAsyncWrite(true);
+    fct_req(f->open(name, AmAudioFile::Write) == 0);
+    fct_chk_eq_int(AmAudioFileWriter::getActiveWriters(), active + 1);
+
+    unsigned char frame[AFW_FRAME];
+    for (unsigned int i = 0; i < AFW_FRAMES; i++) {
+      memset(frame, i + 1, sizeof(frame));
+      int res = f->put(i * 160, frame, AFW_RATE, sizeof(frame));
+      fct_chk_eq_int(res, AFW_FRAME);
+    }
+
+    // the writer thread writes the rest, updates the header
+    // and closes the file
+    delete f;
+    fct_req(afw_wait_released(active));
+
+    // header updated after all data was written
+    fct_chk_eq_int(afw_close_pos, AFW_HDR + AFW_FRAME * AFW_FRAMES);
+    fct_chk_eq_int(afw_close_data_size, AFW_FRAME * AFW_FRAMES);
+    fct_chk_eq_int(AmAudioFileWriter::getTotalBytes() - bytes,
+		   AFW_FRAME * AFW_FRAMES);
+
+    FILE* fp = fopen(name.c_str(), "r");
+    fct_req(fp != NULL);
+    unsigned int size = 0;
+    fct_chk(fread(&size, sizeof(size), 1, fp) == 1);
+    fct_chk_eq_int(size, AFW_FRAME * AFW_FRAMES);
+    fct_chk(afw_check_data(fp, AFW_HDR, AFW_FRAMES, AFW_FRAME));
+    fclose(fp);
+    unlink(name.c_str());
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(audio_file_writer_on_close_drains) {
+    afw_init();
+    string name = "/tmp/sems_test_afw_drain.afwtest";
+    unsigned int active = AmAudioFileWriter::getActiveWriters();
+    afw_close_pos = -1;
+
+    AmAudioFile f;
+    f.setAsyncWrite(true);
+    fct_req(f.open(name, AmAudioFile::Write) == 0);
+
+    unsigned char frame[AFW_FRAME];
+    for (unsigned int i = 0; i < AFW_FRAMES; i++) {
+      memset(frame, i + 1, sizeof(frame));
+      f.put(i * 160, frame, AFW_RATE, sizeof(frame));
+    }
+
+    // on_close() waits for the writer: the file is complete
+    // before the header is updated, and the file stays usable
+    f.on_close();
+    fct_chk_eq_int(afw_close_pos, AFW_HDR + AFW_FRAME * AFW_FRAMES);
+    fct_req(f.getfp() != NULL);
+    fflush(f.getfp());
+    fct_chk(afw_check_data(f.getfp(), AFW_HDR, AFW_FRAMES, AFW_FRAME));
+
+    f.close();
+    fct_chk(afw_wait_released(active));
+    unlink(name.c_str());
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(audio_file_writer_overrun) {
+    afw_init();
+    unsigned int active = AmAudioFileWriter::getActiveWriters();
+    long long total_overruns = AmAudioFileWriter::getTotalOverruns();
+
+    FILE* fp = tmpfile();
+    fct_req(fp != NULL);
+    AmAudioFileWriter* w = new AmAudioFileWriter(fp, AFW_BUFFER);
+    inc_ref(w);
+
+    // the disk does not keep up: hold back the writer thread
+    unsigned char frame[AFW_FRAME * 4];
+    unsigned int accepted = 0, dropped = 0;
+    w->lock();
+    for (unsigned int i = 0; dropped < 5; i++) {
+      memset(frame, accepted + 1, sizeof(frame));
+      int res = w->write(frame, sizeof(frame));
+      if (res == AmAudioFileWriter::BufferFull)
+	dropped++;
+      else if (res == (int)sizeof(frame))
+	accepted++;
+      else
+	break;
+    }
+    w->unlock();
+
+    fct_chk_eq_int(accepted, AFW_BUFFER / sizeof(frame));
+    fct_chk_eq_int(dropped, 5);
+    unsigned long long overruns = w->getOverruns();
+    fct_chk_eq_int(overruns, 5);
+    fct_chk_eq_int(AmAudioFileWriter::getTotalOverruns() - total_overruns, 5);
+
+    // drain() returns once the accepted frames are in the file
+    w->drain();
+    fct_chk(afw_check_data(fp, 0, accepted, sizeof(frame)));
+    dec_ref(w);
+
+    fct_chk(afw_wait_released(active));
+    fclose(fp);
+  }
+  FCT_TEST_END();
+
+}
+FCTMF_SUITE_END();
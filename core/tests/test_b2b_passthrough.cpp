@@ -0,0 +1,291 @@
+#include "fct.h"
+
+#include "log.h"
+
+#include "AmRtpAudio.h"
+#include "AmPlugIn.h"
+#include "AmSdp.h"
+#include "amci/amci.h"
+#include "amci/codecs.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <string.h>
+
+#define PT_RATE    8000
+#define PT_FRAME   160     // 20 ms @ 8 kHz
+#define PT_TICK    (WALLCLOCK_RATE / 50)
+#define PT_SSRC    0x1234abcd
+#define PT_L16     96
+
+static amci_payload_t pt_l16_8k = {
+  -1, "L16", 8000, 8000, 1, CODEC_PCM16, AMCI_PT_AUDIO_LINEAR
+};
+
+static amci_payload_t pt_l16_16k = {
+  -1, "L16", 16000, 16000, 1, CODEC_PCM16, AMCI_PT_AUDIO_LINEAR
+};
+
+static void pt_init_plugins()
+{
+  AmPlugIn* p = AmPlugIn::instance();
+  if (!p->codec(CODEC_PCM16))
+    p->init();
+  if (p->getDynPayload("L16", 8000, 0) < 0)
+    p->addPayload(&pt_l16_8k);
+  if (p->getDynPayload("L16", 16000, 0) < 0)
+    p->addPayload(&pt_l16_16k);
+}
+
+static int pt_bind(unsigned short port)
+{
+  int sd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (sd < 0)
+    return -1;
+
+  struct sockaddr_in sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sin_family = AF_INET;
+  sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  sa.sin_port = htons(port);
+  if (bind(sd, (struct sockaddr*)&sa, sizeof(sa))) {
+    close(sd);
+    return -1;
+  }
+  return sd;
+}
+
+/** an even local port with a free RTCP port above it */
+static unsigned short pt_free_port()
+{
+  for (int i=0; i<100; i++) {
+    int sd = pt_bind(0);
+    if (sd < 0)
+      return 0;
+
+    struct sockaddr_in sa;
+    socklen_t sa_len = sizeof(sa);
+    getsockname(sd, (struct sockaddr*)&sa, &sa_len);
+    unsigned short port = ntohs(sa.sin_port);
+    close(sd);
+
+    port &= ~1;
+    int rtp_sd = pt_bind(port);
+    int rtcp_sd = rtp_sd < 0 ? -1 : pt_bind(port + 1);
+    if (rtp_sd >= 0) close(rtp_sd);
+    if (rtcp_sd >= 0) {
+      close(rtcp_sd);
+      return port;
+    }
+  }
+  return 0;
+}
+
+static void pt_sdp(AmSdp& sdp, unsigned short port, int rate,
+		   const string& fmtp = "")
+{
+  sdp.conn.network = NT_IN;
+  sdp.conn.addrType = AT_V4;
+  sdp.conn.address = "127.0.0.1";
+
+  SdpMedia m;
+  m.type = MT_AUDIO;
+  m.port = port;
+  m.transport = TP_RTPAVP;
+  m.payloads.push_back(SdpPayload(PT_L16, "L16", rate, 0));
+  m.payloads.back().sdp_format_parameters = fmtp;
+  sdp.media.push_back(m);
+}
+
+/** (re-)negotiates stream for L16 at rate, sending to remote_port */
+static int pt_negotiate(AmRtpAudio& stream, unsigned short local_port,
+			unsigned short remote_port, int rate,
+			const string& fmtp = "")
+{
+  AmSdp local, remote;
+  pt_sdp(local, local_port, rate, fmtp);
+  pt_sdp(remote, remote_port, rate, fmtp);
+  stream.forceSdpMediaIndex(0);
+  if (stream.init(local, remote))
+    return -1;
+
+  // init() asks for the receive buffer to be cleared: have that done
+  // before packets are handed to the stream
+  return stream.receive(0) < 0 ? -1 : 0;
+}
+
+/** hand an L16 packet of samples with the given value to the stream */
+static void pt_receive(AmRtpAudio& stream, unsigned short seq, unsigned int ts,
+		       unsigned char value, unsigned int samples = PT_FRAME)
+{
+  unsigned char pkt[12 + PT_FRAME * 4];
+  pkt[0] = 0x80;
+  pkt[1] = PT_L16;
+  pkt[2] = seq >> 8;
+  pkt[3] = seq & 0xff;
+  pkt[4] = ts >> 24;
+  pkt[5] = (ts >> 16) & 0xff;
+  pkt[6] = (ts >> 8) & 0xff;
+  pkt[7] = ts & 0xff;
+  pkt[8] = (PT_SSRC >> 24) & 0xff;
+  pkt[9] = (PT_SSRC >> 16) & 0xff;
+  pkt[10] = (PT_SSRC >> 8) & 0xff;
+  pkt[11] = PT_SSRC & 0xff;
+  memset(pkt + 12, value, samples * 2);
+
+  stream.recvPacket(-1, pkt, 12 + samples * 2);
+}
+
+/** the stream conditions of AudioStreamData::canPassthrough */
+static bool pt_can_passthrough(AmRtpAudio& src, AmRtpAudio& dst)
+{
+  return src.getPacketSamples() == dst.getFrameSize() &&
+    src.sameEncoding(dst.getRtpFormat());
+}
+
+FCTMF_SUITE_BGN(test_b2b_passthrough) {
+
+  FCT_TEST_BGN(passthrough_queue_depth) {
+    pt_init_plugins();
+    unsigned short a_port = pt_free_port();
+    unsigned short b_port = pt_free_port();
+    fct_req(a_port && b_port);
+
+    AmRtpAudio a(NULL, 0);
+    fct_req(pt_negotiate(a, a_port, b_port, PT_RATE) == 0);
+    a.setPassthrough(true, 0);
+
+    // the receiving side falls behind: only the newest frames are kept
+    unsigned int n = PASSTHROUGH_QUEUE_FRAMES + 3;
+    for (unsigned int i=0; i<n; i++)
+      pt_receive(a, i + 1, i * PT_FRAME, i + 1);
+
+    unsigned char buf[AUDIO_BUFFER_SIZE];
+    unsigned int frames = 0, first = 0, last = 0;
+    int got;
+    while ((got = a.getEncoded(PT_TICK, buf, a.getRtpFormat())) > 0) {
+      fct_chk_eq_int(got, PT_FRAME * 2);
+      if (!frames) first = buf[0];
+      last = buf[got - 1];
+      frames++;
+    }
+    fct_chk_eq_int(frames, PASSTHROUGH_QUEUE_FRAMES);
+    fct_chk_eq_int(first, n - PASSTHROUGH_QUEUE_FRAMES + 1);
+    fct_chk_eq_int(last, n);
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(passthrough_same_encoding) {
+    pt_init_plugins();
+    unsigned short a_port = pt_free_port();
+    unsigned short b_port = pt_free_port();
+    unsigned short c_port = pt_free_port();
+    unsigned short d_port = pt_free_port();
+    fct_req(a_port && b_port && c_port && d_port);
+
+    AmRtpAudio a(NULL, 0), b(NULL, 0), c(NULL, 0), d(NULL, 0);
+    fct_req(pt_negotiate(a, a_port, b_port, PT_RATE) == 0);
+    fct_req(pt_negotiate(b, b_port, a_port, PT_RATE) == 0);
+    fct_req(pt_negotiate(c, c_port, a_port, 16000) == 0);
+    fct_req(pt_negotiate(d, d_port, a_port, PT_RATE, "mode=x") == 0);
+
+    fct_chk(a.sameEncoding(b.getRtpFormat()));
+    fct_chk(!a.sameEncoding(c.getRtpFormat()));
+    fct_chk(!a.sameEncoding(d.getRtpFormat()));
+    fct_chk(!a.sameEncoding(NULL));
+
+    // nothing received yet: packet length unknown
+    fct_chk(!pt_can_passthrough(a, b));
+
+    unsigned char buf[AUDIO_BUFFER_SIZE];
+    unsigned long long ts = PT_TICK;
+    pt_receive(a, 1, 0, 1);
+    fct_chk(a.get(ts, buf, PT_RATE, PT_FRAME) > 0);
+    unsigned int samples = a.getPacketSamples();
+    fct_chk_eq_int(samples, PT_FRAME);
+    fct_chk(pt_can_passthrough(a, b));
+    fct_chk(!pt_can_passthrough(a, c));
+
+    // 30 ms packets do not fit b's 20 ms frames
+    ts += PT_TICK;
+    pt_receive(a, 2, PT_FRAME, 2, PT_FRAME * 3 / 2);
+    fct_chk(a.get(ts, buf, PT_RATE, PT_FRAME) > 0);
+    samples = a.getPacketSamples();
+    fct_chk_eq_int(samples, PT_FRAME * 3 / 2);
+    fct_chk(!pt_can_passthrough(a, b));
+
+    // back to 20 ms, then the ptime changes while in passthrough
+    ts += PT_TICK;
+    pt_receive(a, 3, PT_FRAME * 5 / 2, 3);
+    fct_chk(a.get(ts, buf, PT_RATE, PT_FRAME) > 0);
+    fct_req(pt_can_passthrough(a, b));
+    a.setPassthrough(true, ts);
+
+    pt_receive(a, 4, PT_FRAME * 7 / 2, 4);
+    ts += PT_TICK;
+    fct_chk(a.getEncoded(ts, buf, b.getRtpFormat()) > 0);
+    fct_chk(pt_can_passthrough(a, b));
+
+    pt_receive(a, 5, PT_FRAME * 7 / 2 + PT_FRAME * 3 / 2, 5);
+    ts += PT_TICK;
+    fct_chk(a.getEncoded(ts, buf, b.getRtpFormat()) > 0);
+    samples = a.getPacketSamples();
+    fct_chk_eq_int(samples, 0);
+    fct_chk(!pt_can_passthrough(a, b));
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(passthrough_renegotiation_fallback) {
+    pt_init_plugins();
+    unsigned short a_port = pt_free_port();
+    unsigned short b_port = pt_free_port();
+    fct_req(a_port && b_port);
+
+    AmRtpAudio a(NULL, 0), b(NULL, 0);
+    fct_req(pt_negotiate(a, a_port, b_port, PT_RATE) == 0);
+    fct_req(pt_negotiate(b, b_port, a_port, PT_RATE) == 0);
+
+    unsigned char buf[AUDIO_BUFFER_SIZE];
+    unsigned long long ts = PT_TICK;
+    pt_receive(a, 1, 0, 1);
+    fct_chk(a.get(ts, buf, PT_RATE, PT_FRAME) > 0);
+    fct_req(pt_can_passthrough(a, b));
+    a.setPassthrough(true, ts);
+
+    // forwarded as received
+    pt_receive(a, 2, PT_FRAME, 2);
+    pt_receive(a, 3, PT_FRAME * 2, 3);
+    ts += PT_TICK;
+    int got = a.getEncoded(ts, buf, b.getRtpFormat());
+    fct_chk_eq_int(got, PT_FRAME * 2);
+    fct_chk_eq_int(buf[0], 2);
+
+    // b renegotiates to 16 kHz: a falls back to transcoding,
+    // and the frame still queued is decoded instead of lost
+    fct_req(pt_negotiate(b, b_port, a_port, 16000) == 0);
+    fct_chk(!pt_can_passthrough(a, b));
+    ts += PT_TICK;
+    a.setPassthrough(false, ts);
+    fct_chk(!a.getPassthrough());
+    got = a.getEncoded(ts, buf, b.getRtpFormat());
+    fct_chk_eq_int(got, 0);
+
+    // (the default PLC delays the decoded audio by a few samples)
+    memset(buf, 0, sizeof(buf));
+    got = a.get(ts, buf, PT_RATE, PT_FRAME);
+    fct_chk_eq_int(got, PT_FRAME * 2);
+    fct_chk_eq_int(buf[got - 1], 3);
+
+    // and further frames are decoded, too
+    pt_receive(a, 4, PT_FRAME * 3, 4);
+    ts += PT_TICK;
+    got = a.get(ts, buf, PT_RATE, PT_FRAME);
+    fct_chk_eq_int(got, PT_FRAME * 2);
+    fct_chk_eq_int(buf[got - 1], 4);
+  }
+  FCT_TEST_END();
+
+}
+FCTMF_SUITE_END();
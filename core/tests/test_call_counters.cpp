@@ -0,0 +1,163 @@
+#include "fct.h"
+
+#include "log.h"
+
+#include "AmThread.h"
+#include "AmUtils.h"
+
+#include "../../apps/sbc/CallCounterTable.h"
+
+#include <vector>
+using std::vector;
+
+#define CC_TEST_THREADS 8
+#define CC_TEST_KEYS    64
+#define CC_TEST_ROUNDS  2048
+
+/** increments and decrements keys of the table */
+class CallCounterTestThread : public AmThread
+{
+  CallCounterTable* table;
+  int limit;
+
+protected:
+  void run() {
+    int current;
+    for (int i=0; i<CC_TEST_ROUNDS; i++) {
+      string key = "key" + int2str(i % CC_TEST_KEYS);
+      if (table->inc_below(key, limit, current))
+	incremented++;
+      // the shared key is only counted up to its limit
+      if (table->inc_below("shared", 10, current))
+	shared++;
+    }
+    // half of them released again
+    for (int i=0; i<CC_TEST_ROUNDS / 2; i++)
+      table->dec("key" + int2str(i % CC_TEST_KEYS));
+  }
+  void on_stop() { }
+
+public:
+  int incremented;
+  int shared;
+
+  CallCounterTestThread(CallCounterTable* table, int limit)
+    : table(table), limit(limit), incremented(0), shared(0) { }
+};
+
+FCTMF_SUITE_BGN(test_call_counters) {
+
+  FCT_TEST_BGN(call_counter_inc_below) {
+    CallCounterTable t;
+    int current = -1;
+    int value = -1;
+
+    fct_chk(t.inc_below("uuid1", 2, current));
+    fct_chk_eq_int(current, 1);
+    fct_chk(t.inc_below("uuid1", 2, current));
+    fct_chk_eq_int(current, 2);
+    // at the limit: not incremented
+    fct_chk(!t.inc_below("uuid1", 2, current));
+    fct_chk_eq_int(current, 2);
+    fct_chk(t.get("uuid1", value));
+    fct_chk_eq_int(value, 2);
+
+    // no limit: not created
+    fct_chk(!t.inc_below("uuid2", 0, current));
+    fct_chk_eq_int(current, 0);
+    fct_chk(!t.get("uuid2", value));
+
+    // a lower limit than the count
+    fct_chk(!t.inc_below("uuid1", 1, current));
+    fct_chk_eq_int(current, 2);
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(call_counter_dec) {
+    CallCounterTable t;
+    int current = 0;
+    int value = 0;
+
+    t.inc_below("uuid", 5, current);
+    t.inc_below("uuid", 5, current);
+    value = t.dec("uuid");
+    fct_chk_eq_int(value, 1);
+    fct_chk(t.get("uuid", value));
+    // removed at zero
+    value = t.dec("uuid");
+    fct_chk_eq_int(value, 0);
+    fct_chk(!t.get("uuid", value));
+    // unknown: nothing to decrement
+    value = t.dec("uuid");
+    fct_chk_eq_int(value, 0);
+    fct_chk(!t.get("uuid", value));
+
+    // starts again from 0
+    fct_chk(t.inc_below("uuid", 1, current));
+    fct_chk_eq_int(current, 1);
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(call_counter_add_set_list) {
+    CallCounterTable t;
+    bool found = true;
+    int value = 0;
+
+    value = t.add("pin", 5, found);
+    fct_chk_eq_int(value, 5);
+    fct_chk(!found);
+    value = t.add("pin", -2, found);
+    fct_chk_eq_int(value, 3);
+    fct_chk(found);
+    value = t.set("other", 7);
+    fct_chk_eq_int(value, 7);
+    fct_chk(t.get("other", value));
+    fct_chk_eq_int(value, 7);
+
+    AmArg l;
+    t.list(l);
+    fct_chk(isArgStruct(l));
+    fct_chk_eq_int(l.size(), 2);
+    fct_chk(l.hasMember("pin") && l["pin"].asInt() == 3);
+    fct_chk(l.hasMember("other") && l["other"].asInt() == 7);
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(call_counter_concurrent_buckets) {
+    CallCounterTable t;
+    // per key and thread CC_TEST_ROUNDS / CC_TEST_KEYS increments
+    int limit = CC_TEST_THREADS * CC_TEST_ROUNDS / CC_TEST_KEYS;
+
+    vector<CallCounterTestThread*> threads;
+    for (int i=0; i<CC_TEST_THREADS; i++)
+      threads.push_back(new CallCounterTestThread(&t, limit));
+    for (int i=0; i<CC_TEST_THREADS; i++)
+      threads[i]->start();
+
+    int incremented = 0;
+    int shared = 0;
+    for (int i=0; i<CC_TEST_THREADS; i++) {
+      threads[i]->join();
+      incremented += threads[i]->incremented;
+      shared += threads[i]->shared;
+      delete threads[i];
+    }
+
+    // no increment lost, the limits held
+    fct_chk_eq_int(incremented, CC_TEST_THREADS * CC_TEST_ROUNDS);
+    fct_chk_eq_int(shared, 10);
+
+    int value = 0;
+    bool counts_ok = true;
+    for (int k=0; k<CC_TEST_KEYS; k++) {
+      if (!t.get("key" + int2str(k), value) || value != limit / 2)
+	counts_ok = false;
+    }
+    fct_chk(counts_ok);
+    fct_chk(t.get("shared", value));
+    fct_chk_eq_int(value, 10);
+  }
+  FCT_TEST_END();
+
+}
+FCTMF_SUITE_END();
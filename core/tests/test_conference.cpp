@@ -0,0 +1,297 @@
+#include "fct.h"
+
+#include "log.h"
+
+#include "AmConferenceStatus.h"
+#include "AmConferenceChannel.h"
+#include "AmEventDispatcher.h"
+#include "AmThread.h"
+#include "AmUtils.h"
+
+#include <sys/time.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// SEMS_TEST_CONF_MEMBERS=1000 for the full size benchmark
+#define CONF_BENCH_MEMBERS 200
+#define CONF_BENCH_STORMERS 4
+#define CONF_BENCH_CYCLES  100
+
+/** a session as far as conference events are concerned */
+struct ConfTestReceiver
+  : public AmEventHandler,
+    public AmEventQueue
+{
+  string tag;
+
+  AmMutex mut;
+  vector<ConferenceEvent> events;
+  /** queue entries, i.e. wakeups of the session */
+  unsigned int posted;
+
+  ConfTestReceiver(const string& tag)
+    : AmEventQueue(this), tag(tag), posted(0)
+  {
+    AmEventDispatcher::instance()->addEventQueue(tag, this);
+  }
+
+  ~ConfTestReceiver() {
+    AmEventDispatcher::instance()->delEventQueue(tag);
+  }
+
+  void postEvent(AmEvent* ev) {
+    __sync_fetch_and_add(&posted, 1);
+    AmEventQueue::postEvent(ev);
+  }
+
+  void process(AmEvent* ev) {
+    ConferenceEvent* ce = dynamic_cast<ConferenceEvent*>(ev);
+    if (!ce)
+      return;
+    mut.lock();
+    events.push_back(*ce);
+    mut.unlock();
+  }
+
+  size_t count() {
+    mut.lock();
+    size_t res = events.size();
+    mut.unlock();
+    return res;
+  }
+
+  bool got(size_t i, int event_id, unsigned int participants, const string& sess_id) {
+    mut.lock();
+    bool res = i < events.size() && events[i].event_id == event_id &&
+      events[i].participants == participants && events[i].sess_id == sess_id;
+    mut.unlock();
+    return res;
+  }
+};
+
+/** processes the events of some receivers, as session threads do */
+class ConfTestSessionThread
+  : public AmThread
+{
+  vector<ConfTestReceiver*> receivers;
+  volatile bool running;
+
+public:
+  ConfTestSessionThread() : running(true) { }
+
+  void add(ConfTestReceiver* r) { receivers.push_back(r); }
+
+  void run() {
+    while (running) {
+      bool idle = true;
+      for (size_t i=0; i<receivers.size(); i++) {
+	if (receivers[i]->eventPending()) {
+	  receivers[i]->processEvents();
+	  idle = false;
+	}
+      }
+      if (idle)
+	usleep(200);
+    }
+  }
+  void on_stop() { running = false; }
+};
+
+/** joins and leaves the conference again and again */
+class ConfTestStormer
+  : public AmThread
+{
+  string cid;
+  ConfTestReceiver* receiver;
+  unsigned int cycles;
+
+public:
+  ConfTestStormer(const string& cid, ConfTestReceiver* receiver, unsigned int cycles)
+    : cid(cid), receiver(receiver), cycles(cycles) { }
+
+  void run() {
+    for (unsigned int i=0; i<cycles; i++)
+      delete AmConferenceStatus::getChannel(cid, receiver->tag, 8000);
+  }
+  void on_stop() { }
+};
+
+static double conf_elapsed_us(const struct timeval& start) {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return (now.tv_sec - start.tv_sec) * 1e6 + (now.tv_usec - start.tv_usec);
+}
+
+FCTMF_SUITE_BGN(test_conference) {
+
+  FCT_TEST_BGN(conference_events_in_order) {
+    ConfTestReceiver a("conftest-a"), b("conftest-b"), c("conftest-c");
+    string cid = "conftest-conf";
+
+    AmConferenceChannel* ch_a = AmConferenceStatus::getChannel(cid, a.tag, 8000);
+    a.processEvents();
+    fct_chk(a.got(0, ConfNewParticipant, 1, a.tag));
+
+    // a does not process events meanwhile: one wakeup for both
+    AmConferenceChannel* ch_b = AmConferenceStatus::getChannel(cid, b.tag, 8000);
+    AmConferenceChannel* ch_c = AmConferenceStatus::getChannel(cid, c.tag, 8000);
+    fct_chk_eq_int(AmConferenceStatus::getConferenceSize(cid), 3);
+    fct_chk_eq_int(a.posted, 2);
+    a.processSingleEvent();
+    fct_chk(!a.eventPending());
+    fct_chk_eq_int(a.count(), 3);
+    fct_chk(a.got(1, ConfNewParticipant, 2, b.tag));
+    fct_chk(a.got(2, ConfNewParticipant, 3, c.tag));
+    b.processEvents();
+    fct_chk_eq_int(b.count(), 1);
+    fct_chk(b.got(0, ConfNewParticipant, 3, c.tag));
+
+    // same session again: no new participant
+    AmConferenceChannel* ch_b2 = AmConferenceStatus::getChannel(cid, b.tag, 8000);
+    delete ch_b2;
+    fct_chk_eq_int(AmConferenceStatus::getConferenceSize(cid), 3);
+
+    delete ch_b;
+    AmConferenceStatus::postConferenceEvent(cid, 42, "x");
+    a.processEvents();
+    b.processEvents();
+    c.processEvents();
+    fct_chk_eq_int(a.count(), 5);
+    fct_chk(a.got(3, ConfParticipantLeft, 2, b.tag));
+    fct_chk(a.got(4, 42, 2, "x"));
+    fct_chk_eq_int(b.count(), 1);
+    fct_chk_eq_int(c.count(), 2);
+    fct_chk(c.got(1, 42, 2, "x"));
+
+    delete ch_a;
+    delete ch_c;
+    fct_chk_eq_int(AmConferenceStatus::getConferenceSize(cid), 0);
+    c.processEvents();
+    fct_chk(c.got(2, ConfParticipantLeft, 1, a.tag));
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(event_mailbox_receiver_gone) {
+    AmEventMailbox* mb = new AmEventMailbox("conftest-nobody");
+    inc_ref(mb);
+    fct_chk(!mb->post(new AmEvent(1)));
+    // not stuck: the next one is posted again
+    AmEventBatch* batch = mb->add(new AmEvent(2));
+    fct_chk(batch != NULL);
+    fct_chk(mb->add(new AmEvent(3)) == NULL);
+    fct_chk(!mb->post(batch));
+    dec_ref(mb);
+
+    // receiver gone with the batch still queued
+    ConfTestReceiver* r = new ConfTestReceiver("conftest-gone");
+    AmConferenceChannel* ch = AmConferenceStatus::getChannel("conftest-gone", r->tag, 8000);
+    delete r;
+    delete ch;
+  }
+  FCT_TEST_END();
+
+}
+FCTMF_SUITE_END();
+
+/* opt-in: SEMS_TEST_BENCH=1 */
+FCTMF_SUITE_BGN(bench_conference) {
+
+  FCT_TEST_BGN(conference_join_leave_storm) {
+    int saved_log_level = log_level;
+    log_level = L_INFO;
+
+    unsigned int n_members = CONF_BENCH_MEMBERS;
+    if (getenv("SEMS_TEST_CONF_MEMBERS"))
+      n_members = atoi(getenv("SEMS_TEST_CONF_MEMBERS"));
+
+    string cid = "conftest-storm";
+    vector<ConfTestReceiver*> members;
+    ConfTestSessionThread threads[4];
+    for (unsigned int i=0; i<n_members; i++) {
+      members.push_back(new ConfTestReceiver("conftest-m" + int2str(i)));
+      threads[i % 4].add(members.back());
+    }
+    vector<ConfTestReceiver*> stormers;
+    for (unsigned int i=0; i<CONF_BENCH_STORMERS; i++) {
+      stormers.push_back(new ConfTestReceiver("conftest-s" + int2str(i)));
+      threads[i % 4].add(stormers.back());
+    }
+    for (unsigned int i=0; i<4; i++)
+      threads[i].start();
+
+    struct timeval start;
+    gettimeofday(&start, NULL);
+    vector<AmConferenceChannel*> channels;
+    for (unsigned int i=0; i<n_members; i++)
+      channels.push_back(AmConferenceStatus::getChannel(cid, members[i]->tag, 8000));
+    double join_us = conf_elapsed_us(start) / n_members;
+
+    gettimeofday(&start, NULL);
+    ConfTestStormer* storm[CONF_BENCH_STORMERS];
+    for (unsigned int i=0; i<CONF_BENCH_STORMERS; i++) {
+      storm[i] = new ConfTestStormer(cid, stormers[i], CONF_BENCH_CYCLES);
+      storm[i]->start();
+    }
+    for (unsigned int i=0; i<CONF_BENCH_STORMERS; i++) {
+      storm[i]->join();
+      delete storm[i];
+    }
+    double storm_us = conf_elapsed_us(start);
+
+    // every member: the joins after it, its own if first, and the storm
+    size_t expected = 0;
+    for (unsigned int i=0; i<n_members; i++)
+      expected += (i ? n_members - 1 - i : n_members) +
+	2 * CONF_BENCH_STORMERS * CONF_BENCH_CYCLES;
+    size_t delivered = 0;
+    for (unsigned int wait=0; wait<2000; wait++) {
+      delivered = 0;
+      for (unsigned int i=0; i<n_members; i++)
+	delivered += members[i]->count();
+      if (delivered >= expected)
+	break;
+      usleep(10000);
+    }
+    double drain_us = conf_elapsed_us(start);
+
+    unsigned int wakeups = 0;
+    bool ordered = true;
+    for (unsigned int i=0; i<n_members; i++) {
+      wakeups += members[i]->posted;
+      // the joins up to the full conference come in order
+      ConfTestReceiver* m = members[i];
+      m->mut.lock();
+      for (size_t e=1; e<m->events.size() && e < (i ? n_members - 1 - i : n_members); e++)
+	ordered = ordered && m->events[e].participants == m->events[e-1].participants + 1;
+      if (!m->events.empty())
+	ordered = ordered && m->events.back().participants == n_members;
+      m->mut.unlock();
+    }
+    fct_chk(delivered == expected);
+    fct_chk(ordered);
+    fct_chk(AmConferenceStatus::getConferenceSize(cid) == n_members);
+
+    INFO("conference with %u members: join %.1f us, %u x %u join/leave "
+	 "in %.0f ms (%.0f /s), %zd events delivered in %.0f ms, %.1f events/wakeup\n",
+	 n_members, join_us, CONF_BENCH_STORMERS, CONF_BENCH_CYCLES,
+	 storm_us / 1000, 2 * CONF_BENCH_STORMERS * CONF_BENCH_CYCLES * 1e6 / storm_us,
+	 delivered, drain_us / 1000, wakeups ? (double)delivered / wakeups : 0.0);
+
+    for (unsigned int i=0; i<n_members; i++)
+      delete channels[i];
+    fct_chk(AmConferenceStatus::getConferenceSize(cid) == 0);
+
+    for (unsigned int i=0; i<4; i++) {
+      threads[i].stop();
+      threads[i].join();
+    }
+    for (unsigned int i=0; i<n_members; i++)
+      delete members[i];
+    for (unsigned int i=0; i<CONF_BENCH_STORMERS; i++)
+      delete stormers[i];
+
+    log_level = saved_log_level;
+  }
+  FCT_TEST_END();
+}
+FCTMF_SUITE_END();
@@ -0,0 +1,525 @@
+#include "fct.h"
+
+#include "log.h"
+
+#include "AmThread.h"
+
+#include "../../apps/db_reg_agent/RegistrationTimer.h"
+#include "../../apps/db_reg_agent/RegRateLimiter.h"
+#include "../../apps/db_reg_agent/RegRefresh.h"
+#include "../../apps/db_reg_agent/RegStatusQueue.h"
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+using std::vector;
+
+// SEMS_TEST_REG_COUNT=200000 for the full size benchmark
+#define REG_BENCH_COUNT   20000
+#define REG_BENCH_RATE    100000
+#define REG_BENCH_SENDERS 4
+#define REG_BENCH_EXPIRES 3600
+
+static vector<long> reg_fired;
+
+static void reg_test_cb(RegTimer* timer, long data1, int data2) {
+  reg_fired.push_back(data1);
+}
+
+/** wheel with known start: constructed within one second */
+static RegistrationTimer* reg_new_wheel(time_t& start) {
+  while (true) {
+    time_t before = time(NULL);
+    RegistrationTimer* wheel = new RegistrationTimer();
+    start = time(NULL);
+    if (start == before)
+      return wheel;
+    delete wheel;
+  }
+}
+
+/** how many timers per wheel bucket, from the start bucket on */
+static vector<unsigned int> reg_bucket_loads(const vector<time_t>& expires,
+					     time_t start) {
+  vector<unsigned int> loads;
+  for (size_t i=0; i<expires.size(); i++) {
+    size_t b = (expires[i] - start) / TIMER_BUCKET_LENGTH;
+    if (loads.size() <= b)
+      loads.resize(b + 1);
+    loads[b]++;
+  }
+  return loads;
+}
+
+static unsigned int reg_max_load(const vector<unsigned int>& loads) {
+  return loads.empty() ? 0 : *std::max_element(loads.begin(), loads.end());
+}
+
+/** minimum load of the used buckets between the first and the last used one */
+static unsigned int reg_min_load(const vector<unsigned int>& loads) {
+  unsigned int res = 0;
+  bool first = true;
+  for (size_t i=0; i<loads.size(); i++) {
+    if (!loads[i] && first)
+      continue;
+    if (first || loads[i] < res)
+      res = loads[i];
+    first = false;
+  }
+  return res;
+}
+
+/** answers "REGISTER ... Call-ID: n" with "200 OK ... Call-ID: n" */
+class RegStubRegistrar : public AmThread
+{
+  int fd;
+
+protected:
+  void run() {
+    char buf[512];
+    while (true) {
+      ssize_t len = recv(fd, buf, sizeof(buf) - 1, 0);
+      if (len <= 0)
+	break;
+      buf[len] = '\0';
+      if (!strncmp(buf, "STOP", 4))
+	break;
+      const char* call_id = strstr(buf, "Call-ID: ");
+      if (!call_id)
+	continue;
+      char reply[256];
+      int reply_len =
+	snprintf(reply, sizeof(reply), "SIP/2.0 200 OK\r\nCall-ID: %ld\r\n"
+		 "Contact: <sip:bench@127.0.0.1>;expires=%d\r\n\r\n",
+		 atol(call_id + 9), REG_BENCH_EXPIRES);
+      if (send(fd, reply, reply_len, 0) < 0)
+	break;
+    }
+  }
+  void on_stop() { }
+
+public:
+  RegStubRegistrar(int fd) : fd(fd) { }
+};
+
+/** sends the REGISTERs, paced by the shared rate limiter */
+class RegBenchSender : public AmThread
+{
+  int fd;
+  RegRateLimiter* limiter;
+  long* next;
+  long count;
+
+protected:
+  void run() {
+    long i;
+    while ((i = __sync_fetch_and_add(next, 1)) < count) {
+      useconds_t wait_time = limiter->acquire();
+      if (wait_time)
+	usleep(wait_time);
+      char req[256];
+      int req_len =
+	snprintf(req, sizeof(req), "REGISTER sip:registrar.example SIP/2.0\r\n"
+		 "Call-ID: %ld\r\nExpires: %d\r\n\r\n", i, REG_BENCH_EXPIRES);
+      if (send(fd, req, req_len, 0) < 0)
+	break;
+    }
+  }
+  void on_stop() { }
+
+public:
+  RegBenchSender(int fd, RegRateLimiter* limiter, long* next, long count)
+    : fd(fd), limiter(limiter), next(next), count(count) { }
+};
+
+static double reg_elapsed_ms(const struct timeval& start) {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return (now.tv_sec - start.tv_sec) * 1e3 + (now.tv_usec - start.tv_usec) / 1e3;
+}
+
+FCTMF_SUITE_BGN(test_db_reg_agent) {
+
+  FCT_TEST_BGN(timer_wheel_insert_remove_fire) {
+    time_t t0;
+    RegistrationTimer* wheel = reg_new_wheel(t0);
+    reg_fired.clear();
+
+    RegTimer a, b, c, d;
+    a.cb = b.cb = c.cb = d.cb = reg_test_cb;
+    a.data1 = 1; b.data1 = 2; c.data1 = 3; d.data1 = 4;
+
+    a.expires = t0 + 5;
+    b.expires = t0 + 35;
+    c.expires = t0 + 100;
+    fct_chk(wheel->insert_timer(&a));
+    fct_chk(wheel->insert_timer(&b));
+    fct_chk(wheel->insert_timer(&c));
+    fct_chk(wheel->is_scheduled(&c));
+    fct_chk(wheel->remove_timer(&c));
+    fct_chk(!wheel->remove_timer(&c));
+    fct_chk(!wheel->is_scheduled(&c));
+
+    // moved when inserted again
+    d.expires = t0 + 50;
+    fct_chk(wheel->insert_timer(&d));
+    d.expires = t0 + 20;
+    fct_chk(wheel->insert_timer(&d));
+
+    // already expired: fired right away
+    c.expires = t0 - 100;
+    fct_chk(!wheel->insert_timer(&c));
+    fct_chk_eq_int(reg_fired.size(), 1);
+
+    wheel->run_timers(t0 + 3);
+    fct_chk_eq_int(reg_fired.size(), 1);
+    for (time_t t=t0 + 4; t < t0 + 200; t++)
+      wheel->run_timers(t);
+
+    fct_req(reg_fired.size() == 4);
+    fct_chk_eq_int(reg_fired[0], 3);
+    fct_chk_eq_int(reg_fired[1], 1);
+    fct_chk_eq_int(reg_fired[2], 4);
+    fct_chk_eq_int(reg_fired[3], 2);
+    fct_chk(!wheel->is_scheduled(&a) && !wheel->is_scheduled(&d));
+
+    delete wheel;
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(timer_wheel_spreads_refreshes) {
+    int saved_log_level = log_level;
+    log_level = L_INFO;
+
+    time_t t0;
+    RegistrationTimer* wheel = reg_new_wheel(t0);
+
+    // least loaded: every bucket of the interval gets its share
+    vector<RegTimer> timers(2000);
+    vector<time_t> expires;
+    for (size_t i=0; i<1000; i++) {
+      fct_chk(wheel->insert_timer_leastloaded(&timers[i], t0 + 100, t0 + 300));
+      expires.push_back(timers[i].expires);
+    }
+    vector<unsigned int> loads = reg_bucket_loads(expires, t0);
+    fct_chk_eq_int(reg_max_load(loads), 50);
+    fct_chk_eq_int(reg_min_load(loads), 50);
+
+    // jittered: in the interval, roughly even
+    expires.clear();
+    for (size_t i=1000; i<2000; i++) {
+      fct_chk(wheel->insert_timer_jittered(&timers[i], t0 + 1000, t0 + 1099));
+      fct_chk(timers[i].expires >= t0 + 1000 && timers[i].expires <= t0 + 1099);
+      expires.push_back(timers[i].expires);
+    }
+    loads = reg_bucket_loads(expires, t0 + 1000);
+    fct_chk_eq_int(loads.size(), 10);
+    fct_chk(reg_max_load(loads) < 200);
+    fct_chk(reg_min_load(loads) > 40);
+
+    for (size_t i=0; i<timers.size(); i++)
+      fct_chk(wheel->remove_timer(&timers[i]));
+
+    delete wheel;
+    log_level = saved_log_level;
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(refresh_policy_window) {
+    time_t t0;
+    RegistrationTimer* wheel = reg_new_wheel(t0);
+    RegTimer t;
+
+    RegRefreshPolicy policy;
+    policy.reregister_jitter = 0;
+    fct_chk(policy.schedule(*wheel, &t, t0 + 1000, t0, t0));
+    fct_chk_eq_int(t.expires, t0 + 500);
+
+    // from reg_start_ts, not from now
+    fct_chk(policy.schedule(*wheel, &t, t0 + 1000, t0 - 200, t0));
+    fct_chk_eq_int(t.expires, t0 + 400);
+
+    // refresh due already: now
+    fct_chk(policy.schedule(*wheel, &t, t0 + 100, t0 - 1000, t0));
+    fct_chk_eq_int(t.expires, t0);
+
+    policy.reregister_jitter = 0.1;
+    for (int i=0; i<20; i++) {
+      fct_chk(policy.schedule(*wheel, &t, t0 + 1000, t0, t0));
+      fct_chk(t.expires >= t0 + 450 && t.expires <= t0 + 500);
+    }
+
+    policy.minimum_reregister_interval = 0.4;
+    for (int i=0; i<20; i++) {
+      fct_chk(policy.schedule(*wheel, &t, t0 + 1000, t0, t0));
+      fct_chk(t.expires >= t0 + 400 && t.expires <= t0 + 500);
+    }
+
+    fct_chk(wheel->remove_timer(&t));
+    delete wheel;
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(rate_limiter_paces_senders) {
+    RegRateLimiter limiter;
+    limiter.init(100, 1, false);
+    struct timeval now;
+    gettimeofday(&now, NULL);
+
+    // full bucket first
+    for (int i=0; i<100; i++)
+      fct_chk(limiter.acquire(now) == 0);
+    // then booked ahead, one every 10ms
+    useconds_t w = limiter.acquire(now);
+    fct_chk(w > 9900 && w <= 10000);
+    w = limiter.acquire(now);
+    fct_chk(w > 19900 && w <= 20000);
+
+    // one second later, refilled (less what was booked)
+    now.tv_sec++;
+    for (int i=0; i<98; i++)
+      fct_chk(limiter.acquire(now) == 0);
+    fct_chk(limiter.acquire(now) > 0);
+
+    // slow start: nothing at first
+    limiter.init(10, 1, true);
+    gettimeofday(&now, NULL);
+    w = limiter.acquire(now);
+    fct_chk(w > 99000 && w <= 100000);
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(status_queue_merges_updates) {
+    RegStatusQueue queue;
+    queue.configure(3, 1000);
+
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    fct_chk(!queue.due(now));
+
+    RegStatusUpdate u1(1);
+    u1.update = true;
+    u1.last_code = 401;
+    u1.last_reason = "Unauthorized";
+    queue.push(u1);
+
+    RegStatusUpdate d2(2);
+    d2.remove = true;
+    queue.push(d2);
+
+    RegStatusUpdate u1b(1);
+    u1b.update = true;
+    u1b.last_code = 200;
+    u1b.last_reason = "OK";
+    u1b.update_status = true;
+    u1b.status = 2;
+    u1b.update_ts = true;
+    u1b.expiry = 3600;
+    queue.push(u1b);
+
+    fct_chk_eq_int(queue.size(), 2);
+    fct_chk(!queue.due(now));
+    now.tv_sec += 2;
+    fct_chk(queue.due(now));
+    now.tv_sec -= 2;
+
+    // update after delete: both
+    RegStatusUpdate u2(2);
+    u2.update = true;
+    u2.last_code = 200;
+    queue.push(u2);
+
+    // delete after update: only delete
+    RegStatusUpdate u3(3);
+    u3.update = true;
+    u3.last_code = 200;
+    queue.push(u3);
+    RegStatusUpdate d3(3);
+    d3.remove = true;
+    queue.push(d3);
+
+    fct_chk(queue.due(now));
+
+    vector<RegStatusUpdate> batch;
+    fct_req(queue.take(batch) == 3);
+    fct_chk_eq_int(queue.size(), 0);
+    fct_chk(!queue.due(now));
+
+    fct_chk_eq_int(batch[0].subscriber_id, 1);
+    fct_chk(!batch[0].remove && batch[0].update);
+    fct_chk_eq_int(batch[0].last_code, 200);
+    fct_chk(batch[0].last_reason == "OK");
+    fct_chk(batch[0].update_status && batch[0].status == 2);
+    fct_chk(batch[0].update_ts && batch[0].expiry == 3600);
+    fct_chk(!batch[0].update_contacts);
+
+    fct_chk_eq_int(batch[1].subscriber_id, 2);
+    fct_chk(batch[1].remove && batch[1].update);
+    fct_chk(!batch[1].update_status);
+
+    fct_chk_eq_int(batch[2].subscriber_id, 3);
+    fct_chk(batch[2].remove && !batch[2].update);
+  }
+  FCT_TEST_END();
+
+}
+FCTMF_SUITE_END();
+
+/* opt-in: SEMS_TEST_BENCH=1 */
+FCTMF_SUITE_BGN(bench_db_reg_agent) {
+
+  FCT_TEST_BGN(registration_benchmark) {
+    int saved_log_level = log_level;
+    log_level = L_INFO;
+
+    long n_regs = REG_BENCH_COUNT;
+    if (getenv("SEMS_TEST_REG_COUNT"))
+      n_regs = atol(getenv("SEMS_TEST_REG_COUNT"));
+    unsigned int rate = REG_BENCH_RATE;
+    if (getenv("SEMS_TEST_REG_RATE"))
+      rate = atoi(getenv("SEMS_TEST_REG_RATE"));
+
+    // local stub registrar; unix datagrams are not lost when the
+    // receiver is behind, the sender blocks instead
+    int sv[2];
+    fct_req(socketpair(AF_UNIX, SOCK_DGRAM, 0, sv) == 0);
+
+    // refresh as db_reg_agent with reregister_interval=0.5: exactly,
+    // with the default jitter, or with minimum_reregister_interval=0.4
+    RegRefreshPolicy exact, jitter, least;
+    exact.reregister_jitter = 0;
+    least.minimum_reregister_interval = 0.4;
+
+    time_t exact_start, least_start, jitter_start;
+    RegistrationTimer* exact_wheel = reg_new_wheel(exact_start);
+    RegistrationTimer* least_wheel = reg_new_wheel(least_start);
+    RegistrationTimer* jitter_wheel = reg_new_wheel(jitter_start);
+    vector<RegTimer> exact_timers(n_regs), least_timers(n_regs), jitter_timers(n_regs);
+    vector<time_t> exact_exp, least_exp, jitter_exp;
+
+    RegStatusQueue status_queue;
+    status_queue.configure(500, 100);
+    unsigned int db_batches = 0;
+    size_t db_rows = 0;
+    vector<RegStatusUpdate> batch;
+
+    RegRateLimiter limiter;
+    limiter.init(rate, 1, false);
+
+    RegStubRegistrar registrar(sv[1]);
+    registrar.start();
+
+    struct timeval start;
+    gettimeofday(&start, NULL);
+
+    long next = 0;
+    vector<RegBenchSender*> senders;
+    for (int i=0; i<REG_BENCH_SENDERS; i++) {
+      senders.push_back(new RegBenchSender(sv[0], &limiter, &next, n_regs));
+      senders.back()->start();
+    }
+
+    long replies = 0;
+    double schedule_ms = 0;
+    char buf[512];
+    while (replies < n_regs) {
+      ssize_t len = recv(sv[0], buf, sizeof(buf) - 1, 0);
+      if (len <= 0)
+	break;
+      buf[len] = '\0';
+      const char* call_id = strstr(buf, "Call-ID: ");
+      const char* exp = strstr(buf, "expires=");
+      if (strncmp(buf, "SIP/2.0 200", 11) || !call_id || !exp)
+	continue;
+      long id = atol(call_id + 9);
+      time_t expiry = atoi(exp + 8);
+      if (id < 0 || id >= n_regs)
+	continue;
+      replies++;
+
+      struct timeval sched_start;
+      gettimeofday(&sched_start, NULL);
+      time_t now = sched_start.tv_sec;
+      exact_timers[id].data1 = id;
+      exact.schedule(*exact_wheel, &exact_timers[id], now + expiry, now, now);
+      exact_exp.push_back(exact_timers[id].expires);
+      jitter_timers[id].data1 = id;
+      jitter.schedule(*jitter_wheel, &jitter_timers[id], now + expiry, now, now);
+      jitter_exp.push_back(jitter_timers[id].expires);
+      least_timers[id].data1 = id;
+      least.schedule(*least_wheel, &least_timers[id], now + expiry, now, now);
+      least_exp.push_back(least_timers[id].expires);
+      schedule_ms += reg_elapsed_ms(sched_start);
+
+      RegStatusUpdate u(id);
+      u.update = true;
+      u.last_code = 200;
+      u.last_reason = "OK";
+      u.update_status = true;
+      u.status = 2;
+      u.update_ts = true;
+      u.ts = now;
+      u.expiry = expiry;
+      status_queue.push(u);
+      if (status_queue.due()) {
+	db_rows += status_queue.take(batch);
+	db_batches++;
+      }
+    }
+    if (status_queue.take(batch)) {
+      db_rows += batch.size();
+      db_batches++;
+    }
+    double reg_ms = reg_elapsed_ms(start);
+
+    for (size_t i=0; i<senders.size(); i++) {
+      senders[i]->join();
+      delete senders[i];
+    }
+    fct_chk(send(sv[0], "STOP", 4, 0) == 4);
+    registrar.join();
+    close(sv[0]);
+    close(sv[1]);
+
+    fct_chk_eq_int(replies, n_regs);
+    fct_chk_eq_int(db_rows, (size_t)n_regs);
+
+    vector<unsigned int> exact_loads = reg_bucket_loads(exact_exp, exact_start);
+    vector<unsigned int> jitter_loads = reg_bucket_loads(jitter_exp, jitter_start);
+    vector<unsigned int> least_loads = reg_bucket_loads(least_exp, least_start);
+    fct_chk(reg_max_load(least_loads) <= reg_max_load(jitter_loads));
+    fct_chk(reg_max_load(jitter_loads) <= reg_max_load(exact_loads));
+
+    double remove_ms;
+    struct timeval rm_start;
+    gettimeofday(&rm_start, NULL);
+    for (long i=0; i<n_regs; i++) {
+      fct_chk(exact_wheel->remove_timer(&exact_timers[i]));
+      fct_chk(least_wheel->remove_timer(&least_timers[i]));
+      fct_chk(jitter_wheel->remove_timer(&jitter_timers[i]));
+    }
+    remove_ms = reg_elapsed_ms(rm_start);
+
+    INFO("%ld registrations, %d senders at max. %u/s: %.0f ms (%.0f/s); "
+	 "refresh scheduling %.2f us, removing %.2f us per timer; "
+	 "max. refreshes per %ds: exact %u, jittered %u, least loaded %u; "
+	 "%zd DB updates in %u batches\n",
+	 n_regs, REG_BENCH_SENDERS, rate, reg_ms, n_regs / reg_ms * 1000,
+	 schedule_ms * 1000 / n_regs / 3, remove_ms * 1000 / n_regs / 3,
+	 TIMER_BUCKET_LENGTH, reg_max_load(exact_loads), reg_max_load(jitter_loads),
+	 reg_max_load(least_loads), db_rows, db_batches);
+
+    delete exact_wheel;
+    delete least_wheel;
+    delete jitter_wheel;
+    log_level = saved_log_level;
+  }
+  FCT_TEST_END();
+}
+FCTMF_SUITE_END();
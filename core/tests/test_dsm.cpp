@@ -0,0 +1,468 @@
+#include "fct.h"
+
+#include "log.h"
+
+#include "AmSession.h"
+#include "AmUtils.h"
+
+#include "../../apps/dsm/DSM.h"
+#include "../../apps/dsm/DSMChartReader.h"
+#include "../../apps/dsm/DSMModule.h"
+#include "../../apps/dsm/DSMSession.h"
+#include "../../apps/dsm/DSMStateEngine.h"
+#include "../../apps/dsm/DSMStateDiagramCollection.h"
+#include "../../apps/dsm/DSMChartCache.h"
+
+#include <sys/time.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fstream>
+#include <vector>
+
+// The DSM application is linked without its factory (DSM.cpp), which
+// would export plugin_class_create a second time.
+#ifdef USE_MONITORING
+bool DSMFactory::MonitoringFullCallgraph = false;
+bool DSMFactory::MonitoringFullTransitions = false;
+#endif
+DSMFactory* DSMFactory::instance() { return NULL; }
+bool DSMFactory::createSystemDSM(const string& config_name, const string& start_diag,
+				 bool reload, string& status) {
+  status = "not available in sems_tests";
+  return false;
+}
+
+#define DSM_BENCH_EVENTS 1000000
+
+/** DSM session without media: records the prompts played */
+class TestDSMSession : public DSMSession
+{
+public:
+  vector<string> prompts;
+
+  void playPrompt(const string& name, bool loop, bool front) {
+    if (prompts.size() < 1000) prompts.push_back(name);
+  }
+  void playFile(const string& name, bool loop, bool front) { }
+  void playSilence(unsigned int length, bool front) { }
+  void playRingtone(int length, int on, int off, int f, int f2, bool front) { }
+  void recordFile(const string& name) { }
+  unsigned int getRecordLength() { return 0; }
+  unsigned int getRecordDataSize() { return 0; }
+  void stopRecord() { }
+  void setInOutPlaylist() { }
+  void setInputPlaylist() { }
+  void setOutputPlaylist() { }
+  void addToPlaylist(AmPlaylistItem* item, bool front) { }
+  void flushPlaylist() { }
+  void setPromptSet(const string& name) { }
+  void addSeparator(const string& name, bool front) { }
+  void connectMedia() { }
+  void disconnectMedia() { }
+  void mute() { }
+  void unmute() { }
+  void B2BconnectCallee(const string& remote_party, const string& remote_uri,
+			bool relayed_invite) { }
+  void B2BterminateOtherLeg() { }
+  void B2BaddReceivedRequest(const AmSipRequest& req) { }
+  void B2BsetRelayEarlyMediaSDP(bool enabled) { }
+  void B2BsetHeaders(const string& hdr, bool replaceCRLF) { }
+  void B2BclearHeaders() { }
+  void B2BaddHeader(const string& hdr) { }
+  void B2BremoveHeader(const string& hdr) { }
+  void transferOwnership(DSMDisposable* d) { delete d; }
+  void releaseOwnership(DSMDisposable* d) { }
+};
+
+/**
+ * IVR menu chart: every menu state has a transition per digit, a
+ * timeout, events_per_state DSM event transitions and hangup
+ */
+static string dsm_ivr_chart(unsigned int n_states, unsigned int events_per_state,
+			    bool with_exceptions)
+{
+  string c;
+  for (unsigned int i=0; i<n_states; i++) {
+    string st = "menu_" + int2str(i);
+    c += string(i ? "" : "initial ") + "state " + st +
+      " enter { playPrompt(" + st + "); set($menu=" + int2str(i) + "); };\n";
+  }
+  c += "state end;\n";
+
+  for (unsigned int i=0; i<n_states; i++) {
+    string st = "menu_" + int2str(i);
+    for (unsigned int j=0; j<events_per_state; j++)
+      c += "transition \"event " + int2str(j) + "\" " + st +
+	" - eventTest(#name == ev_" + int2str(j) + ") / set($last_event=#name) -> " +
+	st + ";\n";
+
+    if (with_exceptions) {
+      c += "transition \"nine\" " + st + " - keyTest(#key == 9) / throw(nine) -> end;\n";
+      c += "transition \"error\" " + st + " - exception; test(#type == nine) / "
+	"inc($errors) -> menu_0;\n";
+    }
+
+    for (unsigned int k=0; k<10; k++)
+      c += "transition \"digit " + int2str(k) + "\" " + st +
+	" - keyTest(#key == " + int2str(k) + ") / { set($digit=#key); inc($presses); "
+	"eval($sum=$digit + $menu); } -> menu_" + int2str((i + k) % n_states) + ";\n";
+
+    if (with_exceptions) // also on key events, before the timeout
+      c += "transition \"no timer 1\" " + st + " - not timerTest(#id == 1); "
+	"test($presses > 5) / inc($not_timer) -> " + st + ";\n";
+
+    c += "transition timeout " + st + " - timerTest(#id == 1) / "
+      "{ inc($timeouts); playPrompt(timeout); } -> " + st + ";\n";
+  }
+  c += "transition bye (";
+  for (unsigned int i=0; i<n_states; i++)
+    c += string(i ? ", " : "") + "menu_" + int2str(i);
+  c += ") - hangup -> end;\n";
+  return c;
+}
+
+/** chart, session and engine */
+struct DSMTestCall
+{
+  DSMElemContainer owner;
+  DSMStateDiagram diag;
+  DSMStateEngine engine;
+  AmSession sess;
+  TestDSMSession sc_sess;
+
+  DSMTestCall(const string& chart, bool compile)
+    : diag("ivr")
+  {
+    DSMChartReader cr;
+    vector<DSMModule*> mods;
+    cr.decode(&diag, chart, "", &owner, mods);
+    if (compile)
+      diag.compile();
+    engine.addDiagram(&diag);
+    engine.init(&sess, &sc_sess, "ivr", DSMCondition::Start);
+  }
+
+  void key(unsigned int k) {
+    map<string,string> params;
+    params["key"] = int2str(k);
+    engine.runEvent(&sess, &sc_sess, DSMCondition::Key, &params);
+  }
+  void timer(unsigned int id) {
+    map<string,string> params;
+    params["id"] = int2str(id);
+    engine.runEvent(&sess, &sc_sess, DSMCondition::Timer, &params);
+  }
+};
+
+static double dsm_elapsed_us(const struct timeval& start)
+{
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return (now.tv_sec - start.tv_sec) * 1e6 + (now.tv_usec - start.tv_usec);
+}
+
+static double dsm_bench_keys(const string& chart, bool compile, unsigned int n)
+{
+  DSMTestCall call(chart, compile);
+  map<string,string> params;
+  struct timeval start;
+  gettimeofday(&start, NULL);
+  for (unsigned int i=0; i<n; i++) {
+    params["key"] = int2str((i * 7) % 9); // no exceptions
+    call.engine.runEvent(&call.sess, &call.sc_sess, DSMCondition::Key, &params);
+  }
+  return dsm_elapsed_us(start) * 1000 / n;
+}
+
+/** directory for charts and compiled charts, removed by the destructor */
+struct DSMTestDir
+{
+  string path;
+
+  DSMTestDir() {
+    char tmpl[] = "/tmp/sems_test_dsm_XXXXXX";
+    if (mkdtemp(tmpl))
+      path = string(tmpl) + "/";
+  }
+  ~DSMTestDir() {
+    DIR* dp = opendir(path.c_str());
+    if (dp) {
+      struct dirent* ep;
+      while ((ep = readdir(dp)))
+	unlink((path + ep->d_name).c_str());
+      closedir(dp);
+    }
+    rmdir(path.c_str());
+  }
+  void write(const string& name, const string& text) {
+    std::ofstream ofs((path + name).c_str());
+    ofs << text;
+  }
+  unsigned int count(const string& suffix) {
+    unsigned int res = 0;
+    DIR* dp = opendir(path.c_str());
+    struct dirent* ep;
+    while (dp && (ep = readdir(dp))) {
+      string n(ep->d_name);
+      if (n.length() > suffix.length() &&
+	  n.substr(n.length() - suffix.length()) == suffix)
+	res++;
+    }
+    if (dp) closedir(dp);
+    return res;
+  }
+};
+
+/** load ivr.dsm from dir with chart cache; @return load time in us */
+static double dsm_load_ivr(DSMTestDir& dir, bool use_cache,
+			   DSMStateDiagramCollection** diags)
+{
+  struct timeval start;
+  gettimeofday(&start, NULL);
+  *diags = new DSMStateDiagramCollection();
+  if (use_cache)
+    (*diags)->setCachePath(dir.path);
+  if (!(*diags)->loadFile(dir.path + "ivr.dsm", "ivr", dir.path, "", false, false)) {
+    (*diags)->release();
+    *diags = NULL;
+  }
+  return dsm_elapsed_us(start);
+}
+
+/** run keys through a call with the diags, and compare with compiled text */
+static bool dsm_runs_like_chart(DSMStateDiagramCollection* diags, const string& chart)
+{
+  DSMTestCall ref(chart, true);
+  DSMStateEngine engine;
+  AmSession sess;
+  TestDSMSession sc_sess;
+  diags->addToEngine(&engine);
+  engine.init(&sess, &sc_sess, "ivr", DSMCondition::Start);
+
+  map<string,string> params;
+  for (unsigned int i=0; i<500; i++) {
+    unsigned int k = (i * 7) % 10;
+    params["key"] = int2str(k);
+    engine.runEvent(&sess, &sc_sess, DSMCondition::Key, &params);
+    ref.key(k);
+  }
+  return !sc_sess.var.empty() && sc_sess.var == ref.sc_sess.var &&
+    sc_sess.prompts == ref.sc_sess.prompts;
+}
+
+FCTMF_SUITE_BGN(test_dsm) {
+
+  FCT_TEST_BGN(templates_resolve_like_resolveVars) {
+    TestDSMSession sc_sess;
+    sc_sess.var["a"] = "alpha";
+    sc_sess.var["n"] = "12";
+    sc_sess.var["x-y"] = "dash";
+    map<string,string> params;
+    params["p"] = "param";
+    params["k"] = "5";
+
+    const char* exprs[] = {
+      "", "$a", "$b", "$$", "$", "#p", "#q", "##", "lit", "\"quoted\"",
+      "$n - 3", "5+$n", "#k-$n", "$x-y", "1 - 2 + 3", "$a+1", "@@", "@", NULL
+    };
+    for (unsigned int i=0; exprs[i]; i++) {
+      for (int ops=0; ops<2; ops++) {
+	DSMVarTemplate tpl(exprs[i], ops);
+	fct_chk(tpl.resolve(NULL, &sc_sess, &params) ==
+		resolveVars(exprs[i], NULL, &sc_sess, &params, ops));
+	fct_chk(tpl.resolve(NULL, &sc_sess, NULL) ==
+		resolveVars(exprs[i], NULL, &sc_sess, NULL, ops));
+      }
+    }
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(var_slots_follow_erase) {
+    TestDSMSession sc_sess;
+    DSMVarTemplate v("$slot_var");
+    fct_chk(v.resolve(NULL, &sc_sess, NULL) == "");
+    v.getVar(&sc_sess) = "one";
+    fct_chk(sc_sess.var["slot_var"] == "one");
+    fct_chk(v.resolve(NULL, &sc_sess, NULL) == "one");
+
+    sc_sess.var.erase("slot_var");
+    fct_chk(v.resolve(NULL, &sc_sess, NULL) == "");
+    sc_sess.var["slot_var"] = "two";
+    fct_chk(v.resolve(NULL, &sc_sess, NULL) == "two");
+
+    VarMapT other;
+    other["slot_var"] = "three";
+    sc_sess.var = other;
+    fct_chk(v.resolve(NULL, &sc_sess, NULL) == "three");
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(compiled_chart_runs_like_interpreted) {
+    int saved_log_level = log_level;
+    log_level = L_INFO; // too many transitions to trace
+
+    string chart = dsm_ivr_chart(7, 5, true);
+    DSMTestCall compiled(chart, true);
+    DSMTestCall interpreted(chart, false);
+
+    srand(41);
+    for (unsigned int i=0; i<5000; i++) {
+      unsigned int k = rand() % 10;
+      if (k == 3 && (i & 1)) {
+	compiled.timer(1 + (i & 2) / 2);
+	interpreted.timer(1 + (i & 2) / 2);
+      } else {
+	compiled.key(k);
+	interpreted.key(k);
+      }
+    }
+
+    fct_chk(compiled.sc_sess.var == interpreted.sc_sess.var);
+    fct_chk(compiled.sc_sess.prompts == interpreted.sc_sess.prompts);
+    fct_chk(!compiled.sc_sess.var["errors"].empty());
+    fct_chk(!compiled.sc_sess.var["not_timer"].empty());
+    fct_chk(!compiled.sc_sess.var["timeouts"].empty());
+
+    log_level = saved_log_level;
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(chart_cache_loads_same_chart) {
+    int saved_log_level = log_level;
+    log_level = L_INFO;
+
+    DSMTestDir dir;
+    fct_req(!dir.path.empty());
+    string chart = dsm_ivr_chart(5, 3, true);
+    // part of the chart in an include
+    size_t split = chart.find("transition");
+    dir.write("ivr.dsm", chart.substr(0, split) + "#include \"ivr_tr.dsm\"\n");
+    dir.write("ivr_tr.dsm", chart.substr(split));
+
+    DSMStateDiagramCollection* text_diags = NULL;
+    dsm_load_ivr(dir, true, &text_diags);
+    fct_req(text_diags != NULL);
+    fct_chk(dir.count(".dsmc") == 1);
+
+    DSMStateDiagramCollection* cached_diags = NULL;
+    dsm_load_ivr(dir, true, &cached_diags);
+    fct_req(cached_diags != NULL);
+    fct_chk(cached_diags->hasDiagram("ivr"));
+    fct_chk(dsm_runs_like_chart(text_diags, chart));
+    fct_chk(dsm_runs_like_chart(cached_diags, chart));
+    text_diags->release();
+    cached_diags->release();
+
+    // changed include: new entry
+    dir.write("ivr_tr.dsm", chart.substr(split) +
+	      "transition extra menu_0 - keyTest(#key == 10) -> end;\n");
+    DSMStateDiagramCollection* changed_diags = NULL;
+    dsm_load_ivr(dir, true, &changed_diags);
+    fct_req(changed_diags != NULL);
+    fct_chk(dir.count(".dsmc") == 2);
+    changed_diags->release();
+
+    // a damaged entry is not used
+    DSMStateDiagramCollection reader;
+    string text;
+    fct_req(reader.readFile(dir.path + "ivr.dsm", "ivr", dir.path, text));
+    {
+      vector<DSMChartToken> tokens;
+      DSMChartCache cache(dir.path, text);
+      fct_chk(cache.read(tokens) && !tokens.empty());
+      std::ofstream ofs(cache.getFileName().c_str());
+      ofs << "DSMC garbage";
+    }
+    {
+      vector<DSMChartToken> tokens;
+      DSMChartCache cache(dir.path, text);
+      fct_chk(!cache.read(tokens) && tokens.empty());
+    }
+
+    log_level = saved_log_level;
+  }
+  FCT_TEST_END();
+
+}
+FCTMF_SUITE_END();
+
+/* opt-in: SEMS_TEST_BENCH=1 */
+FCTMF_SUITE_BGN(bench_dsm) {
+
+  FCT_TEST_BGN(chart_load_benchmark) {
+    int saved_log_level = log_level;
+    log_level = L_INFO;
+
+    DSMTestDir dir;
+    fct_req(!dir.path.empty());
+    string chart = dsm_ivr_chart(128, 40, true);
+    dir.write("ivr.dsm", chart);
+
+    DSMStateDiagramCollection* diags = NULL;
+    double text_us = dsm_load_ivr(dir, false, &diags);
+    fct_req(diags != NULL);
+    diags->release();
+    double compile_us = dsm_load_ivr(dir, true, &diags);
+    fct_req(diags != NULL);
+    diags->release();
+    double cached_us = dsm_load_ivr(dir, true, &diags);
+    fct_req(diags != NULL);
+    fct_chk(dsm_runs_like_chart(diags, chart));
+    diags->release();
+
+    INFO("DSM chart load, %zd bytes: from text %.1f ms, from text writing cache "
+	 "%.1f ms, from chart cache %.1f ms\n",
+	 chart.length(), text_us / 1000, compile_us / 1000, cached_us / 1000);
+
+    log_level = saved_log_level;
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(dsm_benchmark) {
+    int saved_log_level = log_level;
+    log_level = L_INFO;
+
+    // the same menu with few and with many other transitions per state
+    string small_chart = dsm_ivr_chart(4, 0, false);
+    string large_chart = dsm_ivr_chart(64, 40, false);
+
+    double small_interpreted =
+      dsm_bench_keys(small_chart, false, DSM_BENCH_EVENTS);
+    double small_compiled = dsm_bench_keys(small_chart, true, DSM_BENCH_EVENTS);
+    double large_interpreted =
+      dsm_bench_keys(large_chart, false, DSM_BENCH_EVENTS);
+    double large_compiled = dsm_bench_keys(large_chart, true, DSM_BENCH_EVENTS);
+
+    INFO("DSM IVR key events: 4 states/12 transitions each: interpreted %.0f ns/event, "
+	 "compiled %.0f ns/event; 64 states/52 transitions each: interpreted %.0f "
+	 "ns/event, compiled %.0f ns/event (%u events)\n",
+	 small_interpreted, small_compiled, large_interpreted, large_compiled,
+	 DSM_BENCH_EVENTS);
+
+    // argument resolution alone
+    TestDSMSession sc_sess;
+    for (unsigned int i=0; i<20; i++)
+      sc_sess.var["var_" + int2str(i)] = int2str(i);
+    DSMVarTemplate tpl("$var_13");
+    string arg = "$var_13";
+    size_t len = 0;
+    struct timeval start;
+    gettimeofday(&start, NULL);
+    for (unsigned int i=0; i<DSM_BENCH_EVENTS; i++)
+      len += resolveVars(arg, NULL, &sc_sess, NULL).length();
+    double resolve_ns = dsm_elapsed_us(start) * 1000 / DSM_BENCH_EVENTS;
+    gettimeofday(&start, NULL);
+    for (unsigned int i=0; i<DSM_BENCH_EVENTS; i++)
+      len += tpl.resolve(NULL, &sc_sess, NULL).length();
+    double tpl_ns = dsm_elapsed_us(start) * 1000 / DSM_BENCH_EVENTS;
+    INFO("DSM $variable with 20 set: resolveVars %.1f ns, template %.1f ns\n",
+	 resolve_ns, tpl_ns);
+    fct_chk(len == 4 * DSM_BENCH_EVENTS);
+
+    log_level = saved_log_level;
+  }
+  FCT_TEST_END();
+}
+FCTMF_SUITE_END();
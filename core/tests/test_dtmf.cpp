@@ -0,0 +1,302 @@
+#include "fct.h"
+
+#include "log.h"
+
+#include "AmDtmfDetector.h"
+#include "AmDtmfGoertzel.h"
+#include "AmAudio.h"
+
+#include <sys/time.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define DT_RATE        8000
+#define DT_FRAME       160     // 20 ms @ 8 kHz
+#define DT_TICK        (WALLCLOCK_RATE / 50)
+#define DT_BENCH_STREAMS 200
+#define DT_BENCH_TICKS   250   // 5 sec of audio
+
+static const int dt_low[4] = { 697, 770, 852, 941 };
+static const int dt_high[4] = { 1209, 1336, 1477, 1633 };
+static const int dt_codes[4][4] =
+  { { 1, 2, 3, 12 }, { 4, 5, 6, 13 }, { 7, 8, 9, 14 }, { 10, 0, 11, 15 } };
+
+static double dt_elapsed_us(const struct timeval& start)
+{
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return (now.tv_sec - start.tv_sec) * 1e6 + (now.tv_usec - start.tv_usec);
+}
+
+/** the Goertzel filter as it was before the kernels */
+static void dt_ref_goertzel(const int* buf, const int* coef, int* result)
+{
+  int sk, sk1, sk2;
+
+  for (int k = 0; k < GOERTZEL_NTONES; k++) {
+    sk = sk1 = sk2 = 0;
+    for (int n = 0; n < GOERTZEL_NPOINTS; n++) {
+      sk = buf[n] + ((coef[k] * sk1) >> 15) - sk2;
+      sk2 = sk1;
+      sk1 = sk;
+    }
+    sk >>= 1;
+    sk2 >>= 1;
+    result[k] =
+      ((sk * sk) >> GOERTZEL_AMP_BITS) -
+      ((((coef[k] * sk) >> 15) * sk2) >> GOERTZEL_AMP_BITS) +
+      ((sk2 * sk2) >> GOERTZEL_AMP_BITS);
+  }
+}
+
+/** one or two tones, amplitudes in linear PCM */
+static void dt_tones(std::vector<short>& buf, double f1, double a1,
+		     double f2, double a2, unsigned int samples)
+{
+  unsigned int start = buf.size();
+  buf.resize(start + samples);
+  for (unsigned int i=0; i<samples; i++)
+    buf[start + i] = (short)lrint(a1 * sin(2.0 * M_PI * f1 * i / DT_RATE) +
+				  a2 * sin(2.0 * M_PI * f2 * i / DT_RATE));
+}
+
+/** 16 digits, 100 ms on, 100 ms off */
+static void dt_digits(std::vector<short>& buf, double low_amp, double high_amp)
+{
+  for (int r=0; r<4; r++)
+    for (int c=0; c<4; c++) {
+      dt_tones(buf, dt_low[r], low_amp, dt_high[c], high_amp, DT_RATE / 10);
+      dt_tones(buf, 0, 0, 0, 0, DT_RATE / 10);
+    }
+}
+
+/** records what the detector reports */
+class DtSink : public AmKeyPressSink
+{
+public:
+  std::string log;
+
+  void registerKeyReleased(int event, Dtmf::EventSource source,
+			   const struct timeval& start, const struct timeval& stop,
+			   bool has_eventid, unsigned int event_id) {
+    char s[64];
+    snprintf(s, sizeof(s), "R%d:%ld.%06ld-%ld.%06ld ", event,
+	     (long)start.tv_sec, (long)start.tv_usec,
+	     (long)stop.tv_sec, (long)stop.tv_usec);
+    log += s;
+  }
+  void registerKeyPressed(int event, Dtmf::EventSource source,
+			  bool has_eventid, unsigned int event_id) {
+    char s[16];
+    snprintf(s, sizeof(s), "P%d ", event);
+    log += s;
+  }
+  void flushKey(unsigned int event_id) { }
+
+  /** codes of the released keys */
+  std::vector<int> released() const {
+    std::vector<int> codes;
+    for (size_t p = log.find('R'); p != std::string::npos; p = log.find('R', p + 1))
+      codes.push_back(atoi(log.c_str() + p + 1));
+    return codes;
+  }
+};
+
+/** feed buf in 20 ms frames */
+static void dt_feed(AmInbandDtmfDetector& det, const std::vector<short>& buf)
+{
+  unsigned long long ts = 0;
+  for (unsigned int i=0; i + DT_FRAME <= buf.size(); i += DT_FRAME) {
+    det.streamPut((const unsigned char*)&buf[i], PCM16_S2B(DT_FRAME), ts);
+    ts += DT_TICK;
+  }
+}
+
+static std::string dt_detect(const std::vector<short>& buf,
+			     const AmGoertzelKernels* kernels)
+{
+  DtSink sink;
+  AmSemsInbandDtmfDetector det(&sink, DT_RATE, kernels);
+  dt_feed(det, buf);
+  return sink.log;
+}
+
+FCTMF_SUITE_BGN(test_dtmf) {
+
+  FCT_TEST_BGN(kernels_bitexact) {
+    const char* names[] = { "scalar", "sse2", "avx2", NULL };
+    int coef[GOERTZEL_LANES];
+    // different coefficients in the second half of the lanes
+    AmGoertzelKernels::toneCoefficients(DT_RATE, coef);
+    AmGoertzelKernels::toneCoefficients(2 * DT_RATE, coef + GOERTZEL_NTONES);
+
+    // random blocks at full scale, tones and silence
+    std::vector<short> in;
+    srand(11);
+    for (unsigned int i=0; i<GOERTZEL_NPOINTS * 40; i++)
+      in.push_back((short)(rand() % 65536 - 32768));
+    dt_digits(in, 16000, 16000);
+
+    std::vector<int> x(in.size());
+    for (unsigned int i=0; i<in.size(); i++)
+      x[i] = in[i] >> (15 - GOERTZEL_AMP_BITS);
+
+    for (unsigned int b=0; b + 2 * GOERTZEL_NPOINTS <= x.size(); b += GOERTZEL_NPOINTS) {
+      const int* x0 = &x[b];
+      const int* x1 = &x[b + GOERTZEL_NPOINTS];
+      int ref[GOERTZEL_LANES];
+      dt_ref_goertzel(x0, coef, ref);
+      dt_ref_goertzel(x1, coef + GOERTZEL_NTONES, ref + GOERTZEL_NTONES);
+
+      for (unsigned int k=0; names[k]; k++) {
+	const AmGoertzelKernels* kernels = AmGoertzelKernels::get(names[k]);
+	if (!kernels) continue; // not supported by this CPU
+	int result[GOERTZEL_LANES];
+	kernels->goertzel(x0, x1, coef, result);
+	fct_chk(memcmp(result, ref, sizeof(ref)) == 0);
+      }
+    }
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(digits) {
+    std::vector<short> in;
+    dt_digits(in, 8000, 8000);
+
+    DtSink ref;
+    ref.log = dt_detect(in, AmGoertzelKernels::get("scalar"));
+    std::vector<int> codes = ref.released();
+    fct_chk(codes.size() == 16);
+    for (unsigned int i=0; i<codes.size() && i<16; i++)
+      fct_chk(codes[i] == dt_codes[i / 4][i % 4]);
+
+    fct_chk(dt_detect(in, AmGoertzelKernels::get()) == ref.log);
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(rejection) {
+    std::vector<short> in;
+    // one tone only
+    dt_tones(in, dt_low[0], 8000, 0, 0, DT_RATE / 5);
+    dt_tones(in, 0, 0, dt_high[2], 8000, DT_RATE / 5);
+    // two tones of one group
+    dt_tones(in, dt_low[0], 8000, dt_low[2], 8000, DT_RATE / 5);
+    // 24 dB twist
+    dt_tones(in, dt_low[1], 8000, dt_high[1], 500, DT_RATE / 5);
+    // too low
+    dt_tones(in, dt_low[1], 30, dt_high[1], 30, DT_RATE / 5);
+    // too short
+    dt_tones(in, dt_low[3], 8000, dt_high[3], 8000, DT_RATE / 25);
+    dt_tones(in, 0, 0, 0, 0, DT_RATE / 5);
+
+    std::string ref = dt_detect(in, AmGoertzelKernels::get("scalar"));
+    fct_chk(ref.empty());
+    fct_chk(dt_detect(in, AmGoertzelKernels::get()) == ref);
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(batch) {
+    // many streams, different digits and phases; batched per tick
+    // the events must be the same as evaluated per block
+    const unsigned int streams = 7;
+    std::vector<std::vector<short> > in(streams);
+    for (unsigned int s=0; s<streams; s++) {
+      dt_tones(in[s], 0, 0, 0, 0, 37 * s);
+      dt_digits(in[s], 6000 + 500 * s, 7000);
+    }
+
+    std::vector<DtSink> ref_sinks(streams), sinks(streams);
+    std::vector<AmSemsInbandDtmfDetector*> dets;
+    for (unsigned int s=0; s<streams; s++) {
+      ref_sinks[s].log = dt_detect(in[s], AmGoertzelKernels::get("scalar"));
+      dets.push_back(new AmSemsInbandDtmfDetector(&sinks[s], DT_RATE));
+    }
+
+    AmInbandDtmfBatch* batch = AmInbandDtmfBatch::enable();
+    fct_chk(AmInbandDtmfBatch::current() == batch);
+    unsigned long long ts = 0;
+    for (unsigned int i=0; i + DT_FRAME <= in[0].size(); i += DT_FRAME) {
+      for (unsigned int s=0; s<streams; s++)
+	if (i + DT_FRAME <= in[s].size())
+	  dets[s]->streamPut((const unsigned char*)&in[s][i], PCM16_S2B(DT_FRAME), ts);
+      batch->flush();
+      ts += DT_TICK;
+    }
+
+    // a detector deleted with pending blocks
+    dets[0]->streamPut((const unsigned char*)&in[0][0], PCM16_S2B(DT_FRAME), ts);
+    dets[0]->streamPut((const unsigned char*)&in[0][0], PCM16_S2B(DT_FRAME), ts);
+    delete dets[0];
+    dets[0] = NULL;
+    AmInbandDtmfBatch::disable();
+    fct_chk(AmInbandDtmfBatch::current() == NULL);
+
+    for (unsigned int s=0; s<streams; s++) {
+      fct_chk(sinks[s].released().size() == 16);
+      fct_chk(sinks[s].log == ref_sinks[s].log);
+      delete dets[s];
+    }
+  }
+  FCT_TEST_END();
+
+}
+FCTMF_SUITE_END();
+
+/* opt-in: SEMS_TEST_BENCH=1 */
+FCTMF_SUITE_BGN(bench_dtmf) {
+
+  FCT_TEST_BGN(dtmf_benchmark) {
+    int saved_log_level = log_level;
+    log_level = L_INFO;
+
+    std::vector<short> in;
+    while (in.size() < DT_FRAME * DT_BENCH_TICKS)
+      dt_digits(in, 8000, 8000);
+    unsigned int blocks = DT_BENCH_STREAMS * (DT_FRAME * DT_BENCH_TICKS / GOERTZEL_NPOINTS);
+
+    std::vector<DtSink> sinks(DT_BENCH_STREAMS);
+    const char* names[] = { "scalar", "sse2", "avx2", NULL };
+    double us[4] = { 0, 0, 0, 0 };
+
+    for (unsigned int k=0; k<4; k++) {
+      const AmGoertzelKernels* kernels = names[k] ? AmGoertzelKernels::get(names[k]) : NULL;
+      if (names[k] && !kernels) continue;
+
+      std::vector<AmSemsInbandDtmfDetector*> dets;
+      for (unsigned int s=0; s<DT_BENCH_STREAMS; s++)
+	dets.push_back(new AmSemsInbandDtmfDetector(&sinks[s], DT_RATE, kernels));
+
+      // the last round: batched per tick with the best kernels
+      AmInbandDtmfBatch* batch = names[k] ? NULL : AmInbandDtmfBatch::enable();
+
+      struct timeval start;
+      gettimeofday(&start, NULL);
+      unsigned long long ts = 0;
+      for (unsigned int t=0; t<DT_BENCH_TICKS; t++) {
+	for (unsigned int s=0; s<DT_BENCH_STREAMS; s++)
+	  dets[s]->streamPut((const unsigned char*)&in[t * DT_FRAME],
+			     PCM16_S2B(DT_FRAME), ts);
+	if (batch) batch->flush();
+	ts += DT_TICK;
+      }
+      us[k] = dt_elapsed_us(start);
+
+      if (batch) AmInbandDtmfBatch::disable();
+      for (unsigned int s=0; s<DT_BENCH_STREAMS; s++)
+	delete dets[s];
+    }
+
+    INFO("inband DTMF, %u streams: scalar %.0f ns/block, sse2 %.0f ns/block, "
+	 "avx2 %.0f ns/block, batched %s %.0f ns/block\n", DT_BENCH_STREAMS,
+	 us[0] * 1000 / blocks, us[1] * 1000 / blocks, us[2] * 1000 / blocks,
+	 AmGoertzelKernels::get()->name, us[3] * 1000 / blocks);
+
+    log_level = saved_log_level;
+  }
+  FCT_TEST_END();
+}
+FCTMF_SUITE_END();
@@ -0,0 +1,149 @@
+#include "fct.h"
+
+#include "log.h"
+
+#include "../plug-in/wav/g711.h"
+
+#include <sys/time.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#define G711_FRAME        160    // 20 ms @ 8 kHz
+#define G711_BENCH_FRAMES 200000
+
+static const char* g711_names[] = { "scalar", "ssse3", "avx2", NULL };
+
+static double g711_elapsed_us(const struct timeval& start)
+{
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return (now.tv_sec - start.tv_sec) * 1e6 + (now.tv_usec - start.tv_usec);
+}
+
+// keeps the benchmark output alive
+static volatile unsigned int g711_sum = 0;
+
+FCTMF_SUITE_BGN(test_g711) {
+
+  FCT_TEST_BGN(encode_all_values) {
+    // every 16 bit value, in frames with odd tails
+    std::vector<int16_t> in(65536);
+    for (unsigned int i=0; i<in.size(); i++)
+      in[i] = (int16_t)(i - 32768);
+
+    std::vector<uint8_t> u_ref(in.size()), a_ref(in.size());
+    for (unsigned int i=0; i<in.size(); i++) {
+      u_ref[i] = st_14linear2ulaw(in[i] >> 2);
+      a_ref[i] = st_13linear2alaw(in[i] >> 3);
+    }
+
+    for (unsigned int k=0; g711_names[k]; k++) {
+      const g711_kernels_t* kernels = g711_kernels(g711_names[k]);
+      if (!kernels) continue; // not supported by this CPU
+      std::vector<uint8_t> u(in.size()), a(in.size());
+      for (unsigned int i=0; i<in.size(); ) {
+	unsigned int n = 1 + i % 173;
+	if (n > in.size() - i) n = in.size() - i;
+	kernels->ulaw_encode(&u[i], &in[i], n);
+	kernels->alaw_encode(&a[i], &in[i], n);
+	i += n;
+      }
+      fct_chk(u == u_ref);
+      fct_chk(a == a_ref);
+    }
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(decode_all_values) {
+    std::vector<uint8_t> in(256 * 3);
+    for (unsigned int i=0; i<in.size(); i++)
+      in[i] = (uint8_t)(i * 7);
+
+    for (unsigned int k=0; g711_names[k]; k++) {
+      const g711_kernels_t* kernels = g711_kernels(g711_names[k]);
+      if (!kernels) continue;
+      std::vector<int16_t> u(in.size()), a(in.size());
+      kernels->ulaw_decode(&u[0], &in[0], in.size() - 5);
+      kernels->alaw_decode(&a[0], &in[0], in.size() - 5);
+      for (unsigned int i=0; i<in.size() - 5; i++) {
+	fct_chk(u[i] == st_ulaw2linear16(in[i]));
+	fct_chk(a[i] == st_alaw2linear16(in[i]));
+      }
+    }
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(encode_in_place) {
+    std::vector<int16_t> in(G711_FRAME * 2 + 3);
+    srand(5);
+    for (unsigned int i=0; i<in.size(); i++)
+      in[i] = (int16_t)(rand() % 65536 - 32768);
+
+    std::vector<uint8_t> ref(in.size());
+    g711_kernels("scalar")->alaw_encode(&ref[0], &in[0], in.size());
+    g711_kernels(NULL)->alaw_encode((uint8_t*)&in[0], &in[0], in.size());
+    fct_chk(memcmp(&in[0], &ref[0], ref.size()) == 0);
+  }
+  FCT_TEST_END();
+
+}
+FCTMF_SUITE_END();
+
+/* opt-in: SEMS_TEST_BENCH=1 */
+FCTMF_SUITE_BGN(bench_g711) {
+
+  FCT_TEST_BGN(g711_benchmark) {
+    int saved_log_level = log_level;
+    log_level = L_INFO;
+
+    int16_t pcm[G711_FRAME];
+    uint8_t enc[G711_FRAME];
+    srand(9);
+    for (unsigned int i=0; i<G711_FRAME; i++)
+      pcm[i] = (int16_t)(rand() % 20000 - 10000);
+
+    for (unsigned int k=0; g711_names[k]; k++) {
+      const g711_kernels_t* kernels = g711_kernels(g711_names[k]);
+      if (!kernels) continue;
+
+      struct timeval start;
+      gettimeofday(&start, NULL);
+      for (unsigned int f=0; f<G711_BENCH_FRAMES; f++) {
+	kernels->alaw_encode(enc, pcm, G711_FRAME);
+	g711_sum += enc[f % G711_FRAME];
+      }
+      double a_enc = g711_elapsed_us(start);
+
+      gettimeofday(&start, NULL);
+      for (unsigned int f=0; f<G711_BENCH_FRAMES; f++) {
+	kernels->ulaw_encode(enc, pcm, G711_FRAME);
+	g711_sum += enc[f % G711_FRAME];
+      }
+      double u_enc = g711_elapsed_us(start);
+
+      gettimeofday(&start, NULL);
+      for (unsigned int f=0; f<G711_BENCH_FRAMES; f++) {
+	kernels->alaw_decode(pcm, enc, G711_FRAME);
+	g711_sum += pcm[f % G711_FRAME];
+      }
+      double a_dec = g711_elapsed_us(start);
+
+      gettimeofday(&start, NULL);
+      for (unsigned int f=0; f<G711_BENCH_FRAMES; f++) {
+	kernels->ulaw_decode(pcm, enc, G711_FRAME);
+	g711_sum += pcm[f % G711_FRAME];
+      }
+      double u_dec = g711_elapsed_us(start);
+
+      double samples = (double)G711_BENCH_FRAMES * G711_FRAME;
+      INFO("G.711 %s: A-law encode %.0f, u-law encode %.0f, A-law decode %.0f, "
+	   "u-law decode %.0f Msamples/s\n", kernels->name,
+	   samples / a_enc, samples / u_enc, samples / a_dec, samples / u_dec);
+    }
+
+    log_level = saved_log_level;
+  }
+  FCT_TEST_END();
+}
+FCTMF_SUITE_END();
@@ -0,0 +1,344 @@
+#ifdef WITH_HTTP_CLIENT
+
+#include "fct.h"
+
+#include "log.h"
+
+#include "AmConfig.h"
+#include "AmEventDispatcher.h"
+#include "AmPlugIn.h"
+#include "AmThread.h"
+#include "AmUtils.h"
+#include "ampi/HttpClientAPI.h"
+
+#include "../../apps/http_client/HttpClient.h"
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vector>
+using std::vector;
+
+#define HTTP_TEST_CONF_DIR  "/tmp/sems_test_http_client"
+#define HTTP_TEST_LISTENER  "http_test_listener"
+#define HTTP_TEST_MAX_BODY  1024
+#define HTTP_TEST_SLOW_MS   2000
+
+/** minimal HTTP/1.0 server on the loopback interface */
+class HttpTestServer
+  : public AmThread
+{
+  int sd;
+  unsigned short port;
+  AmSharedVar<bool> stop_requested;
+
+  bool readRequest(int c, string& method, string& path, string& body,
+		   string& content_type)
+  {
+    string req;
+    char buf[1024];
+    size_t hdr_end;
+    while ((hdr_end = req.find("\r\n\r\n")) == string::npos) {
+      ssize_t n = recv(c, buf, sizeof(buf), 0);
+      if (n <= 0)
+	return false;
+      req.append(buf, n);
+    }
+
+    size_t sp1 = req.find(' ');
+    size_t sp2 = req.find(' ', sp1 + 1);
+    if (sp1 == string::npos || sp2 == string::npos)
+      return false;
+    method = req.substr(0, sp1);
+    path = req.substr(sp1 + 1, sp2 - sp1 - 1);
+
+    string hdrs = req.substr(0, hdr_end);
+    unsigned int content_length = 0;
+    vector<string> lines = explode(hdrs, "\r\n");
+    for (size_t i = 1; i < lines.size(); i++) {
+      size_t colon = lines[i].find(':');
+      if (colon == string::npos)
+	continue;
+      string name = lines[i].substr(0, colon);
+      string value = trim(lines[i].substr(colon + 1), " ");
+      if (!strcasecmp(name.c_str(), "Content-Length"))
+	str2i(value, content_length);
+      else if (!strcasecmp(name.c_str(), "Content-Type"))
+	content_type = value;
+    }
+
+    body = req.substr(hdr_end + 4);
+    while (body.length() < content_length) {
+      ssize_t n = recv(c, buf, sizeof(buf), 0);
+      if (n <= 0)
+	return false;
+      body.append(buf, n);
+    }
+    return true;
+  }
+
+  void respond(int c, const string& content_type, const string& body)
+  {
+    string resp = "HTTP/1.0 200 OK\r\n"
+      "Content-Type: " + content_type + "\r\n"
+      "Content-Length: " + int2str((unsigned int)body.length()) + "\r\n"
+      "Connection: close\r\n\r\n" + body;
+    size_t sent = 0;
+    while (sent < resp.length()) {
+      ssize_t n = send(c, resp.data() + sent, resp.length() - sent, MSG_NOSIGNAL);
+      if (n <= 0)
+	return;
+      sent += n;
+    }
+  }
+
+  void serve(int c)
+  {
+    string method, path, body, content_type;
+    if (!readRequest(c, method, path, body, content_type))
+      return;
+
+    if (path == "/hello") {
+      respond(c, "text/plain", "hello " + method);
+    } else if (path == "/echo") {
+      respond(c, content_type, body);
+    } else if (path == "/big") {
+      respond(c, "text/plain", string(HTTP_TEST_MAX_BODY * 4, 'x'));
+    } else if (path == "/slow") {
+      for (int i = 0; i < HTTP_TEST_SLOW_MS / 10 && !stop_requested.get(); i++)
+	usleep(10000);
+      respond(c, "text/plain", "late");
+    } else {
+      string resp = "HTTP/1.0 404 Not Found\r\nConnection: close\r\n\r\n";
+      send(c, resp.data(), resp.length(), MSG_NOSIGNAL);
+    }
+  }
+
+protected:
+  void run()
+  {
+    while (!stop_requested.get()) {
+      struct pollfd pfd;
+      pfd.fd = sd;
+      pfd.events = POLLIN;
+      if (poll(&pfd, 1, 100) <= 0)
+	continue;
+
+      int c = accept(sd, NULL, NULL);
+      if (c < 0)
+	continue;
+      serve(c);
+      close(c);
+    }
+  }
+
+  void on_stop() { stop_requested.set(true); }
+
+public:
+  HttpTestServer()
+    : sd(-1), port(0), stop_requested(false) {}
+
+  ~HttpTestServer() {
+    if (sd >= 0)
+      close(sd);
+  }
+
+  bool listen()
+  {
+    sd = socket(AF_INET, SOCK_STREAM, 0);
+    if (sd < 0)
+      return false;
+
+    struct sockaddr_in sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    sa.sin_port = 0;
+    socklen_t sa_len = sizeof(sa);
+    if (bind(sd, (struct sockaddr*)&sa, sizeof(sa)) ||
+	::listen(sd, 16) ||
+	getsockname(sd, (struct sockaddr*)&sa, &sa_len))
+      return false;
+
+    port = ntohs(sa.sin_port);
+    return true;
+  }
+
+  string url(const string& path) {
+    return "http://127.0.0.1:" + int2str((unsigned int)port) + path;
+  }
+};
+
+/** a session waiting for responses */
+struct HttpTestListener
+  : public AmEventHandler,
+    public AmEventQueue
+{
+  vector<HttpResponseEvent> responses;
+
+  HttpTestListener()
+    : AmEventQueue(this)
+  {
+    AmEventDispatcher::instance()->addEventQueue(HTTP_TEST_LISTENER, this);
+  }
+
+  ~HttpTestListener() {
+    AmEventDispatcher::instance()->delEventQueue(HTTP_TEST_LISTENER);
+  }
+
+  void process(AmEvent* ev) {
+    HttpResponseEvent* resp = dynamic_cast<HttpResponseEvent*>(ev);
+    if (resp)
+      responses.push_back(*resp);
+  }
+
+  /** wait for the response with token, max 5s */
+  HttpResponseEvent* wait(const string& token) {
+    for (int i = 0; i < 500; i++) {
+      processEvents();
+      for (size_t r = 0; r < responses.size(); r++)
+	if (responses[r].token == token)
+	  return &responses[r];
+      usleep(10000);
+    }
+    return NULL;
+  }
+};
+
+static HttpTestServer* http_test_server = NULL;
+
+/** start the module with a small max_body_size, and the server */
+static AmDynInvoke* http_test_init()
+{
+  if (!http_test_server) {
+    mkdir(HTTP_TEST_CONF_DIR, 0755);
+    FILE* fp = fopen(HTTP_TEST_CONF_DIR "/http_client.conf", "w");
+    if (!fp)
+      return NULL;
+    fprintf(fp, "max_body_size=%u\n", HTTP_TEST_MAX_BODY);
+    fclose(fp);
+
+    string saved_path = AmConfig::ModConfigPath;
+    AmConfig::ModConfigPath = HTTP_TEST_CONF_DIR "/";
+    int res = HttpClient::instance()->onLoad();
+    AmConfig::ModConfigPath = saved_path;
+    unlink(HTTP_TEST_CONF_DIR "/http_client.conf");
+    rmdir(HTTP_TEST_CONF_DIR);
+    if (res)
+      return NULL;
+
+    http_test_server = new HttpTestServer();
+    if (!http_test_server->listen())
+      return NULL;
+    http_test_server->start();
+  }
+
+  AmDynInvokeFactory* f = AmPlugIn::instance()->getFactory4Di("http_client");
+  return f ? f->getInstance() : NULL;
+}
+
+FCTMF_SUITE_BGN(test_http_client) {
+
+  FCT_TEST_BGN(http_client_get_di) {
+    AmDynInvoke* di = http_test_init();
+    fct_req(di != NULL);
+    HttpTestListener listener;
+
+    AmArg args, ret;
+    args.push(http_test_server->url("/hello"));
+    args.push(HTTP_TEST_LISTENER);
+    args.push("get1");
+    di->invoke("get", args, ret);
+    fct_chk_eq_int(ret.get(0).asInt(), 0);
+
+    HttpResponseEvent* resp = listener.wait("get1");
+    fct_req(resp != NULL);
+    fct_chk_eq_int(resp->error, 0);
+    fct_chk_eq_int(resp->status, 200);
+    fct_chk_eq_str(resp->body.c_str(), "hello GET");
+    fct_chk_eq_str(resp->content_type.c_str(), "text/plain");
+    fct_chk_eq_str(resp->url.c_str(), http_test_server->url("/hello").c_str());
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(http_client_post_event) {
+    fct_req(http_test_init() != NULL);
+    HttpTestListener listener;
+
+    HttpRequestEvent* req =
+      new HttpRequestEvent(HttpRequestEvent::Post, http_test_server->url("/echo"),
+			   HTTP_TEST_LISTENER, "post1");
+    req->body = "a=1&b=2";
+    req->content_type = "application/x-www-form-urlencoded";
+    fct_req(AmEventDispatcher::instance()->post(HTTP_CLIENT_QUEUE, req));
+
+    HttpResponseEvent* resp = listener.wait("post1");
+    fct_req(resp != NULL);
+    fct_chk_eq_int(resp->error, 0);
+    fct_chk_eq_int(resp->status, 200);
+    fct_chk_eq_str(resp->body.c_str(), "a=1&b=2");
+    fct_chk_eq_str(resp->content_type.c_str(), "application/x-www-form-urlencoded");
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(http_client_max_body_size) {
+    AmDynInvoke* di = http_test_init();
+    fct_req(di != NULL);
+    HttpTestListener listener;
+
+    AmArg args, ret;
+    args.push(http_test_server->url("/big"));
+    args.push(HTTP_TEST_LISTENER);
+    args.push("big1");
+    di->invoke("get", args, ret);
+
+    HttpResponseEvent* resp = listener.wait("big1");
+    fct_req(resp != NULL);
+    fct_chk_eq_int(resp->error, CURLE_WRITE_ERROR);
+    fct_chk_eq_str(resp->error_str.c_str(), "response body too large");
+    fct_chk(resp->body.length() <= HTTP_TEST_MAX_BODY);
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(http_client_timeout) {
+    AmDynInvoke* di = http_test_init();
+    fct_req(di != NULL);
+    HttpTestListener listener;
+
+    AmArg args, ret;
+    args.push(http_test_server->url("/slow"));
+    args.push(HTTP_TEST_LISTENER);
+    args.push("slow1");
+    args.push(200);
+    di->invoke("get", args, ret);
+
+    HttpResponseEvent* resp = listener.wait("slow1");
+    fct_req(resp != NULL);
+    fct_chk_eq_int(resp->error, CURLE_OPERATION_TIMEDOUT);
+    fct_chk_eq_int(resp->status, 0);
+    fct_chk(resp->time_ms >= 200 && resp->time_ms < HTTP_TEST_SLOW_MS);
+
+    // all answered
+    AmArg stats;
+    di->invoke("getStats", AmArg(), stats);
+    fct_chk_eq_int(stats["active"].asInt(), 0);
+    fct_chk_eq_int(stats["requests"].asInt(), 4);
+    fct_chk_eq_int(stats["failed"].asInt(), 2);
+
+    HttpClient::instance()->stop();
+    http_test_server->stop();
+    while (!HttpClient::instance()->is_stopped() || !http_test_server->is_stopped())
+      usleep(10000);
+  }
+  FCT_TEST_END();
+
+}
+FCTMF_SUITE_END();
+
+#endif
@@ -129,5 +129,40 @@ FCTMF_SUITE_BGN(test_jsonarg) {
     // DBG("a1 = '%s', a2 = '%s', \n", AmArg::print(a1).c_str(), AmArg::print(a2).c_str());
   }
   FCT_TEST_END();
+
+  FCT_TEST_BGN(json_encode_escaped) {
+    AmArg a;
+    a["k\"ey"] = "tab\there \x01 \xc3\xa4 /";
+    a["n"].push(-12);
+    a["n"].push((long long)-5000000000LL);
+    a["n"].push(AmArg());
+    a["n"].push(true);
+
+    string s = arg2json(a);
+    fct_chk(s == "{\"k\\\"ey\": \"tab\\there \\u0001 \xc3\xa4 /\", "
+	    "\"n\": [-12, -5000000000, null, true]}");
+
+    // appends
+    string out = "7:";
+    arg2json(a["n"], out);
+    fct_chk(out == "7:[-12, -5000000000, null, true]");
+
+    AmArg b;
+    fct_chk(json2arg(s, b));
+    // (\u escapes are left as they are by the parser)
+    fct_chk(b.hasMember("k\"ey") && isArgCStr(b["k\"ey"]));
+    fct_chk(b["n"].size() == 4 && b["n"][0].asInt() == -12);
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(json_parse_in_place) {
+    // netstrings: the next message follows without terminator
+    const char* buf = "{\"id\": \"1\"},15:{\"id\": \"2\"}";
+    AmArg a;
+    fct_chk(json2arg(buf, 11, a));
+    fct_chk(isArgCStr(a["id"]) && a["id"].asCStr() == string("1"));
+    fct_chk(!json2arg(buf, 5, a));
+  }
+  FCT_TEST_END();
 }
 FCTMF_SUITE_END();
@@ -0,0 +1,261 @@
+#include "fct.h"
+
+#include "log.h"
+
+#include "AmMultiPartyMixer.h"
+#include "AmRtpAudio.h"
+#include "AmPlugIn.h"
+#include "amci/codecs.h"
+
+#include <sys/time.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#define MIX_RATE       8000
+#define MIX_FRAME      160     // 20 ms @ 8 kHz
+#define MIX_TICK       (WALLCLOCK_RATE / 50)
+#define MIX_BENCH_TICKS 50     // 1 sec of audio
+
+static double mix_elapsed_us(const struct timeval& start)
+{
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return (now.tv_sec - start.tv_sec) * 1e6 + (now.tv_usec - start.tv_usec);
+}
+
+/** speech-like test signal: participant p, loud or quiet */
+static void mix_signal(short* buf, unsigned int p, unsigned int tick, bool loud)
+{
+  int amp = loud ? 8000 : 20;
+  for (unsigned int i=0; i<MIX_FRAME; i++) {
+    int phase = (tick * MIX_FRAME + i) * (p + 3);
+    buf[i] = (short)(((phase % 64) - 32) * amp / 32);
+  }
+}
+
+// keeps the encoder output alive
+static volatile unsigned int mix_encoded_sum = 0;
+
+/** G.711 A-law encoder, as the stand-in for a listener's encoder */
+static void mix_encode(unsigned char* out, const short* in, unsigned int samples)
+{
+  unsigned int sum = 0;
+  for (unsigned int i=0; i<samples; i++) {
+    int pcm = in[i] >> 3;
+    int mask = 0xD5;
+    if (pcm < 0) {
+      mask = 0x55;
+      pcm = -pcm - 1;
+    }
+    int seg = 0;
+    while (seg < 8 && pcm > (0x1F << seg))
+      seg++;
+    unsigned char a = (seg >= 8) ? 0x7F :
+      (seg << 4) | ((pcm >> (seg ? seg : 1)) & 0x0F);
+    out[i] = a ^ mask;
+    sum += out[i];
+  }
+  mix_encoded_sum += sum;
+}
+
+/**
+ * one 20ms tick of a conference: everybody puts, then everybody gets
+ * (and encodes, if rtp_fmt is set)
+ */
+static void mix_tick(AmMultiPartyMixer& mixer, const std::vector<unsigned int>& ch,
+		     unsigned int tick, unsigned int loud,
+		     std::vector<std::vector<short> >* out = NULL,
+		     AmAudioRtpFormat* rtp_fmt = NULL)
+{
+  unsigned long long ts = (unsigned long long)tick * MIX_TICK;
+  short buf[AUDIO_BUFFER_SIZE/2];
+  unsigned char enc[AUDIO_BUFFER_SIZE];
+  bool shared_encoded = false;
+
+  mixer.lock();
+  for (unsigned int i=0; i<ch.size(); i++) {
+    mix_signal(buf, i, tick, i < loud);
+    mixer.PutChannelPacket(ch[i], ts, (unsigned char*)buf, PCM16_S2B(MIX_FRAME));
+  }
+  for (unsigned int i=0; i<ch.size(); i++) {
+    if (rtp_fmt &&
+	mixer.GetChannelPacketEncoded(ch[i], ts, (unsigned char*)buf, rtp_fmt) > 0) {
+      // shared frame: encoded once for all listeners
+      if (!shared_encoded)
+	mix_encode(enc, buf, MIX_FRAME);
+      shared_encoded = true;
+      continue;
+    }
+
+    unsigned int size = PCM16_S2B(MIX_FRAME);
+    unsigned int rate = 0;
+    mixer.GetChannelPacket(ch[i], ts, (unsigned char*)buf, size, rate);
+    if (out)
+      (*out)[i].assign(buf, buf + PCM16_B2S(size));
+    if (rtp_fmt)
+      mix_encode(enc, buf, PCM16_B2S(size));
+  }
+  mixer.unlock();
+}
+
+static double mix_bench(unsigned int participants, unsigned int active_speakers,
+			AmAudioRtpFormat* rtp_fmt = NULL)
+{
+  AmMultiPartyMixer mixer;
+  mixer.setActiveSpeakers(active_speakers);
+
+  std::vector<unsigned int> ch;
+  for (unsigned int i=0; i<participants; i++)
+    ch.push_back(mixer.addChannel(MIX_RATE));
+
+  // warm up (buffers, speaker levels)
+  for (unsigned int t=0; t<10; t++)
+    mix_tick(mixer, ch, t, 3, NULL, rtp_fmt);
+
+  struct timeval start;
+  gettimeofday(&start, NULL);
+  for (unsigned int t=10; t<10+MIX_BENCH_TICKS; t++)
+    mix_tick(mixer, ch, t, 3, NULL, rtp_fmt);
+
+  return mix_elapsed_us(start) / MIX_BENCH_TICKS;
+}
+
+FCTMF_SUITE_BGN(test_mixer) {
+
+  FCT_TEST_BGN(kernels_bitexact) {
+    const char* names[] = { "sse2", "avx2", NULL };
+    const AmMixerKernels* ref = AmMixerKernels::get("scalar");
+    fct_chk(ref != NULL);
+    fct_chk(AmMixerKernels::get() != NULL);
+
+    srand(42);
+    for (unsigned int n=0; names[n]; n++) {
+      const AmMixerKernels* k = AmMixerKernels::get(names[n]);
+      if (!k) {
+	INFO("mixer kernels '%s' not supported here\n", names[n]);
+	continue;
+      }
+
+      for (unsigned int round=0; round<200; round++) {
+	unsigned int size = rand() % 330;
+	// large sums to exercise clipping
+	int range = (round % 4 == 0) ? 2000000 : 40000;
+
+	std::vector<int> src1(size), d_ref(size), d_k(size);
+	std::vector<short> src2(size), s_ref(size), s_k(size);
+	for (unsigned int i=0; i<size; i++) {
+	  src1[i] = (rand() % range) - range/2;
+	  src2[i] = (short)(rand() % 65536 - 32768);
+	}
+
+	ref->mix_add(d_ref.data(), src1.data(), src2.data(), size);
+	k->mix_add(d_k.data(), src1.data(), src2.data(), size);
+	fct_chk(d_ref == d_k);
+
+	ref->mix_sub(d_ref.data(), src1.data(), src2.data(), size);
+	k->mix_sub(d_k.data(), src1.data(), src2.data(), size);
+	fct_chk(d_ref == d_k);
+
+	int f = 1 + rand() % 64;
+	int f_ref = ref->scale(s_ref.data(), d_ref.data(), size, f);
+	int f_k = k->scale(s_k.data(), d_ref.data(), size, f);
+	fct_chk(f_ref == f_k);
+	fct_chk(s_ref == s_k);
+      }
+    }
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(active_speakers) {
+    AmMultiPartyMixer mixer;
+    mixer.setActiveSpeakers(2);
+
+    std::vector<unsigned int> ch;
+    for (unsigned int i=0; i<6; i++)
+      ch.push_back(mixer.addChannel(MIX_RATE));
+
+    std::vector<std::vector<short> > out(ch.size());
+    for (unsigned int t=0; t<20; t++)
+      mix_tick(mixer, ch, t, 2, &out);
+
+    // listeners share one frame, the two loud speakers hear each other
+    fct_chk(out[2] == out[3]);
+    fct_chk(out[2] == out[5]);
+    fct_chk(out[0] != out[2]);
+    fct_chk(out[0] != out[1]);
+
+    short other[MIX_FRAME];
+    mix_signal(other, 1, 19 - 1, true);  // mixer delay: one frame
+    int max_diff = 0;
+    for (unsigned int i=0; i<MIX_FRAME; i++) {
+      int d = abs(out[0][i] - other[i]);
+      if (d > max_diff) max_diff = d;
+    }
+    fct_chk(max_diff <= 1);
+  }
+  FCT_TEST_END();
+
+}
+FCTMF_SUITE_END();
+
+/* opt-in: SEMS_TEST_BENCH=1 */
+FCTMF_SUITE_BGN(bench_mixer) {
+
+  FCT_TEST_BGN(mixer_benchmark) {
+    int saved_log_level = log_level;
+    log_level = L_INFO;
+
+    // kernels alone: one mix-minus-self + scale per listener
+    const AmMixerKernels* ref = AmMixerKernels::get("scalar");
+    const AmMixerKernels* best = AmMixerKernels::get();
+    int mixed[MIX_FRAME];
+    short own[MIX_FRAME], out[MIX_FRAME];
+    for (unsigned int i=0; i<MIX_FRAME; i++) {
+      mixed[i] = (i * 37) % 20000 - 10000;
+      own[i] = (short)((i * 11) % 2000 - 1000);
+    }
+
+    const AmMixerKernels* ks[2] = { ref, best };
+    double k_us[2];
+    for (unsigned int k=0; k<2; k++) {
+      struct timeval start;
+      gettimeofday(&start, NULL);
+      for (unsigned int r=0; r<100000; r++) {
+	int tmp[MIX_FRAME];
+	ks[k]->mix_sub(tmp, mixed, own, MIX_FRAME);
+	ks[k]->scale(out, tmp, MIX_FRAME, 64);
+      }
+      k_us[k] = mix_elapsed_us(start);
+    }
+    INFO("mixer kernels, mix-minus + scale of 160 samples: "
+	 "scalar %.1f ns, %s %.1f ns\n",
+	 k_us[0] / 100, best->name, k_us[1] / 100);
+
+    // listeners' RTP format: a codec without encoder state
+    AmPlugIn::instance()->init();
+    Payload pl;
+    pl.pt = 96;
+    pl.name = "L16";
+    pl.clock_rate = pl.advertised_clock_rate = MIX_RATE;
+    pl.codec_id = CODEC_PCM16;
+    AmAudioRtpFormat rtp_fmt;
+    rtp_fmt.setCurrentPayload(pl);
+
+    unsigned int sizes[] = { 10, 100, 500 };
+    for (unsigned int s=0; s<3; s++) {
+      double all_us = mix_bench(sizes[s], 0);
+      double active_us = mix_bench(sizes[s], 3);
+      double all_enc_us = mix_bench(sizes[s], 0, &rtp_fmt);
+      double active_enc_us = mix_bench(sizes[s], 3, &rtp_fmt);
+      INFO("conference with %u participants: mix all %.0f us/frame "
+	   "(%.0f with G.711 encoding), 3 active speakers %.0f us/frame "
+	   "(%.0f with G.711 encoding)\n",
+	   sizes[s], all_us, all_enc_us, active_us, active_enc_us);
+    }
+
+    log_level = saved_log_level;
+  }
+  FCT_TEST_END();
+}
+FCTMF_SUITE_END();
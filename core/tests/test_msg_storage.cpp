@@ -0,0 +1,310 @@
+#include "fct.h"
+
+#include "log.h"
+
+#include "AmUtils.h"
+
+#include "../../apps/msg_storage/MsgIndex.h"
+#include "../../apps/msg_storage/MsgStorageAPI.h"
+
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <utime.h>
+
+// SEMS_TEST_MSG_USERS=10000 for the full size benchmark
+#define MSG_BENCH_USERS    100
+#define MSG_BENCH_MESSAGES 200
+
+/** temporary storage dir, removed by the destructor (two levels) */
+struct MsgTestDir
+{
+  string path;
+
+  MsgTestDir() {
+    char tmpl[] = "/tmp/sems_test_msg_XXXXXX";
+    if (mkdtemp(tmpl))
+      path = string(tmpl) + "/";
+  }
+  ~MsgTestDir() {
+    remove_dir(path);
+  }
+
+  static void remove_dir(const string& dir) {
+    DIR* dp = opendir(dir.c_str());
+    if (!dp)
+      return;
+    struct dirent* ep;
+    while ((ep = readdir(dp))) {
+      string n(ep->d_name);
+      if (n == "." || n == "..")
+	continue;
+      if (unlink((dir + n).c_str()))
+	remove_dir(dir + n + "/");
+    }
+    closedir(dp);
+    rmdir(dir.c_str());
+  }
+
+  string user(unsigned int i) {
+    string d = path + "user" + int2str(i) + "/";
+    mkdir(d.c_str(), 0700);
+    return d;
+  }
+};
+
+static void msg_write(const string& file, const string& data) {
+  FILE* fp = fopen(file.c_str(), "wb");
+  if (fp) {
+    fwrite(data.data(), 1, data.length(), fp);
+    fclose(fp);
+  }
+}
+
+/** counts as msg_storage got them without index */
+static void msg_scan_counts(const string& dir, unsigned int& new_msgs,
+			    unsigned int& saved_msgs) {
+  new_msgs = saved_msgs = 0;
+  DIR* dp = opendir(dir.c_str());
+  if (!dp)
+    return;
+  struct dirent* ep;
+  while ((ep = readdir(dp))) {
+    if (ep->d_name[0] == '.')
+      continue;
+    struct stat st;
+    if (stat((dir + ep->d_name).c_str(), &st) || !st.st_size)
+      continue;
+    if (st.st_atime == st.st_mtime)
+      new_msgs++;
+    else
+      saved_msgs++;
+  }
+  closedir(dp);
+}
+
+static double msg_elapsed_us(const struct timeval& start) {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return (now.tv_sec - start.tv_sec) * 1e6 + (now.tv_usec - start.tv_usec);
+}
+
+FCTMF_SUITE_BGN(test_msg_storage) {
+
+  FCT_TEST_BGN(index_built_from_dir_and_journaled) {
+    MsgTestDir dir;
+    fct_req(!dir.path.empty());
+    string u = dir.user(1);
+
+    // existing mailbox: one new, one read (atime), one empty
+    msg_write(u + "a.wav", "aaaa");
+    msg_write(u + "b.wav", "bb");
+    msg_write(u + "c.wav", "");
+    struct utimbuf tb;
+    tb.actime = tb.modtime = 1000;
+    utime((u + "a.wav").c_str(), &tb);
+    utime((u + "c.wav").c_str(), &tb);
+    tb.actime = 1001;
+    utime((u + "b.wav").c_str(), &tb);
+
+    MsgIndex idx(u);
+    fct_req(idx.load());
+    unsigned int n_new, n_saved;
+    idx.getCounts(n_new, n_saved);
+    fct_chk_eq_int(n_new, 1);
+    fct_chk_eq_int(n_saved, 1);
+    fct_chk_eq_int(idx.size(), 3);
+    fct_chk(idx.isCurrent());
+    fct_chk(access((u + MSG_INDEX_FILE).c_str(), F_OK) == 0);
+
+    // changes go to the journal
+    msg_write(u + "d.wav", "ddd");
+    fct_chk(idx.add("d.wav", 3, 1000) == MSG_OK);
+    fct_chk(idx.markRead("a.wav") == MSG_OK);
+    fct_chk(idx.remove("b.wav") == MSG_OK);
+    fct_chk(idx.remove("b.wav") == MSG_EMSGNOTFOUND);
+    fct_chk(idx.markRead("x.wav") == MSG_EMSGNOTFOUND);
+    fct_chk(idx.add(".hidden", 3, 1000) == MSG_ESTORAGE);
+    idx.getCounts(n_new, n_saved);
+    fct_chk_eq_int(n_new, 1);
+    fct_chk_eq_int(n_saved, 1);
+    fct_chk(idx.isCurrent());
+
+    // the index is not built again, and reads the same
+    unlink((u + "d.wav").c_str());
+    MsgIndex idx2(u);
+    fct_req(idx2.load());
+    AmArg l1, l2;
+    idx.list(l1);
+    idx2.list(l2);
+    fct_chk(l1 == l2);
+    fct_chk_eq_int(l2.size(), 3);
+    fct_chk(l2.get(0).get(0).asCStr() == string("a.wav"));
+    fct_chk_eq_int(l2.get(0).get(1).asInt(), 0);
+    fct_chk_eq_int(l2.get(0).get(2).asInt(), 4);
+    fct_chk(l2.get(2).get(0).asCStr() == string("d.wav"));
+    fct_chk_eq_int(l2.get(2).get(1).asInt(), 1);
+
+    // someone else writes: the first one sees it's not current
+    fct_chk(idx2.add("e.wav", 5, 1001) == MSG_OK);
+    fct_chk(!idx.isCurrent());
+    fct_req(idx.load());
+    fct_chk_eq_int(idx.size(), 4);
+
+    // a torn record at the end of the journal is dropped
+    int fd = open((u + MSG_JOURNAL_FILE).c_str(), O_WRONLY | O_APPEND);
+    fct_req(fd >= 0);
+    fct_chk(write(fd, "N 1 7 1002 f.w", 14) == 14);
+    close(fd);
+    MsgIndex idx3(u);
+    fct_req(idx3.load());
+    fct_chk_eq_int(idx3.size(), 4);
+    fct_chk(idx3.add("g.wav", 1, 1003) == MSG_OK);
+    MsgIndex idx4(u);
+    fct_req(idx4.load());
+    fct_chk_eq_int(idx4.size(), 5);
+
+    // no such user
+    MsgIndex none(dir.path + "nobody/");
+    fct_chk(!none.load());
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(index_journal_compacted) {
+    MsgTestDir dir;
+    fct_req(!dir.path.empty());
+    string u = dir.user(1);
+
+    MsgIndex idx(u);
+    fct_req(idx.load());
+    for (unsigned int i=0; i<1000; i++) {
+      string name = "m" + int2str(i % 10);
+      fct_chk(idx.add(name, 10, 1000 + i) == MSG_OK);
+      fct_chk(idx.markRead(name) == MSG_OK);
+    }
+    // journal was folded into the snapshot on the way
+    struct stat st;
+    fct_chk(!stat((u + MSG_JOURNAL_FILE).c_str(), &st) && st.st_size < 64 * 32);
+
+    MsgIndex idx2(u);
+    fct_req(idx2.load());
+    unsigned int n_new, n_saved;
+    idx2.getCounts(n_new, n_saved);
+    fct_chk_eq_int(n_new, 0);
+    fct_chk_eq_int(n_saved, 10);
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(index_cache_evicts_unused) {
+    MsgTestDir dir;
+    fct_req(!dir.path.empty());
+
+    MsgIndexCache cache(2);
+    fct_chk(cache.get(dir.path + "nobody/") == NULL);
+
+    MsgIndex* held = cache.get(dir.user(0));
+    fct_req(held != NULL);
+    for (unsigned int i=1; i<5; i++) {
+      MsgIndex* idx = cache.get(dir.user(i));
+      fct_req(idx != NULL);
+      fct_chk(idx->add("m", 1, 1) == MSG_OK);
+      cache.put(idx);
+    }
+    // still usable while held
+    fct_chk(held->add("m", 1, 1) == MSG_OK);
+    cache.put(held);
+
+    MsgIndex* idx = cache.get(dir.user(3));
+    fct_req(idx != NULL);
+    fct_chk_eq_int(idx->size(), 1);
+    cache.put(idx);
+  }
+  FCT_TEST_END();
+
+}
+FCTMF_SUITE_END();
+
+/* opt-in: SEMS_TEST_BENCH=1 */
+FCTMF_SUITE_BGN(bench_msg_storage) {
+
+  FCT_TEST_BGN(msg_storage_benchmark) {
+    int saved_log_level = log_level;
+    log_level = L_INFO;
+
+    unsigned int n_users = MSG_BENCH_USERS;
+    if (getenv("SEMS_TEST_MSG_USERS"))
+      n_users = atoi(getenv("SEMS_TEST_MSG_USERS"));
+
+    MsgTestDir dir;
+    fct_req(!dir.path.empty());
+    vector<string> users;
+    struct timeval start;
+    gettimeofday(&start, NULL);
+    for (unsigned int u=0; u<n_users; u++) {
+      users.push_back(dir.user(u));
+      MsgIndex idx(users.back());
+      idx.load();
+      for (unsigned int m=0; m<MSG_BENCH_MESSAGES; m++) {
+	string name = "msg" + int2str(m) + ".wav";
+	msg_write(users.back() + name, "RIFF");
+	idx.add(name, 4, 1000 + m);
+	// every other one read, also in the atime
+	if (m & 1)
+	  idx.markRead(name);
+	struct utimbuf tb;
+	tb.actime = (m & 1) ? 2 : 1;
+	tb.modtime = 1;
+	utime((users.back() + name).c_str(), &tb);
+      }
+    }
+    double create_ms = msg_elapsed_us(start) / 1000;
+
+    unsigned int n_new, n_saved, total_scan = 0, total_index = 0, total_cached = 0;
+    gettimeofday(&start, NULL);
+    for (unsigned int u=0; u<n_users; u++) {
+      msg_scan_counts(users[u], n_new, n_saved);
+      total_scan += n_new + 2 * n_saved;
+    }
+    double scan_us = msg_elapsed_us(start) / n_users;
+
+    // not cached: snapshot and journal read per login
+    gettimeofday(&start, NULL);
+    for (unsigned int u=0; u<n_users; u++) {
+      MsgIndex idx(users[u]);
+      idx.load();
+      idx.getCounts(n_new, n_saved);
+      total_index += n_new + 2 * n_saved;
+    }
+    double index_us = msg_elapsed_us(start) / n_users;
+
+    MsgIndexCache cache(n_users);
+    for (unsigned int u=0; u<n_users; u++)
+      cache.put(cache.get(users[u]));
+    gettimeofday(&start, NULL);
+    for (unsigned int u=0; u<n_users; u++) {
+      MsgIndex* idx = cache.get(users[u]);
+      fct_req(idx != NULL);
+      idx->getCounts(n_new, n_saved);
+      total_cached += n_new + 2 * n_saved;
+      cache.put(idx);
+    }
+    double cached_us = msg_elapsed_us(start) / n_users;
+
+    fct_chk_eq_int(total_scan, n_users * (MSG_BENCH_MESSAGES / 2) * 3);
+    fct_chk_eq_int(total_index, total_scan);
+    fct_chk_eq_int(total_cached, total_scan);
+
+    INFO("message counts, %u users x %u messages (created in %.0f ms): "
+	 "directory scan %.1f us/user, index %.1f us/user, "
+	 "cached index %.2f us/user\n", n_users, MSG_BENCH_MESSAGES, create_ms,
+	 scan_us, index_us, cached_us);
+
+    log_level = saved_log_level;
+  }
+  FCT_TEST_END();
+}
+FCTMF_SUITE_END();
@@ -0,0 +1,257 @@
+#include "fct.h"
+
+#include "log.h"
+
+#include "AmPromptCache.h"
+#include "AmCachedAudioFile.h"
+#include "AmRtpAudio.h"
+#include "AmPlugIn.h"
+#include "AmConfig.h"
+#include "AmUtils.h"
+#include "amci/codecs.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define PC_RATE    8000
+#define PC_SAMPLES 8000 // 1 s
+
+/* headerless 16 bit mono file format, so that no plug-in is needed */
+static int pc_mem_open(unsigned char* mptr, unsigned long size,
+		       unsigned long* pos, struct amci_file_desc_t* fmt_desc,
+		       int options, long h_codec)
+{
+  fmt_desc->subtype = 0;
+  fmt_desc->rate = PC_RATE;
+  fmt_desc->channels = 1;
+  fmt_desc->data_size = size;
+  *pos = 0;
+  return 0;
+}
+
+static amci_subtype_t pc_subtypes[] = {
+  { 0, "L16", PC_RATE, 1, CODEC_PCM16 },
+  { -1, 0, -1, -1, -1 }
+};
+
+static amci_inoutfmt_t pc_file_fmt = {
+  (char*)"pc_test", (char*)"pctest", (char*)"audio/x-test",
+  NULL, NULL, pc_mem_open, NULL, pc_subtypes
+};
+
+static bool pc_write_file(const string& name, unsigned int samples)
+{
+  FILE* fp = fopen(name.c_str(), "w");
+  if (!fp)
+    return false;
+  for (unsigned int i = 0; i < samples; i++) {
+    short s = (short)((i % 64) * 256);
+    fwrite(&s, sizeof(s), 1, fp);
+  }
+  fclose(fp);
+  return true;
+}
+
+static void pc_init_plugins()
+{
+  if (!AmPlugIn::instance()->codec(CODEC_PCM16))
+    AmPlugIn::instance()->init();
+  if (!AmPlugIn::instance()->fileFormat("pc_test"))
+    AmPlugIn::instance()->addFileFormat(&pc_file_fmt);
+}
+
+static void pc_set_format(AmAudioRtpFormat& rtp_fmt, const char* fmtp)
+{
+  Payload pl;
+  pl.pt = 96;
+  pl.name = "L16";
+  pl.clock_rate = pl.advertised_clock_rate = PC_RATE;
+  pl.codec_id = CODEC_PCM16;
+  rtp_fmt.setCurrentPayload(pl);
+  rtp_fmt.sdp_format_parameters = fmtp;
+}
+
+static bool pc_wait_ready(AmPromptFrames* f)
+{
+  for (int i = 0; i < 5000 && !f->ready; i++) // max 5s
+    usleep(1000);
+  return f->ready;
+}
+
+FCTMF_SUITE_BGN(test_prompt_cache) {
+
+  FCT_TEST_BGN(prompt_cache_hit_miss) {
+    pc_init_plugins();
+    string name = "/tmp/sems_test_prompt_hit.pctest";
+    fct_req(pc_write_file(name, PC_SAMPLES));
+
+    long long misses = AmPromptCache::misses.get();
+    long long hits = AmPromptCache::hits.get();
+
+    AmPromptCacheEntry* e1 = AmPromptCache::instance()->get(name);
+    fct_req(e1 != NULL);
+    fct_chk_eq_int(AmPromptCache::misses.get() - misses, 1);
+
+    AmPromptCacheEntry* e2 = AmPromptCache::instance()->get(name);
+    fct_chk(e2 == e1);
+    fct_chk_eq_int(AmPromptCache::hits.get() - hits, 1);
+
+    // changed on disk: loaded again, the old one stays valid
+    fct_req(pc_write_file(name, PC_SAMPLES / 2));
+    AmPromptCacheEntry* e3 = AmPromptCache::instance()->get(name);
+    fct_req(e3 != NULL);
+    fct_chk(e3 != e1);
+    fct_chk_eq_int(AmPromptCache::misses.get() - misses, 2);
+    fct_chk(e1->getFile()->getSize() == PC_SAMPLES * 2);
+    fct_chk(e3->getFile()->getSize() == PC_SAMPLES);
+
+    fct_chk(AmPromptCache::instance()->get("/tmp/sems_test_no_such.pctest") == NULL);
+
+    dec_ref(e1);
+    dec_ref(e2);
+    dec_ref(e3);
+    unlink(name.c_str());
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(prompt_cache_format_change) {
+    pc_init_plugins();
+    string name = "/tmp/sems_test_prompt_fmt.pctest";
+    fct_req(pc_write_file(name, PC_SAMPLES));
+
+    AmPromptCacheEntry* e = AmPromptCache::instance()->get(name);
+    fct_req(e != NULL);
+
+    AmAudioRtpFormat fmt_a;
+    pc_set_format(fmt_a, "");
+    AmPromptFrames* fa = e->getFrames(&fmt_a);
+    fct_req(fa != NULL);
+    fct_req(pc_wait_ready(fa));
+    fct_chk_eq_int(fa->src_frame_bytes, 2 * 160);
+    fct_chk_eq_int(fa->count(), PC_SAMPLES / 160);
+    fct_chk(fa->matches(&fmt_a));
+
+    // same format: same frames
+    fct_chk(e->getFrames(&fmt_a) == fa);
+
+    // other format: encoded again
+    AmAudioRtpFormat fmt_b;
+    pc_set_format(fmt_b, "test=1");
+    fct_chk(!fa->matches(&fmt_b));
+    AmPromptFrames* fb = e->getFrames(&fmt_b);
+    fct_req(fb != NULL);
+    fct_chk(fb != fa);
+    fct_req(pc_wait_ready(fb));
+    fct_chk_eq_int(fb->count(), PC_SAMPLES / 160);
+
+    // pre-encoded frames are sent once ready
+    AmCachedAudioFile player(e);
+    fct_req(player.is_good());
+    unsigned char buf[AUDIO_BUFFER_SIZE];
+    int len = player.getEncoded(0, buf, &fmt_a);
+    fct_chk_eq_int(len, 2 * 160);
+    fct_chk(!memcmp(buf, &fa->data[0], 2 * 160));
+
+    dec_ref(e);
+    unlink(name.c_str());
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(prompt_cache_evict) {
+    pc_init_plugins();
+    string names[4];
+    for (int i = 0; i < 4; i++) {
+      names[i] = "/tmp/sems_test_prompt_evict" + int2str(i) + ".pctest";
+      fct_req(pc_write_file(names[i], PC_SAMPLES));
+    }
+
+    // room for two files
+    unsigned long long saved_max = AmConfig::PromptCacheMaxMapped;
+    AmConfig::PromptCacheMaxMapped = 2 * PC_SAMPLES * 2;
+    AmPromptCache* pc = AmPromptCache::instance();
+
+    AmPromptCacheEntry* a = pc->get(names[0]);
+    AmPromptCacheEntry* b = pc->get(names[1]);
+    fct_req(a && b);
+    dec_ref(a);
+    dec_ref(b);
+    a = pc->get(names[0]); // b is now the least recently used
+    dec_ref(a);
+
+    long long evictions = AmPromptCache::evictions.get();
+    long long misses = AmPromptCache::misses.get();
+    AmPromptCacheEntry* c = pc->get(names[2]);
+    fct_req(c != NULL);
+    long long n = AmPromptCache::evictions.get() - evictions;
+    fct_chk_eq_int(n, 1);
+    long long mapped = AmPromptCache::mapped_bytes.get();
+    fct_chk_eq_int(mapped, 2 * PC_SAMPLES * 2);
+
+    a = pc->get(names[0]);
+    fct_req(a != NULL);
+    n = AmPromptCache::misses.get() - misses;
+    fct_chk_eq_int(n, 1); // only c
+
+    // files being played are kept, even above the limit
+    AmPromptCacheEntry* d = pc->get(names[3]);
+    fct_req(d != NULL);
+    n = AmPromptCache::evictions.get() - evictions;
+    fct_chk_eq_int(n, 1);
+    mapped = AmPromptCache::mapped_bytes.get();
+    fct_chk_eq_int(mapped, 3 * PC_SAMPLES * 2);
+    fct_chk_eq_int(pc->getSize(), 3);
+
+    dec_ref(a);
+    dec_ref(c);
+    dec_ref(d);
+
+    // dropped from the cache, the entry is freed once released
+    b = pc->get(names[1]);
+    fct_req(b != NULL);
+    n = AmPromptCache::evictions.get() - evictions;
+    fct_chk_eq_int(n, 3);
+    mapped = AmPromptCache::mapped_bytes.get();
+    fct_chk_eq_int(mapped, 2 * PC_SAMPLES * 2);
+    dec_ref(b);
+
+    AmConfig::PromptCacheMaxMapped = saved_max;
+    for (int i = 0; i < 4; i++)
+      unlink(names[i].c_str());
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(prompt_cache_limit) {
+    pc_init_plugins();
+    string name = "/tmp/sems_test_prompt_limit.pctest";
+    fct_req(pc_write_file(name, PC_SAMPLES));
+
+    unsigned long long saved_max = AmConfig::PromptCacheMaxEncoded;
+    AmConfig::PromptCacheMaxEncoded = 0;
+    long long skipped = AmPromptCache::encode_skipped.get();
+
+    AmPromptCacheEntry* e = AmPromptCache::instance()->get(name);
+    fct_req(e != NULL);
+    AmAudioRtpFormat fmt;
+    pc_set_format(fmt, "");
+    AmPromptFrames* f = e->getFrames(&fmt);
+    fct_req(f != NULL);
+    fct_req(pc_wait_ready(f));
+    // not encoded: played the normal way
+    fct_chk_eq_int(f->src_frame_bytes, 0);
+    fct_chk_eq_int(AmPromptCache::encode_skipped.get() - skipped, 1);
+
+    AmCachedAudioFile player(e);
+    unsigned char buf[AUDIO_BUFFER_SIZE];
+    int len = player.getEncoded(0, buf, &fmt);
+    fct_chk_eq_int(len, 0);
+
+    AmConfig::PromptCacheMaxEncoded = saved_max;
+    dec_ref(e);
+    unlink(name.c_str());
+
+    AmPromptCache::dispose();
+  }
+  FCT_TEST_END();
+}
+FCTMF_SUITE_END();
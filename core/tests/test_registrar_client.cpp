@@ -0,0 +1,419 @@
+#include "fct.h"
+
+#include "log.h"
+
+#include "AmEventDispatcher.h"
+#include "AmSipEvent.h"
+#include "AmThread.h"
+#include "AmUtils.h"
+
+#include "../../apps/registrar_client/RegClientShard.h"
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vector>
+using std::vector;
+
+// SEMS_TEST_REG_COUNT=100000 for the full size benchmark
+#define REGC_BENCH_COUNT   20000
+#define REGC_SHARDS        4
+#define REGC_TEST_COUNT    200
+#define REGC_TEST_EXPIRES  4
+#define REGC_LISTENER      "regclient-test-listener"
+
+/** a registration's event sink */
+struct RegClientTestListener
+  : public AmEventHandler,
+    public AmEventQueue
+{
+  unsigned int events[SIPRegistrationEvent::RegisterSendTimeout + 1];
+  /** queue entries, i.e. wakeups of the listener */
+  unsigned int posted;
+
+  RegClientTestListener()
+    : AmEventQueue(this), posted(0)
+  {
+    memset(events, 0, sizeof(events));
+    AmEventDispatcher::instance()->addEventQueue(REGC_LISTENER, this);
+  }
+
+  ~RegClientTestListener() {
+    AmEventDispatcher::instance()->delEventQueue(REGC_LISTENER);
+  }
+
+  void postEvent(AmEvent* ev) {
+    __sync_fetch_and_add(&posted, 1);
+    AmEventQueue::postEvent(ev);
+  }
+
+  void process(AmEvent* ev) {
+    SIPRegistrationEvent* reg_ev = dynamic_cast<SIPRegistrationEvent*>(ev);
+    if (reg_ev && reg_ev->event_id <= SIPRegistrationEvent::RegisterSendTimeout)
+      events[reg_ev->event_id]++;
+  }
+};
+
+/** where the registrations send their REGISTERs to */
+static int regc_trsp_fd = -1;
+
+/** sends the REGISTER to the stub registrar instead of the SIP stack */
+class RegClientTestRegistration
+  : public RegClientRegistration
+{
+ protected:
+  int sendRegisterRequest(const string& hdrs, int flags) {
+    string expires = getHeader(hdrs, "Expires");
+    char req[512];
+    int req_len =
+      snprintf(req, sizeof(req), "REGISTER sip:%s SIP/2.0\r\n"
+	       "From-Tag: %s\r\nUser: %s\r\nExpires: %s\r\nContact: <%s>\r\n\r\n",
+	       getInfo().domain.c_str(), getHandle().c_str(),
+	       getInfo().user.c_str(), expires.c_str(), getInfo().contact.c_str());
+    return send(regc_trsp_fd, req, req_len, 0) < 0 ? -1 : 0;
+  }
+
+ public:
+  RegClientTestRegistration(RegClientShard* shard, const string& handle,
+			    const SIPRegistrationInfo& info, const string& sess_link)
+    : RegClientRegistration(shard, handle, info, sess_link) { }
+
+  void onRxReply(const AmSipReply& reply) {
+    AmSipRequest req;
+    req.from_tag = getHandle();
+    onSipReply(req, reply, AmBasicSipDialog::Connected);
+  }
+};
+
+class RegClientTestShard
+  : public RegClientShard
+{
+ protected:
+  RegClientRegistration* newRegistration(const string& handle,
+					 const SIPRegistrationInfo& info,
+					 const string& sess_link) {
+    return new RegClientTestRegistration(this, handle, info, sess_link);
+  }
+
+ public:
+  RegClientTestShard(unsigned int id) : RegClientShard(id) { }
+};
+
+static string regc_line(const char* msg, const char* hdr) {
+  const char* p = strstr(msg, hdr);
+  if (!p)
+    return string();
+  p += strlen(hdr);
+  return string(p, strcspn(p, "\r\n"));
+}
+
+/**
+  Local stub registrar: answers REGISTERs with 200 OK and the contact
+  (expires at most max_expires), without contact for Expires: 0, users
+  "forbidden*" with 403.
+ */
+class RegClientStubRegistrar : public AmThread
+{
+  int fd;
+  unsigned int max_expires;
+
+protected:
+  void run() {
+    char buf[1024];
+    while (true) {
+      ssize_t len = recv(fd, buf, sizeof(buf) - 1, 0);
+      if (len <= 0)
+	break;
+      buf[len] = '\0';
+      if (!strncmp(buf, "STOP", 4)) {
+	// on to the transport
+	send(fd, buf, len, 0);
+	break;
+      }
+      __sync_fetch_and_add(&registers, 1);
+
+      string tag = regc_line(buf, "From-Tag: ");
+      string expires = regc_line(buf, "Expires: ");
+      char reply[512];
+      int reply_len;
+      if (!regc_line(buf, "User: ").compare(0, 9, "forbidden")) {
+	reply_len = snprintf(reply, sizeof(reply), "SIP/2.0 403 Forbidden\r\n"
+			     "From-Tag: %s\r\n\r\n", tag.c_str());
+      } else if (expires == "0") {
+	reply_len = snprintf(reply, sizeof(reply), "SIP/2.0 200 OK\r\n"
+			     "From-Tag: %s\r\n\r\n", tag.c_str());
+      } else {
+	unsigned int granted = atoi(expires.c_str());
+	if (granted > max_expires)
+	  granted = max_expires;
+	reply_len = snprintf(reply, sizeof(reply), "SIP/2.0 200 OK\r\n"
+			     "From-Tag: %s\r\nContact: %s;expires=%u\r\n\r\n",
+			     tag.c_str(), regc_line(buf, "Contact: ").c_str(),
+			     granted);
+      }
+      if (send(fd, reply, reply_len, 0) < 0)
+	break;
+    }
+  }
+  void on_stop() { }
+
+public:
+  unsigned int registers;
+
+  RegClientStubRegistrar(int fd, unsigned int max_expires)
+    : fd(fd), max_expires(max_expires), registers(0) { }
+};
+
+/** receives the replies, and routes them by from-tag as the SIP stack */
+class RegClientTestTransport : public AmThread
+{
+  int fd;
+
+protected:
+  void run() {
+    char buf[1024];
+    while (true) {
+      ssize_t len = recv(fd, buf, sizeof(buf) - 1, 0);
+      if (len <= 0)
+	break;
+      buf[len] = '\0';
+      if (!strncmp(buf, "STOP", 4))
+	break;
+
+      AmSipReply reply;
+      reply.code = atoi(buf + 8);
+      reply.reason = regc_line(buf, " ").substr(4);
+      reply.from_tag = regc_line(buf, "From-Tag: ");
+      reply.contact = regc_line(buf, "Contact: ");
+      AmSipReplyEvent* ev = new AmSipReplyEvent(reply);
+      if (!AmEventDispatcher::instance()->post(reply.from_tag, ev))
+	delete ev;
+    }
+  }
+  void on_stop() { }
+
+public:
+  RegClientTestTransport(int fd) : fd(fd) { }
+};
+
+/** shards, stub registrar and transport */
+struct RegClientTestSetup
+{
+  int sv[2];
+  vector<RegClientShard*> shards;
+  RegClientStubRegistrar* registrar;
+  RegClientTestTransport* transport;
+
+  RegClientTestSetup(unsigned int max_expires)
+    : registrar(NULL), transport(NULL) {
+    // unix datagrams are not lost when the receiver is behind
+    if (socketpair(AF_UNIX, SOCK_DGRAM, 0, sv))
+      return;
+    regc_trsp_fd = sv[0];
+    registrar = new RegClientStubRegistrar(sv[1], max_expires);
+    registrar->start();
+    transport = new RegClientTestTransport(sv[0]);
+    transport->start();
+    for (unsigned int i=0; i<REGC_SHARDS; i++) {
+      shards.push_back(new RegClientTestShard(i));
+      shards.back()->start();
+    }
+  }
+
+  ~RegClientTestSetup() {
+    for (size_t i=0; i<shards.size(); i++) {
+      shards[i]->stop_and_wait();
+      delete shards[i];
+    }
+    if (!registrar)
+      return;
+    send(sv[0], "STOP", 4, 0);
+    while (!registrar->is_stopped() || !transport->is_stopped())
+      usleep(10000);
+    delete registrar;
+    delete transport;
+    close(sv[0]);
+    close(sv[1]);
+    regc_trsp_fd = -1;
+  }
+
+  RegClientShard* shard(unsigned int i) { return shards[i % shards.size()]; }
+
+  void add(unsigned int i, const string& user, const string& handle) {
+    shard(i)->postEvent(new SIPNewRegistrationEvent(
+      SIPRegistrationInfo("registrar.example", user, user, user, "secret", "",
+			  "sip:" + user + "@127.0.0.1:5080"),
+      handle, REGC_LISTENER));
+  }
+
+  size_t size() {
+    size_t res = 0;
+    for (size_t i=0; i<shards.size(); i++)
+      res += shards[i]->size();
+    return res;
+  }
+};
+
+static string regc_handle(unsigned int i) {
+  return "regclient-test-" + int2str(i);
+}
+
+/** process the listener's events until events[ev_type] reaches count */
+static bool regc_wait(RegClientTestListener& listener, int ev_type,
+		      unsigned int count, unsigned int timeout_ms) {
+  for (unsigned int t=0; t<timeout_ms; t+=20) {
+    listener.processEvents();
+    if (listener.events[ev_type] >= count)
+      return true;
+    usleep(20000);
+  }
+  return false;
+}
+
+static double regc_elapsed_ms(const struct timeval& start) {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return (now.tv_sec - start.tv_sec) * 1e3 + (now.tv_usec - start.tv_usec) / 1e3;
+}
+
+FCTMF_SUITE_BGN(test_registrar_client) {
+
+  FCT_TEST_BGN(regclient_stub_registrar) {
+    int saved_log_level = log_level;
+    log_level = L_INFO;
+
+    RegClientTestListener listener;
+    RegClientTestSetup setup(REGC_TEST_EXPIRES);
+    fct_req(setup.registrar != NULL);
+
+    for (unsigned int i=0; i<REGC_TEST_COUNT; i++)
+      setup.add(i, "user" + int2str(i), regc_handle(i));
+    setup.add(0, "forbidden", "regclient-test-forbidden");
+
+    fct_chk(regc_wait(listener, SIPRegistrationEvent::RegisterSuccess,
+		      REGC_TEST_COUNT, 5000));
+    fct_chk(regc_wait(listener, SIPRegistrationEvent::RegisterFailed, 1, 1000));
+    fct_chk_eq_int(listener.events[SIPRegistrationEvent::RegisterSuccess],
+		   REGC_TEST_COUNT);
+    // batched: far fewer wakeups than events
+    fct_chk(listener.posted < REGC_TEST_COUNT / 2);
+
+    // failed ones are removed
+    fct_chk_eq_int(setup.size(), REGC_TEST_COUNT);
+    unsigned int state = 0, expires_left = 0;
+    fct_chk(!setup.shard(0)->getRegistrationState("regclient-test-forbidden",
+						  state, expires_left));
+    for (unsigned int i=0; i<REGC_TEST_COUNT; i++) {
+      fct_chk(setup.shard(i)->getRegistrationState(regc_handle(i),
+						   state, expires_left));
+      fct_chk_eq_int(state, AmSIPRegistration::RegisterActive);
+      fct_chk(expires_left <= REGC_TEST_EXPIRES);
+    }
+    AmArg list;
+    setup.shard(1)->listRegistrations(list);
+    fct_chk_eq_int(list.size(), REGC_TEST_COUNT / REGC_SHARDS);
+    fct_chk(list[0]["domain"].asCStr() == string("registrar.example"));
+
+    // refreshed after half the expires, none expired
+    fct_chk(regc_wait(listener, SIPRegistrationEvent::RegisterSuccess,
+		      2 * REGC_TEST_COUNT, 5000));
+    fct_chk(setup.registrar->registers >= 2 * REGC_TEST_COUNT + 1);
+    fct_chk_eq_int(listener.events[SIPRegistrationEvent::RegisterTimeout], 0);
+    fct_chk_eq_int(setup.size(), REGC_TEST_COUNT);
+
+    // de-registered and removed
+    for (unsigned int i=0; i<REGC_TEST_COUNT; i++)
+      setup.shard(i)->postEvent(new SIPRemoveRegistrationEvent(regc_handle(i)));
+    fct_chk(regc_wait(listener, SIPRegistrationEvent::RegisterNoContact,
+		      REGC_TEST_COUNT, 5000));
+    fct_chk_eq_int(setup.size(), 0);
+    fct_chk(!setup.shard(0)->hasRegistration(regc_handle(0)));
+
+    log_level = saved_log_level;
+  }
+  FCT_TEST_END();
+
+} FCTMF_SUITE_END();
+
+/* opt-in: SEMS_TEST_BENCH=1 */
+FCTMF_SUITE_BGN(bench_registrar_client) {
+
+  FCT_TEST_BGN(registrar_client_benchmark) {
+    int saved_log_level = log_level;
+    log_level = L_INFO;
+
+    unsigned int n_regs = REGC_BENCH_COUNT;
+    if (getenv("SEMS_TEST_REG_COUNT"))
+      n_regs = atol(getenv("SEMS_TEST_REG_COUNT"));
+
+    // the timer wheel alone, refreshes of 3600s registrations
+    {
+      vector<AmWheelTimer> timers(n_regs);
+      vector<AmWheelTimer*> fired;
+      AmTimerWheel wheel(0, REG_CLIENT_WHEEL_SLOTS);
+      struct timeval start;
+      gettimeofday(&start, NULL);
+      for (unsigned int i=0; i<n_regs; i++)
+	wheel.schedule(&timers[i], 1 + (i * 7919UL) % 1800);
+      double schedule_ms = regc_elapsed_ms(start);
+      gettimeofday(&start, NULL);
+      for (unsigned int i=0; i<n_regs; i++)
+	wheel.schedule(&timers[i], 1800 + (i * 7919UL) % 1800);
+      double reschedule_ms = regc_elapsed_ms(start);
+      gettimeofday(&start, NULL);
+      for (time_t t=1; t<=3600; t++)
+	wheel.expire(t, fired);
+      double expire_ms = regc_elapsed_ms(start);
+      fct_chk_eq_int(fired.size(), n_regs);
+      INFO("registrar_client timer wheel, %u timers: schedule %.3f us, "
+	   "reschedule %.3f us, %.1f ms for 3600 s of expire\n", n_regs,
+	   schedule_ms * 1e3 / n_regs, reschedule_ms * 1e3 / n_regs, expire_ms);
+    }
+
+    RegClientTestListener listener;
+    RegClientTestSetup setup(3600);
+    fct_req(setup.registrar != NULL);
+
+    struct timeval start;
+    gettimeofday(&start, NULL);
+    for (unsigned int i=0; i<n_regs; i++)
+      setup.add(i, "bench" + int2str(i), regc_handle(i));
+    fct_chk(regc_wait(listener, SIPRegistrationEvent::RegisterSuccess,
+		      n_regs, 60000));
+    double register_ms = regc_elapsed_ms(start);
+    fct_chk_eq_int(setup.size(), n_regs);
+    unsigned int posted = listener.posted;
+
+    // status of registrations meanwhile
+    gettimeofday(&start, NULL);
+    unsigned int state = 0, expires_left = 0, active = 0;
+    for (unsigned int i=0; i<n_regs; i++)
+      if (setup.shard(i)->getRegistrationState(regc_handle(i), state, expires_left) &&
+	  state == AmSIPRegistration::RegisterActive)
+	active++;
+    double state_ms = regc_elapsed_ms(start);
+    fct_chk_eq_int(active, n_regs);
+
+    gettimeofday(&start, NULL);
+    for (unsigned int i=0; i<n_regs; i++)
+      setup.shard(i)->postEvent(new SIPRemoveRegistrationEvent(regc_handle(i)));
+    fct_chk(regc_wait(listener, SIPRegistrationEvent::RegisterNoContact,
+		      n_regs, 60000));
+    double unregister_ms = regc_elapsed_ms(start);
+    fct_chk_eq_int(setup.size(), 0);
+
+    INFO("registrar_client, %u registrations in %d shards: registered in %.0f ms "
+	 "(%.0f/s), listener woken %u times; getRegistrationState %.2f us; "
+	 "de-registered in %.0f ms\n", n_regs, REGC_SHARDS, register_ms,
+	 n_regs * 1e3 / register_ms, posted, state_ms * 1e3 / n_regs,
+	 unregister_ms);
+
+    log_level = saved_log_level;
+  }
+  FCT_TEST_END();
+
+} FCTMF_SUITE_END();
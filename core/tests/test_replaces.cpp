@@ -21,6 +21,34 @@ FCTMF_SUITE_BGN(test_replaces) {
   }
   FCT_TEST_END();
 
+  FCT_TEST_BGN(registry_list) {
+    unsigned int size = SBCCallRegistry::getSize();
+    SBCCallRegistry::addCall("l1", SBCCallRegistryEntry("c2", "l2", "r2"));
+    SBCCallRegistry::addCall("l2", SBCCallRegistryEntry("c1", "l1", "r1"));
+    SBCCallRegistry::addCall("l2", SBCCallRegistryEntry("c1", "l1", "r1"));
+    SBCCallRegistry::updateCall("l2", "r1x");
+    fct_chk(SBCCallRegistry::getSize() == size + 2);
+
+    AmArg calls;
+    SBCCallRegistry::listCalls(calls);
+    fct_chk(calls.size() == size + 2);
+    bool found = false;
+    for (size_t i=0; i<calls.size(); i++) {
+      if (calls[i]["ltag"].asCStr() == string("l2")) {
+        found = true;
+        fct_chk(calls[i]["other_rtag"].asCStr() == string("r1x"));
+        fct_chk(calls[i]["other_callid"].asCStr() == string("c1"));
+      }
+    }
+    fct_chk(found);
+
+    SBCCallRegistry::removeCall("l1");
+    SBCCallRegistry::removeCall("l2");
+    SBCCallRegistry::removeCall("l2");
+    fct_chk(SBCCallRegistry::getSize() == size);
+  }
+  FCT_TEST_END();
+
   FCT_TEST_BGN(replaces_fixup_invite) {
     SBCCallRegistryEntry e = SBCCallRegistryEntry("C2", "C2f", "C2t");
     SBCCallRegistry::addCall("Ct", e);
@@ -0,0 +1,242 @@
+#include "fct.h"
+
+#include "log.h"
+
+#include "AmPolyphaseResampler.h"
+#include "AmAudio.h"
+
+#include <sys/time.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#define RS_BENCH_FRAMES 5000   // 100 sec of audio
+
+struct rs_rates { unsigned int in; unsigned int out; };
+
+static const rs_rates rs_pairs[] = {
+  { 8000, 16000 }, { 16000, 8000 },
+  { 8000, 48000 }, { 48000, 8000 },
+  { 16000, 48000 }, { 48000, 16000 },
+  { 8000, 32000 }, { 32000, 8000 },
+  { 16000, 32000 }, { 32000, 16000 },
+  { 32000, 48000 }, { 48000, 32000 }
+};
+
+#define RS_PAIRS (sizeof(rs_pairs) / sizeof(rs_pairs[0]))
+
+static double rs_elapsed_us(const struct timeval& start)
+{
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return (now.tv_sec - start.tv_sec) * 1e6 + (now.tv_usec - start.tv_usec);
+}
+
+static void rs_sine(std::vector<short>& buf, unsigned int rate, double freq,
+		    double amp, unsigned int samples)
+{
+  buf.resize(samples);
+  for (unsigned int i=0; i<samples; i++)
+    buf[i] = (short)lrint(amp * sin(2.0 * M_PI * freq * i / rate));
+}
+
+/** SNR of a sine of freq in buf (after skip samples), phase and gain fitted */
+static double rs_snr(const std::vector<short>& buf, unsigned int skip,
+		     unsigned int rate, double freq)
+{
+  // an integer number of periods for the fit
+  unsigned int period = rate / (unsigned int)freq;
+  unsigned int n = (buf.size() - skip) / period * period;
+
+  double s = 0, c = 0, dc = 0;
+  for (unsigned int i=0; i<n; i++) {
+    double w = 2.0 * M_PI * freq * (skip + i) / rate;
+    s += buf[skip + i] * sin(w);
+    c += buf[skip + i] * cos(w);
+    dc += buf[skip + i];
+  }
+  s = 2 * s / n; c = 2 * c / n; dc /= n;
+
+  double sig = 0, noise = 0;
+  for (unsigned int i=0; i<n; i++) {
+    double w = 2.0 * M_PI * freq * (skip + i) / rate;
+    double fit = s * sin(w) + c * cos(w) + dc;
+    sig += fit * fit;
+    noise += (buf[skip + i] - fit) * (buf[skip + i] - fit);
+  }
+  return 10.0 * log10(sig / (noise > 0 ? noise : 1e-9));
+}
+
+static double rs_rms(const std::vector<short>& buf, unsigned int skip)
+{
+  double sum = 0;
+  for (unsigned int i=skip; i<buf.size(); i++)
+    sum += (double)buf[i] * buf[i];
+  return sqrt(sum / (buf.size() - skip));
+}
+
+/** resample in 20ms frames */
+static void rs_run(AmPolyphaseResampler* rs, const rs_rates& r,
+		   const std::vector<short>& in, std::vector<short>& out)
+{
+  unsigned int in_frame = r.in / 50;
+  short buf[AUDIO_BUFFER_SIZE/2];
+  out.clear();
+  for (unsigned int i=0; i + in_frame <= in.size(); i += in_frame) {
+    unsigned int n = rs->resample(&in[i], in_frame, buf, AUDIO_BUFFER_SIZE/2);
+    out.insert(out.end(), buf, buf + n);
+  }
+}
+
+#ifdef USE_INTERNAL_RESAMPLER
+static void rs_run_internal(AmInternalResamplerState& rs, const rs_rates& r,
+			    const std::vector<short>& in, std::vector<short>& out)
+{
+  unsigned int in_frame = r.in / 50;
+  unsigned char buf[AUDIO_BUFFER_SIZE];
+  out.clear();
+  for (unsigned int i=0; i + in_frame <= in.size(); i += in_frame) {
+    memcpy(buf, &in[i], PCM16_S2B(in_frame));
+    unsigned int n = rs.resample(buf, PCM16_S2B(in_frame), (double)r.out / r.in);
+    out.insert(out.end(), (short*)buf, (short*)buf + PCM16_B2S(n));
+  }
+}
+#endif
+
+FCTMF_SUITE_BGN(test_resampler) {
+
+  FCT_TEST_BGN(kernels_bitexact) {
+    const char* names[] = { "sse2", "avx2", NULL };
+    std::vector<short> in(48000);
+    srand(7);
+    for (unsigned int i=0; i<in.size(); i++)
+      in[i] = (short)(rand() % 65536 - 32768);
+
+    for (unsigned int p=0; p<RS_PAIRS; p++) {
+      double ratio = (double)rs_pairs[p].out / rs_pairs[p].in;
+      AmPolyphaseResampler* ref = AmPolyphaseResampler::create(ratio, "scalar");
+      fct_chk(ref != NULL);
+      if (!ref) continue;
+
+      std::vector<short> out_ref;
+      rs_run(ref, rs_pairs[p], in, out_ref);
+      fct_chk(out_ref.size() ==
+	      in.size() / (rs_pairs[p].in / 50) * (rs_pairs[p].out / 50));
+
+      for (unsigned int k=0; names[k]; k++) {
+	AmPolyphaseResampler* rs = AmPolyphaseResampler::create(ratio, names[k]);
+	if (!rs) continue; // not supported by this CPU
+	std::vector<short> out;
+	rs_run(rs, rs_pairs[p], in, out);
+	fct_chk(out == out_ref);
+	delete rs;
+      }
+      delete ref;
+    }
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(frame_continuity) {
+    // the same output, whether resampled in one block or frame by frame
+    for (unsigned int p=0; p<RS_PAIRS; p++) {
+      double ratio = (double)rs_pairs[p].out / rs_pairs[p].in;
+      std::vector<short> in;
+      rs_sine(in, rs_pairs[p].in, 700.0, 12000.0, rs_pairs[p].in / 5);
+
+      AmPolyphaseResampler* block = AmPolyphaseResampler::create(ratio);
+      AmPolyphaseResampler* frames = AmPolyphaseResampler::create(ratio);
+
+      std::vector<short> out_block(in.size() * 6);
+      out_block.resize(block->resample(&in[0], in.size(), &out_block[0],
+				       out_block.size()));
+      std::vector<short> out_frames;
+      rs_run(frames, rs_pairs[p], in, out_frames);
+
+      fct_chk(out_block == out_frames);
+      delete block;
+      delete frames;
+    }
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(quality) {
+    for (unsigned int p=0; p<RS_PAIRS; p++) {
+      const rs_rates& r = rs_pairs[p];
+      AmPolyphaseResampler* rs = AmPolyphaseResampler::create((double)r.out / r.in);
+
+      // passband: 1 kHz
+      std::vector<short> in, out;
+      rs_sine(in, r.in, 1000.0, 10000.0, r.in);
+      rs_run(rs, r, in, out);
+      double snr = rs_snr(out, r.out / 20, r.out, 1000.0);
+      fct_chk(snr > 70.0);
+
+      // stopband: a tone above the output's Nyquist frequency
+      if (r.in > r.out) {
+	rs->reset();
+	double f = (r.out / 2 + r.in / 2) / 2.0;
+	rs_sine(in, r.in, f, 10000.0, r.in);
+	rs_run(rs, r, in, out);
+	double att = 20.0 * log10(rs_rms(out, r.out / 20) / (10000.0 / sqrt(2.0)));
+	fct_chk(att < -60.0);
+      }
+      delete rs;
+    }
+  }
+  FCT_TEST_END();
+
+}
+FCTMF_SUITE_END();
+
+/* opt-in: SEMS_TEST_BENCH=1 */
+FCTMF_SUITE_BGN(bench_resampler) {
+
+  FCT_TEST_BGN(resampler_benchmark) {
+    int saved_log_level = log_level;
+    log_level = L_INFO;
+
+    for (unsigned int p=0; p<RS_PAIRS; p++) {
+      const rs_rates& r = rs_pairs[p];
+      double ratio = (double)r.out / r.in;
+      std::vector<short> in, out;
+      rs_sine(in, r.in, 1000.0, 10000.0, r.in / 50 * RS_BENCH_FRAMES);
+
+      AmPolyphaseResampler* scalar = AmPolyphaseResampler::create(ratio, "scalar");
+      AmPolyphaseResampler* best = AmPolyphaseResampler::create(ratio);
+
+      struct timeval start;
+      gettimeofday(&start, NULL);
+      rs_run(scalar, r, in, out);
+      double scalar_us = rs_elapsed_us(start);
+
+      gettimeofday(&start, NULL);
+      rs_run(best, r, in, out);
+      double best_us = rs_elapsed_us(start);
+      double snr = rs_snr(out, r.out / 20, r.out, 1000.0);
+
+      double internal_us = 0, internal_snr = 0;
+#ifdef USE_INTERNAL_RESAMPLER
+      AmInternalResamplerState internal;
+      gettimeofday(&start, NULL);
+      rs_run_internal(internal, r, in, out);
+      internal_us = rs_elapsed_us(start);
+      internal_snr = rs_snr(out, r.out / 20, r.out, 1000.0);
+#endif
+
+      INFO("resample %u -> %u Hz (%u taps): polyphase scalar %.0f ns/frame, "
+	   "%s %.0f ns/frame, SNR %.1f dB; internal %.0f ns/frame, SNR %.1f dB\n",
+	   r.in, r.out, best->taps(),
+	   scalar_us * 1000 / RS_BENCH_FRAMES, best->kernelName(),
+	   best_us * 1000 / RS_BENCH_FRAMES, snr,
+	   internal_us * 1000 / RS_BENCH_FRAMES, internal_snr);
+
+      delete scalar;
+      delete best;
+    }
+
+    log_level = saved_log_level;
+  }
+  FCT_TEST_END();
+}
+FCTMF_SUITE_END();
@@ -0,0 +1,315 @@
+#include "fct.h"
+
+#include "log.h"
+
+#include "AmRtpReceiveBuffer.h"
+#include "AmThread.h"
+#include "SampleArray.h"
+
+#include <sys/time.h>
+#include <sched.h>
+#include <map>
+#include <vector>
+
+#define RB_BENCH_PACKETS 1000000
+
+static double rb_elapsed_us(const struct timeval& start)
+{
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return (now.tv_sec - start.tv_sec) * 1e6 + (now.tv_usec - start.tv_usec);
+}
+
+static AmRtpPacket* rb_put(AmRtpReceiveBuffer& buf, unsigned int seq,
+			   bool event = false, unsigned int ssrc = 1)
+{
+  AmRtpPacket* p = buf.newPacket();
+  if (!p) p = buf.reusePacket();
+  if (!p) return NULL;
+  p->ssrc = ssrc;
+  p->sequence = seq;
+  p->timestamp = seq * 160;
+  bool queued = event ? buf.putEvent(p) : buf.putPacket(p);
+  if (!queued) {
+    buf.freePacket(p);
+    return NULL;
+  }
+  return p;
+}
+
+/** pops everything; the sequence numbers (events + 100000) */
+static std::vector<int> rb_pop_all(AmRtpReceiveBuffer& buf,
+				   const std::vector<AmRtpPacket*>& events
+				   = std::vector<AmRtpPacket*>())
+{
+  std::vector<int> seqs;
+  AmRtpPacket* p;
+  while ((p = buf.pop()) != NULL) {
+    bool is_event = false;
+    for (size_t i=0; i<events.size(); i++)
+      if (events[i] == p) is_event = true;
+    seqs.push_back(p->sequence + (is_event ? 100000 : 0));
+    buf.release(p);
+  }
+  return seqs;
+}
+
+static std::vector<int> rb_seqs(int first, int n)
+{
+  std::vector<int> v;
+  for (int i=0; i<n; i++)
+    v.push_back((first + i) & 0xFFFF);
+  return v;
+}
+
+/** the former receive buffer, for the benchmark */
+struct RbMapBuffer
+{
+  std::map<unsigned int, AmRtpPacket*, ts_less> buf;
+  AmMutex mut;
+
+  void put(AmRtpPacket* p) {
+    mut.lock();
+    buf.insert(std::make_pair(p->timestamp, p));
+    mut.unlock();
+  }
+  AmRtpPacket* pop() {
+    AmRtpPacket* p = NULL;
+    mut.lock();
+    if (!buf.empty()) {
+      p = buf.begin()->second;
+      buf.erase(buf.begin());
+    }
+    mut.unlock();
+    return p;
+  }
+};
+
+/** RTP receiver thread: sends n packets in sequence */
+class RbProducer : public AmThread
+{
+  AmRtpReceiveBuffer& buf;
+  unsigned int n;
+
+public:
+  RbProducer(AmRtpReceiveBuffer& buf, unsigned int n) : buf(buf), n(n) { }
+
+  void run() {
+    for (unsigned int i=0; i<n; ) {
+      AmRtpPacket* p = buf.newPacket();
+      if (!p) {
+	sched_yield(); // wait for the consumer instead of reusing
+	continue;
+      }
+      p->ssrc = 1;
+      p->sequence = i & 0xFFFF;
+      p->timestamp = i * 160;
+      if (!buf.putPacket(p))
+	buf.freePacket(p);
+      i++;
+    }
+  }
+  void on_stop() { }
+};
+
+FCTMF_SUITE_BGN(test_rtp_buffer) {
+
+  FCT_TEST_BGN(reorder_and_duplicates) {
+    AmRtpReceiveBuffer buf;
+    fct_chk(buf.pop() == NULL);
+
+    rb_put(buf, 102); rb_put(buf, 100); rb_put(buf, 101);
+    fct_chk(rb_put(buf, 101) == NULL); // duplicate
+    fct_chk(rb_pop_all(buf) == rb_seqs(100, 3));
+
+    // 104 lost, 103 late: still delivered
+    rb_put(buf, 105); rb_put(buf, 106);
+    fct_chk(rb_pop_all(buf) == rb_seqs(105, 2));
+    fct_chk(rb_put(buf, 103) != NULL);
+    rb_put(buf, 107);
+    std::vector<int> expect;
+    expect.push_back(103); expect.push_back(107);
+    fct_chk(rb_pop_all(buf) == expect);
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(reorder_across_pops) {
+    // n+1 arrives and is popped before n
+    AmRtpReceiveBuffer buf;
+    rb_put(buf, 199);
+    fct_chk(rb_pop_all(buf) == rb_seqs(199, 1));
+    rb_put(buf, 201);
+    fct_chk(rb_pop_all(buf) == rb_seqs(201, 1));
+    fct_chk(rb_put(buf, 200) != NULL);
+    fct_chk(rb_pop_all(buf) == rb_seqs(200, 1));
+    rb_put(buf, 202);
+    fct_chk(rb_pop_all(buf) == rb_seqs(202, 1));
+
+    // a bounded number of late packets
+    for (int i=0; i<RECV_LATE_SLOTS; i++)
+      fct_chk(rb_put(buf, 180 + i) != NULL);
+    fct_chk(rb_put(buf, 179) == NULL);
+    fct_chk(rb_pop_all(buf) == rb_seqs(180, RECV_LATE_SLOTS));
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(new_ssrc) {
+    AmRtpReceiveBuffer buf;
+    rb_put(buf, 5000); rb_put(buf, 5001);
+    fct_chk(rb_pop_all(buf) == rb_seqs(5000, 2));
+    rb_put(buf, 5003); rb_put(buf, 5004); // not popped
+
+    // a new source starting just behind the tail is not late,
+    // the rest of the old one is dropped
+    rb_put(buf, 4990, false, 2);
+    rb_put(buf, 4991, false, 2);
+    fct_chk(rb_pop_all(buf) == rb_seqs(4990, 2));
+    rb_put(buf, 4992, false, 2);
+    fct_chk(rb_pop_all(buf) == rb_seqs(4992, 1));
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(wrap_and_jump) {
+    AmRtpReceiveBuffer buf;
+    for (int i=0; i<10; i++)
+      rb_put(buf, (65530 + i) & 0xFFFF);
+    fct_chk(rb_pop_all(buf) == rb_seqs(65530, 10));
+
+    // the sender jumps ahead
+    rb_put(buf, 30000); rb_put(buf, 30001);
+    fct_chk(rb_pop_all(buf) == rb_seqs(30000, 2));
+
+    // and restarts with a lower sequence number
+    rb_put(buf, 1000); rb_put(buf, 1001);
+    fct_chk(rb_pop_all(buf) == rb_seqs(1000, 2));
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(events_first) {
+    AmRtpReceiveBuffer buf;
+    std::vector<AmRtpPacket*> events;
+    rb_put(buf, 10);
+    events.push_back(rb_put(buf, 11, true));
+    rb_put(buf, 12);
+    events.push_back(rb_put(buf, 13, true));
+
+    std::vector<int> expect;
+    expect.push_back(100011); expect.push_back(100013);
+    expect.push_back(10); expect.push_back(12);
+    fct_chk(rb_pop_all(buf, events) == expect);
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(pool_and_clear) {
+    AmRtpReceiveBuffer buf;
+    // the consumer does not run: the oldest buffered packets are reused
+    for (int i=0; i<MAX_PACKETS + 8; i++)
+      fct_chk(rb_put(buf, 500 + i) != NULL);
+    std::vector<int> seqs = rb_pop_all(buf);
+    fct_chk(seqs == rb_seqs(508, MAX_PACKETS));
+
+    // everything went back to the pool
+    for (int i=0; i<MAX_PACKETS; i++)
+      fct_chk(rb_put(buf, 600 + i) != NULL);
+    buf.clear();
+    fct_chk(buf.pop() == NULL);
+    for (int i=0; i<MAX_PACKETS; i++) {
+      AmRtpPacket* p = buf.newPacket();
+      fct_chk(p != NULL);
+      buf.freePacket(p);
+    }
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(two_threads) {
+    // all packets, in order, from a receiver thread to this one
+    const unsigned int n = 200000;
+    AmRtpReceiveBuffer buf;
+    RbProducer producer(buf, n);
+    producer.start();
+
+    unsigned int received = 0;
+    bool in_order = true;
+    while (received < n) {
+      AmRtpPacket* p = buf.pop();
+      if (!p) {
+	sched_yield();
+	continue;
+      }
+      if (p->sequence != (received & 0xFFFF))
+	in_order = false;
+      received++;
+      buf.release(p);
+    }
+    producer.join();
+
+    fct_chk(in_order);
+    fct_chk(received == n);
+  }
+  FCT_TEST_END();
+
+}
+FCTMF_SUITE_END();
+
+/* opt-in: SEMS_TEST_BENCH=1 */
+FCTMF_SUITE_BGN(bench_rtp_buffer) {
+
+  FCT_TEST_BGN(rtp_buffer_benchmark) {
+    int saved_log_level = log_level;
+    log_level = L_INFO;
+
+    // put and pop one packet after another, as with a 20 ms packet
+    // and a media tick
+    std::vector<AmRtpPacket> mem(2);
+    struct timeval start;
+
+    RbMapBuffer map_buf;
+    gettimeofday(&start, NULL);
+    for (unsigned int i=0; i<RB_BENCH_PACKETS; i++) {
+      AmRtpPacket* p = &mem[i & 1];
+      p->sequence = i & 0xFFFF;
+      p->timestamp = i * 160;
+      map_buf.put(p);
+      if (map_buf.pop() != p)
+	break;
+    }
+    double map_us = rb_elapsed_us(start);
+
+    AmRtpReceiveBuffer ring_buf;
+    gettimeofday(&start, NULL);
+    for (unsigned int i=0; i<RB_BENCH_PACKETS; i++) {
+      AmRtpPacket* p = ring_buf.newPacket();
+      p->sequence = i & 0xFFFF;
+      p->timestamp = i * 160;
+      ring_buf.putPacket(p);
+      ring_buf.release(ring_buf.pop());
+    }
+    double ring_us = rb_elapsed_us(start);
+
+    AmRtpReceiveBuffer thread_buf;
+    RbProducer producer(thread_buf, RB_BENCH_PACKETS);
+    gettimeofday(&start, NULL);
+    producer.start();
+    unsigned int received = 0;
+    while (received < RB_BENCH_PACKETS) {
+      AmRtpPacket* p = thread_buf.pop();
+      if (!p) {
+	sched_yield();
+	continue;
+      }
+      received++;
+      thread_buf.release(p);
+    }
+    producer.join();
+    double thread_us = rb_elapsed_us(start);
+
+    INFO("RTP receive buffer, %u packets: map+mutex %.1f ns/packet, "
+	 "ring %.1f ns/packet, ring across threads %.1f ns/packet\n",
+	 RB_BENCH_PACKETS, map_us * 1000 / RB_BENCH_PACKETS,
+	 ring_us * 1000 / RB_BENCH_PACKETS, thread_us * 1000 / RB_BENCH_PACKETS);
+
+    log_level = saved_log_level;
+  }
+  FCT_TEST_END();
+}
+FCTMF_SUITE_END();
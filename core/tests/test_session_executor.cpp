@@ -0,0 +1,193 @@
+#include "fct.h"
+
+#include "log.h"
+
+#include "AmSession.h"
+#include "AmSessionExecutor.h"
+#include "AmConfig.h"
+#include "atomic_types.h"
+
+#include <sys/time.h>
+#include <unistd.h>
+#include <vector>
+#include <algorithm>
+
+#ifndef SESSION_THREADPOOL
+
+/* sessions for the functional test */
+#define SE_TEST_SESSIONS 200
+
+/* concurrent sessions on the executor */
+#define SE_BENCH_SESSIONS 10000
+/* thread-per-session reference (1 MB stack each) */
+#define SE_BENCH_THREAD_SESSIONS 1000
+
+#define SE_BENCH_EVENT 4242
+
+static atomic_int se_started;
+static atomic_int se_processed;
+static atomic_int se_destroyed;
+
+static unsigned long long se_now_us() {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return now.tv_sec * 1000000ULL + now.tv_usec;
+}
+
+/** session that only records when it is started and when it gets events */
+class ExecTestSession : public AmSession
+{
+public:
+  unsigned long long t_start;
+  unsigned long long setup_us;
+  unsigned long long t_event;
+  unsigned long long event_us;
+
+  ExecTestSession()
+    : t_start(0), setup_us(0), t_event(0), event_us(0) { }
+
+  void onStart() {
+    setup_us = se_now_us() - t_start;
+    se_started.inc();
+  }
+
+  void process(AmEvent* ev) {
+    if (ev->event_id == SE_BENCH_EVENT) {
+      event_us = se_now_us() - t_event;
+      se_processed.inc();
+      return;
+    }
+    // wakeup
+  }
+
+  // not registered in the session container
+  void destroy() {
+    se_destroyed.inc();
+  }
+};
+
+static bool se_wait_for(atomic_int& cnt, unsigned int n) {
+  for (int i=0; i<30000 && cnt.get() < n; i++) // max 30s
+    usleep(1000);
+  return cnt.get() == n;
+}
+
+static void se_report(const char* what, std::vector<unsigned long long>& lat) {
+  std::sort(lat.begin(), lat.end());
+  unsigned long long sum = 0;
+  for (size_t i=0; i<lat.size(); i++)
+    sum += lat[i];
+  INFO("%s: %zd sessions, latency avg %llu us, p50 %llu us, p99 %llu us, max %llu us\n",
+       what, lat.size(), sum / lat.size(), lat[lat.size() / 2],
+       lat[lat.size() * 99 / 100], lat.back());
+}
+
+/**
+ * start n sessions (all alive at the same time), post one event to
+ * each, then stop them; report start->onStart and post->process latency
+ */
+static bool se_run(const char* mode, unsigned int n) {
+  se_started.set(0);
+  se_processed.set(0);
+  se_destroyed.set(0);
+
+  std::vector<ExecTestSession*> sessions;
+  for (unsigned int i=0; i<n; i++)
+    sessions.push_back(new ExecTestSession());
+
+  for (unsigned int i=0; i<n; i++) {
+    sessions[i]->t_start = se_now_us();
+    sessions[i]->start();
+  }
+  bool ok = se_wait_for(se_started, n);
+
+  for (unsigned int i=0; i<n; i++) {
+    sessions[i]->t_event = se_now_us();
+    sessions[i]->postEvent(new AmEvent(SE_BENCH_EVENT));
+  }
+  ok = se_wait_for(se_processed, n) && ok;
+
+  for (unsigned int i=0; i<n; i++) {
+    sessions[i]->setStopped(false);
+    sessions[i]->postEvent(new AmEvent(0));
+  }
+  ok = se_wait_for(se_destroyed, n) && ok;
+
+  std::vector<unsigned long long> setup, event;
+  for (unsigned int i=0; i<n; i++) {
+    setup.push_back(sessions[i]->setup_us);
+    event.push_back(sessions[i]->event_us);
+  }
+  se_report((string(mode) + " session setup").c_str(), setup);
+  se_report((string(mode) + " event dispatch").c_str(), event);
+
+  for (unsigned int i=0; i<n; i++) {
+    while (!sessions[i]->is_stopped())
+      usleep(1000);
+    delete sessions[i];
+  }
+  return ok;
+}
+
+#endif
+
+FCTMF_SUITE_BGN(test_session_executor) {
+
+#ifndef SESSION_THREADPOOL
+  FCT_TEST_BGN(executor_sessions) {
+    int saved_log_level = log_level;
+    log_level = L_INFO;
+
+    AmSessionExecutor::instance()->start(4);
+    fct_chk(AmSessionExecutor::isRunning());
+    fct_chk(se_run("workstealing executor", SE_TEST_SESSIONS));
+
+    AmArg stats;
+    AmSessionExecutor::instance()->getStats(stats);
+    fct_chk(stats.size() == 4);
+    unsigned int runs = 0;
+    for (size_t i=0; i<stats.size(); i++)
+      runs += stats.get(i)["runs"].asInt();
+    // at least start, event and stop of every session
+    fct_chk(runs >= 3 * SE_TEST_SESSIONS);
+
+    AmSessionExecutor::dispose();
+    fct_chk(!AmSessionExecutor::isRunning());
+
+    log_level = saved_log_level;
+  }
+  FCT_TEST_END();
+#endif
+
+}
+FCTMF_SUITE_END();
+
+/* opt-in: SEMS_TEST_BENCH=1 */
+FCTMF_SUITE_BGN(bench_session_executor) {
+
+#ifndef SESSION_THREADPOOL
+  FCT_TEST_BGN(executor_benchmark) {
+    // no per-event debug output while measuring
+    int saved_log_level = log_level;
+    log_level = L_INFO;
+
+    fct_chk(se_run("thread-per-session", SE_BENCH_THREAD_SESSIONS));
+
+    AmSessionExecutor::instance()->start(4);
+    fct_chk(AmSessionExecutor::isRunning());
+    fct_chk(se_run("workstealing executor", SE_BENCH_SESSIONS));
+
+    AmArg stats;
+    AmSessionExecutor::instance()->getStats(stats);
+    INFO("executor threads: %s\n", AmArg::print(stats).c_str());
+
+    AmSessionExecutor::dispose();
+    fct_chk(!AmSessionExecutor::isRunning());
+
+    log_level = saved_log_level;
+  }
+  FCT_TEST_END();
+#endif
+
+}
+FCTMF_SUITE_END();
@@ -0,0 +1,124 @@
+#include "fct.h"
+
+#include "log.h"
+
+#include "AmTimerWheel.h"
+
+#include <vector>
+using std::vector;
+
+#define TW_TEST_SLOTS 64
+
+FCTMF_SUITE_BGN(test_timer_wheel) {
+
+  FCT_TEST_BGN(timer_wheel_schedule_expire) {
+    AmTimerWheel wheel(1000, TW_TEST_SLOTS);
+    AmWheelTimer a, b, c, d, e;
+    vector<AmWheelTimer*> fired;
+
+    wheel.schedule(&a, 1001);
+    wheel.schedule(&b, 1005);
+    // same slot as 1002, next round
+    wheel.schedule(&c, 1002 + TW_TEST_SLOTS);
+    // past: taken by the next expire
+    wheel.schedule(&d, 900);
+    wheel.schedule(&e, 1003);
+    fct_chk_eq_int(wheel.size(), 5);
+
+    // moved
+    wheel.schedule(&e, 1010);
+    fct_chk_eq_int(wheel.size(), 5);
+    wheel.cancel(&b);
+    wheel.cancel(&b);
+    fct_chk(!b.isScheduled());
+    fct_chk_eq_int(wheel.size(), 4);
+
+    wheel.expire(1000, fired);
+    fct_chk_eq_int(fired.size(), 0);
+    // fired after the due time
+    wheel.expire(1001, fired);
+    fct_req(fired.size() == 1);
+    fct_chk(fired[0] == &d);
+    wheel.expire(1004, fired);
+    fct_req(fired.size() == 2);
+    fct_chk(fired[1] == &a);
+    fct_chk(!a.isScheduled() && !d.isScheduled());
+    fct_chk(c.isScheduled());
+
+    fired.clear();
+    wheel.expire(1010, fired);
+    fct_chk_eq_int(fired.size(), 0);
+    wheel.expire(1011, fired);
+    fct_req(fired.size() == 1);
+    fct_chk(fired[0] == &e);
+
+    // long jump: all slots once
+    fired.clear();
+    wheel.expire(1010 + 3 * TW_TEST_SLOTS, fired);
+    fct_req(fired.size() == 1);
+    fct_chk(fired[0] == &c);
+    fct_chk_eq_int(wheel.size(), 0);
+    fct_chk(wheel.getTime() == 1010 + 3 * TW_TEST_SLOTS);
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(timer_wheel_slot_length) {
+    // 10 s slots, counted from the start
+    AmTimerWheel wheel(1005, TW_TEST_SLOTS, 10);
+    AmWheelTimer a, b, c;
+    vector<AmWheelTimer*> fired;
+
+    wheel.schedule(&a, 1014);
+    wheel.schedule(&b, 1010);
+    wheel.schedule(&c, 1015);
+    fct_chk_eq_int(wheel.getLoad(1005), 2);
+    fct_chk_eq_int(wheel.getLoad(1014), 2);
+    fct_chk_eq_int(wheel.getLoad(1015), 1);
+
+    // the same slot, by due time
+    wheel.expire(1011, fired);
+    fct_req(fired.size() == 1);
+    fct_chk(fired[0] == &b);
+    fct_chk_eq_int(wheel.getLoad(1005), 1);
+    wheel.expire(1016, fired);
+    fct_req(fired.size() == 3);
+    fct_chk(fired[1] == &a);
+    fct_chk(fired[2] == &c);
+    fct_chk_eq_int(wheel.getLoad(1015), 0);
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(timer_wheel_least_loaded) {
+    AmTimerWheel wheel(1000, TW_TEST_SLOTS, 10);
+    vector<AmWheelTimer> timers(100);
+    time_t slot_start = 0;
+
+    // the latest of equally loaded slots, before the slot of to_time
+    fct_chk(wheel.leastLoaded(1100, 1300, slot_start));
+    fct_chk(slot_start == 1290);
+
+    // every slot gets its share
+    for (size_t i=0; i<timers.size(); i++) {
+      fct_req(wheel.leastLoaded(1100, 1300, slot_start));
+      wheel.schedule(&timers[i], slot_start + i % 10);
+    }
+    for (time_t t=1100; t<1300; t+=10)
+      fct_chk_eq_int(wheel.getLoad(t), 5);
+    fct_chk_eq_int(wheel.getLoad(1300), 0);
+
+    // from the current slot on
+    wheel.schedule(&timers[0], 1000);
+    fct_chk(wheel.leastLoaded(900, 1020, slot_start));
+    fct_chk(slot_start == 1010);
+    std::vector<AmWheelTimer*> fired;
+    wheel.expire(1001, fired);
+    fct_chk(wheel.leastLoaded(900, 1010, slot_start));
+    fct_chk(slot_start == 1000);
+
+    // over already
+    fct_chk(!wheel.leastLoaded(900, 1000, slot_start));
+  }
+  FCT_TEST_END();
+
+}
+FCTMF_SUITE_END();
@@ -0,0 +1,416 @@
+#include "fct.h"
+
+#include "log.h"
+
+#include "AmThread.h"
+#include "AmUtils.h"
+
+#include "../../apps/xmlrpc2di/AsyncXmlRpcServer.h"
+#include "../../apps/xmlrpc2di/TOXmlRpcClient.h"
+#include "../../apps/xmlrpc2di/XmlRpcAmArg.h"
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// SEMS_TEST_XMLRPC_CALLS=100000 for the full size benchmark
+#define XMLRPC_BENCH_CALLS   2000
+#define XMLRPC_BENCH_ENTRIES 1000
+
+struct XmlRpcTestEcho : public XmlRpcMethod
+{
+  XmlRpcTestEcho(AsyncXmlRpcServer* s) : XmlRpcMethod("echo", s) { }
+  void execute(const AmArg& params, AmArg& result) {
+    result = params;
+  }
+};
+
+struct XmlRpcTestFail : public XmlRpcMethod
+{
+  XmlRpcTestFail(AsyncXmlRpcServer* s) : XmlRpcMethod("fail", s) { }
+  void execute(const AmArg& params, AmArg& result) {
+    throw XmlRpcFault("failed as asked", 42);
+  }
+};
+
+/** blocks its worker until released */
+struct XmlRpcTestBlock : public XmlRpcMethod
+{
+  AmCondition<bool> entered;
+  AmCondition<bool> released;
+
+  XmlRpcTestBlock(AsyncXmlRpcServer* s) : XmlRpcMethod("block", s) { }
+  void execute(const AmArg& params, AmArg& result) {
+    entered.set(true);
+    released.wait_for();
+    result = "done";
+  }
+};
+
+static int xmlrpc_test_connect(unsigned int port) {
+  int sd = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(sd, (struct sockaddr*)&addr, sizeof(addr))) {
+    close(sd);
+    return -1;
+  }
+  return sd;
+}
+
+static bool xmlrpc_test_send(int sd, const string& method, const AmArg& params) {
+  string xml;
+  xmlrpcAppendCall(method, params, xml);
+  string req = "POST /RPC2 HTTP/1.1\r\nContent-Type: text/xml\r\nContent-Length: " +
+    int2str((unsigned int)xml.length()) + "\r\n\r\n" + xml;
+  return send(sd, req.data(), req.length(), 0) == (ssize_t)req.length();
+}
+
+/** status line and body of the next response */
+static bool xmlrpc_test_read(int sd, string& status, string& body) {
+  string buf;
+  char tmp[4096];
+  size_t hdr_end;
+  while ((hdr_end = buf.find("\r\n\r\n")) == string::npos) {
+    ssize_t n = recv(sd, tmp, sizeof(tmp), 0);
+    if (n <= 0)
+      return false;
+    buf.append(tmp, n);
+  }
+  status = buf.substr(0, buf.find("\r\n"));
+  const char* cl = strcasestr(buf.c_str(), "Content-Length:");
+  size_t len = cl ? atoi(cl + 15) : 0;
+  while (buf.size() < hdr_end + 4 + len) {
+    ssize_t n = recv(sd, tmp, sizeof(tmp), 0);
+    if (n <= 0)
+      return false;
+    buf.append(tmp, n);
+  }
+  body = buf.substr(hdr_end + 4, len);
+  return true;
+}
+
+static int xmlrpc_test_fault(const string& body) {
+  XmlRpcReader r(body.data(), body.length());
+  AmArg res;
+  bool is_fault;
+  if (!r.readResponse(res, is_fault) || !is_fault || !res.hasMember("faultCode"))
+    return 0;
+  return res["faultCode"].asInt();
+}
+
+static double xmlrpc_elapsed_us(const struct timeval& start) {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return (now.tv_sec - start.tv_sec) * 1e6 + (now.tv_usec - start.tv_usec);
+}
+
+FCTMF_SUITE_BGN(test_xmlrpc) {
+
+  FCT_TEST_BGN(xmlrpc_codec_roundtrip) {
+    AmArg params, s;
+    params.push(1);
+    params.push(AmArg((long long)1 << 40));
+    params.push(true);
+    params.push(0.5);
+    params.push("a <b> & \"c\"");
+    params.push(ArgBlob("\0\1\2xyz", 6));
+    s["k1"] = "v";
+    s["k2"].push(1);
+    s["k2"].push("x");
+    params.push(s);
+
+    string xml;
+    xmlrpcAppendCall("test.m", params, xml);
+    string method;
+    AmArg parsed;
+    XmlRpcReader r(xml.data(), xml.length());
+    fct_req(r.readCall(method, parsed));
+    fct_chk(method == "test.m");
+    fct_req(isArgArray(parsed) && parsed.size() == 7);
+    fct_chk(isArgInt(parsed[0]) && parsed[0].asInt() == 1);
+    fct_chk(isArgLongLong(parsed[1]) && parsed[1].asLongLong() == (long long)1 << 40);
+    fct_chk(isArgBool(parsed[2]) && parsed[2].asBool());
+    fct_chk(isArgDouble(parsed[3]) && parsed[3].asDouble() == 0.5);
+    fct_chk(parsed[4].asCStr() == string("a <b> & \"c\""));
+    fct_chk(isArgBlob(parsed[5]) && parsed[5].asBlob()->len == 6 &&
+	    !memcmp(parsed[5].asBlob()->data, "\0\1\2xyz", 6));
+    fct_chk(parsed[6] == s);
+
+    // as xmlrpc++ and others write it
+    const char* req =
+      "<?xml version=\"1.0\"?>\r\n<!-- c -->\r\n<methodCall>\r\n"
+      "  <methodName> di </methodName>\r\n  <params>\r\n"
+      "    <param><value>untyped &amp; &#65;&#x42;</value></param>\r\n"
+      "    <param><value><int> -7 </int></value></param>\r\n"
+      "    <param><value><string><![CDATA[<raw>]]></string></value></param>\r\n"
+      "    <param><value><nil/></value></param>\r\n"
+      "    <param><value/></param>\r\n"
+      "    <param><value><array><data>\r\n"
+      "      <value><boolean>0</boolean></value><value><array><data/></array></value>\r\n"
+      "    </data></array></value></param>\r\n"
+      "    <param><value><struct><member><name>n</name><value><base64>YWJj</base64>"
+      "</value></member></struct></value></param>\r\n"
+      "  </params>\r\n</methodCall>\r\n";
+    XmlRpcReader r2(req, strlen(req));
+    fct_req(r2.readCall(method, parsed));
+    fct_chk(method == "di");
+    fct_req(parsed.size() == 7);
+    fct_chk(parsed[0].asCStr() == string("untyped & AB"));
+    fct_chk(parsed[1].asInt() == -7);
+    fct_chk(parsed[2].asCStr() == string("<raw>"));
+    fct_chk(isArgUndef(parsed[3]));
+    fct_chk(parsed[4].asCStr() == string(""));
+    fct_chk(parsed[5].size() == 2 && !parsed[5][0].asBool() &&
+	    isArgArray(parsed[5][1]) && parsed[5][1].size() == 0);
+    fct_chk(parsed[6]["n"].asBlob()->len == 3);
+
+    // no params
+    const char* no_params = "<methodCall><methodName>m</methodName></methodCall>";
+    XmlRpcReader r3(no_params, strlen(no_params));
+    fct_chk(r3.readCall(method, parsed) && isArgUndef(parsed));
+
+    // responses
+    string resp;
+    xmlrpcAppendResponse(s, resp);
+    bool is_fault = true;
+    XmlRpcReader r4(resp.data(), resp.length());
+    fct_chk(r4.readResponse(parsed, is_fault) && !is_fault && parsed == s);
+    resp.clear();
+    xmlrpcAppendFault(503, "busy & <more>", resp);
+    XmlRpcReader r5(resp.data(), resp.length());
+    fct_chk(r5.readResponse(parsed, is_fault) && is_fault);
+    fct_chk(parsed["faultCode"].asInt() == 503);
+    fct_chk(parsed["faultString"].asCStr() == string("busy & <more>"));
+
+    // broken ones
+    const char* bad[] = {
+      "",
+      "<methodCall><methodName>m</methodName><params><param><value><i4>x</i4>"
+      "</value></param></params></methodCall>",
+      "<methodCall><methodName>m</methodName><params><param><value><i4>1</i4>",
+      "<methodCall><methodName>m</methodName><params><param><value><date>1</date>"
+      "</value></param></params></methodCall>",
+      "<methodCall><methodName>m</methodName><params><param><value>&foo;</value>"
+      "</param></params></methodCall>",
+      "<methodCall><methodName></methodName></methodCall>",
+    };
+    for (size_t i=0; i<sizeof(bad)/sizeof(bad[0]); i++) {
+      XmlRpcReader rb(bad[i], strlen(bad[i]));
+      fct_chk(!rb.readCall(method, parsed));
+      fct_chk(!rb.error().empty());
+    }
+
+    // nesting is limited
+    string deep = "<methodCall><methodName>m</methodName><params><param>";
+    for (int i=0; i<XMLRPC_MAX_DEPTH + 2; i++)
+      deep += "<value><array><data>";
+    XmlRpcReader rd(deep.data(), deep.length());
+    fct_chk(!rd.readCall(method, parsed));
+    fct_chk(rd.error() == "values nested too deep");
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(xmlrpc_server_keepalive) {
+    int saved_log_level = log_level;
+    log_level = L_INFO;
+
+    AsyncXmlRpcServer server(2);
+    XmlRpcTestEcho echo(&server);
+    XmlRpcTestFail fail(&server);
+    fct_req(server.bindAndListen(0, "127.0.0.1"));
+    unsigned int port = server.getPort();
+    server.start();
+
+    TOXmlRpcClient c("127.0.0.1", port);
+    AmArg params, result;
+    params.push("x");
+    params.push(3);
+    for (int i=0; i<100; i++) {
+      params[1] = i;
+      fct_req(c.execute("echo", params, result, 2.0));
+      fct_chk(!c.isFault() && result == params);
+    }
+    fct_chk(c.isConnected());
+
+    fct_chk(c.execute("fail", params, result, 2.0) && c.isFault());
+    fct_chk(result["faultCode"].asInt() == 42);
+    fct_chk(c.execute("nosuch", params, result, 2.0) && c.isFault());
+
+    // several calls in one request
+    AmArg mc, call;
+    call["methodName"] = "echo";
+    call["params"].push(7);
+    mc.push(call);
+    call["methodName"] = "fail";
+    mc.push(call);
+    AmArg mc_params;
+    mc_params.push(mc);
+    fct_req(c.execute("system.multicall", mc_params, result, 2.0) && !c.isFault());
+    fct_req(result.size() == 2);
+    fct_chk(result[0][0][0].asInt() == 7);
+    fct_chk(result[1]["faultCode"].asInt() == 42);
+
+    // HTTP/1.0 without keep-alive, garbage
+    int sd = xmlrpc_test_connect(port);
+    fct_req(sd >= 0);
+    string xml, status, body;
+    xmlrpcAppendCall("echo", params, xml);
+    string req = "POST /RPC2 HTTP/1.0\r\nContent-Length: " +
+      int2str((unsigned int)xml.length()) + "\r\n\r\n" + xml;
+    fct_chk(send(sd, req.data(), req.length(), 0) == (ssize_t)req.length());
+    fct_chk(xmlrpc_test_read(sd, status, body));
+    char tmp;
+    fct_chk(recv(sd, &tmp, 1, 0) == 0);
+    close(sd);
+
+    sd = xmlrpc_test_connect(port);
+    fct_req(sd >= 0);
+    fct_chk(send(sd, "GET / HTTP/1.1\r\n\r\n", 18, 0) == 18);
+    fct_chk(xmlrpc_test_read(sd, status, body));
+    fct_chk(status == "HTTP/1.1 405 Method Not Allowed");
+    close(sd);
+
+    // server closed the idle connection meanwhile: sent again
+    server.stop_and_wait();
+    AsyncXmlRpcServer server2(0);
+    XmlRpcTestEcho echo2(&server2);
+    fct_req(server2.bindAndListen(port, "127.0.0.1"));
+    server2.start();
+    fct_chk(c.execute("echo", params, result, 2.0) && result == params);
+    server2.stop_and_wait();
+    fct_chk(!c.execute("echo", params, result, 0.5));
+
+    log_level = saved_log_level;
+  }
+  FCT_TEST_END();
+
+  FCT_TEST_BGN(xmlrpc_server_overload) {
+    int saved_log_level = log_level;
+    log_level = L_INFO;
+
+    AsyncXmlRpcServer server(1, 1);
+    XmlRpcTestBlock block(&server);
+    XmlRpcTestEcho echo(&server);
+    fct_req(server.bindAndListen(0, "127.0.0.1"));
+    unsigned int port = server.getPort();
+    server.start();
+
+    int sd[3];
+    for (int i=0; i<3; i++) {
+      sd[i] = xmlrpc_test_connect(port);
+      fct_req(sd[i] >= 0);
+    }
+    AmArg params;
+    fct_chk(xmlrpc_test_send(sd[0], "block", params));
+    block.entered.wait_for();
+    // worker busy: one queued, the next one rejected right away
+    fct_chk(xmlrpc_test_send(sd[1], "echo", params));
+    usleep(50000);
+    fct_chk(xmlrpc_test_send(sd[2], "echo", params));
+
+    string status, body;
+    fct_chk(xmlrpc_test_read(sd[2], status, body));
+    fct_chk(xmlrpc_test_fault(body) == XMLRPC_FAULT_OVERLOAD);
+    fct_chk_eq_int(server.getRejected(), 1);
+
+    block.released.set(true);
+    fct_chk(xmlrpc_test_read(sd[0], status, body));
+    fct_chk(status == "HTTP/1.1 200 OK" && xmlrpc_test_fault(body) == 0);
+    fct_chk(xmlrpc_test_read(sd[1], status, body));
+    fct_chk(xmlrpc_test_fault(body) == 0);
+
+    // still usable after the rejection
+    fct_chk(xmlrpc_test_send(sd[2], "echo", params));
+    fct_chk(xmlrpc_test_read(sd[2], status, body));
+    fct_chk(xmlrpc_test_fault(body) == 0);
+
+    for (int i=0; i<3; i++)
+      close(sd[i]);
+    server.stop_and_wait();
+
+    log_level = saved_log_level;
+  }
+  FCT_TEST_END();
+
+}
+FCTMF_SUITE_END();
+
+/* opt-in: SEMS_TEST_BENCH=1 */
+FCTMF_SUITE_BGN(bench_xmlrpc) {
+
+  FCT_TEST_BGN(xmlrpc_benchmark) {
+    int saved_log_level = log_level;
+    log_level = L_INFO;
+
+    unsigned int n_calls = XMLRPC_BENCH_CALLS;
+    if (getenv("SEMS_TEST_XMLRPC_CALLS"))
+      n_calls = atoi(getenv("SEMS_TEST_XMLRPC_CALLS"));
+
+    // bulk monitoring result
+    AmArg bulk;
+    for (unsigned int i=0; i<XMLRPC_BENCH_ENTRIES; i++) {
+      AmArg e;
+      e["id"] = "call-" + int2str(i);
+      e["state"] = (int)(i % 3);
+      e["duration"] = i * 1.5;
+      bulk.push(e);
+    }
+    string resp;
+    xmlrpcAppendResponse(bulk, resp);
+    struct timeval start;
+    gettimeofday(&start, NULL);
+    bool parsed_ok = true;
+    for (unsigned int i=0; i<20; i++) {
+      AmArg res;
+      bool is_fault;
+      XmlRpcReader r(resp.data(), resp.length());
+      parsed_ok = parsed_ok && r.readResponse(res, is_fault) && res.size() == bulk.size();
+    }
+    double parse_us = xmlrpc_elapsed_us(start) / 20;
+    fct_chk(parsed_ok);
+
+    AsyncXmlRpcServer server(4);
+    XmlRpcTestEcho echo(&server);
+    fct_req(server.bindAndListen(0, "127.0.0.1"));
+    unsigned int port = server.getPort();
+    server.start();
+
+    AmArg params;
+    params.push("ping");
+    AmArg result;
+    unsigned int ok = 0;
+    TOXmlRpcClient c("127.0.0.1", port);
+    gettimeofday(&start, NULL);
+    for (unsigned int i=0; i<n_calls; i++)
+      ok += c.execute("echo", params, result, 2.0) && !c.isFault();
+    double keepalive_us = xmlrpc_elapsed_us(start) / n_calls;
+
+    gettimeofday(&start, NULL);
+    for (unsigned int i=0; i<n_calls / 10; i++) {
+      TOXmlRpcClient c1("127.0.0.1", port);
+      ok += c1.execute("echo", params, result, 2.0) && !c1.isFault();
+    }
+    double new_conn_us = xmlrpc_elapsed_us(start) / (n_calls / 10);
+    fct_chk_eq_int(ok, n_calls + n_calls / 10);
+
+    server.stop_and_wait();
+
+    INFO("xmlrpc: %u entry response (%zd bytes) parsed in %.0f us (%.1f MB/s), "
+	 "calls with keep-alive %.1f us, with new connection %.1f us\n",
+	 XMLRPC_BENCH_ENTRIES, resp.length(), parse_us, resp.length() / parse_us,
+	 keepalive_us, new_conn_us);
+
+    log_level = saved_log_level;
+  }
+  FCT_TEST_END();
+}
+FCTMF_SUITE_END();